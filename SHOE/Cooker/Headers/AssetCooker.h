@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "CookDatabase.h"
+#include "../../Headers/TextureCompressor.h"
+#include "../../Headers/AssetPack.h"
+
+#define COOK_DATABASE_FILE "cook.db"
+
+// Bump when a cook step changes its output without the file format changing,
+// so every existing output is rebuilt
+#define COOK_RECIPE_VERSION 3
+
+struct CookSettings {
+	std::string assetRoot = "Assets";
+	std::string outputRoot = "Cooked";
+	bool force = false;
+	bool verbose = false;
+	unsigned int jobCount = 0;
+	// Archive to pack the asset and output folders into after cooking, or empty for none
+	std::string packPath;
+	// Times reading every asset and output file synchronously against the AsyncFileReader
+	bool benchmarkReads = false;
+	// Checks the engine's shader reflection cache against the compiled shaders in the asset folder
+	bool checkShaderCache = false;
+	// Runs the texture pipeline over generated reference images instead of cooking
+	bool verifyTextures = false;
+	TexturePreset texturePreset = TEXTURE_PRESET_BALANCED;
+
+	// Must match Terrain::SetDefaults for the engine to pick the cooked terrain up
+	uint32_t terrainWidth = 512;
+	uint32_t terrainHeight = 512;
+	float terrainHeightScale = 25.0f;
+};
+
+enum CookJobType {
+	COOK_JOB_MESH,
+	COOK_JOB_TERRAIN,
+	COOK_JOB_TEXTURE,
+	COOK_JOB_SKY
+};
+
+/// <summary>
+/// One output file and the source files it's built from.
+/// Paths are relative to their roots and '/' separated.
+/// </summary>
+struct CookJob {
+	CookJobType type;
+	std::string output;
+	std::vector<std::string> inputs;
+};
+
+/// <summary>
+/// Walks an asset folder and converts everything the engine can load
+/// faster in a preprocessed form:
+/// Models/*.obj and HeightMaps/*.raw(16) become .smesh files, images become
+/// mipmapped and block compressed .stex files, and sky folders become single
+/// cubemap .stex files.
+/// Outputs mirror the asset folder layout, with the cooked extension appended.
+/// </summary>
+class AssetCooker
+{
+public:
+	AssetCooker(const CookSettings& settings);
+
+	/// <summary>
+	/// Cooks everything out of date and removes outputs whose sources are gone
+	/// </summary>
+	/// <returns>The number of assets that failed to cook</returns>
+	unsigned int Run();
+
+	/// <summary>
+	/// Finds every cookable asset under the asset root
+	/// </summary>
+	std::vector<CookJob> FindJobs();
+
+	/// <summary>
+	/// Packs the asset and output folders into one archive. Files are stored
+	/// under the name of the folder they're in, so mounted next to those
+	/// folders, the archive stands in for both.
+	/// </summary>
+	/// <returns>False if the archive couldn't be written</returns>
+	bool Pack(const std::string& packPath);
+
+	/// <summary>
+	/// Reads every file in the asset and output folders (through the archive,
+	/// if one was packed) one at a time, then all at once on the AsyncFileReader,
+	/// and logs the throughput and latency of both
+	/// </summary>
+	void BenchmarkReads();
+
+	/// <summary>
+	/// Checks every file in the shader reflection cache under Shaders/ in
+	/// the asset root. Files for shaders that are no longer there, and files
+	/// that fail validation, are removed.
+	/// </summary>
+	/// <returns>The number of valid cache files</returns>
+	unsigned int CheckShaderReflectionCache();
+
+	/// <summary>
+	/// Runs generated reference images through every texture preset and checks
+	/// each mip chain against a known hash and each top mip against an error ceiling
+	/// </summary>
+	/// <returns>The number of outputs that didn't match</returns>
+	unsigned int VerifyTextures();
+
+private:
+	CookSettings settings;
+	CookDatabase database;
+	std::mutex logMutex;
+
+	std::atomic<unsigned int> cookedCount;
+	std::atomic<unsigned int> skippedCount;
+	std::atomic<unsigned int> failedCount;
+
+	uint64_t GetRecipe(const CookJob& job);
+	TexturePreset GetTexturePreset(const CookJob& job);
+	void ProcessJob(const CookJob& job);
+	bool IsOutputCurrent(const CookJob& job);
+
+	bool CookMesh(const CookJob& job, std::string* error);
+	bool CookTerrain(const CookJob& job, std::string* error);
+	bool CookTexture(const CookJob& job, std::string* error);
+	bool CookSky(const CookJob& job, std::string* error);
+
+	std::string GetAssetPath(const std::string& relativePath);
+	std::string GetOutputPath(const std::string& relativePath);
+	bool CreateOutputFolder(const std::string& relativePath);
+	void AddPackSources(const std::string& root, std::vector<AssetPackSource>* sources);
+
+	void Log(const std::string& message);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+struct CookInput {
+	// Relative to the asset root, always '/' separated
+	std::string path;
+	uint64_t hash;
+};
+
+/// <summary>
+/// What a cooked output was last built from. The output is up to date while
+/// the recipe (format versions and cook settings) and every input hash match.
+/// </summary>
+struct CookRecord {
+	// Relative to the output root, always '/' separated
+	std::string output;
+	uint64_t recipe;
+	std::vector<CookInput> inputs;
+};
+
+/// <summary>
+/// Content hash database for incremental cooks. Stored as a small text file
+/// in the output root so it can be inspected and diffed. Thread safe.
+/// </summary>
+class CookDatabase
+{
+public:
+	/// <summary>
+	/// Loads records from disk. A missing or unreadable database
+	/// is treated as empty, which just means everything is rebuilt.
+	/// </summary>
+	void Load(const std::string& path);
+	bool Save(const std::string& path);
+
+	bool IsUpToDate(const CookRecord& wanted);
+	void SetRecord(const CookRecord& record);
+
+	/// <summary>
+	/// Drops every record whose output isn't in the given set
+	/// </summary>
+	/// <returns>Outputs of the dropped records</returns>
+	std::vector<std::string> RemoveRecordsExcept(const std::vector<std::string>& outputs);
+
+	/// <summary>
+	/// 64-bit FNV-1a hash of a file's contents
+	/// </summary>
+	/// <returns>False if the file couldn't be read</returns>
+	static bool HashFile(const std::string& path, uint64_t* hash);
+	static uint64_t HashString(const std::string& text, uint64_t hash = 14695981039346656037ull);
+
+private:
+	std::map<std::string, CookRecord> records;
+	std::mutex recordMutex;
+};
@@ -0,0 +1,802 @@
+#include "../Headers/AssetCooker.h"
+#include "../../Headers/MeshFile.h"
+#include "../../Headers/MeshBuilder.h"
+#include "../../Headers/TextureFile.h"
+#include "../../Headers/ImageDecoder.h"
+#include "../../Headers/JobSystem.h"
+#include "../../Headers/AsyncFileReader.h"
+#include "../../Headers/ShaderReflectionFile.h"
+#include <experimental/filesystem>
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <map>
+#include <fstream>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace fs = std::experimental::filesystem;
+
+// Order matters here! Matches the faces AssetManager expects: +X, -X, +Y, -Y, +Z, -Z
+static const char* skyFaceNames[6] = { "right", "left", "up", "down", "forward", "back" };
+
+static const char* formatNames[] = { "", "RGBA8", "BC1", "BC3", "BC4", "BC5", "BC7" };
+
+static std::string ToLower(std::string text) {
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return text;
+}
+
+static bool StartsWith(const std::string& text, const std::string& prefix) {
+	return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+static bool IsImageExtension(const std::string& extension) {
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+}
+
+AssetCooker::AssetCooker(const CookSettings& settings) {
+	this->settings = settings;
+
+	// Relative paths are cut from the root, so it can't end in a separator
+	while (this->settings.assetRoot.size() > 1 &&
+		(this->settings.assetRoot.back() == '/' || this->settings.assetRoot.back() == '\\')) {
+		this->settings.assetRoot.pop_back();
+	}
+
+	cookedCount = 0;
+	skippedCount = 0;
+	failedCount = 0;
+}
+
+unsigned int AssetCooker::Run() {
+	std::error_code error;
+	fs::create_directories(settings.outputRoot, error);
+	if (!fs::is_directory(settings.outputRoot)) {
+		Log("[failed] Couldn't create output folder " + settings.outputRoot);
+		return 1;
+	}
+
+	std::string databasePath = GetOutputPath(COOK_DATABASE_FILE);
+	database.Load(databasePath);
+
+	std::vector<CookJob> jobs = FindJobs();
+	if (jobs.empty()) Log("No cookable assets found in " + settings.assetRoot);
+
+	// Folders are made up front, so jobs in the same folder don't race to create it
+	for (const CookJob& job : jobs) {
+		CreateOutputFolder(job.output);
+	}
+
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	jobSystem.Initialize(settings.jobCount);
+	jobSystem.ParallelFor(jobs.size(), 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			ProcessJob(jobs[i]);
+		}
+	});
+
+	// Anything the database knows about that no longer has a source is stale
+	std::vector<std::string> outputs;
+	for (const CookJob& job : jobs) {
+		outputs.push_back(job.output);
+	}
+
+	std::vector<std::string> removed = database.RemoveRecordsExcept(outputs);
+	for (const std::string& output : removed) {
+		fs::remove(GetOutputPath(output), error);
+		Log("[removed] " + output);
+	}
+
+	if (!database.Save(databasePath)) {
+		Log("[failed] Couldn't write " + databasePath);
+		failedCount++;
+	}
+
+	Log(std::to_string(cookedCount) + " cooked, " +
+		std::to_string(skippedCount) + " up to date, " +
+		std::to_string(removed.size()) + " removed, " +
+		std::to_string(failedCount) + " failed");
+
+	if (settings.checkShaderCache) CheckShaderReflectionCache();
+
+	// Packing goes last, so removed outputs are already gone
+	if (!settings.packPath.empty() && !Pack(settings.packPath)) {
+		failedCount++;
+	}
+
+	if (settings.benchmarkReads) BenchmarkReads();
+
+	jobSystem.Shutdown();
+
+	return failedCount;
+}
+
+bool AssetCooker::Pack(const std::string& packPath) {
+	std::vector<AssetPackSource> sources;
+	AddPackSources(settings.assetRoot, &sources);
+	AddPackSources(settings.outputRoot, &sources);
+
+	AssetPackWriteStats stats;
+	if (!AssetPack::Write(packPath, sources, &stats)) {
+		Log("[failed] Couldn't write " + packPath);
+		return false;
+	}
+
+	for (const std::string& path : stats.failedPaths) {
+		Log("[warning] Couldn't pack " + path);
+	}
+
+	double originalMB = stats.originalBytes / (1024.0 * 1024.0);
+	double packedMB = stats.packedBytes / (1024.0 * 1024.0);
+	Log("[packed] " + packPath + ": " + std::to_string(stats.fileCount) + " files, " +
+		std::to_string(stats.compressedCount) + " compressed, " +
+		std::to_string(originalMB) + " MB to " + std::to_string(packedMB) + " MB");
+
+	return true;
+}
+
+std::vector<CookJob> AssetCooker::FindJobs() {
+	std::vector<CookJob> jobs;
+	std::set<std::string> skyFolders;
+	std::error_code error;
+
+	std::vector<std::string> files;
+	for (fs::recursive_directory_iterator it(settings.assetRoot, error), end; !error && it != end; it.increment(error)) {
+		std::string fullPath = it->path().string();
+		if (fullPath.size() <= settings.assetRoot.size() + 1) continue;
+
+		std::string relativePath = fullPath.substr(settings.assetRoot.size() + 1);
+		std::replace(relativePath.begin(), relativePath.end(), '\\', '/');
+
+		if (fs::is_directory(it->path())) {
+			// Sky folders are any folder in Textures/Skies with a right face in it
+			if (StartsWith(relativePath, "Textures/Skies/")) {
+				for (const char* extension : { ".png", ".jpg", ".jpeg" }) {
+					if (fs::exists(it->path() / (std::string(skyFaceNames[0]) + extension))) {
+						CookJob job;
+						job.type = COOK_JOB_SKY;
+						job.output = relativePath + TEXTURE_FILE_EXTENSION;
+						for (const char* face : skyFaceNames) {
+							job.inputs.push_back(relativePath + "/" + face + extension);
+						}
+
+						jobs.push_back(job);
+						skyFolders.insert(relativePath + "/");
+						break;
+					}
+				}
+			}
+		}
+		else {
+			files.push_back(relativePath);
+		}
+	}
+
+	if (error) Log("[failed] Couldn't read " + settings.assetRoot + ": " + error.message());
+
+	for (const std::string& relativePath : files) {
+		std::string extension = ToLower(fs::path(relativePath).extension().string());
+
+		CookJob job;
+		job.output = relativePath;
+		job.inputs.push_back(relativePath);
+
+		if (StartsWith(relativePath, "Models/") && extension == ".obj") {
+			job.type = COOK_JOB_MESH;
+			job.output += MESH_FILE_EXTENSION;
+		}
+		else if (StartsWith(relativePath, "HeightMaps/") && (extension == ".raw" || extension == ".raw16")) {
+			job.type = COOK_JOB_TERRAIN;
+			job.output += MESH_FILE_EXTENSION;
+		}
+		else if ((StartsWith(relativePath, "Textures/") || StartsWith(relativePath, "PBR/") || StartsWith(relativePath, "Particles/")) &&
+			IsImageExtension(extension)) {
+			// Sky faces are cooked into their folder's cubemap instead
+			std::string folder = relativePath.substr(0, relativePath.rfind('/') + 1);
+			if (skyFolders.count(folder)) continue;
+
+			job.type = COOK_JOB_TEXTURE;
+			job.output += TEXTURE_FILE_EXTENSION;
+		}
+		else {
+			continue;
+		}
+
+		jobs.push_back(job);
+	}
+
+	// Keeps logs and the database stable between runs
+	std::sort(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) { return a.output < b.output; });
+
+	return jobs;
+}
+
+/// <summary>
+/// Hashes everything besides the inputs that decides what a job writes
+/// </summary>
+uint64_t AssetCooker::GetRecipe(const CookJob& job) {
+	std::string recipe = "recipe " + std::to_string(COOK_RECIPE_VERSION);
+
+	switch (job.type) {
+	case COOK_JOB_MESH:
+		recipe += " mesh " + std::to_string(MESH_FILE_VERSION) + " " + std::to_string(sizeof(MeshFileVertex));
+		break;
+	case COOK_JOB_TERRAIN:
+		recipe += " terrain " + std::to_string(MESH_FILE_VERSION) + " " + std::to_string(sizeof(MeshFileVertex)) +
+			" " + std::to_string(settings.terrainWidth) + "x" + std::to_string(settings.terrainHeight) +
+			" " + std::to_string(settings.terrainHeightScale);
+		break;
+	case COOK_JOB_TEXTURE:
+		recipe += " texture " + std::to_string(TEXTURE_FILE_VERSION) + " " + TextureCompressor::GetPresetName(GetTexturePreset(job));
+		break;
+	case COOK_JOB_SKY:
+		recipe += " sky " + std::to_string(TEXTURE_FILE_VERSION);
+		break;
+	}
+
+	return CookDatabase::HashString(recipe);
+}
+
+/// <summary>
+/// Particles are loaded into texture arrays, which only take RGBA8
+/// </summary>
+TexturePreset AssetCooker::GetTexturePreset(const CookJob& job) {
+	if (StartsWith(job.output, "Particles/")) return TEXTURE_PRESET_UNCOMPRESSED;
+
+	return settings.texturePreset;
+}
+
+void AssetCooker::ProcessJob(const CookJob& job) {
+	CookRecord record;
+	record.output = job.output;
+	record.recipe = GetRecipe(job);
+
+	for (const std::string& input : job.inputs) {
+		CookInput cookInput;
+		cookInput.path = input;
+
+		if (!CookDatabase::HashFile(GetAssetPath(input), &cookInput.hash)) {
+			failedCount++;
+			Log("[failed] " + job.output + ": couldn't read " + input);
+			return;
+		}
+
+		record.inputs.push_back(cookInput);
+	}
+
+	std::string outputPath = GetOutputPath(job.output);
+	if (!settings.force && database.IsUpToDate(record) && fs::exists(outputPath) && IsOutputCurrent(job)) {
+		skippedCount++;
+		if (settings.verbose) Log("[up to date] " + job.output);
+		return;
+	}
+
+	std::string error;
+	bool cooked = false;
+	switch (job.type) {
+	case COOK_JOB_MESH:
+		cooked = CookMesh(job, &error);
+		break;
+	case COOK_JOB_TERRAIN:
+		cooked = CookTerrain(job, &error);
+		break;
+	case COOK_JOB_TEXTURE:
+		cooked = CookTexture(job, &error);
+		break;
+	case COOK_JOB_SKY:
+		cooked = CookSky(job, &error);
+		break;
+	}
+
+	if (!cooked) {
+		// A stale output would still be picked up by the engine, so drop it
+		// and let the engine fall back to the source file
+		std::error_code removeError;
+		fs::remove(outputPath, removeError);
+
+		failedCount++;
+		Log("[failed] " + job.output + ": " + error);
+		return;
+	}
+
+	database.SetRecord(record);
+	cookedCount++;
+	Log("[cooked] " + job.output);
+}
+
+/// <summary>
+/// The engine only uses a cooked mesh whose source stamp matches the source
+/// file, and a cooked texture written after its sources. Outputs with the
+/// right contents that fail those (say, after the folders were copied)
+/// still have to be written again.
+/// </summary>
+bool AssetCooker::IsOutputCurrent(const CookJob& job) {
+	if (job.type == COOK_JOB_MESH || job.type == COOK_JOB_TERRAIN) {
+		MeshFileSourceStamp source;
+		if (!MeshFile::GetSourceStamp(GetAssetPath(job.inputs[0]), &source)) return false;
+
+		MeshFileView output;
+		return output.Open(GetOutputPath(job.output), sizeof(MeshFileVertex), &source);
+	}
+
+	uint64_t size;
+	int64_t outputTime;
+	if (!AssetPack::GetDiskStamp(GetOutputPath(job.output), &size, &outputTime)) return false;
+
+	for (const std::string& input : job.inputs) {
+		int64_t inputTime;
+		if (!AssetPack::GetDiskStamp(GetAssetPath(input), &size, &inputTime) || inputTime > outputTime) return false;
+	}
+
+	return true;
+}
+
+bool AssetCooker::CookMesh(const CookJob& job, std::string* error) {
+	std::string inputPath = GetAssetPath(job.inputs[0]);
+
+	std::vector<MeshFileVertex> vertices;
+	std::vector<uint32_t> indices;
+	if (!MeshBuilder::LoadOBJ(inputPath, &vertices, &indices, error)) return false;
+
+	if (vertices.empty() || indices.empty()) {
+		*error = "model has no faces";
+		return false;
+	}
+
+	MeshBuilder::CalculateTangents(vertices.data(), (uint32_t)vertices.size(), indices.data(), (uint32_t)indices.size());
+
+	MeshFileContents contents = {};
+	contents.vertices = vertices.data();
+	contents.vertexCount = (uint32_t)vertices.size();
+	contents.vertexStride = sizeof(MeshFileVertex);
+	contents.indices = indices.data();
+	contents.indexCount = (uint32_t)indices.size();
+	MeshBuilder::CalculateBounds(vertices.data(), contents.vertexCount, &contents);
+
+	MeshFileSourceStamp source = {};
+	MeshFile::GetSourceStamp(inputPath, &source);
+
+	if (!MeshFile::Write(GetOutputPath(job.output), contents, source)) {
+		*error = "couldn't write the output";
+		return false;
+	}
+
+	return true;
+}
+
+bool AssetCooker::CookTerrain(const CookJob& job, std::string* error) {
+	std::string inputPath = GetAssetPath(job.inputs[0]);
+
+	std::vector<uint16_t> heights;
+	if (!MeshBuilder::LoadHeightmap(inputPath, settings.terrainWidth, settings.terrainHeight, &heights)) {
+		*error = "couldn't read the heightmap";
+		return false;
+	}
+
+	if (settings.verbose && fs::file_size(inputPath) < heights.size() * sizeof(uint16_t)) {
+		Log("[warning] " + job.inputs[0] + " is smaller than " +
+			std::to_string(settings.terrainWidth) + "x" + std::to_string(settings.terrainHeight) + ", the rest is flat");
+	}
+
+	std::vector<MeshFileVertex> vertices;
+	std::vector<uint32_t> indices;
+	MeshBuilder::BuildTerrain(heights.data(), settings.terrainWidth, settings.terrainHeight, settings.terrainHeightScale, &vertices, &indices);
+
+	if (indices.empty()) {
+		*error = "terrain size is too small";
+		return false;
+	}
+
+	MeshBuilder::CalculateTangents(vertices.data(), (uint32_t)vertices.size(), indices.data(), (uint32_t)indices.size());
+
+	MeshFileContents contents = {};
+	contents.vertices = vertices.data();
+	contents.vertexCount = (uint32_t)vertices.size();
+	contents.vertexStride = sizeof(MeshFileVertex);
+	contents.indices = indices.data();
+	contents.indexCount = (uint32_t)indices.size();
+	MeshBuilder::CalculateBounds(vertices.data(), contents.vertexCount, &contents);
+
+	MeshFileTerrain terrain = {};
+	terrain.mapWidth = settings.terrainWidth;
+	terrain.mapHeight = settings.terrainHeight;
+	terrain.heightScale = settings.terrainHeightScale;
+	contents.terrain.push_back(terrain);
+
+	MeshFileSourceStamp source = {};
+	MeshFile::GetSourceStamp(inputPath, &source);
+
+	if (!MeshFile::Write(GetOutputPath(job.output), contents, source)) {
+		*error = "couldn't write the output";
+		return false;
+	}
+
+	return true;
+}
+
+bool AssetCooker::CookTexture(const CookJob& job, std::string* error) {
+	TextureFileImage image;
+	bool sRGB = false;
+	if (!ImageDecoder::Decode(GetAssetPath(job.inputs[0]), &image, &sRGB, error)) return false;
+
+	TextureUsage usage = TextureCompressor::GetUsageForPath(job.inputs[0]);
+	TexturePreset preset = GetTexturePreset(job);
+
+	std::vector<std::vector<TextureFileImage>> slices(1);
+	TextureFileFormat format = TextureCompressor::Process(image, usage, sRGB, preset, &slices[0]);
+
+	if (!TextureFile::Write(GetOutputPath(job.output), sRGB ? (uint32_t)TEXTURE_FLAG_SRGB : 0u, slices, format)) {
+		*error = "couldn't write the output";
+		return false;
+	}
+
+	if (settings.verbose && format != TEXTURE_FORMAT_RGBA8) {
+		float error = TextureCompressor::GetCompressionError(image, slices[0][0], format);
+		Log("[texture] " + job.output + ": " + formatNames[format] + ", RMSE " + std::to_string(error));
+	}
+
+	return true;
+}
+
+bool AssetCooker::CookSky(const CookJob& job, std::string* error) {
+	// Skies are sampled without mips, same as CreateCubemapFromDecoded
+	std::vector<std::vector<TextureFileImage>> slices(6, std::vector<TextureFileImage>(1));
+	bool sRGB = false;
+
+	for (int i = 0; i < 6; i++) {
+		bool faceSRGB = false;
+		std::string faceError;
+		if (!ImageDecoder::Decode(GetAssetPath(job.inputs[i]), &slices[i][0], &faceSRGB, &faceError)) {
+			*error = job.inputs[i] + ": " + faceError;
+			return false;
+		}
+
+		// The cube's format comes from the first face
+		if (i == 0) sRGB = faceSRGB;
+
+		if (slices[i][0].width != slices[0][0].width || slices[i][0].height != slices[0][0].height) {
+			*error = job.inputs[i] + " isn't the same size as " + job.inputs[0];
+			return false;
+		}
+	}
+
+	uint32_t flags = TEXTURE_FLAG_CUBEMAP | (sRGB ? (uint32_t)TEXTURE_FLAG_SRGB : 0u);
+	if (!TextureFile::Write(GetOutputPath(job.output), flags, slices)) {
+		*error = "couldn't write the output";
+		return false;
+	}
+
+	return true;
+}
+
+std::string AssetCooker::GetAssetPath(const std::string& relativePath) {
+	return (fs::path(settings.assetRoot) / fs::path(relativePath)).string();
+}
+
+std::string AssetCooker::GetOutputPath(const std::string& relativePath) {
+	return (fs::path(settings.outputRoot) / fs::path(relativePath)).string();
+}
+
+bool AssetCooker::CreateOutputFolder(const std::string& relativePath) {
+	std::error_code error;
+	fs::path folder = fs::path(GetOutputPath(relativePath)).parent_path();
+	fs::create_directories(folder, error);
+	return fs::is_directory(folder);
+}
+
+void AssetCooker::BenchmarkReads() {
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<AssetPackSource> sources;
+	AddPackSources(settings.assetRoot, &sources);
+	AddPackSources(settings.outputRoot, &sources);
+
+	std::vector<std::string> paths;
+	for (const AssetPackSource& source : sources) {
+		paths.push_back(source.diskPath);
+	}
+
+	// Packed paths start with their folder's name, so the archive mounts where both folders are
+	VirtualFileSystem& vfs = VirtualFileSystem::GetInstance();
+	std::error_code error;
+	if (!settings.packPath.empty()) {
+		fs::path mountPoint = fs::canonical(settings.assetRoot, error).parent_path();
+		if (!error && vfs.Mount(settings.packPath, mountPoint.string())) Log("[benchmark] Reading through " + settings.packPath);
+	}
+
+	// One untimed pass first, so both timed passes read from a warm cache
+	std::vector<char> data;
+	for (const std::string& path : paths) {
+		vfs.ReadWholeFile(path, &data);
+	}
+
+	auto logResult = [&](const char* name, double seconds, uint64_t bytes, double totalLatency, double maxLatency) {
+		double megabytes = bytes / (1024.0 * 1024.0);
+		Log(std::string("[benchmark] ") + name + ": " + std::to_string(paths.size()) + " files, " +
+			std::to_string(megabytes) + " MB in " + std::to_string(seconds * 1000.0) + " ms (" +
+			std::to_string(seconds > 0 ? megabytes / seconds : 0.0) + " MB/s), latency " +
+			std::to_string(paths.empty() ? 0.0 : totalLatency / paths.size() * 1000.0) + " ms avg, " +
+			std::to_string(maxLatency * 1000.0) + " ms max");
+	};
+
+	// Latency is from the start of the pass, as if every file had been asked for at once
+	Clock::time_point start = Clock::now();
+	uint64_t syncBytes = 0;
+	double syncTotalLatency = 0;
+	double syncMaxLatency = 0;
+	for (const std::string& path : paths) {
+		vfs.ReadWholeFile(path, &data);
+		syncBytes += data.size();
+
+		double latency = std::chrono::duration<double>(Clock::now() - start).count();
+		syncTotalLatency += latency;
+		syncMaxLatency = (std::max)(syncMaxLatency, latency);
+	}
+	logResult("Synchronous", std::chrono::duration<double>(Clock::now() - start).count(), syncBytes, syncTotalLatency, syncMaxLatency);
+
+	AsyncFileReader& reader = AsyncFileReader::GetInstance();
+	reader.Initialize();
+
+	start = Clock::now();
+	std::vector<std::future<AsyncReadResult>> reads = reader.ReadBatch(paths, ASYNC_READ_PRIORITY_NORMAL);
+	uint64_t asyncBytes = 0;
+	double asyncTotalLatency = 0;
+	double asyncMaxLatency = 0;
+	for (std::future<AsyncReadResult>& read : reads) {
+		AsyncReadResult result = read.get();
+		asyncBytes += result.data.size();
+		asyncTotalLatency += result.latency;
+		asyncMaxLatency = (std::max)(asyncMaxLatency, result.latency);
+	}
+	logResult("Asynchronous", std::chrono::duration<double>(Clock::now() - start).count(), asyncBytes, asyncTotalLatency, asyncMaxLatency);
+
+	AsyncFileReaderStats stats = reader.GetStats();
+	Log("[benchmark] " + std::to_string(stats.coalescedCount) + " reads coalesced into " + std::to_string(stats.spanCount) + " spans");
+
+	reader.Shutdown();
+	vfs.UnmountAll();
+}
+
+unsigned int AssetCooker::CheckShaderReflectionCache() {
+	std::string shaderFolder = GetAssetPath("Shaders");
+
+	std::string cacheFolderName = SHADER_REFLECTION_FOLDER;
+	cacheFolderName.pop_back();
+	std::string cacheFolder = (fs::path(shaderFolder) / fs::path(cacheFolderName)).string();
+
+	// Cache files are named by their shader's hash, and also have to agree on its size
+	std::map<uint64_t, uint64_t> bytecodeSizes;
+	std::error_code error;
+	for (fs::directory_iterator it(shaderFolder, error), end; !error && it != end; it.increment(error)) {
+		if (ToLower(it->path().extension().string()) != ".cso") continue;
+
+		std::ifstream file(it->path().string(), std::ios::binary);
+		std::vector<char> bytecode((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (!file.good() && !file.eof()) {
+			Log("[warning] Couldn't read " + it->path().string());
+			continue;
+		}
+
+		bytecodeSizes[ShaderReflectionFile::HashBytecode(bytecode.data(), bytecode.size())] = bytecode.size();
+	}
+
+	unsigned int validCount = 0;
+	unsigned int staleCount = 0;
+	unsigned int damagedCount = 0;
+	for (fs::directory_iterator it(cacheFolder, error), end; !error && it != end; it.increment(error)) {
+		std::string path = it->path().string();
+		if (ToLower(it->path().extension().string()) != SHADER_REFLECTION_FILE_EXTENSION) continue;
+
+		uint64_t bytecodeHash = 0;
+		auto shader = ShaderReflectionFile::ParseCachePath(path, &bytecodeHash) ? bytecodeSizes.find(bytecodeHash) : bytecodeSizes.end();
+		if (shader == bytecodeSizes.end()) {
+			std::error_code removeError;
+			fs::remove(it->path(), removeError);
+			staleCount++;
+			if (settings.verbose) Log("[removed] " + path + " (no matching shader)");
+			continue;
+		}
+
+		// Read removes the file itself if it's damaged
+		if (ShaderReflectionFile::Read(path, bytecodeHash, shader->second, nullptr)) {
+			validCount++;
+		}
+		else {
+			damagedCount++;
+			Log("[removed] " + path + " (damaged)");
+		}
+	}
+
+	Log("[shader cache] " + std::to_string(bytecodeSizes.size()) + " shaders, " +
+		std::to_string(validCount) + " valid, " +
+		std::to_string(staleCount) + " stale and " +
+		std::to_string(damagedCount) + " damaged removed");
+
+	return validCount;
+}
+
+#pragma region texture verification
+/// <summary>
+/// A generated image the texture pipeline is checked against
+/// </summary>
+struct TextureReference {
+	const char* name;
+	TextureUsage usage;
+	bool sRGB;
+	uint32_t width;
+	uint32_t height;
+};
+
+static const TextureReference textureReferences[] = {
+	{ "color", TEXTURE_USAGE_COLOR, true, 64, 64 },
+	{ "color alpha", TEXTURE_USAGE_COLOR, true, 64, 64 },
+	{ "mask", TEXTURE_USAGE_MASK, false, 64, 64 },
+	{ "normal", TEXTURE_USAGE_NORMAL, false, 64, 64 },
+	// Not whole blocks, so it stays RGBA8 and only the mips are checked
+	{ "odd size", TEXTURE_USAGE_COLOR, true, 30, 18 }
+};
+
+#define TEXTURE_REFERENCE_COUNT (sizeof(textureReferences) / sizeof(textureReferences[0]))
+
+/// <summary>
+/// What each preset is expected to make of a reference image: a hash of the
+/// whole mip chain, and a ceiling on the top mip's RMSE. The hashes have to be
+/// updated along with any change to mip filtering or the encoders that's meant
+/// to change their output; --verify-textures --verbose prints the new ones.
+/// </summary>
+struct TextureExpectation {
+	uint64_t hash;
+	float maxError;
+};
+
+static const TextureExpectation textureExpectations[TEXTURE_REFERENCE_COUNT][TEXTURE_PRESET_COUNT] = {
+	// uncompressed, fast, balanced, quality
+	{ { 0x20cd610e545c61a8ull, 0.0f }, { 0x667bbd0cfbfa60a6ull, 5.4f }, { 0xfa9fea62f4cb2154ull, 4.2f }, { 0x95f0a439696736a1ull, 3.0f } },
+	{ { 0xcd1f43cad8ae3fc1ull, 0.0f }, { 0x52a8fe515194dadbull, 4.9f }, { 0xa2561fcb2a40353cull, 3.7f }, { 0xdd2bd13675372114ull, 3.5f } },
+	{ { 0x30d7a6ab1e0ffc1dull, 0.0f }, { 0xee19c54ee1b36489ull, 1.7f }, { 0xf37d1cd503de1740ull, 1.6f }, { 0x568886849c2d95efull, 1.6f } },
+	{ { 0xbacbde0d7d5fc0abull, 0.0f }, { 0x15ec4827fedf8df7ull, 1.2f }, { 0xd16743d314d9ff37ull, 1.1f }, { 0xb60233d297c945d7ull, 1.1f } },
+	{ { 0x0cca3c194eb838d4ull, 0.0f }, { 0x0cca3c194eb838d4ull, 0.0f }, { 0x0cca3c194eb838d4ull, 0.0f }, { 0x0cca3c194eb838d4ull, 0.0f } }
+};
+
+/// <summary>
+/// Fills in a reference image: gradients, hard edges and noise, made from
+/// integer math (and sqrtf, which is exact) so it's the same on every platform
+/// </summary>
+static void MakeReferenceImage(size_t index, TextureFileImage* image) {
+	const TextureReference& reference = textureReferences[index];
+	image->width = reference.width;
+	image->height = reference.height;
+	image->pixels.resize((size_t)reference.width * reference.height * 4);
+
+	uint32_t seed = 12345u + (uint32_t)index;
+	for (uint32_t y = 0; y < reference.height; y++) {
+		for (uint32_t x = 0; x < reference.width; x++) {
+			seed = seed * 1664525u + 1013904223u;
+			int noise = (int)(seed >> 28) - 8;
+			int dx = (int)x - (int)reference.width / 2;
+			int dy = (int)y - (int)reference.height / 2;
+			int distance = dx * dx + dy * dy;
+			uint8_t* pixel = &image->pixels[((size_t)y * reference.width + x) * 4];
+
+			if (reference.usage == TEXTURE_USAGE_NORMAL) {
+				// Overlapping bumps on a grid, from the slope of a quadratic height
+				int bx = (int)(x % 16) - 8;
+				int by = (int)(y % 16) - 8;
+				float nx = (x / 16 + y / 16) % 2 ? (float)bx : -(float)bx;
+				float ny = (float)by;
+				float nz = 12.0f;
+				float length = sqrtf(nx * nx + ny * ny + nz * nz);
+				pixel[0] = (uint8_t)((nx / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+				pixel[1] = (uint8_t)((ny / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+				pixel[2] = (uint8_t)((nz / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+				pixel[3] = 255;
+				continue;
+			}
+
+			if (reference.usage == TEXTURE_USAGE_MASK) {
+				int value = (std::min)(distance / 4, 255) + noise;
+				pixel[0] = pixel[1] = pixel[2] = (uint8_t)(std::max)(0, (std::min)(value, 255));
+				pixel[3] = 255;
+				continue;
+			}
+
+			// A disc with a hard edge over two gradients, with noise on top
+			bool inside = distance < (int)(reference.width * reference.width / 9);
+			int red = (int)(x * 255 / (reference.width - 1)) + noise;
+			int green = (int)(y * 255 / (reference.height - 1)) - noise;
+			int blue = inside ? 220 + noise : 40 + noise;
+			pixel[0] = (uint8_t)(std::max)(0, (std::min)(red, 255));
+			pixel[1] = (uint8_t)(std::max)(0, (std::min)(green, 255));
+			pixel[2] = (uint8_t)(std::max)(0, (std::min)(blue, 255));
+			pixel[3] = 255;
+			if (index == 1) pixel[3] = inside ? 255 : (uint8_t)(x * 4);
+		}
+	}
+}
+
+unsigned int AssetCooker::VerifyTextures() {
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	jobSystem.Initialize(settings.jobCount);
+
+	unsigned int failures = 0;
+	for (size_t i = 0; i < TEXTURE_REFERENCE_COUNT; i++) {
+		const TextureReference& reference = textureReferences[i];
+		TextureFileImage image;
+		MakeReferenceImage(i, &image);
+
+		for (int preset = 0; preset < TEXTURE_PRESET_COUNT; preset++) {
+			std::vector<TextureFileImage> mips;
+			TextureFileFormat format = TextureCompressor::Process(image, reference.usage, reference.sRGB, (TexturePreset)preset, &mips);
+
+			// Everything the texture file would hold, so a change to any mip shows up
+			std::vector<uint8_t> contents;
+			contents.push_back((uint8_t)format);
+			for (const TextureFileImage& mip : mips) {
+				uint32_t size[2] = { mip.width, mip.height };
+				contents.insert(contents.end(), (const uint8_t*)size, (const uint8_t*)size + sizeof(size));
+				contents.insert(contents.end(), mip.pixels.begin(), mip.pixels.end());
+			}
+			uint64_t hash = AssetPack::HashContents(contents.data(), contents.size());
+			float error = format == TEXTURE_FORMAT_RGBA8 ? 0.0f : TextureCompressor::GetCompressionError(image, mips[0], format);
+
+			const TextureExpectation& expected = textureExpectations[i][preset];
+			bool passed = hash == expected.hash && error <= expected.maxError;
+			if (!passed) failures++;
+
+			if (!passed || settings.verbose) {
+				char hashText[17];
+				snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)hash);
+				Log(std::string(passed ? "[verified] " : "[failed] ") + reference.name + ", " +
+					TextureCompressor::GetPresetName((TexturePreset)preset) + ": " +
+					formatNames[format] + ", RMSE " + std::to_string(error) + ", hash " + hashText);
+			}
+		}
+	}
+
+	Log("[verify] " + std::to_string(TEXTURE_REFERENCE_COUNT * TEXTURE_PRESET_COUNT) + " texture outputs checked, " +
+		std::to_string(failures) + " failed");
+
+	jobSystem.Shutdown();
+	return failures;
+}
+#pragma endregion
+
+void AssetCooker::AddPackSources(const std::string& root, std::vector<AssetPackSource>* sources) {
+	std::error_code error;
+	fs::path rootPath = fs::canonical(root, error);
+	if (error) {
+		Log("[warning] Couldn't pack " + root + ": " + error.message());
+		return;
+	}
+
+	std::string rootName = rootPath.filename().string();
+	std::string rootString = rootPath.string();
+
+	for (fs::recursive_directory_iterator it(rootPath, error), end; !error && it != end; it.increment(error)) {
+		if (!fs::is_regular_file(it->path())) continue;
+
+		std::string fileName = it->path().filename().string();
+		std::string extension = ToLower(it->path().extension().string());
+
+		// Cook bookkeeping, half-written files, hidden editor files and other archives stay out
+		if (fileName == COOK_DATABASE_FILE || extension == ".tmp" || extension == ASSET_PACK_EXTENSION || StartsWith(fileName, ".")) continue;
+
+		std::string relativePath = it->path().string().substr(rootString.size() + 1);
+		std::replace(relativePath.begin(), relativePath.end(), '\\', '/');
+
+		AssetPackSource source;
+		source.packedPath = rootName + "/" + relativePath;
+		source.diskPath = it->path().string();
+		sources->push_back(source);
+	}
+
+	if (error) Log("[failed] Couldn't read " + root + ": " + error.message());
+}
+
+void AssetCooker::Log(const std::string& message) {
+	std::lock_guard<std::mutex> lock(logMutex);
+	std::cout << message << std::endl;
+}
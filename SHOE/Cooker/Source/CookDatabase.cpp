@@ -0,0 +1,137 @@
+#include "../Headers/CookDatabase.h"
+#include "../../Headers/MappedFile.h"
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <cstdlib>
+#include <cstdio>
+
+#define COOK_DATABASE_HEADER "SHOE cook database 1"
+
+static const uint64_t fnvPrime = 1099511628211ull;
+
+static std::string ToHex(uint64_t value) {
+	char buffer[17];
+	snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)value);
+	return buffer;
+}
+
+void CookDatabase::Load(const std::string& path) {
+	std::lock_guard<std::mutex> lock(recordMutex);
+	records.clear();
+
+	std::ifstream file(path);
+	if (!file.is_open()) return;
+
+	std::string line;
+	if (!std::getline(file, line) || line != COOK_DATABASE_HEADER) return;
+
+	// Each record is "output<TAB>recipe<TAB>inputCount",
+	// followed by one "<TAB>input<TAB>hash" line per input
+	CookRecord* current = nullptr;
+	while (std::getline(file, line)) {
+		if (line.empty()) continue;
+
+		std::vector<std::string> fields;
+		std::stringstream stream(line);
+		std::string field;
+		while (std::getline(stream, field, '\t')) fields.push_back(field);
+
+		if (line[0] == '\t') {
+			if (current == nullptr || fields.size() != 3) continue;
+			current->inputs.push_back({ fields[1], strtoull(fields[2].c_str(), nullptr, 16) });
+		}
+		else if (fields.size() == 3) {
+			CookRecord& record = records[fields[0]];
+			record.output = fields[0];
+			record.recipe = strtoull(fields[1].c_str(), nullptr, 16);
+			record.inputs.clear();
+			current = &record;
+		}
+	}
+}
+
+bool CookDatabase::Save(const std::string& path) {
+	std::lock_guard<std::mutex> lock(recordMutex);
+
+	std::string contents = COOK_DATABASE_HEADER "\n";
+	for (const std::pair<const std::string, CookRecord>& entry : records) {
+		const CookRecord& record = entry.second;
+		contents += record.output + "\t" + ToHex(record.recipe) + "\t" + std::to_string(record.inputs.size()) + "\n";
+
+		for (const CookInput& input : record.inputs) {
+			contents += "\t" + input.path + "\t" + ToHex(input.hash) + "\n";
+		}
+	}
+
+	return MappedFile::WriteWholeFile(path, contents.data(), contents.size());
+}
+
+bool CookDatabase::IsUpToDate(const CookRecord& wanted) {
+	std::lock_guard<std::mutex> lock(recordMutex);
+
+	std::map<std::string, CookRecord>::iterator existing = records.find(wanted.output);
+	if (existing == records.end()) return false;
+
+	const CookRecord& record = existing->second;
+	if (record.recipe != wanted.recipe || record.inputs.size() != wanted.inputs.size()) return false;
+
+	for (size_t i = 0; i < record.inputs.size(); i++) {
+		if (record.inputs[i].path != wanted.inputs[i].path || record.inputs[i].hash != wanted.inputs[i].hash) return false;
+	}
+
+	return true;
+}
+
+void CookDatabase::SetRecord(const CookRecord& record) {
+	std::lock_guard<std::mutex> lock(recordMutex);
+	records[record.output] = record;
+}
+
+std::vector<std::string> CookDatabase::RemoveRecordsExcept(const std::vector<std::string>& outputs) {
+	std::lock_guard<std::mutex> lock(recordMutex);
+
+	std::set<std::string> keep(outputs.begin(), outputs.end());
+	std::vector<std::string> removed;
+
+	for (std::map<std::string, CookRecord>::iterator it = records.begin(); it != records.end();) {
+		if (keep.count(it->first) == 0) {
+			removed.push_back(it->first);
+			it = records.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	return removed;
+}
+
+bool CookDatabase::HashFile(const std::string& path, uint64_t* hash) {
+	MappedFile file;
+	*hash = 14695981039346656037ull;
+
+	if (!file.Open(path)) {
+		// Mapping rejects empty files, but an empty file is still a valid input
+		std::ifstream empty(path, std::ios::binary | std::ios::ate);
+		return empty.is_open() && empty.tellg() == 0;
+	}
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	for (size_t i = 0; i < size; i++) {
+		*hash ^= data[i];
+		*hash *= fnvPrime;
+	}
+
+	return true;
+}
+
+uint64_t CookDatabase::HashString(const std::string& text, uint64_t hash) {
+	for (unsigned char c : text) {
+		hash ^= c;
+		hash *= fnvPrime;
+	}
+
+	return hash;
+}
@@ -0,0 +1,113 @@
+#include "../Headers/AssetCooker.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+// --------------------------------------------------------
+// Offline asset cooker. Converts the contents of an asset
+// folder into the engine's cooked formats, rebuilding only
+// what changed since the last run.
+//
+// Exit code is 0 on success, 1 if anything failed to cook
+// (or, with --verify-textures, failed verification)
+// and 2 for bad arguments.
+// --------------------------------------------------------
+
+static void PrintUsage() {
+	std::cout <<
+		"Usage: SHOECooker [options]\n"
+		"  --assets <folder>        Asset folder to cook (default: Assets)\n"
+		"  --output <folder>        Where cooked files go (default: Cooked)\n"
+		"  --force                  Rebuild everything, even if it's up to date\n"
+		"  --jobs <count>           Worker threads, 0 for one per core (default: 0)\n"
+		"  --texture-quality <name> uncompressed, fast, balanced or quality (default: balanced)\n"
+		"  --terrain-size <size>    Heightmap width and height in samples (default: 512)\n"
+		"  --terrain-scale <scale>  Terrain height scale (default: 25)\n"
+		"  --pack <file>            Also pack the asset and output folders into an archive (.spak)\n"
+		"  --benchmark-reads        Time reading every file one at a time against the async reader\n"
+		"  --check-shader-cache     Remove stale and damaged shader reflection cache files\n"
+		"  --verify-textures        Check the texture pipeline against reference images, then exit\n"
+		"  --verbose                Also list up to date assets and texture compression error\n"
+		"  --help                   Show this message\n";
+}
+
+int main(int argc, char* argv[])
+{
+	CookSettings settings;
+
+	for (int i = 1; i < argc; i++) {
+		const char* argument = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (strcmp(argument, "--force") == 0) {
+			settings.force = true;
+		}
+		else if (strcmp(argument, "--verbose") == 0) {
+			settings.verbose = true;
+		}
+		else if (strcmp(argument, "--benchmark-reads") == 0) {
+			settings.benchmarkReads = true;
+		}
+		else if (strcmp(argument, "--check-shader-cache") == 0) {
+			settings.checkShaderCache = true;
+		}
+		else if (strcmp(argument, "--verify-textures") == 0) {
+			settings.verifyTextures = true;
+		}
+		else if (strcmp(argument, "--help") == 0) {
+			PrintUsage();
+			return 0;
+		}
+		else if (value == nullptr) {
+			std::cerr << "Unknown or incomplete option " << argument << "\n";
+			PrintUsage();
+			return 2;
+		}
+		else if (strcmp(argument, "--assets") == 0) {
+			settings.assetRoot = value;
+			i++;
+		}
+		else if (strcmp(argument, "--output") == 0) {
+			settings.outputRoot = value;
+			i++;
+		}
+		else if (strcmp(argument, "--pack") == 0) {
+			settings.packPath = value;
+			i++;
+		}
+		else if (strcmp(argument, "--jobs") == 0) {
+			settings.jobCount = (unsigned int)strtoul(value, nullptr, 10);
+			i++;
+		}
+		else if (strcmp(argument, "--texture-quality") == 0) {
+			if (!TextureCompressor::ParsePreset(value, &settings.texturePreset)) {
+				std::cerr << "Unknown texture quality " << value << "\n";
+				PrintUsage();
+				return 2;
+			}
+			i++;
+		}
+		else if (strcmp(argument, "--terrain-size") == 0) {
+			settings.terrainWidth = settings.terrainHeight = (uint32_t)strtoul(value, nullptr, 10);
+			i++;
+		}
+		else if (strcmp(argument, "--terrain-scale") == 0) {
+			settings.terrainHeightScale = strtof(value, nullptr);
+			i++;
+		}
+		else {
+			std::cerr << "Unknown option " << argument << "\n";
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	if (settings.terrainWidth < 2) {
+		std::cerr << "Terrain size must be at least 2\n";
+		return 2;
+	}
+
+	AssetCooker cooker(settings);
+	if (settings.verifyTextures) return cooker.VerifyTextures() > 0 ? 1 : 0;
+	return cooker.Run() > 0 ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <fmod.hpp>
+#include "Texture.h"
+#include "Mesh.h"
+#include "Sky.h"
+#include "MeshFile.h"
+
+enum AssetCacheType {
+	ASSET_CACHE_TEXTURE,
+	ASSET_CACHE_MESH,
+	ASSET_CACHE_SOUND,
+	ASSET_CACHE_SKY,
+	ASSET_CACHE_PARTICLE_TEXTURE
+};
+
+/// <summary>
+/// One loaded file, or set of files, that can be handed out again instead of
+/// being reloaded. The asset members hold the first object created for it,
+/// which keeps the shared resources alive. Only the members for the entry's type are set.
+/// </summary>
+struct AssetCacheEntry {
+	AssetCacheType type;
+	unsigned int refCount = 0;
+
+	// Estimated size of a single copy, used to report what sharing saved
+	uint64_t gpuBytes = 0;
+	uint64_t cpuBytes = 0;
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureView;
+	std::shared_ptr<Texture> texture;
+	std::shared_ptr<Mesh> mesh;
+	std::shared_ptr<Sky> sky;
+	FMOD::Sound* sound = nullptr;
+};
+
+struct AssetCacheStats {
+	size_t entryCount = 0;
+	size_t referenceCount = 0;
+	uint64_t hitCount = 0;
+	uint64_t missCount = 0;
+	uint64_t savedGpuBytes = 0;
+	uint64_t savedCpuBytes = 0;
+};
+
+/// <summary>
+/// Reference counted cache of loaded assets, keyed by what was loaded rather
+/// than by what it's called. Two requests for files with the same contents
+/// share one entry, even through different paths, and a file that changed on
+/// disk gets a new one. File hashes are remembered per normalized path and only
+/// recomputed when the file's size or modified time changes.
+/// </summary>
+class AssetCache
+{
+public:
+	AssetCache();
+
+	// Entries hold GPU resources, so the cache can't be copied
+	AssetCache(AssetCache const&) = delete;
+	void operator=(AssetCache const&) = delete;
+
+	/// <summary>
+	/// Makes an absolute path with consistent separators (and case, on Windows),
+	/// so the same file always maps to the same string
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+
+	/// <summary>
+	/// Hashes a file's contents. Safe to call from JobSystem workers.
+	/// </summary>
+	/// <returns>False if the file is missing or empty</returns>
+	bool GetContentHash(const std::string& path, uint64_t* hash);
+
+	/// <summary>
+	/// Hashes the contents of several files, in order, into one value
+	/// </summary>
+	/// <returns>False if any of the files is missing or empty</returns>
+	bool GetContentHash(const std::vector<std::string>& paths, uint64_t* hash);
+
+	/// <summary>
+	/// Builds a cache key. Variant separates loads of the same contents
+	/// that produce different assets, like a sound opened in two modes.
+	/// </summary>
+	static std::string MakeKey(AssetCacheType type, uint64_t contentHash, const std::string& variant = "");
+
+	/// <summary>
+	/// Looks up an entry. Whatever is handed out for it
+	/// needs a reference added with AddReference.
+	/// </summary>
+	/// <returns>The entry, or null on a miss</returns>
+	AssetCacheEntry* Find(const std::string& key);
+
+	/// <summary>
+	/// Checks for an entry without counting a hit or a miss, for
+	/// working out ahead of time what a load would have to read
+	/// </summary>
+	bool Contains(const std::string& key);
+
+	/// <summary>
+	/// Adds a newly loaded asset, with no references yet
+	/// </summary>
+	AssetCacheEntry* Insert(const std::string& key, const AssetCacheEntry& entry);
+
+	/// <summary>
+	/// Records that an asset object was handed out for an entry. The same object
+	/// can be handed out several times, and holds a reference for each.
+	/// </summary>
+	void AddReference(const void* asset, const std::string& key);
+
+	/// <summary>
+	/// Drops every reference held by an asset object that's being removed.
+	/// The entry, and with it the shared resources, goes once nothing uses it.
+	/// </summary>
+	/// <returns>False if the object didn't come from the cache</returns>
+	bool Release(const void* asset);
+
+	/// <summary>
+	/// Whether an asset object handed out by the cache is still in use
+	/// </summary>
+	bool IsReferenced(const void* asset);
+
+	/// <summary>
+	/// Points texture entries at a new view of the same texture, like one
+	/// with more or fewer mips resident, so later hits share the new one
+	/// </summary>
+	void ReplaceTextureView(ID3D11ShaderResourceView* oldView, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> newView);
+
+	void Clear();
+
+	AssetCacheStats GetStats();
+
+private:
+	struct FileHash {
+		MeshFileSourceStamp stamp;
+		uint64_t hash;
+	};
+
+	std::unordered_map<std::string, FileHash> fileHashes;
+	std::mutex fileHashMutex;
+
+	struct AssetReference {
+		std::string key;
+		unsigned int count;
+	};
+
+	std::unordered_map<std::string, AssetCacheEntry> entries;
+	std::unordered_map<const void*, AssetReference> assetReferences;
+
+	uint64_t hitCount;
+	uint64_t missCount;
+};
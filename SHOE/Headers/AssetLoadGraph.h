@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "JobSystem.h"
+
+// Worker stages are handed a callback to report each finished item with
+typedef std::function<void(std::function<void()> itemLoaded)> AssetWorkerStage;
+
+/// <summary>
+/// One category of assets in a load graph. The worker stage does file reads and
+/// decoding on the JobSystem and may start immediately. The main thread stage does
+/// everything that needs the device or touches AssetManager state, and only runs once
+/// its own worker stage and the main thread stages of all its dependencies are done.
+/// </summary>
+struct AssetLoadNode {
+	std::string name;
+	AssetWorkerStage workerStage;
+	std::function<void()> mainThreadStage;
+	std::vector<int> dependencies;
+
+	std::future<void> workerResult;
+	std::atomic<int> itemsLoaded;
+	int itemCount;
+	bool complete;
+};
+
+class AssetLoadGraph
+{
+private:
+	std::vector<std::unique_ptr<AssetLoadNode>> nodes;
+
+	std::mutex progressMutex;
+	std::condition_variable progressChanged;
+
+	bool IsReady(AssetLoadNode* node);
+	std::string GetProgressString(AssetLoadNode* node);
+
+public:
+	/// <summary>
+	/// Adds a category to the graph
+	/// </summary>
+	/// <param name="name">Category name, passed to the progress listener</param>
+	/// <param name="mainThreadStage">Work that needs the device or AssetManager vectors</param>
+	/// <param name="dependencies">Node IDs whose main thread stage must finish first</param>
+	/// <param name="workerStage">Optional file read and decode work to run on the pool</param>
+	/// <param name="itemCount">How many times the worker stage will call its itemLoaded callback</param>
+	/// <returns>ID of the new node, for use as a dependency</returns>
+	int AddNode(std::string name,
+				std::function<void()> mainThreadStage,
+				std::vector<int> dependencies = std::vector<int>(),
+				AssetWorkerStage workerStage = {},
+				int itemCount = 0);
+
+	/// <summary>
+	/// Starts every worker stage, then runs main thread stages in dependency order
+	/// as they become ready. Must be called from the thread that owns the device.
+	/// </summary>
+	/// <param name="progressListener">Called on this thread before each main thread stage,
+	/// and again whenever worker progress changes while waiting</param>
+	void Execute(std::function<void(std::string)> progressListener = {});
+};
@@ -26,14 +26,158 @@
 #include "Collider.h"
 #include "EngineState.h"
 #include <tchar.h>
+#include "JobSystem.h"
+#include "AssetLoadGraph.h"
+#include "TextureCompressor.h"
+#include "TextureStreamer.h"
+#include "AssetCache.h"
+#include "FileWatcher.h"
+#include <unordered_set>
 
 #define RandomRange(min, max) (float)rand() / RAND_MAX * (max - min) + min
 
+// Unused assets are unloaded once the loaded ones estimate over this.
+// Zero turns the budget off, leaving only manual unloads. Off unless set.
+#define DEFAULT_ASSET_MEMORY_BUDGET 0ull
+// Seconds between checks against the budget
+#define ASSET_BUDGET_CHECK_INTERVAL 1.0f
+
 struct FMODUserData {
 	std::shared_ptr<std::string> name;
 	std::shared_ptr<std::string> filenameKey;
 };
 
+// Staging data for assets loaded through the Initialize load graph.
+// Worker stages fill in the decoded data, the main thread uploads it.
+struct TextureLoadRequest {
+	std::string fullPath;
+	std::string nameToLoad;
+	std::string textureName;
+	AssetPathIndex assetPath;
+	std::string cacheKey;
+	// Deferred requests are registered around a placeholder and loaded on first use
+	bool deferLoad;
+	DecodedTexture decodedTexture;
+	HRESULT result;
+};
+
+// Where a streamed texture's full mip chain is reloaded from, and the view of what's resident now
+struct StreamedTextureSource {
+	std::string fullPath;
+	TexturePreset preset;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureView;
+};
+
+struct MeshLoadRequest {
+	std::string fullPath;
+	std::string id;
+	std::string nameToLoad;
+	std::string cacheKey;
+	bool deferLoad;
+	// Set if an up to date .smesh was mapped, otherwise meshData holds the parsed source
+	std::shared_ptr<MeshFileView> meshFile;
+	MeshData meshData;
+	bool loaded;
+};
+
+struct SkyLoadRequest {
+	std::string fullPath;
+	std::string filepath;
+	bool fileType;
+	std::string name;
+	std::string fileExtension;
+	std::string cacheKey;
+	// Hash of the source files, and where their IBL maps are cached. Empty if the files couldn't be hashed.
+	uint64_t contentHash = 0;
+	std::string iblCachePath;
+	// Raw .dds file if fileType is 0, otherwise six decoded faces
+	std::vector<char> ddsFileData;
+	DecodedTexture faces[6];
+	// IBL maps read from the IBL cache or baked from the faces. Null for
+	// uncached .dds skies, whose maps the shaders render.
+	std::shared_ptr<IBLBakedSky> bakedIBL;
+	HRESULT result;
+};
+
+struct ParticleTextureLoadRequest {
+	std::string textureNameToLoad;
+	bool isMultiParticle;
+	std::vector<std::string> texturePaths;
+	std::string cacheKey;
+	std::vector<DecodedTexture> decodedTextures;
+};
+
+struct SoundLoadRequest {
+	std::string fullPath;
+	FMOD_MODE mode;
+	std::string name;
+	std::string cacheKey;
+	FMOD::Sound* sound;
+};
+
+// A scene's assets, read and decoded on JobSystem workers while another scene
+// is still running. While it's set, the Create methods take their data from
+// here instead of the disk. Files already in the asset cache are left out.
+struct ScenePreload {
+	std::vector<TextureLoadRequest> textures;
+	std::vector<MeshLoadRequest> meshes;
+	std::vector<SkyLoadRequest> skies;
+	std::vector<SoundLoadRequest> sounds;
+};
+
+// What a scene held in the global lists, set aside while the scene replacing
+// it loads. Its cache references are kept until then, so anything the two
+// scenes share is handed over rather than loaded again.
+struct RetiredSceneAssets {
+	std::vector<std::shared_ptr<SimplePixelShader>> pixelShaders;
+	std::vector<std::shared_ptr<SimpleVertexShader>> vertexShaders;
+	std::vector<std::shared_ptr<SimpleComputeShader>> computeShaders;
+	std::vector<std::shared_ptr<Sky>> skies;
+	std::vector<std::shared_ptr<Mesh>> meshes;
+	std::vector<std::shared_ptr<Texture>> textures;
+	std::vector<std::shared_ptr<Material>> materials;
+	std::vector<std::shared_ptr<TerrainMaterial>> terrainMaterials;
+	std::vector<FMOD::Sound*> sounds;
+	std::vector<std::shared_ptr<SHOEFont>> fonts;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11SamplerState>> textureSampleStates;
+};
+
+// Estimated size of the loaded assets. Resources shared
+// between several assets are only counted once.
+struct AssetMemoryUsage {
+	uint64_t gpuBytes = 0;
+	uint64_t cpuBytes = 0;
+};
+
+// How many of the first meshes, materials and terrain materials in the
+// global lists are referred to by index from records outside any component,
+// like the play snapshot or a streamed scene's cell files
+struct IndexedAssetCounts {
+	size_t meshCount = 0;
+	size_t materialCount = 0;
+	size_t terrainMaterialCount = 0;
+};
+
+// Meshes and CPU copy sizes under each residency policy
+struct MeshResidencyStats {
+	size_t meshCounts[MESH_RESIDENCY_COUNT] = {};
+	uint64_t cpuBytes[MESH_RESIDENCY_COUNT] = {};
+};
+
+// What a terrain mesh was built from, so it can be built again when its heightmap changes
+struct TerrainSource {
+	std::weak_ptr<Mesh> mesh;
+	std::string fullPath;
+	MeshFileTerrain settings;
+};
+
+struct HotReloadStats {
+	bool watching = false;
+	// Files that changed, and the loaded assets reloaded because of them
+	uint64_t changedFiles = 0;
+	uint64_t reloadedAssets = 0;
+};
+
 enum ComponentTypes {
 	// While Transform is tracked here, it is often skipped or handled uniquely
 	// when assessing all components, as it cannot be removed or doubled
@@ -91,20 +235,150 @@ private:
 
 	DirectX::XMFLOAT4 whiteTint = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
 
-	// Helper for creating a cubemap from 6 individual textures
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateCubemap(
-		const wchar_t* right,
-		const wchar_t* left,
-		const wchar_t* up,
-		const wchar_t* down,
-		const wchar_t* front,
-		const wchar_t* back);
 	std::shared_ptr<Mesh> LoadTerrain(const char* filename, unsigned int mapWidth, unsigned int mapHeight, float heightScale);
 
 	void CreateComplexGeometry();
-	void ProcessComplexModel(aiNode* node, const aiScene* scene, std::string serializedFilenameKey, std::string name);
-	std::shared_ptr<Mesh> ProcessComplexMesh(aiMesh* mesh, const aiScene* scene);
+	std::shared_ptr<GameEntity> ProcessComplexModel(aiNode* node, 
+													std::shared_ptr<GameEntity> parent, 
+													const std::vector<std::shared_ptr<Mesh>>& meshes, 
+													const std::vector<std::shared_ptr<Material>>& meshMaterials, 
+													std::string name);
+	std::vector<std::shared_ptr<Material>> ImportComplexMaterials(const aiScene* scene, std::string modelPath, std::string name);
+	static void ConvertComplexMesh(const aiMesh* mesh, OUT MeshData* meshData);
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> LoadParticleTexture(std::string textureNameToLoad, bool isMultiParticle);
+	ParticleTextureLoadRequest MakeParticleTextureRequest(std::string textureNameToLoad, bool isMultiParticle);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateParticleTextureFromRequest(const ParticleTextureLoadRequest& request);
+
+	// Decode helpers only read files and never touch the device
+	// or any asset vector, so they're safe to run on JobSystem workers.
+	static HRESULT DecodeTextureFile(std::string fullPath, OUT DecodedTexture* decodedTexture);
+	static HRESULT DecodeAndCompressTextureFile(std::string fullPath, TexturePreset preset, OUT DecodedTexture* decodedTexture);
+	static void DecodeTextureFiles(const std::vector<std::string>& fullPaths, OUT std::vector<DecodedTexture>* decodedTextures, std::function<void()> itemLoaded = {});
+	static bool ReadFileBytes(std::string fullPath, OUT std::vector<char>* fileData);
+	static void DecodeSkyRequest(SkyLoadRequest& request);
+	static void BakeSkyIBL(SkyLoadRequest& request);
+	void HashSkyRequest(SkyLoadRequest& request);
+	void CacheSkyIBL(const SkyLoadRequest& request, std::shared_ptr<Sky> sky);
+	static void DecodeMeshRequest(MeshLoadRequest& request);
+	static void DecodeParticleTextureRequest(ParticleTextureLoadRequest& request);
+	static bool DecodeCookedTexture(std::string cookedPath, unsigned int sliceCount, OUT DecodedTexture* decodedTextures);
+	static std::string GetCookedAssetPath(std::string fullPath, std::string cookedExtension);
+	static bool OpenCookedMesh(const std::string& fullPath, MeshFileView* meshFile);
+	static bool IsCookedFileCurrent(const std::string& cookedPath, const std::vector<std::string>& sourcePaths);
+	static uint64_t GetDecodedTextureSize(const DecodedTexture& decodedTexture);
+	static DXGI_FORMAT GetDecodedTextureFormat(const DecodedTexture& decodedTexture);
+	std::vector<std::string> GetParticleTexturePaths(std::string textureNameToLoad);
+
+	// Upload helpers, main thread only
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateTextureFromDecoded(const DecodedTexture& decodedTexture, unsigned int firstMip = 0);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateStreamedTexture(const DecodedTexture& decodedTexture, std::string fullPath, TexturePreset preset, OUT unsigned int* streamingID);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateCubemapFromDecoded(const DecodedTexture* faces);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateTextureArrayFromDecoded(const std::vector<DecodedTexture>& decodedTextures);
+	std::shared_ptr<Texture> RegisterTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> coreTexture, std::string nameToLoad, std::string textureName, AssetPathIndex assetPath, bool isNameFullPath);
+	std::shared_ptr<Sky> CreateSkyFromRequest(SkyLoadRequest& request);
+	std::shared_ptr<Sky> CreateSkyFromTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skyTexture, const SkyLoadRequest& request);
+	static std::vector<std::string> GetSkyFacePaths(const SkyLoadRequest& request);
+	FMOD::Sound* RegisterSound(FMOD::Sound* sound, std::string namePath, std::string name);
+
+	// Every file loaded through a Create or Queue method is looked up here first.
+	// Keys are made from file contents, so they can be built on workers,
+	// but entries are only found and added on the main thread.
+	AssetCache assetCache;
+
+	std::string GetContentCacheKey(AssetCacheType type, const std::vector<std::string>& fullPaths, std::string variant = "");
+	std::string GetTextureCacheKey(std::string fullPath, TexturePreset preset);
+	std::shared_ptr<Texture> FindCachedTexture(std::string cacheKey, std::string nameToLoad, std::string textureName, AssetPathIndex assetPath, bool isNameFullPath);
+	std::shared_ptr<Mesh> FindCachedMesh(std::string cacheKey, std::string id);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> FindCachedParticleTexture(std::string cacheKey);
+	std::shared_ptr<Sky> FindCachedSky(std::string cacheKey, const SkyLoadRequest& request);
+	FMOD::Sound* FindCachedSound(std::string cacheKey);
+	void CacheTexture(std::string cacheKey, std::shared_ptr<Texture> texture, const DecodedTexture& decodedTexture);
+	void CacheMesh(std::string cacheKey, std::shared_ptr<Mesh> mesh);
+	void CacheSky(std::string cacheKey, std::shared_ptr<Sky> sky, uint64_t textureBytes);
+	void CacheSound(std::string cacheKey, FMOD::Sound* sound, FMOD_MODE mode);
+
+	// Set for the length of a scene switch's swap
+	std::shared_ptr<ScenePreload> scenePreload;
+
+	bool TakePreloadedTexture(std::string cacheKey, OUT DecodedTexture* decodedTexture, OUT HRESULT* result);
+	bool TakePreloadedMesh(std::string cacheKey, OUT MeshLoadRequest* request);
+	bool TakePreloadedSky(std::string cacheKey, SkyLoadRequest* request);
+	FMOD::Sound* TakePreloadedSound(std::string cacheKey);
+
+	// Queues filled by the Initialize* methods and consumed by the load graph
+	std::vector<TextureLoadRequest> textureLoadQueue;
+	std::vector<MeshLoadRequest> meshLoadQueue;
+	std::vector<SkyLoadRequest> skyLoadQueue;
+	std::vector<SoundLoadRequest> soundLoadQueue;
+	std::vector<DecodedTexture> defaultParticleTextures;
+
+	void QueueTexture(std::string nameToLoad, std::string textureName, AssetPathIndex assetPath, bool deferLoad = true);
+	void QueueMesh(std::string id, std::string nameToLoad, bool deferLoad = true);
+	void QueueSky(std::string filepath, bool fileType, std::string name, std::string fileExtension = ".png");
+	void QueueSound(std::string path, FMOD_MODE mode, std::string name);
+
+	void DecodeQueuedTextures(std::function<void()> itemLoaded);
+	void DecodeQueuedMeshes(std::function<void()> itemLoaded);
+	void DecodeQueuedSkies(std::function<void()> itemLoaded);
+	void LoadQueuedSounds(std::function<void()> itemLoaded);
+
+	void CreateQueuedTextures();
+	void CreateQueuedMeshes();
+	void CreateQueuedSkies();
+	void RegisterQueuedSounds();
+
+	// Deferred assets stand in with a placeholder until first used, then
+	// decode on a JobSystem worker and swap the real data in on the main thread
+	size_t deferredLoadsInFlight;
+
+	std::shared_ptr<Texture> RegisterDeferredTexture(const TextureLoadRequest& request, std::shared_ptr<Texture> placeholder);
+	std::shared_ptr<Mesh> RegisterDeferredMesh(const MeshLoadRequest& request, std::shared_ptr<Mesh> placeholder);
+	void MaterializeTexture(std::weak_ptr<Texture> texture, std::string fullPath);
+	void MaterializeMesh(std::weak_ptr<Mesh> mesh, MeshLoadRequest request);
+	void MaterializeParticleTexture(std::weak_ptr<ParticleSystem> emitter, std::string textureNameToLoad, bool isMultiParticle);
+
+	uint64_t assetMemoryBudget;
+	float nextBudgetCheckTime;
+	std::function<IndexedAssetCounts()> indexedAssetCounter;
+
+	// Preset for textures that weren't cooked, which have their
+	// mips built and are block compressed on JobSystem workers
+	TexturePreset textureCompressionPreset;
+
+	// Textures loaded from files start with only their mip tail on the GPU.
+	// The streamer decides when the rest is reloaded and when it's dropped again.
+	TextureStreamer textureStreamer;
+	std::unordered_map<unsigned int, StreamedTextureSource> streamedTextureSources;
+
+	void ReleaseUnusedStreamedTextures();
+	void RequestMaterialStreaming(std::shared_ptr<Material> material, float screenSize);
+	void EvictStreamedMips(const TextureStreamingChange& change);
+	void StreamInMips(const TextureStreamingChange& change);
+	void SwapStreamedTexture(unsigned int streamingID, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureView);
+
+	// Watches Assets/ and Cooked/ while hot reload is on. Changed files are
+	// reloaded into the assets already using them, so nothing holding a
+	// Mesh, Texture, Sky, TerrainMaterial, emitter or shader has to change.
+	FileWatcher assetWatcher;
+	FileWatcher cookedWatcher;
+	HotReloadStats hotReloadStats;
+	std::vector<TerrainSource> terrainSources;
+
+	std::string GetHotReloadSourcePath(std::string changedPath);
+	std::string GetFilenameKeySourcePath(std::string filenameKey, AssetPathIndex assetPath);
+	static bool IsSameOrInsideFolder(const std::string& normalizedPath, std::string normalizedFolder);
+	size_t ReloadChangedFile(std::string fullPath);
+	size_t ReloadShaders(const std::string& normalizedPath, const std::string& fullPath);
+	size_t ReloadMeshes(const std::string& normalizedPath, const std::string& fullPath);
+	size_t ReloadTerrains(const std::string& normalizedPath);
+	size_t ReloadTextures(const std::string& normalizedPath, const std::string& fullPath);
+	size_t ReloadBlendMaps(const std::string& normalizedPath, const std::string& fullPath);
+	size_t ReloadSkies(const std::string& normalizedPath);
+	size_t ReloadParticleTextures(const std::string& normalizedPath);
+	static void DecodeTerrainRequest(MeshLoadRequest& request, const MeshFileTerrain& settings);
+
+	std::unordered_set<const void*> FindReferencedAssets();
+	static uint64_t GetTextureMemorySize(ID3D11ShaderResourceView* textureView, std::unordered_set<const void*>* countedResources);
 
 	void InitializeTextureSampleStates();
 	void InitializeMeshes();
@@ -194,6 +468,7 @@ public:
 	std::shared_ptr<SimplePixelShader> CreatePixelShader(std::string id, std::string nameToLoad);
 	std::shared_ptr<SimpleComputeShader> CreateComputeShader(std::string id, std::string nameToLoad);
 	std::shared_ptr<Mesh> CreateMesh(std::string id, std::string nameToLoad, bool isNameFullPath = false);
+	std::shared_ptr<GameEntity> ImportComplexModel(std::string nameToLoad, std::string name, bool isNameFullPath = false);
 	std::shared_ptr<Camera> CreateCamera(std::string name, float aspectRatio = 0);
 	std::shared_ptr<Light> CreateDirectionalLight(std::string name, DirectX::XMFLOAT3 color = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), float intensity = 1.0f);
 	std::shared_ptr<Light> CreatePointLight(std::string name, float range, DirectX::XMFLOAT3 color = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), float intensity = 1.0f);
@@ -294,14 +569,130 @@ public:
 	void RemovePixelShader(int id);
 	void RemoveMesh(std::string name);
 	void RemoveMesh(int id);
+	void RemoveTexture(std::string name);
+	void RemoveTexture(int id);
 	void RemoveMaterial(std::string name);
 	void RemoveMaterial(int id);
 	void RemoveTerrainMaterial(std::string name);
 	void RemoveTerrainMaterial(int id);
+	void RemoveSound(int id);
 
 	void CleanAllEntities();
 	void CleanAllVectors();
 
+	/// <summary>
+	/// Works out the cache key of every file in a preload. Safe to call from JobSystem workers.
+	/// </summary>
+	void HashScenePreload(ScenePreload* preload);
+
+	/// <summary>
+	/// Drops the files a preload would find in the asset cache, so they aren't read twice
+	/// </summary>
+	/// <returns>The number of files dropped</returns>
+	size_t FilterScenePreload(ScenePreload* preload);
+
+	/// <summary>
+	/// Reads and decodes every file left in a preload. Safe to call from JobSystem workers.
+	/// </summary>
+	void DecodeScenePreload(ScenePreload* preload);
+
+	/// <summary>
+	/// Has the Create methods use a preload's data until it's cleared
+	/// </summary>
+	void SetScenePreload(std::shared_ptr<ScenePreload> preload);
+
+	/// <summary>
+	/// Stops using a preload, and frees whatever of it wasn't used
+	/// </summary>
+	void ReleaseScenePreload(std::shared_ptr<ScenePreload> preload);
+
+	/// <summary>
+	/// Removes every entity, and moves every asset out of the global lists
+	/// without releasing anything from the asset cache, so a scene loaded
+	/// next shares whatever it has in common with this one
+	/// </summary>
+	void RetireSceneAssets(OUT RetiredSceneAssets* retired);
+
+	/// <summary>
+	/// Frees the retired assets the scene loaded after them didn't take over
+	/// </summary>
+	/// <returns>The number of meshes, textures, skies and sounds freed</returns>
+	size_t ReleaseRetiredAssets(RetiredSceneAssets* retired);
+
+	/// <summary>
+	/// Removes every mesh, texture, material, terrain material, sky and sound
+	/// that no component, component default or in-use material references,
+	/// freeing their GPU resources, CPU copies and FMOD sounds.
+	/// Placeholders, the current sky and playing sounds are kept.
+	/// </summary>
+	/// <returns>The number of assets removed</returns>
+	size_t UnloadUnusedAssets();
+
+	/// <summary>
+	/// Unloads unused assets if the loaded ones estimate over the memory budget.
+	/// Cheap to call every frame, the estimate is only made once per check interval.
+	/// Only runs while editing.
+	/// </summary>
+	/// <returns>The number of assets removed</returns>
+	size_t EnforceAssetMemoryBudget();
+
+	AssetMemoryUsage GetLoadedAssetMemory();
+	void SetAssetMemoryBudget(uint64_t budgetBytes);
+	uint64_t GetAssetMemoryBudget();
+
+	/// <summary>
+	/// Sets what reports the assets records refer to by index. Unloading keeps
+	/// every entry up to the counts it gives, so none of those indices shift.
+	/// </summary>
+	void SetIndexedAssetCounter(std::function<IndexedAssetCounts()> counter);
+
+	/// <summary>
+	/// Sets every loaded mesh, and the meshes loaded after, to one CPU residency policy
+	/// </summary>
+	void SetMeshResidency(MeshResidency residency);
+	MeshResidencyStats GetMeshResidencyStats();
+
+	/// <summary>
+	/// Sets how textures that weren't cooked are processed from now on.
+	/// Loaded textures keep their format.
+	/// </summary>
+	void SetTextureCompressionPreset(TexturePreset preset);
+	TexturePreset GetTextureCompressionPreset();
+
+	/// <summary>
+	/// Asks for mips for the materials of everything the camera can see, sized
+	/// by how big it is on screen, then streams mips in and out to match.
+	/// Stream-ins decode on JobSystem workers and are swapped in on the main thread.
+	/// </summary>
+	/// <param name="viewportHeight">Height of what the camera renders to, in pixels</param>
+	void UpdateTextureStreaming(std::shared_ptr<Camera> camera, float viewportHeight);
+
+	/// <summary>
+	/// Sets how much GPU memory streamed textures may use. 0 means no limit.
+	/// </summary>
+	void SetTextureStreamingBudget(uint64_t budgetBytes);
+	uint64_t GetTextureStreamingBudget();
+	TextureStreamingStats GetTextureStreamingStats();
+
+	/// <returns>False if the texture isn't streamed</returns>
+	bool GetTextureStreamingStatus(std::shared_ptr<Texture> texture, OUT StreamedTextureStatus* status);
+
+	/// <summary>
+	/// Starts or stops watching the asset folders for changed files
+	/// </summary>
+	/// <returns>False if it was turned on but neither folder could be watched</returns>
+	bool SetHotReloadEnabled(bool enabled);
+	bool IsHotReloadEnabled();
+
+	/// <summary>
+	/// Reloads the assets made from files that changed, in place. Call it on the
+	/// main thread between frames: files are decoded on JobSystem workers and
+	/// swapped in by RunMainThreadJobs, and shaders are swapped in right away.
+	/// </summary>
+	/// <returns>The number of assets being reloaded</returns>
+	size_t UpdateHotReload();
+	HotReloadStats GetHotReloadStats();
+
 	// Asset search-by-name methods
 
 	std::shared_ptr<GameEntity> GetGameEntityByName(std::string name);
@@ -323,7 +714,8 @@ public:
 	int GetComputeShaderIDByName(std::string name);
 	int GetMeshIDByName(std::string name);
 	int GetMaterialIDByName(std::string name);
-	//int GetTerrainMaterialIDByName(std::string name);
+	int GetTextureIDByName(std::string name);
+	int GetTerrainMaterialIDByName(std::string name);
 
 	// Relevant Get methods
 	
@@ -338,6 +730,11 @@ public:
 	size_t GetGameEntityArraySize();
 	size_t GetTerrainMaterialArraySize();
 	size_t GetSoundArraySize();
+	AssetCacheStats GetAssetCacheStats();
+	IBLCacheStats GetIBLCacheStats();
+	ShaderReflectionCacheStats GetShaderReflectionCacheStats();
+	size_t GetDeferredAssetCount();
+	size_t GetDeferredLoadsInFlight();
 
 	FMOD::Sound* GetSoundAtID(int id);
 	std::shared_ptr<Texture> GetTextureAtID(int id);
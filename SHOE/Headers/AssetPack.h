@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// Packed asset archive (.spak). Holds many files in one, so loading a scene
+// is a handful of mapped reads instead of thousands of opens and seeks.
+// Entries are compressed one by one in the LZ4 block format, or stored as
+// they are when that doesn't save enough to be worth decoding. Stored entries
+// start on a 16 byte boundary and are handed out straight from the mapping,
+// so cooked files keep the alignment their views rely on.
+//
+// Layout: AssetPackHeader, then entry data, then the table of contents:
+// entryCount AssetPackEntries sorted by path hash, then their path strings.
+// Paths are relative to the archive's mount point, '/' separated, and
+// looked up without regard to case.
+
+#define ASSET_PACK_MAGIC 0x4B504853 // "SHPK"
+#define ASSET_PACK_VERSION 2
+#define ASSET_PACK_EXTENSION ".spak"
+#define ASSET_PACK_DATA_ALIGNMENT 16
+
+// Compressed entries have to be at least this much smaller than the original, in 1/16ths
+#define ASSET_PACK_MIN_SAVING 1
+// Files per JobSystem job while packing
+#define ASSET_PACK_GRAIN_SIZE 4
+
+enum AssetPackEntryFlags : uint32_t {
+	ASSET_PACK_ENTRY_COMPRESSED = 1 << 0
+};
+
+struct AssetPackHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t entrySize;
+
+	uint32_t entryCount;
+	uint32_t padding;
+	uint64_t tocOffset;
+	uint64_t tocSize;
+	uint64_t tocChecksum;
+};
+
+struct AssetPackEntry {
+	uint64_t pathHash;
+	uint64_t offset;
+	uint64_t storedSize;
+	uint64_t size;
+
+	// Hash of the uncompressed contents, the same one AssetCache makes
+	uint64_t contentHash;
+	// Size and last write time (ns since the Unix epoch) of the file that was packed, for stamp checks against cooked files
+	uint64_t sourceSize;
+	int64_t sourceModifiedTime;
+
+	// Offset into the path strings, which follow the entries
+	uint32_t pathOffset;
+	uint32_t pathLength;
+	uint32_t flags;
+	uint32_t padding;
+};
+
+/// <summary>
+/// A file to pack, and the path it's stored under
+/// </summary>
+struct AssetPackSource {
+	std::string packedPath;
+	std::string diskPath;
+};
+
+struct AssetPackWriteStats {
+	size_t fileCount = 0;
+	size_t compressedCount = 0;
+	uint64_t originalBytes = 0;
+	uint64_t packedBytes = 0;
+	// Files that couldn't be read, left out of the archive
+	std::vector<std::string> failedPaths;
+};
+
+/// <summary>
+/// Read-only view of a mapped archive. Lookups and reads don't change
+/// anything, so they're safe from any thread once it's open.
+/// </summary>
+class AssetPack
+{
+public:
+	AssetPack();
+
+	// Entry pointers point into the mapping, so a pack can't be copied
+	AssetPack(AssetPack const&) = delete;
+	void operator=(AssetPack const&) = delete;
+
+	/// <summary>
+	/// Maps an archive and checks its header and table of contents
+	/// </summary>
+	/// <returns>False if missing, a different version, or corrupt</returns>
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen();
+	// Path the archive was opened from, for reading it without the mapping
+	const std::string& GetPath() const;
+
+	/// <summary>
+	/// Finds an entry by its packed path
+	/// </summary>
+	/// <returns>The entry, or null if it isn't in the archive</returns>
+	const AssetPackEntry* Find(const std::string& packedPath) const;
+
+	uint32_t GetEntryCount() const;
+	const AssetPackEntry* GetEntry(uint32_t index) const;
+	std::string GetEntryPath(const AssetPackEntry& entry) const;
+
+	/// <summary>
+	/// Gets an entry's bytes straight from the mapping
+	/// </summary>
+	/// <returns>The data, or null if the entry is compressed</returns>
+	const unsigned char* GetStoredData(const AssetPackEntry& entry) const;
+
+	/// <summary>
+	/// Decompresses an entry, or copies it if it was stored as is
+	/// </summary>
+	/// <returns>False if the compressed data is damaged</returns>
+	bool Read(const AssetPackEntry& entry, std::vector<unsigned char>* data) const;
+
+	/// <summary>
+	/// Writes an archive, compressing files in parallel on the JobSystem.
+	/// The output doesn't depend on the worker count or the order of the sources.
+	/// </summary>
+	/// <returns>False if the archive couldn't be written</returns>
+	static bool Write(const std::string& path, const std::vector<AssetPackSource>& sources, AssetPackWriteStats* stats = nullptr);
+
+	/// <summary>
+	/// Makes a path comparable: '/' separated and lower case
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+	static uint64_t HashPath(const std::string& normalizedPath);
+	static uint64_t HashContents(const unsigned char* data, size_t size);
+
+	/// <summary>
+	/// Size and last write time of a regular file on disk, in nanoseconds since the Unix epoch.
+	/// Seconds aren't enough, a source saved twice in the same second would keep its stale cooked copy.
+	/// </summary>
+	static bool GetDiskStamp(const std::string& path, uint64_t* size, int64_t* modifiedTime);
+
+	/// <summary>
+	/// Compresses a buffer into the LZ4 block format
+	/// </summary>
+	static void Compress(const unsigned char* data, size_t size, std::vector<unsigned char>* compressed);
+
+	/// <summary>
+	/// Decompresses an LZ4 block, checking every length against both buffers
+	/// </summary>
+	/// <returns>False if the block is damaged or doesn't fill the output exactly</returns>
+	static bool Decompress(const unsigned char* compressed, size_t compressedSize, unsigned char* data, size_t size);
+
+private:
+	MappedFile file;
+	std::string path;
+	const AssetPackHeader* header;
+	const AssetPackEntry* entries;
+	const char* paths;
+	size_t pathsSize;
+};
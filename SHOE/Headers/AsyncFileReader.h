@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include "VirtualFileSystem.h"
+
+// Reads mostly wait on the disk, so a couple of threads keep it busy
+// without taking cores from the JobSystem
+#define ASYNC_READ_THREAD_COUNT 2
+// Packed files closer together than this are read as one span, with the gap thrown away
+#define ASYNC_READ_MERGE_GAP (64 * 1024)
+// Largest span read in one go
+#define ASYNC_READ_MAX_SPAN (8 * 1024 * 1024)
+
+enum AsyncReadPriority {
+	ASYNC_READ_PRIORITY_LOW,
+	ASYNC_READ_PRIORITY_NORMAL,
+	ASYNC_READ_PRIORITY_HIGH
+};
+
+struct AsyncReadResult {
+	std::string path;
+	bool succeeded = false;
+	std::vector<char> data;
+	// Seconds from the request to its data being ready
+	double latency = 0;
+};
+
+typedef std::function<void(AsyncReadResult& result)> AsyncReadCallback;
+
+struct AsyncFileReaderStats {
+	uint64_t requestCount = 0;
+	uint64_t completedCount = 0;
+	uint64_t failedCount = 0;
+	// Requests answered by a read made for another request
+	uint64_t coalescedCount = 0;
+	uint64_t spanCount = 0;
+	uint64_t bytesRead = 0;
+	size_t pendingCount = 0;
+	double averageLatency = 0;
+	double maxLatency = 0;
+};
+
+/// <summary>
+/// Reads whole files on a few dedicated I/O threads, highest priority first.
+/// Files in the same archive that sit close together are read as one span
+/// and split afterwards, and requests for the same loose file share a read.
+/// Callbacks run on an I/O thread, so they should hand anything slow to the
+/// JobSystem and anything that needs the device to QueueMainThreadJob.
+/// </summary>
+class AsyncFileReader
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static AsyncFileReader& GetInstance()
+	{
+		if (!instance)
+		{
+			instance = new AsyncFileReader();
+		}
+
+		return *instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	AsyncFileReader(AsyncFileReader const&) = delete;
+	void operator=(AsyncFileReader const&) = delete;
+
+private:
+	static AsyncFileReader* instance;
+	AsyncFileReader();
+#pragma endregion
+
+public:
+	~AsyncFileReader();
+
+	/// <summary>
+	/// Starts the I/O threads. Safe to call more than once.
+	/// </summary>
+	void Initialize(unsigned int threadCount = ASYNC_READ_THREAD_COUNT);
+
+	/// <summary>
+	/// Stops the I/O threads once the reads they're on finish.
+	/// Anything still queued completes as failed, so nothing waits forever.
+	/// </summary>
+	void Shutdown();
+
+	/// <summary>
+	/// Queues a read. Without I/O threads, it's read before this returns.
+	/// </summary>
+	/// <param name="callback">Called on an I/O thread with the file's contents</param>
+	void Read(const std::string& path, AsyncReadPriority priority, AsyncReadCallback callback);
+	std::future<AsyncReadResult> Read(const std::string& path, AsyncReadPriority priority);
+
+	/// <summary>
+	/// Queues several reads at once, so they can be coalesced with each other
+	/// </summary>
+	/// <param name="callback">Called once per file with its index in paths</param>
+	void ReadBatch(const std::vector<std::string>& paths, AsyncReadPriority priority, std::function<void(size_t index, AsyncReadResult& result)> callback);
+	std::vector<std::future<AsyncReadResult>> ReadBatch(const std::vector<std::string>& paths, AsyncReadPriority priority);
+
+	AsyncFileReaderStats GetStats();
+
+private:
+	struct PendingRead {
+		std::string path;
+		AsyncReadCallback callback;
+		std::chrono::steady_clock::time_point requestTime;
+		// Set when an archive has the file
+		std::shared_ptr<AssetPack> pack;
+		const AssetPackEntry* entry = nullptr;
+	};
+
+	// Highest priority first, then oldest first
+	typedef std::pair<int, uint64_t> QueueKey;
+
+	std::vector<std::thread> threads;
+	std::map<QueueKey, PendingRead> queue;
+	// Queued reads by what they read from: the archive, or the loose file's path
+	std::unordered_map<std::string, std::vector<QueueKey>> sources;
+	std::mutex queueMutex;
+	std::condition_variable readAvailable;
+	uint64_t nextSequence;
+	bool running;
+
+	std::mutex statsMutex;
+	AsyncFileReaderStats stats;
+	double totalLatency;
+
+	PendingRead MakeRead(const std::string& path, AsyncReadCallback callback);
+	void Enqueue(std::vector<PendingRead>& reads, AsyncReadPriority priority);
+
+	/// <summary>
+	/// Takes the next read off the queue, with any it can share a read with
+	/// </summary>
+	/// <returns>False once it's shutting down</returns>
+	bool TakeReads(std::vector<PendingRead>* reads);
+	static std::string GetSourceKey(const PendingRead& read);
+
+	void ThreadLoop();
+	void ReadPacked(std::vector<PendingRead>& reads, std::ifstream& archive, std::string* archivePath);
+	void ReadLoose(std::vector<PendingRead>& reads);
+	void Complete(PendingRead& read, AsyncReadResult& result, bool coalesced);
+};
@@ -5,6 +5,8 @@
 #include <string>
 #include "DXCore.h"
 
+#define AUDIO_MAX_CHANNELS 512
+
 class AudioHandler
 {
 #pragma region Singleton
@@ -41,7 +43,10 @@ public:
 	FMOD_RESULT Initialize();
 
 	FMOD::Sound* LoadSound(std::string soundPath, FMOD_MODE mode);
+	// FMOD copies the data, so it doesn't have to outlive the call
+	FMOD::Sound* LoadSoundFromMemory(const char* data, size_t size, FMOD_MODE mode);
 	FMOD::Channel* BasicPlaySound(FMOD::Sound* sound);
+	bool IsSoundPlaying(FMOD::Sound* sound);
 
 	FMOD::System* GetSoundSystem();
 };
\ No newline at end of file
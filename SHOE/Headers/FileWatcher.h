@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+// Seconds a file has to go without changing before it's reported. Editors and
+// the cooker write in several steps, and this waits for the last of them.
+#define FILE_WATCHER_DEBOUNCE_TIME 0.25
+// How often the inotify thread checks whether it should stop, in milliseconds.
+// Windows wakes its thread with an event instead.
+#define FILE_WATCHER_STOP_CHECK_INTERVAL 100
+
+/// <summary>
+/// Watches a folder and everything under it for files that are written,
+/// created or renamed into place. Uses ReadDirectoryChangesW on Windows and
+/// inotify elsewhere. Changes are collected on a background thread and
+/// handed out by Poll, so whoever polls decides when it's safe to act on them.
+/// </summary>
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	// Owns an OS handle and a thread, so it can't be copied
+	FileWatcher(FileWatcher const&) = delete;
+	void operator=(FileWatcher const&) = delete;
+
+	/// <summary>
+	/// Starts watching a folder, stopping whatever was watched before
+	/// </summary>
+	/// <param name="folder">Full path to the folder</param>
+	/// <returns>False if the folder doesn't exist or can't be watched</returns>
+	bool Start(const std::string& folder);
+	void Stop();
+
+	bool IsWatching();
+	std::string GetFolder();
+
+	/// <summary>
+	/// Takes the files that changed and have since settled for the debounce time.
+	/// Files still changing are kept until a later call.
+	/// </summary>
+	/// <param name="changedPaths">Filled with full paths, in the folder's own form</param>
+	void Poll(std::vector<std::string>* changedPaths);
+
+private:
+	std::string folder;
+	std::thread thread;
+	std::atomic<bool> running;
+
+	// When each changed file last changed
+	std::map<std::string, std::chrono::steady_clock::time_point> changes;
+	std::mutex changeMutex;
+
+#ifdef _WIN32
+	void* directoryHandle;
+	void* stopEvent;
+#else
+	int inotifyDescriptor;
+	// Each subfolder has its own watch, so events are mapped back to their folder
+	std::map<int, std::string> watchedFolders;
+
+	void AddWatches(const std::string& root);
+#endif
+
+	void ThreadLoop();
+	void AddChange(const std::string& path);
+};
@@ -39,14 +39,17 @@ private:
 	// Mainly does pre- and post- loading, and creates
 	// the threads that do the actual loading
 	void LoadScene();
+	void SwitchScene();
 	void SaveScene();
 	void SaveSceneAs();
+	void CreateRenderer();
 
 	// Rendering helper methods
 	void DrawInitializingScreen(std::string category);
 	void DrawLoadingScreen();
 	void GenerateEditingUI();
 	void RenderChildObjectsInUI(std::shared_ptr<GameEntity> entity);
+	void ResetSkyUIIndex();
 	std::unique_ptr<Renderer> renderer;
 
 	// GUI control tracking/UI toggles
@@ -70,6 +73,8 @@ private:
 	// Then add helper functions for setting them?
 	int entityUIIndex;
 	int skyUIIndex;
+	// Seconds since scene edits were last journaled
+	float journalTimer;
 	DirectX::XMFLOAT3 UIPositionEdit;
 	DirectX::XMFLOAT3 UIRotationEdit;
 	DirectX::XMFLOAT3 UIScaleEdit;
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Sizes shared with Sky's shader path, so both produce the same textures
+#define IBL_CUBE_FACE_SIZE 256
+#define IBL_SPECULAR_MIP_SKIP 3
+#define IBL_BRDF_LOOKUP_SIZE 256
+
+// The BRDF shader's sample count. The LUT is baked once, so it uses all of them.
+#define IBL_BRDF_SAMPLES 4096
+
+// Specular prefiltering reads from the source's mips, picked by each sample's
+// footprint, so far fewer samples than the shader's 4096 give the same blur
+#define IBL_SPECULAR_SAMPLES 128
+
+// Expected mean absolute difference from the shader path, per channel, in 0-1 units.
+// Measured against a CPU port of the shaders: up to 0.6/255 irradiance and 0.5/255
+// specular on smooth and high contrast skies. Single texel stars are the worst case,
+// at 6.6/255 and 1.7/255, since the shaders filter before removing their gamma and
+// lose most of a star's light. The LUT only differs by float precision.
+#define IBL_IRRADIANCE_TOLERANCE (7.0f / 255.0f)
+#define IBL_SPECULAR_TOLERANCE (3.0f / 255.0f)
+#define IBL_BRDF_TOLERANCE (16.0f / 65535.0f)
+
+/// <summary>
+/// Cube map in the linear space Sky's shaders light in: 0-1 values, after the
+/// GPU's sRGB decode and their own 2.2 gamma, with a box filtered mip chain.
+/// Faces are in D3D order: +X, -X, +Y, -Y, +Z, -Z.
+/// </summary>
+struct IBLCubemap {
+	uint32_t faceSize = 0;
+	uint32_t mipLevels = 0;
+	// Each face's mips, largest first, 3 floats per texel
+	std::vector<float> faces[6];
+};
+
+/// <summary>
+/// RGBA8 cube faces with their mips packed largest first, ready to upload
+/// </summary>
+struct IBLCubeFaces {
+	uint32_t faceSize = 0;
+	uint32_t mipLevels = 0;
+	std::vector<unsigned char> faces[6];
+};
+
+/// <summary>
+/// Everything Sky needs besides the shared BRDF lookup
+/// </summary>
+struct IBLBakedSky {
+	// Linear irradiance, 9 coefficients per channel
+	float irradianceSH[9][3] = {};
+	IBLCubeFaces irradiance;
+	IBLCubeFaces specular;
+
+	// Set when the cubes were read back from what the IBL shaders
+	// rendered, instead of being baked. There's no SH then.
+	bool fromShaders = false;
+	bool fromCache = false;
+};
+
+struct IBLError {
+	float mean = 0.0f;
+	float max = 0.0f;
+};
+
+/// <summary>
+/// Computes image based lighting on the CPU, with no device, so it can run
+/// on JobSystem workers or offline. Results match the IBL shaders Sky
+/// renders with, within the IBL_*_TOLERANCE values.
+/// </summary>
+class IBLBaker
+{
+public:
+	/// <summary>
+	/// Converts six square RGBA8 faces into a cube map with mips
+	/// </summary>
+	/// <param name="sRGB">Whether the faces are uploaded as sRGB, which the GPU decodes before the shaders see them</param>
+	/// <returns>False if the faces are missing or not all the same square size</returns>
+	static bool BuildCubemap(const unsigned char* const faces[6], uint32_t width, uint32_t height, bool sRGB, IBLCubemap* cubemap);
+
+	/// <summary>
+	/// Projects the cube map's radiance onto 9 SH coefficients and convolves
+	/// them with a cosine lobe, giving irradiance. Faces are projected in parallel.
+	/// </summary>
+	static void ProjectIrradianceSH(const IBLCubemap& cubemap, float irradianceSH[9][3]);
+
+	/// <summary>
+	/// Evaluates irradiance SH into cube faces, stored the way the irradiance shader writes them
+	/// </summary>
+	static void BakeIrradiance(const float irradianceSH[9][3], uint32_t faceSize, IBLCubeFaces* irradiance);
+
+	/// <summary>
+	/// GGX prefiltered specular, one mip per roughness step from 0 to 1
+	/// </summary>
+	static void PrefilterSpecular(const IBLCubemap& cubemap, uint32_t faceSize, uint32_t mipLevels, IBLCubeFaces* specular);
+
+	/// <summary>
+	/// Runs every sky bake. Same as calling the steps one by one.
+	/// </summary>
+	/// <returns>False if the faces couldn't be used, see BuildCubemap</returns>
+	static bool BakeSky(const unsigned char* const faces[6], uint32_t width, uint32_t height, bool sRGB, IBLBakedSky* bakedSky);
+
+	/// <summary>
+	/// The split sum BRDF lookup, as R16G16 UNORM texels, IBL_BRDF_LOOKUP_SIZE on a side.
+	/// It's the same for every sky, so Sky bakes it once and shares it.
+	/// </summary>
+	static void BakeBRDFLookup(std::vector<uint16_t>* lookup);
+
+	static uint32_t GetSpecularMipLevels(uint32_t faceSize);
+
+	/// <summary>
+	/// Differences between the color channels of two sets of RGBA8 texels
+	/// </summary>
+	static IBLError CompareTexels(const unsigned char* a, const unsigned char* b, size_t texelCount);
+
+	/// <summary>
+	/// Differences between two sets of R16G16 texels
+	/// </summary>
+	static IBLError CompareTexels(const uint16_t* a, const uint16_t* b, size_t texelCount);
+};
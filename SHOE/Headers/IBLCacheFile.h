@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "IBLBaker.h"
+#include "MappedFile.h"
+
+// Cached IBL products (.sibl). One file holds either a sky's irradiance and
+// specular cubes (plus its irradiance SH if it was baked on the CPU) or the
+// shared BRDF lookup. Files are named by the hash of what they were made from
+// and the settings they were made with, and both are checked again on read,
+// along with a checksum of everything after the header.
+//
+// Layout: IBLCacheFileHeader, then the payload.
+//   Sky: 6 irradiance faces (RGBA8, one mip), then 6 specular faces (RGBA8, mips packed largest first)
+//   BRDF lookup: R16G16 texels, row by row
+
+#define IBL_CACHE_FILE_MAGIC 0x42494853 // "SHIB"
+#define IBL_CACHE_FILE_VERSION 1
+#define IBL_CACHE_FILE_EXTENSION ".sibl"
+#define IBL_CACHE_FOLDER "IBLCache\\"
+
+// Bump when the baker or the IBL shaders change their output,
+// so every existing cache file is treated as a miss
+#define IBL_BAKE_VERSION 2
+
+enum IBLCacheFileKind : uint32_t {
+	IBL_CACHE_SKY = 1,
+	IBL_CACHE_BRDF_LOOKUP
+};
+
+enum IBLCacheFileFlags : uint32_t {
+	IBL_CACHE_FLAG_HAS_SH = 1 << 0,
+	IBL_CACHE_FLAG_FROM_SHADERS = 1 << 1
+};
+
+struct IBLCacheFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t kind;
+
+	uint32_t flags;
+	uint32_t faceSize;
+	uint32_t mipLevels;
+	uint32_t padding;
+
+	uint64_t sourceHash;
+	uint64_t settingsHash;
+	uint64_t payloadSize;
+	uint64_t payloadChecksum;
+
+	float irradianceSH[9][3];
+	float padding2;
+};
+
+struct IBLCacheStats {
+	uint64_t hitCount = 0;
+	uint64_t missCount = 0;
+	// Files that were there but failed validation, also counted as misses
+	uint64_t corruptCount = 0;
+	uint64_t writeCount = 0;
+	uint64_t failedWriteCount = 0;
+};
+
+/// <summary>
+/// Reads and writes cached IBL products. Everything here is safe to call
+/// from JobSystem workers, and the counters behind GetStats are shared.
+/// </summary>
+class IBLCacheFile
+{
+public:
+	/// <summary>
+	/// Hash of every setting that changes baked output. Maps rendered by the
+	/// shaders hash differently from CPU bakes of the same source.
+	/// </summary>
+	static uint64_t GetSettingsHash(IBLCacheFileKind kind, bool fromShaders);
+
+	/// <summary>
+	/// Gets the file a sky's IBL products are cached in
+	/// </summary>
+	/// <param name="cacheFolder">Folder holding the cache files, ending in a separator</param>
+	/// <param name="sourceHash">Hash of the sky's source files, 0 for the BRDF lookup</param>
+	static std::string GetCachePath(const std::string& cacheFolder, IBLCacheFileKind kind, uint64_t sourceHash, bool fromShaders);
+
+	/// <summary>
+	/// Loads a sky's cached IBL products. Deletes the file if it's damaged,
+	/// so the next write replaces it.
+	/// </summary>
+	/// <returns>False on a miss</returns>
+	static bool ReadSky(const std::string& path, uint64_t sourceHash, bool fromShaders, IBLBakedSky* bakedSky);
+
+	/// <summary>
+	/// Writes a sky's IBL products, creating the cache folder if needed
+	/// </summary>
+	static bool WriteSky(const std::string& path, uint64_t sourceHash, const IBLBakedSky& bakedSky);
+
+	/// <summary>
+	/// Loads the cached BRDF lookup, IBL_BRDF_LOOKUP_SIZE on a side
+	/// </summary>
+	/// <returns>False on a miss</returns>
+	static bool ReadBRDFLookup(const std::string& path, std::vector<uint16_t>* lookup);
+	static bool WriteBRDFLookup(const std::string& path, const std::vector<uint16_t>& lookup);
+
+	static IBLCacheStats GetStats();
+
+private:
+	static std::atomic<uint64_t> hitCount;
+	static std::atomic<uint64_t> missCount;
+	static std::atomic<uint64_t> corruptCount;
+	static std::atomic<uint64_t> writeCount;
+	static std::atomic<uint64_t> failedWriteCount;
+
+	static const unsigned char* OpenPayload(MappedFile& file, const std::string& path, IBLCacheFileKind kind, uint64_t sourceHash, uint64_t settingsHash);
+	static bool Write(const std::string& path, const IBLCacheFileHeader& header, const std::vector<unsigned char>& payload);
+	static uint64_t Checksum(const unsigned char* data, size_t size);
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "TextureFile.h"
+
+/// <summary>
+/// Dependency-free PNG and baseline JPEG decoding into RGBA8, for tools
+/// that can't rely on WIC. The sRGB flag follows the same rules the engine's
+/// WIC path uses: a PNG sRGB chunk, or an EXIF color space of 1 in a JPEG.
+/// </summary>
+class ImageDecoder
+{
+public:
+	/// <summary>
+	/// Decodes a PNG or JPEG file, picked by its signature
+	/// </summary>
+	/// <param name="error">Optional, set to a reason when decoding fails</param>
+	/// <returns>False if the file is missing, corrupt or uses an unsupported feature</returns>
+	static bool Decode(const std::string& path, TextureFileImage* image, bool* sRGB, std::string* error = nullptr);
+
+	static bool DecodePNG(const uint8_t* data, size_t size, TextureFileImage* image, bool* sRGB, std::string* error = nullptr);
+
+	/// <summary>
+	/// Decodes baseline (sequential Huffman) JPEGs with one or three components.
+	/// Progressive and arithmetic coded files are rejected.
+	/// </summary>
+	static bool DecodeJPEG(const uint8_t* data, size_t size, TextureFileImage* image, bool* sRGB, std::string* error = nullptr);
+
+	/// <summary>
+	/// Decompresses a zlib stream (RFC 1950/1951)
+	/// </summary>
+	static bool Inflate(const uint8_t* data, size_t size, std::vector<uint8_t>* output);
+};
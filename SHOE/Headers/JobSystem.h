@@ -0,0 +1,116 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <type_traits>
+#include <algorithm>
+#include <exception>
+
+/// <summary>
+/// A small fixed-size worker pool. Jobs scheduled here must not touch
+/// the D3D11 immediate context or any AssetManager vector - anything that
+/// has to run on the thread that owns the device should be queued with
+/// QueueMainThreadJob and picked up by RunMainThreadJobs instead.
+/// </summary>
+class JobSystem
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static JobSystem& GetInstance()
+	{
+		if (!instance)
+		{
+			instance = new JobSystem();
+		}
+
+		return *instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	JobSystem(JobSystem const&) = delete;
+	void operator=(JobSystem const&) = delete;
+
+private:
+	static JobSystem* instance;
+	JobSystem()
+	{
+		running = false;
+	};
+#pragma endregion
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::deque<std::function<void()>> mainThreadJobs;
+	std::mutex jobMutex;
+	std::mutex mainThreadMutex;
+	std::condition_variable jobAvailable;
+	bool running;
+
+	void WorkerLoop();
+	void Enqueue(std::function<void()> job);
+
+public:
+	~JobSystem();
+
+	/// <summary>
+	/// Starts the worker threads. Safe to call more than once.
+	/// </summary>
+	/// <param name="workerCount">0 uses one worker per hardware thread, minus the main thread</param>
+	void Initialize(unsigned int workerCount = 0);
+	void Shutdown();
+
+	unsigned int GetWorkerCount();
+
+	/// <summary>
+	/// Runs a job on the worker pool.
+	/// </summary>
+	/// <returns>A future holding the job's result, or the exception it threw</returns>
+	template <typename F>
+	std::future<typename std::result_of<F()>::type> Schedule(F job);
+
+	/// <summary>
+	/// Splits [0, count) into chunks of at most grainSize and runs them across
+	/// the pool. The calling thread works on chunks too, so this is safe to
+	/// call from inside another job.
+	/// </summary>
+	void ParallelFor(size_t count, size_t grainSize, std::function<void(size_t start, size_t end)> job);
+
+	/// <summary>
+	/// Runs one pending pool job on the calling thread, if there is one.
+	/// Used to keep waiting threads busy instead of blocking.
+	/// </summary>
+	/// <returns>True if a job was run</returns>
+	bool TryRunPendingJob();
+
+	void QueueMainThreadJob(std::function<void()> job);
+	void RunMainThreadJobs();
+};
+
+template<typename F>
+std::future<typename std::result_of<F()>::type> JobSystem::Schedule(F job)
+{
+	typedef typename std::result_of<F()>::type ResultType;
+
+	// packaged_task is move-only, but the queue stores copyable std::functions
+	std::shared_ptr<std::packaged_task<ResultType()>> task = std::make_shared<std::packaged_task<ResultType()>>(job);
+	std::future<ResultType> result = task->get_future();
+
+	if (workers.empty()) {
+		// No pool to hand off to, so do the work now
+		(*task)();
+		return result;
+	}
+
+	Enqueue([task]() { (*task)(); });
+
+	return result;
+}
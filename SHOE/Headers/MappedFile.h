@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/// <summary>
+/// Read-only memory mapping of a whole file. Uses CreateFileMapping/MapViewOfFile
+/// on Windows and mmap elsewhere, so it's usable from both the engine and tools.
+/// </summary>
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	// A mapping owns OS handles, so it can't be copied
+	MappedFile(MappedFile const&) = delete;
+	void operator=(MappedFile const&) = delete;
+
+	/// <summary>
+	/// Maps the file at the given path, closing any previous mapping
+	/// </summary>
+	/// <returns>False if the file doesn't exist, is empty, or can't be mapped</returns>
+	bool Open(const std::string& path);
+	void Close();
+
+	/// <summary>
+	/// Replaces a file's contents. Writes to a temporary file next to it first and
+	/// renames it into place, so a reader never maps a half-written file.
+	/// </summary>
+	/// <returns>False if the file couldn't be written</returns>
+	static bool WriteWholeFile(const std::string& path, const void* data, size_t size);
+
+	/// <summary>
+	/// Renames a finished temporary file over another, replacing it if it exists.
+	/// The temporary file is removed if that fails.
+	/// </summary>
+	static bool CommitTempFile(const std::string& tempPath, const std::string& path);
+
+	bool IsOpen();
+	const unsigned char* GetData();
+	size_t GetSize();
+
+private:
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+	const unsigned char* data;
+	size_t size;
+};
@@ -2,11 +2,37 @@
 
 #include "Vertex.h"
 #include "DXCore.h"
+#include "MeshFile.h"
 #include <DirectXMath.h>
 #include <DirectXCollision.h>
 #include <wrl/client.h>
 #include <fstream>
 #include <vector>
+#include <memory>
+#include <functional>
+
+/// <summary>
+/// CPU-side vertex and index data, as produced by a loader
+/// before any GPU resources exist. Safe to build off the main thread.
+/// </summary>
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+};
+
+/// <summary>
+/// How much of a mesh stays in CPU memory once its buffers are uploaded.
+/// Only picking reads the CPU copy, and it only needs positions.
+/// </summary>
+enum MeshResidency {
+	// Every vertex attribute and index
+	MESH_RESIDENCY_FULL,
+	// Positions and indices, enough to pick against triangles
+	MESH_RESIDENCY_POSITIONS,
+	// Nothing, picking falls back to the mesh's bounds
+	MESH_RESIDENCY_DISCARD,
+	MESH_RESIDENCY_COUNT
+};
 
 class Mesh
 {
@@ -15,6 +41,9 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> inBuffer;
 	Vertex* vertexArray;
 	unsigned int* indices;
+	DirectX::XMFLOAT3* positions;
+	MeshResidency residency;
+	int vertexCount;
 	int indexCount;
 	int materialIndex;
 	bool enabled;
@@ -22,6 +51,18 @@ private:
 	DirectX::BoundingOrientedBox bounds;
 	std::string name;
 	std::string filenameKey;
+	// Set if the buffers and arrays belong to another mesh
+	std::shared_ptr<Mesh> sharedSource;
+	// Loads the real mesh, if this is still a placeholder
+	std::function<void()> materializer;
+
+	static MeshResidency defaultResidency;
+
+	void InitializeFromMeshFile(MeshFileView& meshFile, Microsoft::WRL::ComPtr<ID3D11Device> device);
+	void Materialize();
+	void ReleaseData();
+	void StoreCPUData(const Vertex* vertices, int vertexCount, const unsigned int* indices, int indexCount);
+	void ApplyResidency();
 public:
 	//Load mesh from manual array
 	Mesh(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCount, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name = "mesh");
@@ -29,19 +70,73 @@ public:
 	//Load mesh from file
 	Mesh(std::string filename, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name = "mesh");
 
+	//Load mesh from pre-processed data (tangents must already be calculated)
+	Mesh(const MeshData& data, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name = "mesh");
+
+	//Load mesh from a mapped binary mesh file
+	Mesh(MeshFileView& meshFile, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name = "mesh");
+
+	//Share another mesh's buffers under a different name
+	Mesh(std::shared_ptr<Mesh> source, std::string name);
+
 	//Load mesh from assimp (don't reset tangents)
 	Mesh(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCount, int associatedMaterialIndex, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name = "mesh");
 
 	~Mesh();
 
-	void MakeBuffers(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCount, Microsoft::WRL::ComPtr<ID3D11Device> device);
-	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
-	void CalculateBounds(Vertex* verts, int numVerts);
+	/// <summary>
+	/// Defers loading until the mesh is first used. It shares a placeholder's
+	/// buffers until then, and the materializer is called once, on the first
+	/// access to the buffers, arrays or bounds.
+	/// </summary>
+	void SetMaterializer(std::function<void()> materializer);
+	bool IsLoadDeferred();
+
+	//Replace the placeholder data once the real mesh is loaded
+	void SetMeshData(const MeshData& data, Microsoft::WRL::ComPtr<ID3D11Device> device);
+	void SetMeshData(MeshFileView& meshFile, Microsoft::WRL::ComPtr<ID3D11Device> device);
+	void SetMeshData(std::shared_ptr<Mesh> source);
+
+	/// <summary>
+	/// Residency given to meshes as they're created
+	/// </summary>
+	static void SetDefaultResidency(MeshResidency residency);
+	static MeshResidency GetDefaultResidency();
+
+	/// <summary>
+	/// Trims the CPU copy down to what the policy keeps. Data that's already
+	/// gone isn't brought back, a higher policy only applies to later loads.
+	/// Meshes sharing another mesh's data set the policy on their source.
+	/// </summary>
+	void SetResidency(MeshResidency residency);
+	MeshResidency GetResidency();
+
+	/// <summary>
+	/// Bytes held by the CPU copy. Zero for meshes sharing another mesh's data.
+	/// </summary>
+	size_t GetCPUMemorySize();
+
+	/// <summary>
+	/// Finds the closest triangle a ray hits, or the bounds if the triangles were discarded
+	/// </summary>
+	/// <param name="world">Transform from the mesh's space to the ray's</param>
+	/// <param name="distance">Distance along the ray to the hit</param>
+	/// <returns>False if nothing was hit</returns>
+	bool Raycast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, DirectX::CXMMATRIX world, float* distance);
+
+	void MakeBuffers(const Vertex* vertexArray, int vertices, const unsigned int* indices, int indexCount, Microsoft::WRL::ComPtr<ID3D11Device> device);
+	static void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
+	static bool LoadOBJ(std::string filename, MeshData& outData);
+	static bool WriteMeshFile(std::string filename, const MeshData& data, const MeshFileSourceStamp& source);
+	void CalculateBounds(const Vertex* verts, int numVerts);
 
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
+	// Null unless the mesh keeps its full CPU copy
 	Vertex* GetVertexArray();
+	// Null if the mesh discarded its CPU copy
 	unsigned int* GetIndexArray();
+	int GetVertexCount();
 	int GetIndexCount();
 
 	void SetDepthPrePass(bool prePass);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MeshFile.h"
+
+// Triangles and vertices per job when calculating tangents
+#define TANGENT_GRAIN_SIZE (1 << 14)
+
+/// <summary>
+/// Builds mesh data on the CPU without any device or DirectXMath
+/// dependencies, so the engine and the asset cooker produce the
+/// exact same vertices from the same source files.
+/// </summary>
+class MeshBuilder
+{
+public:
+	/// <summary>
+	/// Parses an .obj file into welded vertex and index data, converted to
+	/// DirectX's left-handed space. Tangents are left at zero. See ObjParser.
+	/// </summary>
+	/// <param name="error">Optional, set to a reason when loading fails</param>
+	/// <returns>False if the file couldn't be opened or is corrupt</returns>
+	static bool LoadOBJ(const std::string& filename, std::vector<MeshFileVertex>* vertices, std::vector<uint32_t>* indices, std::string* error = nullptr);
+
+	/// <summary>
+	/// Reads a headerless 16-bit heightmap. Samples past the end of a short file are zero.
+	/// </summary>
+	/// <returns>False if the file couldn't be opened</returns>
+	static bool LoadHeightmap(const std::string& filename, uint32_t mapWidth, uint32_t mapHeight, std::vector<uint16_t>* heights);
+
+	/// <summary>
+	/// Builds a grid of mapWidth by mapHeight vertices, one unit apart,
+	/// with smoothed normals. Tangents are left at zero.
+	/// </summary>
+	static void BuildTerrain(const uint16_t* heights,
+							 uint32_t mapWidth,
+							 uint32_t mapHeight,
+							 float heightScale,
+							 std::vector<MeshFileVertex>* vertices,
+							 std::vector<uint32_t>* indices);
+
+	/// <summary>
+	/// Calculates MikkTSpace style per-vertex tangents from positions, normals
+	/// and uvs. w holds the bitangent's sign, for mirrored uvs. Runs on the
+	/// JobSystem, and gives the same result for the same input every time.
+	/// </summary>
+	static void CalculateTangents(MeshFileVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+	/// <summary>
+	/// Fills in an axis-aligned bounding box, with an identity orientation
+	/// </summary>
+	static void CalculateBounds(const MeshFileVertex* vertices, uint32_t vertexCount, MeshFileContents* contents);
+};
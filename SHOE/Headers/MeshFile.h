@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "VirtualFileSystem.h"
+
+// Binary mesh container (.smesh). Holds final, upload-ready vertex and index
+// data plus bounds and meshlets, so loading is a map and a pointer fix-up
+// instead of a parse. Everything is little-endian and every section
+// starts on a 16 byte boundary, so vertex data can be handed straight to the
+// GPU from the mapped pages.
+//
+// Layout: MeshFileHeader, then sectionCount MeshFileSections, then section data.
+
+#define MESH_FILE_MAGIC 0x534D4853 // "SHMS"
+#define MESH_FILE_VERSION 3
+#define MESH_FILE_EXTENSION ".smesh"
+#define MESH_FILE_SECTION_ALIGNMENT 16
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+enum MeshFileSectionType : uint32_t {
+	MESH_SECTION_VERTICES = 1,
+	MESH_SECTION_INDICES,
+	// 3 held LOD index ranges, but only LOD 0 was ever written. Older files
+	// still have the section, which is skipped like any other unknown one.
+	MESH_SECTION_MESHLETS = 4,
+	MESH_SECTION_MESHLET_VERTICES,
+	MESH_SECTION_MESHLET_TRIANGLES,
+	MESH_SECTION_TERRAIN
+};
+
+/// <summary>
+/// On-disk vertex layout. Matches the engine's Vertex struct
+/// without pulling DirectXMath into tools that write mesh files.
+/// </summary>
+struct MeshFileVertex {
+	float position[3];
+	float normal[3];
+	// w is the bitangent sign
+	float tangent[4];
+	float uv[2];
+};
+
+/// <summary>
+/// Size and last write time (ns since the Unix epoch) of the file a mesh was built from.
+/// A cached mesh is stale when either differs.
+/// </summary>
+struct MeshFileSourceStamp {
+	uint64_t size;
+	int64_t modifiedTime;
+};
+
+struct MeshFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t sectionCount;
+
+	MeshFileSourceStamp source;
+
+	uint32_t vertexCount;
+	uint32_t vertexStride;
+	uint32_t indexCount;
+	uint32_t flags;
+
+	// Oriented bounding box, same layout as DirectX::BoundingOrientedBox
+	float boundsCenter[3];
+	float boundsExtents[3];
+	float boundsOrientation[4];
+	float padding[2];
+};
+
+struct MeshFileSection {
+	uint32_t type;
+	uint32_t elementStride;
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct MeshFileMeshlet {
+	// Into the meshlet vertex section
+	uint32_t vertexOffset;
+	// Into the meshlet triangle section, which holds three local vertex indices per triangle
+	uint32_t triangleOffset;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+};
+
+// Settings a terrain mesh was generated with, so a cooked
+// terrain is only used when they match the requested ones
+struct MeshFileTerrain {
+	uint32_t mapWidth;
+	uint32_t mapHeight;
+	float heightScale;
+	uint32_t padding;
+};
+
+/// <summary>
+/// Everything needed to write a mesh file. Pointers are not owned.
+/// </summary>
+struct MeshFileContents {
+	const void* vertices;
+	uint32_t vertexCount;
+	uint32_t vertexStride;
+	const uint32_t* indices;
+	uint32_t indexCount;
+
+	float boundsCenter[3];
+	float boundsExtents[3];
+	float boundsOrientation[4];
+
+	// Optional, built from the indices if empty
+	std::vector<MeshFileMeshlet> meshlets;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+
+	// Optional, only written for meshes generated from a heightmap
+	std::vector<MeshFileTerrain> terrain;
+};
+
+/// <summary>
+/// Read-only view over a mapped mesh file. Pointers returned point straight
+/// into the mapping and stay valid until the view is closed or destroyed.
+/// </summary>
+class MeshFileView
+{
+public:
+	/// <summary>
+	/// Maps and validates a mesh file
+	/// </summary>
+	/// <param name="path">Path to the .smesh file</param>
+	/// <param name="expectedVertexStride">Rejects the file if its vertex layout doesn't match</param>
+	/// <param name="expectedSource">If given, rejects the file when it was built from a different source</param>
+	/// <returns>False if missing, stale, a different version, or corrupt,
+	/// including any index or meshlet range that lands outside its buffer</returns>
+	bool Open(const std::string& path, uint32_t expectedVertexStride, const MeshFileSourceStamp* expectedSource = nullptr);
+	void Close();
+
+	const MeshFileHeader* GetHeader();
+	const void* GetVertices();
+	const uint32_t* GetIndices();
+	const MeshFileMeshlet* GetMeshlets(uint32_t* count);
+	const uint32_t* GetMeshletVertices(uint32_t* count);
+	const uint8_t* GetMeshletTriangles(uint32_t* count);
+	const MeshFileTerrain* GetTerrain();
+
+private:
+	VirtualFile file;
+	const MeshFileHeader* header = nullptr;
+
+	bool MeshletsValid(uint32_t vertexCount);
+	const MeshFileSection* FindSection(uint32_t type);
+	const void* GetSectionData(uint32_t type, uint32_t* count);
+};
+
+class MeshFile
+{
+public:
+	/// <summary>
+	/// Gets where the cached binary version of a source mesh lives
+	/// </summary>
+	static std::string GetCachePath(const std::string& sourcePath);
+
+	/// <summary>
+	/// Gets the size and modified time of a file
+	/// </summary>
+	/// <returns>False if the file doesn't exist</returns>
+	static bool GetSourceStamp(const std::string& sourcePath, MeshFileSourceStamp* stamp);
+
+	/// <summary>
+	/// Writes a mesh file. Writes to a temporary file first, so a reader
+	/// never maps a half-written mesh.
+	/// </summary>
+	static bool Write(const std::string& path, const MeshFileContents& contents, const MeshFileSourceStamp& source);
+
+	/// <summary>
+	/// Greedily splits a triangle list into meshlets of at most
+	/// MESHLET_MAX_VERTICES unique vertices and MESHLET_MAX_TRIANGLES triangles
+	/// </summary>
+	static void BuildMeshlets(const uint32_t* indices,
+							  uint32_t indexCount,
+							  std::vector<MeshFileMeshlet>* meshlets,
+							  std::vector<uint32_t>* meshletVertices,
+							  std::vector<uint8_t>* meshletTriangles);
+};
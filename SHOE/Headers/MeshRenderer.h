@@ -11,6 +11,8 @@ public:
 		std::shared_ptr<Mesh> mesh,
 		std::shared_ptr<Material> mat
 	);
+	static std::shared_ptr<Mesh> GetDefaultMesh();
+	static std::shared_ptr<Material> GetDefaultMaterial();
 	void OnDestroy() override;
 
 	bool DrawBounds;
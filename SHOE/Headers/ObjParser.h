@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "MeshFile.h"
+
+// Files are split into chunks of about this many bytes, cut at line ends,
+// and each chunk is parsed on its own JobSystem worker
+#define OBJ_PARSE_CHUNK_SIZE (1 << 20)
+
+/// <summary>
+/// Memory mapped .obj reader built for large files. Numbers are tokenized
+/// in place without copying lines, chunks are parsed in parallel, and
+/// corners that share the same position, uv and normal are welded into one
+/// vertex. Supports n-gon faces (fan triangulated) and negative indices.
+/// Only v, vt, vn and f lines are read, everything else is skipped. A face
+/// that's malformed or uses an attribute the file doesn't have fails the
+/// whole parse, with the line it's on.
+/// </summary>
+class ObjParser
+{
+public:
+	/// <summary>
+	/// Parses an .obj file into indexed vertices, converted to
+	/// DirectX's left-handed space. Tangents are left at zero.
+	/// </summary>
+	/// <param name="error">Optional, set to a reason, with the line number for a bad face, when parsing fails</param>
+	/// <returns>False if the file couldn't be opened or has a malformed face</returns>
+	static bool Parse(const std::string& filename, std::vector<MeshFileVertex>* vertices, std::vector<uint32_t>* indices, std::string* error = nullptr);
+
+	/// <summary>
+	/// Parses the in-memory contents of an .obj file. Same as Parse otherwise.
+	/// </summary>
+	static bool ParseText(const char* text, size_t size, std::vector<MeshFileVertex>* vertices, std::vector<uint32_t>* indices, std::string* error = nullptr);
+
+	/// <summary>
+	/// Reads a decimal float, with optional sign, fraction and exponent
+	/// </summary>
+	/// <returns>Pointer past the number, or text if there wasn't one</returns>
+	static const char* ParseFloat(const char* text, const char* end, float* value);
+
+	/// <summary>
+	/// Reads a decimal integer with an optional sign
+	/// </summary>
+	/// <returns>Pointer past the number, or text if there wasn't one</returns>
+	static const char* ParseInt(const char* text, const char* end, int64_t* value);
+};
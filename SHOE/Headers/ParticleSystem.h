@@ -4,6 +4,7 @@
 #include "IComponent.h"
 #include "DXCore.h"
 #include "Vertex.h"
+#include <functional>
 
 #define RandomRange(min, max) (float)rand() / RAND_MAX * (max - min) + min
 #define RandomIntRange(min, max) (int)rand() / RAND_MAX * (max - min) + min
@@ -29,6 +30,13 @@ public:
 
 	void SetParticleTextureSRV(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> particleTextureSRV);
 
+	/// <summary>
+	/// Defers loading the particle texture until the emitter is first drawn.
+	/// The default texture is used until the real one is ready.
+	/// </summary>
+	void SetTextureMaterializer(std::function<void()> materializer);
+	bool IsTextureLoadDeferred();
+
 	void SetColorTint(DirectX::XMFLOAT4 color);
 	DirectX::XMFLOAT4 GetColorTint();
 
@@ -105,6 +113,7 @@ private:
 	bool additiveBlend;
 	bool usesComputeShader;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> particleTextureSRV;
+	std::function<void()> textureMaterializer;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> sortListSRV;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> drawListSRV;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> inBuffer;
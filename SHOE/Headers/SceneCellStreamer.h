@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Cells start loading once the camera is this close to their bounds...
+#define SCENE_STREAMING_DEFAULT_LOAD_DISTANCE 96.0f
+// ...and aren't unloaded until it's this far, so walking along an edge doesn't thrash them
+#define SCENE_STREAMING_DEFAULT_UNLOAD_DISTANCE 128.0f
+// Cell loads in flight at once. More wait their turn, nearest first.
+#define SCENE_STREAMING_LOAD_LIMIT 2
+
+enum SceneCellState {
+	SCENE_CELL_UNLOADED,
+	SCENE_CELL_LOADING,
+	SCENE_CELL_LOADED,
+	SCENE_CELL_UNLOADING
+};
+
+struct SceneCellStatus {
+	float minX = 0;
+	float minZ = 0;
+	float maxX = 0;
+	float maxZ = 0;
+	SceneCellState state = SCENE_CELL_UNLOADED;
+	// Distance from the camera to the cell's bounds at the last update, 0 inside them
+	float distance = 0;
+	// A load failed, so it isn't tried again
+	bool failed = false;
+};
+
+/// <summary>
+/// A cell to load or unload, then hand back with CompleteChange
+/// </summary>
+struct SceneCellChange {
+	uint32_t id = 0;
+	bool unload = false;
+};
+
+struct SceneCellPoint {
+	float x = 0;
+	float z = 0;
+};
+
+struct SceneCellStreamingStats {
+	size_t cellCount = 0;
+	size_t loadedCount = 0;
+	size_t loadingCount = 0;
+	size_t unloadingCount = 0;
+	uint64_t loadCount = 0;
+	uint64_t unloadCount = 0;
+	uint64_t failedCount = 0;
+};
+
+/// <summary>
+/// Decides which cells of a streamed scene should be loaded, from how far
+/// the camera is from each one on the ground plane. It only deals in bounds
+/// and ids, so it doesn't touch entities or files; whoever owns the cells
+/// applies the changes Update hands out and reports back when each is done.
+/// Updates only depend on the camera positions given, so the same path
+/// always streams the same way. Not thread safe, it's meant to be driven
+/// from the main thread.
+/// </summary>
+class SceneCellStreamer
+{
+public:
+	SceneCellStreamer();
+
+	/// <summary>
+	/// Starts tracking a cell, unloaded
+	/// </summary>
+	/// <returns>An id for the cell. Ids count up from 0 in the order cells are added.</returns>
+	uint32_t AddCell(float minX, float minZ, float maxX, float maxZ);
+	void Clear();
+	size_t GetCellCount();
+
+	/// <summary>
+	/// Sets how close the camera has to get for a cell to load, and how far
+	/// away it has to go again for it to unload. Unloading is never closer than loading.
+	/// </summary>
+	void SetDistances(float loadingDistance, float unloadingDistance);
+
+	/// <summary>
+	/// Works out which cells should be loaded for a camera position, then
+	/// hands out unloads first and loads after, nearest first
+	/// </summary>
+	/// <param name="changes">Replaced with the changes to make</param>
+	void Update(float cameraX, float cameraZ, std::vector<SceneCellChange>* changes);
+
+	/// <summary>
+	/// Reports that a change from Update was made, or couldn't be
+	/// </summary>
+	/// <param name="failed">Whether the change failed. A cell that fails to load isn't tried again.</param>
+	void CompleteChange(uint32_t id, bool failed = false);
+
+	/// <summary>
+	/// Marks every cell unloaded, for when their entities were removed all at once
+	/// </summary>
+	void UnloadAll();
+
+	bool GetStatus(uint32_t id, SceneCellStatus* status);
+	SceneCellStreamingStats GetStats();
+
+	/// <summary>
+	/// Runs a camera path through a copy of this streamer, completing every
+	/// change as soon as it's handed out. Leaves this streamer as it was.
+	/// </summary>
+	/// <param name="log">Replaced with the changes handed out at each point of the path</param>
+	void Simulate(const std::vector<SceneCellPoint>& path, std::vector<std::vector<SceneCellChange>>* log);
+
+	/// <summary>
+	/// Distance from a point to a box on the ground plane, 0 inside it
+	/// </summary>
+	static float GetDistance(float x, float z, float minX, float minZ, float maxX, float maxZ);
+
+private:
+	std::vector<SceneCellStatus> cells;
+	float loadDistance;
+	float unloadDistance;
+
+	uint64_t loadCount;
+	uint64_t unloadCount;
+	uint64_t failedCount;
+};
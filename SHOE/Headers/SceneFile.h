@@ -0,0 +1,422 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Binary scene (.sscene). Holds the same data as a JSON scene, but as flat
+// arrays of fixed-size records, one section per kind of asset or component,
+// so loading is a handful of copies instead of a parse and a member search
+// per value. Names and asset references are indices into one string table.
+// Everything is little-endian and every section starts on a 16 byte boundary.
+//
+// Layout: SceneFileHeader, then sectionCount SceneFileSections, then section data.
+//
+// Each section is tagged with a schema id and the size of its records, which
+// is how the format evolves without breaking old files:
+//  - Fields are only ever added to the end of a record, with a default.
+//    Readers copy as much of each record as both sides know about, so old
+//    files load with the defaults and new files load in old builds with the
+//    new fields ignored.
+//  - Sections with an unknown schema are skipped, and so are components
+//    that reference one.
+//  - Schema ids are never reused or renumbered. Anything else bumps SCENE_FILE_VERSION.
+
+#define SCENE_FILE_MAGIC 0x43534853 // "SHSC"
+#define SCENE_FILE_VERSION 1
+#define SCENE_FILE_EXTENSION ".sscene"
+#define SCENE_FILE_SECTION_ALIGNMENT 16
+
+// Stored where an asset index can't be found, like a material without a normal map
+#define SCENE_FILE_NO_INDEX -1
+
+enum SceneFileSchema : uint32_t {
+	SCENE_SCHEMA_STRINGS = 1,
+	SCENE_SCHEMA_STRING_DATA,
+	SCENE_SCHEMA_INDICES,
+	SCENE_SCHEMA_FONTS,
+	SCENE_SCHEMA_SAMPLERS,
+	SCENE_SCHEMA_PIXEL_SHADERS,
+	SCENE_SCHEMA_VERTEX_SHADERS,
+	SCENE_SCHEMA_COMPUTE_SHADERS,
+	SCENE_SCHEMA_TEXTURES,
+	SCENE_SCHEMA_MATERIALS,
+	SCENE_SCHEMA_MESHES,
+	SCENE_SCHEMA_TERRAIN_MATERIALS,
+	SCENE_SCHEMA_SKIES,
+	SCENE_SCHEMA_SOUNDS,
+	SCENE_SCHEMA_ENTITIES,
+	SCENE_SCHEMA_COMPONENTS,
+	SCENE_SCHEMA_CELLS,
+
+	// Component types, independent of ComponentTypes so the engine can reorder those
+	SCENE_SCHEMA_COLLIDER = 100,
+	SCENE_SCHEMA_TERRAIN,
+	SCENE_SCHEMA_PARTICLE_SYSTEM,
+	SCENE_SCHEMA_LIGHT,
+	SCENE_SCHEMA_MESH_RENDERER,
+	SCENE_SCHEMA_CAMERA,
+	SCENE_SCHEMA_NOCLIP_MOVEMENT,
+	SCENE_SCHEMA_FLASHLIGHT_CONTROLLER
+};
+
+enum SceneFileHeaderFlags : uint32_t {
+	// Cleared for files that only hold entities, like the snapshot taken before play
+	SCENE_FILE_FLAG_HAS_ASSETS = 1 << 0
+};
+
+// Shared by every record with a flags field. Each record only uses the ones that apply to it.
+enum SceneFileFlags : uint32_t {
+	SCENE_FLAG_ENABLED = 1 << 0,
+	SCENE_FLAG_TRANSPARENT = 1 << 1,
+	SCENE_FLAG_REFRACTIVE = 1 << 2,
+	SCENE_FLAG_DEPTH_PREPASS = 1 << 3,
+	SCENE_FLAG_BLEND_MAP = 1 << 4,
+	// Sky cube faces stored as six images rather than one file
+	SCENE_FLAG_SEPARATE_SKY_FACES = 1 << 5,
+	SCENE_FLAG_TRIGGER = 1 << 6,
+	SCENE_FLAG_VISIBLE = 1 << 7,
+	SCENE_FLAG_CASTS_SHADOWS = 1 << 8,
+	SCENE_FLAG_MULTI_PARTICLE = 1 << 9,
+	SCENE_FLAG_ADDITIVE_BLEND = 1 << 10,
+	SCENE_FLAG_PERSPECTIVE = 1 << 11,
+	SCENE_FLAG_MAIN_CAMERA = 1 << 12
+};
+
+struct SceneFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t sectionCount;
+
+	uint32_t flags;
+	// Index into the string table
+	uint32_t name;
+	uint32_t padding[2];
+};
+
+struct SceneFileSection {
+	uint32_t schema;
+	uint32_t recordSize;
+	uint64_t offset;
+	uint64_t size;
+};
+
+#pragma region records
+// Strings are indices into the string table, and asset references are
+// indices into the matching asset section, or SCENE_FILE_NO_INDEX.
+
+struct SceneFileString {
+	uint32_t offset = 0;
+	uint32_t length = 0;
+};
+
+struct SceneFileFont {
+	uint32_t name = 0;
+	uint32_t fileNameKey = 0;
+};
+
+struct SceneFileSampler {
+	// D3D11_SAMPLER_DESC, with the defaults D3D11 gives an empty description
+	int32_t addressU = 1;
+	int32_t addressV = 1;
+	int32_t addressW = 1;
+	int32_t comparisonFunction = 1;
+	int32_t filter = 0;
+	uint32_t maxAnisotropy = 1;
+	float minLOD = 0.0f;
+	float maxLOD = 0.0f;
+	float mipLODBias = 0.0f;
+	float borderColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+struct SceneFileShader {
+	uint32_t name = 0;
+	uint32_t filePath = 0;
+};
+
+struct SceneFileTexture {
+	uint32_t name = 0;
+	uint32_t fileNameKey = 0;
+	int32_t assetPathIndex = 0;
+};
+
+struct SceneFileMaterial {
+	uint32_t name = 0;
+	uint32_t flags = 0;
+	float uvTiling = 1.0f;
+	float indexOfRefraction = 0.0f;
+	float refractionScale = 0.0f;
+	float colorTint[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	int32_t vertexShader = SCENE_FILE_NO_INDEX;
+	int32_t pixelShader = SCENE_FILE_NO_INDEX;
+	int32_t refractionPixelShader = SCENE_FILE_NO_INDEX;
+	int32_t albedoMap = SCENE_FILE_NO_INDEX;
+	int32_t normalMap = SCENE_FILE_NO_INDEX;
+	int32_t metalMap = SCENE_FILE_NO_INDEX;
+	int32_t roughnessMap = SCENE_FILE_NO_INDEX;
+	int32_t samplerState = SCENE_FILE_NO_INDEX;
+	int32_t clampSamplerState = SCENE_FILE_NO_INDEX;
+};
+
+struct SceneFileMesh {
+	uint32_t name = 0;
+	uint32_t fileNameKey = 0;
+	uint32_t flags = 0;
+	int32_t indexCount = 0;
+	int32_t materialIndex = 0;
+};
+
+struct SceneFileTerrainMaterial {
+	uint32_t name = 0;
+	uint32_t blendMapPath = 0;
+	uint32_t flags = 0;
+	// Range of material indices in the index section
+	uint32_t firstMaterial = 0;
+	uint32_t materialCount = 0;
+};
+
+struct SceneFileSky {
+	uint32_t name = 0;
+	uint32_t fileNameKey = 0;
+	uint32_t fileExtension = 0;
+	uint32_t flags = 0;
+};
+
+struct SceneFileSound {
+	uint32_t name = 0;
+	uint32_t fileNameKey = 0;
+	uint32_t mode = 0;
+};
+
+struct SceneFileEntity {
+	uint32_t name = 0;
+	uint32_t flags = SCENE_FLAG_ENABLED;
+	float position[3] = { 0.0f, 0.0f, 0.0f };
+	// Pitch, yaw and roll
+	float rotation[3] = { 0.0f, 0.0f, 0.0f };
+	float scale[3] = { 1.0f, 1.0f, 1.0f };
+	// Range of the entity's components in the component section, in the order they were added
+	uint32_t firstComponent = 0;
+	uint32_t componentCount = 0;
+};
+
+/// <summary>
+/// One component of an entity: which component section it's in, and where
+/// </summary>
+struct SceneFileComponent {
+	uint32_t schema = 0;
+	uint32_t index = 0;
+};
+
+struct SceneFileCollider {
+	uint32_t flags = SCENE_FLAG_ENABLED;
+	float positionOffset[3] = { 0.0f, 0.0f, 0.0f };
+	float rotationOffset[3] = { 0.0f, 0.0f, 0.0f };
+	float scale[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+struct SceneFileTerrain {
+	uint32_t flags = SCENE_FLAG_ENABLED;
+	uint32_t fileNameKey = 0;
+	int32_t terrainMaterial = SCENE_FILE_NO_INDEX;
+};
+
+struct SceneFileParticleSystem {
+	uint32_t flags = SCENE_FLAG_ENABLED;
+	uint32_t fileNameKey = 0;
+	int32_t maxParticles = 0;
+	float particlesPerSecond = 0.0f;
+	float particleLifetime = 0.0f;
+	float scale = 1.0f;
+	float speed = 0.0f;
+	float destination[3] = { 0.0f, 0.0f, 0.0f };
+	float colorTint[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+};
+
+struct SceneFileLight {
+	uint32_t flags = SCENE_FLAG_ENABLED;
+	// 0 directional, 1 point, 2 spot, as Light stores it
+	float type = 0.0f;
+	float intensity = 1.0f;
+	float range = 0.0f;
+	float color[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+struct SceneFileMeshRenderer {
+	uint32_t flags = SCENE_FLAG_ENABLED;
+	int32_t mesh = SCENE_FILE_NO_INDEX;
+	int32_t material = SCENE_FILE_NO_INDEX;
+};
+
+struct SceneFileCamera {
+	uint32_t flags = SCENE_FLAG_ENABLED | SCENE_FLAG_PERSPECTIVE;
+	float aspectRatio = 1.0f;
+	float nearDistance = 0.0f;
+	float farDistance = 0.0f;
+	float fieldOfView = 0.0f;
+};
+
+struct SceneFileNoclipMovement {
+	uint32_t flags = SCENE_FLAG_ENABLED;
+	float moveSpeed = 0.0f;
+	float lookSpeed = 0.0f;
+};
+
+struct SceneFileFlashlightController {
+	uint32_t flags = SCENE_FLAG_ENABLED;
+};
+
+/// <summary>
+/// A spatial cell of a streamed scene. The scene's own entities are always
+/// loaded, and each cell's are loaded from their own entity-only file while
+/// the camera is near its bounds.
+/// </summary>
+struct SceneFileCell {
+	float minX = 0.0f;
+	float minZ = 0.0f;
+	float maxX = 0.0f;
+	float maxZ = 0.0f;
+	// The cell's scene file, relative to the scene folder
+	uint32_t path = 0;
+};
+#pragma endregion
+
+/// <summary>
+/// A whole scene in memory, in the layout it's stored in. Both the JSON and
+/// the binary format are read into this and written from it, so converting
+/// between them is a read and a write.
+/// </summary>
+struct SceneFileContents {
+	std::string name;
+	// Entity-only files leave every asset section empty
+	bool hasAssets = true;
+
+	std::vector<std::string> strings;
+	// Shared storage for variable length lists, like a terrain material's materials
+	std::vector<uint32_t> indices;
+
+	std::vector<SceneFileFont> fonts;
+	std::vector<SceneFileSampler> samplers;
+	std::vector<SceneFileShader> pixelShaders;
+	std::vector<SceneFileShader> vertexShaders;
+	std::vector<SceneFileShader> computeShaders;
+	std::vector<SceneFileTexture> textures;
+	std::vector<SceneFileMaterial> materials;
+	std::vector<SceneFileMesh> meshes;
+	std::vector<SceneFileTerrainMaterial> terrainMaterials;
+	std::vector<SceneFileSky> skies;
+	std::vector<SceneFileSound> sounds;
+
+	std::vector<SceneFileEntity> entities;
+	std::vector<SceneFileComponent> components;
+
+	std::vector<SceneFileCollider> colliders;
+	std::vector<SceneFileTerrain> terrains;
+	std::vector<SceneFileParticleSystem> particleSystems;
+	std::vector<SceneFileLight> lights;
+	std::vector<SceneFileMeshRenderer> meshRenderers;
+	std::vector<SceneFileCamera> cameras;
+	std::vector<SceneFileNoclipMovement> noclipMovements;
+	std::vector<SceneFileFlashlightController> flashlightControllers;
+
+	std::vector<SceneFileCell> cells;
+
+	/// <summary>
+	/// Adds a string to the table, or finds it if it's already there
+	/// </summary>
+	/// <returns>The string's index</returns>
+	uint32_t AddString(const std::string& text);
+
+	/// <summary>
+	/// Gets a string from the table
+	/// </summary>
+	/// <returns>Empty for an index outside the table</returns>
+	const std::string& GetString(uint32_t index) const;
+
+	/// <summary>
+	/// Adds a component record to its section and to the entity being built,
+	/// which has to be the last one added
+	/// </summary>
+	/// <returns>The component's record</returns>
+	template <typename T>
+	T& AddComponent(SceneFileSchema schema, std::vector<T>& section);
+
+	/// <summary>
+	/// Adds a copy of another contents' entity and its components.
+	/// Asset indices are copied as they are, so both have to share assets.
+	/// </summary>
+	/// <returns>The new entity's index</returns>
+	uint32_t CopyEntity(const SceneFileContents& source, uint32_t entityIndex);
+
+	/// <summary>
+	/// Removes every entity and component, keeping the assets, strings and cells
+	/// </summary>
+	void ClearEntities();
+	void Clear();
+
+	/// <summary>
+	/// Estimates the heap memory the contents hold, string lookup included
+	/// </summary>
+	/// <returns>Size in bytes</returns>
+	size_t GetMemoryUsage() const;
+
+private:
+	std::unordered_map<std::string, uint32_t> stringIndices;
+};
+
+template <typename T>
+T& SceneFileContents::AddComponent(SceneFileSchema schema, std::vector<T>& section) {
+	SceneFileComponent component;
+	component.schema = schema;
+	component.index = (uint32_t)section.size();
+	components.push_back(component);
+
+	if (!entities.empty()) entities.back().componentCount++;
+
+	section.push_back(T());
+	return section.back();
+}
+
+class SceneFile
+{
+public:
+	/// <summary>
+	/// Reads a scene file that's already in memory
+	/// </summary>
+	/// <returns>False if it isn't a scene file, it's from an incompatible
+	/// version, or anything in it points outside the file</returns>
+	static bool Read(const void* data, size_t size, SceneFileContents* contents);
+
+	/// <summary>
+	/// Writes a scene file. Writes to a temporary file first, so a reader
+	/// never sees a half-written scene.
+	/// </summary>
+	static bool Write(const std::string& path, const SceneFileContents& contents);
+
+	/// <summary>
+	/// Builds a whole scene file in memory
+	/// </summary>
+	static void Encode(const SceneFileContents& contents, std::vector<unsigned char>* output);
+
+	/// <summary>
+	/// Checks that every string, asset, index and component reference lands
+	/// inside its table, so nothing loading the contents can index out of range
+	/// </summary>
+	static bool Validate(const SceneFileContents& contents);
+
+	/// <summary>
+	/// Checks that the asset references of one contents' entities land inside
+	/// another's asset tables, like an entity-only file's against the scene it's loaded into
+	/// </summary>
+	static bool ValidateAssetReferences(const SceneFileContents& entities, const SceneFileContents& assets);
+
+	/// <summary>
+	/// Checks whether two components hold the same state. They can come from
+	/// different contents, since file names are compared by their text.
+	/// </summary>
+	static bool ComponentsEqual(const SceneFileContents& contentsA, const SceneFileComponent& componentA,
+		const SceneFileContents& contentsB, const SceneFileComponent& componentB);
+};
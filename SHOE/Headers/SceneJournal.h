@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SceneFile.h"
+
+// Scene journal (.sjournal). Kept next to a scene file, and holds the entity
+// edits made since that file was written, so saving an edit only costs as
+// much as the edit. Loading the scene replays the journal on top of it, and
+// writing the scene file again starts a new, empty journal.
+//
+// Layout: SceneJournalHeader, then records back to back, each a
+// SceneJournalRecord followed by its payload. Records are only ever appended.
+// A record whose payload runs past the end of the file or whose checksum is
+// wrong is where a crash cut the journal short, so replay stops there and
+// everything before it is kept.
+//
+// Entities are referred to by slot. The scene file's entities are slots 0 to
+// n - 1 in the order they're stored, and entities added since count on from
+// there. Slots aren't reused once their entity is removed.
+
+#define SCENE_JOURNAL_MAGIC 0x4A534853 // "SHSJ"
+#define SCENE_JOURNAL_VERSION 1
+#define SCENE_JOURNAL_EXTENSION ".sjournal"
+
+enum SceneJournalRecordType : uint32_t {
+	// Payload is an entity-only scene file holding just the entity, which
+	// replaces whatever the slot held before or adds it
+	SCENE_JOURNAL_SET_ENTITY = 1,
+	// Payload is a SceneJournalTransform, for when nothing else changed
+	SCENE_JOURNAL_SET_TRANSFORM,
+	// No payload
+	SCENE_JOURNAL_REMOVE_ENTITY
+};
+
+struct SceneJournalHeader {
+	uint32_t magic;
+	uint32_t version;
+	// The scene file the journal applies to. If it's been written
+	// since, these won't match and the journal is ignored.
+	uint64_t baseHash;
+	uint64_t baseSize;
+};
+
+struct SceneJournalRecord {
+	uint32_t type;
+	uint32_t slot;
+	// Bytes of payload after this record
+	uint32_t size;
+	uint32_t padding;
+	// Of everything above and the payload
+	uint64_t checksum;
+};
+
+struct SceneJournalTransform {
+	float position[3];
+	float rotation[3];
+	float scale[3];
+};
+
+/// <summary>
+/// Where a scene's entities stand relative to its journal
+/// </summary>
+struct SceneJournalState {
+	// The scene file the journal applies to
+	uint64_t baseHash = 0;
+	uint64_t baseSize = 0;
+	// The slot of each of the scene's entities, in order
+	std::vector<uint32_t> slots;
+	// Slots handed out so far, including ones whose entity was removed
+	uint32_t slotCount = 0;
+	// Bytes of the journal file that were replayed, 0 if there isn't one. If
+	// the file's longer, the rest is a cut off record that has to be dropped
+	// before appending, or nothing appended after it would ever be replayed.
+	uint64_t journalSize = 0;
+	// Records replayed from the journal file
+	size_t replayedCount = 0;
+};
+
+class SceneJournal
+{
+public:
+	static uint64_t Hash(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+	/// <summary>
+	/// Gives every entity of a freshly written scene file its own slot
+	/// </summary>
+	static void Reset(const SceneFileContents& contents, uint64_t baseHash, uint64_t baseSize, SceneJournalState* state);
+
+	/// <summary>
+	/// Replays a journal on top of the contents of its scene file. Does
+	/// nothing to the contents if the journal is for a different file, or
+	/// holds an entity using an asset the scene doesn't have.
+	/// </summary>
+	/// <param name="state">Has to hold the scene file's hash and size. Gets
+	/// the slot of each entity, whether or not the journal was replayed.</param>
+	/// <returns>False if the journal wasn't replayed</returns>
+	static bool Apply(const void* data, size_t size, SceneFileContents* contents, SceneJournalState* state);
+
+	/// <summary>
+	/// Adds a record of an entity's whole state
+	/// </summary>
+	static void AddEntity(const SceneFileContents& contents, uint32_t entityIndex, uint32_t slot, std::vector<unsigned char>* records);
+
+	/// <summary>
+	/// Adds a record of whatever changed between two states of an entity, as
+	/// just its transform if nothing else did. They can come from different contents.
+	/// </summary>
+	/// <returns>False if nothing changed, so nothing was added</returns>
+	static bool AddEntityChanges(const SceneFileContents& before, uint32_t beforeIndex,
+		const SceneFileContents& after, uint32_t afterIndex, uint32_t slot, std::vector<unsigned char>* records);
+
+	static void AddRemoval(uint32_t slot, std::vector<unsigned char>* records);
+
+	/// <summary>
+	/// Starts an empty journal for a scene file, replacing any old one
+	/// </summary>
+	static bool Create(const std::string& path, uint64_t baseHash, uint64_t baseSize);
+
+	/// <summary>
+	/// Adds records to the end of a journal and flushes them
+	/// </summary>
+	static bool Append(const std::string& path, const std::vector<unsigned char>& records);
+
+private:
+	static void AddRecord(SceneJournalRecordType type, uint32_t slot, const void* payload, size_t size, std::vector<unsigned char>* records);
+};
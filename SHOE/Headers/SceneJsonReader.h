@@ -0,0 +1,141 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "rapidjson\reader.h"
+#include "SceneFile.h"
+
+// Every asset category a full JSON scene has, one bit each
+#define SCENE_JSON_ALL_ASSET_CATEGORIES 0x7FF
+
+/// <summary>
+/// One JSON object's members, flattened. Holds a single asset, entity or
+/// component at a time, so reading never keeps more than one object of
+/// JSON in memory.
+/// </summary>
+struct SceneJsonObject {
+	struct Member {
+		std::string key;
+		bool isNull = false;
+		bool isNumber = false;
+		bool boolean = false;
+		double number = 0.0;
+		std::string text;
+		// Filled for array members, like positions and material lists
+		std::vector<double> numbers;
+	};
+
+	std::vector<Member> members;
+	size_t memberCount = 0;
+
+	void Clear();
+	Member& Add(const char* key, rapidjson::SizeType length);
+
+	/// <returns>The member, or null if the object doesn't have it</returns>
+	const Member* Find(const char* key) const;
+};
+
+/// <summary>
+/// Reads a JSON scene as a stream of parse events rather than a document.
+/// Each asset, entity and component becomes a scene file record as soon as
+/// its object closes, and each entity is handed to a listener as soon as
+/// everything it could reference has been read.
+/// </summary>
+class SceneJsonReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, SceneJsonReader>
+{
+public:
+	/// <summary>
+	/// Called with each entity once it and every asset are read
+	/// </summary>
+	typedef std::function<bool(const SceneFileContents& contents, uint32_t entityIndex)> EntityListener;
+
+	/// <summary>
+	/// Called once every asset is read, before any entity listener call.
+	/// Return false from either listener to stop reading.
+	/// </summary>
+	typedef std::function<bool(const SceneFileContents& contents)> AssetListener;
+
+	SceneJsonReader(SceneFileContents* contents, AssetListener assetListener = {}, EntityListener entityListener = {});
+
+	/// <summary>
+	/// Reads a whole scene, calling the listeners as it goes
+	/// </summary>
+	/// <returns>False if it isn't a valid SHOE scene, or a listener stopped it</returns>
+	bool Read(const char* data, size_t size);
+
+	/// <summary>
+	/// Gets the first entity's time to reach its listener, in seconds
+	/// from the start of Read, or a negative number if none did
+	/// </summary>
+	double GetFirstEntityTime();
+
+	// Parse events
+	bool Null();
+	bool Bool(bool b);
+	bool Int(int i);
+	bool Uint(unsigned u);
+	bool Int64(int64_t i);
+	bool Uint64(uint64_t u);
+	bool Double(double d);
+	bool String(const char* str, rapidjson::SizeType length, bool copy);
+	bool StartObject();
+	bool Key(const char* str, rapidjson::SizeType length, bool copy);
+	bool EndObject(rapidjson::SizeType memberCount);
+	bool StartArray();
+	bool EndArray(rapidjson::SizeType elementCount);
+
+private:
+	enum Frame {
+		FRAME_ROOT,
+		FRAME_CATEGORY,
+		FRAME_RECORD,
+		FRAME_COMPONENTS,
+		FRAME_COMPONENT,
+		FRAME_VALUE_ARRAY,
+		// Anything this reader doesn't understand, skipped until it closes
+		FRAME_SKIP
+	};
+
+	SceneFileContents* contents;
+	AssetListener assetListener;
+	EntityListener entityListener;
+
+	std::vector<Frame> frames;
+	std::string key;
+	// The root array being read, as its bit in assetCategories
+	uint32_t categoryBit;
+	bool readingEntities;
+
+	SceneJsonObject record;
+	SceneJsonObject component;
+	SceneJsonObject::Member* arrayMember;
+
+	bool validScene;
+	bool assetsReady;
+	uint32_t assetCategories;
+	// Entities read before every asset was, passed on once they all are
+	std::vector<uint32_t> pendingEntities;
+
+	double startTime;
+	double firstEntityTime;
+
+	SceneJsonObject* GetCurrentObject();
+	bool AddValue(bool isNull, bool boolean, double number, const char* text, rapidjson::SizeType length);
+
+	bool EndRecord();
+	void EndComponent();
+	bool EndEntity();
+	bool FinishAssets();
+	bool PassEntity(uint32_t entityIndex);
+
+	uint32_t GetCategoryBit(const std::string& categoryKey);
+	double GetTime();
+
+	// Member reading, with the defaults scene file records use when a member is missing
+	uint32_t ReadString(const SceneJsonObject& object, const char* memberName, const char* defaultText = "");
+	int32_t ReadIndex(const SceneJsonObject& object, const char* memberName);
+	uint32_t ReadFlag(const SceneJsonObject& object, const char* memberName, uint32_t flag);
+	double ReadNumber(const SceneJsonObject& object, const char* memberName, double defaultNumber);
+	void ReadFloats(const SceneJsonObject& object, const char* memberName, float* values, int count);
+};
@@ -1,13 +1,25 @@
 #pragma once
 
 #include <string>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <unordered_set>
+#include <unordered_map>
 #include <DirectXMath.h>
 #include "rapidjson\document.h"
 #include "rapidjson\filereadstream.h"
-#include "rapidjson\filewritestream.h"
+#include "rapidjson\memorystream.h"
 #include "rapidjson\writer.h"
+#include "rapidjson\stringbuffer.h"
 #include "AssetManager.h"
 #include "EngineState.h"
+#include "SceneFile.h"
+#include "SceneJsonReader.h"
+#include "SceneCellStreamer.h"
+#include "SceneJournal.h"
 
 #pragma region saveLoadIdentifiers
 // Saving and loading shorthand identifiers
@@ -141,7 +153,89 @@
 
 #pragma endregion
 
-#define FILE_BUFFER_SIZE 65536
+// Streamed cell entities created or removed each frame, so a big cell is spread over several
+#define SCENE_STREAMING_ENTITY_LIMIT 64
+
+// Seconds between the editor journaling scene edits
+#define SCENE_JOURNAL_INTERVAL 5.0f
+// A journal is folded into its scene file once it's bigger than the file, or than this
+#define SCENE_JOURNAL_COMPACT_SIZE (256 * 1024)
+
+/// <summary>
+/// Compares reading a JSON scene into a document against streaming it,
+/// on this thread and on a worker like LoadScene does. Times are in
+/// seconds, and memory is what each way holds on to while reading.
+/// </summary>
+struct SceneLoadBenchmark {
+	bool succeeded = false;
+
+	double documentTime = 0.0;
+	double documentFirstEntityTime = 0.0;
+	size_t documentMemory = 0;
+
+	double streamTime = 0.0;
+	double streamFirstEntityTime = 0.0;
+	size_t streamMemory = 0;
+
+	// Streamed on a worker as LoadScene does it, with the first entity
+	// timed to when it's handed over to the main thread
+	double workerTime = 0.0;
+	double workerFirstEntityTime = 0.0;
+};
+
+/// <summary>
+/// How a background scene save went. Times are in seconds.
+/// </summary>
+struct SceneSaveResult {
+	std::string path;
+	bool succeeded = false;
+	// A newer save of the same file was asked for before this one started, so it was skipped
+	bool superseded = false;
+
+	// Recording the scene on the main thread, which is all the save holds the editor up for
+	double captureTime = 0.0;
+	// Serializing and writing it in the background
+	double writeTime = 0.0;
+
+	// Of the file that was written
+	uint64_t fileHash = 0;
+	uint64_t fileSize = 0;
+};
+
+typedef std::function<void(const SceneSaveResult& result)> SceneSaveCallback;
+
+/// <summary>
+/// How a background scene switch went. Times are in seconds.
+/// </summary>
+struct SceneSwitchResult {
+	std::string path;
+	bool succeeded = false;
+	// Another switch or load was started before this one was swapped in
+	bool cancelled = false;
+
+	// Reading and decoding the scene in the background, while the old one kept running
+	double preparationTime = 0.0;
+	// Swapping it in, the only part that holds up a frame
+	double swapTime = 0.0;
+
+	// Asset files the new scene had in common with the old one, so were never read
+	size_t sharedAssetCount = 0;
+	// Meshes, textures, skies and sounds of the old scene the new one didn't use
+	size_t releasedAssetCount = 0;
+};
+
+typedef std::function<void(const SceneSwitchResult& result)> SceneSwitchCallback;
+
+/// <summary>
+/// Refers to an entity in a streamed cell. Unlike a pointer to the entity it
+/// stays valid while the cell unloads and loads again, so it can be kept
+/// anywhere, including by entities in other cells.
+/// </summary>
+struct SceneEntityHandle {
+	uint32_t cell = 0;
+	// The entity's index in the cell's file
+	uint32_t entity = 0;
+};
 
 class SceneManager
 {
@@ -181,29 +275,212 @@ private:
 	std::string currentLoadName;
 	std::exception_ptr error;
 
-	DirectX::XMFLOAT2 LoadFloat2(const rapidjson::Value& jsonBlock, const char* memberName);
-	DirectX::XMFLOAT3 LoadFloat3(const rapidjson::Value& jsonBlock, const char* memberName);
-	DirectX::XMFLOAT4 LoadFloat4(const rapidjson::Value& jsonBlock, const char* memberName);
-	void SaveFloat2(rapidjson::Value& jsonObject, const char* memberName, DirectX::XMFLOAT2 vec, rapidjson::Document& sceneDoc);
-	void SaveFloat3(rapidjson::Value& jsonObject, const char* memberName, DirectX::XMFLOAT3 vec, rapidjson::Document& sceneDoc);
-	void SaveFloat4(rapidjson::Value& jsonObject, const char* memberName, DirectX::XMFLOAT4 vec, rapidjson::Document& sceneDoc);
+	// Entities as they were just before play, restored when play stops.
+	// Each entity and component record is matched with the object it was
+	// recorded from, so restoring only has to touch what play changed.
+	SceneFileContents playSnapshot;
+	std::vector<std::shared_ptr<GameEntity>> playSnapshotEntities;
+	std::vector<std::shared_ptr<IComponent>> playSnapshotComponents;
+
+	// A cell of the loaded scene, and whatever of it has been streamed in
+	struct StreamedCell {
+		SceneFileCell bounds;
+		std::string path;
+		// Set once the cell's file has been read, until all its entities are made
+		std::shared_ptr<SceneFileContents> contents;
+		// In the same order as the cell file's entities
+		std::vector<std::shared_ptr<GameEntity>> entities;
+	};
 
-	std::string LoadDeserializedFileName(const rapidjson::Value& jsonBlock, const char* memberName);
+	// Cells of the loaded scene. Its own entities are the persistent layer, always loaded.
+	SceneCellStreamer cellStreamer;
+	std::vector<StreamedCell> streamedCells;
+	// Bumped whenever the cells are reset, so reads started before are dropped when they finish
+	uint32_t streamingGeneration = 0;
+
+	// Where each asset entity records can refer to is in its list, so
+	// recording a component is a lookup rather than a search of the list
+	struct SceneAssetIndices {
+		std::unordered_map<const void*, int32_t> meshes;
+		std::unordered_map<const void*, int32_t> materials;
+		std::unordered_map<const void*, int32_t> terrainMaterials;
+	};
 
-	void LoadAssets(const rapidjson::Value& sceneDoc, std::function<void()> progressListener = {});
-	void LoadEntities(const rapidjson::Value& sceneDoc, std::function<void()> progressListener = {});
+	// The assets entity records can refer to, in list order. Held weakly,
+	// so an asset that's unloaded no longer matches what replaced it.
+	struct JournalAssets {
+		std::vector<std::weak_ptr<Mesh>> meshes;
+		std::vector<std::weak_ptr<Material>> materials;
+		std::vector<std::weak_ptr<TerrainMaterial>> terrainMaterials;
+	};
 
-	void SaveAssets(rapidjson::Document& sceneDocToSave);
-	void SaveEntities(rapidjson::Document& sceneDocToSave);
+	// A recorded scene waiting to be written, or being written
+	struct SceneSave {
+		uint64_t id = 0;
+		std::string filepath;
+		std::string namePath;
+		std::shared_ptr<const SceneFileContents> contents;
+		// The entity each entity record was made from, for journaling on top of the file
+		std::vector<std::shared_ptr<GameEntity>> entities;
+		JournalAssets assets;
+		SceneSaveCallback callback;
+		double captureTime = 0.0;
+		// The scene the save was recorded from, see sceneGeneration
+		uint64_t sceneGeneration = 0;
+	};
+
+	// Saves are written one at a time, in the order they were asked for,
+	// so two never write the same file at once or finish out of order
+	SceneSave activeSave;
+	std::future<SceneSaveResult> activeSaveResult;
+	std::deque<SceneSave> queuedSaves;
+	uint64_t nextSaveId = 1;
+	SceneSaveResult lastSaveResult;
+
+	// An entity as it was last journaled: the record it was journaled as, and its slot
+	struct JournaledEntity {
+		std::shared_ptr<GameEntity> entity;
+		std::shared_ptr<const SceneFileContents> contents;
+		uint32_t index = 0;
+		uint32_t slot = 0;
+	};
+
+	// The scene file edits are journaled next to, and the entities as they
+	// were last journaled
+	std::string journalSceneFile;
+	SceneJournalState journal;
+	std::unordered_map<GameEntity*, JournaledEntity> journaledEntities;
+	// Entities the editor changed since they were last journaled. The rest are only journaled if they're added or removed.
+	std::unordered_set<GameEntity*> editedEntities;
+	// Journals only hold entities, so the assets they can reference have to stay put
+	JournalAssets journaledAssets;
+	// Set when the journal can't follow the scene any more, so the next journal is a full save
+	bool journalNeedsCompaction = false;
+	// A journal was asked for while the scene file was being written
+	bool journalPending = false;
+
+	// Bumped whenever a scene replaces the last, so saves recorded from the old one don't touch the new one's journal
+	uint64_t sceneGeneration = 0;
+
+	// A scene being read and decoded in the background, to be swapped in once it's ready
+	struct SceneSwitch {
+		std::string filepath;
+		std::string namePath;
+		SceneFileContents contents;
+		SceneJournalState journal;
+		std::shared_ptr<ScenePreload> preload = std::make_shared<ScenePreload>();
+		SceneSwitchCallback callback;
+		double startTime = 0.0;
+		size_t sharedAssetCount = 0;
+		// Everything's decoded, and it's waiting on UpdateSceneSwitch
+		bool ready = false;
+	};
+
+	std::shared_ptr<SceneSwitch> activeSwitch;
+	SceneSwitchResult lastSwitchResult;
+
+	// A JSON scene being read on a JobSystem worker. Each record is handed
+	// over as soon as it's read, so the main thread makes entities while the
+	// rest of the file is still being parsed.
+	struct JsonSceneRead {
+		std::vector<char> data;
+		std::mutex recordMutex;
+		std::condition_variable recordsReady;
+		// Every asset, set once they're all read and before any entity is
+		std::shared_ptr<SceneFileContents> assets;
+		// Each entity in contents of its own, in the order they were read
+		std::deque<std::shared_ptr<SceneFileContents>> entities;
+		bool finished = false;
+		bool succeeded = false;
+		// Set by the main thread to stop reading at the next record
+		std::atomic<bool> cancelled{ false };
+		// Everything read, only to be used once finished
+		SceneFileContents contents;
+		std::future<void> result;
+	};
+
+	std::shared_ptr<JsonSceneRead> StartJsonRead(std::vector<char> data);
+	bool TakeJsonRecords(JsonSceneRead& read, std::shared_ptr<SceneFileContents>* assets, std::deque<std::shared_ptr<SceneFileContents>>* entities);
+
+	void SaveFloats(rapidjson::Value& jsonObject, const char* memberName, const float* values, int count, rapidjson::Document& sceneDoc);
+	void SaveStringIndex(rapidjson::Value& jsonObject, const char* memberName, uint32_t index, const SceneFileContents& contents, rapidjson::Document& sceneDoc);
+	void SaveIndex(rapidjson::Value& jsonObject, const char* memberName, int32_t index, rapidjson::Document& sceneDoc);
+	void SaveFlag(rapidjson::Value& jsonObject, const char* memberName, uint32_t flags, uint32_t flag, rapidjson::Document& sceneDoc);
+
+	std::string LoadDeserializedFileName(const SceneFileContents& contents, uint32_t index);
+
+	// Both scene formats are read into and written from SceneFileContents,
+	// so creating a scene only has to understand one of them. JSON is read
+	// with SceneJsonReader, so no document of the whole scene is ever built.
+	void WriteJsonAssets(const SceneFileContents& contents, rapidjson::Document& sceneDoc);
+	void WriteJsonEntities(const SceneFileContents& contents, rapidjson::Document& sceneDoc);
+
+	bool IsBinaryScene(const std::string& filepath);
+	bool ReadSceneFile(std::string namePath, SceneFileContents& contents, SceneJournalState* journalState = nullptr);
+	bool WriteSceneFile(std::string namePath, const SceneFileContents& contents, uint64_t* fileHash = nullptr, uint64_t* fileSize = nullptr);
+
+	void StartNextSave();
+	void FinishSave(uint64_t id);
+
+	void StartJournal(std::string filepath, const SceneJournalState& state);
+	void StopJournal();
+	void SetJournaledEntities(std::shared_ptr<const SceneFileContents> contents, const std::vector<std::shared_ptr<GameEntity>>& entities);
+	JournalAssets CaptureJournalAssets();
+	bool JournalAssetsMatch(const JournalAssets& assets);
+
+	void LoadAssets(const SceneFileContents& contents, std::function<void()> progressListener = {});
+	void LoadEntities(const SceneFileContents& contents, std::function<void()> progressListener = {});
+	std::shared_ptr<GameEntity> LoadEntity(const SceneFileContents& contents, const SceneFileEntity& entity);
+	void LoadComponent(const SceneFileContents& contents, std::shared_ptr<GameEntity> entity, const SceneFileComponent& component);
+
+	void CaptureAssets(SceneFileContents& contents);
+	void CaptureEntities(SceneFileContents& contents, std::vector<std::shared_ptr<GameEntity>>* capturedEntities = nullptr);
+	SceneAssetIndices MapAssetIndices(const SceneFileContents& contents);
+	void CaptureEntity(SceneFileContents& contents, std::shared_ptr<GameEntity> ge, const SceneAssetIndices& assetIndices, std::vector<std::shared_ptr<IComponent>>* capturedComponents = nullptr);
+
+	void CapturePlaySnapshot();
+	IndexedAssetCounts CountIndexedAssets();
+	void RestoreEntity(uint32_t snapshotIndex, SceneFileContents& current, const SceneAssetIndices& assetIndices);
+
+	void BuildScenePreload(const SceneFileContents& contents, ScenePreload* preload);
+	void DecodeSceneSwitch(std::shared_ptr<SceneSwitch> sceneSwitch, bool succeeded);
+	void FinishSceneSwitch(bool succeeded);
+	void CancelSceneSwitch();
+
+	void StartStreaming(const SceneFileContents& contents);
+	void ResetStreaming(bool keepCells);
+	void ReadStreamedCell(uint32_t id);
+	void RemoveStreamedEntity(std::shared_ptr<GameEntity> entity);
+	std::unordered_set<GameEntity*> GetStreamedEntities();
 public:
+	~SceneManager();
+
 	void Initialize(EngineState* engineState);
 
 	void LoadScene(std::string filepath, std::function<void()> progressListener = {});
-	void SaveScene(std::string filepath, std::string sceneName = "");
+	bool SwitchScene(std::string filepath, SceneSwitchCallback completionListener = {});
+	void UpdateSceneSwitch();
+	bool IsSwitchingScene();
+	SceneSwitchResult GetLastSwitchResult();
+	void SaveScene(std::string filepath, std::string sceneName = "", SceneSaveCallback completionListener = {});
+	bool JournalScene();
+	void MarkEntityEdited(std::shared_ptr<GameEntity> entity);
+	bool IsSaving();
+	void WaitForSaves();
+	SceneSaveResult GetLastSaveResult();
 
 	void PrePlaySave();
 	void PostPlayLoad();
 
+	bool ConvertScene(std::string sourcePath, std::string destinationPath);
+	bool PartitionScene(std::string sourcePath, std::string destinationPath, float cellSize);
+	SceneLoadBenchmark BenchmarkJsonLoad(std::string filepath);
+
+	void UpdateSceneStreaming(std::shared_ptr<Camera> camera);
+	std::shared_ptr<GameEntity> FindStreamedEntity(SceneEntityHandle handle);
+	bool IsStreamedEntity(std::shared_ptr<GameEntity> entity);
+	SceneCellStreamingStats GetSceneStreamingStats();
+
 	// Loading helper methods for other classes
 	std::string GetLoadingSceneName();
 	std::string GetCurrentSceneName();
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "MappedFile.h"
+
+// Cached shader reflection (.sref). Holds everything SimpleShader reads
+// through D3DReflect: constant buffer layouts and their variables, texture,
+// sampler and UAV slots, a vertex shader's input signature and a compute
+// shader's thread group size. Files are named by the hash of the compiled
+// shader they describe, which is checked again on read along with the
+// bytecode's size and a checksum of the thread group size and everything
+// after the header.
+//
+// Layout: ShaderReflectionFileHeader, then the payload:
+//   bufferCount ShaderReflectionFileBuffer
+//   variableCount ShaderReflectionFileVariable, each buffer's variables together, in buffer order
+//   textureCount ShaderReflectionFileResource
+//   samplerCount ShaderReflectionFileResource
+//   uavCount ShaderReflectionFileResource
+//   inputCount ShaderReflectionFileInput
+//   stringsSize bytes of names, referenced by offset and length and not null terminated
+
+#define SHADER_REFLECTION_FILE_MAGIC 0x52534853 // "SHSR"
+#define SHADER_REFLECTION_FILE_VERSION 1
+#define SHADER_REFLECTION_FILE_EXTENSION ".sref"
+#define SHADER_REFLECTION_FOLDER "ReflectionCache\\"
+
+struct ShaderReflectionFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t bufferCount;
+
+	uint32_t variableCount;
+	uint32_t textureCount;
+	uint32_t samplerCount;
+	uint32_t uavCount;
+
+	uint32_t inputCount;
+	uint32_t stringsSize;
+	uint32_t threadGroupSize[3];
+	uint32_t padding;
+	uint64_t bytecodeSize;
+
+	uint64_t bytecodeHash;
+	uint64_t payloadSize;
+	uint64_t payloadChecksum;
+};
+
+struct ShaderReflectionFileBuffer {
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t type;
+	uint32_t bindIndex;
+	uint32_t size;
+	uint32_t firstVariable;
+	uint32_t variableCount;
+	uint32_t padding;
+};
+
+struct ShaderReflectionFileVariable {
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t byteOffset;
+	uint32_t size;
+};
+
+struct ShaderReflectionFileResource {
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t bindIndex;
+	uint32_t padding;
+};
+
+struct ShaderReflectionFileInput {
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t semanticIndex;
+	uint32_t mask;
+	uint32_t componentType;
+	uint32_t padding;
+};
+
+struct ShaderReflectionVariable {
+	std::string name;
+	uint32_t byteOffset = 0;
+	uint32_t size = 0;
+};
+
+struct ShaderReflectionBuffer {
+	std::string name;
+	// D3D_CBUFFER_TYPE
+	uint32_t type = 0;
+	uint32_t bindIndex = 0;
+	uint32_t size = 0;
+	std::vector<ShaderReflectionVariable> variables;
+};
+
+struct ShaderReflectionResource {
+	std::string name;
+	uint32_t bindIndex = 0;
+};
+
+struct ShaderReflectionInput {
+	std::string semanticName;
+	uint32_t semanticIndex = 0;
+	// Which of xyzw are used, one bit each
+	uint32_t mask = 0;
+	// D3D_REGISTER_COMPONENT_TYPE
+	uint32_t componentType = 0;
+};
+
+/// <summary>
+/// What a compiled shader exposes, in the order D3DReflect lists it.
+/// Textures include structured buffers, which SimpleShader binds the same way.
+/// </summary>
+struct ShaderReflection {
+	std::vector<ShaderReflectionBuffer> constantBuffers;
+	std::vector<ShaderReflectionResource> textures;
+	std::vector<ShaderReflectionResource> samplers;
+	// Only filled for compute shaders
+	std::vector<ShaderReflectionResource> unorderedAccessViews;
+	uint32_t threadGroupSize[3] = { 0, 0, 0 };
+	// Only filled for vertex shaders
+	std::vector<ShaderReflectionInput> inputs;
+};
+
+struct ShaderReflectionCacheStats {
+	uint64_t hitCount = 0;
+	uint64_t missCount = 0;
+	// Files that were there but failed validation, also counted as misses
+	uint64_t corruptCount = 0;
+	uint64_t writeCount = 0;
+	uint64_t failedWriteCount = 0;
+};
+
+/// <summary>
+/// Reads and writes cached shader reflection. Nothing here touches Direct3D,
+/// so the format can be written and checked anywhere.
+/// </summary>
+class ShaderReflectionFile
+{
+public:
+	/// <summary>
+	/// Hash of a compiled shader, which names its cache file
+	/// </summary>
+	static uint64_t HashBytecode(const void* bytecode, size_t size);
+
+	/// <summary>
+	/// Gets the file a shader's reflection is cached in
+	/// </summary>
+	/// <param name="cacheFolder">Folder holding the cache files, ending in a separator</param>
+	static std::string GetCachePath(const std::string& cacheFolder, uint64_t bytecodeHash);
+
+	/// <summary>
+	/// Gets the bytecode hash a cache file is named by
+	/// </summary>
+	/// <returns>False if the name isn't one GetCachePath makes</returns>
+	static bool ParseCachePath(const std::string& path, uint64_t* bytecodeHash);
+
+	/// <summary>
+	/// Loads a shader's cached reflection. Deletes the file if it's damaged,
+	/// so the next write replaces it.
+	/// </summary>
+	/// <returns>False on a miss</returns>
+	static bool Read(const std::string& path, uint64_t bytecodeHash, uint64_t bytecodeSize, ShaderReflection* reflection);
+
+	/// <summary>
+	/// Writes a shader's reflection, creating the cache folder if needed
+	/// </summary>
+	static bool Write(const std::string& path, uint64_t bytecodeHash, uint64_t bytecodeSize, const ShaderReflection& reflection);
+
+	/// <summary>
+	/// Checks a whole cache file in memory, header and payload
+	/// </summary>
+	/// <param name="reflection">Filled if it's valid, or null to only check it</param>
+	static bool Decode(const unsigned char* data, size_t size, uint64_t bytecodeHash, uint64_t bytecodeSize, ShaderReflection* reflection);
+
+	/// <summary>
+	/// Builds a whole cache file in memory
+	/// </summary>
+	/// <returns>False if the reflection has more than the format can hold</returns>
+	static bool Encode(uint64_t bytecodeHash, uint64_t bytecodeSize, const ShaderReflection& reflection, std::vector<unsigned char>* output);
+
+	static ShaderReflectionCacheStats GetStats();
+
+private:
+	static std::atomic<uint64_t> hitCount;
+	static std::atomic<uint64_t> missCount;
+	static std::atomic<uint64_t> corruptCount;
+	static std::atomic<uint64_t> writeCount;
+	static std::atomic<uint64_t> failedWriteCount;
+
+	static uint64_t Checksum(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ull);
+	static uint64_t GetPayloadChecksum(const ShaderReflectionFileHeader& header, const unsigned char* payload);
+};
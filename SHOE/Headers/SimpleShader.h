@@ -12,6 +12,8 @@
 #include <string>
 #include <memory>
 
+#include "ShaderReflectionFile.h"
+
 
 // --------------------------------------------------------
 // Used by simple shaders to store information about
@@ -70,6 +72,10 @@ public:
 	// Simple helpers
 	bool IsShaderValid() { return shaderValid; }
 
+	// Loads the compiled shader again, like after it's rebuilt. Variables,
+	// buffers and resources are reflected again, and have to be set again.
+	bool ReloadShaderFile(std::string shaderFile);
+
 	// Activating the shader and copying data
 	void SetShader();
 	void CopyAllBufferData();
@@ -127,6 +133,10 @@ public:
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Folder reflection is cached in, ending in a separator. Empty to
+	// reflect every shader as it loads.
+	static std::string ReflectionCacheFolder;
+
 	static inline HRESULT ConvertToWide(const std::string& as, OUT std::wstring& cs);
 
 protected:
@@ -150,8 +160,12 @@ protected:
 	std::unordered_map<std::string, SimpleSRV*> textureTable;
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
+	// What the loaded shader exposes, from the cache or reflection
+	ShaderReflection reflection;
+
 	// Initialization method
 	bool LoadShaderFile(std::string shaderFile);
+	bool ReflectShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob, ShaderReflection* reflection);
 
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
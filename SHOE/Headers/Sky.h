@@ -4,8 +4,20 @@
 #include "SimpleShader.h"
 #include "DDSTextureLoader.h"
 #include "Camera.h"
+#include "IBLBaker.h"
+#include "IBLCacheFile.h"
 #include <map>
 #include <memory>
+#include <future>
+
+/// <summary>
+/// How far a sky's CPU baked IBL maps are from what the shaders render
+/// </summary>
+struct SkyIBLComparison {
+	IBLError irradiance;
+	IBLError specular;
+	IBLError brdfLookup;
+};
 
 class Sky
 {
@@ -16,15 +28,45 @@ public:
 		std::vector<std::shared_ptr<SimpleVertexShader>> vertShaders,
 		Microsoft::WRL::ComPtr<ID3D11Device> device,
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
-		std::string name = "sky");
+		std::string name = "sky",
+		std::shared_ptr<IBLBakedSky> bakedIBL = nullptr);
 	~Sky();
 
+	/// <summary>
+	/// Starts loading the BRDF lookup every sky shares on a JobSystem worker,
+	/// so it's usually ready by the time the first sky needs it. It's read
+	/// from the IBL cache, or baked and written there if it isn't cached yet.
+	/// </summary>
+	/// <param name="cacheFolder">IBL cache folder, or empty to always bake</param>
+	static void StartBRDFLookupBake(std::string cacheFolder = "");
+
+	/// <summary>
+	/// Releases the shared BRDF lookup, before the device goes away
+	/// </summary>
+	static void ReleaseSharedResources();
+
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetIrradianceCubeMap();
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetConvolvedSpecularCubeMap();
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetBRDFLookupTexture();
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetSkyTexture();
 	int GetIBLMipLevelCount();
 
+	std::shared_ptr<IBLBakedSky> GetBakedIBL();
+	bool IsIBLBakedOnCPU();
+
+	/// <summary>
+	/// Copies the IBL maps the shaders rendered back to the CPU, for the IBL cache
+	/// </summary>
+	/// <returns>False if the maps were baked on the CPU, or couldn't be read</returns>
+	bool ReadBackIBL(IBLBakedSky* bakedSky);
+
+	/// <summary>
+	/// Renders the IBL maps with the shaders and measures how far the
+	/// CPU baked ones are from them. Slow, meant for checking the bake.
+	/// </summary>
+	/// <returns>False if this sky's maps weren't baked on the CPU</returns>
+	bool CompareIBLWithShaders(SkyIBLComparison* comparison);
+
 	std::string GetName();
 	void SetName(std::string name);
 
@@ -65,11 +107,15 @@ private:
 
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> irradianceCM;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> convolvedSpecularCM;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> lookupTexture;
 	int mipLevelCount;
-	const int mipLevelSkip = 3;
-	const int CMFaceSize = 256;
-	const int lookupTextureSize = 256;
+
+	// Set if the maps were baked on the CPU, shared by every sky made from the same files
+	std::shared_ptr<IBLBakedSky> bakedIBL;
+
+	static Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> sharedLookupTexture;
+	static std::vector<uint16_t> brdfLookupTexels;
+	static std::future<void> brdfLookupBake;
+	static std::string brdfLookupCacheFolder;
 
 	std::shared_ptr<Mesh> skyGeometry;
 	std::shared_ptr<SimplePixelShader> skyPixelShader;
@@ -77,8 +123,13 @@ private:
 	std::vector<std::shared_ptr<SimplePixelShader>> pixShaders;
 	std::vector<std::shared_ptr<SimpleVertexShader>> vertShaders;
 
-	void IBLCreateIrradianceMap();
-	void IBLCreateConvolvedSpecularMap();
-	void IBLCreateBRDFLookUpTexture();
+	void IBLCreateIrradianceMap(ID3D11ShaderResourceView** irradianceMap);
+	void IBLCreateConvolvedSpecularMap(ID3D11ShaderResourceView** specularMap);
+	void IBLCreateBRDFLookUpTexture(ID3D11ShaderResourceView** lookupMap);
+
+	void IBLCreateBakedCubeMap(const IBLCubeFaces& faces, ID3D11ShaderResourceView** cubeMap);
+	void IBLCreateSharedBRDFLookUpTexture();
+
+	bool ReadBackTexture(ID3D11ShaderResourceView* texture, unsigned int arraySlice, unsigned int mipLevel, unsigned int texelSize, std::vector<unsigned char>* texels);
 };
 
@@ -4,10 +4,16 @@
 #include "Mesh.h"
 #include "Material.h"
 
+// How many times a terrain's materials tile across it, near the camera and far from it
+#define TERRAIN_UV_MULT_NEAR 50.0f
+#define TERRAIN_UV_MULT_FAR 150.0f
+
 class Terrain : public IComponent
 {
 public:
 	static void SetDefaults(std::shared_ptr<Mesh> mesh, std::shared_ptr<TerrainMaterial> tMat);
+	static std::shared_ptr<Mesh> GetDefaultMesh();
+	static std::shared_ptr<TerrainMaterial> GetDefaultMaterial();
 	void OnDestroy() override;
 
 	bool DrawBounds;
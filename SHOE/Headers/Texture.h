@@ -3,7 +3,25 @@
 #include <DirectXMath.h>
 #include <wrl/client.h>
 #include "DXCore.h"
+#include "TextureFile.h"
 #include <memory>
+#include <vector>
+#include <functional>
+
+/// <summary>
+/// Pixels decoded from an image file, waiting to be uploaded.
+/// Tightly packed 8-bit RGBA, or rows of blocks once compressed.
+/// Cooked and CPU processed textures carry their whole mip chain,
+/// each mip following the previous one in pixels.
+/// </summary>
+struct DecodedTexture {
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int mipLevels = 1;
+	bool sRGB = false;
+	TextureFileFormat format = TEXTURE_FORMAT_RGBA8;
+	std::vector<unsigned char> pixels;
+};
 
 class Texture {
 private:
@@ -12,6 +30,10 @@ private:
 	std::string name;
 	std::string fileKey;
 	AssetPathIndex assetPathIndex;
+	// Loads the real texture, if it's still a placeholder
+	std::function<void()> materializer;
+	// Id in the AssetManager's TextureStreamer, 0 if all its mips are always resident
+	unsigned int streamingID;
 
 public:
 
@@ -25,6 +47,19 @@ public:
 	void SetTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> texture);
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetTexture();
 
+	/// <summary>
+	/// Defers loading until the texture is first used. It holds a placeholder
+	/// until then, and the materializer is called once, on the first GetTexture.
+	/// </summary>
+	void SetMaterializer(std::function<void()> materializer);
+	bool IsLoadDeferred();
+
+	/// <summary>
+	/// Textures made from the same file share an id, and have their mips swapped together
+	/// </summary>
+	unsigned int GetStreamingID();
+	void SetStreamingID(unsigned int streamingID);
+
 	std::string GetName();
 	void SetName(std::string name);
 
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TextureFile.h"
+
+// Block rows per JobSystem job while compressing
+#define TEXTURE_COMPRESSION_GRAIN_SIZE 4
+
+/// <summary>
+/// What a texture holds, which decides how its mips are filtered and how it's compressed
+/// </summary>
+enum TextureUsage {
+	// Color, filtered in linear space when it's sRGB
+	TEXTURE_USAGE_COLOR,
+	// Linear data sampled from the red channel, like metalness and roughness
+	TEXTURE_USAGE_MASK,
+	// Tangent space normals, renormalized per mip and stored as x and y only
+	TEXTURE_USAGE_NORMAL,
+	TEXTURE_USAGE_COUNT
+};
+
+/// <summary>
+/// Trade between encode time and quality
+/// </summary>
+enum TexturePreset {
+	// Mips only, uploaded as RGBA8
+	TEXTURE_PRESET_UNCOMPRESSED,
+	// Bounding box endpoints, fast enough for loading at runtime
+	TEXTURE_PRESET_FAST,
+	// Principal axis endpoints, refined once
+	TEXTURE_PRESET_BALANCED,
+	// Color goes to BC7, everything is refined further
+	TEXTURE_PRESET_QUALITY,
+	TEXTURE_PRESET_COUNT
+};
+
+/// <summary>
+/// CPU texture pipeline shared by the engine and the cooker: builds mip chains
+/// that respect what the texture holds, then block compresses them. Work is
+/// split across JobSystem workers, and every block is encoded on its own,
+/// so output is the same no matter how many workers there are.
+/// </summary>
+class TextureCompressor
+{
+public:
+	/// <summary>
+	/// Guesses a texture's usage from the folder it's in: PBR/Normals,
+	/// PBR/Metalness and PBR/Roughness, or color for anything else
+	/// </summary>
+	static TextureUsage GetUsageForPath(const std::string& path);
+
+	static const char* GetPresetName(TexturePreset preset);
+	static bool ParsePreset(const std::string& name, TexturePreset* preset);
+
+	/// <summary>
+	/// Picks the compressed format for an image, or RGBA8 if it can't or shouldn't be compressed
+	/// </summary>
+	static TextureFileFormat ChooseFormat(const TextureFileImage& image, TextureUsage usage, TexturePreset preset);
+
+	/// <summary>
+	/// Builds a full mip chain (down to 1x1) with a 2x2 box filter, in parallel
+	/// by row. The first entry is a copy of the source image.
+	/// </summary>
+	/// <param name="sRGB">Whether color is gamma encoded, and so averaged in linear space</param>
+	static void GenerateMips(const TextureFileImage& image, TextureUsage usage, bool sRGB, std::vector<TextureFileImage>* mips);
+
+	/// <summary>
+	/// Block compresses one RGBA8 image, in parallel across its block rows
+	/// </summary>
+	/// <returns>False if the format isn't a block compressed one</returns>
+	static bool Compress(const TextureFileImage& image, TextureFileFormat format, TexturePreset preset, TextureFileImage* compressed);
+
+	/// <summary>
+	/// Runs the whole pipeline: mips, then compression if the preset and image allow it
+	/// </summary>
+	/// <param name="mips">Filled with the mip chain, compressed in place</param>
+	/// <returns>The format the mips ended up in</returns>
+	static TextureFileFormat Process(const TextureFileImage& image, TextureUsage usage, bool sRGB, TexturePreset preset, std::vector<TextureFileImage>* mips);
+
+	/// <summary>
+	/// Decodes one block back to 4x4 RGBA8 texels, row by row. BC7 blocks
+	/// other than mode 6 aren't written by the encoder, and decode as black.
+	/// </summary>
+	static void DecodeBlock(TextureFileFormat format, const uint8_t* block, uint8_t texels[64]);
+
+	/// <summary>
+	/// Root mean square difference per channel between an RGBA8 image and its
+	/// compressed version, over the channels the format keeps
+	/// </summary>
+	static float GetCompressionError(const TextureFileImage& image, const TextureFileImage& compressed, TextureFileFormat format);
+
+	static void EncodeBC1Block(const uint8_t texels[64], TexturePreset preset, uint8_t block[8]);
+	static void EncodeBC4Block(const uint8_t texels[64], int channel, TexturePreset preset, uint8_t block[8]);
+	static void EncodeBC7Block(const uint8_t texels[64], TexturePreset preset, uint8_t block[16]);
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "VirtualFileSystem.h"
+
+// Cooked texture container (.stex). Holds every mip of every array slice
+// already in its GPU format, so a texture can be created with all of its
+// initial data in one call instead of decoding and generating mips at load.
+// Block compressed formats store rows of 4x4 blocks instead of rows of texels.
+//
+// Layout: TextureFileHeader, then arraySize * mipCount TextureFileSubresources
+// in D3D11CalcSubresource order (mip + slice * mipCount), then pixel data.
+
+#define TEXTURE_FILE_MAGIC 0x58544853 // "SHTX"
+#define TEXTURE_FILE_VERSION 2
+#define TEXTURE_FILE_EXTENSION ".stex"
+#define TEXTURE_FILE_SECTION_ALIGNMENT 16
+// D3D11's limits for 2D textures, so files the device would refuse are rejected on open
+#define TEXTURE_FILE_MAX_DIMENSION 16384
+#define TEXTURE_FILE_MAX_ARRAY_SIZE 2048
+
+enum TextureFileFormat : uint32_t {
+	TEXTURE_FORMAT_RGBA8 = 1,
+	// Color, 565 endpoints, no alpha
+	TEXTURE_FORMAT_BC1,
+	// BC1 color plus a BC4 alpha block
+	TEXTURE_FORMAT_BC3,
+	// One channel, red
+	TEXTURE_FORMAT_BC4,
+	// Two channels, red and green, used for normal maps
+	TEXTURE_FORMAT_BC5,
+	// Color and alpha, always written as mode 6
+	TEXTURE_FORMAT_BC7
+};
+
+enum TextureFileFlags : uint32_t {
+	TEXTURE_FLAG_SRGB = 1 << 0,
+	TEXTURE_FLAG_CUBEMAP = 1 << 1
+};
+
+struct TextureFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t format;
+
+	uint32_t flags;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+
+	uint32_t arraySize;
+	uint32_t padding[3];
+};
+
+struct TextureFileSubresource {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+	uint32_t rowPitch;
+	uint32_t padding;
+};
+
+/// <summary>
+/// One tightly packed RGBA8 image, or its blocks once compressed
+/// </summary>
+struct TextureFileImage {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+/// <summary>
+/// Read-only view over a mapped texture file. Pointers returned point straight
+/// into the mapping and stay valid until the view is closed or destroyed.
+/// </summary>
+class TextureFileView
+{
+public:
+	/// <summary>
+	/// Maps and validates a texture file
+	/// </summary>
+	/// <returns>False if missing, a different version, or corrupt</returns>
+	bool Open(const std::string& path);
+	void Close();
+
+	const TextureFileHeader* GetHeader();
+	const TextureFileSubresource* GetSubresource(uint32_t mip, uint32_t slice);
+	const uint8_t* GetSubresourceData(uint32_t mip, uint32_t slice);
+
+private:
+	VirtualFile file;
+	const TextureFileHeader* header = nullptr;
+};
+
+class TextureFile
+{
+public:
+	/// <summary>
+	/// Writes a texture file
+	/// </summary>
+	/// <param name="slices">One mip chain per array slice, all the same size and length, already in the given format. Each mip is half the one above, rounded down, and at least 1.</param>
+	/// <returns>False if the slices don't match or the file couldn't be written</returns>
+	static bool Write(const std::string& path, uint32_t flags, const std::vector<std::vector<TextureFileImage>>& slices, TextureFileFormat format = TEXTURE_FORMAT_RGBA8);
+
+	/// <summary>
+	/// Bytes per 4x4 block, or 0 for formats that aren't block compressed
+	/// </summary>
+	static uint32_t GetBlockSize(uint32_t format);
+
+	/// <summary>
+	/// Bytes in one packed row of texels, or of blocks for compressed formats
+	/// </summary>
+	static uint32_t GetRowPitch(uint32_t format, uint32_t width);
+
+	/// <summary>
+	/// Rows of texels, or of blocks for compressed formats
+	/// </summary>
+	static uint32_t GetRowCount(uint32_t format, uint32_t height);
+
+	/// <summary>
+	/// Mips in a full chain down to 1x1
+	/// </summary>
+	static uint32_t GetFullMipCount(uint32_t width, uint32_t height);
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "TextureFile.h"
+
+// Mips this size or smaller on their longer side are always resident
+#define TEXTURE_STREAMING_TAIL_SIZE 64
+#define TEXTURE_STREAMING_DEFAULT_BUDGET (256ull * 1024 * 1024)
+// Mip data started streaming in per update, so a camera cut doesn't queue every texture at once
+#define TEXTURE_STREAMING_UPLOAD_LIMIT (32ull * 1024 * 1024)
+// Seconds a texture can go unseen before it falls back to its tail
+#define TEXTURE_STREAMING_IDLE_TIME 5.0f
+
+struct StreamedTextureStatus {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipCount = 0;
+	uint32_t format = TEXTURE_FORMAT_RGBA8;
+	// Least detailed mip the texture is ever cut back to
+	uint32_t tailMip = 0;
+	// Most detailed mip on the GPU
+	uint32_t residentMip = 0;
+	// Most detailed mip it's been seen needing
+	uint32_t wantedMip = 0;
+	// Wanted mip after the budget, what it's streaming towards
+	uint32_t targetMip = 0;
+	uint64_t residentBytes = 0;
+	float lastUsedTime = 0;
+	float screenSize = 0;
+	// A change was handed out and hasn't been completed yet
+	bool streaming = false;
+};
+
+/// <summary>
+/// A change for the owner of the GPU textures to make, then hand back with CompleteChange
+/// </summary>
+struct TextureStreamingChange {
+	uint32_t id = 0;
+	// Most detailed mip to keep after the change
+	uint32_t residentMip = 0;
+	// Drops mips, which can be done from what's already resident
+	bool evict = false;
+};
+
+struct TextureStreamingStats {
+	size_t textureCount = 0;
+	size_t streamingCount = 0;
+	uint64_t budget = 0;
+	uint64_t residentBytes = 0;
+	// What would be resident with no budget
+	uint64_t wantedBytes = 0;
+	uint64_t streamedInBytes = 0;
+	uint64_t evictedBytes = 0;
+	uint64_t failedCount = 0;
+};
+
+/// <summary>
+/// Decides which mips of each streamed texture should be resident. It only
+/// deals in sizes and mip indices, so it doesn't touch the GPU; whoever owns
+/// the textures reports how big they were on screen, applies the changes
+/// Update hands out, and reports back when each one is done.
+/// Not thread safe, it's meant to be driven from the main thread.
+/// </summary>
+class TextureStreamer
+{
+public:
+	TextureStreamer();
+
+	/// <summary>
+	/// Starts tracking a texture
+	/// </summary>
+	/// <param name="residentMip">Most detailed mip it was created with, usually its tail mip</param>
+	/// <returns>An id for the texture, never 0 and never reused</returns>
+	uint32_t Register(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t format, uint32_t residentMip);
+	void Unregister(uint32_t id);
+	bool IsRegistered(uint32_t id);
+	void Clear();
+
+	/// <summary>
+	/// Notes that a texture was drawn this big, in texels across the screen
+	/// for its longer side. The largest request since the last update wins.
+	/// </summary>
+	void RequestScreenSize(uint32_t id, float screenSize, float time);
+
+	/// <summary>
+	/// Works out what should be resident under the budget, then hands out
+	/// evictions first and stream-ins after, most important first
+	/// </summary>
+	/// <param name="changes">Replaced with the changes to make</param>
+	void Update(float time, std::vector<TextureStreamingChange>* changes);
+
+	/// <summary>
+	/// Reports that a change from Update was made, or couldn't be
+	/// </summary>
+	/// <param name="residentMip">Most detailed mip resident now</param>
+	/// <param name="failed">Whether the change failed. A failed stream-in isn't tried again.</param>
+	void CompleteChange(uint32_t id, uint32_t residentMip, bool failed = false);
+
+	/// <summary>
+	/// Sets how much memory streamed textures may use, tails included. 0 means no limit.
+	/// </summary>
+	void SetBudget(uint64_t budgetBytes);
+	uint64_t GetBudget();
+
+	bool GetStatus(uint32_t id, StreamedTextureStatus* status);
+	TextureStreamingStats GetStats();
+
+	/// <summary>
+	/// Gets the mip at or below TEXTURE_STREAMING_TAIL_SIZE. Block compressed
+	/// textures stop early if halving further wouldn't leave whole blocks.
+	/// </summary>
+	static uint32_t GetTailMip(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t format);
+
+	/// <summary>
+	/// Gets the least detailed mip that still has a texel per pixel
+	/// </summary>
+	static uint32_t GetWantedMip(uint32_t width, uint32_t height, uint32_t mipCount, float screenSize);
+
+	/// <summary>
+	/// Bytes used by a mip chain from firstMip down
+	/// </summary>
+	static uint64_t GetMipChainSize(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t format, uint32_t firstMip);
+
+private:
+	struct StreamedTexture {
+		StreamedTextureStatus status;
+		// Largest screen size requested since the last update
+		float requestedSize = 0;
+		// Most detailed mip it's allowed, raised when streaming in fails
+		uint32_t bestMip = 0;
+	};
+
+	std::unordered_map<uint32_t, StreamedTexture> textures;
+	uint32_t nextID;
+	uint64_t budget;
+
+	uint64_t streamedInBytes;
+	uint64_t evictedBytes;
+	uint64_t failedCount;
+
+	uint64_t GetSize(const StreamedTextureStatus& status, uint32_t firstMip);
+};
@@ -42,9 +42,6 @@ private:
 
 	bool transformChangedThisFrame = false;
 
-	// Helpers for conversion
-	DirectX::XMFLOAT3 QuaternionToEuler(DirectX::XMFLOAT4 quaternion);
-
 	void Start() override;
 	void Update() override;
 	void EditingUpdate() override;
@@ -58,6 +55,9 @@ private:
 public:
 	void OnDestroy() override;
 
+	// Helpers for conversion
+	static DirectX::XMFLOAT3 QuaternionToEuler(DirectX::XMFLOAT4 quaternion);
+
 	void MoveAbsolute(float x, float y, float z);
 	void MoveAbsolute(DirectX::XMFLOAT3 offset);
 	void MoveRelative(float x, float y, float z); // Move along our "local" axes (respect rotation)
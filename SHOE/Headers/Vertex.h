@@ -12,7 +12,7 @@ struct Vertex
 {
 	DirectX::XMFLOAT3 Position;	    // The position of the vertex
 	DirectX::XMFLOAT3 normal;
-	DirectX::XMFLOAT3 Tangent;
+	DirectX::XMFLOAT4 Tangent;	// w is the bitangent sign
 	DirectX::XMFLOAT2 uv;
 };
 
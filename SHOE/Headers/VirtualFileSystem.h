@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "AssetPack.h"
+#include "MappedFile.h"
+
+/// <summary>
+/// What's known about a file without reading it
+/// </summary>
+struct VirtualFileInfo {
+	uint64_t size = 0;
+	// Last write time of the loose file, or of the file that was packed, in ns since the Unix epoch
+	int64_t modifiedTime = 0;
+	bool packed = false;
+	// Only set for packed files, which have it stored
+	uint64_t contentHash = 0;
+};
+
+struct VirtualFileSystemStats {
+	size_t archiveCount = 0;
+	size_t packedFileCount = 0;
+	uint64_t packedReads = 0;
+	uint64_t looseReads = 0;
+	uint64_t decompressedBytes = 0;
+	uint64_t failedReads = 0;
+};
+
+/// <summary>
+/// Read-only contents of a file, from whichever mounted archive has it or
+/// from disk. Used like a MappedFile: the data stays valid until it's closed.
+/// </summary>
+class VirtualFile
+{
+public:
+	VirtualFile();
+
+	// Can hold a mapping, so it can't be copied
+	VirtualFile(VirtualFile const&) = delete;
+	void operator=(VirtualFile const&) = delete;
+
+	/// <summary>
+	/// Opens a file through the VirtualFileSystem, closing whatever was open
+	/// </summary>
+	/// <returns>False if no archive has it and it isn't on disk, or it's empty</returns>
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen();
+	// Whether the data came from an archive
+	bool IsPacked();
+	const unsigned char* GetData();
+	size_t GetSize();
+
+private:
+	MappedFile looseFile;
+	// Kept so the archive stays mapped while its stored data is pointed into
+	std::shared_ptr<AssetPack> pack;
+	std::vector<unsigned char> unpacked;
+	const unsigned char* data;
+	size_t size;
+
+	friend class VirtualFileSystem;
+};
+
+/// <summary>
+/// Resolves asset paths to mounted archives first and loose files second.
+/// Archives mounted later override earlier ones, so patches can be mounted
+/// over a base archive, and anything no archive has is read from disk,
+/// which lets loose files stand in during development.
+/// Lookups and reads are safe from JobSystem workers. Mounting swaps the
+/// mount list whole, so reads already running finish against the old one.
+/// </summary>
+class VirtualFileSystem
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static VirtualFileSystem& GetInstance()
+	{
+		if (!instance)
+		{
+			instance = new VirtualFileSystem();
+		}
+
+		return *instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	VirtualFileSystem(VirtualFileSystem const&) = delete;
+	void operator=(VirtualFileSystem const&) = delete;
+
+private:
+	static VirtualFileSystem* instance;
+	VirtualFileSystem();
+#pragma endregion
+
+public:
+	/// <summary>
+	/// Mounts an archive so its paths resolve under a folder
+	/// </summary>
+	/// <param name="mountPoint">Folder the archive's paths are relative to, as a full path</param>
+	/// <returns>False if the archive couldn't be opened</returns>
+	bool Mount(const std::string& archivePath, const std::string& mountPoint);
+
+	/// <summary>
+	/// Mounts every archive in a folder, in name order, under that folder
+	/// </summary>
+	/// <returns>The number of archives mounted</returns>
+	size_t MountFolder(const std::string& folder);
+	void UnmountAll();
+
+	/// <summary>
+	/// Opens a file, from the last mounted archive that has it or from disk
+	/// </summary>
+	bool Open(const std::string& path, VirtualFile* file);
+	bool Exists(const std::string& path);
+	bool GetFileInfo(const std::string& path, VirtualFileInfo* info);
+
+	/// <summary>
+	/// Reads a whole file into memory
+	/// </summary>
+	bool ReadWholeFile(const std::string& path, std::vector<char>* data);
+
+	/// <summary>
+	/// Lists the files in a folder across every archive and on disk, once each, in name order
+	/// </summary>
+	/// <param name="recursive">Whether to include files in subfolders</param>
+	/// <param name="paths">Filled with full paths, in the folder's own form</param>
+	void ListFiles(const std::string& folder, bool recursive, std::vector<std::string>* paths);
+
+	VirtualFileSystemStats GetStats();
+
+	/// <summary>
+	/// Finds the last mounted archive with a file
+	/// </summary>
+	/// <returns>False if no archive has it</returns>
+	bool FindPacked(const std::string& path, std::shared_ptr<AssetPack>* pack, const AssetPackEntry** entry);
+
+private:
+	struct MountedPack {
+		// Normalized, ending in '/'
+		std::string root;
+		std::shared_ptr<AssetPack> pack;
+	};
+
+	std::mutex mountMutex;
+	std::shared_ptr<const std::vector<MountedPack>> mounts;
+
+	std::atomic<uint64_t> packedReads;
+	std::atomic<uint64_t> looseReads;
+	std::atomic<uint64_t> decompressedBytes;
+	std::atomic<uint64_t> failedReads;
+
+	std::shared_ptr<const std::vector<MountedPack>> GetMounts();
+
+	/// <summary>
+	/// Makes a path absolute, resolves "." and "..", and lower cases it with '/' separators
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+};
@@ -47,12 +47,13 @@ PS_Output main(VertexToPixelNormal input)
 	input.uv *= uvMult;
 
 	//sample and unpack normal
-	float3 unpackedNormal = textureNormal.Sample(sampleState, input.uv).rgb * 2 - 1;
+	float3 unpackedNormal = UnpackNormalMap(textureNormal.Sample(sampleState, input.uv));
 
 	float3 N = normalize(input.normal);
-	float3 T = normalize(input.tangent);
+	float3 T = normalize(input.tangent.xyz);
 	T = normalize(T - N * dot(T, N));
-	float3 B = cross(T, N);
+	// w flips the bitangent for mirrored uvs
+	float3 B = cross(T, N) * input.tangent.w;
 	float3x3 TBN = float3x3(T, B, N);
 
 	input.normal = normalize(mul(unpackedNormal, TBN));
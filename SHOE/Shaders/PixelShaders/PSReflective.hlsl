@@ -31,12 +31,13 @@ float3 calcLightExternal(VertexToPixelNormal input, LightStruct light, float3 te
 float4 main(VertexToPixelNormal input) : SV_TARGET
 {
 	//sample and unpack normal
-	float3 unpackedNormal = textureNormal.Sample(sampleState, input.uv).rgb * 2 - 1;
+	float3 unpackedNormal = UnpackNormalMap(textureNormal.Sample(sampleState, input.uv));
 
 	float3 N = normalize(input.normal);
-	float3 T = normalize(input.tangent);
+	float3 T = normalize(input.tangent.xyz);
 	T = normalize(T - N * dot(T, N));
-	float3 B = cross(T, N);
+	// w flips the bitangent for mirrored uvs
+	float3 B = cross(T, N) * input.tangent.w;
 	float3x3 TBN = float3x3(T, B, N);
 
 	input.normal = mul(unpackedNormal, TBN);
@@ -58,22 +58,23 @@ PS_Output main(VertexToPixelNormal input)
 	float2 uvFar = input.uv * uvMultFar;
 
 	//sample and unpack normals
-	float3 unpackedNormal1 = texture1Normal.Sample(sampleState, uvNear).rgb * 2 - 1;
-	float3 unpackedNormal2 = texture2Normal.Sample(sampleState, uvNear).rgb * 2 - 1;
-	float3 unpackedNormal3 = texture3Normal.Sample(sampleState, uvNear).rgb * 2 - 1;
+	float3 unpackedNormal1 = UnpackNormalMap(texture1Normal.Sample(sampleState, uvNear));
+	float3 unpackedNormal2 = UnpackNormalMap(texture2Normal.Sample(sampleState, uvNear));
+	float3 unpackedNormal3 = UnpackNormalMap(texture3Normal.Sample(sampleState, uvNear));
 
-	float3 unpackedNormal1Far = texture1Normal.Sample(sampleState, uvFar).rgb * 2 - 1;
-	float3 unpackedNormal2Far = texture2Normal.Sample(sampleState, uvFar).rgb * 2 - 1;
-	float3 unpackedNormal3Far = texture3Normal.Sample(sampleState, uvFar).rgb * 2 - 1;
+	float3 unpackedNormal1Far = UnpackNormalMap(texture1Normal.Sample(sampleState, uvFar));
+	float3 unpackedNormal2Far = UnpackNormalMap(texture2Normal.Sample(sampleState, uvFar));
+	float3 unpackedNormal3Far = UnpackNormalMap(texture3Normal.Sample(sampleState, uvFar));
 
 	float3 lerpedNormal1 = lerp(unpackedNormal1, unpackedNormal1Far, distanceForUV);
 	float3 lerpedNormal2 = lerp(unpackedNormal2, unpackedNormal2Far, distanceForUV);
 	float3 lerpedNormal3 = lerp(unpackedNormal3, unpackedNormal3Far, distanceForUV);
 
 	float3 N = normalize(input.normal);
-	float3 T = normalize(input.tangent);
+	float3 T = normalize(input.tangent.xyz);
 	T = normalize(T - N * dot(T, N));
-	float3 B = cross(T, N);
+	// w flips the bitangent for mirrored uvs
+	float3 B = cross(T, N) * input.tangent.w;
 	float3x3 TBN = float3x3(T, B, N);
 
 	float3 normal1 = mul(lerpedNormal1, TBN);
@@ -182,7 +182,7 @@ struct VertexToPixelNormal
 	float4 surfaceColor			: COLOR;
 	float3 normal				: NORMAL;
 	float3 worldPos				: POSITION;
-	float3 tangent				: TANGENT;
+	float4 tangent				: TANGENT;
 	float2 uv					: TEXCOORD;
 };
 
@@ -546,6 +546,14 @@ float3 ImportanceSampleGGX(float2 Xi, float roughness, float3 N)
 	return TangentX * H.x + TangentY * H.y + N * H.z;
 }
 
+// Tangent space normal from a normal map sample. Only x and y are read,
+// since BC5 compressed maps don't store z, which is rebuilt from them.
+float3 UnpackNormalMap(float4 packedNormal)
+{
+	float2 xy = packedNormal.xy * 2 - 1;
+	return float3(xy, sqrt(saturate(1 - dot(xy, xy))));
+}
+
 #endif
 
 struct PS_Output
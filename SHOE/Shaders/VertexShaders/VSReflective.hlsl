@@ -14,7 +14,7 @@ struct VertexShaderInput
 	//  v    v                v
 	float3 position		: POSITION;     // XYZ position
 	float3 normal		: NORMAL;
-	float3 tangent		: TANGENT;
+	float4 tangent		: TANGENT;
 	float2 uv			: TEXCOORD;
 };
 
@@ -57,7 +57,7 @@ VertexToPixelNormal main(VertexShaderInput input)
 
 	output.normal = normalize(mul((float3x3)world, input.normal));
 
-	output.tangent = normalize(mul((float3x3)world, input.tangent));
+	output.tangent = float4(normalize(mul((float3x3)world, input.tangent.xyz)), input.tangent.w);
 
 	output.worldPos = mul(world, float4(input.position, 1.0f)).xyz;
 
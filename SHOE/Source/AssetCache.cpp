@@ -0,0 +1,198 @@
+#include "../Headers/AssetCache.h"
+#include "../Headers/VirtualFileSystem.h"
+#include "experimental\filesystem"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+// 64 bit FNV-1a
+static const uint64_t fnvOffset = 14695981039346656037ull;
+static const uint64_t fnvPrime = 1099511628211ull;
+
+AssetCache::AssetCache() {
+	hitCount = 0;
+	missCount = 0;
+}
+
+#pragma region hashing
+std::string AssetCache::NormalizePath(const std::string& path) {
+	std::error_code error;
+	std::experimental::filesystem::path absolutePath = std::experimental::filesystem::canonical(path, error);
+
+	std::string normalized = error ? path : absolutePath.string();
+
+#ifdef _WIN32
+	// Windows accepts either separator and ignores case
+	std::replace(normalized.begin(), normalized.end(), '/', '\\');
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return (char)tolower(c); });
+#endif
+
+	return normalized;
+}
+
+bool AssetCache::GetContentHash(const std::string& path, uint64_t* hash) {
+	std::string normalizedPath = NormalizePath(path);
+
+	VirtualFileInfo info;
+	if (!VirtualFileSystem::GetInstance().GetFileInfo(normalizedPath, &info)) return false;
+
+	// Archives store the hash of every file they hold, so packed files never have to be read
+	if (info.packed) {
+		*hash = info.contentHash;
+		return true;
+	}
+
+	MeshFileSourceStamp stamp;
+	stamp.size = info.size;
+	stamp.modifiedTime = info.modifiedTime;
+
+	{
+		std::lock_guard<std::mutex> lock(fileHashMutex);
+		auto known = fileHashes.find(normalizedPath);
+		if (known != fileHashes.end() &&
+			known->second.stamp.size == stamp.size &&
+			known->second.stamp.modifiedTime == stamp.modifiedTime) {
+			*hash = known->second.hash;
+			return true;
+		}
+	}
+
+	// Hash outside the lock, so workers hashing different files don't wait on each other
+	VirtualFile file;
+	if (!file.Open(normalizedPath)) return false;
+
+	uint64_t contentHash = fnvOffset;
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	for (size_t i = 0; i < size; i++) {
+		contentHash ^= data[i];
+		contentHash *= fnvPrime;
+	}
+
+	std::lock_guard<std::mutex> lock(fileHashMutex);
+	fileHashes[normalizedPath] = { stamp, contentHash };
+
+	*hash = contentHash;
+	return true;
+}
+
+bool AssetCache::GetContentHash(const std::vector<std::string>& paths, uint64_t* hash) {
+	if (paths.empty()) return false;
+
+	uint64_t combinedHash = fnvOffset;
+	for (const std::string& path : paths) {
+		uint64_t fileHash;
+		if (!GetContentHash(path, &fileHash)) return false;
+
+		for (int i = 0; i < 8; i++) {
+			combinedHash ^= (fileHash >> (i * 8)) & 0xFF;
+			combinedHash *= fnvPrime;
+		}
+	}
+
+	*hash = combinedHash;
+	return true;
+}
+
+std::string AssetCache::MakeKey(AssetCacheType type, uint64_t contentHash, const std::string& variant) {
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)contentHash);
+
+	return std::to_string((int)type) + "|" + hashText + "|" + variant;
+}
+#pragma endregion
+
+#pragma region references
+AssetCacheEntry* AssetCache::Find(const std::string& key) {
+	auto found = entries.find(key);
+	if (found == entries.end()) return nullptr;
+
+	hitCount++;
+
+	return &found->second;
+}
+
+bool AssetCache::Contains(const std::string& key) {
+	return entries.find(key) != entries.end();
+}
+
+AssetCacheEntry* AssetCache::Insert(const std::string& key, const AssetCacheEntry& entry) {
+	AssetCacheEntry& newEntry = entries[key];
+	newEntry = entry;
+	newEntry.refCount = 0;
+	missCount++;
+
+	return &newEntry;
+}
+
+void AssetCache::AddReference(const void* asset, const std::string& key) {
+	auto found = entries.find(key);
+	if (asset == nullptr || found == entries.end()) return;
+
+	AssetReference& reference = assetReferences[asset];
+	if (reference.key != key) {
+		reference.key = key;
+		reference.count = 0;
+	}
+
+	reference.count++;
+	found->second.refCount++;
+}
+
+bool AssetCache::Release(const void* asset) {
+	auto reference = assetReferences.find(asset);
+	if (reference == assetReferences.end()) return false;
+
+	auto found = entries.find(reference->second.key);
+	if (found != entries.end()) {
+		AssetCacheEntry& entry = found->second;
+		entry.refCount -= (std::min)(entry.refCount, reference->second.count);
+
+		if (entry.refCount == 0) {
+			entries.erase(found);
+		}
+	}
+
+	assetReferences.erase(reference);
+
+	return true;
+}
+
+bool AssetCache::IsReferenced(const void* asset) {
+	return asset != nullptr && assetReferences.find(asset) != assetReferences.end();
+}
+
+void AssetCache::ReplaceTextureView(ID3D11ShaderResourceView* oldView, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> newView) {
+	if (oldView == nullptr) return;
+
+	for (auto& entry : entries) {
+		if (entry.second.textureView.Get() == oldView) {
+			entry.second.textureView = newView;
+		}
+	}
+}
+
+void AssetCache::Clear() {
+	entries.clear();
+	assetReferences.clear();
+}
+
+AssetCacheStats AssetCache::GetStats() {
+	AssetCacheStats stats;
+	stats.entryCount = entries.size();
+	stats.hitCount = hitCount;
+	stats.missCount = missCount;
+
+	for (auto& entry : entries) {
+		stats.referenceCount += entry.second.refCount;
+
+		// Every reference past the first would have been its own copy
+		if (entry.second.refCount > 1) {
+			stats.savedGpuBytes += entry.second.gpuBytes * (entry.second.refCount - 1);
+			stats.savedCpuBytes += entry.second.cpuBytes * (entry.second.refCount - 1);
+		}
+	}
+
+	return stats;
+}
+#pragma endregion
@@ -0,0 +1,140 @@
+#include "../Headers/AssetLoadGraph.h"
+#include <stdexcept>
+#include <chrono>
+
+int AssetLoadGraph::AddNode(std::string name,
+							std::function<void()> mainThreadStage,
+							std::vector<int> dependencies,
+							AssetWorkerStage workerStage,
+							int itemCount)
+{
+	// Only allowing dependencies on earlier nodes keeps the graph acyclic
+	for (int dependency : dependencies) {
+		if (dependency < 0 || dependency >= (int)nodes.size()) {
+			throw std::invalid_argument("Asset load node '" + name + "' depends on a node that hasn't been added yet");
+		}
+	}
+
+	std::unique_ptr<AssetLoadNode> node = std::make_unique<AssetLoadNode>();
+	node->name = name;
+	node->mainThreadStage = mainThreadStage;
+	node->workerStage = workerStage;
+	node->dependencies = dependencies;
+	node->itemsLoaded = 0;
+	node->itemCount = itemCount;
+	node->complete = false;
+
+	nodes.push_back(std::move(node));
+
+	return (int)nodes.size() - 1;
+}
+
+bool AssetLoadGraph::IsReady(AssetLoadNode* node) {
+	if (node->complete) return false;
+
+	for (int dependency : node->dependencies) {
+		if (!nodes[dependency]->complete) return false;
+	}
+
+	if (node->workerResult.valid()) {
+		return node->workerResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	return true;
+}
+
+std::string AssetLoadGraph::GetProgressString(AssetLoadNode* node) {
+	if (node->itemCount <= 0) return node->name;
+
+	return node->name + " (" + std::to_string(node->itemsLoaded.load()) + "/" + std::to_string(node->itemCount) + ")";
+}
+
+void AssetLoadGraph::Execute(std::function<void(std::string)> progressListener) {
+	JobSystem& jobSystem = JobSystem::GetInstance();
+
+	// Every worker stage only reads files and decodes into its own staging
+	// data, so they can all start now regardless of the dependency order
+	for (std::unique_ptr<AssetLoadNode>& node : nodes) {
+		if (!node->workerStage) continue;
+
+		AssetLoadNode* nodePtr = node.get();
+		node->workerResult = jobSystem.Schedule([this, nodePtr]() {
+			// Signal on the way out even if the stage throws,
+			// the main thread will pick the exception up from the future
+			struct NotifyOnExit {
+				AssetLoadGraph* graph;
+				~NotifyOnExit() {
+					std::lock_guard<std::mutex> lock(graph->progressMutex);
+					graph->progressChanged.notify_all();
+				}
+			} notifier = { this };
+
+			nodePtr->workerStage([this, nodePtr]() {
+				nodePtr->itemsLoaded++;
+
+				std::lock_guard<std::mutex> lock(progressMutex);
+				progressChanged.notify_all();
+			});
+		});
+	}
+
+	size_t remaining = nodes.size();
+	std::string lastReported;
+
+	try {
+		while (remaining > 0) {
+			AssetLoadNode* next = nullptr;
+			for (std::unique_ptr<AssetLoadNode>& node : nodes) {
+				if (IsReady(node.get())) {
+					next = node.get();
+					break;
+				}
+			}
+
+			if (next != nullptr) {
+				if (progressListener) progressListener(next->name);
+				lastReported = next->name;
+
+				// Rethrows anything the worker stage hit
+				if (next->workerResult.valid()) next->workerResult.get();
+				if (next->mainThreadStage) next->mainThreadStage();
+
+				next->complete = true;
+				remaining--;
+				continue;
+			}
+
+			// Nothing can run yet, so the first node in order whose dependencies
+			// are met is waiting on its worker stage. Report that while we wait.
+			AssetLoadNode* waitingOn = nullptr;
+			for (std::unique_ptr<AssetLoadNode>& node : nodes) {
+				if (node->complete) continue;
+
+				bool dependenciesMet = true;
+				for (int dependency : node->dependencies) {
+					if (!nodes[dependency]->complete) dependenciesMet = false;
+				}
+
+				if (dependenciesMet) {
+					waitingOn = node.get();
+					break;
+				}
+			}
+
+			std::string progress = GetProgressString(waitingOn);
+			if (progressListener && progress != lastReported) progressListener(progress);
+			lastReported = progress;
+
+			std::unique_lock<std::mutex> lock(progressMutex);
+			progressChanged.wait_for(lock, std::chrono::milliseconds(16));
+		}
+	}
+	catch (...) {
+		// Worker stages reference the nodes, so they have to finish before we unwind
+		for (std::unique_ptr<AssetLoadNode>& node : nodes) {
+			if (node->workerResult.valid()) node->workerResult.wait();
+		}
+
+		throw;
+	}
+}
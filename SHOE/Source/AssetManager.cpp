@@ -1,6 +1,18 @@
 #include "../Headers/AssetManager.h"
 #include "..\Headers\FlashlightController.h"
 #include "..\Headers\NoclipMovement.h"
+#include <wincodec.h>
+#include "../Headers/TextureFile.h"
+#include "../Headers/VirtualFileSystem.h"
+#include "../Headers/AsyncFileReader.h"
+#include "../Headers/MeshBuilder.h"
+#include "../Headers/Time.h"
+#include <cfloat>
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+
+// WIC is used directly to decode textures off the main thread
+#pragma comment(lib, "windowscodecs.lib")
 
 using namespace DirectX;
 
@@ -8,6 +20,12 @@ using namespace DirectX;
 AssetManager* AssetManager::instance;
 
 AssetManager::~AssetManager() {
+	// Deferred loads still running on workers call back into the manager,
+	// and read callbacks can still be handing work to them
+	SetHotReloadEnabled(false);
+	AsyncFileReader::GetInstance().Shutdown();
+	JobSystem::GetInstance().Shutdown();
+
 	// Everything should be smart-pointer managed
 	// Except sounds, which have to have UserData cleared
 	// manually (and can't use auto, iterator isn't built)
@@ -39,41 +57,79 @@ void AssetManager::Initialize(Microsoft::WRL::ComPtr<ID3D11Device> device, Micro
 	this->device = device;
 	this->engineState = engineState;
 
+	// Archives next to the Assets folder are read before any loose files
+	VirtualFileSystem::GetInstance().UnmountAll();
+	VirtualFileSystem::GetInstance().MountFolder(GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, "..\\..\\"));
+
+	JobSystem::GetInstance().Initialize();
+	AsyncFileReader::GetInstance().Initialize();
+	Sky::StartBRDFLookupBake(GetFullPathToAssetFile(AssetPathIndex::ASSET_TEXTURE_PATH_SKIES, IBL_CACHE_FOLDER));
+	ISimpleShader::ReflectionCacheFolder = GetFullPathToAssetFile(AssetPathIndex::ASSET_SHADER_PATH, SHADER_REFLECTION_FOLDER);
+	deferredLoadsInFlight = 0;
+	assetMemoryBudget = DEFAULT_ASSET_MEMORY_BUDGET;
+	nextBudgetCheckTime = 0.0f;
+	textureCompressionPreset = TEXTURE_PRESET_FAST;
+
 	CleanAllVectors();
 
 	// This must occur before the loading screen starts
 	InitializeFonts();
 	InitializeTextureSampleStates();
 
-	// The rest signal the loading screen each time an object loads
-	if(progressListener) progressListener("Shaders");
-	InitializeShaders();
-	if (progressListener) progressListener("Textures");
+	// These only fill the load queues, nothing is read from disk yet
 	InitializeTextures();
-	if(progressListener) progressListener("Materials");
-	InitializeMaterials();
-	if(progressListener) progressListener("Terrain Materials");
-	InitializeTerrainMaterials();
-	if(progressListener) progressListener("Meshes");
 	InitializeMeshes();
-	if(progressListener) progressListener("Entities");
-	InitializeGameEntities();
-	if(progressListener) progressListener("Cameras");
-	InitializeCameras();
-	if(progressListener) progressListener("Terrain");
-	InitializeTerrainEntities();
-	if(progressListener) progressListener("Lights");
-	InitializeLights();
-	if(progressListener) progressListener("Colliders");
-	InitializeColliders();
-	if(progressListener) progressListener("Emitters");
-	InitializeEmitters();
-	if(progressListener) progressListener("Skies");
 	InitializeSkies();
-	if(progressListener) progressListener("Audio");
 	InitializeAudio();
-	if(progressListener) progressListener("IMGUI");
-	InitializeIMGUI(hwnd);
+
+	std::vector<std::string> defaultParticlePaths = GetParticleTexturePaths("Smoke/");
+
+	// File reads and decoding start on the job system immediately. Everything
+	// that needs the device or the asset vectors runs here on the main thread,
+	// in dependency order, as soon as its inputs are ready. The graph signals
+	// the loading screen each time a category starts or makes progress.
+	AssetLoadGraph loadGraph;
+
+	int shaderNode = loadGraph.AddNode("Shaders", [&]() { InitializeShaders(); });
+
+	int textureNode = loadGraph.AddNode("Textures", [&]() { CreateQueuedTextures(); }, {},
+		[&](std::function<void()> itemLoaded) { DecodeQueuedTextures(itemLoaded); },
+		(int)textureLoadQueue.size());
+
+	int materialNode = loadGraph.AddNode("Materials", [&]() { InitializeMaterials(); }, { shaderNode, textureNode });
+
+	int terrainMaterialNode = loadGraph.AddNode("Terrain Materials", [&]() { InitializeTerrainMaterials(); }, { materialNode });
+
+	int meshNode = loadGraph.AddNode("Meshes", [&]() { CreateQueuedMeshes(); }, {},
+		[&](std::function<void()> itemLoaded) { DecodeQueuedMeshes(itemLoaded); },
+		(int)meshLoadQueue.size());
+
+	int entityNode = loadGraph.AddNode("Entities", [&]() { InitializeGameEntities(); }, { meshNode, materialNode });
+
+	int cameraNode = loadGraph.AddNode("Cameras", [&]() { InitializeCameras(); });
+
+	loadGraph.AddNode("Terrain", [&]() { InitializeTerrainEntities(); }, { meshNode, terrainMaterialNode });
+
+	loadGraph.AddNode("Lights", [&]() { InitializeLights(); }, { cameraNode });
+
+	loadGraph.AddNode("Colliders", [&]() { InitializeColliders(); }, { entityNode });
+
+	loadGraph.AddNode("Emitters", [&]() { InitializeEmitters(); }, { shaderNode },
+		[&](std::function<void()> itemLoaded) { DecodeTextureFiles(defaultParticlePaths, &defaultParticleTextures, itemLoaded); },
+		(int)defaultParticlePaths.size());
+
+	// Sky IBL maps are rendered with the IBL shaders, so those have to exist first
+	loadGraph.AddNode("Skies", [&]() { CreateQueuedSkies(); }, { shaderNode },
+		[&](std::function<void()> itemLoaded) { DecodeQueuedSkies(itemLoaded); },
+		(int)skyLoadQueue.size());
+
+	loadGraph.AddNode("Audio", [&]() { RegisterQueuedSounds(); }, {},
+		[&](std::function<void()> itemLoaded) { LoadQueuedSounds(itemLoaded); },
+		(int)soundLoadQueue.size());
+
+	loadGraph.AddNode("IMGUI", [&]() { InitializeIMGUI(hwnd); });
+
+	loadGraph.Execute(progressListener);
 
 	if(progressListener) progressListener("Editing Camera");
 	//Intentionally not tracked by the asset manager
@@ -83,16 +139,16 @@ void AssetManager::Initialize(Microsoft::WRL::ComPtr<ID3D11Device> device, Micro
 	editingCamera = CreateCameraOnEntity(editingCamObj);
 	editingCamObj->AddComponent<NoclipMovement>();
 
+	// Only starts watching now, so nothing loaded above is reloaded
+	SetHotReloadEnabled(true);
+
 	*engineState = EngineState::EDITING;
 }
 #pragma endregion
 
 #pragma region createAssets
 FMOD::Sound* AssetManager::CreateSound(std::string path, FMOD_MODE mode, std::string name, bool isNameFullPath) {
-	FMODUserData* uData = new FMODUserData;
-	FMOD::Sound* sound;
-
-	std::string namePath = GetFullPathToAssetFile(AssetPathIndex::ASSET_SOUND_PATH, path);
+	std::string namePath;
 
 	if (isNameFullPath) {
 		namePath = path;
@@ -101,7 +157,32 @@ FMOD::Sound* AssetManager::CreateSound(std::string path, FMOD_MODE mode, std::st
 		namePath = GetFullPathToAssetFile(AssetPathIndex::ASSET_SOUND_PATH, path);
 	}
 
-	sound = audioInstance.LoadSound(namePath, mode);
+	// Sounds carry their name in their user data, so only a repeat under the same name can share
+	std::string cacheKey = GetContentCacheKey(ASSET_CACHE_SOUND, { namePath }, std::to_string(mode) + "|" + name);
+	FMOD::Sound* cachedSound = FindCachedSound(cacheKey);
+	if (cachedSound != nullptr) return cachedSound;
+
+	FMOD::Sound* loadedSound = TakePreloadedSound(cacheKey);
+	if (loadedSound == nullptr) loadedSound = audioInstance.LoadSound(namePath, mode);
+
+	FMOD::Sound* newSound = RegisterSound(loadedSound, namePath, name);
+	CacheSound(cacheKey, newSound, mode);
+
+	return newSound;
+}
+
+/// <summary>
+/// Attaches name and filename key user data to an already loaded
+/// sound and tracks it in the global sound list.
+/// </summary>
+/// <param name="sound">Sound from AudioHandler::LoadSound, may be null if loading failed</param>
+/// <param name="namePath">Full path the sound was loaded from</param>
+/// <param name="name">Name to search for the sound by</param>
+/// <returns>The same sound, or null if it failed to load</returns>
+FMOD::Sound* AssetManager::RegisterSound(FMOD::Sound* sound, std::string namePath, std::string name) {
+	if (sound == nullptr) return nullptr;
+
+	FMODUserData* uData = new FMODUserData;
 
 	// Serialize the filename if it's in the right folder
 	std::string assetPathStr = "Assets\\Sounds\\";
@@ -202,9 +283,31 @@ std::shared_ptr<Mesh> AssetManager::CreateMesh(std::string id, std::string nameT
 		namePath = GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, nameToLoad);
 	}
 
-	std::shared_ptr<Mesh> newMesh = std::make_shared<Mesh>(namePath.c_str(), device, id);
+	std::string cacheKey = GetContentCacheKey(ASSET_CACHE_MESH, { namePath });
+	std::shared_ptr<Mesh> newMesh = FindCachedMesh(cacheKey, id);
+	if (newMesh != nullptr) return newMesh;
+
+	MeshLoadRequest preloaded;
+	MeshFileView cookedMesh;
+	if (TakePreloadedMesh(cacheKey, &preloaded)) {
+		if (preloaded.meshFile) {
+			newMesh = std::make_shared<Mesh>(*preloaded.meshFile, device, id);
+		}
+		else {
+			newMesh = std::make_shared<Mesh>(preloaded.meshData, device, id);
+		}
+	}
+	else if (OpenCookedMesh(namePath, &cookedMesh)) {
+		newMesh = std::make_shared<Mesh>(cookedMesh, device, id);
+	}
+	else {
+		newMesh = std::make_shared<Mesh>(namePath.c_str(), device, id);
+	}
+
+	newMesh->SetFileNameKey(SerializeFileName("Assets\\Models\\", namePath));
 
 	globalMeshes.push_back(newMesh);
+	CacheMesh(cacheKey, newMesh);
 
 	return newMesh;
 }
@@ -334,12 +437,35 @@ std::shared_ptr<Texture> AssetManager::CreateTexture(std::string nameToLoad, std
 	else {
 		namePath = GetFullPathToAssetFile(assetPath, nameToLoad);
 	}
-	std::wstring widePath;
 
-	HRESULT hr = ISimpleShader::ConvertToWide(namePath, widePath);
+	std::string cacheKey = GetTextureCacheKey(namePath, textureCompressionPreset);
+	std::shared_ptr<Texture> cachedTexture = FindCachedTexture(cacheKey, nameToLoad, textureName, assetPath, isNameFullPath);
+	if (cachedTexture != nullptr) return cachedTexture;
+
+	DecodedTexture decodedTexture;
+	HRESULT result;
+	if (!TakePreloadedTexture(cacheKey, &decodedTexture, &result)) {
+		result = DecodeAndCompressTextureFile(namePath, textureCompressionPreset, &decodedTexture);
+	}
+
+	unsigned int streamingID = 0;
+	if (SUCCEEDED(result)) {
+		coreTexture = CreateStreamedTexture(decodedTexture, namePath, textureCompressionPreset, &streamingID);
+	}
+
+	std::shared_ptr<Texture> newTexture = RegisterTexture(coreTexture, nameToLoad, textureName, assetPath, isNameFullPath);
+	newTexture->SetStreamingID(streamingID);
+	CacheTexture(cacheKey, newTexture, decodedTexture);
 
-	CreateWICTextureFromFile(device.Get(), context.Get(), widePath.c_str(), nullptr, coreTexture.GetAddressOf());
+	return newTexture;
+}
 
+/// <summary>
+/// Wraps an uploaded texture in a Texture asset and tracks it in the global list.
+/// A null SRV is still registered, matching how failed loads have always behaved.
+/// </summary>
+std::shared_ptr<Texture> AssetManager::RegisterTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> coreTexture, std::string nameToLoad, std::string textureName, AssetPathIndex assetPath, bool isNameFullPath)
+{
 	std::shared_ptr<Texture> newTexture = std::make_shared<Texture>(coreTexture, GetTextureFileKey(nameToLoad), textureName);
 
 	if (isNameFullPath) {
@@ -551,10 +677,10 @@ std::shared_ptr<TerrainMaterial> AssetManager::CreateTerrainMaterial(std::string
 		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> blendMap;
 		std::string namePath = GetFullPathToAssetFile(AssetPathIndex::ASSET_TEXTURE_PATH_BASIC, blendMapPath);
 
-		std::wstring wPath;
-		ISimpleShader::ConvertToWide(namePath, wPath);
-
-		CreateWICTextureFromFile(device.Get(), context.Get(), wPath.c_str(), nullptr, blendMap.GetAddressOf());
+		std::vector<char> blendMapData;
+		if (ReadFileBytes(namePath, &blendMapData)) {
+			CreateWICTextureFromMemory(device.Get(), context.Get(), (const uint8_t*)blendMapData.data(), blendMapData.size(), nullptr, blendMap.GetAddressOf());
+		}
 
 		newTMat->SetBlendMap(blendMap);
 
@@ -595,10 +721,10 @@ std::shared_ptr<TerrainMaterial> AssetManager::CreateTerrainMaterial(std::string
 		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> blendMap;
 		std::string namePath = GetFullPathToAssetFile(AssetPathIndex::ASSET_TEXTURE_PATH_BASIC, blendMapPath);
 
-		std::wstring wPath;
-		ISimpleShader::ConvertToWide(namePath, wPath);
-
-		CreateWICTextureFromFile(device.Get(), context.Get(), wPath.c_str(), nullptr, blendMap.GetAddressOf());
+		std::vector<char> blendMapData;
+		if (ReadFileBytes(namePath, &blendMapData)) {
+			CreateWICTextureFromMemory(device.Get(), context.Get(), (const uint8_t*)blendMapData.data(), blendMapData.size(), nullptr, blendMap.GetAddressOf());
+		}
 
 		newTMat->SetBlendMap(blendMap);
 		newTMat->SetBlendMapFilenameKey(SerializeFileName("Assets\\Textures\\", namePath));
@@ -613,6 +739,67 @@ std::shared_ptr<TerrainMaterial> AssetManager::CreateTerrainMaterial(std::string
 }
 
 std::shared_ptr<Sky> AssetManager::CreateSky(std::string filepath, bool fileType, std::string name, std::string fileExtension) {
+	SkyLoadRequest request;
+	request.fullPath = GetFullPathToAssetFile(AssetPathIndex::ASSET_TEXTURE_PATH_SKIES, filepath);
+	request.filepath = filepath;
+	request.fileType = fileType;
+	request.name = name;
+	request.fileExtension = fileExtension;
+	HashSkyRequest(request);
+
+	std::shared_ptr<Sky> cachedSky = FindCachedSky(request.cacheKey, request);
+	if (cachedSky != nullptr) return cachedSky;
+
+	if (!TakePreloadedSky(request.cacheKey, &request)) {
+		DecodeSkyRequest(request);
+	}
+
+	return CreateSkyFromRequest(request);
+}
+
+/// <summary>
+/// Uploads the sky texture from a decoded request, then builds the Sky
+/// and adds it to the content cache.
+/// </summary>
+std::shared_ptr<Sky> AssetManager::CreateSkyFromRequest(SkyLoadRequest& request) {
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> newSkyTexture;
+	uint64_t textureBytes = 0;
+
+	if (SUCCEEDED(request.result)) {
+		if (request.fileType) {
+			// Process as 6 textures in a directory
+			newSkyTexture = CreateCubemapFromDecoded(request.faces);
+
+			// Only the top mip of each face is uploaded
+			for (int i = 0; i < 6; i++) {
+				textureBytes += (uint64_t)request.faces[i].width * request.faces[i].height * 4;
+			}
+		}
+		else {
+			// Process as a .dds
+			CreateDDSTextureFromMemory(device.Get(),
+				context.Get(),
+				(const uint8_t*)request.ddsFileData.data(),
+				request.ddsFileData.size(),
+				nullptr,
+				newSkyTexture.GetAddressOf());
+
+			textureBytes = request.ddsFileData.size();
+		}
+	}
+
+	std::shared_ptr<Sky> newSky = CreateSkyFromTexture(newSkyTexture, request);
+	CacheSky(request.cacheKey, newSky, textureBytes);
+	CacheSkyIBL(request, newSky);
+
+	return newSky;
+}
+
+/// <summary>
+/// Builds a Sky around an uploaded cube map and tracks it in the global list.
+/// The Sky uploads the request's baked IBL maps, or renders them if there are none.
+/// </summary>
+std::shared_ptr<Sky> AssetManager::CreateSkyFromTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skyTexture, const SkyLoadRequest& request) {
 	std::vector<std::shared_ptr<SimplePixelShader>> importantSkyPixelShaders;
 	std::vector<std::shared_ptr<SimpleVertexShader>> importantSkyVertexShaders;
 
@@ -624,41 +811,13 @@ std::shared_ptr<Sky> AssetManager::CreateSky(std::string filepath, bool fileType
 	importantSkyVertexShaders.push_back(GetVertexShaderByName("SkyVS"));
 	importantSkyVertexShaders.push_back(GetVertexShaderByName("FullscreenVS"));
 
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> newSkyTexture;
-
-	std::string assetPath = GetFullPathToAssetFile(AssetPathIndex::ASSET_TEXTURE_PATH_SKIES, filepath);
-
-	if (fileType) {
-		// Process as 6 textures in a directory
+	std::string filenameKey = SerializeFileName("Assets\\Textures\\Skies\\", request.fullPath);
 
-		std::wstring skyDirWide;
-		std::wstring fileExtensionW;
-		ISimpleShader::ConvertToWide(assetPath, skyDirWide);
-		ISimpleShader::ConvertToWide(fileExtension, fileExtensionW);
+	std::shared_ptr<Sky> newSky = std::make_shared<Sky>(textureState, skyTexture, importantSkyPixelShaders, importantSkyVertexShaders, device, context, request.name, request.bakedIBL);
 
-		newSkyTexture = CreateCubemap((skyDirWide + L"right" + fileExtensionW).c_str(),
-			(skyDirWide + L"left" + fileExtensionW).c_str(),
-			(skyDirWide + L"up" + fileExtensionW).c_str(),
-			(skyDirWide + L"down" + fileExtensionW).c_str(),
-			(skyDirWide + L"forward" + fileExtensionW).c_str(),
-			(skyDirWide + L"back" + fileExtensionW).c_str());
-	}
-	else {
-		// Process as a .dds
-
-		std::wstring skyDDSWide;
-		ISimpleShader::ConvertToWide(assetPath, skyDDSWide);
-
-		CreateDDSTextureFromFile(device.Get(), context.Get(), skyDDSWide.c_str(), nullptr, &newSkyTexture);
-	}
-
-	std::string filenameKey = SerializeFileName("Assets\\Textures\\Skies\\", assetPath);
-
-	std::shared_ptr<Sky> newSky = std::make_shared<Sky>(textureState, newSkyTexture, importantSkyPixelShaders, importantSkyVertexShaders, device, context, name);
-
-	newSky->SetFilenameKeyType(fileType);
+	newSky->SetFilenameKeyType(request.fileType);
 	newSky->SetFilenameKey(filenameKey);
-	newSky->SetFileExtension(fileExtension);
+	newSky->SetFileExtension(request.fileExtension);
 
 	skies.push_back(newSky);
 
@@ -759,7 +918,12 @@ std::shared_ptr<ParticleSystem> AssetManager::CreateParticleEmitterOnEntity(std:
 	std::shared_ptr<ParticleSystem> newEmitter = entityToEdit->AddComponent<ParticleSystem>();
 
 	newEmitter->SetIsMultiParticle(isMultiParticle);
-	newEmitter->SetParticleTextureSRV(LoadParticleTexture(textureNameToLoad, isMultiParticle));
+
+	// Draws the default particles until its first Draw starts loading the real ones
+	std::weak_ptr<ParticleSystem> weakEmitter = newEmitter;
+	newEmitter->SetTextureMaterializer([this, weakEmitter, textureNameToLoad, isMultiParticle]() {
+		MaterializeParticleTexture(weakEmitter, textureNameToLoad, isMultiParticle);
+	});
 
 	std::string asset = GetFullPathToAssetFile(AssetPathIndex::ASSET_PARTICLE_PATH, textureNameToLoad);
 
@@ -960,43 +1124,44 @@ void AssetManager::InitializeGameEntities() {
 }
 
 void AssetManager::InitializeTextures() {
-	CreateTexture("BlankAlbedo.png", "BlankTexture", ASSET_TEXTURE_PATH_PBR_ALBEDO);
-	CreateTexture("GenericRoughness100.png", "HighRoughness", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
-
-	CreateTexture("bronze_albedo.png", "BronzeAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
-	CreateTexture("bronze_normals.png", "BronzeNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
-	CreateTexture("bronze_metal.png", "BronzeMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
-	CreateTexture("bronze_roughness.png", "BronzeRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
-
-	CreateTexture("cobblestone_albedo.png", "CobbleAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
-	CreateTexture("cobblestone_normals.png", "CobbleNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
-	CreateTexture("cobblestone_metal.png", "CobbleMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
-	CreateTexture("cobblestone_roughness.png", "CobbleRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
-
-	CreateTexture("floor_albedo.png", "FloorAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
-	CreateTexture("floor_normals.png", "FloorNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
-	CreateTexture("floor_metal.png", "FloorMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
-	CreateTexture("floor_roughness.png", "FloorRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
-
-	CreateTexture("paint_albedo.png", "PaintAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
-	CreateTexture("paint_normals.png", "PaintNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
-	CreateTexture("paint_metal.png", "PaintMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
-	CreateTexture("paint_roughness.png", "PaintRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
-
-	CreateTexture("wood_albedo.png", "WoodAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
-	CreateTexture("wood_normals.png", "WoodNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
-	CreateTexture("wood_metal.png", "WoodMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
-	CreateTexture("wood_roughness.png", "WoodRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
-
-	CreateTexture("scratched_albedo.png", "ScratchAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
-	CreateTexture("scratched_normals.png", "ScratchNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
-	CreateTexture("scratched_metal.png", "ScratchMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
-	CreateTexture("scratched_roughness.png", "ScratchRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
-
-	CreateTexture("rough_albedo.png", "RoughAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
-	CreateTexture("rough_normals.png", "RoughNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
-	CreateTexture("rough_metal.png", "RoughMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
-	CreateTexture("rough_roughness.png", "RoughRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
+	// Loaded up front, every other texture stands in with it until first used
+	QueueTexture("BlankAlbedo.png", "BlankTexture", ASSET_TEXTURE_PATH_PBR_ALBEDO, false);
+	QueueTexture("GenericRoughness100.png", "HighRoughness", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
+
+	QueueTexture("bronze_albedo.png", "BronzeAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
+	QueueTexture("bronze_normals.png", "BronzeNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
+	QueueTexture("bronze_metal.png", "BronzeMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
+	QueueTexture("bronze_roughness.png", "BronzeRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
+
+	QueueTexture("cobblestone_albedo.png", "CobbleAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
+	QueueTexture("cobblestone_normals.png", "CobbleNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
+	QueueTexture("cobblestone_metal.png", "CobbleMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
+	QueueTexture("cobblestone_roughness.png", "CobbleRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
+
+	QueueTexture("floor_albedo.png", "FloorAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
+	QueueTexture("floor_normals.png", "FloorNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
+	QueueTexture("floor_metal.png", "FloorMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
+	QueueTexture("floor_roughness.png", "FloorRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
+
+	QueueTexture("paint_albedo.png", "PaintAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
+	QueueTexture("paint_normals.png", "PaintNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
+	QueueTexture("paint_metal.png", "PaintMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
+	QueueTexture("paint_roughness.png", "PaintRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
+
+	QueueTexture("wood_albedo.png", "WoodAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
+	QueueTexture("wood_normals.png", "WoodNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
+	QueueTexture("wood_metal.png", "WoodMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
+	QueueTexture("wood_roughness.png", "WoodRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
+
+	QueueTexture("scratched_albedo.png", "ScratchAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
+	QueueTexture("scratched_normals.png", "ScratchNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
+	QueueTexture("scratched_metal.png", "ScratchMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
+	QueueTexture("scratched_roughness.png", "ScratchRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
+
+	QueueTexture("rough_albedo.png", "RoughAlbedo", ASSET_TEXTURE_PATH_PBR_ALBEDO);
+	QueueTexture("rough_normals.png", "RoughNormals", ASSET_TEXTURE_PATH_PBR_NORMALS);
+	QueueTexture("rough_metal.png", "RoughMetal", ASSET_TEXTURE_PATH_PBR_METALNESS);
+	QueueTexture("rough_roughness.png", "RoughRough", ASSET_TEXTURE_PATH_PBR_ROUGHNESS);
 }
 
 void AssetManager::InitializeMaterials() {
@@ -1123,25 +1288,26 @@ void AssetManager::InitializeMeshes() {
 	// Test loading failure
 	//CreateMesh("ExceptionTest", "InvalidPath");
 
-	CreateMesh("Cube", "cube.obj");
-	CreateMesh("Sphere", "sphere.obj");
-	CreateMesh("Cylinder", "cylinder.obj");
-	//CreateMesh("Helix", "helix.obj");
-	//CreateMesh("Torus", "torus.obj");
+	// Loaded up front, every other mesh stands in with it until first used
+	QueueMesh("Cube", "cube.obj", false);
+	QueueMesh("Sphere", "sphere.obj");
+	QueueMesh("Cylinder", "cylinder.obj");
+	//QueueMesh("Helix", "helix.obj");
+	//QueueMesh("Torus", "torus.obj");
 }
 
 
 void AssetManager::InitializeSkies() {
 	// Temporarily, we only load 3 skies, as they take a while to load
 
-	//CreateSky(spaceTexture, "space");
-	CreateSky("SunnyCubeMap.dds", 0, "sunny");
-	//CreateSky(mountainTexture, "mountain");
-	//CreateSky("Niagara/", 1, "niagara", ".jpg");
+	//QueueSky(spaceTexture, "space");
+	QueueSky("SunnyCubeMap.dds", 0, "sunny");
+	//QueueSky(mountainTexture, "mountain");
+	//QueueSky("Niagara/", 1, "niagara", ".jpg");
 	// Default is .png, which this is
-	//CreateSky("Stars/", 1, "stars");
+	//QueueSky("Stars/", 1, "stars");
 
-	currentSky = skies[0];
+	// currentSky is set once the queue is created
 }
 
 void AssetManager::InitializeLights() {
@@ -1322,7 +1488,7 @@ void AssetManager::InitializeEmitters() {
 	ParticleSystem::SetDefaults(
 		GetPixelShaderByName("ParticlesPS"),
 		GetVertexShaderByName("ParticlesVS"),
-		LoadParticleTexture("Smoke/", true),
+		defaultParticleTextures.empty() ? LoadParticleTexture("Smoke/", true) : CreateTextureArrayFromDecoded(defaultParticleTextures),
 		GetComputeShaderByName("ParticleEmitCS"),
 		GetComputeShaderByName("ParticleMoveCS"),
 		GetComputeShaderByName("ParticleCopyCS"),
@@ -1330,6 +1496,8 @@ void AssetManager::InitializeEmitters() {
 		device,
 		context);
 
+	defaultParticleTextures.clear();
+
 	std::shared_ptr<ParticleSystem> basicEmitter = CreateParticleEmitter("basicParticle", "Smoke/smoke_01.png", 20, 1.0f, 1.0f);
 	basicEmitter->GetTransform()->SetPosition(XMFLOAT3(1.0f, 0.0f, 0.0f));
 	basicEmitter->SetEnabled(false);
@@ -1364,15 +1532,15 @@ void AssetManager::InitializeEmitters() {
 void AssetManager::InitializeAudio() {
 	audioInstance.Initialize();
 
-	CreateSound("PianoNotes/pinkyfinger__piano-a.wav", FMOD_DEFAULT, "piano-a");
-	CreateSound("PianoNotes/pinkyfinger__piano-b.wav", FMOD_DEFAULT, "piano-b");
-	CreateSound("PianoNotes/pinkyfinger__piano-bb.wav", FMOD_DEFAULT, "piano-bb");
-	CreateSound("PianoNotes/pinkyfinger__piano-c.wav", FMOD_DEFAULT, "piano-c");
-	CreateSound("PianoNotes/pinkyfinger__piano-e.wav", FMOD_DEFAULT, "piano-e");
-	CreateSound("PianoNotes/pinkyfinger__piano-eb.wav", FMOD_DEFAULT, "piano-eb");
-	CreateSound("PianoNotes/pinkyfinger__piano-d.wav", FMOD_DEFAULT, "piano-d");
-	CreateSound("PianoNotes/pinkyfinger__piano-f.wav", FMOD_DEFAULT, "piano-f");
-	CreateSound("PianoNotes/pinkyfinger__piano-g.wav", FMOD_DEFAULT, "piano-g");
+	QueueSound("PianoNotes/pinkyfinger__piano-a.wav", FMOD_DEFAULT, "piano-a");
+	QueueSound("PianoNotes/pinkyfinger__piano-b.wav", FMOD_DEFAULT, "piano-b");
+	QueueSound("PianoNotes/pinkyfinger__piano-bb.wav", FMOD_DEFAULT, "piano-bb");
+	QueueSound("PianoNotes/pinkyfinger__piano-c.wav", FMOD_DEFAULT, "piano-c");
+	QueueSound("PianoNotes/pinkyfinger__piano-e.wav", FMOD_DEFAULT, "piano-e");
+	QueueSound("PianoNotes/pinkyfinger__piano-eb.wav", FMOD_DEFAULT, "piano-eb");
+	QueueSound("PianoNotes/pinkyfinger__piano-d.wav", FMOD_DEFAULT, "piano-d");
+	QueueSound("PianoNotes/pinkyfinger__piano-f.wav", FMOD_DEFAULT, "piano-f");
+	QueueSound("PianoNotes/pinkyfinger__piano-g.wav", FMOD_DEFAULT, "piano-g");
 }
 
 void AssetManager::InitializeFonts() {
@@ -1410,760 +1578,3239 @@ void AssetManager::InitializeColliders() {
 }
 #pragma endregion
 
-#pragma region importMethods
+#pragma region loadQueues
+// Queue methods only record what to load. The Decode/Load methods are worker
+// stages of the Initialize load graph and write only into their own queue
+// entries. The Create/Register methods run on the main thread afterwards.
 
-void AssetManager::ImportTexture() {
-	char filename[MAX_PATH];
-	OPENFILENAME ofn;
+void AssetManager::QueueTexture(std::string nameToLoad, std::string textureName, AssetPathIndex assetPath, bool deferLoad) {
+	TextureLoadRequest request;
+	request.fullPath = GetFullPathToAssetFile(assetPath, nameToLoad);
+	request.nameToLoad = nameToLoad;
+	request.textureName = textureName;
+	request.assetPath = assetPath;
+	request.deferLoad = deferLoad;
+	request.result = E_PENDING;
 
-	ZeroMemory(&ofn, sizeof(ofn));
-	ZeroMemory(&filename, sizeof(filename));
-	ofn.lpstrFilter = _T("Image Files\0*.png;*.jpg;*.jpeg;\0Any File\0*.*\0");
-	ofn.lpstrTitle = _T("Select a texture file:");
-	ofn.lStructSize = sizeof(ofn);
-	ofn.hwndOwner = dxInstance->hWnd;
-	ofn.lpstrFile = filename;
-	ofn.nMaxFile = MAX_PATH;
-	ofn.Flags = OFN_DONTADDTORECENT | OFN_FILEMUSTEXIST;
+	textureLoadQueue.push_back(request);
+}
 
-	if (GetOpenFileName(&ofn)) {
-		CreateTexture(ofn.lpstrFile, "newTexture", ASSET_TEXTURE_PATH_BASIC, true);
-	}
+void AssetManager::QueueMesh(std::string id, std::string nameToLoad, bool deferLoad) {
+	MeshLoadRequest request;
+	request.fullPath = GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, nameToLoad);
+	request.id = id;
+	request.nameToLoad = nameToLoad;
+	request.deferLoad = deferLoad;
+	request.loaded = false;
+
+	meshLoadQueue.push_back(request);
 }
 
-void AssetManager::ImportSkyTexture() {
-	// unimplemented, requires some regex and stuff to deal with dds vs path
-	/*OPENFILENAME ofn;
-	ZeroMemory(&ofn, sizeof(ofn));
-	ofn.lpstrFilter = _T("Image Files\0*.png;*.jpg;*.jpeg;\0Any File\0*.*\0");
-	ofn.lpstrTitle = _T("Select a texture file:");
+void AssetManager::QueueSky(std::string filepath, bool fileType, std::string name, std::string fileExtension) {
+	SkyLoadRequest request;
+	request.fullPath = GetFullPathToAssetFile(AssetPathIndex::ASSET_TEXTURE_PATH_SKIES, filepath);
+	request.filepath = filepath;
+	request.fileType = fileType;
+	request.name = name;
+	request.fileExtension = fileExtension;
+	request.result = E_PENDING;
 
-	CreateSky(GetImportedFileString(&ofn), "newTexture", ASSET_TEXTURE_PATH_BASIC, true);*/
+	skyLoadQueue.push_back(request);
 }
 
-void AssetManager::ImportHeightMap() {
-	// unimplemented, heightmap is tied to terrain for now
-	/*OPENFILENAME ofn;
-	ZeroMemory(&ofn, sizeof(ofn));
-	ofn.lpstrFilter = _T("Heightmap Files\0*.raw;*.raw16;\0Any File\0*.*\0");
-	ofn.lpstrTitle = _T("Select a heightmap file:");
+void AssetManager::QueueSound(std::string path, FMOD_MODE mode, std::string name) {
+	SoundLoadRequest request;
+	request.fullPath = GetFullPathToAssetFile(AssetPathIndex::ASSET_SOUND_PATH, path);
+	request.mode = mode;
+	request.name = name;
+	request.sound = nullptr;
 
-	CreateTexture(GetImportedFileString(&ofn), "newTexture", ASSET_TEXTURE_PATH_BASIC, true);*/
+	soundLoadQueue.push_back(request);
 }
 
-void AssetManager::ImportSound() {
-	char filename[MAX_PATH];
-	OPENFILENAME ofn;
+void AssetManager::DecodeQueuedTextures(std::function<void()> itemLoaded) {
+	JobSystem::GetInstance().ParallelFor(textureLoadQueue.size(), 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			TextureLoadRequest& request = textureLoadQueue[i];
 
-	ZeroMemory(&ofn, sizeof(ofn));
-	ZeroMemory(&filename, sizeof(filename));
-	ofn.lpstrFilter = _T("Sound Files\0*.wav;*.mp3;*.ogg;\0Any File\0*.*\0");
-	ofn.lpstrTitle = _T("Select a Sound file:");
-	ofn.lStructSize = sizeof(ofn);
-	ofn.hwndOwner = dxInstance->hWnd;
-	ofn.lpstrFile = filename;
-	ofn.nMaxFile = MAX_PATH;
-	ofn.Flags = OFN_DONTADDTORECENT | OFN_FILEMUSTEXIST;
+			// Deferred textures aren't read until they're used
+			if (!request.deferLoad) {
+				request.cacheKey = GetTextureCacheKey(request.fullPath, textureCompressionPreset);
+				request.result = DecodeAndCompressTextureFile(request.fullPath, textureCompressionPreset, &request.decodedTexture);
+			}
 
-	if (GetOpenFileName(&ofn)) {
-		CreateSound(ofn.lpstrFile, FMOD_DEFAULT, "newSound", true);
-	}
+			if (itemLoaded) itemLoaded();
+		}
+	});
 }
 
-void AssetManager::ImportFont() {
-	char filename[MAX_PATH];
-	OPENFILENAME ofn;
+void AssetManager::DecodeQueuedMeshes(std::function<void()> itemLoaded) {
+	JobSystem::GetInstance().ParallelFor(meshLoadQueue.size(), 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			MeshLoadRequest& request = meshLoadQueue[i];
 
-	ZeroMemory(&ofn, sizeof(ofn));
-	ZeroMemory(&filename, sizeof(filename));
-	ofn.lpstrFilter = _T("Spritefont Files\0*.spritefont;\0Any File\0*.*\0");
-	ofn.lpstrTitle = _T("Select a font file:");
-	ofn.lStructSize = sizeof(ofn);
-	ofn.hwndOwner = dxInstance->hWnd;
-	ofn.lpstrFile = filename;
-	ofn.nMaxFile = MAX_PATH;
-	ofn.Flags = OFN_DONTADDTORECENT | OFN_FILEMUSTEXIST;
+			// Deferred meshes aren't read until they're used
+			if (!request.deferLoad) {
+				request.cacheKey = GetContentCacheKey(ASSET_CACHE_MESH, { request.fullPath });
+				DecodeMeshRequest(request);
+			}
 
-	if (GetOpenFileName(&ofn)) {
-		CreateSHOEFont("newFont", ofn.lpstrFile, false, true);
-	}
+			if (itemLoaded) itemLoaded();
+		}
+	});
 }
 
-void AssetManager::ImportMesh() {
-	char filename[MAX_PATH];
-	OPENFILENAME ofn;
-
-	ZeroMemory(&ofn, sizeof(ofn));
-	ZeroMemory(&filename, sizeof(filename));
-	ofn.lpstrFilter = _T("Mesh or Model Files\0*.obj;\0Any File\0*.*\0");
-	ofn.lpstrTitle = _T("Select a mesh file:");
-	ofn.lStructSize = sizeof(ofn);
-	ofn.hwndOwner = dxInstance->hWnd;
-	ofn.lpstrFile = filename;
-	ofn.nMaxFile = MAX_PATH;
-	ofn.Flags = OFN_DONTADDTORECENT | OFN_FILEMUSTEXIST;
+void AssetManager::DecodeQueuedSkies(std::function<void()> itemLoaded) {
+	for (SkyLoadRequest& request : skyLoadQueue) {
+		HashSkyRequest(request);
+		DecodeSkyRequest(request);
 
-	if (GetOpenFileName(&ofn)) {
-		CreateMesh("NewMesh", ofn.lpstrFile, true);
+		if (itemLoaded) itemLoaded();
 	}
 }
 
-std::string AssetManager::GetImportedFileString(OPENFILENAME* file) {
-	
+void AssetManager::LoadQueuedSounds(std::function<void()> itemLoaded) {
+	// Every sample is read up front in one batch, so later files are read while earlier ones
+	// decode. Streams only ever read a bit at a time, so FMOD keeps opening those itself.
+	std::vector<std::string> samplePaths;
+	std::vector<size_t> sampleRequests;
+	for (size_t i = 0; i < soundLoadQueue.size(); i++) {
+		if (soundLoadQueue[i].mode & FMOD_CREATESTREAM) continue;
 
-	return "0";
-}
+		samplePaths.push_back(soundLoadQueue[i].fullPath);
+		sampleRequests.push_back(i);
+	}
 
-#pragma endregion
+	std::vector<std::future<AsyncReadResult>> sampleReads = AsyncFileReader::GetInstance().ReadBatch(samplePaths, ASYNC_READ_PRIORITY_NORMAL);
 
-#pragma region getMethods
-Microsoft::WRL::ComPtr<ID3D11InputLayout> AssetManager::GetInputLayout() {
-	return this->inputLayout;
-}
+	// FMOD's system object is thread safe, so sample data can
+	// be read and decoded here and registered on the main thread
+	size_t nextSample = 0;
+	for (size_t i = 0; i < soundLoadQueue.size(); i++) {
+		SoundLoadRequest& request = soundLoadQueue[i];
+		request.cacheKey = GetContentCacheKey(ASSET_CACHE_SOUND, { request.fullPath }, std::to_string(request.mode) + "|" + request.name);
 
-Microsoft::WRL::ComPtr<ID3D11Device> AssetManager::GetDevice() {
-	return this->device;
-}
+		if (nextSample < sampleRequests.size() && sampleRequests[nextSample] == i) {
+			AsyncReadResult sample = sampleReads[nextSample++].get();
+			request.sound = sample.succeeded ? audioInstance.LoadSoundFromMemory(sample.data.data(), sample.data.size(), request.mode) : nullptr;
+		}
+		else {
+			request.sound = audioInstance.LoadSound(request.fullPath, request.mode);
+		}
 
-Microsoft::WRL::ComPtr<ID3D11DeviceContext> AssetManager::GetContext() {
-	return this->context;
+		if (itemLoaded) itemLoaded();
+	}
 }
 
-size_t AssetManager::GetPixelShaderArraySize() {
-	return this->pixelShaders.size();
-}
+void AssetManager::CreateQueuedTextures() {
+	for (TextureLoadRequest& request : textureLoadQueue) {
+		if (request.deferLoad) continue;
 
-size_t AssetManager::GetVertexShaderArraySize() {
-	return this->vertexShaders.size();
-}
+		// Duplicates in the queue were decoded, but only the first gets uploaded
+		if (FindCachedTexture(request.cacheKey, request.nameToLoad, request.textureName, request.assetPath, false) != nullptr) continue;
 
-size_t AssetManager::GetComputeShaderArraySize() {
-	return this->computeShaders.size();
-}
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> coreTexture;
+		unsigned int streamingID = 0;
 
-size_t AssetManager::GetSkyArraySize() {
-	return this->skies.size();
-}
+		if (SUCCEEDED(request.result)) {
+			coreTexture = CreateStreamedTexture(request.decodedTexture, request.fullPath, textureCompressionPreset, &streamingID);
+		}
 
-size_t AssetManager::GetMeshArraySize() {
-	return this->globalMeshes.size();
-}
+		std::shared_ptr<Texture> newTexture = RegisterTexture(coreTexture, request.nameToLoad, request.textureName, request.assetPath, false);
+		newTexture->SetStreamingID(streamingID);
+		CacheTexture(request.cacheKey, newTexture, request.decodedTexture);
+	}
 
-size_t AssetManager::GetTextureArraySize() {
-	return this->globalTextures.size();
-}
+	// The placeholder was loaded up front above
+	std::shared_ptr<Texture> placeholder = GetTextureByName("BlankTexture");
+	for (TextureLoadRequest& request : textureLoadQueue) {
+		if (request.deferLoad) RegisterDeferredTexture(request, placeholder);
+	}
 
-size_t AssetManager::GetMaterialArraySize() {
-	return this->globalMaterials.size();
+	textureLoadQueue.clear();
 }
 
-size_t AssetManager::GetGameEntityArraySize() {
-	return this->globalEntities.size();
-}
+void AssetManager::CreateQueuedMeshes() {
+	for (MeshLoadRequest& request : meshLoadQueue) {
+		if (request.deferLoad) continue;
 
-size_t AssetManager::GetTerrainMaterialArraySize() {
-	return this->globalTerrainMaterials.size();
-}
+		std::shared_ptr<Mesh> newMesh = FindCachedMesh(request.cacheKey, request.id);
+		if (newMesh != nullptr) continue;
 
-size_t AssetManager::GetSoundArraySize() {
-	return this->globalSounds.size();
-}
+		if (request.meshFile) {
+			newMesh = std::make_shared<Mesh>(*request.meshFile, device, request.id);
+			newMesh->SetFileNameKey(SerializeFileName("Assets\\Models\\", request.fullPath));
 
-FMOD::Sound* AssetManager::GetSoundAtID(int id) {
-	return this->globalSounds[id];
-}
+			// Unmaps the file, the GPU and CPU copies are made by now
+			request.meshFile.reset();
+		}
+		else if (request.loaded) {
+			newMesh = std::make_shared<Mesh>(request.meshData, device, request.id);
+			newMesh->SetFileNameKey(SerializeFileName("Assets\\Models\\", request.fullPath));
+		}
+		else {
+			// Keeps the same (empty mesh) behaviour as a failed CreateMesh
+			newMesh = std::make_shared<Mesh>(request.fullPath, device, request.id);
+		}
 
-std::shared_ptr<Sky> AssetManager::GetSkyAtID(int id) {
-	return this->skies[id];
-}
+		globalMeshes.push_back(newMesh);
+		CacheMesh(request.cacheKey, newMesh);
+	}
 
-/// <summary>
-/// Broadcasts a message to all entities
-/// </summary>
-/// <param name="event">Message type to send</param>
-/// <param name="message">Body of the message, should one be needed</param>
-void AssetManager::BroadcastGlobalEntityEvent(EntityEventType event, std::shared_ptr<void> message)
-{
-	for (std::shared_ptr<GameEntity> entity : globalEntities) {
-		entity->PropagateEvent(event);
+	// The placeholder was loaded up front above
+	std::shared_ptr<Mesh> placeholder = GetMeshByName("Cube");
+	for (MeshLoadRequest& request : meshLoadQueue) {
+		if (request.deferLoad) RegisterDeferredMesh(request, placeholder);
 	}
+
+	meshLoadQueue.clear();
 }
 
-std::shared_ptr<Texture> AssetManager::GetTextureAtID(int id) {
-	return this->globalTextures[id];
+void AssetManager::CreateQueuedSkies() {
+	for (SkyLoadRequest& request : skyLoadQueue) {
+		CreateSkyFromRequest(request);
+	}
+
+	skyLoadQueue.clear();
+
+	if (skies.size() > 0) currentSky = skies[0];
+}
+
+void AssetManager::RegisterQueuedSounds() {
+	for (SoundLoadRequest& request : soundLoadQueue) {
+		CacheSound(request.cacheKey, RegisterSound(request.sound, request.fullPath, request.name), request.mode);
+	}
+
+	soundLoadQueue.clear();
+}
+#pragma endregion
+
+#pragma region deferredLoads
+// Deferred assets are registered right away, sharing a placeholder's GPU
+// resources so anything can reference them. The first real use starts a
+// decode on a JobSystem worker, and the upload and swap happen on the main
+// thread in RunMainThreadJobs. Until then the placeholder is drawn instead.
+
+std::shared_ptr<Texture> AssetManager::RegisterDeferredTexture(const TextureLoadRequest& request, std::shared_ptr<Texture> placeholder) {
+	std::shared_ptr<Texture> newTexture = RegisterTexture(placeholder != nullptr ? placeholder->GetTexture() : nullptr,
+		request.nameToLoad, request.textureName, request.assetPath, false);
+
+	std::weak_ptr<Texture> weakTexture = newTexture;
+	std::string fullPath = request.fullPath;
+	newTexture->SetMaterializer([this, weakTexture, fullPath]() { MaterializeTexture(weakTexture, fullPath); });
+
+	return newTexture;
+}
+
+std::shared_ptr<Mesh> AssetManager::RegisterDeferredMesh(const MeshLoadRequest& request, std::shared_ptr<Mesh> placeholder) {
+	std::shared_ptr<Mesh> newMesh;
+
+	if (placeholder == nullptr) {
+		// Nothing to stand in for it, so load it now
+		newMesh = std::make_shared<Mesh>(request.fullPath, device, request.id);
+		globalMeshes.push_back(newMesh);
+
+		return newMesh;
+	}
+
+	newMesh = std::make_shared<Mesh>(placeholder, request.id);
+	newMesh->SetFileNameKey(SerializeFileName("Assets\\Models\\", request.fullPath));
+
+	std::weak_ptr<Mesh> weakMesh = newMesh;
+	MeshLoadRequest meshRequest = request;
+	newMesh->SetMaterializer([this, weakMesh, meshRequest]() { MaterializeMesh(weakMesh, meshRequest); });
+
+	globalMeshes.push_back(newMesh);
+
+	return newMesh;
+}
+
+/// <summary>
+/// Loads a deferred texture in the background. If it fails to
+/// load, or is removed before it finishes, the placeholder stays.
+/// </summary>
+void AssetManager::MaterializeTexture(std::weak_ptr<Texture> texture, std::string fullPath) {
+	deferredLoadsInFlight++;
+
+	TexturePreset preset = textureCompressionPreset;
+	JobSystem::GetInstance().Schedule([this, texture, fullPath, preset]() {
+		std::shared_ptr<TextureLoadRequest> request = std::make_shared<TextureLoadRequest>();
+		request->cacheKey = GetTextureCacheKey(fullPath, preset);
+		request->result = DecodeAndCompressTextureFile(fullPath, preset, &request->decodedTexture);
+
+		JobSystem::GetInstance().QueueMainThreadJob([this, texture, request, fullPath, preset]() {
+			deferredLoadsInFlight--;
+
+			std::shared_ptr<Texture> loadedTexture = texture.lock();
+			if (loadedTexture == nullptr || FAILED(request->result)) return;
+
+			// Another texture may have loaded the same file in the meantime
+			AssetCacheEntry* cached = request->cacheKey.empty() ? nullptr : assetCache.Find(request->cacheKey);
+			if (cached != nullptr) {
+				loadedTexture->SetTexture(cached->textureView);
+				loadedTexture->SetStreamingID(cached->texture->GetStreamingID());
+				assetCache.AddReference(loadedTexture.get(), request->cacheKey);
+				return;
+			}
+
+			unsigned int streamingID = 0;
+			loadedTexture->SetTexture(CreateStreamedTexture(request->decodedTexture, fullPath, preset, &streamingID));
+			loadedTexture->SetStreamingID(streamingID);
+			CacheTexture(request->cacheKey, loadedTexture, request->decodedTexture);
+		});
+	});
+}
+
+/// <summary>
+/// Loads a deferred mesh in the background. If it fails to
+/// load, or is removed before it finishes, the placeholder stays.
+/// </summary>
+void AssetManager::MaterializeMesh(std::weak_ptr<Mesh> mesh, MeshLoadRequest request) {
+	deferredLoadsInFlight++;
+
+	std::shared_ptr<MeshLoadRequest> loadRequest = std::make_shared<MeshLoadRequest>(request);
+
+	JobSystem::GetInstance().Schedule([this, mesh, loadRequest]() {
+		loadRequest->cacheKey = GetContentCacheKey(ASSET_CACHE_MESH, { loadRequest->fullPath });
+		DecodeMeshRequest(*loadRequest);
+
+		JobSystem::GetInstance().QueueMainThreadJob([this, mesh, loadRequest]() {
+			deferredLoadsInFlight--;
+
+			std::shared_ptr<Mesh> loadedMesh = mesh.lock();
+			if (loadedMesh == nullptr || !loadRequest->loaded) return;
+
+			// Another mesh may have loaded the same file in the meantime
+			AssetCacheEntry* cached = loadRequest->cacheKey.empty() ? nullptr : assetCache.Find(loadRequest->cacheKey);
+			if (cached != nullptr) {
+				loadedMesh->SetMeshData(cached->mesh);
+				assetCache.AddReference(loadedMesh.get(), loadRequest->cacheKey);
+				return;
+			}
+
+			if (loadRequest->meshFile) {
+				loadedMesh->SetMeshData(*loadRequest->meshFile, device);
+
+				// Unmaps the file, the GPU and CPU copies are made by now
+				loadRequest->meshFile.reset();
+			}
+			else {
+				loadedMesh->SetMeshData(loadRequest->meshData, device);
+			}
+
+			CacheMesh(loadRequest->cacheKey, loadedMesh);
+		});
+	});
+}
+
+/// <summary>
+/// Loads an emitter's particle texture in the background. If it fails to
+/// load, or the emitter is removed before it finishes, the default stays.
+/// </summary>
+void AssetManager::MaterializeParticleTexture(std::weak_ptr<ParticleSystem> emitter, std::string textureNameToLoad, bool isMultiParticle) {
+	deferredLoadsInFlight++;
+
+	JobSystem::GetInstance().Schedule([this, emitter, textureNameToLoad, isMultiParticle]() {
+		std::shared_ptr<ParticleTextureLoadRequest> request =
+			std::make_shared<ParticleTextureLoadRequest>(MakeParticleTextureRequest(textureNameToLoad, isMultiParticle));
+		DecodeParticleTextureRequest(*request);
+
+		JobSystem::GetInstance().QueueMainThreadJob([this, emitter, request]() {
+			deferredLoadsInFlight--;
+
+			std::shared_ptr<ParticleSystem> loadedEmitter = emitter.lock();
+			if (loadedEmitter == nullptr) return;
+
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> particleTexture = FindCachedParticleTexture(request->cacheKey);
+			if (particleTexture == nullptr) particleTexture = CreateParticleTextureFromRequest(*request);
+
+			if (particleTexture != nullptr) loadedEmitter->SetParticleTextureSRV(particleTexture);
+		});
+	});
+}
+#pragma endregion
+
+#pragma region scenePreloads
+// A scene switch hashes the next scene's files on a worker, drops the ones
+// the cache already holds on the main thread, then decodes the rest on
+// workers. Only uploading and creating is left for the swap itself.
+
+void AssetManager::HashScenePreload(ScenePreload* preload) {
+	for (TextureLoadRequest& request : preload->textures) {
+		request.cacheKey = GetTextureCacheKey(request.fullPath, textureCompressionPreset);
+	}
+
+	for (MeshLoadRequest& request : preload->meshes) {
+		request.cacheKey = GetContentCacheKey(ASSET_CACHE_MESH, { request.fullPath });
+	}
+
+	for (SkyLoadRequest& request : preload->skies) {
+		HashSkyRequest(request);
+	}
+
+	for (SoundLoadRequest& request : preload->sounds) {
+		request.cacheKey = GetContentCacheKey(ASSET_CACHE_SOUND, { request.fullPath }, std::to_string(request.mode) + "|" + request.name);
+	}
+}
+
+size_t AssetManager::FilterScenePreload(ScenePreload* preload) {
+	size_t cachedCount = 0;
+	std::unordered_set<std::string> seenKeys;
+
+	// Files that couldn't be hashed, and repeats of a file, are left to
+	// the Create methods. Those would only have been read for nothing.
+	auto isLoaded = [&](const std::string& cacheKey) {
+		if (cacheKey.empty() || !seenKeys.insert(cacheKey).second) return true;
+		if (!assetCache.Contains(cacheKey)) return false;
+
+		cachedCount++;
+		return true;
+	};
+
+	preload->textures.erase(std::remove_if(preload->textures.begin(), preload->textures.end(),
+		[&](const TextureLoadRequest& request) { return isLoaded(request.cacheKey); }), preload->textures.end());
+
+	preload->meshes.erase(std::remove_if(preload->meshes.begin(), preload->meshes.end(),
+		[&](const MeshLoadRequest& request) { return isLoaded(request.cacheKey); }), preload->meshes.end());
+
+	preload->skies.erase(std::remove_if(preload->skies.begin(), preload->skies.end(),
+		[&](const SkyLoadRequest& request) { return isLoaded(request.cacheKey); }), preload->skies.end());
+
+	preload->sounds.erase(std::remove_if(preload->sounds.begin(), preload->sounds.end(),
+		[&](const SoundLoadRequest& request) { return isLoaded(request.cacheKey); }), preload->sounds.end());
+
+	return cachedCount;
+}
+
+void AssetManager::DecodeScenePreload(ScenePreload* preload) {
+	TexturePreset preset = textureCompressionPreset;
+	JobSystem::GetInstance().ParallelFor(preload->textures.size(), 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			TextureLoadRequest& request = preload->textures[i];
+			request.result = DecodeAndCompressTextureFile(request.fullPath, preset, &request.decodedTexture);
+		}
+	});
+
+	JobSystem::GetInstance().ParallelFor(preload->meshes.size(), 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			DecodeMeshRequest(preload->meshes[i]);
+		}
+	});
+
+	for (SkyLoadRequest& request : preload->skies) {
+		DecodeSkyRequest(request);
+	}
+
+	// FMOD's system object is thread safe, so sounds are opened here and registered during the swap
+	for (SoundLoadRequest& request : preload->sounds) {
+		request.sound = audioInstance.LoadSound(request.fullPath, request.mode);
+	}
+}
+
+void AssetManager::SetScenePreload(std::shared_ptr<ScenePreload> preload) {
+	scenePreload = preload;
+}
+
+void AssetManager::ReleaseScenePreload(std::shared_ptr<ScenePreload> preload) {
+	if (scenePreload == preload) scenePreload = nullptr;
+	if (preload == nullptr) return;
+
+	for (SoundLoadRequest& request : preload->sounds) {
+		if (request.sound != nullptr) request.sound->release();
+	}
+
+	// Unmaps mesh files and frees decoded pixels now, rather than whenever the last holder lets go
+	*preload = ScenePreload();
+}
+#pragma endregion
+
+#pragma region importMethods
+
+void AssetManager::ImportTexture() {
+	char filename[MAX_PATH];
+	OPENFILENAME ofn;
+
+	ZeroMemory(&ofn, sizeof(ofn));
+	ZeroMemory(&filename, sizeof(filename));
+	ofn.lpstrFilter = _T("Image Files\0*.png;*.jpg;*.jpeg;\0Any File\0*.*\0");
+	ofn.lpstrTitle = _T("Select a texture file:");
+	ofn.lStructSize = sizeof(ofn);
+	ofn.hwndOwner = dxInstance->hWnd;
+	ofn.lpstrFile = filename;
+	ofn.nMaxFile = MAX_PATH;
+	ofn.Flags = OFN_DONTADDTORECENT | OFN_FILEMUSTEXIST;
+
+	if (GetOpenFileName(&ofn)) {
+		CreateTexture(ofn.lpstrFile, "newTexture", ASSET_TEXTURE_PATH_BASIC, true);
+	}
+}
+
+void AssetManager::ImportSkyTexture() {
+	// unimplemented, requires some regex and stuff to deal with dds vs path
+	/*OPENFILENAME ofn;
+	ZeroMemory(&ofn, sizeof(ofn));
+	ofn.lpstrFilter = _T("Image Files\0*.png;*.jpg;*.jpeg;\0Any File\0*.*\0");
+	ofn.lpstrTitle = _T("Select a texture file:");
+
+	CreateSky(GetImportedFileString(&ofn), "newTexture", ASSET_TEXTURE_PATH_BASIC, true);*/
+}
+
+void AssetManager::ImportHeightMap() {
+	// unimplemented, heightmap is tied to terrain for now
+	/*OPENFILENAME ofn;
+	ZeroMemory(&ofn, sizeof(ofn));
+	ofn.lpstrFilter = _T("Heightmap Files\0*.raw;*.raw16;\0Any File\0*.*\0");
+	ofn.lpstrTitle = _T("Select a heightmap file:");
+
+	CreateTexture(GetImportedFileString(&ofn), "newTexture", ASSET_TEXTURE_PATH_BASIC, true);*/
+}
+
+void AssetManager::ImportSound() {
+	char filename[MAX_PATH];
+	OPENFILENAME ofn;
+
+	ZeroMemory(&ofn, sizeof(ofn));
+	ZeroMemory(&filename, sizeof(filename));
+	ofn.lpstrFilter = _T("Sound Files\0*.wav;*.mp3;*.ogg;\0Any File\0*.*\0");
+	ofn.lpstrTitle = _T("Select a Sound file:");
+	ofn.lStructSize = sizeof(ofn);
+	ofn.hwndOwner = dxInstance->hWnd;
+	ofn.lpstrFile = filename;
+	ofn.nMaxFile = MAX_PATH;
+	ofn.Flags = OFN_DONTADDTORECENT | OFN_FILEMUSTEXIST;
+
+	if (GetOpenFileName(&ofn)) {
+		CreateSound(ofn.lpstrFile, FMOD_DEFAULT, "newSound", true);
+	}
+}
+
+void AssetManager::ImportFont() {
+	char filename[MAX_PATH];
+	OPENFILENAME ofn;
+
+	ZeroMemory(&ofn, sizeof(ofn));
+	ZeroMemory(&filename, sizeof(filename));
+	ofn.lpstrFilter = _T("Spritefont Files\0*.spritefont;\0Any File\0*.*\0");
+	ofn.lpstrTitle = _T("Select a font file:");
+	ofn.lStructSize = sizeof(ofn);
+	ofn.hwndOwner = dxInstance->hWnd;
+	ofn.lpstrFile = filename;
+	ofn.nMaxFile = MAX_PATH;
+	ofn.Flags = OFN_DONTADDTORECENT | OFN_FILEMUSTEXIST;
+
+	if (GetOpenFileName(&ofn)) {
+		CreateSHOEFont("newFont", ofn.lpstrFile, false, true);
+	}
+}
+
+void AssetManager::ImportMesh() {
+	char filename[MAX_PATH];
+	OPENFILENAME ofn;
+
+	ZeroMemory(&ofn, sizeof(ofn));
+	ZeroMemory(&filename, sizeof(filename));
+	ofn.lpstrFilter = _T("Mesh or Model Files\0*.obj;\0Any File\0*.*\0");
+	ofn.lpstrTitle = _T("Select a mesh file:");
+	ofn.lStructSize = sizeof(ofn);
+	ofn.hwndOwner = dxInstance->hWnd;
+	ofn.lpstrFile = filename;
+	ofn.nMaxFile = MAX_PATH;
+	ofn.Flags = OFN_DONTADDTORECENT | OFN_FILEMUSTEXIST;
+
+	if (GetOpenFileName(&ofn)) {
+		CreateMesh("NewMesh", ofn.lpstrFile, true);
+	}
+}
+
+std::string AssetManager::GetImportedFileString(OPENFILENAME* file) {
+	
+
+	return "0";
+}
+
+#pragma endregion
+
+#pragma region getMethods
+Microsoft::WRL::ComPtr<ID3D11InputLayout> AssetManager::GetInputLayout() {
+	return this->inputLayout;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Device> AssetManager::GetDevice() {
+	return this->device;
+}
+
+Microsoft::WRL::ComPtr<ID3D11DeviceContext> AssetManager::GetContext() {
+	return this->context;
+}
+
+size_t AssetManager::GetPixelShaderArraySize() {
+	return this->pixelShaders.size();
+}
+
+size_t AssetManager::GetVertexShaderArraySize() {
+	return this->vertexShaders.size();
+}
+
+size_t AssetManager::GetComputeShaderArraySize() {
+	return this->computeShaders.size();
+}
+
+size_t AssetManager::GetSkyArraySize() {
+	return this->skies.size();
+}
+
+size_t AssetManager::GetMeshArraySize() {
+	return this->globalMeshes.size();
+}
+
+size_t AssetManager::GetTextureArraySize() {
+	return this->globalTextures.size();
+}
+
+size_t AssetManager::GetMaterialArraySize() {
+	return this->globalMaterials.size();
+}
+
+size_t AssetManager::GetGameEntityArraySize() {
+	return this->globalEntities.size();
+}
+
+size_t AssetManager::GetTerrainMaterialArraySize() {
+	return this->globalTerrainMaterials.size();
+}
+
+size_t AssetManager::GetSoundArraySize() {
+	return this->globalSounds.size();
+}
+
+AssetCacheStats AssetManager::GetAssetCacheStats() {
+	return assetCache.GetStats();
+}
+
+IBLCacheStats AssetManager::GetIBLCacheStats() {
+	return IBLCacheFile::GetStats();
+}
+
+ShaderReflectionCacheStats AssetManager::GetShaderReflectionCacheStats() {
+	return ShaderReflectionFile::GetStats();
+}
+
+/// <summary>
+/// Counts assets that are still placeholders because nothing has used them yet
+/// </summary>
+size_t AssetManager::GetDeferredAssetCount() {
+	size_t count = 0;
+
+	for (std::shared_ptr<Texture> texture : globalTextures) {
+		if (texture->IsLoadDeferred()) count++;
+	}
+
+	for (std::shared_ptr<Mesh> mesh : globalMeshes) {
+		if (mesh->IsLoadDeferred()) count++;
+	}
+
+	for (std::shared_ptr<ParticleSystem> emitter : ComponentManager::GetAll<ParticleSystem>()) {
+		if (emitter->IsTextureLoadDeferred()) count++;
+	}
+
+	return count;
+}
+
+size_t AssetManager::GetDeferredLoadsInFlight() {
+	return deferredLoadsInFlight;
+}
+
+FMOD::Sound* AssetManager::GetSoundAtID(int id) {
+	return this->globalSounds[id];
+}
+
+std::shared_ptr<Sky> AssetManager::GetSkyAtID(int id) {
+	return this->skies[id];
+}
+
+/// <summary>
+/// Broadcasts a message to all entities
+/// </summary>
+/// <param name="event">Message type to send</param>
+/// <param name="message">Body of the message, should one be needed</param>
+void AssetManager::BroadcastGlobalEntityEvent(EntityEventType event, std::shared_ptr<void> message)
+{
+	for (std::shared_ptr<GameEntity> entity : globalEntities) {
+		entity->PropagateEvent(event);
+	}
+}
+
+std::shared_ptr<Texture> AssetManager::GetTextureAtID(int id) {
+	return this->globalTextures[id];
 }
 
 std::shared_ptr<Material> AssetManager::GetMaterialAtID(int id) {
 	return this->globalMaterials[id];
 }
 
-std::shared_ptr<Mesh> AssetManager::GetMeshAtID(int id) {
-	return this->globalMeshes[id];
+std::shared_ptr<Mesh> AssetManager::GetMeshAtID(int id) {
+	return this->globalMeshes[id];
+}
+
+std::shared_ptr<SimpleVertexShader> AssetManager::GetVertexShaderAtID(int id) {
+	return this->vertexShaders[id];
+}
+
+std::shared_ptr<SimplePixelShader> AssetManager::GetPixelShaderAtID(int id) {
+	return this->pixelShaders[id];
+}
+
+std::shared_ptr<SimpleComputeShader> AssetManager::GetComputeShaderAtID(int id) {
+	return this->computeShaders[id];
+}
+
+std::shared_ptr<GameEntity> AssetManager::GetGameEntityAtID(int id) {
+	return this->globalEntities[id];
+}
+
+std::shared_ptr<TerrainMaterial> AssetManager::GetTerrainMaterialAtID(int id) {
+	return this->globalTerrainMaterials[id];
+}
+
+std::shared_ptr<Camera> AssetManager::GetMainCamera() {
+	if (mainCamera != nullptr)
+		return mainCamera;
+	return editingCamera;
+}
+
+void AssetManager::SetMainCamera(std::shared_ptr<Camera> newMain)
+{
+	mainCamera = newMain;
+	//mainCamera->SetAspectRatio((float)windowWidth / (float)this->height);
+}
+
+std::shared_ptr<Camera> AssetManager::GetEditingCamera() {
+	return editingCamera;
+}
+
+void AssetManager::UpdateEditingCamera()
+{
+	editingCamera->GetGameEntity()->PropagateEvent(EntityEventType::Update);
+}
+
+#pragma region buildAssetData
+std::shared_ptr<Mesh> AssetManager::LoadTerrain(const char* filename, unsigned int mapWidth, unsigned int mapHeight, float heightScale) {
+	MeshLoadRequest request;
+	request.fullPath = GetFullPathToAssetFile(AssetPathIndex::ASSET_HEIGHTMAP_PATH, filename);
+	request.deferLoad = false;
+
+	MeshFileTerrain settings = {};
+	settings.mapWidth = mapWidth;
+	settings.mapHeight = mapHeight;
+	settings.heightScale = heightScale;
+
+	DecodeTerrainRequest(request, settings);
+	if (!request.loaded) return nullptr;
+
+	std::shared_ptr<Mesh> finalTerrain;
+	if (request.meshFile) {
+		finalTerrain = std::make_shared<Mesh>(*request.meshFile, device, "TerrainMesh");
+	}
+	else {
+		finalTerrain = std::make_shared<Mesh>(request.meshData, device, "TerrainMesh");
+	}
+
+	finalTerrain->SetFileNameKey(SerializeFileName("Assets\\HeightMaps\\", request.fullPath));
+	globalMeshes.push_back(finalTerrain);
+	Terrain::SetDefaults(finalTerrain, globalTerrainMaterials[0]);
+
+	TerrainSource source;
+	source.mesh = finalTerrain;
+	source.fullPath = request.fullPath;
+	source.settings = settings;
+	terrainSources.push_back(source);
+
+	return finalTerrain;
+}
+
+/// <summary>
+/// Does the file work for a terrain: maps the cooked terrain if it was built
+/// with the same settings, otherwise builds it from the heightmap.
+/// Safe to call from a JobSystem worker.
+/// </summary>
+void AssetManager::DecodeTerrainRequest(MeshLoadRequest& request, const MeshFileTerrain& settings) {
+	// A cooked terrain is only usable if it was built with the same settings
+	request.meshFile = std::make_shared<MeshFileView>();
+	if (OpenCookedMesh(request.fullPath, request.meshFile.get())) {
+		const MeshFileTerrain* terrainSettings = request.meshFile->GetTerrain();
+		request.loaded = terrainSettings != nullptr &&
+			terrainSettings->mapWidth == settings.mapWidth &&
+			terrainSettings->mapHeight == settings.mapHeight &&
+			terrainSettings->heightScale == settings.heightScale;
+		if (request.loaded) return;
+	}
+
+	request.meshFile.reset();
+
+	std::vector<unsigned short> heights;
+	request.loaded = MeshBuilder::LoadHeightmap(request.fullPath, settings.mapWidth, settings.mapHeight, &heights);
+	if (!request.loaded) return;
+
+	// Built the same way the cooker builds it
+	std::vector<MeshFileVertex> terrainVertices;
+	MeshData& data = request.meshData;
+	MeshBuilder::BuildTerrain(heights.data(), settings.mapWidth, settings.mapHeight, settings.heightScale, &terrainVertices, &data.indices);
+
+	data.vertices.resize(terrainVertices.size());
+	memcpy(data.vertices.data(), terrainVertices.data(), data.vertices.size() * sizeof(Vertex));
+
+	Mesh::CalculateTangents(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size());
+}
+
+/// <summary>
+/// Decodes an image file into 8-bit RGBA pixels with WIC. Doesn't touch the
+/// device, so it's safe to call from JobSystem workers (which initialize COM).
+/// A cooked version of the image is used instead when there's one newer than the image.
+/// </summary>
+/// <param name="fullPath">Full path to the image</param>
+/// <param name="decodedTexture">Filled with the decoded pixels</param>
+/// <returns>The first failing HRESULT, or S_OK</returns>
+HRESULT AssetManager::DecodeTextureFile(std::string fullPath, OUT DecodedTexture* decodedTexture) {
+	std::string cookedPath = GetCookedAssetPath(fullPath, TEXTURE_FILE_EXTENSION);
+	if (IsCookedFileCurrent(cookedPath, { fullPath }) && DecodeCookedTexture(cookedPath, 1, decodedTexture)) return S_OK;
+
+	// WIC decodes lazily, so the file stays open until the pixels are copied out
+	VirtualFile file;
+	if (!file.Open(fullPath)) return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+	// Factories are cheap next to the decode itself, and making one
+	// per call avoids sharing COM objects between worker threads
+	Microsoft::WRL::ComPtr<IWICImagingFactory> factory;
+	HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(factory.GetAddressOf()));
+	if (FAILED(hr)) return hr;
+
+	Microsoft::WRL::ComPtr<IWICStream> stream;
+	hr = factory->CreateStream(stream.GetAddressOf());
+	if (FAILED(hr)) return hr;
+
+	hr = stream->InitializeFromMemory(const_cast<BYTE*>(file.GetData()), (DWORD)file.GetSize());
+	if (FAILED(hr)) return hr;
+
+	Microsoft::WRL::ComPtr<IWICBitmapDecoder> decoder;
+	hr = factory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, decoder.GetAddressOf());
+	if (FAILED(hr)) return hr;
+
+	Microsoft::WRL::ComPtr<IWICBitmapFrameDecode> frame;
+	hr = decoder->GetFrame(0, frame.GetAddressOf());
+	if (FAILED(hr)) return hr;
+
+	UINT width, height;
+	hr = frame->GetSize(&width, &height);
+	if (FAILED(hr)) return hr;
+
+	// Match WICTextureLoader's default sRGB handling, so textures
+	// look the same as they did when it created them directly
+	decodedTexture->sRGB = false;
+	GUID containerFormat;
+	Microsoft::WRL::ComPtr<IWICMetadataQueryReader> metadataReader;
+	if (SUCCEEDED(decoder->GetContainerFormat(&containerFormat)) &&
+		SUCCEEDED(frame->GetMetadataQueryReader(metadataReader.GetAddressOf()))) {
+		PROPVARIANT value;
+		PropVariantInit(&value);
+
+		if (containerFormat == GUID_ContainerFormatPng) {
+			// Presence of the sRGB chunk is all that matters
+			if (SUCCEEDED(metadataReader->GetMetadataByName(L"/sRGB/RenderingIntent", &value)) && value.vt == VT_UI1) {
+				decodedTexture->sRGB = true;
+			}
+		}
+		else if (SUCCEEDED(metadataReader->GetMetadataByName(L"System.Image.ColorSpace", &value)) && value.vt == VT_UI2 && value.uiVal == 1) {
+			decodedTexture->sRGB = true;
+		}
+
+		PropVariantClear(&value);
+	}
+
+	Microsoft::WRL::ComPtr<IWICFormatConverter> converter;
+	hr = factory->CreateFormatConverter(converter.GetAddressOf());
+	if (FAILED(hr)) return hr;
+
+	hr = converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeMedianCut);
+	if (FAILED(hr)) return hr;
+
+	decodedTexture->width = width;
+	decodedTexture->height = height;
+	decodedTexture->mipLevels = 1;
+	decodedTexture->pixels.resize((size_t)width * height * 4);
+
+	return converter->CopyPixels(nullptr, width * 4, (UINT)decodedTexture->pixels.size(), decodedTexture->pixels.data());
+}
+
+/// <summary>
+/// Decodes an image like DecodeTextureFile, then builds its mips and block
+/// compresses it on the CPU if it wasn't cooked. Mip filtering and the
+/// format follow what the texture's folder says it holds.
+/// </summary>
+/// <param name="preset">TEXTURE_PRESET_UNCOMPRESSED leaves mips to the GPU, like before</param>
+HRESULT AssetManager::DecodeAndCompressTextureFile(std::string fullPath, TexturePreset preset, OUT DecodedTexture* decodedTexture) {
+	HRESULT hr = DecodeTextureFile(fullPath, decodedTexture);
+
+	// Cooked textures already have their mips
+	if (FAILED(hr) || preset == TEXTURE_PRESET_UNCOMPRESSED || decodedTexture->mipLevels > 1 || decodedTexture->format != TEXTURE_FORMAT_RGBA8) return hr;
+
+	TextureFileImage image;
+	image.width = decodedTexture->width;
+	image.height = decodedTexture->height;
+	image.pixels = std::move(decodedTexture->pixels);
+
+	std::vector<TextureFileImage> mips;
+	decodedTexture->format = TextureCompressor::Process(image, TextureCompressor::GetUsageForPath(fullPath), decodedTexture->sRGB, preset, &mips);
+	decodedTexture->mipLevels = (unsigned int)mips.size();
+	decodedTexture->pixels.clear();
+	for (const TextureFileImage& mip : mips) {
+		decodedTexture->pixels.insert(decodedTexture->pixels.end(), mip.pixels.begin(), mip.pixels.end());
+	}
+
+	return hr;
+}
+
+/// <summary>
+/// Copies a cooked .stex file's slices, with their whole mip chains, into decoded textures
+/// </summary>
+/// <param name="sliceCount">1 for a plain texture, 6 for a cube map</param>
+/// <returns>False if there's no valid cooked file with that many slices</returns>
+bool AssetManager::DecodeCookedTexture(std::string cookedPath, unsigned int sliceCount, OUT DecodedTexture* decodedTextures) {
+	TextureFileView textureFile;
+	if (!textureFile.Open(cookedPath)) return false;
+
+	const TextureFileHeader* header = textureFile.GetHeader();
+	bool isCubemap = (header->flags & TEXTURE_FLAG_CUBEMAP) != 0;
+	if (header->arraySize != sliceCount || isCubemap != (sliceCount == 6)) return false;
+
+	for (unsigned int slice = 0; slice < sliceCount; slice++) {
+		DecodedTexture& decodedTexture = decodedTextures[slice];
+		decodedTexture.width = header->width;
+		decodedTexture.height = header->height;
+		decodedTexture.mipLevels = header->mipCount;
+		decodedTexture.sRGB = (header->flags & TEXTURE_FLAG_SRGB) != 0;
+		decodedTexture.format = (TextureFileFormat)header->format;
+		decodedTexture.pixels.clear();
+
+		// Rows are packed in the file, so each mip copies over in one go
+		for (unsigned int mip = 0; mip < header->mipCount; mip++) {
+			const TextureFileSubresource* subresource = textureFile.GetSubresource(mip, slice);
+			const uint8_t* data = textureFile.GetSubresourceData(mip, slice);
+			size_t rowCount = TextureFile::GetRowCount(header->format, subresource->height);
+			decodedTexture.pixels.insert(decodedTexture.pixels.end(), data, data + (size_t)subresource->rowPitch * rowCount);
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Gets where the asset cooker would have put the cooked version of an asset:
+/// the same path under the Cooked folder instead of Assets, with the cooked extension added.
+/// </summary>
+/// <param name="fullPath">Full path to the source asset, or to a sky's folder</param>
+/// <returns>Path to the cooked file, or an empty string if the asset isn't under Assets</returns>
+std::string AssetManager::GetCookedAssetPath(std::string fullPath, std::string cookedExtension) {
+	std::replace(fullPath.begin(), fullPath.end(), '/', '\\');
+
+	size_t assetFolder = fullPath.rfind("\\Assets\\");
+	if (assetFolder == std::string::npos) return "";
+
+	// Sky folders are cooked into a single file named after the folder
+	while (!fullPath.empty() && fullPath.back() == '\\') fullPath.pop_back();
+
+	return fullPath.substr(0, assetFolder) + "\\Cooked\\" + fullPath.substr(assetFolder + strlen("\\Assets\\")) + cookedExtension;
+}
+
+/// <summary>
+/// Maps the cooked version of a mesh or heightmap, if it was built from the
+/// source file as it is now. The cooker stamps each .smesh with its source,
+/// the same way the runtime mesh cache does. Without a source to compare
+/// against, the cooked file is all there is, so it's used as-is.
+/// </summary>
+/// <returns>False if there's no cooked file, or it's out of date</returns>
+bool AssetManager::OpenCookedMesh(const std::string& fullPath, MeshFileView* meshFile) {
+	MeshFileSourceStamp source;
+	bool hasSource = MeshFile::GetSourceStamp(fullPath, &source);
+
+	return meshFile->Open(GetCookedAssetPath(fullPath, MESH_FILE_EXTENSION), sizeof(Vertex), hasSource ? &source : nullptr);
+}
+
+/// <summary>
+/// Whether a cooked texture was written after every source it was made from.
+/// Texture files don't carry source stamps like meshes do, so an image edited
+/// since it was cooked (including one being hot reloaded) is decoded from
+/// the source instead. Sources that aren't there don't count against it.
+/// </summary>
+bool AssetManager::IsCookedFileCurrent(const std::string& cookedPath, const std::vector<std::string>& sourcePaths) {
+	VirtualFileSystem& vfs = VirtualFileSystem::GetInstance();
+
+	VirtualFileInfo cookedInfo;
+	if (cookedPath.empty() || !vfs.GetFileInfo(cookedPath, &cookedInfo)) return false;
+
+	for (const std::string& sourcePath : sourcePaths) {
+		VirtualFileInfo sourceInfo;
+		if (vfs.GetFileInfo(sourcePath, &sourceInfo) && sourceInfo.modifiedTime > cookedInfo.modifiedTime) return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Decodes a list of image files across the job system.
+/// Failed files are left as empty DecodedTextures.
+/// </summary>
+void AssetManager::DecodeTextureFiles(const std::vector<std::string>& fullPaths, OUT std::vector<DecodedTexture>* decodedTextures, std::function<void()> itemLoaded) {
+	decodedTextures->clear();
+	decodedTextures->resize(fullPaths.size());
+
+	JobSystem::GetInstance().ParallelFor(fullPaths.size(), 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			if (FAILED(DecodeTextureFile(fullPaths[i], &(*decodedTextures)[i]))) {
+				(*decodedTextures)[i] = DecodedTexture();
+			}
+
+			if (itemLoaded) itemLoaded();
+		}
+	});
+}
+
+/// <summary>
+/// Reads a whole file into memory
+/// </summary>
+/// <returns>False if the file couldn't be opened or read</returns>
+bool AssetManager::ReadFileBytes(std::string fullPath, OUT std::vector<char>* fileData) {
+	return VirtualFileSystem::GetInstance().ReadWholeFile(fullPath, fileData);
+}
+
+/// <summary>
+/// Does the file work for a mesh: maps a cooked or cached .smesh if there's
+/// an up to date one, otherwise parses the source and writes the cache.
+/// Safe to call from a JobSystem worker.
+/// </summary>
+void AssetManager::DecodeMeshRequest(MeshLoadRequest& request) {
+	request.meshFile = std::make_shared<MeshFileView>();
+	request.loaded = OpenCookedMesh(request.fullPath, request.meshFile.get());
+	if (request.loaded) return;
+
+	request.meshFile.reset();
+
+	MeshFileSourceStamp source;
+	bool hasSource = MeshFile::GetSourceStamp(request.fullPath, &source);
+	if (hasSource) {
+		request.meshFile = std::make_shared<MeshFileView>();
+		request.loaded = request.meshFile->Open(MeshFile::GetCachePath(request.fullPath), sizeof(Vertex), &source);
+		if (request.loaded) return;
+
+		request.meshFile.reset();
+	}
+
+	request.loaded = Mesh::LoadOBJ(request.fullPath, request.meshData);
+
+	if (request.loaded) {
+		MeshData& data = request.meshData;
+		Mesh::CalculateTangents(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size());
+
+		// Still on a worker, so build the cache for next time here too
+		if (hasSource) Mesh::WriteMeshFile(MeshFile::GetCachePath(request.fullPath), data, source);
+	}
+}
+
+/// <summary>
+/// Does the file work for a sky: reads the .dds, or decodes all six faces.
+/// Safe to call from a JobSystem worker.
+/// </summary>
+void AssetManager::DecodeSkyRequest(SkyLoadRequest& request) {
+	if (request.fileType) {
+		// The cooker packs all six faces into one cube map file
+		std::string cookedPath = GetCookedAssetPath(request.fullPath, TEXTURE_FILE_EXTENSION);
+		if (IsCookedFileCurrent(cookedPath, GetSkyFacePaths(request)) && DecodeCookedTexture(cookedPath, 6, request.faces)) {
+			request.result = S_OK;
+			BakeSkyIBL(request);
+			return;
+		}
+
+		std::vector<DecodedTexture> faces;
+		DecodeTextureFiles(GetSkyFacePaths(request), &faces);
+
+		request.result = S_OK;
+		for (int i = 0; i < 6; i++) {
+			if (faces[i].pixels.empty()) request.result = E_FAIL;
+			request.faces[i] = std::move(faces[i]);
+		}
+	}
+	else {
+		request.result = ReadFileBytes(request.fullPath, &request.ddsFileData) ? S_OK : E_FAIL;
+	}
+
+	BakeSkyIBL(request);
+}
+
+/// <summary>
+/// Reads a decoded sky's IBL maps from the IBL cache, or bakes them on the
+/// CPU and caches them, so the Sky doesn't have to render them on the main
+/// thread. Each face's top mip is what gets baked.
+/// </summary>
+void AssetManager::BakeSkyIBL(SkyLoadRequest& request) {
+	if (FAILED(request.result)) return;
+
+	// .dds skies can only be cached once the shaders have rendered them, see CacheSkyIBL
+	std::shared_ptr<IBLBakedSky> cachedIBL = std::make_shared<IBLBakedSky>();
+	if (request.contentHash != 0 && IBLCacheFile::ReadSky(request.iblCachePath, request.contentHash, !request.fileType, cachedIBL.get())) {
+		request.bakedIBL = cachedIBL;
+		return;
+	}
+
+	if (!request.fileType) return;
+
+	const unsigned char* faces[6];
+	for (int i = 0; i < 6; i++) {
+		if (request.faces[i].width != request.faces[0].width || request.faces[i].height != request.faces[0].height) return;
+		faces[i] = request.faces[i].pixels.data();
+	}
+
+	std::shared_ptr<IBLBakedSky> bakedIBL = std::make_shared<IBLBakedSky>();
+	if (IBLBaker::BakeSky(faces, request.faces[0].width, request.faces[0].height, request.faces[0].sRGB, bakedIBL.get())) {
+		request.bakedIBL = bakedIBL;
+
+		if (request.contentHash != 0) IBLCacheFile::WriteSky(request.iblCachePath, request.contentHash, *bakedIBL);
+	}
+}
+
+/// <summary>
+/// Hashes a sky's source files, for its content cache key and IBL cache file
+/// </summary>
+void AssetManager::HashSkyRequest(SkyLoadRequest& request) {
+	std::vector<std::string> sourcePaths = request.fileType ? GetSkyFacePaths(request) : std::vector<std::string>{ request.fullPath };
+
+	request.cacheKey = "";
+	request.iblCachePath = "";
+	request.contentHash = 0;
+	if (!assetCache.GetContentHash(sourcePaths, &request.contentHash)) return;
+
+	request.cacheKey = AssetCache::MakeKey(ASSET_CACHE_SKY, request.contentHash, std::to_string(request.fileType));
+	request.iblCachePath = IBLCacheFile::GetCachePath(GetFullPathToAssetFile(AssetPathIndex::ASSET_TEXTURE_PATH_SKIES, IBL_CACHE_FOLDER),
+		IBL_CACHE_SKY, request.contentHash, !request.fileType);
+}
+
+/// <summary>
+/// Reads back the IBL maps the shaders rendered for a .dds sky and writes
+/// them to the IBL cache on a worker, so the next load can skip rendering them
+/// </summary>
+void AssetManager::CacheSkyIBL(const SkyLoadRequest& request, std::shared_ptr<Sky> sky) {
+	if (request.bakedIBL != nullptr || request.contentHash == 0 || sky->GetSkyTexture() == nullptr) return;
+
+	std::shared_ptr<IBLBakedSky> renderedIBL = std::make_shared<IBLBakedSky>();
+	if (!sky->ReadBackIBL(renderedIBL.get())) return;
+
+	std::string cachePath = request.iblCachePath;
+	uint64_t contentHash = request.contentHash;
+	JobSystem::GetInstance().Schedule([cachePath, contentHash, renderedIBL]() {
+		IBLCacheFile::WriteSky(cachePath, contentHash, *renderedIBL);
+	});
+}
+
+/// <summary>
+/// Paths of the six face images of a sky folder
+/// </summary>
+std::vector<std::string> AssetManager::GetSkyFacePaths(const SkyLoadRequest& request) {
+	// Order matters here! +X, -X, +Y, -Y, +Z, -Z
+	const char* faceNames[6] = { "right", "left", "up", "down", "forward", "back" };
+
+	std::vector<std::string> facePaths;
+	for (int i = 0; i < 6; i++) {
+		facePaths.push_back(request.fullPath + faceNames[i] + request.fileExtension);
+	}
+
+	return facePaths;
+}
+
+/// <summary>
+/// Creates a texture with a full mip chain from decoded pixels. Mips are generated
+/// on the GPU, the same way WICTextureLoader does when given a context, unless
+/// the texture was cooked or processed on the CPU with its mips already.
+/// </summary>
+/// <param name="firstMip">Mips before this one are left out, for textures that bring their own mips</param>
+/// <returns>SRV for the new texture, or null if creation failed</returns>
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::CreateTextureFromDecoded(const DecodedTexture& decodedTexture, unsigned int firstMip) {
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV;
+
+	if (decodedTexture.pixels.empty()) return textureSRV;
+
+	// Block compressed textures can't be render targets, so they always bring their mips
+	if (decodedTexture.mipLevels > 1 || decodedTexture.format != TEXTURE_FORMAT_RGBA8) {
+		firstMip = (std::min)(firstMip, decodedTexture.mipLevels - 1);
+
+		// Every mip goes up as initial data, so the texture can be immutable
+		std::vector<D3D11_SUBRESOURCE_DATA> mipData(decodedTexture.mipLevels - firstMip);
+		const unsigned char* mipPixels = decodedTexture.pixels.data();
+		for (unsigned int mip = 0; mip < decodedTexture.mipLevels; mip++) {
+			unsigned int mipWidth = (std::max)(1u, decodedTexture.width >> mip);
+			unsigned int mipHeight = (std::max)(1u, decodedTexture.height >> mip);
+			unsigned int rowPitch = TextureFile::GetRowPitch(decodedTexture.format, mipWidth);
+
+			if (mip >= firstMip) {
+				mipData[mip - firstMip].pSysMem = mipPixels;
+				mipData[mip - firstMip].SysMemPitch = rowPitch;
+			}
+			mipPixels += (size_t)rowPitch * TextureFile::GetRowCount(decodedTexture.format, mipHeight);
+		}
+
+		D3D11_TEXTURE2D_DESC mippedDesc = {};
+		mippedDesc.Width = (std::max)(1u, decodedTexture.width >> firstMip);
+		mippedDesc.Height = (std::max)(1u, decodedTexture.height >> firstMip);
+		mippedDesc.MipLevels = decodedTexture.mipLevels - firstMip;
+		mippedDesc.ArraySize = 1;
+		mippedDesc.Format = GetDecodedTextureFormat(decodedTexture);
+		mippedDesc.SampleDesc.Count = 1;
+		mippedDesc.SampleDesc.Quality = 0;
+		mippedDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		mippedDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> mippedTexture;
+		if (FAILED(device->CreateTexture2D(&mippedDesc, mipData.data(), mippedTexture.GetAddressOf()))) return textureSRV;
+
+		device->CreateShaderResourceView(mippedTexture.Get(), nullptr, textureSRV.GetAddressOf());
+		return textureSRV;
+	}
+
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = decodedTexture.width;
+	textureDesc.Height = decodedTexture.height;
+	textureDesc.MipLevels = 0; // Full chain
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = decodedTexture.sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	if (FAILED(device->CreateTexture2D(&textureDesc, nullptr, texture.GetAddressOf()))) return textureSRV;
+
+	context->UpdateSubresource(texture.Get(), 0, nullptr, decodedTexture.pixels.data(), decodedTexture.width * 4, (UINT)decodedTexture.pixels.size());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = textureDesc.Format;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = (UINT)-1;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+
+	if (FAILED(device->CreateShaderResourceView(texture.Get(), &srvDesc, textureSRV.GetAddressOf()))) return textureSRV;
+
+	context->GenerateMips(textureSRV.Get());
+
+	return textureSRV;
+}
+
+/// <summary>
+/// Creates a texture with only its mip tail resident, and starts streaming it.
+/// Textures too small to have anything past their tail are created whole.
+/// </summary>
+/// <param name="streamingID">Set to the texture's id in the streamer, or 0 if it isn't streamed</param>
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::CreateStreamedTexture(const DecodedTexture& decodedTexture, std::string fullPath, TexturePreset preset, OUT unsigned int* streamingID) {
+	*streamingID = 0;
+
+	unsigned int tailMip = TextureStreamer::GetTailMip(decodedTexture.width, decodedTexture.height, decodedTexture.mipLevels, decodedTexture.format);
+	if (decodedTexture.mipLevels <= 1 || tailMip == 0) return CreateTextureFromDecoded(decodedTexture);
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV = CreateTextureFromDecoded(decodedTexture, tailMip);
+	if (textureSRV == nullptr) return textureSRV;
+
+	*streamingID = textureStreamer.Register(decodedTexture.width, decodedTexture.height, decodedTexture.mipLevels, decodedTexture.format, tailMip);
+
+	StreamedTextureSource& source = streamedTextureSources[*streamingID];
+	source.fullPath = fullPath;
+	source.preset = preset;
+	source.textureView = textureSRV;
+
+	return textureSRV;
+}
+
+// --------------------------------------------------------
+// Creates a cube map from six decoded faces. The faces are
+// uploaded directly as the initial data of the cube's array
+// slices, so no temporary per-face textures are needed.
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::CreateCubemapFromDecoded(const DecodedTexture* faces)
+{
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeSRV;
+
+	// We'll assume all of the textures are the same color format and resolution,
+	// so get the description from the first face
+	// - Specifically NOT generating mipmaps, as we usually don't need them for the sky!
+	D3D11_TEXTURE2D_DESC cubeDesc = {};
+	cubeDesc.ArraySize = 6; // Cube map!
+	cubeDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE; // We'll be using as a texture in a shader
+	cubeDesc.CPUAccessFlags = 0; // No read back
+	cubeDesc.Format = faces[0].sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	cubeDesc.Width = faces[0].width; // Match the size
+	cubeDesc.Height = faces[0].height; // Match the size
+	cubeDesc.MipLevels = 1; // Only need 1
+	cubeDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE; // A CUBE MAP, not 6 separate textures
+	cubeDesc.Usage = D3D11_USAGE_DEFAULT; // Standard usage
+	cubeDesc.SampleDesc.Count = 1;
+	cubeDesc.SampleDesc.Quality = 0;
+
+	D3D11_SUBRESOURCE_DATA faceData[6] = {};
+	for (int i = 0; i < 6; i++) {
+		if (faces[i].width != faces[0].width || faces[i].height != faces[0].height || faces[i].format != TEXTURE_FORMAT_RGBA8) return cubeSRV;
+
+		faceData[i].pSysMem = faces[i].pixels.data();
+		faceData[i].SysMemPitch = faces[i].width * 4;
+	}
+
+	// Create the actual texture resource, faces and all
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> cubeMapTexture;
+	if (FAILED(device->CreateTexture2D(&cubeDesc, faceData, cubeMapTexture.GetAddressOf()))) return cubeSRV;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = cubeDesc.Format; // Same format as texture
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE; // Treat this as a cube!
+	srvDesc.TextureCube.MipLevels = 1; // Only need access to 1 mip
+	srvDesc.TextureCube.MostDetailedMip = 0; // Index of the first mip we want to see
+
+	device->CreateShaderResourceView(cubeMapTexture.Get(), &srvDesc, cubeSRV.GetAddressOf());
+
+	// Send back the SRV, which is what we need for our shaders
+	return cubeSRV;
+}
+
+/// <summary>
+/// Creates a Texture2DArray from decoded textures. Slices that failed
+/// to decode or don't match the first slice's size are left blank.
+/// </summary>
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::CreateTextureArrayFromDecoded(const std::vector<DecodedTexture>& decodedTextures)
+{
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> arraySRV;
+
+	if (decodedTextures.empty() || decodedTextures[0].format != TEXTURE_FORMAT_RGBA8) return arraySRV;
+
+	const DecodedTexture& first = decodedTextures[0];
+
+	D3D11_TEXTURE2D_DESC multiTextureDesc = {};
+	multiTextureDesc.ArraySize = (int)decodedTextures.size();
+	multiTextureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	multiTextureDesc.CPUAccessFlags = 0;
+	multiTextureDesc.Format = first.sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	multiTextureDesc.Width = first.width;
+	multiTextureDesc.Height = first.height;
+	multiTextureDesc.MipLevels = 1;
+	multiTextureDesc.Usage = D3D11_USAGE_DEFAULT;
+	multiTextureDesc.SampleDesc.Count = 1;
+	multiTextureDesc.SampleDesc.Quality = 0;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> outputTexture;
+	if (FAILED(device->CreateTexture2D(&multiTextureDesc, 0, outputTexture.GetAddressOf()))) return arraySRV;
+
+	for (int i = 0; i < (int)decodedTextures.size(); i++) {
+		const DecodedTexture& slice = decodedTextures[i];
+		if (slice.pixels.empty() || slice.width != first.width || slice.height != first.height || slice.format != TEXTURE_FORMAT_RGBA8) continue;
+
+		unsigned int subresource = D3D11CalcSubresource(0, i, 1);
+		context->UpdateSubresource(outputTexture.Get(), subresource, nullptr, slice.pixels.data(), slice.width * 4, 0);
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = multiTextureDesc.Format;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	srvDesc.Texture2DArray.MipLevels = 1;
+	srvDesc.Texture2DArray.ArraySize = (int)decodedTextures.size();
+
+	device->CreateShaderResourceView(outputTexture.Get(), &srvDesc, arraySRV.GetAddressOf());
+
+	return arraySRV;
+}
+
+/// <summary>
+/// Lists every file in a particle texture subfolder, recursively
+/// </summary>
+std::vector<std::string> AssetManager::GetParticleTexturePaths(std::string textureNameToLoad) {
+	std::vector<std::string> paths;
+	std::string assets = GetFullPathToAssetFile(AssetPathIndex::ASSET_PARTICLE_PATH, textureNameToLoad);
+
+	// Archives can hold particle folders too, so the listing goes through the VirtualFileSystem
+	VirtualFileSystem::GetInstance().ListFiles(assets, true, &paths);
+
+	return paths;
+}
+
+/// <summary>
+/// Loads a particle texture or set of particle textures
+/// </summary>
+/// <param name="textureNameToLoad">Name of the file or file path to load the texture(s) from</param>
+/// <param name="isMultiParticle">True to recursively load from the file path</param>
+/// <returns>An SRV for the loaded textures</returns>
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::LoadParticleTexture(std::string textureNameToLoad, bool isMultiParticle)
+{
+	ParticleTextureLoadRequest request = MakeParticleTextureRequest(textureNameToLoad, isMultiParticle);
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cachedTexture = FindCachedParticleTexture(request.cacheKey);
+	if (cachedTexture != nullptr) return cachedTexture;
+
+	DecodeParticleTextureRequest(request);
+
+	return CreateParticleTextureFromRequest(request);
+}
+
+/// <summary>
+/// Finds the files a particle texture loads from and builds its cache key.
+/// Only reads files, so it's safe to call from JobSystem workers.
+/// </summary>
+ParticleTextureLoadRequest AssetManager::MakeParticleTextureRequest(std::string textureNameToLoad, bool isMultiParticle) {
+	ParticleTextureLoadRequest request;
+	request.textureNameToLoad = textureNameToLoad;
+	request.isMultiParticle = isMultiParticle;
+
+	if (isMultiParticle) {
+		request.texturePaths = GetParticleTexturePaths(textureNameToLoad);
+	}
+	else {
+		request.texturePaths.push_back(dxInstance->GetAssetPathString(ASSET_PARTICLE_PATH) + textureNameToLoad);
+	}
+
+	request.cacheKey = GetContentCacheKey(ASSET_CACHE_PARTICLE_TEXTURE, request.texturePaths, isMultiParticle ? "array" : "single");
+
+	return request;
+}
+
+void AssetManager::DecodeParticleTextureRequest(ParticleTextureLoadRequest& request) {
+	if (request.isMultiParticle) {
+		// Load all particle textures in a specific subfolder
+		DecodeTextureFiles(request.texturePaths, &request.decodedTextures);
+		return;
+	}
+
+	DecodedTexture decodedTexture;
+	if (SUCCEEDED(DecodeTextureFile(request.texturePaths[0], &decodedTexture))) {
+		request.decodedTextures.push_back(std::move(decodedTexture));
+	}
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::CreateParticleTextureFromRequest(const ParticleTextureLoadRequest& request) {
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> particleTextureSRV;
+	uint64_t textureBytes = 0;
+
+	if (request.isMultiParticle) {
+		particleTextureSRV = CreateTextureArrayFromDecoded(request.decodedTextures);
+
+		for (const DecodedTexture& decodedTexture : request.decodedTextures) {
+			textureBytes += (uint64_t)decodedTexture.width * decodedTexture.height * 4;
+		}
+	}
+	else if (!request.decodedTextures.empty()) {
+		particleTextureSRV = CreateTextureFromDecoded(request.decodedTextures[0]);
+		textureBytes = GetDecodedTextureSize(request.decodedTextures[0]);
+	}
+
+	if (!request.cacheKey.empty() && particleTextureSRV != nullptr) {
+		AssetCacheEntry entry;
+		entry.type = ASSET_CACHE_PARTICLE_TEXTURE;
+		entry.textureView = particleTextureSRV;
+		entry.gpuBytes = textureBytes;
+
+		assetCache.Insert(request.cacheKey, entry);
+		assetCache.AddReference(particleTextureSRV.Get(), request.cacheKey);
+	}
+
+	return particleTextureSRV;
+}
+#pragma endregion
+
+#pragma region contentCache
+// Create and Queue methods check the content cache before loading anything.
+// A hit under the same name returns the existing asset, and a hit under a
+// new name makes a light asset around the shared GPU resources instead.
+
+/// <summary>
+/// Builds the content cache key for the files an asset loads from.
+/// Only hashes files, so it's safe to call from JobSystem workers.
+/// </summary>
+/// <returns>Empty if any of the files can't be read, in which case nothing is cached</returns>
+std::string AssetManager::GetContentCacheKey(AssetCacheType type, const std::vector<std::string>& fullPaths, std::string variant) {
+	uint64_t contentHash;
+	if (!assetCache.GetContentHash(fullPaths, &contentHash)) return "";
+
+	return AssetCache::MakeKey(type, contentHash, variant);
+}
+
+/// <summary>
+/// The same image makes a different texture depending on what it holds and
+/// how it's compressed, so both go in the key
+/// </summary>
+std::string AssetManager::GetTextureCacheKey(std::string fullPath, TexturePreset preset) {
+	TextureUsage usage = TextureCompressor::GetUsageForPath(fullPath);
+	return GetContentCacheKey(ASSET_CACHE_TEXTURE, { fullPath }, std::to_string(usage) + "|" + TextureCompressor::GetPresetName(preset));
+}
+
+/// <summary>
+/// Estimated GPU size of a texture made by CreateTextureFromDecoded
+/// </summary>
+uint64_t AssetManager::GetDecodedTextureSize(const DecodedTexture& decodedTexture) {
+	uint64_t size = decodedTexture.pixels.size();
+
+	// A full mip chain is generated on the GPU for uncooked textures, adding about a third
+	if (decodedTexture.mipLevels == 1) size += size / 3;
+
+	return size;
+}
+
+DXGI_FORMAT AssetManager::GetDecodedTextureFormat(const DecodedTexture& decodedTexture) {
+	bool sRGB = decodedTexture.sRGB;
+
+	switch (decodedTexture.format) {
+	case TEXTURE_FORMAT_BC1:
+		return sRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+	case TEXTURE_FORMAT_BC3:
+		return sRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+	case TEXTURE_FORMAT_BC4:
+		return DXGI_FORMAT_BC4_UNORM;
+	case TEXTURE_FORMAT_BC5:
+		return DXGI_FORMAT_BC5_UNORM;
+	case TEXTURE_FORMAT_BC7:
+		return sRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+	default:
+		return sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+std::shared_ptr<Texture> AssetManager::FindCachedTexture(std::string cacheKey, std::string nameToLoad, std::string textureName, AssetPathIndex assetPath, bool isNameFullPath) {
+	AssetCacheEntry* cached = cacheKey.empty() ? nullptr : assetCache.Find(cacheKey);
+	if (cached == nullptr) return nullptr;
+
+	std::shared_ptr<Texture> texture = cached->texture;
+	if (texture->GetName() != textureName || !assetCache.IsReferenced(texture.get())) {
+		texture = RegisterTexture(cached->textureView, nameToLoad, textureName, assetPath, isNameFullPath);
+		texture->SetStreamingID(cached->texture->GetStreamingID());
+	}
+	else if (std::find(globalTextures.begin(), globalTextures.end(), texture) == globalTextures.end()) {
+		// Kept from the scene that was switched away from
+		globalTextures.push_back(texture);
+	}
+
+	assetCache.AddReference(texture.get(), cacheKey);
+
+	return texture;
+}
+
+std::shared_ptr<Mesh> AssetManager::FindCachedMesh(std::string cacheKey, std::string id) {
+	AssetCacheEntry* cached = cacheKey.empty() ? nullptr : assetCache.Find(cacheKey);
+	if (cached == nullptr) return nullptr;
+
+	std::shared_ptr<Mesh> mesh = cached->mesh;
+	if (mesh->GetName() != id || !assetCache.IsReferenced(mesh.get())) {
+		mesh = std::make_shared<Mesh>(cached->mesh, id);
+		globalMeshes.push_back(mesh);
+	}
+	else if (std::find(globalMeshes.begin(), globalMeshes.end(), mesh) == globalMeshes.end()) {
+		// Kept from the scene that was switched away from
+		globalMeshes.push_back(mesh);
+	}
+
+	assetCache.AddReference(mesh.get(), cacheKey);
+
+	return mesh;
+}
+
+std::shared_ptr<Sky> AssetManager::FindCachedSky(std::string cacheKey, const SkyLoadRequest& request) {
+	AssetCacheEntry* cached = cacheKey.empty() ? nullptr : assetCache.Find(cacheKey);
+	if (cached == nullptr) return nullptr;
+
+	// A new sky reuses the cached IBL bake, and skips the decode and upload
+	std::shared_ptr<Sky> sky = cached->sky;
+	if (sky->GetName() != request.name || !assetCache.IsReferenced(sky.get())) {
+		SkyLoadRequest cachedRequest = request;
+		cachedRequest.bakedIBL = sky->GetBakedIBL();
+		sky = CreateSkyFromTexture(cached->textureView, cachedRequest);
+	}
+	else if (std::find(skies.begin(), skies.end(), sky) == skies.end()) {
+		// Kept from the scene that was switched away from
+		skies.push_back(sky);
+	}
+
+	assetCache.AddReference(sky.get(), cacheKey);
+
+	return sky;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::FindCachedParticleTexture(std::string cacheKey) {
+	AssetCacheEntry* cached = cacheKey.empty() ? nullptr : assetCache.Find(cacheKey);
+	if (cached == nullptr) return nullptr;
+
+	assetCache.AddReference(cached->textureView.Get(), cacheKey);
+
+	return cached->textureView;
+}
+
+FMOD::Sound* AssetManager::FindCachedSound(std::string cacheKey) {
+	AssetCacheEntry* cached = cacheKey.empty() ? nullptr : assetCache.Find(cacheKey);
+	if (cached == nullptr || !assetCache.IsReferenced(cached->sound)) return nullptr;
+
+	// Kept from the scene that was switched away from
+	if (std::find(globalSounds.begin(), globalSounds.end(), cached->sound) == globalSounds.end()) {
+		globalSounds.push_back(cached->sound);
+	}
+
+	assetCache.AddReference(cached->sound, cacheKey);
+
+	return cached->sound;
+}
+
+void AssetManager::CacheTexture(std::string cacheKey, std::shared_ptr<Texture> texture, const DecodedTexture& decodedTexture) {
+	if (cacheKey.empty() || texture->GetTexture() == nullptr) return;
+
+	AssetCacheEntry entry;
+	entry.type = ASSET_CACHE_TEXTURE;
+	entry.textureView = texture->GetTexture();
+	entry.texture = texture;
+	entry.gpuBytes = GetDecodedTextureSize(decodedTexture);
+
+	assetCache.Insert(cacheKey, entry);
+	assetCache.AddReference(texture.get(), cacheKey);
+}
+
+void AssetManager::CacheMesh(std::string cacheKey, std::shared_ptr<Mesh> mesh) {
+	if (cacheKey.empty() || mesh->GetIndexCount() == 0) return;
+
+	AssetCacheEntry entry;
+	entry.type = ASSET_CACHE_MESH;
+	entry.mesh = mesh;
+	entry.gpuBytes = (uint64_t)mesh->GetVertexCount() * sizeof(Vertex) + (uint64_t)mesh->GetIndexCount() * sizeof(unsigned int);
+	entry.cpuBytes = mesh->GetCPUMemorySize();
+
+	assetCache.Insert(cacheKey, entry);
+	assetCache.AddReference(mesh.get(), cacheKey);
+}
+
+void AssetManager::CacheSky(std::string cacheKey, std::shared_ptr<Sky> sky, uint64_t textureBytes) {
+	if (cacheKey.empty() || sky->GetSkyTexture() == nullptr) return;
+
+	AssetCacheEntry entry;
+	entry.type = ASSET_CACHE_SKY;
+	entry.textureView = sky->GetSkyTexture();
+	entry.sky = sky;
+	entry.gpuBytes = textureBytes;
+
+	assetCache.Insert(cacheKey, entry);
+	assetCache.AddReference(sky.get(), cacheKey);
+}
+
+void AssetManager::CacheSound(std::string cacheKey, FMOD::Sound* sound, FMOD_MODE mode) {
+	if (cacheKey.empty() || sound == nullptr) return;
+
+	AssetCacheEntry entry;
+	entry.type = ASSET_CACHE_SOUND;
+	entry.sound = sound;
+
+	// Streams only hold a small decode buffer, samples are fully decoded into memory
+	unsigned int sampleBytes = 0;
+	if (!(mode & FMOD_CREATESTREAM) && sound->getLength(&sampleBytes, FMOD_TIMEUNIT_PCMBYTES) == FMOD_OK) {
+		entry.cpuBytes = sampleBytes;
+	}
+
+	assetCache.Insert(cacheKey, entry);
+	assetCache.AddReference(sound, cacheKey);
+}
+
+// Preloaded data is handed out once. A repeat of the same file finds
+// the first one in the cache by then, like any other load.
+
+bool AssetManager::TakePreloadedTexture(std::string cacheKey, OUT DecodedTexture* decodedTexture, OUT HRESULT* result) {
+	if (scenePreload == nullptr || cacheKey.empty()) return false;
+
+	for (TextureLoadRequest& request : scenePreload->textures) {
+		if (request.cacheKey != cacheKey) continue;
+
+		*decodedTexture = std::move(request.decodedTexture);
+		*result = request.result;
+		request.cacheKey = "";
+
+		return true;
+	}
+
+	return false;
+}
+
+bool AssetManager::TakePreloadedMesh(std::string cacheKey, OUT MeshLoadRequest* request) {
+	if (scenePreload == nullptr || cacheKey.empty()) return false;
+
+	for (MeshLoadRequest& preloaded : scenePreload->meshes) {
+		if (preloaded.cacheKey != cacheKey) continue;
+
+		// A failed read is tried again, so it fails the way CreateMesh always has
+		if (!preloaded.loaded) return false;
+
+		*request = std::move(preloaded);
+		preloaded.cacheKey = "";
+
+		return true;
+	}
+
+	return false;
+}
+
+bool AssetManager::TakePreloadedSky(std::string cacheKey, SkyLoadRequest* request) {
+	if (scenePreload == nullptr || cacheKey.empty()) return false;
+
+	for (SkyLoadRequest& preloaded : scenePreload->skies) {
+		if (preloaded.cacheKey != cacheKey) continue;
+
+		// Only what DecodeSkyRequest fills in, the names are the caller's
+		request->ddsFileData = std::move(preloaded.ddsFileData);
+		for (int i = 0; i < 6; i++) {
+			request->faces[i] = std::move(preloaded.faces[i]);
+		}
+		request->bakedIBL = preloaded.bakedIBL;
+		request->result = preloaded.result;
+		preloaded.cacheKey = "";
+
+		return true;
+	}
+
+	return false;
+}
+
+FMOD::Sound* AssetManager::TakePreloadedSound(std::string cacheKey) {
+	if (scenePreload == nullptr || cacheKey.empty()) return nullptr;
+
+	for (SoundLoadRequest& request : scenePreload->sounds) {
+		if (request.cacheKey != cacheKey || request.sound == nullptr) continue;
+
+		FMOD::Sound* sound = request.sound;
+		request.sound = nullptr;
+
+		return sound;
+	}
+
+	return nullptr;
+}
+#pragma endregion
+
+#pragma region complexModels
+/// <summary>
+/// Read-only assimp stream over a VirtualFile
+/// </summary>
+class VirtualFileIOStream : public Assimp::IOStream {
+public:
+	VirtualFile file;
+	size_t position = 0;
+
+	size_t Read(void* buffer, size_t size, size_t count) override {
+		if (size == 0) return 0;
+
+		size_t available = (file.GetSize() - position) / size;
+		count = (std::min)(count, available);
+		memcpy(buffer, file.GetData() + position, size * count);
+		position += size * count;
+		return count;
+	}
+
+	size_t Write(const void* buffer, size_t size, size_t count) override {
+		return 0;
+	}
+
+	aiReturn Seek(size_t offset, aiOrigin origin) override {
+		size_t newPosition;
+		switch (origin) {
+		case aiOrigin_SET: newPosition = offset; break;
+		case aiOrigin_CUR: newPosition = position + offset; break;
+		case aiOrigin_END: newPosition = file.GetSize() - offset; break;
+		default: return aiReturn_FAILURE;
+		}
+
+		if (newPosition > file.GetSize()) return aiReturn_FAILURE;
+		position = newPosition;
+		return aiReturn_SUCCESS;
+	}
+
+	size_t Tell() const override {
+		return position;
+	}
+
+	size_t FileSize() const override {
+		return const_cast<VirtualFile&>(file).GetSize();
+	}
+
+	void Flush() override {}
+};
+
+/// <summary>
+/// Lets assimp read models, and the material files next to them, out of archives
+/// </summary>
+class VirtualFileIOSystem : public Assimp::IOSystem {
+public:
+	bool Exists(const char* path) const override {
+		return VirtualFileSystem::GetInstance().Exists(path);
+	}
+
+	char getOsSeparator() const override {
+		return '\\';
+	}
+
+	Assimp::IOStream* Open(const char* path, const char* mode) override {
+		// Archives are read-only
+		if (strchr(mode, 'w') != nullptr || strchr(mode, 'a') != nullptr) return nullptr;
+
+		VirtualFileIOStream* stream = new VirtualFileIOStream();
+		if (!stream->file.Open(path)) {
+			delete stream;
+			return nullptr;
+		}
+
+		return stream;
+	}
+
+	void Close(Assimp::IOStream* stream) override {
+		delete stream;
+	}
+};
+
+void AssetManager::CreateComplexGeometry() {
+	std::shared_ptr<GameEntity> human = ImportComplexModel("human.obj", "Human");
+	if (human != nullptr) {
+		human->GetTransform()->SetPosition(0.0f, 0.0f, 1.0f);
+		human->GetTransform()->SetScale(0.25f, 0.25f, 0.25f);
+	}
+
+	std::shared_ptr<GameEntity> hat = ImportComplexModel("hat.obj", "Hat");
+	if (hat != nullptr) {
+		hat->GetTransform()->SetPosition(0.0f, 3.0f, 1.0f);
+		hat->GetTransform()->SetScale(0.25f, 0.25f, 0.25f);
+	}
+}
+
+/// <summary>
+/// Imports any model format assimp supports as a hierarchy of GameEntities.
+/// Every mesh in the file is converted in parallel, materials and their
+/// textures are imported, and each node becomes an entity parented to its
+/// node's parent with the node's local transform.
+/// </summary>
+/// <param name="nameToLoad">File in the models folder, or a full path</param>
+/// <param name="name">Name of the root entity. Child entities and assets are prefixed with it.</param>
+/// <param name="isNameFullPath">Whether nameToLoad is already a full path</param>
+/// <returns>The root entity, or nullptr if assimp couldn't read the file</returns>
+std::shared_ptr<GameEntity> AssetManager::ImportComplexModel(std::string nameToLoad, std::string name, bool isNameFullPath) {
+	std::string namePath;
+
+	if (isNameFullPath) {
+		namePath = nameToLoad;
+	}
+	else {
+		namePath = GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, nameToLoad);
+	}
+
+	Assimp::Importer importer;
+	importer.SetIOHandler(new VirtualFileIOSystem());
+
+	// No aiProcess_CalcTangentSpace, since ConvertComplexMesh replaces whatever tangents assimp has
+	const aiScene* scene = importer.ReadFile(namePath.c_str(),
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_GenNormals |
+		aiProcess_ConvertToLeftHanded);
+
+	if (scene == NULL || scene->mRootNode == NULL) return nullptr;
+
+	std::vector<std::shared_ptr<Material>> materials = ImportComplexMaterials(scene, namePath, name);
+
+	// Meshes don't depend on each other, so every one converts on its own worker.
+	// Only the vertex buffer upload below has to happen on this thread.
+	std::vector<MeshData> meshData(scene->mNumMeshes);
+	JobSystem::GetInstance().ParallelFor(scene->mNumMeshes, 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			ConvertComplexMesh(scene->mMeshes[i], &meshData[i]);
+		}
+	});
+
+	std::string serializedKey = SerializeFileName("Assets\\Models\\", namePath);
+	std::vector<std::shared_ptr<Mesh>> meshes(scene->mNumMeshes);
+	std::vector<std::shared_ptr<Material>> meshMaterials(scene->mNumMeshes);
+	for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+		meshMaterials[i] = scene->mMeshes[i]->mMaterialIndex < materials.size() ? materials[scene->mMeshes[i]->mMaterialIndex] : GetMaterialByName("cobbleMat");
+		if (meshData[i].indices.empty()) continue;
+
+		std::string meshName = scene->mMeshes[i]->mName.length > 0 ? scene->mMeshes[i]->mName.C_Str() : "Mesh" + std::to_string(i);
+
+		meshes[i] = std::make_shared<Mesh>(meshData[i], device, name + meshName);
+		meshes[i]->SetFileNameKey(serializedKey);
+
+		globalMeshes.push_back(meshes[i]);
+	}
+
+	return ProcessComplexModel(scene->mRootNode, nullptr, meshes, meshMaterials, name);
+}
+
+/// <summary>
+/// Creates an entity for a node and its children. Nodes with a single mesh
+/// render it themselves, nodes with several get a child entity per mesh.
+/// </summary>
+/// <param name="meshes">Converted meshes, indexed like the scene's meshes. Empty meshes are null.</param>
+/// <param name="meshMaterials">Material for each of the scene's meshes</param>
+/// <returns>The node's entity</returns>
+std::shared_ptr<GameEntity> AssetManager::ProcessComplexModel(aiNode* node, 
+															  std::shared_ptr<GameEntity> parent, 
+															  const std::vector<std::shared_ptr<Mesh>>& meshes, 
+															  const std::vector<std::shared_ptr<Material>>& meshMaterials, 
+															  std::string name) 
+{
+	std::vector<unsigned int> nodeMeshes;
+	for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+		if (meshes[node->mMeshes[i]] != nullptr) nodeMeshes.push_back(node->mMeshes[i]);
+	}
+
+	std::shared_ptr<GameEntity> newEntity;
+	if (nodeMeshes.size() == 1) {
+		newEntity = CreateGameEntity(meshes[nodeMeshes[0]], meshMaterials[nodeMeshes[0]], name);
+	}
+	else {
+		newEntity = CreateGameEntity(name);
+	}
+
+	// Parent first, since parenting keeps the world transform and
+	// the node's transform is relative to its parent
+	std::shared_ptr<Transform> transform = newEntity->GetTransform();
+	if (parent != nullptr) {
+		transform->SetParent(parent->GetTransform());
+	}
+
+	// Assimp matrices are row major with the translation in the last column
+	DirectX::XMFLOAT4X4 nodeMatrix(&node->mTransformation.a1);
+	DirectX::XMVECTOR scale;
+	DirectX::XMVECTOR rotation;
+	DirectX::XMVECTOR position;
+	if (DirectX::XMMatrixDecompose(&scale, &rotation, &position, DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&nodeMatrix)))) {
+		DirectX::XMFLOAT3 nodeScale;
+		DirectX::XMFLOAT4 nodeRotation;
+		DirectX::XMFLOAT3 nodePosition;
+		DirectX::XMStoreFloat3(&nodeScale, scale);
+		DirectX::XMStoreFloat4(&nodeRotation, rotation);
+		DirectX::XMStoreFloat3(&nodePosition, position);
+
+		transform->SetPosition(nodePosition);
+		transform->SetRotation(Transform::QuaternionToEuler(nodeRotation));
+		transform->SetScale(nodeScale);
+	}
+
+	if (nodeMeshes.size() > 1) {
+		for (size_t i = 0; i < nodeMeshes.size(); i++) {
+			std::shared_ptr<GameEntity> meshEntity = CreateGameEntity(meshes[nodeMeshes[i]], meshMaterials[nodeMeshes[i]], name + "Mesh" + std::to_string(i));
+			meshEntity->GetTransform()->SetParent(transform);
+			meshEntity->GetTransform()->SetPosition(0.0f, 0.0f, 0.0f);
+			meshEntity->GetTransform()->SetRotation(0.0f, 0.0f, 0.0f);
+			meshEntity->GetTransform()->SetScale(1.0f, 1.0f, 1.0f);
+		}
+	}
+
+	for (unsigned int i = 0; i < node->mNumChildren; i++) {
+		std::string childName = node->mChildren[i]->mName.length > 0 ? node->mChildren[i]->mName.C_Str() : "Child" + std::to_string(i);
+		ProcessComplexModel(node->mChildren[i], newEntity, meshes, meshMaterials, name + childName);
+	}
+
+	return newEntity;
+}
+
+/// <summary>
+/// Creates a PBR material for each of the scene's materials. Textures are
+/// found relative to the model file and all decoded in parallel. Slots without
+/// a texture get BlankTexture, and untextured materials are tinted with their diffuse color.
+/// </summary>
+/// <returns>Materials indexed like the scene's materials</returns>
+std::vector<std::shared_ptr<Material>> AssetManager::ImportComplexMaterials(const aiScene* scene, std::string modelPath, std::string name) {
+	enum ComplexTextureSlot {
+		COMPLEX_TEXTURE_ALBEDO,
+		COMPLEX_TEXTURE_NORMALS,
+		COMPLEX_TEXTURE_METALNESS,
+		COMPLEX_TEXTURE_ROUGHNESS,
+		COMPLEX_TEXTURE_SLOT_COUNT
+	};
+
+	// Texture types to check for each slot, in order of preference.
+	// OBJ bump maps come through as height maps.
+	std::vector<aiTextureType> slotTypes[COMPLEX_TEXTURE_SLOT_COUNT];
+	slotTypes[COMPLEX_TEXTURE_ALBEDO] = { aiTextureType_DIFFUSE };
+	slotTypes[COMPLEX_TEXTURE_NORMALS] = { aiTextureType_NORMALS, aiTextureType_HEIGHT };
+#ifdef AI_MATKEY_METALLIC_FACTOR
+	// Only newer versions of assimp know about PBR textures
+	slotTypes[COMPLEX_TEXTURE_ALBEDO].insert(slotTypes[COMPLEX_TEXTURE_ALBEDO].begin(), aiTextureType_BASE_COLOR);
+	slotTypes[COMPLEX_TEXTURE_METALNESS] = { aiTextureType_METALNESS };
+	slotTypes[COMPLEX_TEXTURE_ROUGHNESS] = { aiTextureType_DIFFUSE_ROUGHNESS };
+#endif
+
+	std::string modelFolder = modelPath.substr(0, modelPath.find_last_of("\\/") + 1);
+
+	// Gather every texture once, even if several materials use it
+	std::vector<std::string> texturePaths;
+	std::vector<int> slotTextures(scene->mNumMaterials * COMPLEX_TEXTURE_SLOT_COUNT, -1);
+	for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+		for (int slot = 0; slot < COMPLEX_TEXTURE_SLOT_COUNT; slot++) {
+			for (aiTextureType type : slotTypes[slot]) {
+				aiString texturePath;
+				if (scene->mMaterials[i]->GetTexture(type, 0, &texturePath) != AI_SUCCESS) continue;
+
+				// Embedded textures are referenced as "*index" and aren't supported
+				if (texturePath.length == 0 || texturePath.data[0] == '*') continue;
+
+				std::string fullPath = texturePath.C_Str();
+				std::replace(fullPath.begin(), fullPath.end(), '/', '\\');
+				if (fullPath[0] != '\\' && fullPath.find(':') == std::string::npos) {
+					fullPath = modelFolder + fullPath;
+				}
+
+				size_t textureIndex = std::find(texturePaths.begin(), texturePaths.end(), fullPath) - texturePaths.begin();
+				if (textureIndex == texturePaths.size()) {
+					texturePaths.push_back(fullPath);
+				}
+
+				slotTextures[i * COMPLEX_TEXTURE_SLOT_COUNT + slot] = (int)textureIndex;
+				break;
+			}
+		}
+	}
+
+	std::vector<DecodedTexture> decodedTextures;
+	DecodeTextureFiles(texturePaths, &decodedTextures);
+
+	std::vector<std::shared_ptr<Texture>> textures(texturePaths.size());
+	for (size_t i = 0; i < texturePaths.size(); i++) {
+		if (decodedTextures[i].pixels.empty()) continue;
+
+		std::string textureName = name + texturePaths[i].substr(texturePaths[i].find_last_of('\\') + 1);
+		textures[i] = RegisterTexture(CreateTextureFromDecoded(decodedTextures[i]), texturePaths[i], textureName, ASSET_TEXTURE_PATH_BASIC, true);
+	}
+
+	std::shared_ptr<Texture> blankTexture = GetTextureByName("BlankTexture");
+
+	std::vector<std::shared_ptr<Material>> materials(scene->mNumMaterials);
+	for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+		const aiMaterial* material = scene->mMaterials[i];
+
+		std::shared_ptr<Texture> slotTexture[COMPLEX_TEXTURE_SLOT_COUNT];
+		for (int slot = 0; slot < COMPLEX_TEXTURE_SLOT_COUNT; slot++) {
+			int textureIndex = slotTextures[i * COMPLEX_TEXTURE_SLOT_COUNT + slot];
+			slotTexture[slot] = textureIndex >= 0 && textures[textureIndex] != nullptr ? textures[textureIndex] : blankTexture;
+		}
+
+		aiString materialName;
+		if (material->Get(AI_MATKEY_NAME, materialName) != AI_SUCCESS || materialName.length == 0) {
+			materialName.Set("Material" + std::to_string(i));
+		}
+
+		materials[i] = CreatePBRMaterial(name + materialName.C_Str(),
+			slotTexture[COMPLEX_TEXTURE_ALBEDO],
+			slotTexture[COMPLEX_TEXTURE_NORMALS],
+			slotTexture[COMPLEX_TEXTURE_METALNESS],
+			slotTexture[COMPLEX_TEXTURE_ROUGHNESS]);
+
+		aiColor4D diffuse;
+		if (slotTexture[COMPLEX_TEXTURE_ALBEDO] == blankTexture && material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse) == AI_SUCCESS) {
+			materials[i]->SetTint(DirectX::XMFLOAT4(diffuse.r, diffuse.g, diffuse.b, 1.0f));
+		}
+	}
+
+	return materials;
+}
+
+/// <summary>
+/// Converts one assimp mesh into engine vertices and indices.
+/// Buffers are sized up front and each attribute is copied in its own flat
+/// loop, so there's no per-vertex branching or reallocation.
+/// Only touches the mesh and the output, so it's safe to run on JobSystem workers.
+/// </summary>
+/// <param name="meshData">Left empty if the mesh has no triangles</param>
+void AssetManager::ConvertComplexMesh(const aiMesh* mesh, OUT MeshData* meshData) {
+	meshData->vertices.clear();
+	meshData->indices.clear();
+
+	// Triangulation leaves point and line primitives alone, and they can't be drawn as triangles
+	unsigned int triangleCount = 0;
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+		if (mesh->mFaces[i].mNumIndices == 3) triangleCount++;
+	}
+
+	if (triangleCount == 0 || mesh->mNumVertices == 0) return;
+
+	unsigned int vertexCount = mesh->mNumVertices;
+	meshData->vertices.resize(vertexCount);
+	meshData->indices.resize(triangleCount * 3);
+
+	Vertex* vertices = meshData->vertices.data();
+
+	const aiVector3D* positions = mesh->mVertices;
+	for (unsigned int i = 0; i < vertexCount; i++) {
+		vertices[i].Position = DirectX::XMFLOAT3(positions[i].x, positions[i].y, positions[i].z);
+	}
+
+	const aiVector3D* normals = mesh->mNormals;
+	if (normals != NULL) {
+		for (unsigned int i = 0; i < vertexCount; i++) {
+			vertices[i].normal = DirectX::XMFLOAT3(normals[i].x, normals[i].y, normals[i].z);
+		}
+	}
+
+	const aiVector3D* uvs = mesh->mTextureCoords[0];
+	if (uvs != NULL) {
+		for (unsigned int i = 0; i < vertexCount; i++) {
+			vertices[i].uv = DirectX::XMFLOAT2(uvs[i].x, uvs[i].y);
+		}
+	}
+
+	unsigned int* indices = meshData->indices.data();
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+		const aiFace& face = mesh->mFaces[i];
+		if (face.mNumIndices != 3) continue;
+
+		indices[0] = face.mIndices[0];
+		indices[1] = face.mIndices[1];
+		indices[2] = face.mIndices[2];
+		indices += 3;
+	}
+
+	// Generated here instead of by assimp, so imported meshes get the same
+	// tangents and handedness as every other mesh
+	Mesh::CalculateTangents(vertices, (int)vertexCount, meshData->indices.data(), (int)meshData->indices.size());
+}
+#pragma endregion
+
+#pragma region removeAssets
+
+//
+// Asset Removal methods
+//
+
+void AssetManager::CleanAllEntities()
+{
+	for (auto ge : globalEntities) {
+		ge->Release();
+	}
+	globalEntities.clear();
+}
+
+void AssetManager::CleanAllVectors() {
+	CleanAllEntities();
+
+	for (int i = 0; i < globalSounds.size(); i++) {
+		FMODUserData* uData;
+		globalSounds[i]->getUserData((void**)&uData);
+		uData->filenameKey.reset();
+		uData->name.reset();
+		delete uData;
+
+		globalSounds[i]->release();
+	}
+
+	pixelShaders.clear();
+	vertexShaders.clear();
+	computeShaders.clear();
+	skies.clear();
+	Sky::ReleaseSharedResources();
+	globalMeshes.clear();
+	globalTextures.clear();
+	globalMaterials.clear();
+	globalTerrainMaterials.clear();
+	globalSounds.clear();
+	globalFonts.clear();
+	assetCache.Clear();
+	textureStreamer.Clear();
+	streamedTextureSources.clear();
+	textureSampleStates.clear();
+	textureState = nullptr;
+	clampState = nullptr;
+
+	context->Flush();
+}
+
+void AssetManager::RetireSceneAssets(OUT RetiredSceneAssets* retired) {
+	CleanAllEntities();
+
+	*retired = RetiredSceneAssets();
+	retired->pixelShaders.swap(pixelShaders);
+	retired->vertexShaders.swap(vertexShaders);
+	retired->computeShaders.swap(computeShaders);
+	retired->skies.swap(skies);
+	retired->meshes.swap(globalMeshes);
+	retired->textures.swap(globalTextures);
+	retired->materials.swap(globalMaterials);
+	retired->terrainMaterials.swap(globalTerrainMaterials);
+	retired->sounds.swap(globalSounds);
+	retired->fonts.swap(globalFonts);
+	retired->textureSampleStates.swap(textureSampleStates);
+	textureState = nullptr;
+	clampState = nullptr;
+}
+
+size_t AssetManager::ReleaseRetiredAssets(RetiredSceneAssets* retired) {
+	// Whatever the new scene took over from the cache is in its lists as well
+	std::unordered_set<const void*> kept;
+	for (std::shared_ptr<Texture> texture : globalTextures) kept.insert(texture.get());
+	for (std::shared_ptr<Mesh> mesh : globalMeshes) kept.insert(mesh.get());
+	for (std::shared_ptr<Sky> sky : skies) kept.insert(sky.get());
+	for (FMOD::Sound* sound : globalSounds) kept.insert(sound);
+
+	size_t releasedCount = 0;
+	for (std::shared_ptr<Texture> texture : retired->textures) {
+		if (kept.count(texture.get()) > 0) continue;
+
+		assetCache.Release(texture.get());
+		releasedCount++;
+	}
+
+	for (std::shared_ptr<Mesh> mesh : retired->meshes) {
+		if (kept.count(mesh.get()) > 0) continue;
+
+		assetCache.Release(mesh.get());
+		releasedCount++;
+	}
+
+	for (std::shared_ptr<Sky> sky : retired->skies) {
+		if (kept.count(sky.get()) > 0) continue;
+
+		assetCache.Release(sky.get());
+		releasedCount++;
+	}
+
+	for (FMOD::Sound* sound : retired->sounds) {
+		if (kept.count(sound) > 0) continue;
+
+		assetCache.Release(sound);
+
+		FMODUserData* uData;
+		sound->getUserData((void**)&uData);
+		uData->filenameKey.reset();
+		uData->name.reset();
+		delete uData;
+
+		sound->release();
+		releasedCount++;
+	}
+
+	// The old scene's sky is on its way out
+	if (!skies.empty() && kept.count(currentSky.get()) == 0) currentSky = skies[0];
+
+	*retired = RetiredSceneAssets();
+
+	// Lets the driver free the released resources now instead of at its next flush
+	context->Flush();
+
+	return releasedCount;
+}
+
+void AssetManager::RemoveGameEntity(std::string name) {
+	RemoveGameEntity(GetGameEntityIDByName(name));
+}
+
+void AssetManager::RemoveGameEntity(int id) {
+	globalEntities[id]->Release();
+	globalEntities.erase(globalEntities.begin() + id);
+}
+
+void AssetManager::RemoveSky(std::string name) {
+	RemoveSky(GetSkyIDByName(name));
+}
+
+void AssetManager::RemoveSky(int id) {
+	assetCache.Release(skies[id].get());
+	skies.erase(skies.begin() + id);
+}
+
+void AssetManager::RemoveVertexShader(std::string name) {
+	vertexShaders.erase(vertexShaders.begin() + GetVertexShaderIDByName(name));
+}
+
+void AssetManager::RemoveVertexShader(int id) {
+	vertexShaders.erase(vertexShaders.begin() + id);
+}
+
+void AssetManager::RemovePixelShader(std::string name) {
+	pixelShaders.erase(pixelShaders.begin() + GetPixelShaderIDByName(name));
+}
+
+void AssetManager::RemovePixelShader(int id) {
+	pixelShaders.erase(pixelShaders.begin() + id);
+}
+
+void AssetManager::RemoveMesh(std::string name) {
+	RemoveMesh(GetMeshIDByName(name));
+}
+
+void AssetManager::RemoveMesh(int id) {
+	assetCache.Release(globalMeshes[id].get());
+	globalMeshes.erase(globalMeshes.begin() + id);
+}
+
+void AssetManager::RemoveTexture(std::string name) {
+	RemoveTexture(GetTextureIDByName(name));
+}
+
+void AssetManager::RemoveTexture(int id) {
+	assetCache.Release(globalTextures[id].get());
+	globalTextures.erase(globalTextures.begin() + id);
+}
+
+void AssetManager::RemoveMaterial(std::string name) {
+	globalMaterials.erase(globalMaterials.begin() + GetMaterialIDByName(name));
+}
+
+void AssetManager::RemoveMaterial(int id) {
+	globalMaterials.erase(globalMaterials.begin() + id);
+}
+
+void AssetManager::RemoveTerrainMaterial(std::string name) {
+	RemoveTerrainMaterial(GetTerrainMaterialIDByName(name));
+}
+
+void AssetManager::RemoveTerrainMaterial(int id) {
+	globalTerrainMaterials.erase(globalTerrainMaterials.begin() + id);
+}
+
+void AssetManager::RemoveSound(int id) {
+	FMOD::Sound* sound = globalSounds[id];
+	assetCache.Release(sound);
+
+	FMODUserData* uData;
+	sound->getUserData((void**)&uData);
+	uData->filenameKey.reset();
+	uData->name.reset();
+	delete uData;
+
+	sound->release();
+	globalSounds.erase(globalSounds.begin() + id);
+}
+#pragma endregion
+
+#pragma region unloading
+// Assets are referenced by components and by materials, not by the global
+// lists, so anything only the lists hold is unused. References are found
+// fresh on each pass instead of counted as they change, so nothing that
+// sets a mesh or material has to report it.
+
+std::unordered_set<const void*> AssetManager::FindReferencedAssets() {
+	std::unordered_set<const void*> referenced;
+
+	auto referenceMaterial = [&](std::shared_ptr<Material> material) {
+		if (material == nullptr) return;
+
+		referenced.insert(material.get());
+		referenced.insert(material->GetTexture().get());
+		referenced.insert(material->GetNormalMap().get());
+		referenced.insert(material->GetMetalMap().get());
+		referenced.insert(material->GetRoughMap().get());
+	};
+
+	auto referenceTerrainMaterial = [&](std::shared_ptr<TerrainMaterial> terrainMaterial) {
+		if (terrainMaterial == nullptr) return;
+
+		referenced.insert(terrainMaterial.get());
+		for (size_t i = 0; i < terrainMaterial->GetMaterialCount(); i++) {
+			referenceMaterial(terrainMaterial->GetMaterialAtID((int)i));
+		}
+	};
+
+	for (std::shared_ptr<MeshRenderer> meshRenderer : ComponentManager::GetAll<MeshRenderer>()) {
+		referenced.insert(meshRenderer->GetMesh().get());
+		referenceMaterial(meshRenderer->GetMaterial());
+	}
+
+	for (std::shared_ptr<Terrain> terrain : ComponentManager::GetAll<Terrain>()) {
+		referenced.insert(terrain->GetMesh().get());
+		referenceTerrainMaterial(terrain->GetMaterial());
+	}
+
+	// Removing an entry shifts every one after it, so records that
+	// refer to assets by index keep the whole range they could use
+	if (indexedAssetCounter) {
+		IndexedAssetCounts counts = indexedAssetCounter();
+		for (size_t i = 0; i < counts.meshCount && i < globalMeshes.size(); i++) {
+			referenced.insert(globalMeshes[i].get());
+		}
+		for (size_t i = 0; i < counts.materialCount && i < globalMaterials.size(); i++) {
+			referenceMaterial(globalMaterials[i]);
+		}
+		for (size_t i = 0; i < counts.terrainMaterialCount && i < globalTerrainMaterials.size(); i++) {
+			referenceTerrainMaterial(globalTerrainMaterials[i]);
+		}
+	}
+
+	// New components start out with these
+	referenced.insert(MeshRenderer::GetDefaultMesh().get());
+	referenceMaterial(MeshRenderer::GetDefaultMaterial());
+	referenced.insert(Terrain::GetDefaultMesh().get());
+	referenceTerrainMaterial(Terrain::GetDefaultMaterial());
+
+	// Deferred assets stand in with these until they load
+	referenced.insert(GetTextureByName("BlankTexture").get());
+	referenced.insert(GetMeshByName("Cube").get());
+
+	referenced.insert(currentSky.get());
+
+	for (FMOD::Sound* sound : globalSounds) {
+		if (audioInstance.IsSoundPlaying(sound)) referenced.insert(sound);
+	}
+
+	return referenced;
+}
+
+size_t AssetManager::UnloadUnusedAssets() {
+	std::unordered_set<const void*> referenced = FindReferencedAssets();
+	size_t unloadedCount = 0;
+
+	// Each list is walked backwards, so removing doesn't shift the ids still to check
+	for (int i = (int)globalTerrainMaterials.size() - 1; i >= 0; i--) {
+		if (referenced.count(globalTerrainMaterials[i].get()) > 0) continue;
+
+		RemoveTerrainMaterial(i);
+		unloadedCount++;
+	}
+
+	for (int i = (int)globalMaterials.size() - 1; i >= 0; i--) {
+		if (referenced.count(globalMaterials[i].get()) > 0) continue;
+
+		RemoveMaterial(i);
+		unloadedCount++;
+	}
+
+	for (int i = (int)globalTextures.size() - 1; i >= 0; i--) {
+		if (referenced.count(globalTextures[i].get()) > 0) continue;
+
+		RemoveTexture(i);
+		unloadedCount++;
+	}
+
+	for (int i = (int)globalMeshes.size() - 1; i >= 0; i--) {
+		if (referenced.count(globalMeshes[i].get()) > 0) continue;
+
+		RemoveMesh(i);
+		unloadedCount++;
+	}
+
+	for (int i = (int)skies.size() - 1; i >= 0; i--) {
+		if (referenced.count(skies[i].get()) > 0) continue;
+
+		RemoveSky(i);
+		unloadedCount++;
+	}
+
+	for (int i = (int)globalSounds.size() - 1; i >= 0; i--) {
+		if (referenced.count(globalSounds[i]) > 0) continue;
+
+		RemoveSound(i);
+		unloadedCount++;
+	}
+
+	// Lets the driver free the released resources now instead of at its next flush
+	if (unloadedCount > 0) context->Flush();
+
+	return unloadedCount;
+}
+
+size_t AssetManager::EnforceAssetMemoryBudget() {
+	if (assetMemoryBudget == 0 || Time::totalTime < nextBudgetCheckTime) return 0;
+	if (*engineState != EngineState::EDITING) return 0;
+
+	nextBudgetCheckTime = Time::totalTime + ASSET_BUDGET_CHECK_INTERVAL;
+
+	AssetMemoryUsage usage = GetLoadedAssetMemory();
+	if (usage.gpuBytes + usage.cpuBytes <= assetMemoryBudget) return 0;
+
+	return UnloadUnusedAssets();
+}
+
+AssetMemoryUsage AssetManager::GetLoadedAssetMemory() {
+	AssetMemoryUsage usage;
+	std::unordered_set<const void*> countedResources;
+
+	for (std::shared_ptr<Texture> texture : globalTextures) {
+		// Deferred textures only point at their placeholder, and asking for it would load them
+		if (texture->IsLoadDeferred()) continue;
+
+		usage.gpuBytes += GetTextureMemorySize(texture->GetTexture().Get(), &countedResources);
+	}
+
+	for (std::shared_ptr<Mesh> mesh : globalMeshes) {
+		if (mesh->IsLoadDeferred()) continue;
+		if (!countedResources.insert(mesh->GetVertexBuffer().Get()).second) continue;
+
+		usage.gpuBytes += (uint64_t)mesh->GetVertexCount() * sizeof(Vertex) + (uint64_t)mesh->GetIndexCount() * sizeof(unsigned int);
+		usage.cpuBytes += mesh->GetCPUMemorySize();
+	}
+
+	for (std::shared_ptr<Sky> sky : skies) {
+		usage.gpuBytes += GetTextureMemorySize(sky->GetSkyTexture().Get(), &countedResources);
+		usage.gpuBytes += GetTextureMemorySize(sky->GetIrradianceCubeMap().Get(), &countedResources);
+		usage.gpuBytes += GetTextureMemorySize(sky->GetConvolvedSpecularCubeMap().Get(), &countedResources);
+		usage.gpuBytes += GetTextureMemorySize(sky->GetBRDFLookupTexture().Get(), &countedResources);
+	}
+
+	for (FMOD::Sound* sound : globalSounds) {
+		// Streams only hold a small decode buffer, samples are fully decoded into memory
+		FMOD_MODE mode;
+		unsigned int sampleBytes = 0;
+		if (sound->getMode(&mode) == FMOD_OK && !(mode & FMOD_CREATESTREAM) &&
+			sound->getLength(&sampleBytes, FMOD_TIMEUNIT_PCMBYTES) == FMOD_OK) {
+			usage.cpuBytes += sampleBytes;
+		}
+	}
+
+	return usage;
+}
+
+/// <summary>
+/// Estimates the size of the texture behind a view, with all of its mips and array slices
+/// </summary>
+/// <param name="countedResources">Textures already counted. They count as zero, and this one is added.</param>
+uint64_t AssetManager::GetTextureMemorySize(ID3D11ShaderResourceView* textureView, std::unordered_set<const void*>* countedResources) {
+	if (textureView == nullptr) return 0;
+
+	Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+	textureView->GetResource(resource.GetAddressOf());
+	if (!countedResources->insert(resource.Get()).second) return 0;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	if (FAILED(resource.As(&texture))) return 0;
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture->GetDesc(&desc);
+
+	// Block compressed formats are sized per 4x4 block, everything else per pixel
+	bool blockCompressed = true;
+	uint64_t unitBytes;
+	switch (desc.Format) {
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		unitBytes = 8;
+		break;
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		unitBytes = 16;
+		break;
+	case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		blockCompressed = false;
+		unitBytes = 16;
+		break;
+	case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+		blockCompressed = false;
+		unitBytes = 8;
+		break;
+	default:
+		blockCompressed = false;
+		unitBytes = 4;
+		break;
+	}
+
+	uint64_t size = 0;
+	for (UINT mip = 0; mip < desc.MipLevels; mip++) {
+		uint64_t mipWidth = (std::max)(1u, desc.Width >> mip);
+		uint64_t mipHeight = (std::max)(1u, desc.Height >> mip);
+
+		if (blockCompressed) {
+			mipWidth = (mipWidth + 3) / 4;
+			mipHeight = (mipHeight + 3) / 4;
+		}
+
+		size += mipWidth * mipHeight * unitBytes;
+	}
+
+	return size * desc.ArraySize;
+}
+
+void AssetManager::SetAssetMemoryBudget(uint64_t budgetBytes) {
+	assetMemoryBudget = budgetBytes;
+}
+
+uint64_t AssetManager::GetAssetMemoryBudget() {
+	return assetMemoryBudget;
+}
+
+void AssetManager::SetIndexedAssetCounter(std::function<IndexedAssetCounts()> counter) {
+	indexedAssetCounter = counter;
+}
+
+void AssetManager::SetMeshResidency(MeshResidency residency) {
+	Mesh::SetDefaultResidency(residency);
+
+	for (std::shared_ptr<Mesh> mesh : globalMeshes) {
+		mesh->SetResidency(residency);
+	}
+}
+
+void AssetManager::SetTextureCompressionPreset(TexturePreset preset) {
+	textureCompressionPreset = preset;
+}
+
+TexturePreset AssetManager::GetTextureCompressionPreset() {
+	return textureCompressionPreset;
+}
+
+/// <summary>
+/// Estimates how many texels across the screen a material's textures cover on
+/// an object, from its bounds' longest side and the distance to the closest
+/// point on them. Tiling repeats the texture, so each repeat covers less.
+/// </summary>
+static float GetStreamingScreenSize(const DirectX::BoundingOrientedBox& bounds, DirectX::XMFLOAT3 cameraPosition, float pixelsPerUnit, float nearDist, float tiling) {
+	DirectX::XMVECTOR extents = DirectX::XMLoadFloat3(&bounds.Extents);
+	DirectX::XMVECTOR localPosition = DirectX::XMVector3InverseRotate(
+		DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&cameraPosition), DirectX::XMLoadFloat3(&bounds.Center)),
+		DirectX::XMLoadFloat4(&bounds.Orientation));
+	DirectX::XMVECTOR closest = DirectX::XMVectorClamp(localPosition, DirectX::XMVectorNegate(extents), extents);
+
+	float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(localPosition, closest)));
+	distance = (std::max)(distance, nearDist);
+
+	float size = 2.0f * (std::max)(bounds.Extents.x, (std::max)(bounds.Extents.y, bounds.Extents.z));
+
+	return size * pixelsPerUnit / (distance * (std::max)(tiling, 0.001f));
+}
+
+void AssetManager::UpdateTextureStreaming(std::shared_ptr<Camera> camera, float viewportHeight) {
+	ReleaseUnusedStreamedTextures();
+	if (streamedTextureSources.empty() || camera == nullptr) return;
+
+	DirectX::XMFLOAT4X4 view = camera->GetViewMatrix();
+	DirectX::XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+
+	DirectX::BoundingFrustum frustum;
+	DirectX::BoundingFrustum::CreateFromMatrix(frustum, DirectX::XMLoadFloat4x4(&projection));
+	frustum.Transform(frustum, DirectX::XMMatrixInverse(nullptr, DirectX::XMLoadFloat4x4(&view)));
+
+	DirectX::XMFLOAT3 cameraPosition = camera->GetTransform()->GetGlobalPosition();
+	float pixelsPerUnit = viewportHeight / (2.0f * tanf(camera->GetFOV() * 0.5f));
+
+	for (std::shared_ptr<MeshRenderer> meshRenderer : ComponentManager::GetAll<MeshRenderer>()) {
+		if (!meshRenderer->IsEnabled() || meshRenderer->GetMaterial() == nullptr) continue;
+
+		DirectX::BoundingOrientedBox bounds = meshRenderer->GetBounds();
+		if (!frustum.Intersects(bounds)) continue;
+
+		// Orthographic views don't shrink with distance, so whatever's in them gets everything
+		float screenSize = camera->IsPerspective() ?
+			GetStreamingScreenSize(bounds, cameraPosition, pixelsPerUnit, camera->GetNearDist(), meshRenderer->GetMaterial()->GetTiling()) :
+			FLT_MAX;
+
+		RequestMaterialStreaming(meshRenderer->GetMaterial(), screenSize);
+	}
+
+	for (std::shared_ptr<Terrain> terrain : ComponentManager::GetAll<Terrain>()) {
+		if (!terrain->IsEnabled() || terrain->GetMaterial() == nullptr) continue;
+
+		DirectX::BoundingOrientedBox bounds = terrain->GetBounds();
+		if (!frustum.Intersects(bounds)) continue;
+
+		// Sized for the near tiling, which is the more detailed of the two
+		float screenSize = camera->IsPerspective() ?
+			GetStreamingScreenSize(bounds, cameraPosition, pixelsPerUnit, camera->GetNearDist(), TERRAIN_UV_MULT_NEAR) :
+			FLT_MAX;
+
+		std::shared_ptr<TerrainMaterial> terrainMaterial = terrain->GetMaterial();
+		for (int i = 0; i < terrainMaterial->GetMaterialCount(); i++) {
+			RequestMaterialStreaming(terrainMaterial->GetMaterialAtID(i), screenSize);
+		}
+	}
+
+	std::vector<TextureStreamingChange> changes;
+	textureStreamer.Update(Time::totalTime, &changes);
+
+	for (const TextureStreamingChange& change : changes) {
+		if (change.evict) EvictStreamedMips(change);
+		else StreamInMips(change);
+	}
+}
+
+void AssetManager::RequestMaterialStreaming(std::shared_ptr<Material> material, float screenSize) {
+	if (material == nullptr) return;
+
+	std::shared_ptr<Texture> textures[] = { material->GetTexture(), material->GetNormalMap(), material->GetRoughMap(), material->GetMetalMap() };
+	for (std::shared_ptr<Texture> texture : textures) {
+		if (texture == nullptr || texture->GetStreamingID() == 0) continue;
+
+		textureStreamer.RequestScreenSize(texture->GetStreamingID(), screenSize, Time::totalTime);
+	}
+}
+
+/// <summary>
+/// Stops streaming textures that were removed. Their source holds the last
+/// reference to the GPU texture, so this is also what frees it.
+/// </summary>
+void AssetManager::ReleaseUnusedStreamedTextures() {
+	std::unordered_set<unsigned int> liveIDs;
+	for (std::shared_ptr<Texture> texture : globalTextures) {
+		if (texture->GetStreamingID() != 0) liveIDs.insert(texture->GetStreamingID());
+	}
+
+	for (auto it = streamedTextureSources.begin(); it != streamedTextureSources.end();) {
+		if (liveIDs.count(it->first) > 0) {
+			it++;
+			continue;
+		}
+
+		textureStreamer.Unregister(it->first);
+		it = streamedTextureSources.erase(it);
+	}
+}
+
+/// <summary>
+/// Drops a streamed texture's most detailed mips by copying the rest into a
+/// smaller texture on the GPU, so nothing has to be read from disk
+/// </summary>
+void AssetManager::EvictStreamedMips(const TextureStreamingChange& change) {
+	StreamedTextureStatus status;
+	auto found = streamedTextureSources.find(change.id);
+	if (found == streamedTextureSources.end() || !textureStreamer.GetStatus(change.id, &status)) return;
+
+	Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> oldTexture;
+	found->second.textureView->GetResource(resource.GetAddressOf());
+	if (FAILED(resource.As(&oldTexture))) {
+		textureStreamer.CompleteChange(change.id, status.residentMip, true);
+		return;
+	}
+
+	unsigned int skippedMips = change.residentMip - status.residentMip;
+
+	D3D11_TEXTURE2D_DESC desc;
+	oldTexture->GetDesc(&desc);
+	desc.Width = (std::max)(1u, desc.Width >> skippedMips);
+	desc.Height = (std::max)(1u, desc.Height >> skippedMips);
+	desc.MipLevels -= skippedMips;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> newTexture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> newView;
+	if (FAILED(device->CreateTexture2D(&desc, nullptr, newTexture.GetAddressOf())) ||
+		FAILED(device->CreateShaderResourceView(newTexture.Get(), nullptr, newView.GetAddressOf()))) {
+		textureStreamer.CompleteChange(change.id, status.residentMip, true);
+		return;
+	}
+
+	for (UINT mip = 0; mip < desc.MipLevels; mip++) {
+		context->CopySubresourceRegion(newTexture.Get(), mip, 0, 0, 0, oldTexture.Get(), mip + skippedMips, nullptr);
+	}
+
+	SwapStreamedTexture(change.id, newView);
+	textureStreamer.CompleteChange(change.id, change.residentMip);
 }
 
-std::shared_ptr<SimpleVertexShader> AssetManager::GetVertexShaderAtID(int id) {
-	return this->vertexShaders[id];
-}
+/// <summary>
+/// Reloads a streamed texture on a JobSystem worker, then swaps in a
+/// texture with the wanted mips on the main thread. If the file changed
+/// since it was first loaded, the resident mips are kept.
+/// </summary>
+void AssetManager::StreamInMips(const TextureStreamingChange& change) {
+	auto found = streamedTextureSources.find(change.id);
+	if (found == streamedTextureSources.end()) return;
+
+	unsigned int streamingID = change.id;
+	unsigned int residentMip = change.residentMip;
+	std::string fullPath = found->second.fullPath;
+	TexturePreset preset = found->second.preset;
+
+	JobSystem::GetInstance().Schedule([this, streamingID, residentMip, fullPath, preset]() {
+		std::shared_ptr<DecodedTexture> decodedTexture = std::make_shared<DecodedTexture>();
+		HRESULT result = DecodeAndCompressTextureFile(fullPath, preset, decodedTexture.get());
+
+		JobSystem::GetInstance().QueueMainThreadJob([this, streamingID, residentMip, decodedTexture, result]() {
+			// The texture may have been removed while it was loading
+			StreamedTextureStatus status;
+			if (!textureStreamer.GetStatus(streamingID, &status)) return;
+
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> newView;
+			if (SUCCEEDED(result) &&
+				decodedTexture->width == status.width &&
+				decodedTexture->height == status.height &&
+				decodedTexture->mipLevels == status.mipCount &&
+				decodedTexture->format == status.format) {
+				newView = CreateTextureFromDecoded(*decodedTexture, residentMip);
+			}
 
-std::shared_ptr<SimplePixelShader> AssetManager::GetPixelShaderAtID(int id) {
-	return this->pixelShaders[id];
-}
+			if (newView == nullptr) {
+				textureStreamer.CompleteChange(streamingID, status.residentMip, true);
+				return;
+			}
 
-std::shared_ptr<SimpleComputeShader> AssetManager::GetComputeShaderAtID(int id) {
-	return this->computeShaders[id];
+			SwapStreamedTexture(streamingID, newView);
+			textureStreamer.CompleteChange(streamingID, residentMip);
+		});
+	});
 }
 
-std::shared_ptr<GameEntity> AssetManager::GetGameEntityAtID(int id) {
-	return this->globalEntities[id];
-}
+/// <summary>
+/// Points every texture streamed under an id, and the cache entry they came from, at a new view
+/// </summary>
+void AssetManager::SwapStreamedTexture(unsigned int streamingID, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureView) {
+	StreamedTextureSource& source = streamedTextureSources[streamingID];
 
-std::shared_ptr<TerrainMaterial> AssetManager::GetTerrainMaterialAtID(int id) {
-	return this->globalTerrainMaterials[id];
-}
+	for (std::shared_ptr<Texture> texture : globalTextures) {
+		if (texture->GetStreamingID() == streamingID) texture->SetTexture(textureView);
+	}
 
-std::shared_ptr<Camera> AssetManager::GetMainCamera() {
-	if (mainCamera != nullptr)
-		return mainCamera;
-	return editingCamera;
+	assetCache.ReplaceTextureView(source.textureView.Get(), textureView);
+	source.textureView = textureView;
 }
 
-void AssetManager::SetMainCamera(std::shared_ptr<Camera> newMain)
-{
-	mainCamera = newMain;
-	//mainCamera->SetAspectRatio((float)windowWidth / (float)this->height);
+void AssetManager::SetTextureStreamingBudget(uint64_t budgetBytes) {
+	textureStreamer.SetBudget(budgetBytes);
 }
 
-std::shared_ptr<Camera> AssetManager::GetEditingCamera() {
-	return editingCamera;
+uint64_t AssetManager::GetTextureStreamingBudget() {
+	return textureStreamer.GetBudget();
 }
 
-void AssetManager::UpdateEditingCamera()
-{
-	editingCamera->GetGameEntity()->PropagateEvent(EntityEventType::Update);
+TextureStreamingStats AssetManager::GetTextureStreamingStats() {
+	return textureStreamer.GetStats();
 }
 
-#pragma region buildAssetData
-std::shared_ptr<Mesh> AssetManager::LoadTerrain(const char* filename, unsigned int mapWidth, unsigned int mapHeight, float heightScale) {
-
-	std::string fullPath = GetFullPathToAssetFile(AssetPathIndex::ASSET_HEIGHTMAP_PATH, filename);
+bool AssetManager::GetTextureStreamingStatus(std::shared_ptr<Texture> texture, OUT StreamedTextureStatus* status) {
+	if (texture == nullptr || texture->GetStreamingID() == 0) return false;
 
-	unsigned int numVertices = mapWidth * mapHeight;
-	unsigned int numIndices = (mapWidth - 1) * (mapHeight - 1) * 6;
-
-	std::vector<unsigned short> heights(numVertices);
-	std::vector<float> finalHeights(numVertices);
+	return textureStreamer.GetStatus(texture->GetStreamingID(), status);
+}
 
-	std::vector<Vertex> vertices(numVertices);
-	std::vector<unsigned int> indices(numIndices);
-	std::vector<XMFLOAT3> triangleNormals;
+MeshResidencyStats AssetManager::GetMeshResidencyStats() {
+	MeshResidencyStats stats;
 
-	//Read the file
-	std::ifstream file;
-	file.open(fullPath.c_str(), std::ios_base::binary);
+	for (std::shared_ptr<Mesh> mesh : globalMeshes) {
+		// Deferred meshes haven't loaded anything to keep yet
+		if (mesh->IsLoadDeferred()) continue;
 
-	if (file) {
-		file.read((char*)&heights[0], (std::streamsize)numVertices * 2);
-		file.close();
-	}
-	else {
-		return nullptr;
+		MeshResidency residency = mesh->GetResidency();
+		stats.meshCounts[residency]++;
+		stats.cpuBytes[residency] += mesh->GetCPUMemorySize();
 	}
 
-	int index = 0;
-	int indexCounter = 0;
-	for (int z = 0; z < (int)mapHeight; z++) {
-		for (int x = 0; x < (int)mapWidth; x++) {
-			//Get height map and positional data
-			index = mapWidth * z + x;
-			finalHeights[index] = (heights[index] / 65535.0f) * heightScale;
+	return stats;
+}
+#pragma endregion
 
-			XMFLOAT3 position = XMFLOAT3((float)x, finalHeights[index], (float)z);
+#pragma region hotReload
+bool AssetManager::SetHotReloadEnabled(bool enabled) {
+	if (!enabled) {
+		assetWatcher.Stop();
+		cookedWatcher.Stop();
+		hotReloadStats.watching = false;
+		return true;
+	}
 
-			if (z != mapHeight - 1 && x != mapWidth - 1) {
-				//Calculate indices
-				int i0 = index;
-				int i1 = index + mapWidth;
-				int i2 = index + 1 + mapWidth;
+	std::string assetFolder = GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, "..\\");
 
-				int i3 = index;
-				int i4 = index + 1 + mapWidth;
-				int i5 = index + 1;
+	// The cooker mirrors Assets/ into a Cooked/ folder next to it
+	std::string cookedFolder = assetFolder;
+	while (!cookedFolder.empty() && cookedFolder.back() == '\\') cookedFolder.pop_back();
+	cookedFolder = cookedFolder.substr(0, cookedFolder.find_last_of('\\') + 1) + "Cooked\\";
 
-				indices[indexCounter++] = i0;
-				indices[indexCounter++] = i1;
-				indices[indexCounter++] = i2;
+	bool watchingAssets = assetWatcher.IsWatching() || assetWatcher.Start(assetFolder);
+	bool watchingCooked = cookedWatcher.IsWatching() || cookedWatcher.Start(cookedFolder);
 
-				indices[indexCounter++] = i3;
-				indices[indexCounter++] = i4;
-				indices[indexCounter++] = i5;
+	hotReloadStats.watching = watchingAssets || watchingCooked;
 
-				XMVECTOR pos0 = XMLoadFloat3(&vertices[i0].Position);
-				XMVECTOR pos1 = XMLoadFloat3(&vertices[i1].Position);
-				XMVECTOR pos2 = XMLoadFloat3(&vertices[i2].Position);
+	return hotReloadStats.watching;
+}
 
-				XMVECTOR pos3 = XMLoadFloat3(&vertices[i3].Position);
-				XMVECTOR pos4 = XMLoadFloat3(&vertices[i4].Position);
-				XMVECTOR pos5 = XMLoadFloat3(&vertices[i5].Position);
+bool AssetManager::IsHotReloadEnabled() {
+	return hotReloadStats.watching;
+}
 
-				XMFLOAT3 normal0;
-				XMFLOAT3 normal1;
+size_t AssetManager::UpdateHotReload() {
+	if (!hotReloadStats.watching) return 0;
 
-				XMStoreFloat3(&normal0, XMVector3Normalize(XMVector3Cross(pos1 - pos0, pos2 - pos0)));
-				XMStoreFloat3(&normal1, XMVector3Normalize(XMVector3Cross(pos4 - pos3, pos5 - pos3)));
+	std::vector<std::string> changedPaths;
+	std::vector<std::string> cookedPaths;
+	assetWatcher.Poll(&changedPaths);
+	cookedWatcher.Poll(&cookedPaths);
+	changedPaths.insert(changedPaths.end(), cookedPaths.begin(), cookedPaths.end());
 
-				triangleNormals.push_back(normal0);
-				triangleNormals.push_back(normal1);
-			}
+	// A source and its cooked file usually change together, and only need one reload
+	std::map<std::string, std::string> sourcePaths;
+	for (const std::string& changedPath : changedPaths) {
+		std::string sourcePath = GetHotReloadSourcePath(changedPath);
+		if (!sourcePath.empty()) sourcePaths.emplace(AssetCache::NormalizePath(sourcePath), sourcePath);
+	}
 
-			//Calculate normals
-			int triIndex = index * 2 - (2 * z);
-			int triIndexPrevRow = triIndex - (mapWidth * 2 - 1);
-
-			int normalCount = 0;
-			XMVECTOR normalTotal = XMVectorSet(0, 0, 0, 0);
-
-			//Diagram stolen from Chris's code because it's too useful not to have
-			// x-----x-----x
-			// |\    |\    |  
-			// | \ u | \   |  
-			// |  \  |  \  |  ul = up left
-			// |   \ |   \ |  u  = up
-			// | ul \| ur \|  ur = up right
-			// x-----O-----x
-			// |\ dl |\ dr |  dl = down left
-			// | \   | \   |  d  = down
-			// |  \  |  \  |  dr = down right
-			// |   \ | d \ |
-			// |    \|    \|
-			// x-----x-----x
-
-			if (z > 0 && x > 0)
-			{
-				// "Up left" and "up"
-				normalTotal += XMLoadFloat3(&triangleNormals[triIndexPrevRow - 1]);
-				normalTotal += XMLoadFloat3(&triangleNormals[triIndexPrevRow]);
-
-				normalCount += 2;
-			}
+	size_t reloadedCount = 0;
+	for (auto& sourcePath : sourcePaths) {
+		reloadedCount += ReloadChangedFile(sourcePath.second);
+	}
 
-			if (z > 0 && x < (int)mapWidth - 1)
-			{
-				// "Up right"
-				normalTotal += XMLoadFloat3(&triangleNormals[triIndexPrevRow + 1]);
+	hotReloadStats.changedFiles += sourcePaths.size();
+	hotReloadStats.reloadedAssets += reloadedCount;
 
-				normalCount++;
-			}
+	return reloadedCount;
+}
 
-			if (z < (int)mapHeight - 1 && x > 0)
-			{
-				// "Down left"
-				normalTotal += XMLoadFloat3(&triangleNormals[triIndex - 1]);
+HotReloadStats AssetManager::GetHotReloadStats() {
+	return hotReloadStats;
+}
 
-				normalCount++;
-			}
+/// <summary>
+/// Maps a changed file to the source asset it affects. Cooked files map
+/// back to the file they were cooked from.
+/// </summary>
+/// <returns>Empty for files no asset is loaded from, like caches and temporary files</returns>
+std::string AssetManager::GetHotReloadSourcePath(std::string changedPath) {
+	std::string fileName = changedPath.substr(changedPath.find_last_of("\\/") + 1);
 
-			if (z < (int)mapHeight - 1 && x < (int)mapWidth - 1)
-			{
-				// "Down right" and "down"
-				normalTotal += XMLoadFloat3(&triangleNormals[triIndex]);
-				normalTotal += XMLoadFloat3(&triangleNormals[triIndex + 1]);
+	// Temporary files are renamed into place once they're written, which is reported on its own
+	if (fileName.empty() || fileName[0] == '.' || fileName.find(".tmp") != std::string::npos) return "";
 
-				normalCount += 2;
-			}
+	// Written by skies and shaders as they load
+	if (changedPath.find("\\" IBL_CACHE_FOLDER) != std::string::npos) return "";
+	if (changedPath.find("\\" SHADER_REFLECTION_FOLDER) != std::string::npos) return "";
 
-			normalTotal /= normalCount;
-			XMStoreFloat3(&vertices[index].normal, normalTotal);
+	std::string extension = std::experimental::filesystem::path(fileName).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+	bool isCookedFile = extension == MESH_FILE_EXTENSION || extension == TEXTURE_FILE_EXTENSION;
 
-			//Store data in vertex
-			XMFLOAT3 normal = XMFLOAT3(+0.0f, +1.0f, -0.0f);
-			XMFLOAT3 tangents = XMFLOAT3(+0.0f, +0.0f, +0.0f);
-			XMFLOAT2 UV = XMFLOAT2(x / (float)mapWidth, z / (float)mapWidth);
-			vertices[index] = { position, normal, tangents, UV };
-		}
+	std::string cookedFolder = cookedWatcher.GetFolder();
+	if (!cookedWatcher.IsWatching() || !IsSameOrInsideFolder(AssetCache::NormalizePath(changedPath), AssetCache::NormalizePath(cookedFolder))) {
+		// Mesh caches are written next to their sources while they load
+		return isCookedFile ? "" : changedPath;
 	}
 
-	//Mesh handles tangents
-	std::shared_ptr<Mesh> finalTerrain = std::make_shared<Mesh>(vertices.data(), numVertices, indices.data(), numIndices, device, "TerrainMesh");
+	// Anything else in Cooked/, like the cooker's database, isn't loaded
+	if (!isCookedFile) return "";
 
-	finalTerrain->SetFileNameKey(SerializeFileName("Assets\\HeightMaps\\", fullPath));
-	globalMeshes.push_back(finalTerrain);
-	Terrain::SetDefaults(finalTerrain, globalTerrainMaterials[0]);
+	std::string relativePath = changedPath.substr(cookedFolder.size() + 1);
+	relativePath.resize(relativePath.size() - extension.size());
 
-	return finalTerrain;
+	return GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, "..\\" + relativePath);
 }
 
-// --------------------------------------------------------
-// Loads six individual textures (the six faces of a cube map), then
-// creates a blank cube map and copies each of the six textures to
-// another face. Afterwards, creates a shader resource view for
-// the cube map and cleans up all of the temporary resources.
-// --------------------------------------------------------
-Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::CreateCubemap(
-	const wchar_t* right,
-	const wchar_t* left,
-	const wchar_t* up,
-	const wchar_t* down,
-	const wchar_t* front,
-	const wchar_t* back)
-{
-	// Load the 6 textures into an array.
-	// - We need references to the TEXTURES, not the SHADER RESOURCE VIEWS!
-	// - Specifically NOT generating mipmaps, as we usually don't need them for the sky!
-	// - Order matters here! +X, -X, +Y, -Y, +Z, -Z
-	ID3D11Texture2D* textures[6] = {};
-	CreateWICTextureFromFile(device.Get(), right, (ID3D11Resource**)&textures[0], 0);
-	CreateWICTextureFromFile(device.Get(), left, (ID3D11Resource**)&textures[1], 0);
-	CreateWICTextureFromFile(device.Get(), up, (ID3D11Resource**)&textures[2], 0);
-	CreateWICTextureFromFile(device.Get(), down, (ID3D11Resource**)&textures[3], 0);
-	CreateWICTextureFromFile(device.Get(), front, (ID3D11Resource**)&textures[4], 0);
-	CreateWICTextureFromFile(device.Get(), back, (ID3D11Resource**)&textures[5], 0);
-	// We'll assume all of the textures are the same color format and resolution,
-	// so get the description of the first shader resource view
-	D3D11_TEXTURE2D_DESC faceDesc = {};
-	textures[0]->GetDesc(&faceDesc);
-	// Describe the resource for the cube map, which is simply
-	// a "texture 2d array". This is a special GPU resource format,
-	// NOT just a C++ array of textures!!!
-	D3D11_TEXTURE2D_DESC cubeDesc = {};
-	cubeDesc.ArraySize = 6; // Cube map!
-	cubeDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE; // We'll be using as a texture in a shader
-	cubeDesc.CPUAccessFlags = 0; // No read back
-	cubeDesc.Format = faceDesc.Format; // Match the loaded texture's color format
-	cubeDesc.Width = faceDesc.Width; // Match the size
-	cubeDesc.Height = faceDesc.Height; // Match the size
-	cubeDesc.MipLevels = 1; // Only need 1
-	cubeDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE; // A CUBE MAP, not 6 separate textures
-	cubeDesc.Usage = D3D11_USAGE_DEFAULT; // Standard usage
-	cubeDesc.SampleDesc.Count = 1;
-	cubeDesc.SampleDesc.Quality = 0;
-	// Create the actual texture resource
-	ID3D11Texture2D* cubeMapTexture = 0;
-	device->CreateTexture2D(&cubeDesc, 0, &cubeMapTexture);
-	// Loop through the individual face textures and copy them,
-	// one at a time, to the cube map texure
-	for (int i = 0; i < 6; i++)
-	{
-		// Calculate the subresource position to copy into
-		unsigned int subresource = D3D11CalcSubresource(
-			0, // Which mip (zero, since there's only one)
-			i, // Which array element?
-			1); // How many mip levels are in the texture?
-			// Copy from one resource (texture) to another
-		context->CopySubresourceRegion(
-			cubeMapTexture, // Destination resource
-			subresource, // Dest subresource index (one of the array elements)
-			0, 0, 0, // XYZ location of copy
-			textures[i], // Source resource
-			0, // Source subresource index (we're assuming there's only one)
-			0); // Source subresource "box" of data to copy (zero means the whole thing)
-	}
-	// At this point, all of the faces have been copied into the
-	// cube map texture, so we can describe a shader resource view for it
-	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Format = cubeDesc.Format; // Same format as texture
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE; // Treat this as a cube!
-	srvDesc.TextureCube.MipLevels = 1; // Only need access to 1 mip
-	srvDesc.TextureCube.MostDetailedMip = 0; // Index of the first mip we want to see
-	// Make the SRV
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeSRV;
-	device->CreateShaderResourceView(cubeMapTexture, &srvDesc, cubeSRV.GetAddressOf());
-	// Now that we're done, clean up the stuff we don't need anymore
-	cubeMapTexture->Release(); // Done with this particular reference (the SRV has another)
-	for (int i = 0; i < 6; i++)
-		textures[i]->Release();
-	// Send back the SRV, which is what we need for our shaders
-	return cubeSRV;
+/// <summary>
+/// Gets the full path a serialized filename key was made from
+/// </summary>
+/// <param name="assetPath">Folder "t" keys are relative to</param>
+std::string AssetManager::GetFilenameKeySourcePath(std::string filenameKey, AssetPathIndex assetPath) {
+	if (filenameKey.empty()) return "";
+
+	if (filenameKey[0] == 't') return GetFullPathToAssetFile(assetPath, filenameKey.substr(1));
+	if (filenameKey[0] == 'f') return filenameKey.substr(1);
+
+	// Textures loaded from a full path keep it as their key
+	return filenameKey;
 }
 
 /// <summary>
-/// Loads a particle texture or set of particle textures
+/// Whether a normalized path is a folder, or anything under it
 /// </summary>
-/// <param name="textureNameToLoad">Name of the file or file path to load the texture(s) from</param>
-/// <param name="isMultiParticle">True to recursively load from the file path</param>
-/// <returns>An SRV for the loaded textures</returns>
-Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> AssetManager::LoadParticleTexture(std::string textureNameToLoad, bool isMultiParticle)
-{
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> particleTextureSRV;
-
-	if (isMultiParticle) {
-		// Load all particle textures in a specific subfolder
-		std::string assets = GetFullPathToAssetFile(AssetPathIndex::ASSET_PARTICLE_PATH, textureNameToLoad);
+bool AssetManager::IsSameOrInsideFolder(const std::string& normalizedPath, std::string normalizedFolder) {
+	while (!normalizedFolder.empty() && (normalizedFolder.back() == '\\' || normalizedFolder.back() == '/')) normalizedFolder.pop_back();
 
-		std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> textures;
-		int i = 0;
-		for (auto& p : std::experimental::filesystem::recursive_directory_iterator(assets)) {
-			textures.push_back(nullptr);
-			std::wstring path = L"";
-			ISimpleShader::ConvertToWide(p.path().string().c_str(), path);
+	if (normalizedFolder.empty() || normalizedPath.compare(0, normalizedFolder.size(), normalizedFolder) != 0) return false;
 
-			CreateWICTextureFromFile(device.Get(), context.Get(), (path).c_str(), (ID3D11Resource**)textures[i].GetAddressOf(), nullptr);
+	return normalizedPath.size() == normalizedFolder.size() ||
+		normalizedPath[normalizedFolder.size()] == '\\' ||
+		normalizedPath[normalizedFolder.size()] == '/';
+}
 
-			i++;
-		}
+/// <summary>
+/// Reloads every loaded asset made from a file
+/// </summary>
+/// <returns>The number of assets being reloaded</returns>
+size_t AssetManager::ReloadChangedFile(std::string fullPath) {
+	std::string normalizedPath = AssetCache::NormalizePath(fullPath);
 
-		D3D11_TEXTURE2D_DESC faceDesc = {};
-		textures[0]->GetDesc(&faceDesc);
+	size_t reloadedCount = 0;
+	reloadedCount += ReloadShaders(normalizedPath, fullPath);
+	reloadedCount += ReloadMeshes(normalizedPath, fullPath);
+	reloadedCount += ReloadTerrains(normalizedPath);
+	reloadedCount += ReloadTextures(normalizedPath, fullPath);
+	reloadedCount += ReloadBlendMaps(normalizedPath, fullPath);
+	reloadedCount += ReloadSkies(normalizedPath);
+	reloadedCount += ReloadParticleTextures(normalizedPath);
 
-		D3D11_TEXTURE2D_DESC multiTextureDesc = {};
-		multiTextureDesc.ArraySize = (int)textures.size();
-		multiTextureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-		multiTextureDesc.CPUAccessFlags = 0;
-		multiTextureDesc.Format = faceDesc.Format;
-		multiTextureDesc.Width = faceDesc.Width;
-		multiTextureDesc.Height = faceDesc.Height;
-		multiTextureDesc.MipLevels = 1;
-		multiTextureDesc.Usage = D3D11_USAGE_DEFAULT;
-		multiTextureDesc.SampleDesc.Count = 1;
-		multiTextureDesc.SampleDesc.Quality = 0;
+	return reloadedCount;
+}
 
-		ID3D11Texture2D* outputTexture;
-		device->CreateTexture2D(&multiTextureDesc, 0, &outputTexture);
+/// <summary>
+/// Loads compiled shaders again right away. Materials and skies hold
+/// the shader objects themselves, so they draw with the new ones.
+/// </summary>
+size_t AssetManager::ReloadShaders(const std::string& normalizedPath, const std::string& fullPath) {
+	size_t reloadedCount = 0;
 
-		for (int i = 0; i < (int)textures.size(); i++) {
-			unsigned int subresource = D3D11CalcSubresource(0, i, 1);
+	auto reloadShaders = [&](auto& shaders) {
+		for (auto& shader : shaders) {
+			if (AssetCache::NormalizePath(GetFilenameKeySourcePath(shader->GetFileNameKey(), ASSET_SHADER_PATH)) != normalizedPath) continue;
 
-			if (textures[i] != nullptr) {
-				context->CopySubresourceRegion(outputTexture, subresource, 0, 0, 0, (ID3D11Resource*)textures[i].Get(), 0, 0);
-			}
+			if (shader->ReloadShaderFile(fullPath)) reloadedCount++;
 		}
+	};
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-		srvDesc.Format = multiTextureDesc.Format;
-		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
-		srvDesc.Texture2DArray.MipLevels = 1;
-		srvDesc.Texture2DArray.ArraySize = (int)textures.size();
-
-		device->CreateShaderResourceView(outputTexture, &srvDesc, particleTextureSRV.GetAddressOf());
+	reloadShaders(vertexShaders);
+	reloadShaders(pixelShaders);
+	reloadShaders(computeShaders);
 
-		outputTexture->Release();
-	}
-	else {
-		std::wstring wAssetString;
-		ISimpleShader::ConvertToWide(dxInstance->GetAssetPathString(ASSET_PARTICLE_PATH) + textureNameToLoad, wAssetString);
+	return reloadedCount;
+}
 
-		CreateWICTextureFromFile(device.Get(), context.Get(), wAssetString.c_str(), nullptr, &particleTextureSRV);
+/// <summary>
+/// Reloads .obj meshes into the Mesh objects already drawn with them.
+/// Other model formats are imported as whole entity hierarchies, which
+/// would have to be imported again, so they're left alone.
+/// </summary>
+size_t AssetManager::ReloadMeshes(const std::string& normalizedPath, const std::string& fullPath) {
+	std::string extension = std::experimental::filesystem::path(fullPath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+	if (extension != ".obj") return 0;
+
+	size_t reloadedCount = 0;
+	for (std::shared_ptr<Mesh> mesh : globalMeshes) {
+		// Placeholders load whatever is there once they're used
+		if (mesh->IsLoadDeferred()) continue;
+		if (AssetCache::NormalizePath(GetFilenameKeySourcePath(mesh->GetFileNameKey(), ASSET_MODEL_PATH)) != normalizedPath) continue;
+
+		// The new contents get their own cache entry
+		assetCache.Release(mesh.get());
+
+		MeshLoadRequest request;
+		request.fullPath = fullPath;
+		request.id = mesh->GetName();
+		request.deferLoad = false;
+
+		MaterializeMesh(mesh, request);
+		reloadedCount++;
 	}
 
-	return particleTextureSRV;
+	return reloadedCount;
 }
-#pragma endregion
-
-#pragma region complexModels
-void AssetManager::CreateComplexGeometry() {
-	Assimp::Importer importer;
-	std::vector<std::shared_ptr<Material>> specialMaterials = std::vector<std::shared_ptr<Material>>();
-	std::string namePath = GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, "human.obj");
-	std::string serializedKey = SerializeFileName("Assets\\Models\\", namePath);
-
-	const aiScene* flashLightModel = importer.ReadFile(dxInstance->GetFullPathTo("..\\..\\..\\Assets\\Models\\human.obj").c_str(),
-		aiProcess_Triangulate |
-		aiProcess_JoinIdenticalVertices |
-		aiProcess_GenNormals |
-		aiProcess_ConvertToLeftHanded |
-		aiProcess_CalcTangentSpace);
-
-	if (flashLightModel != NULL) {
-		ProcessComplexModel(flashLightModel->mRootNode, flashLightModel, serializedKey, "Human");
-	}
 
-	namePath = GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, "hat.obj");
-	serializedKey = SerializeFileName("Assets\\Models\\", namePath);
+/// <summary>
+/// Builds terrains again from a changed heightmap, with the settings they were first built with
+/// </summary>
+size_t AssetManager::ReloadTerrains(const std::string& normalizedPath) {
+	size_t reloadedCount = 0;
+
+	for (auto source = terrainSources.begin(); source != terrainSources.end();) {
+		std::shared_ptr<Mesh> terrainMesh = source->mesh.lock();
+		if (terrainMesh == nullptr) {
+			source = terrainSources.erase(source);
+			continue;
+		}
 
-	const aiScene* hatModel = importer.ReadFile(dxInstance->GetFullPathTo("..\\..\\..\\Assets\\Models\\hat.obj").c_str(),
-		aiProcess_Triangulate |
-		aiProcess_JoinIdenticalVertices |
-		aiProcess_GenNormals |
-		aiProcess_ConvertToLeftHanded |
-		aiProcess_CalcTangentSpace);
+		if (AssetCache::NormalizePath(source->fullPath) == normalizedPath) {
+			std::shared_ptr<MeshLoadRequest> request = std::make_shared<MeshLoadRequest>();
+			request->fullPath = source->fullPath;
+			request->deferLoad = false;
 
-	if (hatModel != NULL) {
-		ProcessComplexModel(hatModel->mRootNode, hatModel, serializedKey, "Hat");
-	}
+			std::weak_ptr<Mesh> weakMesh = terrainMesh;
+			MeshFileTerrain settings = source->settings;
 
-}
+			deferredLoadsInFlight++;
+			JobSystem::GetInstance().Schedule([this, weakMesh, request, settings]() {
+				DecodeTerrainRequest(*request, settings);
 
-void AssetManager::ProcessComplexModel(aiNode* node, const aiScene* scene, std::string serializedFilenameKey, std::string name) {
-	for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		mesh->mName = name + "CM" + std::to_string(i);
+				JobSystem::GetInstance().QueueMainThreadJob([this, weakMesh, request]() {
+					deferredLoadsInFlight--;
 
-		std::shared_ptr<Mesh> newMesh = ProcessComplexMesh(mesh, scene);
-		std::shared_ptr<GameEntity> newEntity = CreateGameEntity(newMesh, GetMaterialByName("cobbleMat"), mesh->mName.C_Str());;
+					std::shared_ptr<Mesh> loadedMesh = weakMesh.lock();
+					if (loadedMesh == nullptr || !request->loaded) return;
 
-		globalMeshes.push_back(newMesh);
+					if (request->meshFile) {
+						loadedMesh->SetMeshData(*request->meshFile, device);
+					}
+					else {
+						loadedMesh->SetMeshData(request->meshData, device);
+					}
+				});
+			});
 
-		newEntity->GetTransform()->SetPosition(0.0f, 3.0f * i, 1.0f);
-		newEntity->GetTransform()->SetScale(0.25f, 0.25f, 0.25f);
+			reloadedCount++;
+		}
 
-		newMesh->SetFileNameKey(serializedFilenameKey);
+		source++;
 	}
 
-	for (unsigned int i = 0; i < node->mNumChildren; i++) {
-		ProcessComplexModel(node->mChildren[i], scene, serializedFilenameKey, name + "Child" + std::to_string(i));
-	}
+	return reloadedCount;
 }
 
-std::shared_ptr<Mesh> AssetManager::ProcessComplexMesh(aiMesh* mesh, const aiScene* scene) {
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
-	bool hasTangents = true;
+/// <summary>
+/// Decodes a changed image once, then points every Texture made from it at
+/// the new view. Materials hold the Texture objects, so they all pick it up.
+/// </summary>
+size_t AssetManager::ReloadTextures(const std::string& normalizedPath, const std::string& fullPath) {
+	std::vector<std::weak_ptr<Texture>> textures;
+	for (std::shared_ptr<Texture> texture : globalTextures) {
+		// Placeholders load whatever is there once they're used
+		if (texture->IsLoadDeferred()) continue;
+		if (AssetCache::NormalizePath(GetFilenameKeySourcePath(texture->GetTextureFilenameKey(), texture->GetAssetPathIndex())) != normalizedPath) continue;
+
+		// The new contents get their own cache entry
+		assetCache.Release(texture.get());
+		textures.push_back(texture);
+	}
+
+	if (textures.empty()) return 0;
 
-	for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-		Vertex tempV;
+	deferredLoadsInFlight++;
 
-		//Process position
-		tempV.Position.x = mesh->mVertices[i].x;
-		tempV.Position.y = mesh->mVertices[i].y;
-		tempV.Position.z = mesh->mVertices[i].z;
+	TexturePreset preset = textureCompressionPreset;
+	JobSystem::GetInstance().Schedule([this, textures, fullPath, preset]() {
+		std::shared_ptr<TextureLoadRequest> request = std::make_shared<TextureLoadRequest>();
+		request->cacheKey = GetTextureCacheKey(fullPath, preset);
+		request->result = DecodeAndCompressTextureFile(fullPath, preset, &request->decodedTexture);
 
-		//Process normals
-		tempV.normal.x = mesh->mNormals[i].x;
-		tempV.normal.y = mesh->mNormals[i].y;
-		tempV.normal.z = mesh->mNormals[i].z;
+		JobSystem::GetInstance().QueueMainThreadJob([this, textures, request, fullPath, preset]() {
+			deferredLoadsInFlight--;
+			if (FAILED(request->result)) return;
 
-		//Process tangents
-		if (mesh->mTangents != NULL) {
-			tempV.Tangent.x = mesh->mTangents[i].x;
-			tempV.Tangent.y = mesh->mTangents[i].y;
-			tempV.Tangent.z = mesh->mTangents[i].z;
-		}
-		else {
-			hasTangents = false;
-		}
+			// Another texture may have loaded the same contents already
+			AssetCacheEntry* cached = request->cacheKey.empty() ? nullptr : assetCache.Find(request->cacheKey);
 
-		//Process UV coords
-		for (int j = 0; j < 8; j++) {
-			if (mesh->mNumUVComponents[j] > 0 && mesh->mTextureCoords[j] != NULL) {
-				tempV.uv.x = mesh->mTextureCoords[0]->x;
-				tempV.uv.y = mesh->mTextureCoords[0]->y;
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureView;
+			unsigned int streamingID = 0;
+			if (cached != nullptr) {
+				textureView = cached->textureView;
+				streamingID = cached->texture->GetStreamingID();
 			}
 			else {
-				tempV.uv.x = 0;
-				tempV.uv.y = 0;
-				break;
+				textureView = CreateStreamedTexture(request->decodedTexture, fullPath, preset, &streamingID);
+				if (textureView == nullptr) return;
 			}
-		}
 
-		vertices.push_back(tempV);
-	}
+			// The old streaming id goes once nothing uses it, in ReleaseUnusedStreamedTextures
+			for (const std::weak_ptr<Texture>& texture : textures) {
+				std::shared_ptr<Texture> loadedTexture = texture.lock();
+				if (loadedTexture == nullptr) continue;
+
+				loadedTexture->SetTexture(textureView);
+				loadedTexture->SetStreamingID(streamingID);
+
+				if (cached != nullptr) {
+					assetCache.AddReference(loadedTexture.get(), request->cacheKey);
+				}
+				else {
+					CacheTexture(request->cacheKey, loadedTexture, request->decodedTexture);
+					cached = request->cacheKey.empty() ? nullptr : assetCache.Find(request->cacheKey);
+				}
+			}
+		});
+	});
 
-	for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-		aiFace face = mesh->mFaces[i];
-		for (unsigned int j = 0; j < face.mNumIndices; j++) {
-			indices.push_back(face.mIndices[j]);
-		}
+	return textures.size();
+}
+
+size_t AssetManager::ReloadBlendMaps(const std::string& normalizedPath, const std::string& fullPath) {
+	std::vector<std::weak_ptr<TerrainMaterial>> terrainMaterials;
+	for (std::shared_ptr<TerrainMaterial> terrainMaterial : globalTerrainMaterials) {
+		if (terrainMaterial->GetBlendMapFilenameKey().empty()) continue;
+		if (AssetCache::NormalizePath(GetFilenameKeySourcePath(terrainMaterial->GetBlendMapFilenameKey(), ASSET_TEXTURE_PATH_BASIC)) != normalizedPath) continue;
+
+		terrainMaterials.push_back(terrainMaterial);
 	}
 
-	//Old version of assimp doesn't match with material tutorial; implement manually?
-	//if (mesh->mMaterialIndex >= 0) {
-		//aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		//loadMaterial
-	//}
+	if (terrainMaterials.empty()) return 0;
 
-	if (hasTangents) return std::make_shared<Mesh>(vertices.data(), vertices.size(), indices.data(), indices.size(), 0, device, mesh->mName.C_Str() + std::string("Mesh"));
-	else return std::make_shared<Mesh>(vertices.data(), vertices.size(), indices.data(), indices.size(), device);
-}
-#pragma endregion
+	deferredLoadsInFlight++;
 
-#pragma region removeAssets
+	JobSystem::GetInstance().Schedule([this, terrainMaterials, fullPath]() {
+		std::shared_ptr<std::vector<char>> blendMapData = std::make_shared<std::vector<char>>();
+		bool fileRead = ReadFileBytes(fullPath, blendMapData.get());
 
-//
-// Asset Removal methods
-//
+		JobSystem::GetInstance().QueueMainThreadJob([this, terrainMaterials, blendMapData, fileRead]() {
+			deferredLoadsInFlight--;
 
-void AssetManager::CleanAllEntities()
-{
-	for (auto ge : globalEntities) {
-		ge->Release();
-	}
-	globalEntities.clear();
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> blendMap;
+			if (!fileRead || FAILED(CreateWICTextureFromMemory(device.Get(), context.Get(), (const uint8_t*)blendMapData->data(), blendMapData->size(), nullptr, blendMap.GetAddressOf()))) return;
+
+			for (const std::weak_ptr<TerrainMaterial>& terrainMaterial : terrainMaterials) {
+				std::shared_ptr<TerrainMaterial> loadedMaterial = terrainMaterial.lock();
+				if (loadedMaterial != nullptr) loadedMaterial->SetBlendMap(blendMap);
+			}
+		});
+	});
+
+	return terrainMaterials.size();
 }
 
-void AssetManager::CleanAllVectors() {
-	CleanAllEntities();
+/// <summary>
+/// Builds a sky again, IBL maps and all, and puts it in the old one's place
+/// in the sky list. Cube map folders reload when any of their faces change.
+/// </summary>
+size_t AssetManager::ReloadSkies(const std::string& normalizedPath) {
+	size_t reloadedCount = 0;
 
-	for (int i = 0; i < globalSounds.size(); i++) {
-		FMODUserData* uData;
-		globalSounds[i]->getUserData((void**)&uData);
-		uData->filenameKey.reset();
-		uData->name.reset();
-		delete uData;
-	}
+	for (std::shared_ptr<Sky> sky : skies) {
+		std::string skyPath = GetFilenameKeySourcePath(sky->GetFilenameKey(), ASSET_TEXTURE_PATH_SKIES);
+		if (skyPath.empty() || !IsSameOrInsideFolder(normalizedPath, AssetCache::NormalizePath(skyPath))) continue;
 
-	pixelShaders.clear();
-	vertexShaders.clear();
-	computeShaders.clear();
-	skies.clear();
-	globalMeshes.clear();
-	globalTextures.clear();
-	globalMaterials.clear();
-	globalTerrainMaterials.clear();
-	globalSounds.clear();
-	globalFonts.clear();
-	textureSampleStates.clear();
-	textureState = nullptr;
-	clampState = nullptr;
+		std::shared_ptr<SkyLoadRequest> request = std::make_shared<SkyLoadRequest>();
+		request->fullPath = skyPath;
+		request->filepath = DeSerializeFileName(sky->GetFilenameKey());
+		request->fileType = sky->GetFilenameKeyType();
+		request->name = sky->GetName();
+		request->fileExtension = sky->GetFileExtension();
+		HashSkyRequest(*request);
 
-	context->Flush();
-}
+		std::weak_ptr<Sky> weakSky = sky;
 
-void AssetManager::RemoveGameEntity(std::string name) {
-	RemoveGameEntity(GetGameEntityIDByName(name));
-}
+		deferredLoadsInFlight++;
+		JobSystem::GetInstance().Schedule([this, weakSky, request]() {
+			DecodeSkyRequest(*request);
 
-void AssetManager::RemoveGameEntity(int id) {
-	globalEntities[id]->Release();
-	globalEntities.erase(globalEntities.begin() + id);
-}
+			JobSystem::GetInstance().QueueMainThreadJob([this, weakSky, request]() {
+				deferredLoadsInFlight--;
 
-void AssetManager::RemoveSky(std::string name) {
-	skies.erase(skies.begin() + GetSkyIDByName(name));
-}
+				std::shared_ptr<Sky> oldSky = weakSky.lock();
+				if (oldSky == nullptr || FAILED(request->result)) return;
 
-void AssetManager::RemoveSky(int id) {
-	skies.erase(skies.begin() + id);
-}
+				auto found = std::find(skies.begin(), skies.end(), oldSky);
+				if (found == skies.end()) return;
+				size_t skyIndex = found - skies.begin();
 
-void AssetManager::RemoveVertexShader(std::string name) {
-	vertexShaders.erase(vertexShaders.begin() + GetVertexShaderIDByName(name));
-}
+				// The new contents get their own cache entry
+				assetCache.Release(oldSky.get());
 
-void AssetManager::RemoveVertexShader(int id) {
-	vertexShaders.erase(vertexShaders.begin() + id);
-}
+				// Made at the end of the list, then moved into the old sky's place
+				std::shared_ptr<Sky> newSky = CreateSkyFromRequest(*request);
+				skies.pop_back();
+				skies[skyIndex] = newSky;
 
-void AssetManager::RemovePixelShader(std::string name) {
-	pixelShaders.erase(pixelShaders.begin() + GetPixelShaderIDByName(name));
-}
+				newSky->SetEnabled(oldSky->IsEnabled());
+				if (currentSky == oldSky) currentSky = newSky;
+			});
+		});
 
-void AssetManager::RemovePixelShader(int id) {
-	pixelShaders.erase(pixelShaders.begin() + id);
-}
+		reloadedCount++;
+	}
 
-void AssetManager::RemoveMesh(std::string name) {
-	globalMeshes.erase(globalMeshes.begin() + GetMeshIDByName(name));
+	return reloadedCount;
 }
 
-void AssetManager::RemoveMesh(int id) {
-	globalMeshes.erase(globalMeshes.begin() + id);
-}
+/// <summary>
+/// Loads emitters' particle textures again. Emitters that load a
+/// whole folder reload when any texture in it changes.
+/// </summary>
+size_t AssetManager::ReloadParticleTextures(const std::string& normalizedPath) {
+	size_t reloadedCount = 0;
 
-void AssetManager::RemoveMaterial(std::string name) {
-	globalMaterials.erase(globalMaterials.begin() + GetMaterialIDByName(name));
-}
+	for (std::shared_ptr<ParticleSystem> emitter : ComponentManager::GetAll<ParticleSystem>()) {
+		std::string particlePath = GetFilenameKeySourcePath(emitter->GetFilenameKey(), ASSET_PARTICLE_PATH);
+		if (particlePath.empty() || !IsSameOrInsideFolder(normalizedPath, AssetCache::NormalizePath(particlePath))) continue;
 
-void AssetManager::RemoveMaterial(int id) {
-	globalMaterials.erase(globalMaterials.begin() + id);
-}
-/*
-void AssetManager::RemoveTerrainMaterial(std::string name) {
-	globalEntities.erase(globalEntities.begin() + GetGameEntityIDByName(name));
-}
+		MaterializeParticleTexture(emitter, DeSerializeFileName(emitter->GetFilenameKey()), emitter->IsMultiParticle());
+		reloadedCount++;
+	}
 
-void AssetManager::RemoveTerrainMaterial(int id) {
-	globalEntities.erase(globalEntities.begin() + id);
+	return reloadedCount;
 }
-*/
 #pragma endregion
 
 #pragma region nameSearch
@@ -2318,6 +4965,24 @@ int AssetManager::GetMeshIDByName(std::string name) {
 	return -1;
 }
 
+int AssetManager::GetTextureIDByName(std::string name) {
+	for (int i = 0; i < globalTextures.size(); i++) {
+		if (globalTextures[i]->GetName() == name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int AssetManager::GetTerrainMaterialIDByName(std::string name) {
+	for (int i = 0; i < globalTerrainMaterials.size(); i++) {
+		if (globalTerrainMaterials[i]->GetName() == name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
 int AssetManager::GetMaterialIDByName(std::string name) {
 	for (int i = 0; i < globalMaterials.size(); i++) {
 		if (globalMaterials[i]->GetName() == name) {
@@ -0,0 +1,503 @@
+#include "../Headers/AssetPack.h"
+#include "../Headers/JobSystem.h"
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+// 64 bit FNV-1a, same as AssetCache
+static const uint64_t fnvOffset = 14695981039346656037ull;
+static const uint64_t fnvPrime = 1099511628211ull;
+
+// LZ4 block format limits: matches are at least 4 bytes and reach back at most 64KB,
+// the last match starts at least 12 bytes from the end and the last 5 bytes are literals
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_MATCH_SEARCH_LIMIT 12
+#define LZ_LAST_LITERALS 5
+#define LZ_HASH_BITS 16
+
+AssetPack::AssetPack() {
+	header = nullptr;
+	entries = nullptr;
+	paths = nullptr;
+	pathsSize = 0;
+}
+
+#pragma region reading
+bool AssetPack::Open(const std::string& path) {
+	Close();
+
+	if (!file.Open(path)) return false;
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	const AssetPackHeader* fileHeader = (const AssetPackHeader*)data;
+
+	size_t entriesSize = size >= sizeof(AssetPackHeader) ? (size_t)fileHeader->entryCount * sizeof(AssetPackEntry) : 0;
+	bool valid = size >= sizeof(AssetPackHeader) &&
+		fileHeader->magic == ASSET_PACK_MAGIC &&
+		fileHeader->version == ASSET_PACK_VERSION &&
+		fileHeader->headerSize == sizeof(AssetPackHeader) &&
+		fileHeader->entrySize == sizeof(AssetPackEntry) &&
+		fileHeader->tocOffset <= size &&
+		fileHeader->tocSize == size - fileHeader->tocOffset &&
+		fileHeader->tocSize >= entriesSize &&
+		fileHeader->tocOffset % ASSET_PACK_DATA_ALIGNMENT == 0 &&
+		fileHeader->tocChecksum == HashContents(data + fileHeader->tocOffset, (size_t)fileHeader->tocSize);
+
+	if (!valid) {
+		Close();
+		return false;
+	}
+
+	this->path = path;
+	header = fileHeader;
+	entries = (const AssetPackEntry*)(data + header->tocOffset);
+	paths = (const char*)(data + header->tocOffset + entriesSize);
+	pathsSize = (size_t)header->tocSize - entriesSize;
+
+	// The checksum only proves the table is what was written, so every range is checked once here
+	for (uint32_t i = 0; i < header->entryCount; i++) {
+		const AssetPackEntry& entry = entries[i];
+		bool compressed = (entry.flags & ASSET_PACK_ENTRY_COMPRESSED) != 0;
+
+		if (entry.offset > header->tocOffset ||
+			entry.storedSize > header->tocOffset - entry.offset ||
+			(!compressed && entry.storedSize != entry.size) ||
+			(uint64_t)entry.pathOffset + entry.pathLength > pathsSize ||
+			(i > 0 && entries[i - 1].pathHash > entry.pathHash)) {
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void AssetPack::Close() {
+	file.Close();
+	path.clear();
+
+	header = nullptr;
+	entries = nullptr;
+	paths = nullptr;
+	pathsSize = 0;
+}
+
+const std::string& AssetPack::GetPath() const {
+	return path;
+}
+
+bool AssetPack::IsOpen() {
+	return header != nullptr;
+}
+
+const AssetPackEntry* AssetPack::Find(const std::string& packedPath) const {
+	if (header == nullptr) return nullptr;
+
+	std::string normalizedPath = NormalizePath(packedPath);
+	uint64_t pathHash = HashPath(normalizedPath);
+
+	const AssetPackEntry* end = entries + header->entryCount;
+	const AssetPackEntry* found = std::lower_bound(entries, end, pathHash, [](const AssetPackEntry& entry, uint64_t hash) {
+		return entry.pathHash < hash;
+	});
+
+	// Different paths can share a hash, so every entry with it is compared
+	for (; found != end && found->pathHash == pathHash; found++) {
+		if (NormalizePath(GetEntryPath(*found)) == normalizedPath) return found;
+	}
+
+	return nullptr;
+}
+
+uint32_t AssetPack::GetEntryCount() const {
+	return header == nullptr ? 0 : header->entryCount;
+}
+
+const AssetPackEntry* AssetPack::GetEntry(uint32_t index) const {
+	if (header == nullptr || index >= header->entryCount) return nullptr;
+
+	return &entries[index];
+}
+
+std::string AssetPack::GetEntryPath(const AssetPackEntry& entry) const {
+	return std::string(paths + entry.pathOffset, entry.pathLength);
+}
+
+const unsigned char* AssetPack::GetStoredData(const AssetPackEntry& entry) const {
+	if (header == nullptr || (entry.flags & ASSET_PACK_ENTRY_COMPRESSED)) return nullptr;
+
+	return (const unsigned char*)header + entry.offset;
+}
+
+bool AssetPack::Read(const AssetPackEntry& entry, std::vector<unsigned char>* data) const {
+	if (header == nullptr) return false;
+
+	const unsigned char* stored = (const unsigned char*)header + entry.offset;
+	data->resize((size_t)entry.size);
+
+	if (!(entry.flags & ASSET_PACK_ENTRY_COMPRESSED)) {
+		if (entry.size > 0) memcpy(data->data(), stored, (size_t)entry.size);
+		return true;
+	}
+
+	if (!Decompress(stored, (size_t)entry.storedSize, data->data(), data->size())) {
+		data->clear();
+		return false;
+	}
+
+	return true;
+}
+#pragma endregion
+
+#pragma region writing
+bool AssetPack::GetDiskStamp(const std::string& path, uint64_t* size, int64_t* modifiedTime) {
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+	if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &fileInfo) ||
+		(fileInfo.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) return false;
+
+	*size = ((uint64_t)fileInfo.nFileSizeHigh << 32) | fileInfo.nFileSizeLow;
+	// FILETIME counts 100ns ticks from 1601, move it to the Unix epoch
+	uint64_t ticks = ((uint64_t)fileInfo.ftLastWriteTime.dwHighDateTime << 32) | fileInfo.ftLastWriteTime.dwLowDateTime;
+	*modifiedTime = ((int64_t)ticks - 116444736000000000ll) * 100;
+#else
+	struct stat fileInfo;
+	if (stat(path.c_str(), &fileInfo) != 0 || !S_ISREG(fileInfo.st_mode)) return false;
+
+	*size = (uint64_t)fileInfo.st_size;
+	*modifiedTime = (int64_t)fileInfo.st_mtim.tv_sec * 1000000000ll + fileInfo.st_mtim.tv_nsec;
+#endif
+	return true;
+}
+
+bool AssetPack::Write(const std::string& path, const std::vector<AssetPackSource>& sources, AssetPackWriteStats* stats) {
+	struct PendingEntry {
+		AssetPackSource source;
+		std::string normalizedPath;
+		AssetPackEntry entry;
+		// Empty unless compressing saved enough
+		std::vector<unsigned char> compressed;
+		bool read;
+	};
+
+	// Sorted by path, so files in the same folder sit next to each other in the archive
+	std::vector<PendingEntry> pending(sources.size());
+	for (size_t i = 0; i < sources.size(); i++) {
+		pending[i].source = sources[i];
+		pending[i].normalizedPath = NormalizePath(sources[i].packedPath);
+	}
+	std::stable_sort(pending.begin(), pending.end(), [](const PendingEntry& a, const PendingEntry& b) {
+		return a.normalizedPath < b.normalizedPath;
+	});
+
+	// Packing the same path twice keeps the last one given
+	for (size_t i = 1; i < pending.size();) {
+		if (pending[i].normalizedPath == pending[i - 1].normalizedPath) pending.erase(pending.begin() + i - 1);
+		else i++;
+	}
+
+	JobSystem::GetInstance().ParallelFor(pending.size(), ASSET_PACK_GRAIN_SIZE, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			PendingEntry& item = pending[i];
+			item.entry = {};
+			item.read = false;
+
+			uint64_t sourceSize;
+			int64_t modifiedTime;
+			if (!GetDiskStamp(item.source.diskPath, &sourceSize, &modifiedTime)) continue;
+
+			item.entry.sourceSize = sourceSize;
+			item.entry.sourceModifiedTime = modifiedTime;
+			item.entry.contentHash = fnvOffset;
+
+			// Empty files can't be mapped, but they're still packed
+			MappedFile sourceFile;
+			if (sourceSize > 0) {
+				if (!sourceFile.Open(item.source.diskPath)) continue;
+
+				item.entry.size = sourceFile.GetSize();
+				item.entry.contentHash = HashContents(sourceFile.GetData(), sourceFile.GetSize());
+
+				// Match positions are kept in 32 bits, so anything bigger is stored
+				if (item.entry.size < ((uint64_t)1 << 31)) Compress(sourceFile.GetData(), sourceFile.GetSize(), &item.compressed);
+				if (item.compressed.size() > item.entry.size - item.entry.size * ASSET_PACK_MIN_SAVING / 16) {
+					std::vector<unsigned char>().swap(item.compressed);
+				}
+			}
+
+			item.read = true;
+		}
+	});
+
+	std::string tempPath = path + ".tmp";
+	std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+	if (!output.is_open()) return false;
+
+	AssetPackWriteStats writeStats;
+	std::vector<AssetPackEntry> tableEntries;
+	std::string tablePaths;
+
+	static const unsigned char zeroes[ASSET_PACK_DATA_ALIGNMENT] = {};
+	uint64_t offset = 0;
+	auto align = [&]() {
+		uint64_t padding = (ASSET_PACK_DATA_ALIGNMENT - offset % ASSET_PACK_DATA_ALIGNMENT) % ASSET_PACK_DATA_ALIGNMENT;
+		output.write((const char*)zeroes, (std::streamsize)padding);
+		offset += padding;
+	};
+
+	AssetPackHeader fileHeader = {};
+	output.write((const char*)&fileHeader, sizeof(fileHeader));
+	offset += sizeof(fileHeader);
+
+	for (PendingEntry& item : pending) {
+		if (!item.read) {
+			writeStats.failedPaths.push_back(item.source.diskPath);
+			continue;
+		}
+
+		align();
+
+		AssetPackEntry entry = item.entry;
+		entry.offset = offset;
+		entry.pathHash = HashPath(item.normalizedPath);
+		entry.pathOffset = (uint32_t)tablePaths.size();
+		entry.pathLength = (uint32_t)item.source.packedPath.size();
+		tablePaths += item.source.packedPath;
+
+		if (!item.compressed.empty()) {
+			entry.flags |= ASSET_PACK_ENTRY_COMPRESSED;
+			entry.storedSize = item.compressed.size();
+			output.write((const char*)item.compressed.data(), (std::streamsize)item.compressed.size());
+			writeStats.compressedCount++;
+		}
+		else {
+			// Stored files are mapped again rather than kept around from the compression pass
+			entry.storedSize = entry.size;
+			MappedFile sourceFile;
+			if (entry.size > 0) {
+				if (!sourceFile.Open(item.source.diskPath) || sourceFile.GetSize() != entry.size) {
+					output.close();
+					std::remove(tempPath.c_str());
+					return false;
+				}
+				output.write((const char*)sourceFile.GetData(), (std::streamsize)entry.size);
+			}
+		}
+
+		offset += entry.storedSize;
+		writeStats.fileCount++;
+		writeStats.originalBytes += entry.size;
+		tableEntries.push_back(entry);
+	}
+
+	align();
+
+	std::stable_sort(tableEntries.begin(), tableEntries.end(), [](const AssetPackEntry& a, const AssetPackEntry& b) {
+		return a.pathHash < b.pathHash;
+	});
+
+	std::vector<unsigned char> table(tableEntries.size() * sizeof(AssetPackEntry) + tablePaths.size());
+	if (!tableEntries.empty()) memcpy(table.data(), tableEntries.data(), tableEntries.size() * sizeof(AssetPackEntry));
+	if (!tablePaths.empty()) memcpy(table.data() + tableEntries.size() * sizeof(AssetPackEntry), tablePaths.data(), tablePaths.size());
+	output.write((const char*)table.data(), (std::streamsize)table.size());
+
+	fileHeader.magic = ASSET_PACK_MAGIC;
+	fileHeader.version = ASSET_PACK_VERSION;
+	fileHeader.headerSize = sizeof(AssetPackHeader);
+	fileHeader.entrySize = sizeof(AssetPackEntry);
+	fileHeader.entryCount = (uint32_t)tableEntries.size();
+	fileHeader.tocOffset = offset;
+	fileHeader.tocSize = table.size();
+	fileHeader.tocChecksum = HashContents(table.data(), table.size());
+
+	output.seekp(0);
+	output.write((const char*)&fileHeader, sizeof(fileHeader));
+
+	bool written = output.good();
+	output.close();
+
+	writeStats.packedBytes = offset + table.size();
+	if (stats != nullptr) *stats = writeStats;
+
+	if (!written) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	return MappedFile::CommitTempFile(tempPath, path);
+}
+#pragma endregion
+
+#pragma region hashing
+std::string AssetPack::NormalizePath(const std::string& path) {
+	std::string normalized = path;
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+	return normalized;
+}
+
+uint64_t AssetPack::HashPath(const std::string& normalizedPath) {
+	return HashContents((const unsigned char*)normalizedPath.data(), normalizedPath.size());
+}
+
+uint64_t AssetPack::HashContents(const unsigned char* data, size_t size) {
+	uint64_t hash = fnvOffset;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= fnvPrime;
+	}
+
+	return hash;
+}
+#pragma endregion
+
+#pragma region compression
+static uint32_t ReadUInt32(const unsigned char* data) {
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static void WriteLength(size_t length, std::vector<unsigned char>* output) {
+	while (length >= 255) {
+		output->push_back(255);
+		length -= 255;
+	}
+	output->push_back((unsigned char)length);
+}
+
+/// <summary>
+/// Writes one sequence: literals, then a match unless it's the last one
+/// </summary>
+static void WriteSequence(const unsigned char* literals, size_t literalLength, size_t offset, size_t matchLength, std::vector<unsigned char>* output) {
+	size_t matchCode = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+
+	output->push_back((unsigned char)(((std::min)(literalLength, (size_t)15) << 4) | (std::min)(matchCode, (size_t)15)));
+	if (literalLength >= 15) WriteLength(literalLength - 15, output);
+	output->insert(output->end(), literals, literals + literalLength);
+
+	if (matchLength == 0) return;
+
+	output->push_back((unsigned char)(offset & 0xFF));
+	output->push_back((unsigned char)(offset >> 8));
+	if (matchCode >= 15) WriteLength(matchCode - 15, output);
+}
+
+void AssetPack::Compress(const unsigned char* data, size_t size, std::vector<unsigned char>* compressed) {
+	compressed->clear();
+	compressed->reserve(size + size / 255 + 16);
+
+	size_t anchor = 0;
+
+	if (size > LZ_MATCH_SEARCH_LIMIT) {
+		// Last position seen for each hash of 4 bytes, plus one so 0 means none
+		std::vector<uint32_t> table((size_t)1 << LZ_HASH_BITS, 0);
+
+		size_t searchEnd = size - LZ_MATCH_SEARCH_LIMIT;
+		size_t matchEnd = size - LZ_LAST_LITERALS;
+		size_t position = 0;
+
+		while (position < searchEnd) {
+			uint32_t sequence = ReadUInt32(data + position);
+			uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+			size_t candidate = table[hash];
+			table[hash] = (uint32_t)(position + 1);
+
+			if (candidate == 0 || position - (candidate - 1) > LZ_MAX_OFFSET || ReadUInt32(data + candidate - 1) != sequence) {
+				// Runs without matches are skipped faster the longer they get, like the reference encoder
+				position += 1 + ((position - anchor) >> 6);
+				continue;
+			}
+
+			size_t match = candidate - 1;
+			size_t length = LZ_MIN_MATCH;
+			while (position + length < matchEnd && data[match + length] == data[position + length]) {
+				length++;
+			}
+
+			// Matches can usually start a little earlier than where they were found
+			while (position > anchor && match > 0 && data[position - 1] == data[match - 1]) {
+				position--;
+				match--;
+				length++;
+			}
+
+			WriteSequence(data + anchor, position - anchor, position - match, length, compressed);
+
+			position += length;
+			anchor = position;
+		}
+	}
+
+	WriteSequence(data + anchor, size - anchor, 0, 0, compressed);
+}
+
+bool AssetPack::Decompress(const unsigned char* compressed, size_t compressedSize, unsigned char* data, size_t size) {
+	size_t input = 0;
+	size_t output = 0;
+
+	while (input < compressedSize) {
+		unsigned char token = compressed[input++];
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15) {
+			unsigned char extra;
+			do {
+				if (input >= compressedSize) return false;
+				extra = compressed[input++];
+				literalLength += extra;
+			} while (extra == 255);
+		}
+
+		if (literalLength > compressedSize - input || literalLength > size - output) return false;
+		memcpy(data + output, compressed + input, literalLength);
+		input += literalLength;
+		output += literalLength;
+
+		// The last sequence is only literals
+		if (input == compressedSize) break;
+
+		if (compressedSize - input < 2) return false;
+		size_t offset = compressed[input] | ((size_t)compressed[input + 1] << 8);
+		input += 2;
+		if (offset == 0 || offset > output) return false;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15) {
+			unsigned char extra;
+			do {
+				if (input >= compressedSize) return false;
+				extra = compressed[input++];
+				matchLength += extra;
+			} while (extra == 255);
+		}
+		matchLength += LZ_MIN_MATCH;
+
+		if (matchLength > size - output) return false;
+
+		// Matches can overlap what they're writing, which repeats the overlapped bytes
+		const unsigned char* source = data + output - offset;
+		if (offset >= matchLength) {
+			memcpy(data + output, source, matchLength);
+		}
+		else {
+			for (size_t i = 0; i < matchLength; i++) {
+				data[output + i] = source[i];
+			}
+		}
+		output += matchLength;
+	}
+
+	return output == size;
+}
+#pragma endregion
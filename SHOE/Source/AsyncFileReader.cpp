@@ -0,0 +1,365 @@
+#include "../Headers/AsyncFileReader.h"
+#include <algorithm>
+#include <set>
+
+AsyncFileReader* AsyncFileReader::instance;
+
+AsyncFileReader::AsyncFileReader() {
+	nextSequence = 0;
+	running = false;
+	totalLatency = 0;
+}
+
+AsyncFileReader::~AsyncFileReader() {
+	Shutdown();
+}
+
+#pragma region threads
+void AsyncFileReader::Initialize(unsigned int threadCount) {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if (running) return;
+
+	running = true;
+	for (unsigned int i = 0; i < (std::max)(1u, threadCount); i++) {
+		threads.push_back(std::thread(&AsyncFileReader::ThreadLoop, this));
+	}
+}
+
+void AsyncFileReader::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		if (!running) return;
+		running = false;
+	}
+
+	readAvailable.notify_all();
+
+	for (std::thread& thread : threads) {
+		if (thread.joinable()) thread.join();
+	}
+
+	threads.clear();
+
+	std::map<QueueKey, PendingRead> remaining;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		remaining.swap(queue);
+		sources.clear();
+	}
+
+	for (auto& entry : remaining) {
+		AsyncReadResult result;
+		result.path = entry.second.path;
+		Complete(entry.second, result, false);
+	}
+}
+
+void AsyncFileReader::ThreadLoop() {
+	// Each thread keeps its own handle to the archive it read last
+	std::ifstream archive;
+	std::string archivePath;
+
+	std::vector<PendingRead> reads;
+	while (TakeReads(&reads)) {
+		if (reads[0].pack != nullptr) ReadPacked(reads, archive, &archivePath);
+		else ReadLoose(reads);
+	}
+}
+#pragma endregion
+
+#pragma region requests
+void AsyncFileReader::Read(const std::string& path, AsyncReadPriority priority, AsyncReadCallback callback) {
+	std::vector<PendingRead> reads;
+	reads.push_back(MakeRead(path, callback));
+	Enqueue(reads, priority);
+}
+
+std::future<AsyncReadResult> AsyncFileReader::Read(const std::string& path, AsyncReadPriority priority) {
+	// std::function has to be copyable, so the promise is shared
+	std::shared_ptr<std::promise<AsyncReadResult>> promise = std::make_shared<std::promise<AsyncReadResult>>();
+	std::future<AsyncReadResult> future = promise->get_future();
+
+	Read(path, priority, [promise](AsyncReadResult& result) {
+		promise->set_value(std::move(result));
+	});
+
+	return future;
+}
+
+void AsyncFileReader::ReadBatch(const std::vector<std::string>& paths, AsyncReadPriority priority, std::function<void(size_t index, AsyncReadResult& result)> callback) {
+	std::vector<PendingRead> reads;
+	reads.reserve(paths.size());
+
+	for (size_t i = 0; i < paths.size(); i++) {
+		reads.push_back(MakeRead(paths[i], [callback, i](AsyncReadResult& result) {
+			callback(i, result);
+		}));
+	}
+
+	Enqueue(reads, priority);
+}
+
+std::vector<std::future<AsyncReadResult>> AsyncFileReader::ReadBatch(const std::vector<std::string>& paths, AsyncReadPriority priority) {
+	std::vector<std::shared_ptr<std::promise<AsyncReadResult>>> promises;
+	std::vector<std::future<AsyncReadResult>> futures;
+
+	for (size_t i = 0; i < paths.size(); i++) {
+		promises.push_back(std::make_shared<std::promise<AsyncReadResult>>());
+		futures.push_back(promises.back()->get_future());
+	}
+
+	ReadBatch(paths, priority, [promises](size_t index, AsyncReadResult& result) {
+		promises[index]->set_value(std::move(result));
+	});
+
+	return futures;
+}
+
+AsyncFileReader::PendingRead AsyncFileReader::MakeRead(const std::string& path, AsyncReadCallback callback) {
+	PendingRead read;
+	read.path = path;
+	read.callback = callback;
+	read.requestTime = std::chrono::steady_clock::now();
+
+	// Looked up now, so a read keeps going against the archive it was asked of even if mounts change
+	VirtualFileSystem::GetInstance().FindPacked(path, &read.pack, &read.entry);
+
+	return read;
+}
+
+void AsyncFileReader::Enqueue(std::vector<PendingRead>& reads, AsyncReadPriority priority) {
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		stats.requestCount += reads.size();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		if (running) {
+			for (PendingRead& read : reads) {
+				QueueKey key = std::make_pair(-(int)priority, nextSequence++);
+				sources[GetSourceKey(read)].push_back(key);
+				queue.emplace(key, std::move(read));
+			}
+
+			readAvailable.notify_all();
+			return;
+		}
+	}
+
+	// No threads to hand off to, so read now
+	std::ifstream archive;
+	std::string archivePath;
+	for (PendingRead& read : reads) {
+		std::vector<PendingRead> single;
+		single.push_back(std::move(read));
+
+		if (single[0].pack != nullptr) ReadPacked(single, archive, &archivePath);
+		else ReadLoose(single);
+	}
+}
+
+bool AsyncFileReader::TakeReads(std::vector<PendingRead>* reads) {
+	reads->clear();
+
+	std::unique_lock<std::mutex> lock(queueMutex);
+	readAvailable.wait(lock, [&]() { return !running || !queue.empty(); });
+	if (!running) return false;
+
+	auto top = queue.begin();
+	std::string sourceKey = GetSourceKey(top->second);
+	std::vector<QueueKey>& sameSource = sources[sourceKey];
+
+	std::vector<QueueKey> taken;
+	if (top->second.pack == nullptr) {
+		// Every request for the same loose file is answered by one read
+		taken = sameSource;
+	}
+	else {
+		// Grow a span out from the top read through its neighbors in the archive
+		std::vector<std::pair<const AssetPackEntry*, QueueKey>> ordered;
+		ordered.reserve(sameSource.size());
+		for (const QueueKey& key : sameSource) {
+			ordered.push_back(std::make_pair(queue.at(key).entry, key));
+		}
+
+		std::sort(ordered.begin(), ordered.end(), [](const std::pair<const AssetPackEntry*, QueueKey>& a, const std::pair<const AssetPackEntry*, QueueKey>& b) {
+			if (a.first->offset != b.first->offset) return a.first->offset < b.first->offset;
+			return a.second < b.second;
+		});
+
+		size_t topIndex = 0;
+		while (ordered[topIndex].second != top->first) topIndex++;
+
+		uint64_t spanStart = ordered[topIndex].first->offset;
+		uint64_t spanEnd = spanStart + ordered[topIndex].first->storedSize;
+		size_t first = topIndex;
+		size_t last = topIndex;
+
+		while (last + 1 < ordered.size()) {
+			const AssetPackEntry* next = ordered[last + 1].first;
+			uint64_t nextEnd = (std::max)(spanEnd, next->offset + next->storedSize);
+			if (next->offset > spanEnd + ASYNC_READ_MERGE_GAP || nextEnd - spanStart > ASYNC_READ_MAX_SPAN) break;
+
+			spanEnd = nextEnd;
+			last++;
+		}
+
+		while (first > 0) {
+			const AssetPackEntry* previous = ordered[first - 1].first;
+			if (previous->offset + previous->storedSize + ASYNC_READ_MERGE_GAP < spanStart || spanEnd - previous->offset > ASYNC_READ_MAX_SPAN) break;
+
+			spanStart = previous->offset;
+			first--;
+		}
+
+		for (size_t i = first; i <= last; i++) {
+			taken.push_back(ordered[i].second);
+		}
+	}
+
+	for (const QueueKey& key : taken) {
+		auto found = queue.find(key);
+		reads->push_back(std::move(found->second));
+		queue.erase(found);
+	}
+
+	if (taken.size() == sameSource.size()) {
+		sources.erase(sourceKey);
+	}
+	else {
+		std::set<QueueKey> takenKeys(taken.begin(), taken.end());
+		sameSource.erase(std::remove_if(sameSource.begin(), sameSource.end(), [&](const QueueKey& key) { return takenKeys.count(key) > 0; }), sameSource.end());
+	}
+
+	return true;
+}
+
+std::string AsyncFileReader::GetSourceKey(const PendingRead& read) {
+	// '*' can't be in a file name, so archives can't collide with loose paths
+	return read.pack != nullptr ? "*" + read.pack->GetPath() : read.path;
+}
+#pragma endregion
+
+#pragma region reading
+void AsyncFileReader::ReadPacked(std::vector<PendingRead>& reads, std::ifstream& archive, std::string* archivePath) {
+	const std::string& packPath = reads[0].pack->GetPath();
+	if (*archivePath != packPath) {
+		archive.close();
+		archive.clear();
+		archive.open(packPath, std::ios::binary);
+		*archivePath = packPath;
+	}
+
+	uint64_t spanStart = UINT64_MAX;
+	uint64_t spanEnd = 0;
+	for (const PendingRead& read : reads) {
+		spanStart = (std::min)(spanStart, read.entry->offset);
+		spanEnd = (std::max)(spanEnd, read.entry->offset + read.entry->storedSize);
+	}
+
+	std::vector<char> span((size_t)(spanEnd - spanStart));
+	bool spanRead = archive.is_open() &&
+		archive.seekg((std::streamoff)spanStart) &&
+		archive.read(span.data(), (std::streamsize)span.size());
+
+	if (!spanRead) {
+		// Opened again next time, in case the handle went bad
+		archive.close();
+		archive.clear();
+		archivePath->clear();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		stats.spanCount++;
+		if (spanRead) stats.bytesRead += span.size();
+	}
+
+	for (size_t i = 0; i < reads.size(); i++) {
+		const AssetPackEntry* entry = reads[i].entry;
+
+		AsyncReadResult result;
+		result.path = reads[i].path;
+
+		if (spanRead) {
+			const unsigned char* stored = (const unsigned char*)span.data() + (entry->offset - spanStart);
+			result.data.resize((size_t)entry->size);
+
+			if (entry->flags & ASSET_PACK_ENTRY_COMPRESSED) {
+				result.succeeded = AssetPack::Decompress(stored, (size_t)entry->storedSize, (unsigned char*)result.data.data(), result.data.size());
+			}
+			else {
+				std::copy(stored, stored + entry->size, (unsigned char*)result.data.data());
+				result.succeeded = true;
+			}
+
+			if (!result.succeeded) result.data.clear();
+		}
+
+		Complete(reads[i], result, i > 0);
+	}
+}
+
+void AsyncFileReader::ReadLoose(std::vector<PendingRead>& reads) {
+	AsyncReadResult result;
+	result.path = reads[0].path;
+
+	std::ifstream file(reads[0].path, std::ios::binary | std::ios::ate);
+	if (file.is_open()) {
+		std::streamsize size = file.tellg();
+		file.seekg(0, std::ios::beg);
+
+		result.data.resize((size_t)(std::max)((std::streamsize)0, size));
+		result.succeeded = size >= 0 && (size == 0 || (bool)file.read(result.data.data(), size));
+		if (!result.succeeded) result.data.clear();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		stats.spanCount++;
+		stats.bytesRead += result.data.size();
+	}
+
+	for (size_t i = 0; i < reads.size(); i++) {
+		// The last one gets the data itself, everyone before it a copy
+		AsyncReadResult shared;
+		if (i + 1 < reads.size()) {
+			shared = result;
+			shared.path = reads[i].path;
+		}
+
+		Complete(reads[i], i + 1 < reads.size() ? shared : result, i > 0);
+	}
+}
+
+void AsyncFileReader::Complete(PendingRead& read, AsyncReadResult& result, bool coalesced) {
+	result.latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - read.requestTime).count();
+
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		stats.completedCount++;
+		if (!result.succeeded) stats.failedCount++;
+		if (coalesced) stats.coalescedCount++;
+
+		totalLatency += result.latency;
+		stats.maxLatency = (std::max)(stats.maxLatency, result.latency);
+	}
+
+	if (read.callback) read.callback(result);
+}
+#pragma endregion
+
+AsyncFileReaderStats AsyncFileReader::GetStats() {
+	AsyncFileReaderStats currentStats;
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		currentStats = stats;
+		currentStats.averageLatency = stats.completedCount > 0 ? totalLatency / stats.completedCount : 0;
+	}
+
+	std::lock_guard<std::mutex> lock(queueMutex);
+	currentStats.pendingCount = queue.size();
+
+	return currentStats;
+}
@@ -1,4 +1,5 @@
 #include "../Headers/AudioHandler.h"
+#include "../Headers/VirtualFileSystem.h"
 
 using namespace FMOD;
 
@@ -16,7 +17,7 @@ FMOD_RESULT AudioHandler::Initialize() {
 		return result;
 	}
 
-	result = soundSystem->init(512, FMOD_INIT_NORMAL, 0);
+	result = soundSystem->init(AUDIO_MAX_CHANNELS, FMOD_INIT_NORMAL, 0);
 
 	return result;
 }
@@ -25,6 +26,13 @@ Sound* AudioHandler::LoadSound(std::string soundPath, FMOD_MODE mode) {
 	FMOD::Sound* newSound;
 	FMOD_RESULT result;
 
+	// Packed sounds are handed over from memory. FMOD copies them, so the file can close right after.
+	VirtualFile file;
+	VirtualFileInfo info;
+	if (VirtualFileSystem::GetInstance().GetFileInfo(soundPath, &info) && info.packed && file.Open(soundPath)) {
+		return LoadSoundFromMemory((const char*)file.GetData(), file.GetSize(), mode);
+	}
+
 	result = soundSystem->createSound(soundPath.c_str(),
 									  mode,
 									  0,
@@ -35,6 +43,24 @@ Sound* AudioHandler::LoadSound(std::string soundPath, FMOD_MODE mode) {
 	return newSound;
 }
 
+Sound* AudioHandler::LoadSoundFromMemory(const char* data, size_t size, FMOD_MODE mode) {
+	FMOD::Sound* newSound;
+	FMOD_RESULT result;
+
+	FMOD_CREATESOUNDEXINFO soundInfo = {};
+	soundInfo.cbsize = sizeof(FMOD_CREATESOUNDEXINFO);
+	soundInfo.length = (unsigned int)size;
+
+	result = soundSystem->createSound(data,
+									  mode | FMOD_OPENMEMORY,
+									  &soundInfo,
+									  &newSound);
+
+	if (result != FMOD_OK) return nullptr;
+
+	return newSound;
+}
+
 Channel* AudioHandler::BasicPlaySound(FMOD::Sound* sound) {
 	FMOD_RESULT result;
 	Channel* channel;
@@ -47,6 +73,21 @@ Channel* AudioHandler::BasicPlaySound(FMOD::Sound* sound) {
 	return channel;
 }
 
+bool AudioHandler::IsSoundPlaying(FMOD::Sound* sound) {
+	for (int i = 0; i < AUDIO_MAX_CHANNELS; i++) {
+		Channel* channel;
+		if (this->soundSystem->getChannel(i, &channel) != FMOD_OK) continue;
+
+		bool playing = false;
+		if (channel->isPlaying(&playing) != FMOD_OK || !playing) continue;
+
+		Sound* currentSound;
+		if (channel->getCurrentSound(&currentSound) == FMOD_OK && currentSound == sound) return true;
+	}
+
+	return false;
+}
+
 FMOD::System* AudioHandler::GetSoundSystem() {
 	return this->soundSystem;
 }
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "../Headers/FileWatcher.h"
+#include <experimental/filesystem>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::experimental::filesystem;
+
+FileWatcher::FileWatcher() {
+	running = false;
+#ifdef _WIN32
+	directoryHandle = INVALID_HANDLE_VALUE;
+	stopEvent = nullptr;
+#else
+	inotifyDescriptor = -1;
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+	Stop();
+}
+
+#pragma region watching
+bool FileWatcher::Start(const std::string& folder) {
+	Stop();
+
+	std::error_code error;
+	if (!fs::is_directory(folder, error)) return false;
+
+	this->folder = folder;
+	while (this->folder.size() > 1 && (this->folder.back() == '\\' || this->folder.back() == '/')) this->folder.pop_back();
+
+#ifdef _WIN32
+	directoryHandle = CreateFileA(this->folder.c_str(), FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (directoryHandle == INVALID_HANDLE_VALUE) return false;
+
+	stopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	if (stopEvent == nullptr) {
+		CloseHandle(directoryHandle);
+		directoryHandle = INVALID_HANDLE_VALUE;
+		return false;
+	}
+#else
+	inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyDescriptor < 0) return false;
+
+	AddWatches(this->folder);
+	if (watchedFolders.empty()) {
+		close(inotifyDescriptor);
+		inotifyDescriptor = -1;
+		return false;
+	}
+#endif
+
+	running = true;
+	thread = std::thread(&FileWatcher::ThreadLoop, this);
+
+	return true;
+}
+
+void FileWatcher::Stop() {
+	if (!running) return;
+
+	running = false;
+#ifdef _WIN32
+	SetEvent(stopEvent);
+#endif
+
+	if (thread.joinable()) thread.join();
+
+#ifdef _WIN32
+	CloseHandle(directoryHandle);
+	CloseHandle(stopEvent);
+	directoryHandle = INVALID_HANDLE_VALUE;
+	stopEvent = nullptr;
+#else
+	close(inotifyDescriptor);
+	inotifyDescriptor = -1;
+	watchedFolders.clear();
+#endif
+
+	std::lock_guard<std::mutex> lock(changeMutex);
+	changes.clear();
+}
+
+bool FileWatcher::IsWatching() {
+	return running;
+}
+
+std::string FileWatcher::GetFolder() {
+	return folder;
+}
+
+#ifdef _WIN32
+void FileWatcher::ThreadLoop() {
+	// DWORD aligned, as ReadDirectoryChangesW requires
+	std::vector<DWORD> buffer(16 * 1024);
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	HANDLE waitHandles[] = { overlapped.hEvent, stopEvent };
+
+	while (running) {
+		ResetEvent(overlapped.hEvent);
+
+		if (!ReadDirectoryChangesW(directoryHandle, buffer.data(), (DWORD)(buffer.size() * sizeof(DWORD)), TRUE,
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+			nullptr, &overlapped, nullptr)) {
+			break;
+		}
+
+		DWORD signaled = WaitForMultipleObjects(2, waitHandles, FALSE, INFINITE);
+
+		DWORD bytesReturned = 0;
+		if (signaled != WAIT_OBJECT_0) {
+			// Stopping, so the read has to be cancelled before its buffer goes away
+			CancelIoEx(directoryHandle, &overlapped);
+			GetOverlappedResult(directoryHandle, &overlapped, &bytesReturned, TRUE);
+			break;
+		}
+
+		// Zero bytes means the buffer overflowed and the changes were lost.
+		// Nothing can be reported for them, so they're skipped.
+		if (!GetOverlappedResult(directoryHandle, &overlapped, &bytesReturned, FALSE) || bytesReturned == 0) continue;
+
+		const unsigned char* next = (const unsigned char*)buffer.data();
+		while (true) {
+			const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)next;
+
+			if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+				int nameLength = (int)(info->FileNameLength / sizeof(WCHAR));
+				int size = WideCharToMultiByte(CP_ACP, 0, info->FileName, nameLength, nullptr, 0, nullptr, nullptr);
+
+				std::string name(size, '\0');
+				WideCharToMultiByte(CP_ACP, 0, info->FileName, nameLength, &name[0], size, nullptr, nullptr);
+
+				std::string path = folder + "\\" + name;
+
+				// Folders report their own changes when files in them change
+				std::error_code error;
+				if (fs::is_regular_file(path, error)) AddChange(path);
+			}
+
+			if (info->NextEntryOffset == 0) break;
+			next += info->NextEntryOffset;
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+#else
+void FileWatcher::AddWatches(const std::string& root) {
+	const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+	int watch = inotify_add_watch(inotifyDescriptor, root.c_str(), mask);
+	if (watch >= 0) watchedFolders[watch] = root;
+
+	// inotify doesn't recurse, so every subfolder is watched on its own
+	std::error_code error;
+	for (fs::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+		std::error_code folderError;
+		if (!fs::is_directory(it->path(), folderError)) continue;
+
+		watch = inotify_add_watch(inotifyDescriptor, it->path().string().c_str(), mask);
+		if (watch >= 0) watchedFolders[watch] = it->path().string();
+	}
+}
+
+void FileWatcher::ThreadLoop() {
+	alignas(inotify_event) char buffer[16 * 1024];
+
+	pollfd descriptor = {};
+	descriptor.fd = inotifyDescriptor;
+	descriptor.events = POLLIN;
+
+	while (running) {
+		if (poll(&descriptor, 1, FILE_WATCHER_STOP_CHECK_INTERVAL) <= 0) continue;
+
+		ssize_t length;
+		while ((length = read(inotifyDescriptor, buffer, sizeof(buffer))) > 0) {
+			for (char* next = buffer; next < buffer + length;) {
+				const inotify_event* event = (const inotify_event*)next;
+				next += sizeof(inotify_event) + event->len;
+
+				auto watched = watchedFolders.find(event->wd);
+				if (watched == watchedFolders.end() || event->len == 0) continue;
+
+				std::string path = watched->second + "/" + event->name;
+
+				if (event->mask & IN_ISDIR) {
+					// New folders are watched too, and anything already written into them counts
+					if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+						AddWatches(path);
+
+						std::error_code error;
+						for (fs::recursive_directory_iterator it(path, error), end; !error && it != end; it.increment(error)) {
+							std::error_code fileError;
+							if (fs::is_regular_file(it->path(), fileError)) AddChange(it->path().string());
+						}
+					}
+					continue;
+				}
+
+				// Created files are reported once they're closed after writing
+				if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) AddChange(path);
+			}
+		}
+	}
+}
+#endif
+#pragma endregion
+
+void FileWatcher::AddChange(const std::string& path) {
+	std::lock_guard<std::mutex> lock(changeMutex);
+	changes[path] = std::chrono::steady_clock::now();
+}
+
+void FileWatcher::Poll(std::vector<std::string>* changedPaths) {
+	changedPaths->clear();
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(changeMutex);
+	for (auto it = changes.begin(); it != changes.end();) {
+		if (std::chrono::duration<double>(now - it->second).count() < FILE_WATCHER_DEBOUNCE_TIME) {
+			it++;
+			continue;
+		}
+
+		changedPaths->push_back(it->first);
+		it = changes.erase(it);
+	}
+}
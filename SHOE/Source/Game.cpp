@@ -4,6 +4,7 @@
 #include "..\Headers\ShadowProjector.h"
 #include "..\Headers\FlashlightController.h"
 #include "..\Headers\NoclipMovement.h"
+#include "../Headers/AsyncFileReader.h"
 #include <d3dcompiler.h>
 
 // Needed for a helper function to read compiled shader files from the hard drive
@@ -14,6 +15,9 @@
 // For the DirectX Math library
 using namespace DirectX;
 
+static const char* meshResidencyNames[MESH_RESIDENCY_COUNT] = { "Full", "Positions", "Discard" };
+static const char* texturePresetNames[TEXTURE_PRESET_COUNT] = { "Uncompressed", "Fast", "Balanced", "Quality" };
+
 // --------------------------------------------------------
 // Constructor
 //
@@ -75,6 +79,7 @@ Game::~Game()
 	delete& AudioHandler::GetInstance();
 	delete& CollisionManager::GetInstance();
 	delete& SceneManager::GetInstance();
+	delete& JobSystem::GetInstance();
 
 	delete loadingSpriteBatch;
 }
@@ -111,6 +116,7 @@ void Game::Init()
 
 	entityUIIndex = -1;
 	skyUIIndex = 0;
+	journalTimer = 0.0f;
 
 	// Tell the input assembler stage of the pipeline what kind of
 	// geometric primitives (points, lines or triangles) we want to draw.  
@@ -149,6 +155,25 @@ void Game::LoadScene() {
 	printf("Took %3.4f seconds for main initialization. \n", this->GetDeltaTime());
 #endif
 
+	CreateRenderer();
+}
+
+void Game::SwitchScene() {
+	// The current scene keeps running while the next one is prepared, then it's swapped in between frames
+	sceneManager.SwitchScene("structureTest.json", [this](const SceneSwitchResult& result) {
+		if (!result.succeeded) return;
+
+		objWindowEnabled = false;
+		skyWindowEnabled = false;
+		entityUIIndex = -1;
+		ResetSkyUIIndex();
+
+		// The renderer holds on to assets of the scene that was switched away from
+		CreateRenderer();
+	});
+}
+
+void Game::CreateRenderer() {
 	renderer.reset();
 
 	context->Flush();
@@ -228,6 +253,202 @@ void Game::GenerateEditingUI() {
 
 		ImGui::Text(node.c_str());
 
+		AssetCacheStats cacheStats = globalAssets.GetAssetCacheStats();
+		node = "Cached assets: " + std::to_string(cacheStats.entryCount) +
+			", References: " + std::to_string(cacheStats.referenceCount) +
+			", Hits: " + std::to_string(cacheStats.hitCount) +
+			", Misses: " + std::to_string(cacheStats.missCount);
+
+		ImGui::Text(node.c_str());
+
+		infoStr = std::to_string(cacheStats.savedGpuBytes / (1024.0 * 1024.0));
+		infoStrTwo = std::to_string(cacheStats.savedCpuBytes / (1024.0 * 1024.0));
+		node = "Saved by sharing: " + infoStr + " MB GPU, " + infoStrTwo + " MB CPU";
+
+		ImGui::Text(node.c_str());
+
+		IBLCacheStats iblCacheStats = globalAssets.GetIBLCacheStats();
+		node = "IBL cache hits: " + std::to_string(iblCacheStats.hitCount) +
+			", Misses: " + std::to_string(iblCacheStats.missCount) +
+			" (" + std::to_string(iblCacheStats.corruptCount) + " corrupt)" +
+			", Written: " + std::to_string(iblCacheStats.writeCount);
+		if (iblCacheStats.failedWriteCount > 0) node += ", Failed writes: " + std::to_string(iblCacheStats.failedWriteCount);
+
+		ImGui::Text(node.c_str());
+
+		ShaderReflectionCacheStats shaderCacheStats = globalAssets.GetShaderReflectionCacheStats();
+		node = "Shader reflection cache hits: " + std::to_string(shaderCacheStats.hitCount) +
+			", Misses: " + std::to_string(shaderCacheStats.missCount) +
+			" (" + std::to_string(shaderCacheStats.corruptCount) + " corrupt)" +
+			", Written: " + std::to_string(shaderCacheStats.writeCount);
+		if (shaderCacheStats.failedWriteCount > 0) node += ", Failed writes: " + std::to_string(shaderCacheStats.failedWriteCount);
+
+		ImGui::Text(node.c_str());
+
+		VirtualFileSystemStats vfsStats = VirtualFileSystem::GetInstance().GetStats();
+		infoStr = std::to_string(vfsStats.decompressedBytes / (1024.0 * 1024.0));
+		node = "Archives: " + std::to_string(vfsStats.archiveCount) +
+			" (" + std::to_string(vfsStats.packedFileCount) + " files)" +
+			", Packed reads: " + std::to_string(vfsStats.packedReads) +
+			", Loose reads: " + std::to_string(vfsStats.looseReads) +
+			", Decompressed: " + infoStr + " MB";
+		if (vfsStats.failedReads > 0) node += ", Failed: " + std::to_string(vfsStats.failedReads);
+
+		ImGui::Text(node.c_str());
+
+		AsyncFileReaderStats readStats = AsyncFileReader::GetInstance().GetStats();
+		infoStr = std::to_string(readStats.averageLatency * 1000.0);
+		infoStrTwo = std::to_string(readStats.maxLatency * 1000.0);
+		node = "Async reads: " + std::to_string(readStats.completedCount) +
+			" (" + std::to_string(readStats.coalescedCount) + " coalesced into " + std::to_string(readStats.spanCount) + " reads)" +
+			", Pending: " + std::to_string(readStats.pendingCount) +
+			", Latency: " + infoStr + " ms avg, " + infoStrTwo + " ms max";
+		if (readStats.failedCount > 0) node += ", Failed: " + std::to_string(readStats.failedCount);
+
+		ImGui::Text(node.c_str());
+
+		HotReloadStats hotReloadStats = globalAssets.GetHotReloadStats();
+		node = "Hot reload: " + std::string(hotReloadStats.watching ? "Watching" : "Off") +
+			", Changed files: " + std::to_string(hotReloadStats.changedFiles) +
+			", Reloaded assets: " + std::to_string(hotReloadStats.reloadedAssets);
+
+		ImGui::Text(node.c_str());
+
+		node = "Deferred assets: " + std::to_string(globalAssets.GetDeferredAssetCount()) +
+			", Loading: " + std::to_string(globalAssets.GetDeferredLoadsInFlight());
+
+		ImGui::Text(node.c_str());
+
+		AssetMemoryUsage memoryUsage = globalAssets.GetLoadedAssetMemory();
+		infoStr = std::to_string(memoryUsage.gpuBytes / (1024.0 * 1024.0));
+		infoStrTwo = std::to_string(memoryUsage.cpuBytes / (1024.0 * 1024.0));
+		node = "Loaded assets: " + infoStr + " MB GPU, " + infoStrTwo + " MB CPU";
+
+		ImGui::Text(node.c_str());
+
+		MeshResidencyStats residencyStats = globalAssets.GetMeshResidencyStats();
+		for (int i = 0; i < MESH_RESIDENCY_COUNT; i++) {
+			infoStr = std::to_string(residencyStats.cpuBytes[i] / (1024.0 * 1024.0));
+			node = std::string(meshResidencyNames[i]) + " CPU meshes: " + std::to_string(residencyStats.meshCounts[i]) + ", " + infoStr + " MB";
+
+			ImGui::Text(node.c_str());
+		}
+
+		// Trimming can't be undone, so raising the policy only affects meshes loaded after
+		int meshResidency = Mesh::GetDefaultResidency();
+		if (ImGui::Combo("Mesh CPU Copies", &meshResidency, meshResidencyNames, MESH_RESIDENCY_COUNT)) {
+			globalAssets.SetMeshResidency((MeshResidency)meshResidency);
+		}
+
+		// Only affects textures loaded after, and only ones that weren't cooked
+		int texturePreset = globalAssets.GetTextureCompressionPreset();
+		if (ImGui::Combo("Texture Compression", &texturePreset, texturePresetNames, TEXTURE_PRESET_COUNT)) {
+			globalAssets.SetTextureCompressionPreset((TexturePreset)texturePreset);
+		}
+
+		// Zero turns the budget off
+		int budgetMB = (int)(globalAssets.GetAssetMemoryBudget() / (1024 * 1024));
+		if (ImGui::InputInt("Asset Budget (MB)", &budgetMB)) {
+			globalAssets.SetAssetMemoryBudget((uint64_t)(std::max)(budgetMB, 0) * 1024 * 1024);
+		}
+
+		static size_t lastUnloadedCount = 0;
+		if (ImGui::Button("Unload Unused Assets")) {
+			lastUnloadedCount = globalAssets.UnloadUnusedAssets();
+			ResetSkyUIIndex();
+		}
+		ImGui::SameLine();
+
+		node = "Last unloaded: " + std::to_string(lastUnloadedCount);
+		ImGui::Text(node.c_str());
+
+		ImGui::Separator();
+
+		TextureStreamingStats streamingStats = globalAssets.GetTextureStreamingStats();
+		infoStr = std::to_string(streamingStats.residentBytes / (1024.0 * 1024.0));
+		infoStrTwo = std::to_string(streamingStats.wantedBytes / (1024.0 * 1024.0));
+		node = "Streamed textures: " + std::to_string(streamingStats.textureCount) +
+			", Resident: " + infoStr + " MB, Wanted: " + infoStrTwo + " MB" +
+			", Streaming: " + std::to_string(streamingStats.streamingCount);
+		if (streamingStats.failedCount > 0) node += ", Failed: " + std::to_string(streamingStats.failedCount);
+
+		ImGui::Text(node.c_str());
+
+		infoStr = std::to_string(streamingStats.streamedInBytes / (1024.0 * 1024.0));
+		infoStrTwo = std::to_string(streamingStats.evictedBytes / (1024.0 * 1024.0));
+		node = "Streamed in: " + infoStr + " MB, Evicted: " + infoStrTwo + " MB";
+
+		ImGui::Text(node.c_str());
+
+		SceneCellStreamingStats cellStats = sceneManager.GetSceneStreamingStats();
+		if (cellStats.cellCount > 0) {
+			node = "Scene cells: " + std::to_string(cellStats.cellCount) +
+				", Loaded: " + std::to_string(cellStats.loadedCount) +
+				", Loading: " + std::to_string(cellStats.loadingCount) +
+				", Unloading: " + std::to_string(cellStats.unloadingCount);
+			if (cellStats.failedCount > 0) node += ", Failed: " + std::to_string(cellStats.failedCount);
+
+			ImGui::Text(node.c_str());
+		}
+
+		if (sceneManager.IsSaving()) {
+			ImGui::Text("Saving scene...");
+		}
+		else {
+			SceneSaveResult saveResult = sceneManager.GetLastSaveResult();
+			if (!saveResult.path.empty()) {
+				infoStr = std::to_string(saveResult.captureTime * 1000.0);
+				infoStrTwo = std::to_string(saveResult.writeTime * 1000.0);
+				node = std::string(saveResult.succeeded ? "Last save" : "Last save FAILED") +
+					": captured in " + infoStr + " ms, written in " + infoStrTwo + " ms";
+
+				ImGui::Text(node.c_str());
+			}
+		}
+
+		if (sceneManager.IsSwitchingScene()) {
+			ImGui::Text("Preparing next scene...");
+		}
+		else {
+			SceneSwitchResult switchResult = sceneManager.GetLastSwitchResult();
+			if (!switchResult.path.empty() && !switchResult.cancelled) {
+				infoStr = std::to_string(switchResult.preparationTime * 1000.0);
+				infoStrTwo = std::to_string(switchResult.swapTime * 1000.0);
+				node = std::string(switchResult.succeeded ? "Last scene switch" : "Last scene switch FAILED") +
+					": prepared in " + infoStr + " ms, swapped in " + infoStrTwo + " ms, " +
+					std::to_string(switchResult.sharedAssetCount) + " shared files kept";
+
+				ImGui::Text(node.c_str());
+			}
+		}
+
+		// Zero turns the budget off
+		int streamingBudgetMB = (int)(globalAssets.GetTextureStreamingBudget() / (1024 * 1024));
+		if (ImGui::InputInt("Texture Streaming Budget (MB)", &streamingBudgetMB)) {
+			globalAssets.SetTextureStreamingBudget((uint64_t)(std::max)(streamingBudgetMB, 0) * 1024 * 1024);
+		}
+
+		if (ImGui::TreeNode("Texture Residency")) {
+			for (int i = 0; i < globalAssets.GetTextureArraySize(); i++) {
+				std::shared_ptr<Texture> texture = globalAssets.GetTextureAtID(i);
+
+				StreamedTextureStatus status;
+				if (!globalAssets.GetTextureStreamingStatus(texture, &status)) continue;
+
+				unsigned int residentWidth = (std::max)(1u, status.width >> status.residentMip);
+				unsigned int residentHeight = (std::max)(1u, status.height >> status.residentMip);
+				infoStr = std::to_string(status.residentBytes / (1024.0 * 1024.0));
+				node = texture->GetName() + ": " + std::to_string(residentWidth) + "x" + std::to_string(residentHeight) +
+					", Mip " + std::to_string(status.residentMip) + " (wants " + std::to_string(status.wantedMip) +
+					", tail " + std::to_string(status.tailMip) + "), " + infoStr + " MB";
+				if (status.streaming) node += ", Streaming";
+
+				ImGui::Text(node.c_str());
+			}
+
+			ImGui::TreePop();
+		}
+
 		ImGui::End();
 	}
 
@@ -269,12 +490,46 @@ void Game::GenerateEditingUI() {
 			ImGui::Image((ImTextureID*)currentSky->GetBRDFLookupTexture().Get(), ImVec2(256, 256));
 		}
 
+		if (ImGui::CollapsingHeader("Image Based Lighting")) {
+			static std::string comparedSky;
+			static SkyIBLComparison comparison;
+			static bool comparisonValid = false;
+
+			std::shared_ptr<IBLBakedSky> bakedIBL = currentSky->GetBakedIBL();
+			std::string source = currentSky->IsIBLBakedOnCPU() ? "Irradiance (SH) and specular baked on CPU" : "Irradiance and specular rendered on GPU";
+			if (bakedIBL != nullptr && bakedIBL->fromCache) source += ", loaded from the IBL cache";
+			ImGui::Text(source.c_str());
+
+			if (currentSky->IsIBLBakedOnCPU() && ImGui::Button("Compare with shaders")) {
+				comparedSky = currentSky->GetName();
+				comparisonValid = currentSky->CompareIBLWithShaders(&comparison);
+			}
+
+			if (comparedSky == currentSky->GetName()) {
+				if (!comparisonValid) {
+					ImGui::Text("Comparison failed");
+				}
+				else {
+					auto errorLine = [](std::string label, IBLError error, float tolerance) {
+						std::string line = label + ": mean " + std::to_string(error.mean) + ", max " + std::to_string(error.max) + " (tolerance " + std::to_string(tolerance) + ")";
+						if (error.mean > tolerance) line += " - over";
+						ImGui::Text(line.c_str());
+					};
+
+					errorLine("Irradiance", comparison.irradiance, IBL_IRRADIANCE_TOLERANCE);
+					errorLine("Specular", comparison.specular, IBL_SPECULAR_TOLERANCE);
+					errorLine("BRDF lookup", comparison.brdfLookup, IBL_BRDF_TOLERANCE);
+				}
+			}
+		}
+
 		//ImGui::Image(globalAssets.GetEmitterAtID(0)->particleDataSRV.Get(), ImVec2(256, 256));
 		ImGui::End();
 	}
 
 	if (textureWindowEnabled) {
 		static int textureUIIndex = 0;
+		if (textureUIIndex >= globalAssets.GetTextureArraySize()) textureUIIndex = 0;
 		std::shared_ptr<Texture> currentTexture = globalAssets.GetTextureAtID(textureUIIndex);
 		std::string indexStr = std::to_string(textureUIIndex) + " - " + currentTexture->GetName();
 		std::string node = "Viewing texture " + indexStr;
@@ -304,6 +559,18 @@ void Game::GenerateEditingUI() {
 
 		ImGui::Image((ImTextureID*)currentTexture->GetTexture().Get(), ImVec2(256, 256));
 
+		StreamedTextureStatus streamingStatus;
+		if (globalAssets.GetTextureStreamingStatus(currentTexture, &streamingStatus)) {
+			std::string residency = "Resident mips: " + std::to_string(streamingStatus.residentMip) +
+				" to " + std::to_string(streamingStatus.mipCount - 1) +
+				" of " + std::to_string(streamingStatus.width) + "x" + std::to_string(streamingStatus.height) +
+				", Wanted from: " + std::to_string(streamingStatus.wantedMip);
+			ImGui::Text(residency.c_str());
+		}
+		else {
+			ImGui::Text("Not streamed, all mips resident");
+		}
+
 		ImGui::End();
 	}
 
@@ -311,6 +578,14 @@ void Game::GenerateEditingUI() {
 		// Display the debug UI for objects
 		std::shared_ptr<GameEntity> currentEntity = globalAssets.GetGameEntityAtID(entityUIIndex);
 		std::string indexStr = std::to_string(entityUIIndex) + " - " + currentEntity->GetName();
+
+		// The editor writes its fields back every frame, so whatever it shows is journaled
+		sceneManager.MarkEntityEdited(currentEntity);
+
+		// Cell entities are made from their cell's file and never saved back to it,
+		// so an edit would be lost once the cell unloads
+		bool streamedEntity = sceneManager.IsStreamedEntity(currentEntity);
+
 		std::string node = "Editing object " + indexStr;
 		ImGui::Begin("Object Editor");
 		ImGui::Text(node.c_str());
@@ -326,6 +601,11 @@ void Game::GenerateEditingUI() {
 			if (entityUIIndex > globalAssets.GetGameEntityArraySize() - 1) entityUIIndex = 0;
 		};
 
+		if (streamedEntity) {
+			ImGui::TextWrapped("Streamed in from a scene cell, so it's read-only. Edit the scene before it's partitioned instead.");
+		}
+		ImGui::BeginDisabled(streamedEntity);
+
 		std::string nameBuffer;
 		static char nameBuf[64] = "";
 		nameBuffer = currentEntity->GetName();
@@ -375,6 +655,7 @@ void Game::GenerateEditingUI() {
 				// Material changes
 				if (ImGui::CollapsingHeader("Material Swapping")) {
 					static int materialIndex = 0;
+					if (materialIndex >= globalAssets.GetMaterialArraySize()) materialIndex = 0;
 
 					std::string nameBuffer;
 					static char nameBuf[64] = "";
@@ -407,6 +688,7 @@ void Game::GenerateEditingUI() {
 				// Mesh Swapping
 				if (ImGui::CollapsingHeader("Mesh Swapping")) {
 					static int meshIndex = 0;
+					if (meshIndex >= globalAssets.GetMeshArraySize()) meshIndex = 0;
 
 					std::string nameBuffer;
 					static char nameBuf[64] = "";
@@ -430,6 +712,11 @@ void Game::GenerateEditingUI() {
 					if (ImGui::Button("Swap")) {
 						meshRenderer->SetMesh(globalAssets.GetMeshAtID(meshIndex));
 					}
+
+					int meshResidency = meshRenderer->GetMesh()->GetResidency();
+					if (ImGui::Combo("CPU Copy", &meshResidency, meshResidencyNames, MESH_RESIDENCY_COUNT)) {
+						meshRenderer->GetMesh()->SetResidency((MeshResidency)meshResidency);
+					}
 				}
 			}
 
@@ -500,6 +787,7 @@ void Game::GenerateEditingUI() {
 				// Material changes
 				if (ImGui::CollapsingHeader("Terrain Material Swapping")) {
 					static int materialIndex = 0;
+					if (materialIndex >= globalAssets.GetTerrainMaterialArraySize()) materialIndex = 0;
 
 					std::string nameBuffer;
 					static char nameBuf[64] = "";
@@ -528,6 +816,7 @@ void Game::GenerateEditingUI() {
 				// Mesh Swapping
 				if (ImGui::CollapsingHeader("Mesh Swapping")) {
 					static int meshIndex = 0;
+					if (meshIndex >= globalAssets.GetMeshArraySize()) meshIndex = 0;
 
 					std::string nameBuffer;
 					static char nameBuf[64] = "";
@@ -741,6 +1030,7 @@ void Game::GenerateEditingUI() {
 			ImGui::PopID();
 		}
 
+		ImGui::EndDisabled();
 		ImGui::End();
 	}
 
@@ -847,6 +1137,22 @@ void Game::GenerateEditingUI() {
 				LoadScene();
 			}
 
+			if (ImGui::MenuItem("Switch Scene in Background")) {
+				SwitchScene();
+			}
+
+			if (ImGui::MenuItem("Export Scene as Binary")) {
+				sceneManager.ConvertScene("structureTest.json", "structureTest" SCENE_FILE_EXTENSION);
+			}
+
+			if (ImGui::MenuItem("Export Scene as Streamed Cells")) {
+				sceneManager.PartitionScene("structureTest.json", "structureTestStreamed" SCENE_FILE_EXTENSION, 64.0f);
+			}
+
+			if (ImGui::MenuItem("Benchmark Scene Loading")) {
+				sceneManager.BenchmarkJsonLoad("structureTest.json");
+			}
+
 			ImGui::Separator();
 
 			if (ImGui::BeginMenu("Import New Asset")) {
@@ -1023,19 +1329,12 @@ std::shared_ptr<GameEntity> Game::GetClickedEntity()
 		if (meshRenderer->GetBounds().Intersects(origin, direction, rayLength)) {
 			std::shared_ptr<Mesh> mesh = meshRenderer->GetMesh();
 			XMMATRIX worldMatrix = XMLoadFloat4x4(&meshRenderer->GetTransform()->GetWorldMatrix());
-			Vertex* vertices = mesh->GetVertexArray();
-			unsigned int* indices = mesh->GetIndexArray();
 			float distToTri;
 
-			for (int i = 0; i < mesh->GetIndexCount(); i += 3) {
-				XMVECTOR vertex0 = XMVector3Transform(XMLoadFloat3(&vertices[indices[i]].Position), worldMatrix);
-				XMVECTOR vertex1 = XMVector3Transform(XMLoadFloat3(&vertices[indices[i + 1]].Position), worldMatrix);
-				XMVECTOR vertex2 = XMVector3Transform(XMLoadFloat3(&vertices[indices[i + 2]].Position), worldMatrix);
-				if (DirectX::TriangleTests::Intersects(origin, direction, vertex0, vertex1, vertex2, distToTri) && distToTri < distToHit)
-				{
-					distToHit = distToTri;
-					closestHitEntity = meshRenderer->GetGameEntity();
-				}
+			if (mesh->Raycast(origin, direction, worldMatrix, &distToTri) && distToTri < distToHit)
+			{
+				distToHit = distToTri;
+				closestHitEntity = meshRenderer->GetGameEntity();
 			}
 		}
 	}
@@ -1062,6 +1361,13 @@ void Game::OnResize()
 	renderer->PostResize(this->height, this->width, this->backBufferRTV, this->depthStencilView);
 }
 
+// --------------------------------------------------------
+// Points the sky editor at the current sky after the list changes
+// --------------------------------------------------------
+void Game::ResetSkyUIIndex() {
+	skyUIIndex = (std::max)(globalAssets.GetSkyIDByName(globalAssets.currentSky->GetName()), 0);
+}
+
 // --------------------------------------------------------
 // Update your game here - user input, move objects, AI, etc.
 // --------------------------------------------------------
@@ -1069,6 +1375,37 @@ void Game::Update()
 {
 	audioHandler.GetSoundSystem()->update();
 
+	// Finishes background loads, like deferred assets swapping in
+	JobSystem::GetInstance().RunMainThreadJobs();
+
+	// Swaps in a scene that's finished preparing in the background, before anything uses the old one this frame
+	sceneManager.UpdateSceneSwitch();
+
+	// Starts reloading assets whose files changed. They swap in on a later frame's RunMainThreadJobs.
+	globalAssets.UpdateHotReload();
+
+	// Cell files refer to assets by index, so a streamed scene isn't unloaded from.
+	// Unloading can shift the sky list, so the UI's index is found again.
+	if (sceneManager.GetSceneStreamingStats().cellCount == 0 && globalAssets.EnforceAssetMemoryBudget() > 0) {
+		ResetSkyUIIndex();
+	}
+
+	// Streams texture mips in and out for what the drawing camera sees
+	std::shared_ptr<Camera> streamingCamera = engineState == EngineState::PLAY ? globalAssets.GetMainCamera() : globalAssets.GetEditingCamera();
+	globalAssets.UpdateTextureStreaming(streamingCamera, (float)this->height);
+
+	// Loads and unloads the scene's cells around the same camera
+	sceneManager.UpdateSceneStreaming(streamingCamera);
+
+	// Journals editor changes every few seconds, so a crash loses at most those
+	if (engineState == EngineState::EDITING) {
+		journalTimer += Time::deltaTime;
+		if (journalTimer >= SCENE_JOURNAL_INTERVAL) {
+			journalTimer = 0.0f;
+			sceneManager.JournalScene();
+		}
+	}
+
 	if (input.KeyPress(VK_RIGHT)) {
 		skyUIIndex++;
 		if (skyUIIndex > globalAssets.GetSkyArraySize() - 1) {
@@ -0,0 +1,546 @@
+#include "../Headers/IBLBaker.h"
+#include "../Headers/JobSystem.h"
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+static const float pi = 3.14159265359f;
+
+// Rows of cube texels per job
+static const size_t rowGrainSize = 8;
+
+struct IBLVector {
+	float x, y, z;
+};
+
+static inline IBLVector Add(IBLVector a, IBLVector b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+static inline IBLVector Scale(IBLVector v, float s) { return { v.x * s, v.y * s, v.z * s }; }
+static inline float Dot(IBLVector a, IBLVector b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+static inline IBLVector Cross(IBLVector a, IBLVector b) {
+	return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static inline IBLVector Normalize(IBLVector v) {
+	float length = sqrtf(Dot(v, v));
+	return length > 0.0f ? Scale(v, 1.0f / length) : v;
+}
+
+static inline float Saturate(float value) {
+	return (std::max)(0.0f, (std::min)(1.0f, value));
+}
+
+static inline unsigned char ToUnorm8(float value) {
+	return (unsigned char)(Saturate(value) * 255.0f + 0.5f);
+}
+
+static inline uint16_t ToUnorm16(float value) {
+	return (uint16_t)(Saturate(value) * 65535.0f + 0.5f);
+}
+
+static float SRGBToLinear(float value) {
+	return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+#pragma region cubeAddressing
+// Direction through a point on a face, -1 to 1 across and down it.
+// Same table as the IBL shaders.
+static IBLVector FaceDirection(int face, float x, float y) {
+	IBLVector direction;
+	switch (face) {
+	default:
+	case 0: direction = { +1, -y, -x }; break;
+	case 1: direction = { -1, -y, +x }; break;
+	case 2: direction = { +x, +1, +y }; break;
+	case 3: direction = { +x, -1, -y }; break;
+	case 4: direction = { +x, -y, +1 }; break;
+	case 5: direction = { -x, -y, -1 }; break;
+	}
+
+	return Normalize(direction);
+}
+
+// The inverse of FaceDirection, with u and v from 0 to 1
+static int DirectionToFace(IBLVector direction, float* u, float* v) {
+	float absX = fabsf(direction.x);
+	float absY = fabsf(direction.y);
+	float absZ = fabsf(direction.z);
+
+	int face;
+	float x, y;
+	if (absX >= absY && absX >= absZ) {
+		face = direction.x > 0 ? 0 : 1;
+		x = (direction.x > 0 ? -direction.z : direction.z) / absX;
+		y = -direction.y / absX;
+	}
+	else if (absY >= absZ) {
+		face = direction.y > 0 ? 2 : 3;
+		x = direction.x / absY;
+		y = (direction.y > 0 ? direction.z : -direction.z) / absY;
+	}
+	else {
+		face = direction.z > 0 ? 4 : 5;
+		x = (direction.z > 0 ? direction.x : -direction.x) / absZ;
+		y = -direction.y / absZ;
+	}
+
+	*u = (x + 1.0f) * 0.5f;
+	*v = (y + 1.0f) * 0.5f;
+	return face;
+}
+
+static size_t GetMipOffset(uint32_t faceSize, uint32_t mip, size_t channels) {
+	size_t offset = 0;
+	for (uint32_t i = 0; i < mip; i++) {
+		size_t mipSize = (std::max)(1u, faceSize >> i);
+		offset += mipSize * mipSize * channels;
+	}
+
+	return offset;
+}
+
+// Bilinear sample within one face's mip, clamped at the face's edges.
+// With filterInGamma, texels are put back through the 2.2 gamma before they're
+// blended, the way the shaders filter, and the result is left that way.
+static IBLVector SampleMip(const IBLCubemap& cubemap, int face, uint32_t mip, float u, float v, bool filterInGamma = false) {
+	int size = (int)(std::max)(1u, cubemap.faceSize >> mip);
+	const float* texels = cubemap.faces[face].data() + GetMipOffset(cubemap.faceSize, mip, 3);
+
+	float x = u * size - 0.5f;
+	float y = v * size - 0.5f;
+	int x0 = (int)floorf(x);
+	int y0 = (int)floorf(y);
+	float fractionX = x - x0;
+	float fractionY = y - y0;
+
+	int x1 = (std::min)(x0 + 1, size - 1);
+	int y1 = (std::min)(y0 + 1, size - 1);
+	x0 = (std::max)(x0, 0);
+	y0 = (std::max)(y0, 0);
+	x1 = (std::max)(x1, 0);
+	y1 = (std::max)(y1, 0);
+
+	auto texel = [&](int texelX, int texelY) {
+		const float* value = texels + ((size_t)texelY * size + texelX) * 3;
+		if (filterInGamma) return IBLVector{ powf(value[0], 1.0f / 2.2f), powf(value[1], 1.0f / 2.2f), powf(value[2], 1.0f / 2.2f) };
+		return IBLVector{ value[0], value[1], value[2] };
+	};
+
+	IBLVector top = Add(Scale(texel(x0, y0), 1.0f - fractionX), Scale(texel(x1, y0), fractionX));
+	IBLVector bottom = Add(Scale(texel(x0, y1), 1.0f - fractionX), Scale(texel(x1, y1), fractionX));
+	return Add(Scale(top, 1.0f - fractionY), Scale(bottom, fractionY));
+}
+
+// Trilinear sample. Mips hold linear values, so a coarse mip reads as the average
+// light of the texels under it, like the many top mip samples the shaders take.
+static IBLVector SampleLinear(const IBLCubemap& cubemap, IBLVector direction, float level) {
+	float u, v;
+	int face = DirectionToFace(direction, &u, &v);
+
+	level = (std::max)(0.0f, (std::min)(level, (float)(cubemap.mipLevels - 1)));
+	uint32_t lowerMip = (uint32_t)level;
+	uint32_t upperMip = (std::min)(lowerMip + 1, cubemap.mipLevels - 1);
+	float fraction = level - lowerMip;
+
+	IBLVector value = SampleMip(cubemap, face, lowerMip, u, v);
+	if (fraction > 0.0f && upperMip != lowerMip) {
+		value = Add(Scale(value, 1.0f - fraction), Scale(SampleMip(cubemap, face, upperMip, u, v), fraction));
+	}
+
+	return value;
+}
+
+// Exactly what one shader sample reads: the top mip filtered before the 2.2 gamma is removed
+static IBLVector SampleTopMip(const IBLCubemap& cubemap, IBLVector direction) {
+	float u, v;
+	int face = DirectionToFace(direction, &u, &v);
+
+	IBLVector value = SampleMip(cubemap, face, 0, u, v, true);
+	return { powf(value.x, 2.2f), powf(value.y, 2.2f), powf(value.z, 2.2f) };
+}
+
+// Writes a linear color the way the shaders do, through a 1 / 2.2 gamma
+static void StoreGammaTexel(IBLVector color, unsigned char* texel) {
+	texel[0] = ToUnorm8(powf((std::max)(color.x, 0.0f), 1.0f / 2.2f));
+	texel[1] = ToUnorm8(powf((std::max)(color.y, 0.0f), 1.0f / 2.2f));
+	texel[2] = ToUnorm8(powf((std::max)(color.z, 0.0f), 1.0f / 2.2f));
+	texel[3] = 255;
+}
+#pragma endregion
+
+#pragma region sampling
+// Same sequence as Hammersley2d in ShaderShared.hlsli
+static inline void Hammersley(uint32_t i, uint32_t count, float* x, float* y) {
+	uint32_t bits = i;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+	*x = (float)i / (float)count;
+	*y = (float)bits * 2.3283064365386963e-10f;
+}
+
+// Same as ImportanceSampleGGX in ShaderShared.hlsli, including its tangent frame
+static IBLVector ImportanceSampleGGX(float x, float y, float roughness, IBLVector normal) {
+	float a = roughness * roughness;
+
+	float phi = 2 * pi * x;
+	float cosTheta = sqrtf((1 - y) / (1 + (a * a - 1) * y));
+	float sinTheta = sqrtf((std::max)(0.0f, 1 - cosTheta * cosTheta));
+
+	IBLVector up = fabsf(normal.z) < 0.999f ? IBLVector{ 0, 0, 1 } : IBLVector{ 1, 0, 0 };
+	IBLVector tangentX = Normalize(Cross(up, normal));
+	IBLVector tangentY = Cross(normal, tangentX);
+
+	return Add(Add(Scale(tangentX, sinTheta * cosf(phi)), Scale(tangentY, sinTheta * sinf(phi))), Scale(normal, cosTheta));
+}
+#pragma endregion
+
+bool IBLBaker::BuildCubemap(const unsigned char* const faces[6], uint32_t width, uint32_t height, bool sRGB, IBLCubemap* cubemap) {
+	if (width == 0 || width != height) return false;
+	for (int face = 0; face < 6; face++) {
+		if (faces[face] == nullptr) return false;
+	}
+
+	// Texels are stored as the shaders light with them: sRGB decoded by the GPU,
+	// then their own 2.2 gamma removed
+	float decode[256];
+	for (int i = 0; i < 256; i++) {
+		decode[i] = powf(sRGB ? SRGBToLinear(i / 255.0f) : i / 255.0f, 2.2f);
+	}
+
+	cubemap->faceSize = width;
+	cubemap->mipLevels = 1;
+	while ((width >> cubemap->mipLevels) > 0) cubemap->mipLevels++;
+
+	JobSystem::GetInstance().ParallelFor(6, 1, [&](size_t start, size_t end) {
+		for (size_t face = start; face < end; face++) {
+			std::vector<float>& texels = cubemap->faces[face];
+			texels.resize(GetMipOffset(width, cubemap->mipLevels, 3));
+
+			const unsigned char* source = faces[face];
+			for (size_t i = 0; i < (size_t)width * width; i++) {
+				for (int channel = 0; channel < 3; channel++) {
+					texels[i * 3 + channel] = decode[source[i * 4 + channel]];
+				}
+			}
+
+			// Box filter each mip down from the one above. Averaging linear light, rather than
+			// the gamma encoded values the GPU would, keeps skies with hard contrast from
+			// going dark in the rough specular mips.
+			for (uint32_t mip = 1; mip < cubemap->mipLevels; mip++) {
+				uint32_t parentSize = width >> (mip - 1);
+				uint32_t size = (std::max)(1u, width >> mip);
+				const float* parent = texels.data() + GetMipOffset(width, mip - 1, 3);
+				float* child = texels.data() + GetMipOffset(width, mip, 3);
+
+				for (uint32_t y = 0; y < size; y++) {
+					for (uint32_t x = 0; x < size; x++) {
+						uint32_t parentX = (std::min)(x * 2 + 1, parentSize - 1);
+						uint32_t parentY = (std::min)(y * 2 + 1, parentSize - 1);
+
+						for (int channel = 0; channel < 3; channel++) {
+							child[((size_t)y * size + x) * 3 + channel] = 0.25f * (
+								parent[((size_t)(y * 2) * parentSize + x * 2) * 3 + channel] +
+								parent[((size_t)(y * 2) * parentSize + parentX) * 3 + channel] +
+								parent[((size_t)parentY * parentSize + x * 2) * 3 + channel] +
+								parent[((size_t)parentY * parentSize + parentX) * 3 + channel]);
+						}
+					}
+				}
+			}
+		}
+	});
+
+	return true;
+}
+
+void IBLBaker::ProjectIrradianceSH(const IBLCubemap& cubemap, float irradianceSH[9][3]) {
+	uint32_t size = cubemap.faceSize;
+	size_t rowCount = (size_t)size * 6;
+
+	// Each row sums on its own, then rows are added in order,
+	// so the result doesn't depend on how the rows were split up
+	struct RowSum {
+		float sh[9][3];
+		float solidAngle;
+	};
+	std::vector<RowSum> rowSums(rowCount);
+
+	JobSystem::GetInstance().ParallelFor(rowCount, rowGrainSize, [&](size_t start, size_t end) {
+		for (size_t row = start; row < end; row++) {
+			int face = (int)(row / size);
+			uint32_t y = (uint32_t)(row % size);
+			const float* texels = cubemap.faces[face].data() + (size_t)y * size * 3;
+
+			RowSum& sum = rowSums[row];
+			memset(&sum, 0, sizeof(RowSum));
+
+			float faceY = (y + 0.5f) / size * 2 - 1;
+			for (uint32_t x = 0; x < size; x++) {
+				float faceX = (x + 0.5f) / size * 2 - 1;
+				IBLVector direction = FaceDirection(face, faceX, faceY);
+
+				// Solid angle of a texel on a face one unit from the center
+				float distanceSquared = 1 + faceX * faceX + faceY * faceY;
+				float solidAngle = (4.0f / ((float)size * size)) / (distanceSquared * sqrtf(distanceSquared));
+
+				float basis[9] = {
+					0.282095f,
+					0.488603f * direction.y,
+					0.488603f * direction.z,
+					0.488603f * direction.x,
+					1.092548f * direction.x * direction.y,
+					1.092548f * direction.y * direction.z,
+					0.315392f * (3 * direction.z * direction.z - 1),
+					1.092548f * direction.x * direction.z,
+					0.546274f * (direction.x * direction.x - direction.y * direction.y)
+				};
+
+				float radiance[3];
+				for (int channel = 0; channel < 3; channel++) {
+					radiance[channel] = texels[x * 3 + channel] * solidAngle;
+				}
+
+				for (int i = 0; i < 9; i++) {
+					for (int channel = 0; channel < 3; channel++) {
+						sum.sh[i][channel] += basis[i] * radiance[channel];
+					}
+				}
+				sum.solidAngle += solidAngle;
+			}
+		}
+	});
+
+	float totalSolidAngle = 0;
+	memset(irradianceSH, 0, sizeof(float) * 9 * 3);
+	for (const RowSum& sum : rowSums) {
+		for (int i = 0; i < 9; i++) {
+			for (int channel = 0; channel < 3; channel++) {
+				irradianceSH[i][channel] += sum.sh[i][channel];
+			}
+		}
+		totalSolidAngle += sum.solidAngle;
+	}
+
+	// Texels only approximate the sphere, so the total is corrected to exactly 4 pi.
+	// The bands are then convolved with a cosine lobe to turn radiance into irradiance.
+	float bandScales[3] = { pi, 2.0f * pi / 3.0f, pi / 4.0f };
+	for (int i = 0; i < 9; i++) {
+		float band = i == 0 ? bandScales[0] : (i < 4 ? bandScales[1] : bandScales[2]);
+		for (int channel = 0; channel < 3; channel++) {
+			irradianceSH[i][channel] *= band * 4.0f * pi / totalSolidAngle;
+		}
+	}
+}
+
+void IBLBaker::BakeIrradiance(const float irradianceSH[9][3], uint32_t faceSize, IBLCubeFaces* irradiance) {
+	irradiance->faceSize = faceSize;
+	irradiance->mipLevels = 1;
+	for (int face = 0; face < 6; face++) {
+		irradiance->faces[face].resize((size_t)faceSize * faceSize * 4);
+	}
+
+	JobSystem::GetInstance().ParallelFor((size_t)faceSize * 6, rowGrainSize, [&](size_t start, size_t end) {
+		for (size_t row = start; row < end; row++) {
+			int face = (int)(row / faceSize);
+			uint32_t y = (uint32_t)(row % faceSize);
+			unsigned char* texels = irradiance->faces[face].data() + (size_t)y * faceSize * 4;
+
+			float faceY = (y + 0.5f) / faceSize * 2 - 1;
+			for (uint32_t x = 0; x < faceSize; x++) {
+				IBLVector n = FaceDirection(face, (x + 0.5f) / faceSize * 2 - 1, faceY);
+
+				float basis[9] = {
+					0.282095f,
+					0.488603f * n.y,
+					0.488603f * n.z,
+					0.488603f * n.x,
+					1.092548f * n.x * n.y,
+					1.092548f * n.y * n.z,
+					0.315392f * (3 * n.z * n.z - 1),
+					1.092548f * n.x * n.z,
+					0.546274f * (n.x * n.x - n.y * n.y)
+				};
+
+				float color[3] = {};
+				for (int i = 0; i < 9; i++) {
+					for (int channel = 0; channel < 3; channel++) {
+						color[channel] += basis[i] * irradianceSH[i][channel];
+					}
+				}
+
+				// The shader stores irradiance over pi, the diffuse light off a white surface
+				StoreGammaTexel(Scale({ color[0], color[1], color[2] }, 1.0f / pi), texels + x * 4);
+			}
+		}
+	});
+}
+
+void IBLBaker::PrefilterSpecular(const IBLCubemap& cubemap, uint32_t faceSize, uint32_t mipLevels, IBLCubeFaces* specular) {
+	specular->faceSize = faceSize;
+	specular->mipLevels = mipLevels;
+	for (int face = 0; face < 6; face++) {
+		specular->faces[face].resize(GetMipOffset(faceSize, mipLevels, 4));
+	}
+
+	// Solid angle of one source texel, for picking which source mip a sample reads
+	float texelSolidAngle = 4.0f * pi / (6.0f * cubemap.faceSize * cubemap.faceSize);
+
+	// Every row of every mip of every face is one item
+	std::vector<uint32_t> mipRowStarts(mipLevels + 1, 0);
+	for (uint32_t mip = 0; mip < mipLevels; mip++) {
+		mipRowStarts[mip + 1] = mipRowStarts[mip] + (std::max)(1u, faceSize >> mip) * 6;
+	}
+
+	JobSystem::GetInstance().ParallelFor(mipRowStarts[mipLevels], 1, [&](size_t start, size_t end) {
+		for (size_t item = start; item < end; item++) {
+			uint32_t mip = 0;
+			while (item >= mipRowStarts[mip + 1]) mip++;
+
+			uint32_t size = (std::max)(1u, faceSize >> mip);
+			int face = (int)((item - mipRowStarts[mip]) / size);
+			uint32_t y = (uint32_t)((item - mipRowStarts[mip]) % size);
+			unsigned char* texels = specular->faces[face].data() + GetMipOffset(faceSize, mip, 4) + (size_t)y * size * 4;
+
+			float roughness = mipLevels > 1 ? mip / (float)(mipLevels - 1) : 0.0f;
+			float a = roughness * roughness;
+			float a2 = a * a;
+
+			float faceY = (y + 0.5f) / size * 2 - 1;
+			for (uint32_t x = 0; x < size; x++) {
+				IBLVector n = FaceDirection(face, (x + 0.5f) / size * 2 - 1, faceY);
+
+				// A perfectly smooth lobe only ever reflects straight back
+				if (roughness == 0.0f) {
+					StoreGammaTexel(SampleTopMip(cubemap, n), texels + x * 4);
+					continue;
+				}
+
+				IBLVector color = { 0, 0, 0 };
+				float totalWeight = 0;
+				for (uint32_t i = 0; i < IBL_SPECULAR_SAMPLES; i++) {
+					float sampleX, sampleY;
+					Hammersley(i, IBL_SPECULAR_SAMPLES, &sampleX, &sampleY);
+
+					// N, V and R are all the same direction, as in the shader
+					IBLVector h = ImportanceSampleGGX(sampleX, sampleY, roughness, n);
+					float vDotH = Dot(n, h);
+					IBLVector l = Add(Scale(h, 2 * vDotH), Scale(n, -1));
+
+					float nDotL = Dot(n, l);
+					if (nDotL <= 0) continue;
+
+					// Reads the source mip whose texels are about as big as this sample's share of the lobe
+					float denominator = vDotH * vDotH * (a2 - 1) + 1;
+					float pdf = a2 / (pi * denominator * denominator) * 0.25f;
+					float sampleSolidAngle = 1.0f / (IBL_SPECULAR_SAMPLES * pdf + 0.0001f);
+					float level = 0.5f * log2f(sampleSolidAngle / texelSolidAngle) + 1.0f;
+
+					color = Add(color, Scale(SampleLinear(cubemap, l, level), nDotL));
+					totalWeight += nDotL;
+				}
+
+				StoreGammaTexel(totalWeight > 0 ? Scale(color, 1.0f / totalWeight) : color, texels + x * 4);
+			}
+		}
+	});
+}
+
+bool IBLBaker::BakeSky(const unsigned char* const faces[6], uint32_t width, uint32_t height, bool sRGB, IBLBakedSky* bakedSky) {
+	IBLCubemap cubemap;
+	if (!BuildCubemap(faces, width, height, sRGB, &cubemap)) return false;
+
+	ProjectIrradianceSH(cubemap, bakedSky->irradianceSH);
+	BakeIrradiance(bakedSky->irradianceSH, IBL_CUBE_FACE_SIZE, &bakedSky->irradiance);
+	PrefilterSpecular(cubemap, IBL_CUBE_FACE_SIZE, GetSpecularMipLevels(IBL_CUBE_FACE_SIZE), &bakedSky->specular);
+
+	return true;
+}
+
+void IBLBaker::BakeBRDFLookup(std::vector<uint16_t>* lookup) {
+	lookup->resize((size_t)IBL_BRDF_LOOKUP_SIZE * IBL_BRDF_LOOKUP_SIZE * 2);
+
+	JobSystem::GetInstance().ParallelFor(IBL_BRDF_LOOKUP_SIZE, 1, [&](size_t start, size_t end) {
+		for (size_t y = start; y < end; y++) {
+			// Rows are nDotV and columns are roughness, as in the shader
+			float nDotV = (y + 0.5f) / IBL_BRDF_LOOKUP_SIZE;
+			IBLVector v = { sqrtf(1.0f - nDotV * nDotV), 0, nDotV };
+			IBLVector n = { 0, 0, 1 };
+
+			for (size_t x = 0; x < IBL_BRDF_LOOKUP_SIZE; x++) {
+				float roughness = (x + 0.5f) / IBL_BRDF_LOOKUP_SIZE;
+
+				// Schlick-GGX k, as used in UE4
+				float k = roughness * roughness / 2.0f;
+
+				float scale = 0;
+				float bias = 0;
+				for (uint32_t i = 0; i < IBL_BRDF_SAMPLES; i++) {
+					float sampleX, sampleY;
+					Hammersley(i, IBL_BRDF_SAMPLES, &sampleX, &sampleY);
+
+					IBLVector h = ImportanceSampleGGX(sampleX, sampleY, roughness, n);
+					IBLVector l = Add(Scale(h, 2 * Dot(v, h)), Scale(v, -1));
+
+					float nDotL = Saturate(l.z);
+					float nDotH = Saturate(h.z);
+					float vDotH = Saturate(Dot(v, h));
+
+					if (nDotL > 0) {
+						float g = (nDotV / (nDotV * (1.0f - k) + k)) * (nDotL / (nDotL * (1.0f - k) + k));
+						float gVis = g * vDotH / (nDotH * nDotV);
+						float fresnel = powf(1 - vDotH, 5);
+						scale += (1 - fresnel) * gVis;
+						bias += fresnel * gVis;
+					}
+				}
+
+				uint16_t* texel = lookup->data() + (y * IBL_BRDF_LOOKUP_SIZE + x) * 2;
+				texel[0] = ToUnorm16(scale / IBL_BRDF_SAMPLES);
+				texel[1] = ToUnorm16(bias / IBL_BRDF_SAMPLES);
+			}
+		}
+	});
+}
+
+uint32_t IBLBaker::GetSpecularMipLevels(uint32_t faceSize) {
+	uint32_t fullChain = 1;
+	while ((faceSize >> fullChain) > 0) fullChain++;
+
+	return fullChain > IBL_SPECULAR_MIP_SKIP ? fullChain - IBL_SPECULAR_MIP_SKIP : 1;
+}
+
+IBLError IBLBaker::CompareTexels(const unsigned char* a, const unsigned char* b, size_t texelCount) {
+	IBLError error;
+	if (texelCount == 0) return error;
+
+	double total = 0;
+	for (size_t i = 0; i < texelCount; i++) {
+		for (int channel = 0; channel < 3; channel++) {
+			float difference = fabsf(a[i * 4 + channel] - b[i * 4 + channel]) / 255.0f;
+			total += difference;
+			error.max = (std::max)(error.max, difference);
+		}
+	}
+
+	error.mean = (float)(total / (texelCount * 3));
+	return error;
+}
+
+IBLError IBLBaker::CompareTexels(const uint16_t* a, const uint16_t* b, size_t texelCount) {
+	IBLError error;
+	if (texelCount == 0) return error;
+
+	double total = 0;
+	for (size_t i = 0; i < texelCount * 2; i++) {
+		float difference = fabsf((float)a[i] - (float)b[i]) / 65535.0f;
+		total += difference;
+		error.max = (std::max)(error.max, difference);
+	}
+
+	error.mean = (float)(total / (texelCount * 2));
+	return error;
+}
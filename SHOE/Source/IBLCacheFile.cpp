@@ -0,0 +1,255 @@
+#include "../Headers/IBLCacheFile.h"
+#include "experimental\filesystem"
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+// 64 bit FNV-1a, same as AssetCache
+static const uint64_t fnvOffset = 14695981039346656037ull;
+static const uint64_t fnvPrime = 1099511628211ull;
+
+std::atomic<uint64_t> IBLCacheFile::hitCount(0);
+std::atomic<uint64_t> IBLCacheFile::missCount(0);
+std::atomic<uint64_t> IBLCacheFile::corruptCount(0);
+std::atomic<uint64_t> IBLCacheFile::writeCount(0);
+std::atomic<uint64_t> IBLCacheFile::failedWriteCount(0);
+
+static size_t GetCubeFacesSize(uint32_t faceSize, uint32_t mipLevels) {
+	size_t size = 0;
+	for (uint32_t mip = 0; mip < mipLevels; mip++) {
+		size_t mipSize = (std::max)(1u, faceSize >> mip);
+		size += mipSize * mipSize * 4;
+	}
+
+	return size;
+}
+
+#pragma region naming
+uint64_t IBLCacheFile::GetSettingsHash(IBLCacheFileKind kind, bool fromShaders) {
+	uint32_t settings[] = {
+		IBL_CACHE_FILE_VERSION,
+		IBL_BAKE_VERSION,
+		(uint32_t)kind,
+		fromShaders ? 1u : 0u,
+		IBL_CUBE_FACE_SIZE,
+		IBL_SPECULAR_MIP_SKIP,
+		IBL_SPECULAR_SAMPLES,
+		IBL_BRDF_LOOKUP_SIZE,
+		IBL_BRDF_SAMPLES
+	};
+
+	return Checksum((const unsigned char*)settings, sizeof(settings));
+}
+
+std::string IBLCacheFile::GetCachePath(const std::string& cacheFolder, IBLCacheFileKind kind, uint64_t sourceHash, bool fromShaders) {
+	uint64_t settingsHash = GetSettingsHash(kind, fromShaders);
+
+	char name[40];
+	if (kind == IBL_CACHE_BRDF_LOOKUP) {
+		snprintf(name, sizeof(name), "brdf_%016llx", (unsigned long long)settingsHash);
+	}
+	else {
+		snprintf(name, sizeof(name), "%016llx_%016llx", (unsigned long long)sourceHash, (unsigned long long)settingsHash);
+	}
+
+	return cacheFolder + name + IBL_CACHE_FILE_EXTENSION;
+}
+#pragma endregion
+
+#pragma region reading
+/// <summary>
+/// Maps a cache file and checks everything but the payload's layout
+/// </summary>
+/// <returns>The payload, or null on a miss</returns>
+const unsigned char* IBLCacheFile::OpenPayload(MappedFile& file, const std::string& path, IBLCacheFileKind kind, uint64_t sourceHash, uint64_t settingsHash) {
+	if (path.empty() || !file.Open(path)) {
+		missCount++;
+		return nullptr;
+	}
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	const IBLCacheFileHeader* header = (const IBLCacheFileHeader*)data;
+
+	bool valid = size >= sizeof(IBLCacheFileHeader) &&
+		header->magic == IBL_CACHE_FILE_MAGIC &&
+		header->version == IBL_CACHE_FILE_VERSION &&
+		header->headerSize == sizeof(IBLCacheFileHeader) &&
+		header->kind == (uint32_t)kind &&
+		header->sourceHash == sourceHash &&
+		header->settingsHash == settingsHash &&
+		header->payloadSize == size - sizeof(IBLCacheFileHeader) &&
+		header->payloadChecksum == Checksum(data + sizeof(IBLCacheFileHeader), (size_t)header->payloadSize);
+
+	if (!valid) {
+		// A truncated or damaged file would fail every launch, so it's removed for the rewrite
+		file.Close();
+		std::remove(path.c_str());
+
+		corruptCount++;
+		missCount++;
+		return nullptr;
+	}
+
+	return data + sizeof(IBLCacheFileHeader);
+}
+
+bool IBLCacheFile::ReadSky(const std::string& path, uint64_t sourceHash, bool fromShaders, IBLBakedSky* bakedSky) {
+	MappedFile file;
+	const unsigned char* payload = OpenPayload(file, path, IBL_CACHE_SKY, sourceHash, GetSettingsHash(IBL_CACHE_SKY, fromShaders));
+	if (payload == nullptr) return false;
+
+	const IBLCacheFileHeader* header = (const IBLCacheFileHeader*)file.GetData();
+	size_t irradianceSize = GetCubeFacesSize(header->faceSize, 1);
+	size_t specularSize = GetCubeFacesSize(header->faceSize, header->mipLevels);
+
+	// The checksum matched, so a size mismatch means the file's from a writer that disagrees about the layout
+	if (header->faceSize == 0 || header->mipLevels == 0 || header->mipLevels > 16 ||
+		header->payloadSize != (irradianceSize + specularSize) * 6) {
+		file.Close();
+		std::remove(path.c_str());
+
+		corruptCount++;
+		missCount++;
+		return false;
+	}
+
+	memcpy(bakedSky->irradianceSH, header->irradianceSH, sizeof(bakedSky->irradianceSH));
+	bakedSky->fromShaders = (header->flags & IBL_CACHE_FLAG_FROM_SHADERS) != 0;
+	bakedSky->fromCache = true;
+
+	bakedSky->irradiance.faceSize = header->faceSize;
+	bakedSky->irradiance.mipLevels = 1;
+	bakedSky->specular.faceSize = header->faceSize;
+	bakedSky->specular.mipLevels = header->mipLevels;
+
+	for (int face = 0; face < 6; face++) {
+		const unsigned char* irradianceFace = payload + face * irradianceSize;
+		bakedSky->irradiance.faces[face].assign(irradianceFace, irradianceFace + irradianceSize);
+
+		const unsigned char* specularFace = payload + irradianceSize * 6 + face * specularSize;
+		bakedSky->specular.faces[face].assign(specularFace, specularFace + specularSize);
+	}
+
+	hitCount++;
+	return true;
+}
+
+bool IBLCacheFile::ReadBRDFLookup(const std::string& path, std::vector<uint16_t>* lookup) {
+	MappedFile file;
+	const unsigned char* payload = OpenPayload(file, path, IBL_CACHE_BRDF_LOOKUP, 0, GetSettingsHash(IBL_CACHE_BRDF_LOOKUP, false));
+	if (payload == nullptr) return false;
+
+	const IBLCacheFileHeader* header = (const IBLCacheFileHeader*)file.GetData();
+	size_t texelCount = (size_t)IBL_BRDF_LOOKUP_SIZE * IBL_BRDF_LOOKUP_SIZE * 2;
+	if (header->faceSize != IBL_BRDF_LOOKUP_SIZE || header->payloadSize != texelCount * sizeof(uint16_t)) {
+		file.Close();
+		std::remove(path.c_str());
+
+		corruptCount++;
+		missCount++;
+		return false;
+	}
+
+	lookup->resize(texelCount);
+	memcpy(lookup->data(), payload, texelCount * sizeof(uint16_t));
+
+	hitCount++;
+	return true;
+}
+#pragma endregion
+
+#pragma region writing
+bool IBLCacheFile::WriteSky(const std::string& path, uint64_t sourceHash, const IBLBakedSky& bakedSky) {
+	const IBLCubeFaces& irradiance = bakedSky.irradiance;
+	const IBLCubeFaces& specular = bakedSky.specular;
+	size_t irradianceSize = GetCubeFacesSize(irradiance.faceSize, 1);
+	size_t specularSize = GetCubeFacesSize(specular.faceSize, specular.mipLevels);
+
+	// The file only has room for one face size
+	if (irradiance.faceSize != specular.faceSize || irradiance.mipLevels != 1) return false;
+
+	std::vector<unsigned char> payload;
+	payload.reserve((irradianceSize + specularSize) * 6);
+	for (int face = 0; face < 6; face++) {
+		if (irradiance.faces[face].size() != irradianceSize) return false;
+		payload.insert(payload.end(), irradiance.faces[face].begin(), irradiance.faces[face].end());
+	}
+	for (int face = 0; face < 6; face++) {
+		if (specular.faces[face].size() != specularSize) return false;
+		payload.insert(payload.end(), specular.faces[face].begin(), specular.faces[face].end());
+	}
+
+	IBLCacheFileHeader header = {};
+	header.kind = IBL_CACHE_SKY;
+	header.flags = bakedSky.fromShaders ? IBL_CACHE_FLAG_FROM_SHADERS : IBL_CACHE_FLAG_HAS_SH;
+	header.faceSize = specular.faceSize;
+	header.mipLevels = specular.mipLevels;
+	header.sourceHash = sourceHash;
+	header.settingsHash = GetSettingsHash(IBL_CACHE_SKY, bakedSky.fromShaders);
+	memcpy(header.irradianceSH, bakedSky.irradianceSH, sizeof(header.irradianceSH));
+
+	return Write(path, header, payload);
+}
+
+bool IBLCacheFile::WriteBRDFLookup(const std::string& path, const std::vector<uint16_t>& lookup) {
+	if (lookup.size() != (size_t)IBL_BRDF_LOOKUP_SIZE * IBL_BRDF_LOOKUP_SIZE * 2) return false;
+
+	std::vector<unsigned char> payload(lookup.size() * sizeof(uint16_t));
+	memcpy(payload.data(), lookup.data(), payload.size());
+
+	IBLCacheFileHeader header = {};
+	header.kind = IBL_CACHE_BRDF_LOOKUP;
+	header.faceSize = IBL_BRDF_LOOKUP_SIZE;
+	header.mipLevels = 1;
+	header.settingsHash = GetSettingsHash(IBL_CACHE_BRDF_LOOKUP, false);
+
+	return Write(path, header, payload);
+}
+
+bool IBLCacheFile::Write(const std::string& path, const IBLCacheFileHeader& header, const std::vector<unsigned char>& payload) {
+	if (path.empty()) return false;
+
+	IBLCacheFileHeader fileHeader = header;
+	fileHeader.magic = IBL_CACHE_FILE_MAGIC;
+	fileHeader.version = IBL_CACHE_FILE_VERSION;
+	fileHeader.headerSize = sizeof(IBLCacheFileHeader);
+	fileHeader.payloadSize = payload.size();
+	fileHeader.payloadChecksum = Checksum(payload.data(), payload.size());
+
+	std::error_code error;
+	std::experimental::filesystem::create_directories(std::experimental::filesystem::path(path).parent_path(), error);
+
+	std::vector<unsigned char> output(sizeof(IBLCacheFileHeader) + payload.size());
+	memcpy(output.data(), &fileHeader, sizeof(IBLCacheFileHeader));
+	memcpy(output.data() + sizeof(IBLCacheFileHeader), payload.data(), payload.size());
+
+	// Written to a temporary file and renamed, so a crash mid-write can't leave a partial cache file
+	bool written = MappedFile::WriteWholeFile(path, output.data(), output.size());
+	if (written) writeCount++;
+	else failedWriteCount++;
+
+	return written;
+}
+#pragma endregion
+
+IBLCacheStats IBLCacheFile::GetStats() {
+	IBLCacheStats stats;
+	stats.hitCount = hitCount;
+	stats.missCount = missCount;
+	stats.corruptCount = corruptCount;
+	stats.writeCount = writeCount;
+	stats.failedWriteCount = failedWriteCount;
+
+	return stats;
+}
+
+uint64_t IBLCacheFile::Checksum(const unsigned char* data, size_t size) {
+	uint64_t hash = fnvOffset;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= fnvPrime;
+	}
+
+	return hash;
+}
@@ -0,0 +1,1021 @@
+#include "../Headers/ImageDecoder.h"
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+static bool Fail(std::string* error, const char* reason) {
+	if (error != nullptr) *error = reason;
+	return false;
+}
+
+bool ImageDecoder::Decode(const std::string& path, TextureFileImage* image, bool* sRGB, std::string* error) {
+	VirtualFile file;
+	if (!file.Open(path)) return Fail(error, "couldn't open file");
+
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+
+	if (size >= 8 && memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0) return DecodePNG(data, size, image, sRGB, error);
+	if (size >= 2 && data[0] == 0xFF && data[1] == 0xD8) return DecodeJPEG(data, size, image, sRGB, error);
+
+	return Fail(error, "not a PNG or JPEG");
+}
+
+#pragma region inflate
+
+// Canonical Huffman table, decoded a bit at a time (as in zlib's puff)
+struct InflateHuffman {
+	uint16_t counts[16];
+	uint16_t symbols[288];
+};
+
+struct InflateState {
+	const uint8_t* input;
+	size_t inputSize;
+	size_t inputPosition;
+	uint32_t bitBuffer;
+	int bitCount;
+	bool overrun;
+	std::vector<uint8_t>* output;
+};
+
+static int InflateBits(InflateState& state, int need) {
+	uint32_t value = state.bitBuffer;
+	while (state.bitCount < need) {
+		if (state.inputPosition >= state.inputSize) {
+			state.overrun = true;
+			return 0;
+		}
+
+		value |= (uint32_t)state.input[state.inputPosition++] << state.bitCount;
+		state.bitCount += 8;
+	}
+
+	state.bitBuffer = value >> need;
+	state.bitCount -= need;
+	return (int)(value & ((1u << need) - 1));
+}
+
+// Returns false if the lengths describe an over-subscribed code
+static bool BuildInflateHuffman(InflateHuffman& huffman, const uint16_t* lengths, int count) {
+	memset(huffman.counts, 0, sizeof(huffman.counts));
+	for (int i = 0; i < count; i++) huffman.counts[lengths[i]]++;
+
+	int left = 1;
+	for (int length = 1; length < 16; length++) {
+		left <<= 1;
+		left -= huffman.counts[length];
+		if (left < 0) return false;
+	}
+
+	uint16_t offsets[16];
+	offsets[1] = 0;
+	for (int length = 1; length < 15; length++) offsets[length + 1] = offsets[length] + huffman.counts[length];
+
+	for (int i = 0; i < count; i++) {
+		if (lengths[i] != 0) huffman.symbols[offsets[lengths[i]]++] = (uint16_t)i;
+	}
+
+	return true;
+}
+
+static int InflateDecode(InflateState& state, const InflateHuffman& huffman) {
+	int code = 0;
+	int first = 0;
+	int index = 0;
+
+	for (int length = 1; length < 16; length++) {
+		code |= InflateBits(state, 1);
+		if (state.overrun) return -1;
+
+		int count = huffman.counts[length];
+		if (code - count < first) return huffman.symbols[index + (code - first)];
+
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	return -1;
+}
+
+static bool InflateCodes(InflateState& state, const InflateHuffman& lengthCodes, const InflateHuffman& distanceCodes) {
+	static const uint16_t lengthBase[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const uint16_t lengthExtra[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const uint16_t distanceBase[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const uint16_t distanceExtra[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	std::vector<uint8_t>& output = *state.output;
+
+	while (true) {
+		int symbol = InflateDecode(state, lengthCodes);
+		if (symbol < 0) return false;
+
+		if (symbol < 256) {
+			output.push_back((uint8_t)symbol);
+			continue;
+		}
+
+		if (symbol == 256) return true;
+
+		symbol -= 257;
+		if (symbol >= 29) return false;
+
+		size_t length = lengthBase[symbol] + InflateBits(state, lengthExtra[symbol]);
+
+		symbol = InflateDecode(state, distanceCodes);
+		if (symbol < 0 || symbol >= 30) return false;
+
+		size_t distance = distanceBase[symbol] + InflateBits(state, distanceExtra[symbol]);
+		if (state.overrun || distance > output.size()) return false;
+
+		// Byte by byte, since the copy may overlap what it's writing
+		size_t from = output.size() - distance;
+		for (size_t i = 0; i < length; i++) output.push_back(output[from + i]);
+	}
+}
+
+static bool InflateStored(InflateState& state) {
+	// Stored blocks start on a byte boundary
+	state.bitBuffer = 0;
+	state.bitCount = 0;
+
+	if (state.inputPosition + 4 > state.inputSize) return false;
+
+	const uint8_t* header = state.input + state.inputPosition;
+	unsigned int length = header[0] | (header[1] << 8);
+	unsigned int complement = header[2] | (header[3] << 8);
+	if (length != (~complement & 0xFFFF)) return false;
+
+	state.inputPosition += 4;
+	if (state.inputPosition + length > state.inputSize) return false;
+
+	state.output->insert(state.output->end(), state.input + state.inputPosition, state.input + state.inputPosition + length);
+	state.inputPosition += length;
+	return true;
+}
+
+struct InflateFixedTables {
+	InflateHuffman lengthCodes;
+	InflateHuffman distanceCodes;
+
+	InflateFixedTables() {
+		uint16_t lengths[288];
+		for (int i = 0; i < 144; i++) lengths[i] = 8;
+		for (int i = 144; i < 256; i++) lengths[i] = 9;
+		for (int i = 256; i < 280; i++) lengths[i] = 7;
+		for (int i = 280; i < 288; i++) lengths[i] = 8;
+		BuildInflateHuffman(lengthCodes, lengths, 288);
+
+		for (int i = 0; i < 30; i++) lengths[i] = 5;
+		BuildInflateHuffman(distanceCodes, lengths, 30);
+	}
+};
+
+static bool InflateFixed(InflateState& state) {
+	// Built once, on first use. Static initialization is thread safe,
+	// which matters since images are decoded across the job system.
+	static const InflateFixedTables tables;
+
+	return InflateCodes(state, tables.lengthCodes, tables.distanceCodes);
+}
+
+static bool InflateDynamic(InflateState& state) {
+	static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	int lengthCount = InflateBits(state, 5) + 257;
+	int distanceCount = InflateBits(state, 5) + 1;
+	int codeCount = InflateBits(state, 4) + 4;
+	if (state.overrun || lengthCount > 286 || distanceCount > 30) return false;
+
+	uint16_t lengths[320] = {};
+	for (int i = 0; i < codeCount; i++) lengths[order[i]] = (uint16_t)InflateBits(state, 3);
+
+	InflateHuffman codeLengthCodes;
+	if (!BuildInflateHuffman(codeLengthCodes, lengths, 19)) return false;
+
+	int index = 0;
+	while (index < lengthCount + distanceCount) {
+		int symbol = InflateDecode(state, codeLengthCodes);
+		if (symbol < 0) return false;
+
+		if (symbol < 16) {
+			lengths[index++] = (uint16_t)symbol;
+			continue;
+		}
+
+		uint16_t repeated = 0;
+		int repeat;
+		if (symbol == 16) {
+			if (index == 0) return false;
+			repeated = lengths[index - 1];
+			repeat = 3 + InflateBits(state, 2);
+		}
+		else if (symbol == 17) {
+			repeat = 3 + InflateBits(state, 3);
+		}
+		else {
+			repeat = 11 + InflateBits(state, 7);
+		}
+
+		if (state.overrun || index + repeat > lengthCount + distanceCount) return false;
+		while (repeat-- > 0) lengths[index++] = repeated;
+	}
+
+	// Without an end of block code the block could never finish
+	if (lengths[256] == 0) return false;
+
+	InflateHuffman lengthCodes;
+	InflateHuffman distanceCodes;
+	if (!BuildInflateHuffman(lengthCodes, lengths, lengthCount)) return false;
+	if (!BuildInflateHuffman(distanceCodes, lengths + lengthCount, distanceCount)) return false;
+
+	return InflateCodes(state, lengthCodes, distanceCodes);
+}
+
+bool ImageDecoder::Inflate(const uint8_t* data, size_t size, std::vector<uint8_t>* output) {
+	output->clear();
+
+	// zlib header: deflate with a window of at most 32K and no preset dictionary
+	if (size < 2 || (data[0] & 0x0F) != 8 || (data[0] >> 4) > 7 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) return false;
+
+	InflateState state = {};
+	state.input = data + 2;
+	state.inputSize = size - 2;
+	state.output = output;
+
+	int last;
+	do {
+		last = InflateBits(state, 1);
+		int type = InflateBits(state, 2);
+		if (state.overrun) return false;
+
+		bool succeeded;
+		if (type == 0) succeeded = InflateStored(state);
+		else if (type == 1) succeeded = InflateFixed(state);
+		else if (type == 2) succeeded = InflateDynamic(state);
+		else succeeded = false;
+
+		if (!succeeded || state.overrun) return false;
+	} while (!last);
+
+	return true;
+}
+
+#pragma endregion
+
+#pragma region png
+
+static uint32_t ReadBigEndian32(const uint8_t* data) {
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static uint8_t Paeth(int a, int b, int c) {
+	int p = a + b - c;
+	int pa = abs(p - a);
+	int pb = abs(p - b);
+	int pc = abs(p - c);
+
+	if (pa <= pb && pa <= pc) return (uint8_t)a;
+	if (pb <= pc) return (uint8_t)b;
+	return (uint8_t)c;
+}
+
+// Reverses the per-row filters of one (sub)image in place. Each row is
+// prefixed with its filter type, which is left in the buffer.
+static bool UnfilterPNG(uint8_t* data, size_t rowBytes, uint32_t rows, size_t pixelBytes) {
+	uint8_t* previous = nullptr;
+
+	for (uint32_t y = 0; y < rows; y++) {
+		uint8_t filter = data[0];
+		uint8_t* row = data + 1;
+
+		for (size_t x = 0; x < rowBytes; x++) {
+			int left = x >= pixelBytes ? row[x - pixelBytes] : 0;
+			int up = previous != nullptr ? previous[x] : 0;
+			int upLeft = (previous != nullptr && x >= pixelBytes) ? previous[x - pixelBytes] : 0;
+
+			switch (filter) {
+			case 0: break;
+			case 1: row[x] = (uint8_t)(row[x] + left); break;
+			case 2: row[x] = (uint8_t)(row[x] + up); break;
+			case 3: row[x] = (uint8_t)(row[x] + ((left + up) >> 1)); break;
+			case 4: row[x] = (uint8_t)(row[x] + Paeth(left, up, upLeft)); break;
+			default: return false;
+			}
+		}
+
+		previous = row;
+		data += rowBytes + 1;
+	}
+
+	return true;
+}
+
+struct PNGInfo {
+	uint32_t width;
+	uint32_t height;
+	int bitDepth;
+	int colorType;
+	int channels;
+
+	uint8_t palette[256][4];
+	int paletteSize;
+
+	// Transparent sample values for gray and RGB images, -1 if none
+	int transparent[3];
+};
+
+static int ReadPNGSample(const uint8_t* row, uint32_t index, int bitDepth) {
+	if (bitDepth == 8) return row[index];
+	if (bitDepth == 16) return (row[index * 2] << 8) | row[index * 2 + 1];
+
+	size_t bit = (size_t)index * bitDepth;
+	int shift = 8 - bitDepth - (int)(bit % 8);
+	return (row[bit / 8] >> shift) & ((1 << bitDepth) - 1);
+}
+
+// Expands one unfiltered row into RGBA8 pixels, every step'th pixel starting at output
+static void ExpandPNGRow(const PNGInfo& info, const uint8_t* row, uint32_t width, uint8_t* output, size_t step) {
+	int maximum = (1 << info.bitDepth) - 1;
+
+	for (uint32_t x = 0; x < width; x++, output += step * 4) {
+		int samples[4];
+		for (int channel = 0; channel < info.channels; channel++) {
+			samples[channel] = ReadPNGSample(row, x * info.channels + channel, info.bitDepth);
+		}
+
+		auto scale = [&](int sample) { return (uint8_t)((sample * 255 + maximum / 2) / maximum); };
+
+		switch (info.colorType) {
+		case 0: // Gray
+			output[0] = output[1] = output[2] = scale(samples[0]);
+			output[3] = samples[0] == info.transparent[0] ? 0 : 255;
+			break;
+		case 2: // RGB
+			output[0] = scale(samples[0]);
+			output[1] = scale(samples[1]);
+			output[2] = scale(samples[2]);
+			output[3] = (samples[0] == info.transparent[0] && samples[1] == info.transparent[1] && samples[2] == info.transparent[2]) ? 0 : 255;
+			break;
+		case 3: // Palette
+			memcpy(output, samples[0] < info.paletteSize ? info.palette[samples[0]] : info.palette[0], 4);
+			break;
+		case 4: // Gray and alpha
+			output[0] = output[1] = output[2] = scale(samples[0]);
+			output[3] = scale(samples[1]);
+			break;
+		case 6: // RGBA
+			output[0] = scale(samples[0]);
+			output[1] = scale(samples[1]);
+			output[2] = scale(samples[2]);
+			output[3] = scale(samples[3]);
+			break;
+		}
+	}
+}
+
+bool ImageDecoder::DecodePNG(const uint8_t* data, size_t size, TextureFileImage* image, bool* sRGB, std::string* error) {
+	if (size < 8 || memcmp(data, "\x89PNG\r\n\x1a\n", 8) != 0) return Fail(error, "not a PNG");
+
+	PNGInfo info = {};
+	info.transparent[0] = info.transparent[1] = info.transparent[2] = -1;
+	int interlace = 0;
+	bool hasHeader = false;
+	bool foundEnd = false;
+	*sRGB = false;
+
+	std::vector<uint8_t> compressed;
+
+	size_t position = 8;
+	while (!foundEnd) {
+		if (position + 12 > size) return Fail(error, "truncated chunk");
+
+		uint32_t length = ReadBigEndian32(data + position);
+		const uint8_t* type = data + position + 4;
+		const uint8_t* chunk = data + position + 8;
+		if (length > size - position - 12) return Fail(error, "truncated chunk");
+
+		if (memcmp(type, "IHDR", 4) == 0) {
+			if (length < 13) return Fail(error, "bad IHDR");
+
+			info.width = ReadBigEndian32(chunk);
+			info.height = ReadBigEndian32(chunk + 4);
+			info.bitDepth = chunk[8];
+			info.colorType = chunk[9];
+			interlace = chunk[12];
+
+			static const int channelCounts[7] = { 1, 0, 3, 1, 2, 0, 4 };
+			if (info.colorType > 6 || channelCounts[info.colorType] == 0) return Fail(error, "bad color type");
+			info.channels = channelCounts[info.colorType];
+
+			bool validDepth = info.bitDepth == 8 || info.bitDepth == 16 ||
+				((info.colorType == 0 || info.colorType == 3) && (info.bitDepth == 1 || info.bitDepth == 2 || info.bitDepth == 4));
+			if (!validDepth || (info.colorType == 3 && info.bitDepth == 16)) return Fail(error, "bad bit depth");
+			if (chunk[10] != 0 || chunk[11] != 0 || interlace > 1) return Fail(error, "unknown compression, filter or interlace method");
+			if (info.width == 0 || info.height == 0 || info.width > (1u << 16) || info.height > (1u << 16)) return Fail(error, "bad dimensions");
+
+			hasHeader = true;
+		}
+		else if (memcmp(type, "PLTE", 4) == 0) {
+			info.paletteSize = (std::min)(256, (int)length / 3);
+			for (int i = 0; i < info.paletteSize; i++) {
+				info.palette[i][0] = chunk[i * 3];
+				info.palette[i][1] = chunk[i * 3 + 1];
+				info.palette[i][2] = chunk[i * 3 + 2];
+				info.palette[i][3] = 255;
+			}
+		}
+		else if (memcmp(type, "tRNS", 4) == 0) {
+			if (info.colorType == 3) {
+				for (uint32_t i = 0; i < length && i < 256; i++) info.palette[i][3] = chunk[i];
+			}
+			else if (info.colorType == 0 && length >= 2) {
+				info.transparent[0] = (chunk[0] << 8) | chunk[1];
+			}
+			else if (info.colorType == 2 && length >= 6) {
+				for (int i = 0; i < 3; i++) info.transparent[i] = (chunk[i * 2] << 8) | chunk[i * 2 + 1];
+			}
+		}
+		else if (memcmp(type, "sRGB", 4) == 0) {
+			// Presence of the chunk is all that matters, same as the engine's WIC path
+			*sRGB = true;
+		}
+		else if (memcmp(type, "IDAT", 4) == 0) {
+			compressed.insert(compressed.end(), chunk, chunk + length);
+		}
+		else if (memcmp(type, "IEND", 4) == 0) {
+			foundEnd = true;
+		}
+		else if (!(type[0] & 0x20)) {
+			// Lowercase first letter means the chunk is safe to ignore
+			return Fail(error, "unknown critical chunk");
+		}
+
+		position += (size_t)length + 12;
+	}
+
+	if (!hasHeader || compressed.empty()) return Fail(error, "missing IHDR or IDAT");
+
+	std::vector<uint8_t> raw;
+	if (!Inflate(compressed.data(), compressed.size(), &raw)) return Fail(error, "corrupt image data");
+
+	size_t bitsPerPixel = (size_t)info.channels * info.bitDepth;
+	size_t pixelBytes = (std::max)((size_t)1, bitsPerPixel / 8);
+
+	image->width = info.width;
+	image->height = info.height;
+	image->pixels.assign((size_t)info.width * info.height * 4, 0);
+
+	// Adam7 passes as start x, start y, step x, step y. Non-interlaced
+	// images are treated as a single pass covering every pixel.
+	static const uint32_t adam7[7][4] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+	static const uint32_t noInterlace[1][4] = { { 0, 0, 1, 1 } };
+	const uint32_t(*passes)[4] = interlace ? adam7 : noInterlace;
+	int passCount = interlace ? 7 : 1;
+
+	size_t offset = 0;
+	for (int pass = 0; pass < passCount; pass++) {
+		uint32_t startX = passes[pass][0], startY = passes[pass][1];
+		uint32_t stepX = passes[pass][2], stepY = passes[pass][3];
+
+		if (startX >= info.width || startY >= info.height) continue;
+
+		uint32_t passWidth = (info.width - startX + stepX - 1) / stepX;
+		uint32_t passHeight = (info.height - startY + stepY - 1) / stepY;
+		size_t rowBytes = (passWidth * bitsPerPixel + 7) / 8;
+		size_t passSize = (rowBytes + 1) * passHeight;
+
+		if (offset + passSize > raw.size()) return Fail(error, "image data too short");
+		if (!UnfilterPNG(raw.data() + offset, rowBytes, passHeight, pixelBytes)) return Fail(error, "bad row filter");
+
+		for (uint32_t y = 0; y < passHeight; y++) {
+			const uint8_t* row = raw.data() + offset + y * (rowBytes + 1) + 1;
+			uint8_t* output = &image->pixels[(((size_t)startY + y * stepY) * info.width + startX) * 4];
+			ExpandPNGRow(info, row, passWidth, output, stepX);
+		}
+
+		offset += passSize;
+	}
+
+	return true;
+}
+
+#pragma endregion
+
+#pragma region jpeg
+
+static const uint8_t jpegZigzag[64] = {
+	0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+
+struct JPEGHuffman {
+	bool defined;
+	uint8_t values[256];
+	int maxCode[18];
+	int valuePointer[17];
+	int minCode[17];
+};
+
+struct JPEGComponent {
+	int id;
+	int horizontal;
+	int vertical;
+	int quantTable;
+	int dcTable;
+	int acTable;
+	int dcPrediction;
+
+	int blocksPerLine;
+	int blocksPerColumn;
+	std::vector<uint8_t> plane;
+};
+
+struct JPEGBitReader {
+	const uint8_t* data;
+	size_t size;
+	size_t position;
+	uint32_t bitBuffer;
+	int bitCount;
+	bool hitMarker;
+};
+
+static int JPEGReadBit(JPEGBitReader& reader) {
+	if (reader.bitCount == 0) {
+		uint8_t byte = 0;
+
+		// A marker ends the entropy coded data, pad with zeroes past it
+		if (!reader.hitMarker && reader.position < reader.size) {
+			byte = reader.data[reader.position];
+			if (byte == 0xFF) {
+				uint8_t next = reader.position + 1 < reader.size ? reader.data[reader.position + 1] : 0;
+				if (next == 0x00) {
+					reader.position += 2;
+				}
+				else {
+					reader.hitMarker = true;
+					byte = 0;
+				}
+			}
+			else {
+				reader.position++;
+			}
+		}
+
+		reader.bitBuffer = byte;
+		reader.bitCount = 8;
+	}
+
+	reader.bitCount--;
+	return (reader.bitBuffer >> reader.bitCount) & 1;
+}
+
+static int JPEGReceive(JPEGBitReader& reader, int length) {
+	int value = 0;
+	for (int i = 0; i < length; i++) value = (value << 1) | JPEGReadBit(reader);
+	return value;
+}
+
+static int JPEGExtend(int value, int length) {
+	return value < (1 << (length - 1)) ? value - (1 << length) + 1 : value;
+}
+
+static int JPEGDecodeHuffman(JPEGBitReader& reader, const JPEGHuffman& huffman) {
+	int code = JPEGReadBit(reader);
+	int length = 1;
+
+	while (code > huffman.maxCode[length]) {
+		code = (code << 1) | JPEGReadBit(reader);
+		if (++length > 16) return -1;
+	}
+
+	return huffman.values[huffman.valuePointer[length] + code - huffman.minCode[length]];
+}
+
+static void BuildJPEGHuffman(JPEGHuffman& huffman, const uint8_t* counts) {
+	int code = 0;
+	int index = 0;
+
+	for (int length = 1; length <= 16; length++) {
+		huffman.valuePointer[length] = index;
+		huffman.minCode[length] = code;
+		code += counts[length - 1];
+		index += counts[length - 1];
+		huffman.maxCode[length] = counts[length - 1] ? code - 1 : -1;
+		code <<= 1;
+	}
+
+	// Sentinel so decoding always stops
+	huffman.maxCode[17] = 0x7FFFFFFF;
+	huffman.defined = true;
+}
+
+struct JPEGInverseDCTBasis {
+	float values[8][8];
+
+	JPEGInverseDCTBasis() {
+		for (int x = 0; x < 8; x++) {
+			for (int u = 0; u < 8; u++) {
+				float scale = u == 0 ? 0.70710678f : 1.0f;
+				values[x][u] = 0.5f * scale * cosf((2 * x + 1) * u * 3.14159265f / 16.0f);
+			}
+		}
+	}
+};
+
+// Separable float IDCT with a precomputed basis, +128 level shift and clamp
+static void JPEGInverseDCT(const float* coefficients, uint8_t* output, int stride) {
+	static const JPEGInverseDCTBasis basisTable;
+	const float(*basis)[8] = basisTable.values;
+
+	float rows[64];
+	for (int v = 0; v < 8; v++) {
+		for (int x = 0; x < 8; x++) {
+			float sum = 0.0f;
+			for (int u = 0; u < 8; u++) sum += basis[x][u] * coefficients[v * 8 + u];
+			rows[v * 8 + x] = sum;
+		}
+	}
+
+	for (int y = 0; y < 8; y++) {
+		for (int x = 0; x < 8; x++) {
+			float sum = 0.0f;
+			for (int v = 0; v < 8; v++) sum += basis[y][v] * rows[v * 8 + x];
+
+			int value = (int)lrintf(sum + 128.0f);
+			output[y * stride + x] = (uint8_t)(std::min)(255, (std::max)(0, value));
+		}
+	}
+}
+
+static bool DecodeJPEGBlock(JPEGBitReader& reader, JPEGComponent& component, const JPEGHuffman* dcTables, const JPEGHuffman* acTables,
+	const uint16_t quantTables[4][64], int blockX, int blockY)
+{
+	float coefficients[64] = {};
+	const uint16_t* quant = quantTables[component.quantTable];
+
+	int category = JPEGDecodeHuffman(reader, dcTables[component.dcTable]);
+	if (category < 0 || category > 16) return false;
+
+	int difference = category ? JPEGExtend(JPEGReceive(reader, category), category) : 0;
+	component.dcPrediction += difference;
+	coefficients[0] = (float)(component.dcPrediction * quant[0]);
+
+	for (int k = 1; k < 64;) {
+		int symbol = JPEGDecodeHuffman(reader, acTables[component.acTable]);
+		if (symbol < 0) return false;
+
+		int run = symbol >> 4;
+		int length = symbol & 15;
+
+		if (length == 0) {
+			// End of block, or a run of 16 zeroes
+			if (run != 15) break;
+			k += 16;
+			continue;
+		}
+
+		k += run;
+		if (k > 63) return false;
+
+		coefficients[jpegZigzag[k]] = (float)(JPEGExtend(JPEGReceive(reader, length), length) * quant[k]);
+		k++;
+	}
+
+	int stride = component.blocksPerLine * 8;
+	JPEGInverseDCT(coefficients, &component.plane[((size_t)blockY * 8 * stride) + (size_t)blockX * 8], stride);
+	return true;
+}
+
+// EXIF ColorSpace (0xA001) of 1 means sRGB
+static bool ReadExifSRGB(const uint8_t* data, size_t size) {
+	if (size < 14 || memcmp(data, "Exif\0\0", 6) != 0) return false;
+
+	const uint8_t* tiff = data + 6;
+	size_t tiffSize = size - 6;
+	bool littleEndian = tiff[0] == 'I';
+
+	auto read16 = [&](size_t offset) -> uint32_t {
+		if (offset + 2 > tiffSize) return 0;
+		return littleEndian ? (tiff[offset] | (tiff[offset + 1] << 8)) : ((tiff[offset] << 8) | tiff[offset + 1]);
+	};
+	auto read32 = [&](size_t offset) -> uint32_t {
+		if (offset + 4 > tiffSize) return 0;
+		return littleEndian ? (read16(offset) | (read16(offset + 2) << 16)) : ((read16(offset) << 16) | read16(offset + 2));
+	};
+	auto findTag = [&](size_t directory, uint32_t tag, size_t* entry) {
+		uint32_t count = read16(directory);
+		for (uint32_t i = 0; i < count; i++) {
+			size_t offset = directory + 2 + i * 12;
+			if (offset + 12 > tiffSize) return false;
+			if (read16(offset) == tag) {
+				*entry = offset;
+				return true;
+			}
+		}
+		return false;
+	};
+
+	size_t entry;
+	size_t firstDirectory = read32(4);
+	if (!findTag(firstDirectory, 0x8769, &entry)) return false;
+
+	size_t exifDirectory = read32(entry + 8);
+	if (!findTag(exifDirectory, 0xA001, &entry)) return false;
+
+	return read16(entry + 8) == 1;
+}
+
+bool ImageDecoder::DecodeJPEG(const uint8_t* data, size_t size, TextureFileImage* image, bool* sRGB, std::string* error) {
+	if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return Fail(error, "not a JPEG");
+
+	uint16_t quantTables[4][64] = {};
+	JPEGHuffman dcTables[4] = {};
+	JPEGHuffman acTables[4] = {};
+	std::vector<JPEGComponent> components;
+
+	uint32_t width = 0, height = 0;
+	int maxHorizontal = 1, maxVertical = 1;
+	int mcusPerLine = 0, mcusPerColumn = 0;
+	int restartInterval = 0;
+	bool adobeRGB = false;
+	bool decodedScan = false;
+	*sRGB = false;
+
+	size_t position = 2;
+	while (position + 4 <= size) {
+		if (data[position] != 0xFF) {
+			position++;
+			continue;
+		}
+
+		uint8_t marker = data[position + 1];
+		if (marker == 0xFF) {
+			position++;
+			continue;
+		}
+
+		if (marker == 0xD9) break;
+		if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+			position += 2;
+			continue;
+		}
+
+		uint32_t length = (data[position + 2] << 8) | data[position + 3];
+		const uint8_t* segment = data + position + 4;
+		if (length < 2 || position + 2 + length > size) return Fail(error, "truncated segment");
+		uint32_t segmentSize = length - 2;
+		position += 2 + length;
+
+		if (marker == 0xE1) {
+			if (ReadExifSRGB(segment, segmentSize)) *sRGB = true;
+		}
+		else if (marker == 0xEE) {
+			// Adobe transform 0 means the three components are RGB, not YCbCr
+			if (segmentSize >= 12 && memcmp(segment, "Adobe", 5) == 0 && segment[11] == 0) adobeRGB = true;
+		}
+		else if (marker == 0xDB) {
+			for (uint32_t offset = 0; offset < segmentSize;) {
+				int precision = segment[offset] >> 4;
+				int table = segment[offset] & 3;
+				offset++;
+
+				uint32_t tableSize = precision ? 128 : 64;
+				if (offset + tableSize > segmentSize) return Fail(error, "truncated quantization table");
+
+				for (int i = 0; i < 64; i++) {
+					quantTables[table][i] = precision ? (uint16_t)((segment[offset + i * 2] << 8) | segment[offset + i * 2 + 1]) : segment[offset + i];
+				}
+				offset += tableSize;
+			}
+		}
+		else if (marker == 0xC4) {
+			for (uint32_t offset = 0; offset < segmentSize;) {
+				if (offset + 17 > segmentSize) return Fail(error, "truncated Huffman table");
+
+				int tableClass = segment[offset] >> 4;
+				int table = segment[offset] & 3;
+				const uint8_t* counts = segment + offset + 1;
+
+				int total = 0;
+				for (int i = 0; i < 16; i++) total += counts[i];
+				if (total > 256 || offset + 17 + total > segmentSize) return Fail(error, "bad Huffman table");
+
+				JPEGHuffman& huffman = tableClass ? acTables[table] : dcTables[table];
+				memcpy(huffman.values, segment + offset + 17, total);
+				BuildJPEGHuffman(huffman, counts);
+
+				offset += 17 + total;
+			}
+		}
+		else if (marker == 0xDD) {
+			if (segmentSize < 2) return Fail(error, "bad restart interval");
+			restartInterval = (segment[0] << 8) | segment[1];
+		}
+		else if (marker == 0xC0 || marker == 0xC1) {
+			if (segmentSize < 6 || segment[0] != 8) return Fail(error, "only 8-bit JPEGs are supported");
+
+			height = (segment[1] << 8) | segment[2];
+			width = (segment[3] << 8) | segment[4];
+			int componentCount = segment[5];
+
+			if (width == 0 || height == 0) return Fail(error, "bad dimensions");
+			if (componentCount != 1 && componentCount != 3) return Fail(error, "only grayscale and three component JPEGs are supported");
+			if (segmentSize < 6 + (uint32_t)componentCount * 3) return Fail(error, "truncated frame header");
+
+			components.resize(componentCount);
+			for (int i = 0; i < componentCount; i++) {
+				JPEGComponent& component = components[i];
+				component.id = segment[6 + i * 3];
+				component.horizontal = segment[7 + i * 3] >> 4;
+				component.vertical = segment[7 + i * 3] & 15;
+				component.quantTable = segment[8 + i * 3] & 3;
+
+				if (component.horizontal < 1 || component.horizontal > 4 || component.vertical < 1 || component.vertical > 4) return Fail(error, "bad sampling factors");
+
+				maxHorizontal = (std::max)(maxHorizontal, component.horizontal);
+				maxVertical = (std::max)(maxVertical, component.vertical);
+			}
+
+			mcusPerLine = (int)((width + 8 * maxHorizontal - 1) / (8 * maxHorizontal));
+			mcusPerColumn = (int)((height + 8 * maxVertical - 1) / (8 * maxVertical));
+
+			for (JPEGComponent& component : components) {
+				component.blocksPerLine = mcusPerLine * component.horizontal;
+				component.blocksPerColumn = mcusPerColumn * component.vertical;
+				component.plane.assign((size_t)component.blocksPerLine * component.blocksPerColumn * 64, 0);
+			}
+		}
+		else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+			return Fail(error, "progressive, lossless and arithmetic coded JPEGs are not supported");
+		}
+		else if (marker == 0xDA) {
+			if (components.empty()) return Fail(error, "scan before frame header");
+			if (segmentSize < 1) return Fail(error, "bad scan header");
+
+			int scanCount = segment[0];
+			if (scanCount < 1 || scanCount > 4 || segmentSize < 1 + (uint32_t)scanCount * 2) return Fail(error, "bad scan header");
+
+			std::vector<JPEGComponent*> scanComponents;
+			for (int i = 0; i < scanCount; i++) {
+				int id = segment[1 + i * 2];
+				JPEGComponent* found = nullptr;
+				for (JPEGComponent& component : components) {
+					if (component.id == id) found = &component;
+				}
+				if (found == nullptr) return Fail(error, "scan references an unknown component");
+
+				found->dcTable = segment[2 + i * 2] >> 4 & 3;
+				found->acTable = segment[2 + i * 2] & 3;
+				if (!dcTables[found->dcTable].defined || !acTables[found->acTable].defined) return Fail(error, "scan uses an undefined Huffman table");
+
+				found->dcPrediction = 0;
+				scanComponents.push_back(found);
+			}
+
+			JPEGBitReader reader = {};
+			reader.data = data;
+			reader.size = size;
+			reader.position = position;
+
+			// A single component scan isn't interleaved, and only covers the
+			// blocks the component actually needs rather than whole MCUs
+			int unitsPerLine, unitsPerColumn;
+			if (scanCount == 1) {
+				JPEGComponent* component = scanComponents[0];
+				uint32_t componentWidth = (width * component->horizontal + maxHorizontal - 1) / maxHorizontal;
+				uint32_t componentHeight = (height * component->vertical + maxVertical - 1) / maxVertical;
+				unitsPerLine = (int)((componentWidth + 7) / 8);
+				unitsPerColumn = (int)((componentHeight + 7) / 8);
+			}
+			else {
+				unitsPerLine = mcusPerLine;
+				unitsPerColumn = mcusPerColumn;
+			}
+
+			int unitCount = unitsPerLine * unitsPerColumn;
+			for (int unit = 0; unit < unitCount; unit++) {
+				if (restartInterval > 0 && unit > 0 && unit % restartInterval == 0) {
+					// Skip to just past the RSTn marker and start the predictors over
+					reader.bitCount = 0;
+					reader.hitMarker = false;
+					while (reader.position + 1 < size && !(data[reader.position] == 0xFF && data[reader.position + 1] >= 0xD0 && data[reader.position + 1] <= 0xD7)) {
+						reader.position++;
+					}
+					reader.position += 2;
+
+					for (JPEGComponent* component : scanComponents) component->dcPrediction = 0;
+				}
+
+				int unitX = unit % unitsPerLine;
+				int unitY = unit / unitsPerLine;
+
+				if (scanCount == 1) {
+					if (!DecodeJPEGBlock(reader, *scanComponents[0], dcTables, acTables, quantTables, unitX, unitY)) return Fail(error, "corrupt scan data");
+					continue;
+				}
+
+				for (JPEGComponent* component : scanComponents) {
+					for (int v = 0; v < component->vertical; v++) {
+						for (int h = 0; h < component->horizontal; h++) {
+							int blockX = unitX * component->horizontal + h;
+							int blockY = unitY * component->vertical + v;
+							if (!DecodeJPEGBlock(reader, *component, dcTables, acTables, quantTables, blockX, blockY)) return Fail(error, "corrupt scan data");
+						}
+					}
+				}
+			}
+
+			// Continue parsing after the entropy coded data
+			position = reader.position;
+			decodedScan = true;
+		}
+	}
+
+	if (!decodedScan) return Fail(error, "no image data");
+
+	image->width = width;
+	image->height = height;
+	image->pixels.resize((size_t)width * height * 4);
+
+	// Subsampled components are upsampled with a centered bilinear filter,
+	// which is what libjpeg's "fancy" upsampling does for the common 2x cases
+	auto sample = [&](const JPEGComponent& component, uint32_t x, uint32_t y) {
+		int stride = component.blocksPerLine * 8;
+		if (component.horizontal == maxHorizontal && component.vertical == maxVertical) {
+			return (float)component.plane[(size_t)y * stride + x];
+		}
+
+		float sampleX = (x + 0.5f) * component.horizontal / maxHorizontal - 0.5f;
+		float sampleY = (y + 0.5f) * component.vertical / maxVertical - 0.5f;
+		int maxX = (int)((width * component.horizontal + maxHorizontal - 1) / maxHorizontal) - 1;
+		int maxY = (int)((height * component.vertical + maxVertical - 1) / maxVertical) - 1;
+
+		int x0 = (int)floorf(sampleX);
+		int y0 = (int)floorf(sampleY);
+		float fractionX = sampleX - x0;
+		float fractionY = sampleY - y0;
+
+		int left = (std::max)(0, (std::min)(maxX, x0));
+		int right = (std::max)(0, (std::min)(maxX, x0 + 1));
+		int top = (std::max)(0, (std::min)(maxY, y0));
+		int bottom = (std::max)(0, (std::min)(maxY, y0 + 1));
+
+		const uint8_t* plane = component.plane.data();
+		float upper = plane[(size_t)top * stride + left] * (1.0f - fractionX) + plane[(size_t)top * stride + right] * fractionX;
+		float lower = plane[(size_t)bottom * stride + left] * (1.0f - fractionX) + plane[(size_t)bottom * stride + right] * fractionX;
+		return upper * (1.0f - fractionY) + lower * fractionY;
+	};
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			float samples[3];
+			for (size_t c = 0; c < components.size(); c++) {
+				samples[c] = sample(components[c], x, y);
+			}
+
+			uint8_t* output = &image->pixels[((size_t)y * width + x) * 4];
+			if (components.size() == 1) {
+				output[0] = output[1] = output[2] = (uint8_t)(samples[0] + 0.5f);
+			}
+			else if (adobeRGB) {
+				output[0] = (uint8_t)(samples[0] + 0.5f);
+				output[1] = (uint8_t)(samples[1] + 0.5f);
+				output[2] = (uint8_t)(samples[2] + 0.5f);
+			}
+			else {
+				float luma = samples[0];
+				float blue = samples[1] - 128.0f;
+				float red = samples[2] - 128.0f;
+
+				float rgb[3] = {
+					luma + 1.402f * red,
+					luma - 0.344136f * blue - 0.714136f * red,
+					luma + 1.772f * blue
+				};
+
+				for (int channel = 0; channel < 3; channel++) {
+					output[channel] = (uint8_t)(std::min)(255.0f, (std::max)(0.0f, rgb[channel] + 0.5f));
+				}
+			}
+
+			output[3] = 255;
+		}
+	}
+
+	return true;
+}
+
+#pragma endregion
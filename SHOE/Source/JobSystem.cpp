@@ -0,0 +1,181 @@
+#include "../Headers/JobSystem.h"
+
+#ifdef _WIN32
+#include <objbase.h>
+#endif
+
+JobSystem* JobSystem::instance;
+
+JobSystem::~JobSystem() {
+	Shutdown();
+}
+
+void JobSystem::Initialize(unsigned int workerCount) {
+	if (running) return;
+
+	if (workerCount == 0) {
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	running = true;
+	for (unsigned int i = 0; i < workerCount; i++) {
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this));
+	}
+}
+
+void JobSystem::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		if (!running) return;
+		running = false;
+	}
+
+	jobAvailable.notify_all();
+
+	for (std::thread& worker : workers) {
+		if (worker.joinable()) worker.join();
+	}
+
+	workers.clear();
+	jobs.clear();
+}
+
+unsigned int JobSystem::GetWorkerCount() {
+	return (unsigned int)workers.size();
+}
+
+void JobSystem::WorkerLoop() {
+#ifdef _WIN32
+	// WIC and other COM-based decoders need COM on every thread that uses them
+	HRESULT comResult = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+#endif
+
+	while (true) {
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobAvailable.wait(lock, [this]() { return !running || !jobs.empty(); });
+
+			// Drain what's left before exiting so no future is left hanging
+			if (!running && jobs.empty()) break;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		job();
+	}
+
+#ifdef _WIN32
+	if (SUCCEEDED(comResult)) CoUninitialize();
+#endif
+}
+
+void JobSystem::Enqueue(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		jobs.push_back(std::move(job));
+	}
+
+	jobAvailable.notify_one();
+}
+
+bool JobSystem::TryRunPendingJob() {
+	std::function<void()> job;
+
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		if (jobs.empty()) return false;
+
+		job = std::move(jobs.front());
+		jobs.pop_front();
+	}
+
+	job();
+	return true;
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, std::function<void(size_t start, size_t end)> job) {
+	if (count == 0) return;
+	if (grainSize == 0) grainSize = 1;
+
+	size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+	if (workers.empty() || chunkCount == 1) {
+		job(0, count);
+		return;
+	}
+
+	// Shared so helpers that only start after the caller has returned
+	// still have valid state to look at (they'll simply find no chunks left)
+	struct ParallelForState {
+		std::function<void(size_t, size_t)> job;
+		size_t count;
+		size_t grainSize;
+		size_t chunkCount;
+		std::atomic<size_t> nextChunk;
+		std::atomic<size_t> finishedChunks;
+		std::mutex errorMutex;
+		std::exception_ptr error;
+	};
+
+	std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+	state->job = job;
+	state->count = count;
+	state->grainSize = grainSize;
+	state->chunkCount = chunkCount;
+	state->nextChunk = 0;
+	state->finishedChunks = 0;
+
+	auto runChunks = [](std::shared_ptr<ParallelForState> state) {
+		size_t chunk;
+		while ((chunk = state->nextChunk++) < state->chunkCount) {
+			size_t start = chunk * state->grainSize;
+			size_t end = (std::min)(start + state->grainSize, state->count);
+
+			try {
+				state->job(start, end);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(state->errorMutex);
+				if (!state->error) state->error = std::current_exception();
+			}
+
+			state->finishedChunks++;
+		}
+	};
+
+	size_t helperCount = (std::min)((size_t)workers.size(), chunkCount - 1);
+	for (size_t i = 0; i < helperCount; i++) {
+		Enqueue([state, runChunks]() { runChunks(state); });
+	}
+
+	runChunks(state);
+
+	// Other threads may still be finishing their last chunk
+	while (state->finishedChunks < chunkCount) {
+		if (!TryRunPendingJob()) std::this_thread::yield();
+	}
+
+	if (state->error) std::rethrow_exception(state->error);
+}
+
+void JobSystem::QueueMainThreadJob(std::function<void()> job) {
+	std::lock_guard<std::mutex> lock(mainThreadMutex);
+	mainThreadJobs.push_back(std::move(job));
+}
+
+void JobSystem::RunMainThreadJobs() {
+	std::deque<std::function<void()>> pending;
+
+	{
+		std::lock_guard<std::mutex> lock(mainThreadMutex);
+		pending.swap(mainThreadJobs);
+	}
+
+	for (std::function<void()>& job : pending) {
+		job();
+	}
+}
@@ -0,0 +1,141 @@
+#include "../Headers/MappedFile.h"
+#include <fstream>
+#include <thread>
+#include <functional>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#else
+	fileDescriptor = -1;
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+	Close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	// Empty files can't be mapped, which is why that's checked above
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr) {
+		Close();
+		return false;
+	}
+
+	data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		Close();
+		return false;
+	}
+
+	size = (size_t)fileSize.QuadPart;
+#else
+	fileDescriptor = open(path.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) return false;
+
+	struct stat fileInfo;
+	if (fstat(fileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0) {
+		Close();
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapping == MAP_FAILED) {
+		Close();
+		return false;
+	}
+
+	data = (const unsigned char*)mapping;
+	size = (size_t)fileInfo.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+	if (data != nullptr) UnmapViewOfFile(data);
+	if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#else
+	if (data != nullptr) munmap((void*)data, size);
+	if (fileDescriptor >= 0) close(fileDescriptor);
+
+	fileDescriptor = -1;
+#endif
+
+	data = nullptr;
+	size = 0;
+}
+
+bool MappedFile::WriteWholeFile(const std::string& path, const void* data, size_t size) {
+	// Several threads can write the same file, so give each its own temp file
+	std::string tempPath = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+	{
+		std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+		if (!output.is_open()) return false;
+
+		output.write((const char*)data, (std::streamsize)size);
+		if (!output.good()) {
+			output.close();
+			std::remove(tempPath.c_str());
+			return false;
+		}
+	}
+
+	return CommitTempFile(tempPath, path);
+}
+
+bool MappedFile::CommitTempFile(const std::string& tempPath, const std::string& path) {
+#ifdef _WIN32
+	bool succeeded = MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	bool succeeded = std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+
+	if (!succeeded) std::remove(tempPath.c_str());
+
+	return succeeded;
+}
+
+bool MappedFile::IsOpen() {
+	return data != nullptr;
+}
+
+const unsigned char* MappedFile::GetData() {
+	return data;
+}
+
+size_t MappedFile::GetSize() {
+	return size;
+}
@@ -1,10 +1,17 @@
 #include "../Headers/Mesh.h"
+#include "../Headers/MeshBuilder.h"
+#include <cstdio>
+
+static_assert(sizeof(Vertex) == sizeof(MeshFileVertex), "Vertex must match the mesh file vertex layout");
 
 using namespace DirectX;
 
+MeshResidency Mesh::defaultResidency = MESH_RESIDENCY_POSITIONS;
+
 Mesh::~Mesh() {
 	delete[] vertexArray;
 	delete[] indices;
+	delete[] positions;
 }
 
 Mesh::Mesh(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCount, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name) {
@@ -15,15 +22,20 @@ Mesh::Mesh(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCo
 	this->enabled = true;
 	this->name = name;
 	this->needsDepthPrePass = false;
+	this->positions = nullptr;
+	this->residency = defaultResidency;
 
 	std::copy(vertexArray, vertexArray + vertices, this->vertexArray);
 	std::copy(indices, indices + indexCount, this->indices);
 
 	CalculateTangents(this->vertexArray, vertices, this->indices, this->indexCount);
 
-	MakeBuffers(vertexArray, vertices, indices, indexCount, device);
+	// Uploads the copy, which is the one with tangents
+	MakeBuffers(this->vertexArray, vertices, this->indices, indexCount, device);
 
-	CalculateBounds(vertexArray, vertices);
+	CalculateBounds(this->vertexArray, vertices);
+
+	ApplyResidency();
 }
 
 Mesh::Mesh(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCount, int associatedMaterialIndex, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name) {
@@ -34,6 +46,8 @@ Mesh::Mesh(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCo
 	this->enabled = true;
 	this->name = name;
 	this->needsDepthPrePass = false;
+	this->positions = nullptr;
+	this->residency = defaultResidency;
 
 	std::copy(vertexArray, vertexArray + vertices, this->vertexArray);
 	std::copy(indices, indices + indexCount, this->indices);
@@ -41,10 +55,13 @@ Mesh::Mesh(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCo
 	MakeBuffers(vertexArray, vertices, indices, indexCount, device);
 
 	CalculateBounds(vertexArray, vertices);
+
+	ApplyResidency();
 }
 
 Mesh::Mesh(std::string filename, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name) {
 	this->materialIndex = -1;
+	this->enabled = true;
 	this->name = name;
 	this->needsDepthPrePass = false;
 
@@ -63,234 +80,261 @@ Mesh::Mesh(std::string filename, Microsoft::WRL::ComPtr<ID3D11Device> device, st
 
 	this->filenameKey = baseFilename;
 
-	// Author: Chris Cascioli
-	// Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
-	// 
-	// - You are allowed to directly copy/paste this into your code base
-	//   for assignments, given that you clearly cite that this is not
-	//   code of your own design.
-	//
-	// - NOTE: You'll need to #include <fstream>
-
-	// File input object
-	std::ifstream obj(filename.c_str());
+	this->vertexArray = nullptr;
+	this->indices = nullptr;
+	this->positions = nullptr;
+	this->residency = defaultResidency;
+	this->vertexCount = 0;
+	this->indexCount = 0;
+
+	// Use the binary cache if it was built from this exact source file
+	MeshFileSourceStamp source;
+	bool hasSource = MeshFile::GetSourceStamp(filename, &source);
+	if (hasSource) {
+		MeshFileView meshFile;
+		if (meshFile.Open(MeshFile::GetCachePath(filename), sizeof(Vertex), &source)) {
+			InitializeFromMeshFile(meshFile, device);
+			return;
+		}
+	}
 
-	// Check for successful open
-	if (!obj.is_open())
+	MeshData data;
+	if (!LoadOBJ(filename, data))
 		return;
 
-	// Variables used while reading the file
-	std::vector<XMFLOAT3> positions;	// Positions from the file
-	std::vector<XMFLOAT3> normals;		// Normals from the file
-	std::vector<XMFLOAT2> uvs;		// uvs from the file
-	std::vector<Vertex> verts;		// Verts we're assembling
-	std::vector<UINT> indices;		// Indices of these verts
-	int vertCounter = 0;			// Count of vertices
-	int indexCounter = 0;			// Count of indices
-	char chars[100];			// String for line reading
-
-	// Still have data left?
-	while (obj.good())
-	{
-		// Get the line (100 characters should be more than enough)
-		obj.getline(chars, 100);
-
-		// Check the type of line
-		if (chars[0] == 'v' && chars[1] == 'n')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 norm;
-			sscanf_s(
-				chars,
-				"vn %f %f %f",
-				&norm.x, &norm.y, &norm.z);
-
-			// Add to the list of normals
-			normals.push_back(norm);
-		}
-		else if (chars[0] == 'v' && chars[1] == 't')
-		{
-			// Read the 2 numbers directly into an XMFLOAT2
-			XMFLOAT2 uv;
-			sscanf_s(
-				chars,
-				"vt %f %f",
-				&uv.x, &uv.y);
-
-			// Add to the list of uv's
-			uvs.push_back(uv);
-		}
-		else if (chars[0] == 'v')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 pos;
-			sscanf_s(
-				chars,
-				"v %f %f %f",
-				&pos.x, &pos.y, &pos.z);
-
-			// Add to the positions
-			positions.push_back(pos);
-		}
-		else if (chars[0] == 'f')
-		{
-			// Read the face indices into an array
-			// NOTE: This assumes the given obj file contains
-			//  vertex positions, uv coordinates AND normals.
-			unsigned int i[12];
-			int numbersRead = sscanf_s(
-				chars,
-				"f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-				&i[0], &i[1], &i[2],
-				&i[3], &i[4], &i[5],
-				&i[6], &i[7], &i[8],
-				&i[9], &i[10], &i[11]);
-
-			// If we only got the first number, chances are the OBJ
-			// file has no uv coordinates.  This isn't great, but we
-			// still want to load the model without crashing, so we
-			// need to re-read a different pattern (in which we assume
-			// there are no uvs denoted for any of the vertices)
-			if (numbersRead == 1)
-			{
-				// Re-read with a different pattern
-				numbersRead = sscanf_s(
-					chars,
-					"f %d//%d %d//%d %d//%d %d//%d",
-					&i[0], &i[2],
-					&i[3], &i[5],
-					&i[6], &i[8],
-					&i[9], &i[11]);
-
-				// The following indices are where the uvs should 
-				// have been, so give them a valid value
-				i[1] = 1;
-				i[4] = 1;
-				i[7] = 1;
-				i[10] = 1;
-
-				// If we have no uvs, create a single uv coordinate
-				// that will be used for all vertices
-				if (uvs.size() == 0)
-					uvs.push_back(XMFLOAT2(0, 0));
-			}
-
-			// - Create the verts by looking up
-			//    corresponding data from vectors
-			// - OBJ File indices are 1-based, so
-			//    they need to be adusted
-			Vertex v1;
-			v1.Position = positions[i[0] - 1];
-			v1.uv = uvs[i[1] - 1];
-			v1.normal = normals[i[2] - 1];
-
-			Vertex v2;
-			v2.Position = positions[i[3] - 1];
-			v2.uv = uvs[i[4] - 1];
-			v2.normal = normals[i[5] - 1];
-
-			Vertex v3;
-			v3.Position = positions[i[6] - 1];
-			v3.uv = uvs[i[7] - 1];
-			v3.normal = normals[i[8] - 1];
-
-			// The model is most likely in a right-handed space,
-			// especially if it came from Maya.  We want to convert
-			// to a left-handed space for DirectX.  This means we 
-			// need to:
-			//  - Invert the Z position
-			//  - Invert the normal's Z
-			//  - Flip the winding order
-			// We also need to flip the uv coordinate since DirectX
-			// defines (0,0) as the top left of the texture, and many
-			// 3D modeling packages use the bottom left as (0,0)
-
-			// Flip the uv's since they're probably "upside down"
-			v1.uv.y = 1.0f - v1.uv.y;
-			v2.uv.y = 1.0f - v2.uv.y;
-			v3.uv.y = 1.0f - v3.uv.y;
-
-			// Flip Z (LH vs. RH)
-			v1.Position.z *= -1.0f;
-			v2.Position.z *= -1.0f;
-			v3.Position.z *= -1.0f;
-
-			// Flip normal's Z
-			v1.normal.z *= -1.0f;
-			v2.normal.z *= -1.0f;
-			v3.normal.z *= -1.0f;
-
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-			vertCounter += 3;
-
-			// Add three more indices
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-
-			// Was there a 4th face?
-			// - 12 numbers read means 4 faces WITH uv's
-			// - 8 numbers read means 4 faces WITHOUT uv's
-			if (numbersRead == 12 || numbersRead == 8)
-			{
-				// Make the last vertex
-				Vertex v4;
-				v4.Position = positions[i[9] - 1];
-				v4.uv = uvs[i[10] - 1];
-				v4.normal = normals[i[11] - 1];
-
-				// Flip the uv, Z pos and normal's Z
-				v4.uv.y = 1.0f - v4.uv.y;
-				v4.Position.z *= -1.0f;
-				v4.normal.z *= -1.0f;
-
-				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-				vertCounter += 3;
-
-				// Add three more indices
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-			}
-		}
+	CalculateTangents(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size());
+
+	// Failing to write the cache only costs a re-parse next time
+	if (hasSource) WriteMeshFile(MeshFile::GetCachePath(filename), data, source);
+
+	MakeBuffers(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size(), device);
+
+	CalculateBounds(data.vertices.data(), (int)data.vertices.size());
+
+	StoreCPUData(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size());
+}
+
+Mesh::Mesh(const MeshData& data, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name) {
+	this->vertexArray = nullptr;
+	this->indices = nullptr;
+	this->positions = nullptr;
+	this->residency = defaultResidency;
+	this->materialIndex = -1;
+	this->enabled = true;
+	this->name = name;
+	this->needsDepthPrePass = false;
+
+	MakeBuffers(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size(), device);
+
+	CalculateBounds(data.vertices.data(), (int)data.vertices.size());
+
+	StoreCPUData(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size());
+}
+
+Mesh::Mesh(MeshFileView& meshFile, Microsoft::WRL::ComPtr<ID3D11Device> device, std::string name) {
+	this->vertexArray = nullptr;
+	this->indices = nullptr;
+	this->positions = nullptr;
+	this->residency = defaultResidency;
+	this->materialIndex = -1;
+	this->enabled = true;
+	this->name = name;
+	this->needsDepthPrePass = false;
+
+	InitializeFromMeshFile(meshFile, device);
+}
+
+Mesh::Mesh(std::shared_ptr<Mesh> source, std::string name) {
+	this->vertexArray = nullptr;
+	this->indices = nullptr;
+	this->positions = nullptr;
+	this->residency = defaultResidency;
+	this->filenameKey = source->filenameKey;
+	this->materialIndex = -1;
+	this->enabled = true;
+	this->name = name;
+	this->needsDepthPrePass = false;
+
+	SetMeshData(source);
+}
+
+/// <summary>
+/// Uploads a mesh straight from a mapped mesh file. The file was validated
+/// on open and already holds tangents and bounds, so nothing is recalculated.
+/// </summary>
+void Mesh::InitializeFromMeshFile(MeshFileView& meshFile, Microsoft::WRL::ComPtr<ID3D11Device> device) {
+	const MeshFileHeader* header = meshFile.GetHeader();
+	Vertex* fileVertices = (Vertex*)meshFile.GetVertices();
+	unsigned int* fileIndices = (unsigned int*)meshFile.GetIndices();
+
+	// The buffers are created from the mapped pages directly,
+	// the copies are only kept for CPU-side picking
+	MakeBuffers(fileVertices, header->vertexCount, fileIndices, header->indexCount, device);
+
+	StoreCPUData(fileVertices, header->vertexCount, fileIndices, header->indexCount);
+
+	bounds = BoundingOrientedBox(
+		XMFLOAT3(header->boundsCenter),
+		XMFLOAT3(header->boundsExtents),
+		XMFLOAT4(header->boundsOrientation));
+}
+
+void Mesh::SetMaterializer(std::function<void()> materializer) {
+	this->materializer = materializer;
+}
+
+bool Mesh::IsLoadDeferred() {
+	return (bool)materializer;
+}
+
+void Mesh::Materialize() {
+	if (!materializer) return;
+
+	// Cleared first, so a load that finishes inside the call can't start another
+	std::function<void()> materialize = std::move(materializer);
+	materializer = nullptr;
+	materialize();
+}
+
+/// <summary>
+/// Drops the current arrays and buffers, or the reference
+/// to the mesh they were shared from
+/// </summary>
+void Mesh::ReleaseData() {
+	sharedSource.reset();
+
+	delete[] vertexArray;
+	delete[] indices;
+	delete[] positions;
+
+	vertexArray = nullptr;
+	indices = nullptr;
+	positions = nullptr;
+	vBuffer.Reset();
+	inBuffer.Reset();
+}
+
+/// <summary>
+/// Keeps the part of freshly uploaded data the residency policy asks for
+/// </summary>
+void Mesh::StoreCPUData(const Vertex* vertices, int vertexCount, const unsigned int* indices, int indexCount) {
+	if (residency == MESH_RESIDENCY_DISCARD) return;
+
+	this->indices = new unsigned int[indexCount];
+	std::copy(indices, indices + indexCount, this->indices);
+
+	if (residency == MESH_RESIDENCY_FULL) {
+		this->vertexArray = new Vertex[vertexCount];
+		std::copy(vertices, vertices + vertexCount, this->vertexArray);
+	}
+	else {
+		this->positions = new XMFLOAT3[vertexCount];
+		for (int i = 0; i < vertexCount; i++) this->positions[i] = vertices[i].Position;
+	}
+}
+
+/// <summary>
+/// Trims data that's already stored down to the residency policy
+/// </summary>
+void Mesh::ApplyResidency() {
+	if (sharedSource != nullptr) return;
+
+	if (residency == MESH_RESIDENCY_DISCARD) {
+		delete[] vertexArray;
+		delete[] indices;
+		delete[] positions;
+		vertexArray = nullptr;
+		indices = nullptr;
+		positions = nullptr;
+	}
+	else if (residency == MESH_RESIDENCY_POSITIONS && vertexArray != nullptr) {
+		positions = new XMFLOAT3[vertexCount];
+		for (int i = 0; i < vertexCount; i++) positions[i] = vertexArray[i].Position;
+
+		delete[] vertexArray;
+		vertexArray = nullptr;
 	}
+}
+
+void Mesh::SetMeshData(const MeshData& data, Microsoft::WRL::ComPtr<ID3D11Device> device) {
+	ReleaseData();
+
+	MakeBuffers(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size(), device);
+
+	CalculateBounds(data.vertices.data(), (int)data.vertices.size());
+
+	StoreCPUData(data.vertices.data(), (int)data.vertices.size(), data.indices.data(), (int)data.indices.size());
+}
+
+void Mesh::SetMeshData(MeshFileView& meshFile, Microsoft::WRL::ComPtr<ID3D11Device> device) {
+	ReleaseData();
+
+	InitializeFromMeshFile(meshFile, device);
+}
 
-	// Close the file and create the actual buffers
-	obj.close();
+void Mesh::SetMeshData(std::shared_ptr<Mesh> source) {
+	ReleaseData();
 
-	// - At this point, "verts" is a vector of Vertex structs, and can be used
-	//    directly to create a vertex buffer:  &verts[0] is the address of the first vert
-	//
-	// - The vector "indices" is similar. It's a vector of unsigned ints and
-	//    can be used directly for the index buffer: &indices[0] is the address of the first int
-	//
-	// - "vertCounter" is the number of vertices
-	// - "indexCounter" is the number of indices
-	// - Yes, these are effectively the same since OBJs do not index entire vertices!  This means
-	//    an index buffer isn't doing much for us.  We could try to optimize the mesh ourselves
-	//    and detect duplicate vertices, but at that point it would be better to use a more
-	//    sophisticated model loading library like TinyOBJLoader or AssImp (yes, that's its name)
+	// The CPU copy is read through the source, so it stays valid if the source trims it
+	this->sharedSource = source;
+	this->vBuffer = source->vBuffer;
+	this->inBuffer = source->inBuffer;
+	this->vertexCount = source->vertexCount;
+	this->indexCount = source->indexCount;
+	this->bounds = source->bounds;
+}
 
-	this->vertexArray = new Vertex[vertCounter];
-	this->indices = new unsigned int[indexCounter];
-	this->indexCount = indexCounter;
-	std::copy(verts.begin(), verts.end(), vertexArray);
-	std::copy(indices.begin(), indices.end(), this->indices);
+/// <summary>
+/// Writes loaded mesh data out as a binary mesh file, so the next
+/// load can map it instead of parsing the source again
+/// </summary>
+/// <param name="filename">Path of the .smesh to write</param>
+/// <param name="data">Vertices and indices with tangents already calculated</param>
+/// <param name="source">Stamp of the file the data was loaded from</param>
+/// <returns>False if the file couldn't be written</returns>
+bool Mesh::WriteMeshFile(std::string filename, const MeshData& data, const MeshFileSourceStamp& source) {
+	if (data.vertices.empty()) return false;
+
+	BoundingOrientedBox fileBounds;
+	BoundingOrientedBox::CreateFromPoints(fileBounds, data.vertices.size(), &data.vertices[0].Position, sizeof(Vertex));
+
+	MeshFileContents contents = {};
+	contents.vertices = data.vertices.data();
+	contents.vertexCount = (uint32_t)data.vertices.size();
+	contents.vertexStride = sizeof(Vertex);
+	contents.indices = data.indices.data();
+	contents.indexCount = (uint32_t)data.indices.size();
+	memcpy(contents.boundsCenter, &fileBounds.Center, sizeof(contents.boundsCenter));
+	memcpy(contents.boundsExtents, &fileBounds.Extents, sizeof(contents.boundsExtents));
+	memcpy(contents.boundsOrientation, &fileBounds.Orientation, sizeof(contents.boundsOrientation));
+
+	return MeshFile::Write(filename, contents, source);
+}
 
-	CalculateTangents(&verts[0], vertCounter, &indices[0], indexCounter);
+/// <summary>
+/// Parses an .obj file into vertex and index data. Doesn't touch
+/// the device, so it can be run on a worker thread.
+/// </summary>
+/// <param name="filename">Full path to the .obj</param>
+/// <param name="outData">Filled with the parsed vertices and indices</param>
+/// <returns>False if the file couldn't be opened or has a malformed face</returns>
+bool Mesh::LoadOBJ(std::string filename, MeshData& outData)
+{
+	std::vector<MeshFileVertex> fileVertices;
+	std::string error;
+	if (!MeshBuilder::LoadOBJ(filename, &fileVertices, &outData.indices, &error)) {
+		printf("Failed to load mesh %s: %s\n", filename.c_str(), error.c_str());
+		return false;
+	}
 
-	MakeBuffers(&verts[0], vertCounter, &indices[0], indexCounter, device);
+	outData.vertices.resize(fileVertices.size());
+	if (!fileVertices.empty()) memcpy(outData.vertices.data(), fileVertices.data(), fileVertices.size() * sizeof(Vertex));
 
-	CalculateBounds(&verts[0], vertCounter);
+	return true;
 }
 
-void Mesh::MakeBuffers(Vertex* vertexArray, int vertices, unsigned int* indices, int indexCount, Microsoft::WRL::ComPtr<ID3D11Device> device) {
+void Mesh::MakeBuffers(const Vertex* vertexArray, int vertices, const unsigned int* indices, int indexCount, Microsoft::WRL::ComPtr<ID3D11Device> device) {
+	this->vertexCount = vertices;
 	this->indexCount = indexCount;
 
 	D3D11_BUFFER_DESC vbd;
@@ -328,89 +372,18 @@ void Mesh::MakeBuffers(Vertex* vertexArray, int vertices, unsigned int* indices,
 	device->CreateBuffer(&ibd, &initialIndexData, inBuffer.GetAddressOf());
 }
 
-// Calculates the tangents of the vertices in a mesh
-// - Code originally adapted from: http://www.terathon.com/code/tangent.html
-//   - Updated version now found here: http://foundationsofgameenginedev.com/FGED2-sample.pdf
-//   - See listing 7.4 in section 7.5 (page 9 of the PDF)
-//
-// - Note: For this code to work, your Vertex format must
-//         contain an XMFLOAT3 called Tangent
+// Calculates the tangents of the vertices in a mesh, with their handedness in w
+// - Shared with the asset cooker through MeshBuilder, so
+//   cooked and runtime-loaded meshes get identical tangents
 //
 // - Be sure to call this BEFORE creating your D3D vertex/index buffers
 //
 void Mesh::CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices)
 {
-	// Reset tangents
-	for (int i = 0; i < numVerts; i++)
-	{
-		verts[i].Tangent = XMFLOAT3(0, 0, 0);
-	}
-
-	// Calculate tangents one whole triangle at a time
-	for (int i = 0; i < numIndices;)
-	{
-		// Grab indices and vertices of first triangle
-		unsigned int i1 = indices[i++];
-		unsigned int i2 = indices[i++];
-		unsigned int i3 = indices[i++];
-		Vertex* v1 = &verts[i1];
-		Vertex* v2 = &verts[i2];
-		Vertex* v3 = &verts[i3];
-
-		// Calculate vectors relative to triangle positions
-		float x1 = v2->Position.x - v1->Position.x;
-		float y1 = v2->Position.y - v1->Position.y;
-		float z1 = v2->Position.z - v1->Position.z;
-
-		float x2 = v3->Position.x - v1->Position.x;
-		float y2 = v3->Position.y - v1->Position.y;
-		float z2 = v3->Position.z - v1->Position.z;
-
-		// Do the same for vectors relative to triangle uv's
-		float s1 = v2->uv.x - v1->uv.x;
-		float t1 = v2->uv.y - v1->uv.y;
-
-		float s2 = v3->uv.x - v1->uv.x;
-		float t2 = v3->uv.y - v1->uv.y;
-
-		// Create vectors for tangent calculation
-		float r = 1.0f / (s1 * t2 - s2 * t1);
-
-		float tx = (t2 * x1 - t1 * x2) * r;
-		float ty = (t2 * y1 - t1 * y2) * r;
-		float tz = (t2 * z1 - t1 * z2) * r;
-
-		// Adjust tangents of each vert of the triangle
-		v1->Tangent.x += tx;
-		v1->Tangent.y += ty;
-		v1->Tangent.z += tz;
-
-		v2->Tangent.x += tx;
-		v2->Tangent.y += ty;
-		v2->Tangent.z += tz;
-
-		v3->Tangent.x += tx;
-		v3->Tangent.y += ty;
-		v3->Tangent.z += tz;
-	}
-
-	// Ensure all of the tangents are orthogonal to the normals
-	for (int i = 0; i < numVerts; i++)
-	{
-		// Grab the two vectors
-		XMVECTOR normal = XMLoadFloat3(&verts[i].normal);
-		XMVECTOR tangent = XMLoadFloat3(&verts[i].Tangent);
-
-		// Use Gram-Schmidt orthogonalize
-		tangent = XMVector3Normalize(
-			tangent - normal * XMVector3Dot(normal, tangent));
-
-		// Store the tangent
-		XMStoreFloat3(&verts[i].Tangent, tangent);
-	}
+	MeshBuilder::CalculateTangents((MeshFileVertex*)verts, numVerts, indices, numIndices);
 }
 
-void Mesh::CalculateBounds(Vertex* verts, int numVerts)
+void Mesh::CalculateBounds(const Vertex* verts, int numVerts)
 {
 	DirectX::XMFLOAT3* positions = new DirectX::XMFLOAT3[numVerts];
 	for (int i = 0; i < numVerts; i++) positions[i] = verts[i].Position;
@@ -424,23 +397,108 @@ void Mesh::CalculateBounds(Vertex* verts, int numVerts)
 }
 
 Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetVertexBuffer() {
+	Materialize();
+
 	return vBuffer;
 }
 
 Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetIndexBuffer() {
+	Materialize();
+
 	return inBuffer;
 }
 
 Vertex* Mesh::GetVertexArray()
 {
+	Materialize();
+
+	if (sharedSource != nullptr) return sharedSource->GetVertexArray();
+
 	return vertexArray;
 }
 
 unsigned int* Mesh::GetIndexArray()
 {
+	Materialize();
+
+	if (sharedSource != nullptr) return sharedSource->GetIndexArray();
+
 	return indices;
 }
 
+void Mesh::SetDefaultResidency(MeshResidency residency) {
+	defaultResidency = residency;
+}
+
+MeshResidency Mesh::GetDefaultResidency() {
+	return defaultResidency;
+}
+
+void Mesh::SetResidency(MeshResidency residency) {
+	if (sharedSource != nullptr) {
+		sharedSource->SetResidency(residency);
+		return;
+	}
+
+	this->residency = residency;
+	ApplyResidency();
+}
+
+MeshResidency Mesh::GetResidency() {
+	if (sharedSource != nullptr) return sharedSource->GetResidency();
+
+	return this->residency;
+}
+
+size_t Mesh::GetCPUMemorySize() {
+	if (sharedSource != nullptr) return 0;
+
+	size_t size = 0;
+	if (vertexArray != nullptr) size += sizeof(Vertex) * vertexCount;
+	if (positions != nullptr) size += sizeof(XMFLOAT3) * vertexCount;
+	if (indices != nullptr) size += sizeof(unsigned int) * indexCount;
+
+	return size;
+}
+
+bool Mesh::Raycast(FXMVECTOR origin, FXMVECTOR direction, CXMMATRIX world, float* distance) {
+	Materialize();
+
+	if (sharedSource != nullptr) return sharedSource->Raycast(origin, direction, world, distance);
+
+	if (indices == nullptr) {
+		BoundingOrientedBox worldBounds;
+		bounds.Transform(worldBounds, world);
+		return worldBounds.Intersects(origin, direction, *distance);
+	}
+
+	// Positions are either compacted or read out of the full vertices
+	const XMFLOAT3* vertexPositions = positions != nullptr ? positions : &vertexArray[0].Position;
+	size_t stride = positions != nullptr ? sizeof(XMFLOAT3) : sizeof(Vertex);
+	auto getPosition = [&](unsigned int index) {
+		const XMFLOAT3* position = (const XMFLOAT3*)((const char*)vertexPositions + stride * index);
+		return XMVector3Transform(XMLoadFloat3(position), world);
+	};
+
+	bool hit = false;
+	float distToTri;
+	for (int i = 0; i + 2 < indexCount; i += 3) {
+		XMVECTOR vertex0 = getPosition(indices[i]);
+		XMVECTOR vertex1 = getPosition(indices[i + 1]);
+		XMVECTOR vertex2 = getPosition(indices[i + 2]);
+		if (TriangleTests::Intersects(origin, direction, vertex0, vertex1, vertex2, distToTri) && (!hit || distToTri < *distance)) {
+			*distance = distToTri;
+			hit = true;
+		}
+	}
+
+	return hit;
+}
+
+int Mesh::GetVertexCount() {
+	return this->vertexCount;
+}
+
 int Mesh::GetIndexCount() {
 	return this->indexCount;
 }
@@ -471,6 +529,8 @@ void Mesh::SetFileNameKey(std::string newKey) {
 
 DirectX::BoundingOrientedBox Mesh::GetBounds()
 {
+	Materialize();
+
 	return bounds;
 }
 
@@ -0,0 +1,286 @@
+#include "../Headers/MeshBuilder.h"
+#include "../Headers/ObjParser.h"
+#include "../Headers/JobSystem.h"
+#include "../Headers/VirtualFileSystem.h"
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <xmmintrin.h>
+
+bool MeshBuilder::LoadOBJ(const std::string& filename, std::vector<MeshFileVertex>* vertices, std::vector<uint32_t>* indices, std::string* error)
+{
+	return ObjParser::Parse(filename, vertices, indices, error);
+}
+
+bool MeshBuilder::LoadHeightmap(const std::string& filename, uint32_t mapWidth, uint32_t mapHeight, std::vector<uint16_t>* heights) {
+	std::vector<char> data;
+	if (!VirtualFileSystem::GetInstance().ReadWholeFile(filename, &data)) return false;
+
+	// Short files leave the remaining samples flat, like the original loader
+	size_t sampleCount = (size_t)mapWidth * mapHeight;
+	heights->assign(sampleCount, 0);
+
+	memcpy(heights->data(), data.data(), (std::min)(data.size(), sampleCount * sizeof(uint16_t)));
+	return true;
+}
+
+void MeshBuilder::BuildTerrain(const uint16_t* heights,
+							   uint32_t mapWidth,
+							   uint32_t mapHeight,
+							   float heightScale,
+							   std::vector<MeshFileVertex>* vertices,
+							   std::vector<uint32_t>* indices)
+{
+	vertices->assign((size_t)mapWidth * mapHeight, MeshFileVertex());
+	indices->clear();
+
+	if (mapWidth < 2 || mapHeight < 2) return;
+
+	indices->reserve((size_t)(mapWidth - 1) * (mapHeight - 1) * 6);
+
+	// Positions first, so every triangle normal below sees its final corners
+	for (uint32_t z = 0; z < mapHeight; z++) {
+		for (uint32_t x = 0; x < mapWidth; x++) {
+			MeshFileVertex& vertex = (*vertices)[mapWidth * z + x];
+
+			vertex.position[0] = (float)x;
+			vertex.position[1] = (heights[mapWidth * z + x] / 65535.0f) * heightScale;
+			vertex.position[2] = (float)z;
+
+			vertex.uv[0] = x / (float)mapWidth;
+			vertex.uv[1] = z / (float)mapWidth;
+		}
+	}
+
+	// Two triangles per grid cell. Each triangle's face normal is added
+	// to its corners, and the sums are normalized at the end.
+	for (uint32_t z = 0; z < mapHeight - 1; z++) {
+		for (uint32_t x = 0; x < mapWidth - 1; x++) {
+			uint32_t index = mapWidth * z + x;
+			uint32_t cell[6] = {
+				index, index + mapWidth, index + 1 + mapWidth,
+				index, index + 1 + mapWidth, index + 1
+			};
+
+			for (int triangle = 0; triangle < 2; triangle++) {
+				MeshFileVertex& v0 = (*vertices)[cell[triangle * 3]];
+				MeshFileVertex& v1 = (*vertices)[cell[triangle * 3 + 1]];
+				MeshFileVertex& v2 = (*vertices)[cell[triangle * 3 + 2]];
+
+				float e1[3], e2[3];
+				for (int i = 0; i < 3; i++) {
+					e1[i] = v1.position[i] - v0.position[i];
+					e2[i] = v2.position[i] - v0.position[i];
+				}
+
+				float normal[3] = {
+					e1[1] * e2[2] - e1[2] * e2[1],
+					e1[2] * e2[0] - e1[0] * e2[2],
+					e1[0] * e2[1] - e1[1] * e2[0]
+				};
+
+				float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				if (length > 0.0f) {
+					for (int i = 0; i < 3; i++) {
+						normal[i] /= length;
+						v0.normal[i] += normal[i];
+						v1.normal[i] += normal[i];
+						v2.normal[i] += normal[i];
+					}
+				}
+
+				indices->push_back(cell[triangle * 3]);
+				indices->push_back(cell[triangle * 3 + 1]);
+				indices->push_back(cell[triangle * 3 + 2]);
+			}
+		}
+	}
+
+	for (MeshFileVertex& vertex : *vertices) {
+		float length = sqrtf(vertex.normal[0] * vertex.normal[0] + vertex.normal[1] * vertex.normal[1] + vertex.normal[2] * vertex.normal[2]);
+		if (length > 0.0f) {
+			for (int i = 0; i < 3; i++) vertex.normal[i] /= length;
+		}
+		else {
+			vertex.normal[1] = 1.0f;
+		}
+	}
+}
+
+#pragma region tangents
+// Tangent frame of one triangle, from its positions and uvs.
+// w is unused, and kept zero so whole registers can be loaded.
+struct TriangleFrame {
+	float tangent[4];
+	float bitangent[4];
+	// Angle at each corner, used to weight the corner's vertex
+	float cornerAngles[3];
+};
+
+// x, y and z dot product, in every lane. Inputs must have a zero w.
+static inline __m128 Dot3(__m128 a, __m128 b) {
+	__m128 products = _mm_mul_ps(a, b);
+	__m128 swapped = _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(products, swapped);
+	sums = _mm_add_ss(sums, _mm_movehl_ps(swapped, sums));
+	return _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(0, 0, 0, 0));
+}
+
+// Cross product of x, y and z, with a zero w
+static inline __m128 Cross3(__m128 a, __m128 b) {
+	__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 crossed = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+	return _mm_shuffle_ps(crossed, crossed, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// Zero length vectors stay zero
+static inline __m128 Normalize3(__m128 v) {
+	__m128 lengthSquared = Dot3(v, v);
+	if (_mm_cvtss_f32(lengthSquared) <= 0.0f) return _mm_setzero_ps();
+
+	return _mm_div_ps(v, _mm_sqrt_ps(lengthSquared));
+}
+
+static inline __m128 Load3(const float* v) {
+	return _mm_set_ps(0.0f, v[2], v[1], v[0]);
+}
+
+// Removes the part of v along a unit normal, and normalizes what's left
+static inline __m128 Orthogonalize(__m128 v, __m128 normal) {
+	return Normalize3(_mm_sub_ps(v, _mm_mul_ps(normal, Dot3(normal, v))));
+}
+
+static inline float CornerAngle(__m128 toFirst, __m128 toSecond) {
+	float cosine = _mm_cvtss_f32(Dot3(Normalize3(toFirst), Normalize3(toSecond)));
+	return acosf((std::max)(-1.0f, (std::min)(1.0f, cosine)));
+}
+
+// Calculates the tangents of the vertices in a mesh, following MikkTSpace:
+// each triangle's uv derived tangent and bitangent are projected into a
+// vertex's tangent plane and weighted by the triangle's angle at that vertex.
+// The sign in w is the bitangent's handedness. Shaders rebuild the bitangent
+// as cross(tangent, normal) * w, which points along -v since texture rows run down.
+// Vertices aren't split where mirrored and unmirrored triangles meet,
+// they average like any other seam.
+//
+// - Triangles and vertices are each processed in parallel. Vertices
+//   gather from their triangles through an adjacency list, built in
+//   triangle order, so no two threads write the same vertex and the
+//   sums are the same on every run. The cooker relies on that.
+//
+// - Be sure to call this BEFORE creating your D3D vertex/index buffers
+//
+void MeshBuilder::CalculateTangents(MeshFileVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+{
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	uint32_t triangleCount = indexCount / 3;
+
+	std::vector<TriangleFrame> frames(triangleCount);
+	jobSystem.ParallelFor(triangleCount, TANGENT_GRAIN_SIZE, [&](size_t start, size_t end) {
+		for (size_t triangle = start; triangle < end; triangle++) {
+			const MeshFileVertex& v0 = vertices[indices[triangle * 3]];
+			const MeshFileVertex& v1 = vertices[indices[triangle * 3 + 1]];
+			const MeshFileVertex& v2 = vertices[indices[triangle * 3 + 2]];
+			TriangleFrame& frame = frames[triangle];
+
+			__m128 p0 = Load3(v0.position);
+			__m128 p1 = Load3(v1.position);
+			__m128 p2 = Load3(v2.position);
+			__m128 edge1 = _mm_sub_ps(p1, p0);
+			__m128 edge2 = _mm_sub_ps(p2, p0);
+
+			frame.cornerAngles[0] = CornerAngle(edge1, edge2);
+			frame.cornerAngles[1] = CornerAngle(_mm_sub_ps(p2, p1), _mm_sub_ps(p0, p1));
+			frame.cornerAngles[2] = CornerAngle(_mm_sub_ps(p0, p2), _mm_sub_ps(p1, p2));
+
+			float s1 = v1.uv[0] - v0.uv[0];
+			float t1 = v1.uv[1] - v0.uv[1];
+			float s2 = v2.uv[0] - v0.uv[0];
+			float t2 = v2.uv[1] - v0.uv[1];
+
+			// Twice the signed uv area. Flipping both directions when it's
+			// negative is the same as dividing by it, without the division.
+			float uvArea = s1 * t2 - s2 * t1;
+			if (uvArea == 0.0f) {
+				// Degenerate uvs say nothing about the tangent, so the triangle adds nothing
+				_mm_storeu_ps(frame.tangent, _mm_setzero_ps());
+				_mm_storeu_ps(frame.bitangent, _mm_setzero_ps());
+				continue;
+			}
+
+			__m128 uvSign = _mm_set1_ps(uvArea < 0.0f ? -1.0f : 1.0f);
+			__m128 tangent = _mm_sub_ps(_mm_mul_ps(edge1, _mm_set1_ps(t2)), _mm_mul_ps(edge2, _mm_set1_ps(t1)));
+			__m128 bitangent = _mm_sub_ps(_mm_mul_ps(edge2, _mm_set1_ps(s1)), _mm_mul_ps(edge1, _mm_set1_ps(s2)));
+
+			_mm_storeu_ps(frame.tangent, Normalize3(_mm_mul_ps(tangent, uvSign)));
+			_mm_storeu_ps(frame.bitangent, Normalize3(_mm_mul_ps(bitangent, uvSign)));
+		}
+	});
+
+	// Every corner, grouped by vertex: corners[cornerStarts[v]] up to
+	// corners[cornerStarts[v + 1]] are the ones that use vertex v
+	std::vector<uint32_t> cornerStarts(vertexCount + 1, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; i++) {
+		cornerStarts[indices[i] + 1]++;
+	}
+
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		cornerStarts[v + 1] += cornerStarts[v];
+	}
+
+	std::vector<uint32_t> corners(triangleCount * 3);
+	std::vector<uint32_t> nextCorner(cornerStarts.begin(), cornerStarts.end() - 1);
+	for (uint32_t i = 0; i < triangleCount * 3; i++) {
+		corners[nextCorner[indices[i]]++] = i;
+	}
+
+	jobSystem.ParallelFor(vertexCount, TANGENT_GRAIN_SIZE, [&](size_t start, size_t end) {
+		for (size_t v = start; v < end; v++) {
+			MeshFileVertex& vertex = vertices[v];
+			__m128 normal = Normalize3(Load3(vertex.normal));
+			__m128 tangent = _mm_setzero_ps();
+			__m128 bitangent = _mm_setzero_ps();
+
+			for (uint32_t c = cornerStarts[v]; c < cornerStarts[v + 1]; c++) {
+				const TriangleFrame& frame = frames[corners[c] / 3];
+				__m128 weight = _mm_set1_ps(frame.cornerAngles[corners[c] % 3]);
+
+				tangent = _mm_add_ps(tangent, _mm_mul_ps(Orthogonalize(_mm_loadu_ps(frame.tangent), normal), weight));
+				bitangent = _mm_add_ps(bitangent, _mm_mul_ps(Orthogonalize(_mm_loadu_ps(frame.bitangent), normal), weight));
+			}
+
+			// Degenerate tangents stay zero, same as XMVector3Normalize
+			tangent = Orthogonalize(tangent, normal);
+			float handedness = _mm_cvtss_f32(Dot3(Cross3(normal, tangent), bitangent)) < 0.0f ? -1.0f : 1.0f;
+
+			_mm_storeu_ps(vertex.tangent, tangent);
+			vertex.tangent[3] = handedness;
+		}
+	});
+}
+#pragma endregion
+
+void MeshBuilder::CalculateBounds(const MeshFileVertex* vertices, uint32_t vertexCount, MeshFileContents* contents) {
+	float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			minimum[axis] = (std::min)(minimum[axis], vertices[i].position[axis]);
+			maximum[axis] = (std::max)(maximum[axis], vertices[i].position[axis]);
+		}
+	}
+
+	for (int axis = 0; axis < 3; axis++) {
+		if (vertexCount == 0) minimum[axis] = maximum[axis] = 0.0f;
+
+		contents->boundsCenter[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+		contents->boundsExtents[axis] = (maximum[axis] - minimum[axis]) * 0.5f;
+		contents->boundsOrientation[axis] = 0.0f;
+	}
+
+	contents->boundsOrientation[3] = 1.0f;
+}
@@ -0,0 +1,328 @@
+#include "../Headers/MeshFile.h"
+#include <cstring>
+#include <algorithm>
+
+#pragma region view
+
+bool MeshFileView::Open(const std::string& path, uint32_t expectedVertexStride, const MeshFileSourceStamp* expectedSource) {
+	Close();
+
+	if (!file.Open(path)) return false;
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+
+	if (size < sizeof(MeshFileHeader)) {
+		Close();
+		return false;
+	}
+
+	const MeshFileHeader* fileHeader = (const MeshFileHeader*)data;
+	if (fileHeader->magic != MESH_FILE_MAGIC ||
+		fileHeader->version != MESH_FILE_VERSION ||
+		fileHeader->headerSize != sizeof(MeshFileHeader) ||
+		fileHeader->vertexStride != expectedVertexStride) {
+		Close();
+		return false;
+	}
+
+	if (expectedSource != nullptr &&
+		(fileHeader->source.size != expectedSource->size ||
+		 fileHeader->source.modifiedTime != expectedSource->modifiedTime)) {
+		Close();
+		return false;
+	}
+
+	uint64_t tableEnd = sizeof(MeshFileHeader) + (uint64_t)fileHeader->sectionCount * sizeof(MeshFileSection);
+	if (tableEnd > size) {
+		Close();
+		return false;
+	}
+
+	// Every section has to lie inside the file, so nothing read
+	// through the view later can run off the end of the mapping
+	const MeshFileSection* sections = (const MeshFileSection*)(data + sizeof(MeshFileHeader));
+	for (uint32_t i = 0; i < fileHeader->sectionCount; i++) {
+		if (sections[i].offset < tableEnd ||
+			sections[i].offset > size ||
+			sections[i].offset % MESH_FILE_SECTION_ALIGNMENT != 0 ||
+			sections[i].size > size - sections[i].offset) {
+			Close();
+			return false;
+		}
+	}
+
+	header = fileHeader;
+
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	const void* vertices = GetSectionData(MESH_SECTION_VERTICES, &vertexCount);
+	const uint32_t* indices = (const uint32_t*)GetSectionData(MESH_SECTION_INDICES, &indexCount);
+
+	if (vertices == nullptr || indices == nullptr || vertexCount != header->vertexCount || indexCount != header->indexCount) {
+		Close();
+		return false;
+	}
+
+	// An out of range index would read past the vertex buffer on the GPU
+	for (uint32_t i = 0; i < indexCount; i++) {
+		if (indices[i] >= vertexCount) {
+			Close();
+			return false;
+		}
+	}
+
+	if (!MeshletsValid(vertexCount)) {
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshFileView::MeshletsValid(uint32_t vertexCount) {
+	uint32_t meshletCount;
+	uint32_t meshletVertexCount;
+	uint32_t meshletTriangleCount;
+	const MeshFileMeshlet* meshlets = GetMeshlets(&meshletCount);
+	const uint32_t* meshletVertices = GetMeshletVertices(&meshletVertexCount);
+	const uint8_t* meshletTriangles = GetMeshletTriangles(&meshletTriangleCount);
+
+	for (uint32_t i = 0; i < meshletVertexCount; i++) {
+		if (meshletVertices[i] >= vertexCount) return false;
+	}
+
+	for (uint32_t m = 0; m < meshletCount; m++) {
+		const MeshFileMeshlet& meshlet = meshlets[m];
+		if (meshlet.vertexCount > MESHLET_MAX_VERTICES ||
+			meshlet.triangleCount > MESHLET_MAX_TRIANGLES ||
+			(uint64_t)meshlet.vertexOffset + meshlet.vertexCount > meshletVertexCount ||
+			(uint64_t)meshlet.triangleOffset + meshlet.triangleCount * 3ull > meshletTriangleCount) {
+			return false;
+		}
+
+		// Triangles index the meshlet's own vertices
+		for (uint32_t t = 0; t < meshlet.triangleCount * 3; t++) {
+			if (meshletTriangles[meshlet.triangleOffset + t] >= meshlet.vertexCount) return false;
+		}
+	}
+
+	return true;
+}
+
+void MeshFileView::Close() {
+	file.Close();
+	header = nullptr;
+}
+
+const MeshFileHeader* MeshFileView::GetHeader() {
+	return header;
+}
+
+const void* MeshFileView::GetVertices() {
+	uint32_t count;
+	return GetSectionData(MESH_SECTION_VERTICES, &count);
+}
+
+const uint32_t* MeshFileView::GetIndices() {
+	uint32_t count;
+	return (const uint32_t*)GetSectionData(MESH_SECTION_INDICES, &count);
+}
+
+const MeshFileMeshlet* MeshFileView::GetMeshlets(uint32_t* count) {
+	return (const MeshFileMeshlet*)GetSectionData(MESH_SECTION_MESHLETS, count);
+}
+
+const uint32_t* MeshFileView::GetMeshletVertices(uint32_t* count) {
+	return (const uint32_t*)GetSectionData(MESH_SECTION_MESHLET_VERTICES, count);
+}
+
+const uint8_t* MeshFileView::GetMeshletTriangles(uint32_t* count) {
+	return (const uint8_t*)GetSectionData(MESH_SECTION_MESHLET_TRIANGLES, count);
+}
+
+const MeshFileTerrain* MeshFileView::GetTerrain() {
+	uint32_t count;
+	return (const MeshFileTerrain*)GetSectionData(MESH_SECTION_TERRAIN, &count);
+}
+
+const MeshFileSection* MeshFileView::FindSection(uint32_t type) {
+	if (header == nullptr) return nullptr;
+
+	const MeshFileSection* sections = (const MeshFileSection*)(file.GetData() + sizeof(MeshFileHeader));
+	for (uint32_t i = 0; i < header->sectionCount; i++) {
+		if (sections[i].type == type) return &sections[i];
+	}
+
+	return nullptr;
+}
+
+const void* MeshFileView::GetSectionData(uint32_t type, uint32_t* count) {
+	*count = 0;
+
+	const MeshFileSection* section = FindSection(type);
+	if (section == nullptr || section->elementStride == 0) return nullptr;
+
+	*count = (uint32_t)(section->size / section->elementStride);
+	return file.GetData() + section->offset;
+}
+
+#pragma endregion
+
+#pragma region writing
+
+std::string MeshFile::GetCachePath(const std::string& sourcePath) {
+	return sourcePath + MESH_FILE_EXTENSION;
+}
+
+bool MeshFile::GetSourceStamp(const std::string& sourcePath, MeshFileSourceStamp* stamp) {
+	// Packed files keep the stamp of the file they were packed from, so cooked files packed with them stay valid
+	VirtualFileInfo info;
+	if (!VirtualFileSystem::GetInstance().GetFileInfo(sourcePath, &info)) return false;
+
+	stamp->size = info.size;
+	stamp->modifiedTime = info.modifiedTime;
+	return true;
+}
+
+bool MeshFile::Write(const std::string& path, const MeshFileContents& contents, const MeshFileSourceStamp& source) {
+	struct PendingSection {
+		uint32_t type;
+		uint32_t elementStride;
+		const void* data;
+		uint64_t size;
+	};
+
+	std::vector<MeshFileMeshlet> builtMeshlets;
+	std::vector<uint32_t> builtMeshletVertices;
+	std::vector<uint8_t> builtMeshletTriangles;
+	const std::vector<MeshFileMeshlet>* meshlets = &contents.meshlets;
+	const std::vector<uint32_t>* meshletVertices = &contents.meshletVertices;
+	const std::vector<uint8_t>* meshletTriangles = &contents.meshletTriangles;
+
+	if (contents.meshlets.empty()) {
+		BuildMeshlets(contents.indices, contents.indexCount, &builtMeshlets, &builtMeshletVertices, &builtMeshletTriangles);
+		meshlets = &builtMeshlets;
+		meshletVertices = &builtMeshletVertices;
+		meshletTriangles = &builtMeshletTriangles;
+	}
+
+	std::vector<PendingSection> pending = {
+		{ MESH_SECTION_VERTICES, contents.vertexStride, contents.vertices, (uint64_t)contents.vertexCount * contents.vertexStride },
+		{ MESH_SECTION_INDICES, sizeof(uint32_t), contents.indices, (uint64_t)contents.indexCount * sizeof(uint32_t) },
+		{ MESH_SECTION_MESHLETS, sizeof(MeshFileMeshlet), meshlets->data(), meshlets->size() * sizeof(MeshFileMeshlet) },
+		{ MESH_SECTION_MESHLET_VERTICES, sizeof(uint32_t), meshletVertices->data(), meshletVertices->size() * sizeof(uint32_t) },
+		{ MESH_SECTION_MESHLET_TRIANGLES, sizeof(uint8_t), meshletTriangles->data(), meshletTriangles->size() * sizeof(uint8_t) }
+	};
+
+	if (!contents.terrain.empty()) {
+		pending.push_back({ MESH_SECTION_TERRAIN, sizeof(MeshFileTerrain), contents.terrain.data(), contents.terrain.size() * sizeof(MeshFileTerrain) });
+	}
+
+	MeshFileHeader header = {};
+	header.magic = MESH_FILE_MAGIC;
+	header.version = MESH_FILE_VERSION;
+	header.headerSize = sizeof(MeshFileHeader);
+	header.sectionCount = (uint32_t)pending.size();
+	header.source = source;
+	header.vertexCount = contents.vertexCount;
+	header.vertexStride = contents.vertexStride;
+	header.indexCount = contents.indexCount;
+	memcpy(header.boundsCenter, contents.boundsCenter, sizeof(header.boundsCenter));
+	memcpy(header.boundsExtents, contents.boundsExtents, sizeof(header.boundsExtents));
+	memcpy(header.boundsOrientation, contents.boundsOrientation, sizeof(header.boundsOrientation));
+
+	std::vector<MeshFileSection> sections(pending.size());
+	uint64_t offset = sizeof(MeshFileHeader) + pending.size() * sizeof(MeshFileSection);
+	for (size_t i = 0; i < pending.size(); i++) {
+		offset = (offset + MESH_FILE_SECTION_ALIGNMENT - 1) & ~(uint64_t)(MESH_FILE_SECTION_ALIGNMENT - 1);
+
+		sections[i].type = pending[i].type;
+		sections[i].elementStride = pending[i].elementStride;
+		sections[i].offset = offset;
+		sections[i].size = pending[i].size;
+
+		offset += pending[i].size;
+	}
+
+	// Built in memory so the file lands in a single write
+	std::vector<unsigned char> output((size_t)offset, 0);
+	memcpy(output.data(), &header, sizeof(MeshFileHeader));
+	memcpy(output.data() + sizeof(MeshFileHeader), sections.data(), sections.size() * sizeof(MeshFileSection));
+
+	for (size_t i = 0; i < pending.size(); i++) {
+		if (pending[i].size > 0) memcpy(output.data() + sections[i].offset, pending[i].data, (size_t)pending[i].size);
+	}
+
+	return MappedFile::WriteWholeFile(path, output.data(), output.size());
+}
+
+void MeshFile::BuildMeshlets(const uint32_t* indices,
+							 uint32_t indexCount,
+							 std::vector<MeshFileMeshlet>* meshlets,
+							 std::vector<uint32_t>* meshletVertices,
+							 std::vector<uint8_t>* meshletTriangles)
+{
+	meshlets->clear();
+	meshletVertices->clear();
+	meshletTriangles->clear();
+
+	MeshFileMeshlet current = {};
+
+	// Vertices already in the current meshlet and their local index.
+	// Meshlets are tiny, so a linear search beats a map here.
+	uint32_t localVertices[MESHLET_MAX_VERTICES];
+
+	for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+		// Count how many corners aren't in the meshlet yet
+		int newVertices = 0;
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t index = indices[i + corner];
+			bool found = false;
+
+			for (uint32_t v = 0; v < current.vertexCount && !found; v++) {
+				found = localVertices[v] == index;
+			}
+
+			// Repeated corners in a degenerate triangle only count once
+			for (int previous = 0; previous < corner && !found; previous++) {
+				found = indices[i + previous] == index;
+			}
+
+			if (!found) newVertices++;
+		}
+
+		if (current.vertexCount + newVertices > MESHLET_MAX_VERTICES || current.triangleCount + 1 > MESHLET_MAX_TRIANGLES) {
+			meshlets->push_back(current);
+
+			current.vertexOffset = (uint32_t)meshletVertices->size();
+			current.triangleOffset = (uint32_t)meshletTriangles->size();
+			current.vertexCount = 0;
+			current.triangleCount = 0;
+		}
+
+		uint8_t local[3];
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t index = indices[i + corner];
+
+			uint32_t v = 0;
+			while (v < current.vertexCount && localVertices[v] != index) v++;
+
+			if (v == current.vertexCount) {
+				localVertices[current.vertexCount++] = index;
+				meshletVertices->push_back(index);
+			}
+
+			local[corner] = (uint8_t)v;
+		}
+
+		meshletTriangles->push_back(local[0]);
+		meshletTriangles->push_back(local[1]);
+		meshletTriangles->push_back(local[2]);
+		current.triangleCount++;
+	}
+
+	if (current.triangleCount > 0) meshlets->push_back(current);
+}
+
+#pragma endregion
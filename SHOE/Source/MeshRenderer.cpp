@@ -15,6 +15,22 @@ void MeshRenderer::SetDefaults(std::shared_ptr<Mesh> mesh, std::shared_ptr<Mater
 	defaultMat = mat;
 }
 
+/// <summary>
+/// Get the mesh a newly allocated MeshRenderer starts with
+/// </summary>
+std::shared_ptr<Mesh> MeshRenderer::GetDefaultMesh()
+{
+	return defaultMesh;
+}
+
+/// <summary>
+/// Get the material a newly allocated MeshRenderer starts with
+/// </summary>
+std::shared_ptr<Material> MeshRenderer::GetDefaultMaterial()
+{
+	return defaultMat;
+}
+
 /// <summary>
 /// Sets the members to the defaults for a newly allocated MeshRenderer
 /// </summary>
@@ -0,0 +1,559 @@
+#include "../Headers/ObjParser.h"
+#include "../Headers/VirtualFileSystem.h"
+#include "../Headers/JobSystem.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#define OBJ_MISSING_INDEX UINT32_MAX
+
+enum ObjLineType {
+	OBJ_LINE_OTHER,
+	OBJ_LINE_POSITION,
+	OBJ_LINE_UV,
+	OBJ_LINE_NORMAL,
+	OBJ_LINE_FACE
+};
+
+// One face corner, as absolute 0-based indices into the file's attributes
+struct ObjCorner {
+	uint32_t position;
+	uint32_t uv;
+	uint32_t normal;
+
+	bool operator==(const ObjCorner& other) const {
+		return position == other.position && uv == other.uv && normal == other.normal;
+	}
+};
+
+// Open addressing table from corner to vertex index. Much lighter than an
+// unordered_map for the millions of lookups a large model needs.
+class ObjWeldTable
+{
+public:
+	ObjWeldTable() {
+		Resize(1024);
+	}
+
+	/// <summary>
+	/// Finds a corner's index, adding it with newIndex if it isn't there yet
+	/// </summary>
+	uint32_t FindOrAdd(const ObjCorner& corner, uint32_t newIndex, bool* added) {
+		if ((count + 1) * 2 > corners.size()) Resize(corners.size() * 2);
+
+		size_t slot = Hash(corner) & mask;
+		while (true) {
+			ObjCorner& existing = corners[slot];
+			if (existing.position == OBJ_MISSING_INDEX) {
+				existing = corner;
+				indices[slot] = newIndex;
+				count++;
+				*added = true;
+				return newIndex;
+			}
+
+			if (existing == corner) {
+				*added = false;
+				return indices[slot];
+			}
+
+			slot = (slot + 1) & mask;
+		}
+	}
+
+private:
+	std::vector<ObjCorner> corners;
+	std::vector<uint32_t> indices;
+	size_t mask = 0;
+	size_t count = 0;
+
+	static size_t Hash(const ObjCorner& corner) {
+		uint64_t hash = corner.position * 0x9E3779B97F4A7C15ull;
+		hash ^= (corner.uv + 0x632BE59BD9B4E019ull + (hash << 6) + (hash >> 2));
+		hash ^= (corner.normal * 0xC2B2AE3D27D4EB4Full + (hash << 6) + (hash >> 2));
+		return (size_t)(hash ^ (hash >> 32));
+	}
+
+	void Resize(size_t size) {
+		std::vector<ObjCorner> oldCorners;
+		std::vector<uint32_t> oldIndices;
+		oldCorners.swap(corners);
+		oldIndices.swap(indices);
+
+		// Unused slots are marked by a missing position, which real corners never have
+		ObjCorner empty = { OBJ_MISSING_INDEX, OBJ_MISSING_INDEX, OBJ_MISSING_INDEX };
+		corners.assign(size, empty);
+		indices.assign(size, 0);
+		mask = size - 1;
+		count = 0;
+
+		bool added;
+		for (size_t i = 0; i < oldCorners.size(); i++) {
+			if (oldCorners[i].position != OBJ_MISSING_INDEX) FindOrAdd(oldCorners[i], oldIndices[i], &added);
+		}
+	}
+};
+
+// A run of whole lines, and everything parsed from it
+struct ObjChunk {
+	const char* start;
+	const char* end;
+
+	// Attribute counts in this chunk, and how many came before it
+	uint32_t positionCount = 0;
+	uint32_t uvCount = 0;
+	uint32_t normalCount = 0;
+	uint32_t positionBase = 0;
+	uint32_t uvBase = 0;
+	uint32_t normalBase = 0;
+
+	// Corners welded within the chunk, and triangles indexing into them.
+	// remap takes a chunk corner to its vertex in the final, file-wide list.
+	std::vector<ObjCorner> corners;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> remap;
+	size_t indexBase = 0;
+
+	// The first malformed line in the chunk, if there is one
+	const char* errorLine = nullptr;
+	const char* errorReason = nullptr;
+};
+
+static const double powersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const char* SkipSpaces(const char* text, const char* end) {
+	while (text < end && (*text == ' ' || *text == '\t')) text++;
+	return text;
+}
+
+static const char* NextLine(const char* text, const char* end) {
+	const char* newline = (const char*)memchr(text, '\n', end - text);
+	return newline ? newline + 1 : end;
+}
+
+static bool IsLineEnd(const char* text, const char* end) {
+	return text >= end || *text == '\r' || *text == '\n' || *text == '#';
+}
+
+static ObjLineType GetLineType(const char* text, const char* end) {
+	auto isSpace = [end](const char* c) { return c >= end || *c == ' ' || *c == '\t'; };
+
+	if (text >= end) return OBJ_LINE_OTHER;
+
+	if (text[0] == 'f' && isSpace(text + 1)) return OBJ_LINE_FACE;
+	if (text[0] != 'v') return OBJ_LINE_OTHER;
+
+	if (isSpace(text + 1)) return OBJ_LINE_POSITION;
+	if (text + 1 < end && text[1] == 't' && isSpace(text + 2)) return OBJ_LINE_UV;
+	if (text + 1 < end && text[1] == 'n' && isSpace(text + 2)) return OBJ_LINE_NORMAL;
+
+	return OBJ_LINE_OTHER;
+}
+
+// Reads up to count whitespace separated floats, missing ones are left alone
+static void ReadFloats(const char* text, const char* end, float* values, int count) {
+	for (int i = 0; i < count; i++) {
+		text = SkipSpaces(text, end);
+
+		const char* next = ObjParser::ParseFloat(text, end, &values[i]);
+		if (next == text) return;
+
+		text = next;
+	}
+}
+
+// Turns a 1-based (or negative, relative) OBJ index into a 0-based one.
+// definedCount is how many of that attribute appear before this line.
+// 0 and indices outside the file are missing.
+static uint32_t ResolveIndex(int64_t index, uint32_t definedCount, uint32_t totalCount) {
+	int64_t resolved;
+	if (index > 0) resolved = index - 1;
+	else if (index < 0) resolved = (int64_t)definedCount + index;
+	else return OBJ_MISSING_INDEX;
+
+	if (resolved < 0 || resolved >= totalCount) return OBJ_MISSING_INDEX;
+	return (uint32_t)resolved;
+}
+
+// Reads one "p", "p/t", "p//n" or "p/t/n" face corner. Returns null with a
+// reason if it's malformed or uses an attribute that doesn't exist.
+static const char* ReadCorner(const char* c, const char* end,
+	uint32_t positionIndex, uint32_t uvIndex, uint32_t normalIndex,
+	uint32_t positionTotal, uint32_t uvTotal, uint32_t normalTotal,
+	ObjCorner* corner, const char** reason) {
+	int64_t p = 0, t = 0, n = 0;
+	bool hasUV = false, hasNormal = false;
+
+	const char* next = ObjParser::ParseInt(c, end, &p);
+	if (next == c) {
+		*reason = "face corner isn't a number";
+		return nullptr;
+	}
+	c = next;
+
+	if (c < end && *c == '/') {
+		c++;
+		next = ObjParser::ParseInt(c, end, &t);
+		hasUV = next != c;
+		c = next;
+
+		// The uv can only be left out when a normal follows, as in "p//n"
+		if (c < end && *c == '/') {
+			c++;
+			next = ObjParser::ParseInt(c, end, &n);
+			if (next == c) {
+				*reason = "face corner has an empty normal index";
+				return nullptr;
+			}
+			hasNormal = true;
+			c = next;
+		}
+		else if (!hasUV) {
+			*reason = "face corner has an empty uv index";
+			return nullptr;
+		}
+	}
+
+	if (!IsLineEnd(c, end) && *c != ' ' && *c != '\t') {
+		*reason = "face corner isn't a number";
+		return nullptr;
+	}
+
+	corner->position = ResolveIndex(p, positionIndex, positionTotal);
+	corner->uv = hasUV ? ResolveIndex(t, uvIndex, uvTotal) : OBJ_MISSING_INDEX;
+	corner->normal = hasNormal ? ResolveIndex(n, normalIndex, normalTotal) : OBJ_MISSING_INDEX;
+
+	if (corner->position == OBJ_MISSING_INDEX) *reason = "face uses a position that doesn't exist";
+	else if (hasUV && corner->uv == OBJ_MISSING_INDEX) *reason = "face uses a uv that doesn't exist";
+	else if (hasNormal && corner->normal == OBJ_MISSING_INDEX) *reason = "face uses a normal that doesn't exist";
+	else return c;
+
+	return nullptr;
+}
+
+#pragma region tokenizing
+
+const char* ObjParser::ParseFloat(const char* text, const char* end, float* value) {
+	const char* c = text;
+
+	bool negative = false;
+	if (c < end && (*c == '-' || *c == '+')) {
+		negative = *c == '-';
+		c++;
+	}
+
+	// Up to 19 significant digits fit in the mantissa, the rest only move the exponent
+	uint64_t mantissa = 0;
+	int digitCount = 0;
+	int exponent = 0;
+	bool anyDigits = false;
+
+	for (; c < end && *c >= '0' && *c <= '9'; c++) {
+		anyDigits = true;
+		if (digitCount < 19) {
+			mantissa = mantissa * 10 + (*c - '0');
+			if (mantissa != 0) digitCount++;
+		}
+		else {
+			exponent++;
+		}
+	}
+
+	if (c < end && *c == '.') {
+		c++;
+		for (; c < end && *c >= '0' && *c <= '9'; c++) {
+			anyDigits = true;
+			if (digitCount < 19) {
+				mantissa = mantissa * 10 + (*c - '0');
+				if (mantissa != 0) digitCount++;
+				exponent--;
+			}
+		}
+	}
+
+	if (!anyDigits) return text;
+
+	if (c < end && (*c == 'e' || *c == 'E')) {
+		const char* exponentStart = c + 1;
+		int64_t exponentValue;
+		const char* exponentEnd = ParseInt(exponentStart, end, &exponentValue);
+
+		// A bare 'e' isn't part of the number
+		if (exponentEnd != exponentStart) {
+			exponent += (int)(std::max)((int64_t)-400, (std::min)((int64_t)400, exponentValue));
+			c = exponentEnd;
+		}
+	}
+
+	// Exact for the short decimals OBJ exporters write,
+	// since both the mantissa and the power are exact doubles
+	double result = (double)mantissa;
+	if (mantissa != 0) {
+		if (exponent >= 0 && exponent <= 22) result *= powersOfTen[exponent];
+		else if (exponent < 0 && exponent >= -22) result /= powersOfTen[-exponent];
+		else result *= pow(10.0, exponent);
+	}
+
+	*value = (float)(negative ? -result : result);
+	return c;
+}
+
+const char* ObjParser::ParseInt(const char* text, const char* end, int64_t* value) {
+	const char* c = text;
+
+	bool negative = false;
+	if (c < end && (*c == '-' || *c == '+')) {
+		negative = *c == '-';
+		c++;
+	}
+
+	const char* digitStart = c;
+	int64_t result = 0;
+	for (; c < end && *c >= '0' && *c <= '9'; c++) {
+		// Anything this large is out of range anyway, so just stop growing
+		if (result < INT64_MAX / 10) result = result * 10 + (*c - '0');
+	}
+
+	if (c == digitStart) return text;
+
+	*value = negative ? -result : result;
+	return c;
+}
+
+#pragma endregion
+
+#pragma region parsing
+
+bool ObjParser::Parse(const std::string& filename, std::vector<MeshFileVertex>* vertices, std::vector<uint32_t>* indices, std::string* error) {
+	VirtualFile file;
+	if (!file.Open(filename)) {
+		vertices->clear();
+		indices->clear();
+
+		// Opening rejects empty files, which are still valid (if useless) models
+		VirtualFileInfo info;
+		if (VirtualFileSystem::GetInstance().GetFileInfo(filename, &info) && info.size == 0) return true;
+
+		if (error != nullptr) *error = "couldn't open the file";
+		return false;
+	}
+
+	return ParseText((const char*)file.GetData(), file.GetSize(), vertices, indices, error);
+}
+
+bool ObjParser::ParseText(const char* text, size_t size, std::vector<MeshFileVertex>* vertices, std::vector<uint32_t>* indices, std::string* error) {
+	vertices->clear();
+	indices->clear();
+
+	const char* fileEnd = text + size;
+	JobSystem& jobSystem = JobSystem::GetInstance();
+
+	// Cut the file into chunks that each start at the beginning of a line
+	size_t chunkCount = (std::max)((size_t)1, size / OBJ_PARSE_CHUNK_SIZE);
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* chunkStart = text;
+	for (size_t i = 0; i < chunkCount; i++) {
+		const char* chunkEnd = i + 1 == chunkCount ? fileEnd : text + size * (i + 1) / chunkCount;
+		if (chunkEnd < chunkStart) chunkEnd = chunkStart;
+		if (chunkEnd < fileEnd && chunkEnd > text && chunkEnd[-1] != '\n') chunkEnd = NextLine(chunkEnd, fileEnd);
+
+		chunks[i].start = chunkStart;
+		chunks[i].end = chunkEnd;
+		chunkStart = chunkEnd;
+	}
+
+	// First pass counts attributes, so negative indices and attribute
+	// storage can be resolved before any chunk is actually parsed
+	jobSystem.ParallelFor(chunkCount, 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			ObjChunk& chunk = chunks[i];
+			for (const char* line = chunk.start; line < chunk.end; line = NextLine(line, chunk.end)) {
+				switch (GetLineType(SkipSpaces(line, chunk.end), chunk.end)) {
+				case OBJ_LINE_POSITION: chunk.positionCount++; break;
+				case OBJ_LINE_UV: chunk.uvCount++; break;
+				case OBJ_LINE_NORMAL: chunk.normalCount++; break;
+				default: break;
+				}
+			}
+		}
+	});
+
+	uint32_t positionTotal = 0;
+	uint32_t uvTotal = 0;
+	uint32_t normalTotal = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.positionBase = positionTotal;
+		chunk.uvBase = uvTotal;
+		chunk.normalBase = normalTotal;
+		positionTotal += chunk.positionCount;
+		uvTotal += chunk.uvCount;
+		normalTotal += chunk.normalCount;
+	}
+
+	std::vector<float> positions((size_t)positionTotal * 3, 0.0f);
+	std::vector<float> uvs((size_t)uvTotal * 2, 0.0f);
+	std::vector<float> normals((size_t)normalTotal * 3, 0.0f);
+
+	// Second pass reads attributes straight into place and welds each chunk's corners.
+	// A malformed line stops its own chunk, but the others carry on, so the
+	// line reported is the first bad one in the file however the work is split.
+	jobSystem.ParallelFor(chunkCount, 1, [&](size_t start, size_t end) {
+		std::vector<ObjCorner> faceCorners;
+
+		for (size_t i = start; i < end; i++) {
+			ObjChunk& chunk = chunks[i];
+			uint32_t positionIndex = chunk.positionBase;
+			uint32_t uvIndex = chunk.uvBase;
+			uint32_t normalIndex = chunk.normalBase;
+			ObjWeldTable weldedCorners;
+
+			for (const char* line = chunk.start; line < chunk.end && chunk.errorLine == nullptr; line = NextLine(line, chunk.end)) {
+				const char* c = SkipSpaces(line, chunk.end);
+
+				switch (GetLineType(c, chunk.end)) {
+				case OBJ_LINE_POSITION:
+					ReadFloats(c + 1, chunk.end, &positions[(size_t)positionIndex++ * 3], 3);
+					break;
+				case OBJ_LINE_UV:
+					ReadFloats(c + 2, chunk.end, &uvs[(size_t)uvIndex++ * 2], 2);
+					break;
+				case OBJ_LINE_NORMAL:
+					ReadFloats(c + 2, chunk.end, &normals[(size_t)normalIndex++ * 3], 3);
+					break;
+				case OBJ_LINE_FACE:
+				{
+					faceCorners.clear();
+					c++;
+					while (true) {
+						c = SkipSpaces(c, chunk.end);
+						if (IsLineEnd(c, chunk.end)) break;
+
+						// Uvs and normals left out are zeroed, but one that's given has to exist
+						ObjCorner corner;
+						c = ReadCorner(c, chunk.end, positionIndex, uvIndex, normalIndex,
+							positionTotal, uvTotal, normalTotal, &corner, &chunk.errorReason);
+						if (c == nullptr) break;
+
+						faceCorners.push_back(corner);
+					}
+
+					if (c != nullptr && faceCorners.size() < 3) chunk.errorReason = "face has fewer than three corners";
+					if (chunk.errorReason != nullptr) {
+						chunk.errorLine = line;
+						break;
+					}
+
+					uint32_t cornerIndices[3];
+					for (size_t f = 0; f < faceCorners.size(); f++) {
+						bool added;
+						uint32_t cornerIndex = weldedCorners.FindOrAdd(faceCorners[f], (uint32_t)chunk.corners.size(), &added);
+						if (added) chunk.corners.push_back(faceCorners[f]);
+
+						// Fan out from the first corner, flipping the winding order
+						if (f == 0) cornerIndices[0] = cornerIndex;
+						else if (f == 1) cornerIndices[1] = cornerIndex;
+						else {
+							cornerIndices[2] = cornerIndex;
+							chunk.indices.push_back(cornerIndices[0]);
+							chunk.indices.push_back(cornerIndices[2]);
+							chunk.indices.push_back(cornerIndices[1]);
+							cornerIndices[1] = cornerIndices[2];
+						}
+					}
+					break;
+				}
+				default:
+					break;
+				}
+			}
+		}
+	});
+
+	for (const ObjChunk& chunk : chunks) {
+		if (chunk.errorLine == nullptr) continue;
+
+		if (error != nullptr) {
+			size_t lineNumber = 1 + std::count(text, chunk.errorLine, '\n');
+			*error = "line " + std::to_string(lineNumber) + ": " + chunk.errorReason;
+		}
+		return false;
+	}
+
+	// Weld across chunks. Chunks are merged in file order, so vertices
+	// come out in the order they're first used and the result is the
+	// same however many workers there are.
+	ObjWeldTable weldedCorners;
+	std::vector<ObjCorner> corners;
+	size_t indexTotal = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.remap.resize(chunk.corners.size());
+		for (size_t i = 0; i < chunk.corners.size(); i++) {
+			bool added;
+			chunk.remap[i] = weldedCorners.FindOrAdd(chunk.corners[i], (uint32_t)corners.size(), &added);
+			if (added) corners.push_back(chunk.corners[i]);
+		}
+
+		chunk.indexBase = indexTotal;
+		indexTotal += chunk.indices.size();
+		std::vector<ObjCorner>().swap(chunk.corners);
+	}
+
+	vertices->resize(corners.size());
+	indices->resize(indexTotal);
+
+	jobSystem.ParallelFor(corners.size(), 1 << 16, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			const ObjCorner& corner = corners[i];
+			MeshFileVertex& vertex = (*vertices)[i];
+			memset(&vertex, 0, sizeof(MeshFileVertex));
+
+			// The model is most likely in a right-handed space,
+			// especially if it came from Maya.  We want to convert
+			// to a left-handed space for DirectX.  This means we
+			// need to:
+			//  - Invert the Z position
+			//  - Invert the normal's Z
+			//  - Flip the winding order (done while triangulating)
+			// We also need to flip the uv coordinate since DirectX
+			// defines (0,0) as the top left of the texture, and many
+			// 3D modeling packages use the bottom left as (0,0)
+			const float* position = &positions[(size_t)corner.position * 3];
+			vertex.position[0] = position[0];
+			vertex.position[1] = position[1];
+			vertex.position[2] = -position[2];
+
+			if (corner.normal != OBJ_MISSING_INDEX) {
+				const float* normal = &normals[(size_t)corner.normal * 3];
+				vertex.normal[0] = normal[0];
+				vertex.normal[1] = normal[1];
+				vertex.normal[2] = -normal[2];
+			}
+
+			if (corner.uv != OBJ_MISSING_INDEX) {
+				const float* uv = &uvs[(size_t)corner.uv * 2];
+				vertex.uv[0] = uv[0];
+				vertex.uv[1] = 1.0f - uv[1];
+			}
+			else {
+				vertex.uv[1] = 1.0f;
+			}
+		}
+	});
+
+	jobSystem.ParallelFor(chunkCount, 1, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			ObjChunk& chunk = chunks[i];
+			uint32_t* output = indices->data() + chunk.indexBase;
+			for (size_t index = 0; index < chunk.indices.size(); index++) {
+				output[index] = chunk.remap[chunk.indices[index]];
+			}
+		}
+	});
+
+	return true;
+}
+
+#pragma endregion
@@ -263,6 +263,13 @@ void ParticleSystem::OnDestroy()
 
 void ParticleSystem::Draw(std::shared_ptr<Camera> cam, Microsoft::WRL::ComPtr<ID3D11BlendState> particleBlendAdditive)
 {
+	if (textureMaterializer) {
+		// Cleared first, so a load that finishes inside the call can't start another
+		std::function<void()> materialize = std::move(textureMaterializer);
+		textureMaterializer = nullptr;
+		materialize();
+	}
+
 	ID3D11UnorderedAccessView* none[8] = {};
 	context->CSSetUnorderedAccessViews(0, 8, none, 0);
 
@@ -314,6 +321,16 @@ void ParticleSystem::SetParticleTextureSRV(Microsoft::WRL::ComPtr<ID3D11ShaderRe
 	this->particleTextureSRV = particleTextureSRV;
 }
 
+void ParticleSystem::SetTextureMaterializer(std::function<void()> materializer)
+{
+	this->textureMaterializer = materializer;
+}
+
+bool ParticleSystem::IsTextureLoadDeferred()
+{
+	return (bool)this->textureMaterializer;
+}
+
 void ParticleSystem::Initialize(int maxParticles) 
 {
 	// Deadlist for ParticleEmit and ParticleFlow
@@ -1013,8 +1013,8 @@ void Renderer::Draw(std::shared_ptr<Camera> cam, EngineState engineState) {
 		PSTerrain->SetData("lights", Light::GetLightArray(), sizeof(Light) * MAX_LIGHTS);
 		PSTerrain->SetData("lightCount", &lightCount, sizeof(unsigned int));
 		PSTerrain->SetFloat3("cameraPos", cam->GetTransform()->GetLocalPosition());
-		PSTerrain->SetFloat("uvMultNear", 50.0f);
-		PSTerrain->SetFloat("uvMultFar", 150.0f);
+		PSTerrain->SetFloat("uvMultNear", TERRAIN_UV_MULT_NEAR);
+		PSTerrain->SetFloat("uvMultFar", TERRAIN_UV_MULT_FAR);
 		if (shadowCount > 0) {
 			PSTerrain->SetShaderResourceView("shadowMaps", shadowDSVArraySRV.Get());
 			PSTerrain->SetSamplerState("shadowState", shadowSampler.Get());
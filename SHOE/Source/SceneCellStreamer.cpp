@@ -0,0 +1,154 @@
+#include "../Headers/SceneCellStreamer.h"
+#include <algorithm>
+#include <cmath>
+
+SceneCellStreamer::SceneCellStreamer() {
+	loadDistance = SCENE_STREAMING_DEFAULT_LOAD_DISTANCE;
+	unloadDistance = SCENE_STREAMING_DEFAULT_UNLOAD_DISTANCE;
+
+	loadCount = 0;
+	unloadCount = 0;
+	failedCount = 0;
+}
+
+#pragma region tracking
+uint32_t SceneCellStreamer::AddCell(float minX, float minZ, float maxX, float maxZ) {
+	SceneCellStatus cell;
+	cell.minX = (std::min)(minX, maxX);
+	cell.minZ = (std::min)(minZ, maxZ);
+	cell.maxX = (std::max)(minX, maxX);
+	cell.maxZ = (std::max)(minZ, maxZ);
+	cells.push_back(cell);
+
+	return (uint32_t)cells.size() - 1;
+}
+
+void SceneCellStreamer::Clear() {
+	cells.clear();
+}
+
+size_t SceneCellStreamer::GetCellCount() {
+	return cells.size();
+}
+
+void SceneCellStreamer::SetDistances(float loadingDistance, float unloadingDistance) {
+	loadDistance = (std::max)(loadingDistance, 0.0f);
+	unloadDistance = (std::max)(unloadingDistance, loadDistance);
+}
+#pragma endregion
+
+#pragma region updating
+void SceneCellStreamer::Update(float cameraX, float cameraZ, std::vector<SceneCellChange>* changes) {
+	changes->clear();
+
+	size_t loadingCount = 0;
+	std::vector<uint32_t> wanted;
+	for (uint32_t id = 0; id < cells.size(); id++) {
+		SceneCellStatus& cell = cells[id];
+		cell.distance = GetDistance(cameraX, cameraZ, cell.minX, cell.minZ, cell.maxX, cell.maxZ);
+
+		if (cell.state == SCENE_CELL_LOADING) {
+			loadingCount++;
+		}
+		else if (cell.state == SCENE_CELL_LOADED && cell.distance > unloadDistance) {
+			SceneCellChange change;
+			change.id = id;
+			change.unload = true;
+			changes->push_back(change);
+
+			cell.state = SCENE_CELL_UNLOADING;
+		}
+		else if (cell.state == SCENE_CELL_UNLOADED && !cell.failed && cell.distance <= loadDistance) {
+			wanted.push_back(id);
+		}
+	}
+
+	// Nearest first. The id settles ties so updates are repeatable.
+	std::sort(wanted.begin(), wanted.end(), [this](uint32_t a, uint32_t b) {
+		if (cells[a].distance != cells[b].distance) return cells[a].distance < cells[b].distance;
+		return a < b;
+	});
+
+	for (uint32_t id : wanted) {
+		if (loadingCount >= SCENE_STREAMING_LOAD_LIMIT) break;
+
+		SceneCellChange change;
+		change.id = id;
+		change.unload = false;
+		changes->push_back(change);
+
+		cells[id].state = SCENE_CELL_LOADING;
+		loadingCount++;
+	}
+}
+
+void SceneCellStreamer::CompleteChange(uint32_t id, bool failed) {
+	if (id >= cells.size()) return;
+
+	SceneCellStatus& cell = cells[id];
+	if (cell.state == SCENE_CELL_LOADING) {
+		cell.state = failed ? SCENE_CELL_UNLOADED : SCENE_CELL_LOADED;
+		cell.failed = failed;
+
+		if (failed) failedCount++;
+		else loadCount++;
+	}
+	else if (cell.state == SCENE_CELL_UNLOADING) {
+		// Whatever's left of a cell that failed to unload can't be told apart from a loaded one
+		cell.state = failed ? SCENE_CELL_LOADED : SCENE_CELL_UNLOADED;
+
+		if (failed) failedCount++;
+		else unloadCount++;
+	}
+}
+
+void SceneCellStreamer::UnloadAll() {
+	for (SceneCellStatus& cell : cells) {
+		cell.state = SCENE_CELL_UNLOADED;
+	}
+}
+#pragma endregion
+
+#pragma region stats
+bool SceneCellStreamer::GetStatus(uint32_t id, SceneCellStatus* status) {
+	if (id >= cells.size()) return false;
+
+	*status = cells[id];
+	return true;
+}
+
+SceneCellStreamingStats SceneCellStreamer::GetStats() {
+	SceneCellStreamingStats stats;
+	stats.cellCount = cells.size();
+	stats.loadCount = loadCount;
+	stats.unloadCount = unloadCount;
+	stats.failedCount = failedCount;
+
+	for (const SceneCellStatus& cell : cells) {
+		if (cell.state == SCENE_CELL_LOADED) stats.loadedCount++;
+		else if (cell.state == SCENE_CELL_LOADING) stats.loadingCount++;
+		else if (cell.state == SCENE_CELL_UNLOADING) stats.unloadingCount++;
+	}
+
+	return stats;
+}
+
+void SceneCellStreamer::Simulate(const std::vector<SceneCellPoint>& path, std::vector<std::vector<SceneCellChange>>* log) {
+	SceneCellStreamer simulated = *this;
+
+	log->assign(path.size(), std::vector<SceneCellChange>());
+	for (size_t i = 0; i < path.size(); i++) {
+		simulated.Update(path[i].x, path[i].z, &(*log)[i]);
+
+		for (const SceneCellChange& change : (*log)[i]) {
+			simulated.CompleteChange(change.id);
+		}
+	}
+}
+
+float SceneCellStreamer::GetDistance(float x, float z, float minX, float minZ, float maxX, float maxZ) {
+	float dx = (std::max)((std::max)(minX - x, x - maxX), 0.0f);
+	float dz = (std::max)((std::max)(minZ - z, z - maxZ), 0.0f);
+	return std::sqrt(dx * dx + dz * dz);
+}
+#pragma endregion
@@ -0,0 +1,536 @@
+#include "../Headers/SceneFile.h"
+#include "../Headers/MappedFile.h"
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#pragma region contents
+
+uint32_t SceneFileContents::AddString(const std::string& text) {
+	auto it = stringIndices.find(text);
+	if (it != stringIndices.end()) return it->second;
+
+	uint32_t index = (uint32_t)strings.size();
+	strings.push_back(text);
+	stringIndices.emplace(text, index);
+	return index;
+}
+
+const std::string& SceneFileContents::GetString(uint32_t index) const {
+	static const std::string empty;
+	if (index >= strings.size()) return empty;
+	return strings[index];
+}
+
+void SceneFileContents::ClearEntities() {
+	entities.clear();
+	components.clear();
+	colliders.clear();
+	terrains.clear();
+	particleSystems.clear();
+	lights.clear();
+	meshRenderers.clear();
+	cameras.clear();
+	noclipMovements.clear();
+	flashlightControllers.clear();
+}
+
+void SceneFileContents::Clear() {
+	*this = SceneFileContents();
+}
+
+uint32_t SceneFileContents::CopyEntity(const SceneFileContents& source, uint32_t entityIndex) {
+	const SceneFileEntity& sourceEntity = source.entities[entityIndex];
+
+	SceneFileEntity entity = sourceEntity;
+	entity.name = AddString(source.GetString(sourceEntity.name));
+	entity.firstComponent = (uint32_t)components.size();
+	entity.componentCount = 0;
+	entities.push_back(entity);
+
+	for (uint32_t c = sourceEntity.firstComponent; c < sourceEntity.firstComponent + sourceEntity.componentCount; c++) {
+		const SceneFileComponent& component = source.components[c];
+		switch (component.schema) {
+		case SCENE_SCHEMA_COLLIDER: AddComponent(SCENE_SCHEMA_COLLIDER, colliders) = source.colliders[component.index]; break;
+		case SCENE_SCHEMA_TERRAIN: {
+			SceneFileTerrain& terrain = AddComponent(SCENE_SCHEMA_TERRAIN, terrains);
+			terrain = source.terrains[component.index];
+			terrain.fileNameKey = AddString(source.GetString(terrain.fileNameKey));
+			break;
+		}
+		case SCENE_SCHEMA_PARTICLE_SYSTEM: {
+			SceneFileParticleSystem& particleSystem = AddComponent(SCENE_SCHEMA_PARTICLE_SYSTEM, particleSystems);
+			particleSystem = source.particleSystems[component.index];
+			particleSystem.fileNameKey = AddString(source.GetString(particleSystem.fileNameKey));
+			break;
+		}
+		case SCENE_SCHEMA_LIGHT: AddComponent(SCENE_SCHEMA_LIGHT, lights) = source.lights[component.index]; break;
+		case SCENE_SCHEMA_MESH_RENDERER: AddComponent(SCENE_SCHEMA_MESH_RENDERER, meshRenderers) = source.meshRenderers[component.index]; break;
+		case SCENE_SCHEMA_CAMERA: AddComponent(SCENE_SCHEMA_CAMERA, cameras) = source.cameras[component.index]; break;
+		case SCENE_SCHEMA_NOCLIP_MOVEMENT: AddComponent(SCENE_SCHEMA_NOCLIP_MOVEMENT, noclipMovements) = source.noclipMovements[component.index]; break;
+		case SCENE_SCHEMA_FLASHLIGHT_CONTROLLER: AddComponent(SCENE_SCHEMA_FLASHLIGHT_CONTROLLER, flashlightControllers) = source.flashlightControllers[component.index]; break;
+		default: break;
+		}
+	}
+
+	return (uint32_t)entities.size() - 1;
+}
+
+size_t SceneFileContents::GetMemoryUsage() const {
+	size_t size = 0;
+	auto addSection = [&](const auto& section) {
+		size += section.capacity() * sizeof(section[0]);
+	};
+
+	addSection(strings);
+	addSection(indices);
+	addSection(fonts);
+	addSection(samplers);
+	addSection(pixelShaders);
+	addSection(vertexShaders);
+	addSection(computeShaders);
+	addSection(textures);
+	addSection(materials);
+	addSection(meshes);
+	addSection(terrainMaterials);
+	addSection(skies);
+	addSection(sounds);
+	addSection(entities);
+	addSection(components);
+	addSection(colliders);
+	addSection(terrains);
+	addSection(particleSystems);
+	addSection(lights);
+	addSection(meshRenderers);
+	addSection(cameras);
+	addSection(noclipMovements);
+	addSection(flashlightControllers);
+	addSection(cells);
+
+	// Both the table and the lookup hold a copy of each string, plus a node and bucket for the lookup
+	for (const std::string& text : strings) {
+		size += 2 * (text.capacity() + 1);
+	}
+	size += stringIndices.size() * (sizeof(std::pair<const std::string, uint32_t>) + sizeof(void*));
+	size += stringIndices.bucket_count() * sizeof(void*);
+
+	return size;
+}
+
+#pragma endregion
+
+#pragma region reading
+
+namespace {
+	/// <summary>
+	/// Copies a section's records out of the file. Records written with a
+	/// different layout keep the defaults for any fields the file doesn't have.
+	/// </summary>
+	template <typename T>
+	void ReadRecords(const unsigned char* data, const SceneFileSection& section, std::vector<T>* records) {
+		size_t count = (size_t)(section.size / section.recordSize);
+		const unsigned char* source = data + section.offset;
+
+		if (section.recordSize == sizeof(T)) {
+			records->resize(count);
+			if (count > 0) memcpy(records->data(), source, count * sizeof(T));
+			return;
+		}
+
+		size_t copySize = (std::min)((size_t)section.recordSize, sizeof(T));
+		records->assign(count, T());
+		for (size_t i = 0; i < count; i++) {
+			memcpy(&(*records)[i], source + i * section.recordSize, copySize);
+		}
+	}
+
+	template <typename T>
+	bool RecordsEqual(const std::vector<T>& sectionA, uint32_t indexA, const std::vector<T>& sectionB, uint32_t indexB) {
+		if (indexA >= sectionA.size() || indexB >= sectionB.size()) return false;
+		return memcmp(&sectionA[indexA], &sectionB[indexB], sizeof(T)) == 0;
+	}
+
+	/// <summary>
+	/// Compares records that name a file, whose string indices only mean
+	/// anything in their own contents' string table
+	/// </summary>
+	template <typename T>
+	bool NamedRecordsEqual(const SceneFileContents& contentsA, const std::vector<T>& sectionA, uint32_t indexA,
+		const SceneFileContents& contentsB, const std::vector<T>& sectionB, uint32_t indexB) {
+		if (indexA >= sectionA.size() || indexB >= sectionB.size()) return false;
+
+		T recordA = sectionA[indexA];
+		T recordB = sectionB[indexB];
+		if (contentsA.GetString(recordA.fileNameKey) != contentsB.GetString(recordB.fileNameKey)) return false;
+
+		recordA.fileNameKey = recordB.fileNameKey = 0;
+		return memcmp(&recordA, &recordB, sizeof(T)) == 0;
+	}
+
+	bool IndexInRange(int32_t index, size_t count) {
+		return index == SCENE_FILE_NO_INDEX || (index >= 0 && (size_t)index < count);
+	}
+
+	bool RangeInside(uint32_t first, uint32_t count, size_t size) {
+		return first <= size && count <= size - first;
+	}
+}
+
+bool SceneFile::Read(const void* data, size_t size, SceneFileContents* contents) {
+	contents->Clear();
+
+	const unsigned char* bytes = (const unsigned char*)data;
+	if (bytes == nullptr || size < sizeof(SceneFileHeader)) return false;
+
+	// The header and section table are copied out rather than read in place, since
+	// the file can start anywhere, like part way into a journal, and isn't always aligned
+	SceneFileHeader header;
+	memcpy(&header, bytes, sizeof(header));
+	if (header.magic != SCENE_FILE_MAGIC ||
+		header.version != SCENE_FILE_VERSION ||
+		header.headerSize < sizeof(SceneFileHeader) ||
+		header.headerSize > size) {
+		return false;
+	}
+
+	uint64_t tableEnd = header.headerSize + (uint64_t)header.sectionCount * sizeof(SceneFileSection);
+	if (tableEnd > size) return false;
+
+	std::vector<SceneFileSection> sections(header.sectionCount);
+	if (!sections.empty()) memcpy(sections.data(), bytes + header.headerSize, sections.size() * sizeof(SceneFileSection));
+	for (uint32_t i = 0; i < header.sectionCount; i++) {
+		if (sections[i].offset < tableEnd ||
+			sections[i].offset > size ||
+			sections[i].offset % SCENE_FILE_SECTION_ALIGNMENT != 0 ||
+			sections[i].size > size - sections[i].offset ||
+			sections[i].recordSize == 0) {
+			return false;
+		}
+	}
+
+	const SceneFileSection* stringData = nullptr;
+	std::vector<SceneFileString> stringRecords;
+	std::vector<SceneFileComponent> storedComponents;
+
+	for (uint32_t i = 0; i < header.sectionCount; i++) {
+		const SceneFileSection& section = sections[i];
+		switch (section.schema) {
+		case SCENE_SCHEMA_STRINGS: ReadRecords(bytes, section, &stringRecords); break;
+		case SCENE_SCHEMA_STRING_DATA: stringData = &section; break;
+		case SCENE_SCHEMA_INDICES: ReadRecords(bytes, section, &contents->indices); break;
+		case SCENE_SCHEMA_FONTS: ReadRecords(bytes, section, &contents->fonts); break;
+		case SCENE_SCHEMA_SAMPLERS: ReadRecords(bytes, section, &contents->samplers); break;
+		case SCENE_SCHEMA_PIXEL_SHADERS: ReadRecords(bytes, section, &contents->pixelShaders); break;
+		case SCENE_SCHEMA_VERTEX_SHADERS: ReadRecords(bytes, section, &contents->vertexShaders); break;
+		case SCENE_SCHEMA_COMPUTE_SHADERS: ReadRecords(bytes, section, &contents->computeShaders); break;
+		case SCENE_SCHEMA_TEXTURES: ReadRecords(bytes, section, &contents->textures); break;
+		case SCENE_SCHEMA_MATERIALS: ReadRecords(bytes, section, &contents->materials); break;
+		case SCENE_SCHEMA_MESHES: ReadRecords(bytes, section, &contents->meshes); break;
+		case SCENE_SCHEMA_TERRAIN_MATERIALS: ReadRecords(bytes, section, &contents->terrainMaterials); break;
+		case SCENE_SCHEMA_SKIES: ReadRecords(bytes, section, &contents->skies); break;
+		case SCENE_SCHEMA_SOUNDS: ReadRecords(bytes, section, &contents->sounds); break;
+		case SCENE_SCHEMA_ENTITIES: ReadRecords(bytes, section, &contents->entities); break;
+		case SCENE_SCHEMA_COMPONENTS: ReadRecords(bytes, section, &storedComponents); break;
+		case SCENE_SCHEMA_COLLIDER: ReadRecords(bytes, section, &contents->colliders); break;
+		case SCENE_SCHEMA_TERRAIN: ReadRecords(bytes, section, &contents->terrains); break;
+		case SCENE_SCHEMA_PARTICLE_SYSTEM: ReadRecords(bytes, section, &contents->particleSystems); break;
+		case SCENE_SCHEMA_LIGHT: ReadRecords(bytes, section, &contents->lights); break;
+		case SCENE_SCHEMA_MESH_RENDERER: ReadRecords(bytes, section, &contents->meshRenderers); break;
+		case SCENE_SCHEMA_CAMERA: ReadRecords(bytes, section, &contents->cameras); break;
+		case SCENE_SCHEMA_NOCLIP_MOVEMENT: ReadRecords(bytes, section, &contents->noclipMovements); break;
+		case SCENE_SCHEMA_FLASHLIGHT_CONTROLLER: ReadRecords(bytes, section, &contents->flashlightControllers); break;
+		case SCENE_SCHEMA_CELLS: ReadRecords(bytes, section, &contents->cells); break;
+		default:
+			// Written by a newer build. Whatever it holds, this build has no use for it.
+			break;
+		}
+	}
+
+	// Strings are copied out so the contents outlive the file's memory
+	size_t stringDataSize = stringData != nullptr ? (size_t)stringData->size : 0;
+	const char* characters = stringData != nullptr ? (const char*)(bytes + stringData->offset) : nullptr;
+	contents->strings.reserve(stringRecords.size());
+	for (const SceneFileString& record : stringRecords) {
+		if (!RangeInside(record.offset, record.length, stringDataSize)) {
+			contents->Clear();
+			return false;
+		}
+		contents->strings.emplace_back(characters + record.offset, record.length);
+	}
+
+	// Drops components of types this build doesn't know, keeping every entity's range contiguous
+	contents->components.reserve(storedComponents.size());
+	for (SceneFileEntity& entity : contents->entities) {
+		if (!RangeInside(entity.firstComponent, entity.componentCount, storedComponents.size())) {
+			contents->Clear();
+			return false;
+		}
+
+		uint32_t firstComponent = (uint32_t)contents->components.size();
+		for (uint32_t c = entity.firstComponent; c < entity.firstComponent + entity.componentCount; c++) {
+			if (storedComponents[c].schema >= SCENE_SCHEMA_COLLIDER &&
+				storedComponents[c].schema <= SCENE_SCHEMA_FLASHLIGHT_CONTROLLER) {
+				contents->components.push_back(storedComponents[c]);
+			}
+		}
+
+		entity.firstComponent = firstComponent;
+		entity.componentCount = (uint32_t)contents->components.size() - firstComponent;
+	}
+
+	contents->hasAssets = (header.flags & SCENE_FILE_FLAG_HAS_ASSETS) != 0;
+	if (header.name >= contents->strings.size() || !Validate(*contents)) {
+		contents->Clear();
+		return false;
+	}
+	contents->name = contents->strings[header.name];
+
+	return true;
+}
+
+bool SceneFile::Validate(const SceneFileContents& contents) {
+	size_t stringCount = contents.strings.size();
+	auto stringValid = [stringCount](uint32_t index) { return index < stringCount; };
+
+	for (const SceneFileFont& font : contents.fonts) {
+		if (!stringValid(font.name) || !stringValid(font.fileNameKey)) return false;
+	}
+
+	for (const std::vector<SceneFileShader>* shaders : { &contents.pixelShaders, &contents.vertexShaders, &contents.computeShaders }) {
+		for (const SceneFileShader& shader : *shaders) {
+			if (!stringValid(shader.name) || !stringValid(shader.filePath)) return false;
+		}
+	}
+
+	for (const SceneFileTexture& texture : contents.textures) {
+		if (!stringValid(texture.name) || !stringValid(texture.fileNameKey)) return false;
+	}
+
+	size_t textureCount = contents.textures.size();
+	size_t samplerCount = contents.samplers.size();
+	for (const SceneFileMaterial& material : contents.materials) {
+		if (!stringValid(material.name) ||
+			!IndexInRange(material.vertexShader, contents.vertexShaders.size()) ||
+			!IndexInRange(material.pixelShader, contents.pixelShaders.size()) ||
+			!IndexInRange(material.refractionPixelShader, contents.pixelShaders.size()) ||
+			!IndexInRange(material.albedoMap, textureCount) ||
+			!IndexInRange(material.normalMap, textureCount) ||
+			!IndexInRange(material.metalMap, textureCount) ||
+			!IndexInRange(material.roughnessMap, textureCount) ||
+			!IndexInRange(material.samplerState, samplerCount) ||
+			!IndexInRange(material.clampSamplerState, samplerCount)) {
+			return false;
+		}
+	}
+
+	for (const SceneFileMesh& mesh : contents.meshes) {
+		if (!stringValid(mesh.name) || !stringValid(mesh.fileNameKey)) return false;
+	}
+
+	for (const SceneFileTerrainMaterial& terrainMaterial : contents.terrainMaterials) {
+		if (!stringValid(terrainMaterial.name) ||
+			!stringValid(terrainMaterial.blendMapPath) ||
+			!RangeInside(terrainMaterial.firstMaterial, terrainMaterial.materialCount, contents.indices.size())) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < terrainMaterial.materialCount; i++) {
+			if (contents.indices[terrainMaterial.firstMaterial + i] >= contents.materials.size()) return false;
+		}
+	}
+
+	for (const SceneFileSky& sky : contents.skies) {
+		if (!stringValid(sky.name) || !stringValid(sky.fileNameKey) || !stringValid(sky.fileExtension)) return false;
+	}
+
+	for (const SceneFileSound& sound : contents.sounds) {
+		if (!stringValid(sound.name) || !stringValid(sound.fileNameKey)) return false;
+	}
+
+	for (const SceneFileEntity& entity : contents.entities) {
+		if (!stringValid(entity.name) || !RangeInside(entity.firstComponent, entity.componentCount, contents.components.size())) return false;
+	}
+
+	for (const SceneFileComponent& component : contents.components) {
+		size_t count = 0;
+		switch (component.schema) {
+		case SCENE_SCHEMA_COLLIDER: count = contents.colliders.size(); break;
+		case SCENE_SCHEMA_TERRAIN: count = contents.terrains.size(); break;
+		case SCENE_SCHEMA_PARTICLE_SYSTEM: count = contents.particleSystems.size(); break;
+		case SCENE_SCHEMA_LIGHT: count = contents.lights.size(); break;
+		case SCENE_SCHEMA_MESH_RENDERER: count = contents.meshRenderers.size(); break;
+		case SCENE_SCHEMA_CAMERA: count = contents.cameras.size(); break;
+		case SCENE_SCHEMA_NOCLIP_MOVEMENT: count = contents.noclipMovements.size(); break;
+		case SCENE_SCHEMA_FLASHLIGHT_CONTROLLER: count = contents.flashlightControllers.size(); break;
+		default: return false;
+		}
+
+		if (component.index >= count) return false;
+	}
+
+	for (const SceneFileTerrain& terrain : contents.terrains) {
+		if (!stringValid(terrain.fileNameKey)) return false;
+	}
+
+	for (const SceneFileParticleSystem& particleSystem : contents.particleSystems) {
+		if (!stringValid(particleSystem.fileNameKey)) return false;
+	}
+
+	for (const SceneFileCell& cell : contents.cells) {
+		if (!stringValid(cell.path)) return false;
+	}
+
+	// Entity-only files reference the assets already loaded, which can't be checked here
+	return !contents.hasAssets || ValidateAssetReferences(contents, contents);
+}
+
+bool SceneFile::ValidateAssetReferences(const SceneFileContents& entities, const SceneFileContents& assets) {
+	for (const SceneFileTerrain& terrain : entities.terrains) {
+		if (!IndexInRange(terrain.terrainMaterial, assets.terrainMaterials.size())) return false;
+	}
+
+	for (const SceneFileMeshRenderer& meshRenderer : entities.meshRenderers) {
+		if (!IndexInRange(meshRenderer.mesh, assets.meshes.size()) ||
+			!IndexInRange(meshRenderer.material, assets.materials.size())) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool SceneFile::ComponentsEqual(const SceneFileContents& contentsA, const SceneFileComponent& componentA,
+	const SceneFileContents& contentsB, const SceneFileComponent& componentB) {
+	if (componentA.schema != componentB.schema) return false;
+
+	uint32_t a = componentA.index;
+	uint32_t b = componentB.index;
+	switch (componentA.schema) {
+	case SCENE_SCHEMA_COLLIDER: return RecordsEqual(contentsA.colliders, a, contentsB.colliders, b);
+	case SCENE_SCHEMA_TERRAIN: return NamedRecordsEqual(contentsA, contentsA.terrains, a, contentsB, contentsB.terrains, b);
+	case SCENE_SCHEMA_PARTICLE_SYSTEM: return NamedRecordsEqual(contentsA, contentsA.particleSystems, a, contentsB, contentsB.particleSystems, b);
+	case SCENE_SCHEMA_LIGHT: return RecordsEqual(contentsA.lights, a, contentsB.lights, b);
+	case SCENE_SCHEMA_MESH_RENDERER: return RecordsEqual(contentsA.meshRenderers, a, contentsB.meshRenderers, b);
+	case SCENE_SCHEMA_CAMERA: return RecordsEqual(contentsA.cameras, a, contentsB.cameras, b);
+	case SCENE_SCHEMA_NOCLIP_MOVEMENT: return RecordsEqual(contentsA.noclipMovements, a, contentsB.noclipMovements, b);
+	case SCENE_SCHEMA_FLASHLIGHT_CONTROLLER: return RecordsEqual(contentsA.flashlightControllers, a, contentsB.flashlightControllers, b);
+	default: return false;
+	}
+}
+
+#pragma endregion
+
+#pragma region writing
+
+void SceneFile::Encode(const SceneFileContents& contents, std::vector<unsigned char>* output) {
+	struct PendingSection {
+		uint32_t schema;
+		uint32_t recordSize;
+		const void* data;
+		uint64_t size;
+	};
+
+	// The name goes through the table like every other string, without
+	// adding to the caller's table
+	std::vector<std::string> extraStrings;
+	uint32_t nameIndex;
+	auto existingName = std::find(contents.strings.begin(), contents.strings.end(), contents.name);
+	if (existingName != contents.strings.end()) {
+		nameIndex = (uint32_t)(existingName - contents.strings.begin());
+	}
+	else {
+		nameIndex = (uint32_t)contents.strings.size();
+		extraStrings.push_back(contents.name);
+	}
+
+	std::vector<SceneFileString> stringRecords;
+	std::vector<char> stringData;
+	stringRecords.reserve(contents.strings.size() + extraStrings.size());
+	auto addStrings = [&](const std::vector<std::string>& table) {
+		for (const std::string& text : table) {
+			SceneFileString record;
+			record.offset = (uint32_t)stringData.size();
+			record.length = (uint32_t)text.size();
+			stringRecords.push_back(record);
+			stringData.insert(stringData.end(), text.begin(), text.end());
+		}
+	};
+
+	addStrings(contents.strings);
+	addStrings(extraStrings);
+
+	auto records = [](uint32_t schema, const auto& section) {
+		typedef typename std::decay<decltype(section)>::type::value_type Record;
+		return PendingSection{ schema, (uint32_t)sizeof(Record), section.data(), section.size() * sizeof(Record) };
+	};
+
+	std::vector<PendingSection> pending = {
+		records(SCENE_SCHEMA_STRINGS, stringRecords),
+		{ SCENE_SCHEMA_STRING_DATA, sizeof(char), stringData.data(), stringData.size() },
+		records(SCENE_SCHEMA_INDICES, contents.indices),
+		records(SCENE_SCHEMA_ENTITIES, contents.entities),
+		records(SCENE_SCHEMA_COMPONENTS, contents.components),
+		records(SCENE_SCHEMA_COLLIDER, contents.colliders),
+		records(SCENE_SCHEMA_TERRAIN, contents.terrains),
+		records(SCENE_SCHEMA_PARTICLE_SYSTEM, contents.particleSystems),
+		records(SCENE_SCHEMA_LIGHT, contents.lights),
+		records(SCENE_SCHEMA_MESH_RENDERER, contents.meshRenderers),
+		records(SCENE_SCHEMA_CAMERA, contents.cameras),
+		records(SCENE_SCHEMA_NOCLIP_MOVEMENT, contents.noclipMovements),
+		records(SCENE_SCHEMA_FLASHLIGHT_CONTROLLER, contents.flashlightControllers),
+		records(SCENE_SCHEMA_CELLS, contents.cells)
+	};
+
+	if (contents.hasAssets) {
+		pending.insert(pending.end(), {
+			records(SCENE_SCHEMA_FONTS, contents.fonts),
+			records(SCENE_SCHEMA_SAMPLERS, contents.samplers),
+			records(SCENE_SCHEMA_PIXEL_SHADERS, contents.pixelShaders),
+			records(SCENE_SCHEMA_VERTEX_SHADERS, contents.vertexShaders),
+			records(SCENE_SCHEMA_COMPUTE_SHADERS, contents.computeShaders),
+			records(SCENE_SCHEMA_TEXTURES, contents.textures),
+			records(SCENE_SCHEMA_MATERIALS, contents.materials),
+			records(SCENE_SCHEMA_MESHES, contents.meshes),
+			records(SCENE_SCHEMA_TERRAIN_MATERIALS, contents.terrainMaterials),
+			records(SCENE_SCHEMA_SKIES, contents.skies),
+			records(SCENE_SCHEMA_SOUNDS, contents.sounds)
+		});
+	}
+
+	SceneFileHeader header = {};
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	header.headerSize = sizeof(SceneFileHeader);
+	header.sectionCount = (uint32_t)pending.size();
+	header.flags = contents.hasAssets ? SCENE_FILE_FLAG_HAS_ASSETS : 0;
+	header.name = nameIndex;
+
+	std::vector<SceneFileSection> sections(pending.size());
+	uint64_t offset = sizeof(SceneFileHeader) + pending.size() * sizeof(SceneFileSection);
+	for (size_t i = 0; i < pending.size(); i++) {
+		offset = (offset + SCENE_FILE_SECTION_ALIGNMENT - 1) & ~(uint64_t)(SCENE_FILE_SECTION_ALIGNMENT - 1);
+
+		sections[i].schema = pending[i].schema;
+		sections[i].recordSize = pending[i].recordSize;
+		sections[i].offset = offset;
+		sections[i].size = pending[i].size;
+
+		offset += pending[i].size;
+	}
+
+	output->assign((size_t)offset, 0);
+	memcpy(output->data(), &header, sizeof(SceneFileHeader));
+	memcpy(output->data() + sizeof(SceneFileHeader), sections.data(), sections.size() * sizeof(SceneFileSection));
+
+	for (size_t i = 0; i < pending.size(); i++) {
+		if (pending[i].size > 0) memcpy(output->data() + sections[i].offset, pending[i].data, (size_t)pending[i].size);
+	}
+}
+
+bool SceneFile::Write(const std::string& path, const SceneFileContents& contents) {
+	std::vector<unsigned char> output;
+	Encode(contents, &output);
+	return MappedFile::WriteWholeFile(path, output.data(), output.size());
+}
+
+#pragma endregion
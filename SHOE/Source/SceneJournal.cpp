@@ -0,0 +1,225 @@
+#include "../Headers/SceneJournal.h"
+#include "../Headers/MappedFile.h"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+// 64 bit FNV-1a, same as AssetCache. The offset is Hash's default seed.
+static const uint64_t fnvPrime = 1099511628211ull;
+
+// Record checksums start from the header fields, then carry on through the payload
+static uint64_t GetRecordChecksum(const SceneJournalRecord& record, const void* payload) {
+	uint64_t checksum = SceneJournal::Hash(&record, offsetof(SceneJournalRecord, checksum));
+	return SceneJournal::Hash(payload, record.size, checksum);
+}
+
+uint64_t SceneJournal::Hash(const void* data, size_t size, uint64_t hash) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= fnvPrime;
+	}
+	return hash;
+}
+
+#pragma region reading
+void SceneJournal::Reset(const SceneFileContents& contents, uint64_t baseHash, uint64_t baseSize, SceneJournalState* state) {
+	*state = SceneJournalState();
+	state->baseHash = baseHash;
+	state->baseSize = baseSize;
+
+	state->slots.resize(contents.entities.size());
+	for (uint32_t i = 0; i < state->slots.size(); i++) {
+		state->slots[i] = i;
+	}
+	state->slotCount = (uint32_t)state->slots.size();
+}
+
+bool SceneJournal::Apply(const void* data, size_t size, SceneFileContents* contents, SceneJournalState* state) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	uint64_t baseHash = state->baseHash;
+	uint64_t baseSize = state->baseSize;
+	Reset(*contents, baseHash, baseSize, state);
+
+	SceneJournalHeader header;
+	if (size < sizeof(header)) return false;
+	memcpy(&header, bytes, sizeof(header));
+
+	if (header.magic != SCENE_JOURNAL_MAGIC || header.version != SCENE_JOURNAL_VERSION ||
+		header.baseHash != baseHash || header.baseSize != baseSize) {
+		return false;
+	}
+
+	// What each slot holds once the journal's been replayed
+	struct Slot {
+		bool present = false;
+		// Index into the scene file's entities, or into edits
+		uint32_t entity = 0;
+		bool edited = false;
+		bool moved = false;
+		SceneJournalTransform transform;
+	};
+
+	std::vector<Slot> slots(contents->entities.size());
+	for (uint32_t i = 0; i < slots.size(); i++) {
+		slots[i].present = true;
+		slots[i].entity = i;
+	}
+
+	std::vector<SceneFileContents> edits;
+	bool stale = false;
+	size_t offset = sizeof(header);
+	while (size - offset >= sizeof(SceneJournalRecord)) {
+		SceneJournalRecord record;
+		memcpy(&record, bytes + offset, sizeof(record));
+
+		const unsigned char* payload = bytes + offset + sizeof(record);
+		if (record.size > size - offset - sizeof(record) || GetRecordChecksum(record, payload) != record.checksum) {
+			break;
+		}
+
+		// Slots are handed out in order, so a record can't skip ahead of the next new one
+		if (record.slot > slots.size()) break;
+		if (record.slot == slots.size()) slots.push_back(Slot());
+		Slot& slot = slots[record.slot];
+
+		if (record.type == SCENE_JOURNAL_SET_ENTITY) {
+			SceneFileContents edit;
+			if (!SceneFile::Read(payload, record.size, &edit) || edit.entities.size() != 1) break;
+
+			// An entity using assets the scene doesn't have means the journal was
+			// written against other assets, and none of it can be trusted
+			if (contents->hasAssets && !SceneFile::ValidateAssetReferences(edit, *contents)) {
+				stale = true;
+				break;
+			}
+
+			slot.present = true;
+			slot.entity = (uint32_t)edits.size();
+			slot.edited = true;
+			slot.moved = false;
+			edits.push_back(std::move(edit));
+		}
+		else if (record.type == SCENE_JOURNAL_SET_TRANSFORM) {
+			if (!slot.present || record.size != sizeof(SceneJournalTransform)) break;
+
+			memcpy(&slot.transform, payload, sizeof(SceneJournalTransform));
+			slot.moved = true;
+		}
+		else if (record.type == SCENE_JOURNAL_REMOVE_ENTITY) {
+			slot.present = false;
+		}
+		// Anything else was written by a newer build, and is skipped
+
+		offset += sizeof(record) + record.size;
+		state->replayedCount++;
+	}
+
+	if (stale) {
+		Reset(*contents, baseHash, baseSize, state);
+		return false;
+	}
+
+	SceneFileContents replayed = *contents;
+	replayed.ClearEntities();
+	state->slots.clear();
+
+	for (uint32_t i = 0; i < slots.size(); i++) {
+		const Slot& slot = slots[i];
+		if (!slot.present) continue;
+
+		uint32_t entity = slot.edited ? replayed.CopyEntity(edits[slot.entity], 0) : replayed.CopyEntity(*contents, slot.entity);
+		if (slot.moved) {
+			memcpy(replayed.entities[entity].position, slot.transform.position, sizeof(slot.transform.position));
+			memcpy(replayed.entities[entity].rotation, slot.transform.rotation, sizeof(slot.transform.rotation));
+			memcpy(replayed.entities[entity].scale, slot.transform.scale, sizeof(slot.transform.scale));
+		}
+
+		state->slots.push_back(i);
+	}
+
+	*contents = std::move(replayed);
+	state->slotCount = (uint32_t)slots.size();
+	state->journalSize = offset;
+	return true;
+}
+#pragma endregion
+
+#pragma region writing
+void SceneJournal::AddRecord(SceneJournalRecordType type, uint32_t slot, const void* payload, size_t size, std::vector<unsigned char>* records) {
+	SceneJournalRecord record = {};
+	record.type = type;
+	record.slot = slot;
+	record.size = (uint32_t)size;
+	record.checksum = GetRecordChecksum(record, payload);
+
+	const unsigned char* recordBytes = (const unsigned char*)&record;
+	records->insert(records->end(), recordBytes, recordBytes + sizeof(record));
+	records->insert(records->end(), (const unsigned char*)payload, (const unsigned char*)payload + size);
+}
+
+void SceneJournal::AddEntity(const SceneFileContents& contents, uint32_t entityIndex, uint32_t slot, std::vector<unsigned char>* records) {
+	SceneFileContents entity;
+	entity.hasAssets = false;
+	entity.CopyEntity(contents, entityIndex);
+
+	std::vector<unsigned char> payload;
+	SceneFile::Encode(entity, &payload);
+	AddRecord(SCENE_JOURNAL_SET_ENTITY, slot, payload.data(), payload.size(), records);
+}
+
+bool SceneJournal::AddEntityChanges(const SceneFileContents& before, uint32_t beforeIndex,
+	const SceneFileContents& after, uint32_t afterIndex, uint32_t slot, std::vector<unsigned char>* records) {
+	const SceneFileEntity& beforeEntity = before.entities[beforeIndex];
+	const SceneFileEntity& afterEntity = after.entities[afterIndex];
+
+	bool sameComponents = beforeEntity.flags == afterEntity.flags &&
+		beforeEntity.componentCount == afterEntity.componentCount &&
+		before.GetString(beforeEntity.name) == after.GetString(afterEntity.name);
+	for (uint32_t c = 0; sameComponents && c < afterEntity.componentCount; c++) {
+		sameComponents = SceneFile::ComponentsEqual(before, before.components[beforeEntity.firstComponent + c],
+			after, after.components[afterEntity.firstComponent + c]);
+	}
+
+	if (!sameComponents) {
+		AddEntity(after, afterIndex, slot, records);
+		return true;
+	}
+
+	if (memcmp(beforeEntity.position, afterEntity.position, sizeof(afterEntity.position)) == 0 &&
+		memcmp(beforeEntity.rotation, afterEntity.rotation, sizeof(afterEntity.rotation)) == 0 &&
+		memcmp(beforeEntity.scale, afterEntity.scale, sizeof(afterEntity.scale)) == 0) {
+		return false;
+	}
+
+	SceneJournalTransform transform;
+	memcpy(transform.position, afterEntity.position, sizeof(transform.position));
+	memcpy(transform.rotation, afterEntity.rotation, sizeof(transform.rotation));
+	memcpy(transform.scale, afterEntity.scale, sizeof(transform.scale));
+	AddRecord(SCENE_JOURNAL_SET_TRANSFORM, slot, &transform, sizeof(transform), records);
+	return true;
+}
+
+void SceneJournal::AddRemoval(uint32_t slot, std::vector<unsigned char>* records) {
+	AddRecord(SCENE_JOURNAL_REMOVE_ENTITY, slot, nullptr, 0, records);
+}
+
+bool SceneJournal::Create(const std::string& path, uint64_t baseHash, uint64_t baseSize) {
+	SceneJournalHeader header = {};
+	header.magic = SCENE_JOURNAL_MAGIC;
+	header.version = SCENE_JOURNAL_VERSION;
+	header.baseHash = baseHash;
+	header.baseSize = baseSize;
+
+	return MappedFile::WriteWholeFile(path, &header, sizeof(header));
+}
+
+bool SceneJournal::Append(const std::string& path, const std::vector<unsigned char>& records) {
+	std::ofstream output(path, std::ios::binary | std::ios::app);
+	if (!output.is_open()) return false;
+
+	output.write((const char*)records.data(), (std::streamsize)records.size());
+	output.flush();
+	return output.good();
+}
+#pragma endregion
@@ -0,0 +1,498 @@
+#include "../Headers/SceneJsonReader.h"
+#include "../Headers/SceneManager.h"
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#pragma region object
+
+void SceneJsonObject::Clear() {
+	// Members are kept around so their strings and arrays reuse their memory
+	memberCount = 0;
+}
+
+SceneJsonObject::Member& SceneJsonObject::Add(const char* key, rapidjson::SizeType length) {
+	if (memberCount == members.size()) members.emplace_back();
+
+	Member& member = members[memberCount++];
+	member.key.assign(key, length);
+	member.isNull = false;
+	member.isNumber = false;
+	member.boolean = false;
+	member.number = 0.0;
+	member.text.clear();
+	member.numbers.clear();
+	return member;
+}
+
+const SceneJsonObject::Member* SceneJsonObject::Find(const char* key) const {
+	for (size_t i = 0; i < memberCount; i++) {
+		if (members[i].key == key) return &members[i];
+	}
+	return nullptr;
+}
+
+#pragma endregion
+
+#pragma region reading
+
+SceneJsonReader::SceneJsonReader(SceneFileContents* contents, AssetListener assetListener, EntityListener entityListener)
+{
+	this->contents = contents;
+	this->assetListener = assetListener;
+	this->entityListener = entityListener;
+	this->arrayMember = nullptr;
+	this->categoryBit = 0;
+	this->readingEntities = false;
+	this->validScene = false;
+	this->assetsReady = false;
+	this->assetCategories = 0;
+	this->startTime = 0.0;
+	this->firstEntityTime = -1.0;
+}
+
+bool SceneJsonReader::Read(const char* data, size_t size) {
+	contents->Clear();
+	frames.clear();
+	key.clear();
+	record.Clear();
+	component.Clear();
+	arrayMember = nullptr;
+	categoryBit = 0;
+	readingEntities = false;
+	validScene = false;
+	assetsReady = false;
+	assetCategories = 0;
+	pendingEntities.clear();
+
+	startTime = GetTime();
+	firstEntityTime = -1.0;
+
+	rapidjson::Reader reader;
+	rapidjson::MemoryStream stream(data, size);
+	if (!reader.Parse(stream, *this) || !validScene) {
+		return false;
+	}
+
+	// Scenes missing some or all asset categories, like ones saved
+	// before play, only know every asset is read once they end
+	if (!assetsReady && !FinishAssets()) {
+		return false;
+	}
+
+	return SceneFile::Validate(*contents);
+}
+
+double SceneJsonReader::GetFirstEntityTime() {
+	return firstEntityTime;
+}
+
+SceneJsonObject* SceneJsonReader::GetCurrentObject() {
+	if (frames.empty()) return nullptr;
+	if (frames.back() == FRAME_RECORD) return &record;
+	if (frames.back() == FRAME_COMPONENT) return &component;
+	return nullptr;
+}
+
+bool SceneJsonReader::AddValue(bool isNull, bool boolean, double number, const char* text, rapidjson::SizeType length) {
+	if (frames.empty()) return true;
+
+	if (frames.back() == FRAME_VALUE_ARRAY) {
+		if (text == nullptr && !isNull) arrayMember->numbers.push_back(number);
+		return true;
+	}
+
+	if (frames.back() == FRAME_ROOT) {
+		if (key == VALID_SHOE_SCENE) validScene = boolean;
+		else if (key == NAME && text != nullptr) contents->name.assign(text, length);
+		return true;
+	}
+
+	SceneJsonObject* object = GetCurrentObject();
+	if (object == nullptr) return true;
+
+	SceneJsonObject::Member& member = object->Add(key.c_str(), (rapidjson::SizeType)key.size());
+	member.isNull = isNull;
+	member.isNumber = !isNull && text == nullptr;
+	member.boolean = boolean;
+	member.number = number;
+	if (text != nullptr) member.text.assign(text, length);
+	return true;
+}
+
+bool SceneJsonReader::Null() { return AddValue(true, false, 0.0, nullptr, 0); }
+bool SceneJsonReader::Bool(bool b) { return AddValue(false, b, b ? 1.0 : 0.0, nullptr, 0); }
+bool SceneJsonReader::Int(int i) { return AddValue(false, false, i, nullptr, 0); }
+bool SceneJsonReader::Uint(unsigned u) { return AddValue(false, false, u, nullptr, 0); }
+bool SceneJsonReader::Int64(int64_t i) { return AddValue(false, false, (double)i, nullptr, 0); }
+bool SceneJsonReader::Uint64(uint64_t u) { return AddValue(false, false, (double)u, nullptr, 0); }
+bool SceneJsonReader::Double(double d) { return AddValue(false, false, d, nullptr, 0); }
+
+bool SceneJsonReader::String(const char* str, rapidjson::SizeType length, bool copy) {
+	return AddValue(false, false, 0.0, str, length);
+}
+
+bool SceneJsonReader::Key(const char* str, rapidjson::SizeType length, bool copy) {
+	key.assign(str, length);
+	return true;
+}
+
+bool SceneJsonReader::StartObject() {
+	if (frames.empty()) {
+		frames.push_back(FRAME_ROOT);
+	}
+	else if (frames.back() == FRAME_CATEGORY) {
+		record.Clear();
+		frames.push_back(FRAME_RECORD);
+
+		// Components are added to the last entity as they close, so it's
+		// added now and filled in once the rest of its members are read
+		if (readingEntities) {
+			SceneFileEntity entity;
+			entity.firstComponent = (uint32_t)contents->components.size();
+			contents->entities.push_back(entity);
+		}
+	}
+	else if (frames.back() == FRAME_COMPONENTS) {
+		component.Clear();
+		frames.push_back(FRAME_COMPONENT);
+	}
+	else {
+		frames.push_back(FRAME_SKIP);
+	}
+	return true;
+}
+
+bool SceneJsonReader::EndObject(rapidjson::SizeType memberCount) {
+	Frame frame = frames.back();
+	frames.pop_back();
+
+	if (frame == FRAME_COMPONENT) EndComponent();
+	else if (frame == FRAME_RECORD) return EndRecord();
+	return true;
+}
+
+bool SceneJsonReader::StartArray() {
+	Frame top = frames.empty() ? FRAME_SKIP : frames.back();
+
+	if (top == FRAME_ROOT) {
+		categoryBit = GetCategoryBit(key);
+		readingEntities = key == ENTITIES;
+		frames.push_back(categoryBit != 0 || readingEntities ? FRAME_CATEGORY : FRAME_SKIP);
+	}
+	else if (top == FRAME_RECORD && readingEntities && key == COMPONENTS) {
+		frames.push_back(FRAME_COMPONENTS);
+	}
+	else if (top == FRAME_RECORD || top == FRAME_COMPONENT) {
+		arrayMember = &GetCurrentObject()->Add(key.c_str(), (rapidjson::SizeType)key.size());
+		frames.push_back(FRAME_VALUE_ARRAY);
+	}
+	else {
+		frames.push_back(FRAME_SKIP);
+	}
+	return true;
+}
+
+bool SceneJsonReader::EndArray(rapidjson::SizeType elementCount) {
+	Frame frame = frames.back();
+	frames.pop_back();
+
+	if (frame != FRAME_CATEGORY) return true;
+
+	assetCategories |= categoryBit;
+	categoryBit = 0;
+	readingEntities = false;
+
+	// Entities can be created from here on, even while the rest of the file is still being read
+	if (!assetsReady && assetCategories == SCENE_JSON_ALL_ASSET_CATEGORIES) {
+		return FinishAssets();
+	}
+	return true;
+}
+
+bool SceneJsonReader::FinishAssets() {
+	assetsReady = true;
+	contents->hasAssets = assetCategories != 0;
+
+	// Nothing has been created from this file yet, so this is the last point it can be turned away cleanly
+	if (!validScene || !SceneFile::Validate(*contents)) {
+		return false;
+	}
+
+	if (assetListener && !assetListener(*contents)) {
+		return false;
+	}
+
+	for (uint32_t entityIndex : pendingEntities) {
+		if (!PassEntity(entityIndex)) return false;
+	}
+	pendingEntities.clear();
+
+	return true;
+}
+
+bool SceneJsonReader::PassEntity(uint32_t entityIndex) {
+	if (firstEntityTime < 0.0) firstEntityTime = GetTime() - startTime;
+
+	return !entityListener || entityListener(*contents, entityIndex);
+}
+
+uint32_t SceneJsonReader::GetCategoryBit(const std::string& categoryKey) {
+	const char* categories[] = {
+		MESHES, TEXTURES, MATERIALS, FONTS, TEXTURE_SAMPLE_STATES, VERTEX_SHADERS,
+		PIXEL_SHADERS, COMPUTE_SHADERS, SKIES, SOUNDS, TERRAIN_MATERIALS
+	};
+
+	for (uint32_t i = 0; i < sizeof(categories) / sizeof(categories[0]); i++) {
+		if (categoryKey == categories[i]) return 1 << i;
+	}
+	return 0;
+}
+
+double SceneJsonReader::GetTime() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#pragma endregion
+
+#pragma region records
+
+uint32_t SceneJsonReader::ReadString(const SceneJsonObject& object, const char* memberName, const char* defaultText) {
+	const SceneJsonObject::Member* member = object.Find(memberName);
+	if (member == nullptr || member->isNull || member->isNumber) return contents->AddString(defaultText);
+	return contents->AddString(member->text);
+}
+
+int32_t SceneJsonReader::ReadIndex(const SceneJsonObject& object, const char* memberName) {
+	const SceneJsonObject::Member* member = object.Find(memberName);
+	if (member == nullptr || !member->isNumber) return SCENE_FILE_NO_INDEX;
+	return (int32_t)member->number;
+}
+
+uint32_t SceneJsonReader::ReadFlag(const SceneJsonObject& object, const char* memberName, uint32_t flag) {
+	const SceneJsonObject::Member* member = object.Find(memberName);
+	return member != nullptr && member->boolean ? flag : 0;
+}
+
+double SceneJsonReader::ReadNumber(const SceneJsonObject& object, const char* memberName, double defaultNumber) {
+	const SceneJsonObject::Member* member = object.Find(memberName);
+	if (member == nullptr || !member->isNumber) return defaultNumber;
+	return member->number;
+}
+
+void SceneJsonReader::ReadFloats(const SceneJsonObject& object, const char* memberName, float* values, int count) {
+	const SceneJsonObject::Member* member = object.Find(memberName);
+	if (member == nullptr) return;
+
+	int available = (std::min)(count, (int)member->numbers.size());
+	for (int i = 0; i < available; i++) {
+		values[i] = (float)member->numbers[i];
+	}
+}
+
+bool SceneJsonReader::EndRecord() {
+	if (readingEntities) return EndEntity();
+
+	if (categoryBit == GetCategoryBit(FONTS)) {
+		SceneFileFont font;
+		font.name = ReadString(record, NAME);
+		font.fileNameKey = ReadString(record, FILENAME_KEY);
+		contents->fonts.push_back(font);
+	}
+	else if (categoryBit == GetCategoryBit(TEXTURE_SAMPLE_STATES)) {
+		SceneFileSampler sampler;
+		sampler.addressU = (int32_t)ReadNumber(record, SAMPLER_ADDRESS_U, sampler.addressU);
+		sampler.addressV = (int32_t)ReadNumber(record, SAMPLER_ADDRESS_V, sampler.addressV);
+		sampler.addressW = (int32_t)ReadNumber(record, SAMPLER_ADDRESS_W, sampler.addressW);
+		sampler.filter = (int32_t)ReadNumber(record, SAMPLER_FILTER, sampler.filter);
+		sampler.maxAnisotropy = (uint32_t)ReadNumber(record, SAMPLER_MAX_ANISOTROPY, sampler.maxAnisotropy);
+		sampler.minLOD = (float)ReadNumber(record, SAMPLER_MIN_LOD, sampler.minLOD);
+		sampler.maxLOD = (float)ReadNumber(record, SAMPLER_MAX_LOD, sampler.maxLOD);
+		sampler.mipLODBias = (float)ReadNumber(record, SAMPLER_MIP_LOD_BIAS, sampler.mipLODBias);
+		sampler.comparisonFunction = (int32_t)ReadNumber(record, SAMPLER_COMPARISON_FUNCTION, sampler.comparisonFunction);
+		ReadFloats(record, SAMPLER_BORDER_COLOR, sampler.borderColor, 4);
+		contents->samplers.push_back(sampler);
+	}
+	else if (categoryBit == GetCategoryBit(PIXEL_SHADERS) ||
+			 categoryBit == GetCategoryBit(VERTEX_SHADERS) ||
+			 categoryBit == GetCategoryBit(COMPUTE_SHADERS)) {
+		SceneFileShader shader;
+		shader.name = ReadString(record, NAME);
+		shader.filePath = ReadString(record, SHADER_FILE_PATH);
+
+		if (categoryBit == GetCategoryBit(PIXEL_SHADERS)) contents->pixelShaders.push_back(shader);
+		else if (categoryBit == GetCategoryBit(VERTEX_SHADERS)) contents->vertexShaders.push_back(shader);
+		else contents->computeShaders.push_back(shader);
+	}
+	else if (categoryBit == GetCategoryBit(TEXTURES)) {
+		SceneFileTexture texture;
+		texture.name = ReadString(record, NAME);
+		texture.fileNameKey = ReadString(record, FILENAME_KEY);
+		texture.assetPathIndex = (int32_t)ReadNumber(record, TEXTURE_ASSET_PATH_INDEX, texture.assetPathIndex);
+		contents->textures.push_back(texture);
+	}
+	else if (categoryBit == GetCategoryBit(MATERIALS)) {
+		SceneFileMaterial material;
+		material.name = ReadString(record, NAME);
+		material.flags = ReadFlag(record, MAT_IS_TRANSPARENT, SCENE_FLAG_TRANSPARENT) |
+			ReadFlag(record, MAT_IS_REFRACTIVE, SCENE_FLAG_REFRACTIVE);
+		material.uvTiling = (float)ReadNumber(record, MAT_UV_TILING, material.uvTiling);
+		material.indexOfRefraction = (float)ReadNumber(record, MAT_INDEX_OF_REFRACTION, material.indexOfRefraction);
+		material.refractionScale = (float)ReadNumber(record, MAT_REFRACTION_SCALE, material.refractionScale);
+		ReadFloats(record, MAT_COLOR_TINT, material.colorTint, 4);
+
+		material.vertexShader = ReadIndex(record, MAT_VERTEX_SHADER);
+		material.pixelShader = ReadIndex(record, MAT_PIXEL_SHADER);
+		material.refractionPixelShader = ReadIndex(record, MAT_REFRACTION_PIXEL_SHADER);
+		material.albedoMap = ReadIndex(record, MAT_TEXTURE_OR_ALBEDO_MAP);
+		material.normalMap = ReadIndex(record, MAT_NORMAL_MAP);
+		material.metalMap = ReadIndex(record, MAT_METAL_MAP);
+		material.roughnessMap = ReadIndex(record, MAT_ROUGHNESS_MAP);
+		material.samplerState = ReadIndex(record, MAT_TEXTURE_SAMPLER_STATE);
+		material.clampSamplerState = ReadIndex(record, MAT_CLAMP_SAMPLER_STATE);
+		contents->materials.push_back(material);
+	}
+	else if (categoryBit == GetCategoryBit(MESHES)) {
+		SceneFileMesh mesh;
+		mesh.name = ReadString(record, NAME);
+		mesh.fileNameKey = ReadString(record, FILENAME_KEY);
+		mesh.flags = ReadFlag(record, MESH_NEEDS_DEPTH_PREPASS, SCENE_FLAG_DEPTH_PREPASS);
+		mesh.indexCount = (int32_t)ReadNumber(record, MESH_INDEX_COUNT, mesh.indexCount);
+		mesh.materialIndex = (int32_t)ReadNumber(record, MESH_MATERIAL_INDEX, mesh.materialIndex);
+		contents->meshes.push_back(mesh);
+	}
+	else if (categoryBit == GetCategoryBit(TERRAIN_MATERIALS)) {
+		SceneFileTerrainMaterial terrainMaterial;
+		terrainMaterial.name = ReadString(record, NAME);
+		terrainMaterial.blendMapPath = ReadString(record, TERRAIN_MATERIAL_BLEND_MAP_PATH);
+		terrainMaterial.flags = ReadFlag(record, TERRAIN_MATERIAL_BLEND_MAP_ENABLED, SCENE_FLAG_BLEND_MAP);
+
+		terrainMaterial.firstMaterial = (uint32_t)contents->indices.size();
+		const SceneJsonObject::Member* materials = record.Find(TERRAIN_MATERIAL_MATERIAL_ARRAY);
+		if (materials != nullptr) {
+			for (double index : materials->numbers) {
+				contents->indices.push_back((uint32_t)index);
+			}
+		}
+		terrainMaterial.materialCount = (uint32_t)contents->indices.size() - terrainMaterial.firstMaterial;
+		contents->terrainMaterials.push_back(terrainMaterial);
+	}
+	else if (categoryBit == GetCategoryBit(SKIES)) {
+		SceneFileSky sky;
+		sky.name = ReadString(record, NAME);
+		sky.fileNameKey = ReadString(record, FILENAME_KEY);
+		sky.fileExtension = ReadString(record, SKY_FILENAME_EXTENSION, ".png");
+		sky.flags = ReadFlag(record, SKY_FILENAME_KEY_TYPE, SCENE_FLAG_SEPARATE_SKY_FACES);
+		contents->skies.push_back(sky);
+	}
+	else if (categoryBit == GetCategoryBit(SOUNDS)) {
+		SceneFileSound sound;
+		sound.name = ReadString(record, NAME);
+		sound.fileNameKey = ReadString(record, FILENAME_KEY);
+		sound.mode = (uint32_t)ReadNumber(record, SOUND_FMOD_MODE, sound.mode);
+		contents->sounds.push_back(sound);
+	}
+
+	return true;
+}
+
+bool SceneJsonReader::EndEntity() {
+	SceneFileEntity& entity = contents->entities.back();
+	entity.name = ReadString(record, NAME);
+	entity.flags = ReadFlag(record, ENABLED, SCENE_FLAG_ENABLED);
+	ReadFloats(record, TRANSFORM_LOCAL_POSITION, entity.position, 3);
+	ReadFloats(record, TRANSFORM_LOCAL_ROTATION, entity.rotation, 3);
+	ReadFloats(record, TRANSFORM_LOCAL_SCALE, entity.scale, 3);
+
+	uint32_t entityIndex = (uint32_t)contents->entities.size() - 1;
+	if (!assetsReady) {
+		pendingEntities.push_back(entityIndex);
+		return true;
+	}
+
+	return PassEntity(entityIndex);
+}
+
+void SceneJsonReader::EndComponent() {
+	const SceneJsonObject::Member* componentType = component.Find(COMPONENT_TYPE);
+	if (componentType == nullptr || !componentType->isNumber) return;
+
+	uint32_t enabled = ReadFlag(component, ENABLED, SCENE_FLAG_ENABLED);
+	switch ((int)componentType->number) {
+	case ComponentTypes::COLLIDER: {
+		SceneFileCollider& collider = contents->AddComponent(SCENE_SCHEMA_COLLIDER, contents->colliders);
+		collider.flags = enabled |
+			ReadFlag(component, COLLIDER_IS_VISIBLE, SCENE_FLAG_VISIBLE) |
+			ReadFlag(component, COLLIDER_TYPE, SCENE_FLAG_TRIGGER);
+		ReadFloats(component, COLLIDER_POSITION_OFFSET, collider.positionOffset, 3);
+		ReadFloats(component, COLLIDER_ROTATION_OFFSET, collider.rotationOffset, 3);
+		ReadFloats(component, COLLIDER_SCALE_OFFSET, collider.scale, 3);
+		break;
+	}
+	case ComponentTypes::TERRAIN: {
+		SceneFileTerrain& terrain = contents->AddComponent(SCENE_SCHEMA_TERRAIN, contents->terrains);
+		terrain.flags = enabled;
+		terrain.fileNameKey = ReadString(component, FILENAME_KEY);
+		terrain.terrainMaterial = ReadIndex(component, TERRAIN_INDEX_OF_TERRAIN_MATERIAL);
+		break;
+	}
+	case ComponentTypes::PARTICLE_SYSTEM: {
+		SceneFileParticleSystem& particleSystem = contents->AddComponent(SCENE_SCHEMA_PARTICLE_SYSTEM, contents->particleSystems);
+		particleSystem.flags = enabled |
+			ReadFlag(component, PARTICLE_SYSTEM_ADDITIVE_BLEND, SCENE_FLAG_ADDITIVE_BLEND) |
+			ReadFlag(component, PARTICLE_SYSTEM_IS_MULTI_PARTICLE, SCENE_FLAG_MULTI_PARTICLE);
+		particleSystem.fileNameKey = ReadString(component, FILENAME_KEY);
+		particleSystem.maxParticles = (int32_t)ReadNumber(component, PARTICLE_SYSTEM_MAX_PARTICLES, particleSystem.maxParticles);
+		particleSystem.particlesPerSecond = (float)ReadNumber(component, PARTICLE_SYSTEM_PARTICLES_PER_SECOND, particleSystem.particlesPerSecond);
+		particleSystem.particleLifetime = (float)ReadNumber(component, PARTICLE_SYSTEM_PARTICLE_LIFETIME, particleSystem.particleLifetime);
+		particleSystem.scale = (float)ReadNumber(component, PARTICLE_SYSTEM_SCALE, particleSystem.scale);
+		particleSystem.speed = (float)ReadNumber(component, PARTICLE_SYSTEM_SPEED, particleSystem.speed);
+		ReadFloats(component, PARTICLE_SYSTEM_DESTINATION, particleSystem.destination, 3);
+		ReadFloats(component, PARTICLE_SYSTEM_COLOR_TINT, particleSystem.colorTint, 4);
+		break;
+	}
+	case ComponentTypes::LIGHT: {
+		SceneFileLight& light = contents->AddComponent(SCENE_SCHEMA_LIGHT, contents->lights);
+		light.flags = enabled | ReadFlag(component, LIGHT_CASTS_SHADOWS, SCENE_FLAG_CASTS_SHADOWS);
+		light.type = (float)ReadNumber(component, LIGHT_TYPE, light.type);
+		light.intensity = (float)ReadNumber(component, LIGHT_INTENSITY, light.intensity);
+		light.range = (float)ReadNumber(component, LIGHT_RANGE, light.range);
+		ReadFloats(component, LIGHT_COLOR, light.color, 3);
+		break;
+	}
+	case ComponentTypes::MESH_RENDERER: {
+		SceneFileMeshRenderer& meshRenderer = contents->AddComponent(SCENE_SCHEMA_MESH_RENDERER, contents->meshRenderers);
+		meshRenderer.flags = enabled;
+		meshRenderer.mesh = ReadIndex(component, MESH_COMPONENT_INDEX);
+		meshRenderer.material = ReadIndex(component, MATERIAL_COMPONENT_INDEX);
+		break;
+	}
+	case ComponentTypes::CAMERA: {
+		SceneFileCamera& camera = contents->AddComponent(SCENE_SCHEMA_CAMERA, contents->cameras);
+		camera.flags = enabled |
+			ReadFlag(component, CAMERA_PROJECTION_MATRIX_TYPE, SCENE_FLAG_PERSPECTIVE) |
+			ReadFlag(component, CAMERA_IS_MAIN, SCENE_FLAG_MAIN_CAMERA);
+		camera.aspectRatio = (float)ReadNumber(component, CAMERA_ASPECT_RATIO, camera.aspectRatio);
+		camera.nearDistance = (float)ReadNumber(component, CAMERA_NEAR_DISTANCE, camera.nearDistance);
+		camera.farDistance = (float)ReadNumber(component, CAMERA_FAR_DISTANCE, camera.farDistance);
+		camera.fieldOfView = (float)ReadNumber(component, CAMERA_FIELD_OF_VIEW, camera.fieldOfView);
+		break;
+	}
+	case ComponentTypes::NOCLIP_CHAR_CONTROLLER: {
+		SceneFileNoclipMovement& noclip = contents->AddComponent(SCENE_SCHEMA_NOCLIP_MOVEMENT, contents->noclipMovements);
+		noclip.flags = enabled;
+		noclip.moveSpeed = (float)ReadNumber(component, NOCLIP_MOVE_SPEED, noclip.moveSpeed);
+		noclip.lookSpeed = (float)ReadNumber(component, NOCLIP_LOOK_SPEED, noclip.lookSpeed);
+		break;
+	}
+	case ComponentTypes::FLASHLIGHT_CONTROLLER: {
+		contents->AddComponent(SCENE_SCHEMA_FLASHLIGHT_CONTROLLER, contents->flashlightControllers).flags = enabled;
+		break;
+	}
+	default:
+		// Unkown Component Type, do nothing
+		break;
+	}
+}
+
+#pragma endregion
@@ -1,6 +1,15 @@
 #include "../Headers/SceneManager.h"
 #include "..\Headers\NoclipMovement.h"
 #include "..\Headers\FlashlightController.h"
+#include "../Headers/AsyncFileReader.h"
+#include "../Headers/MappedFile.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <unordered_set>
+#include <unordered_map>
 
 SceneManager* SceneManager::instance;
 
@@ -28,122 +37,471 @@ std::exception_ptr SceneManager::GetLoadingException() {
 	return error;
 }
 
-/// <summary>
-/// Loads a Float2 stored in a JSON block
-/// </summary>
-/// <param name="jsonBlock">The block to load from</param>
-/// <param name="memberName">The key to search</param>
-/// <returns>Float2 populated from the given array type</returns>
-DirectX::XMFLOAT2 SceneManager::LoadFloat2(const rapidjson::Value& jsonBlock, const char* memberName)
-{
-	const rapidjson::Value& vecBlock = jsonBlock.FindMember(memberName)->value;
-	return DirectX::XMFLOAT2(vecBlock[0].GetDouble(),
-		vecBlock[1].GetDouble());
+namespace {
+	/// <summary>
+	/// Gets an asset by its index in the scene, or null for an index that
+	/// wasn't found when the scene was saved
+	/// </summary>
+	template <typename T>
+	T GetAtIndex(const std::vector<T>& assets, int32_t index) {
+		if (index < 0 || (size_t)index >= assets.size()) return T();
+		return assets[index];
+	}
+
+	/// <summary>
+	/// Gets an asset's index by pointer, which is how scenes reference assets
+	/// </summary>
+	/// <returns>SCENE_FILE_NO_INDEX if it isn't in the first count assets</returns>
+	template <typename T, typename U>
+	int32_t FindIndex(const std::vector<T>& assets, const U& asset, size_t count) {
+		count = (std::min)(count, assets.size());
+		for (size_t i = 0; i < count; i++) {
+			if (assets[i] == asset) return (int32_t)i;
+		}
+		return SCENE_FILE_NO_INDEX;
+	}
+
+	/// <summary>
+	/// Maps the first count assets onto their index. Where an asset is in
+	/// the list twice, it maps onto the first, like FindIndex finds.
+	/// </summary>
+	template <typename T>
+	void MapIndices(const std::vector<T>& assets, size_t count, std::unordered_map<const void*, int32_t>* indices) {
+		count = (std::min)(count, assets.size());
+		indices->reserve(count);
+		for (size_t i = 0; i < count; i++) {
+			indices->emplace(assets[i].get(), (int32_t)i);
+		}
+	}
+
+	/// <returns>SCENE_FILE_NO_INDEX if the asset wasn't mapped</returns>
+	int32_t LookUpIndex(const std::unordered_map<const void*, int32_t>& indices, const void* asset) {
+		auto found = indices.find(asset);
+		return found == indices.end() ? SCENE_FILE_NO_INDEX : found->second;
+	}
+
+	/// <summary>
+	/// Records assets without keeping them loaded
+	/// </summary>
+	template <typename T>
+	void CaptureWeak(const std::vector<std::shared_ptr<T>>& assets, std::vector<std::weak_ptr<T>>* captured) {
+		captured->assign(assets.begin(), assets.end());
+	}
+
+	/// <summary>
+	/// Checks that each recorded asset is still loaded and at the same index
+	/// </summary>
+	template <typename T>
+	bool WeakMatch(const std::vector<std::weak_ptr<T>>& captured, const std::vector<std::shared_ptr<T>>& assets) {
+		if (captured.size() != assets.size()) return false;
+
+		for (size_t i = 0; i < assets.size(); i++) {
+			if (captured[i].lock() != assets[i]) return false;
+		}
+		return true;
+	}
+
+	void CopyFloat3(float* values, DirectX::XMFLOAT3 vec) {
+		values[0] = vec.x;
+		values[1] = vec.y;
+		values[2] = vec.z;
+	}
+
+	void CopyFloat4(float* values, DirectX::XMFLOAT4 vec) {
+		values[0] = vec.x;
+		values[1] = vec.y;
+		values[2] = vec.z;
+		values[3] = vec.w;
+	}
+
+	double GetSeconds() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
 }
 
 /// <summary>
-/// Loads a Float3 stored in a JSON block
+/// Stores floats as a float array in JSON
 /// </summary>
-/// <param name="jsonBlock">The block to load from</param>
-/// <param name="memberName">The key to search</param>
-/// <returns>Float3 populated from the given array type</returns>
-DirectX::XMFLOAT3 SceneManager::LoadFloat3(const rapidjson::Value& jsonBlock, const char* memberName)
+/// <param name="jsonObject">The JSON object to store the data into</param>
+/// <param name="memberName">The key to store the data array under</param>
+/// <param name="values">The floats to store</param>
+/// <param name="count">How many floats to store</param>
+/// <param name="sceneDoc">The document the JSON is going into</param>
+void SceneManager::SaveFloats(rapidjson::Value& jsonObject, const char* memberName, const float* values, int count, rapidjson::Document& sceneDoc)
 {
-	const rapidjson::Value& vecBlock = jsonBlock.FindMember(memberName)->value;
-	return DirectX::XMFLOAT3(vecBlock[0].GetDouble(), 
-		vecBlock[1].GetDouble(), 
-		vecBlock[2].GetDouble());
+	rapidjson::Value floats(rapidjson::kArrayType);
+	for (int i = 0; i < count; i++) {
+		floats.PushBack(values[i], sceneDoc.GetAllocator());
+	}
+
+	jsonObject.AddMember(rapidjson::StringRef(memberName),
+		floats,
+		sceneDoc.GetAllocator());
 }
 
 /// <summary>
-/// Loads a Float3 stored in a JSON block
+/// Stores a string from the scene's string table in JSON
 /// </summary>
-/// <param name="jsonBlock">The block to load from</param>
-/// <param name="memberName">The key to search</param>
-/// <returns>Float3 populated from the given array type</returns>
-DirectX::XMFLOAT4 SceneManager::LoadFloat4(const rapidjson::Value& jsonBlock, const char* memberName)
+/// <param name="jsonObject">The JSON object to store the data into</param>
+/// <param name="memberName">The key to store the string under</param>
+/// <param name="index">Index of the string in the table</param>
+/// <param name="contents">Scene holding the string table</param>
+/// <param name="sceneDoc">The document the JSON is going into</param>
+void SceneManager::SaveStringIndex(rapidjson::Value& jsonObject, const char* memberName, uint32_t index, const SceneFileContents& contents, rapidjson::Document& sceneDoc)
 {
-	const rapidjson::Value& vecBlock = jsonBlock.FindMember(memberName)->value;
-	return DirectX::XMFLOAT4(vecBlock[0].GetDouble(),
-		vecBlock[1].GetDouble(),
-		vecBlock[2].GetDouble(),
-		vecBlock[3].GetDouble());
+	const std::string& text = contents.GetString(index);
+	jsonObject.AddMember(rapidjson::StringRef(memberName),
+		rapidjson::Value().SetString(text.c_str(), (rapidjson::SizeType)text.size(), sceneDoc.GetAllocator()),
+		sceneDoc.GetAllocator());
 }
 
 /// <summary>
-/// Stores a Float2 as a float array in JSON
+/// Stores an asset index in JSON, as null if there isn't one
 /// </summary>
 /// <param name="jsonObject">The JSON object to store the data into</param>
-/// <param name="memberName">The key to store the data array under</param>
-/// <param name="vec">The Float2 to store</param>
+/// <param name="memberName">The key to store the index under</param>
+/// <param name="index">The index to store</param>
 /// <param name="sceneDoc">The document the JSON is going into</param>
-void SceneManager::SaveFloat2(rapidjson::Value& jsonObject, const char* memberName, DirectX::XMFLOAT2 vec, rapidjson::Document& sceneDoc)
+void SceneManager::SaveIndex(rapidjson::Value& jsonObject, const char* memberName, int32_t index, rapidjson::Document& sceneDoc)
 {
-	rapidjson::Value float2(rapidjson::kArrayType);
-	float2.PushBack(vec.x, sceneDoc.GetAllocator());
-	float2.PushBack(vec.y, sceneDoc.GetAllocator());
+	rapidjson::Value indexValue;
+	if (index != SCENE_FILE_NO_INDEX) indexValue.SetInt(index);
 
-	jsonObject.AddMember(rapidjson::StringRef(memberName),
-		float2,
-		sceneDoc.GetAllocator());
+	jsonObject.AddMember(rapidjson::StringRef(memberName), indexValue, sceneDoc.GetAllocator());
 }
 
 /// <summary>
-/// Stores a Float3 as a float array in JSON
+/// Stores one of a record's flags as a bool in JSON
 /// </summary>
 /// <param name="jsonObject">The JSON object to store the data into</param>
-/// <param name="memberName">The key to store the data array under</param>
-/// <param name="vec">The Float3 to store</param>
+/// <param name="memberName">The key to store the bool under</param>
+/// <param name="flags">The record's flags</param>
+/// <param name="flag">The flag to store</param>
 /// <param name="sceneDoc">The document the JSON is going into</param>
-void SceneManager::SaveFloat3(rapidjson::Value& jsonObject, const char* memberName, DirectX::XMFLOAT3 vec, rapidjson::Document& sceneDoc)
+void SceneManager::SaveFlag(rapidjson::Value& jsonObject, const char* memberName, uint32_t flags, uint32_t flag, rapidjson::Document& sceneDoc)
 {
-	rapidjson::Value float3(rapidjson::kArrayType);
-	float3.PushBack(vec.x, sceneDoc.GetAllocator());
-	float3.PushBack(vec.y, sceneDoc.GetAllocator());
-	float3.PushBack(vec.z, sceneDoc.GetAllocator());
+	jsonObject.AddMember(rapidjson::StringRef(memberName), (flags & flag) != 0, sceneDoc.GetAllocator());
+}
 
-	jsonObject.AddMember(rapidjson::StringRef(memberName), 
-		float3, 
-		sceneDoc.GetAllocator());
+/// <summary>
+/// Deserializes a file name in the scene's string table
+/// </summary>
+/// <param name="contents">Scene holding the string table</param>
+/// <param name="index">Index of the file name to deserialize</param>
+/// <returns>The deserialized file name</returns>
+std::string SceneManager::LoadDeserializedFileName(const SceneFileContents& contents, uint32_t index)
+{
+	return assetManager.DeSerializeFileName(contents.GetString(index));
 }
 
 /// <summary>
-/// Stores a Float4 as a float array in JSON
+/// Writes a scene's assets as JSON
 /// </summary>
-/// <param name="jsonObject">The JSON object to store the data into</param>
-/// <param name="memberName">The key to store the data array under</param>
-/// <param name="vec">The Float4 to store</param>
-/// <param name="sceneDoc">The document the JSON is going into</param>
-void SceneManager::SaveFloat4(rapidjson::Value& jsonObject, const char* memberName, DirectX::XMFLOAT4 vec, rapidjson::Document& sceneDoc)
+/// <param name="contents">Scene to write</param>
+/// <param name="sceneDoc">JSON document to write them into</param>
+void SceneManager::WriteJsonAssets(const SceneFileContents& contents, rapidjson::Document& sceneDoc)
 {
-	rapidjson::Value float4(rapidjson::kArrayType);
-	float4.PushBack(vec.x, sceneDoc.GetAllocator());
-	float4.PushBack(vec.y, sceneDoc.GetAllocator());
-	float4.PushBack(vec.z, sceneDoc.GetAllocator());
-	float4.PushBack(vec.w, sceneDoc.GetAllocator());
+	rapidjson::MemoryPoolAllocator<>& allocator = sceneDoc.GetAllocator();
 
-	jsonObject.AddMember(rapidjson::StringRef(memberName),
-		float4,
-		sceneDoc.GetAllocator());
+	rapidjson::Value meshBlock(rapidjson::kArrayType);
+	for (const SceneFileMesh& mesh : contents.meshes) {
+		rapidjson::Value meshValue(rapidjson::kObjectType);
+
+		meshValue.AddMember(MESH_INDEX_COUNT, mesh.indexCount, allocator);
+		meshValue.AddMember(MESH_MATERIAL_INDEX, mesh.materialIndex, allocator);
+		SaveFlag(meshValue, MESH_NEEDS_DEPTH_PREPASS, mesh.flags, SCENE_FLAG_DEPTH_PREPASS, sceneDoc);
+
+		SaveStringIndex(meshValue, NAME, mesh.name, contents, sceneDoc);
+		SaveStringIndex(meshValue, FILENAME_KEY, mesh.fileNameKey, contents, sceneDoc);
+
+		meshBlock.PushBack(meshValue, allocator);
+	}
+
+	sceneDoc.AddMember(MESHES, meshBlock, allocator);
+
+	rapidjson::Value textureBlock(rapidjson::kArrayType);
+	for (const SceneFileTexture& texture : contents.textures) {
+		rapidjson::Value textureValue(rapidjson::kObjectType);
+
+		SaveStringIndex(textureValue, NAME, texture.name, contents, sceneDoc);
+		SaveStringIndex(textureValue, FILENAME_KEY, texture.fileNameKey, contents, sceneDoc);
+		textureValue.AddMember(TEXTURE_ASSET_PATH_INDEX, texture.assetPathIndex, allocator);
+
+		textureBlock.PushBack(textureValue, allocator);
+	}
+
+	sceneDoc.AddMember(TEXTURES, textureBlock, allocator);
+
+	rapidjson::Value materialBlock(rapidjson::kArrayType);
+	for (const SceneFileMaterial& material : contents.materials) {
+		rapidjson::Value matValue(rapidjson::kObjectType);
+
+		matValue.AddMember(MAT_UV_TILING, material.uvTiling, allocator);
+		SaveFlag(matValue, MAT_IS_TRANSPARENT, material.flags, SCENE_FLAG_TRANSPARENT, sceneDoc);
+		SaveFlag(matValue, MAT_IS_REFRACTIVE, material.flags, SCENE_FLAG_REFRACTIVE, sceneDoc);
+		matValue.AddMember(MAT_INDEX_OF_REFRACTION, material.indexOfRefraction, allocator);
+		matValue.AddMember(MAT_REFRACTION_SCALE, material.refractionScale, allocator);
+
+		SaveIndex(matValue, MAT_PIXEL_SHADER, material.pixelShader, sceneDoc);
+		SaveIndex(matValue, MAT_VERTEX_SHADER, material.vertexShader, sceneDoc);
+
+		SaveStringIndex(matValue, NAME, material.name, contents, sceneDoc);
+
+		// Currently, refractivePixShader also covers transparency
+		if (material.flags & (SCENE_FLAG_REFRACTIVE | SCENE_FLAG_TRANSPARENT)) {
+			SaveIndex(matValue, MAT_REFRACTION_PIXEL_SHADER, material.refractionPixelShader, sceneDoc);
+		}
+
+		SaveFloats(matValue, MAT_COLOR_TINT, material.colorTint, 4, sceneDoc);
+
+		SaveIndex(matValue, MAT_TEXTURE_SAMPLER_STATE, material.samplerState, sceneDoc);
+		SaveIndex(matValue, MAT_CLAMP_SAMPLER_STATE, material.clampSamplerState, sceneDoc);
+		SaveIndex(matValue, MAT_TEXTURE_OR_ALBEDO_MAP, material.albedoMap, sceneDoc);
+		SaveIndex(matValue, MAT_NORMAL_MAP, material.normalMap, sceneDoc);
+		SaveIndex(matValue, MAT_ROUGHNESS_MAP, material.roughnessMap, sceneDoc);
+		SaveIndex(matValue, MAT_METAL_MAP, material.metalMap, sceneDoc);
+
+		materialBlock.PushBack(matValue, allocator);
+	}
+
+	sceneDoc.AddMember(MATERIALS, materialBlock, allocator);
+
+	rapidjson::Value fontBlock(rapidjson::kArrayType);
+	for (const SceneFileFont& font : contents.fonts) {
+		rapidjson::Value fontObject(rapidjson::kObjectType);
+
+		SaveStringIndex(fontObject, FILENAME_KEY, font.fileNameKey, contents, sceneDoc);
+		SaveStringIndex(fontObject, NAME, font.name, contents, sceneDoc);
+
+		fontBlock.PushBack(fontObject, allocator);
+	}
+
+	sceneDoc.AddMember(FONTS, fontBlock, allocator);
+
+	rapidjson::Value texSampleStateBlock(rapidjson::kArrayType);
+	for (const SceneFileSampler& sampler : contents.samplers) {
+		rapidjson::Value sampleState(rapidjson::kObjectType);
+
+		sampleState.AddMember(SAMPLER_ADDRESS_U, sampler.addressU, allocator);
+		sampleState.AddMember(SAMPLER_ADDRESS_V, sampler.addressV, allocator);
+		sampleState.AddMember(SAMPLER_ADDRESS_W, sampler.addressW, allocator);
+		sampleState.AddMember(SAMPLER_COMPARISON_FUNCTION, sampler.comparisonFunction, allocator);
+		sampleState.AddMember(SAMPLER_FILTER, sampler.filter, allocator);
+		sampleState.AddMember(SAMPLER_MAX_ANISOTROPY, sampler.maxAnisotropy, allocator);
+		sampleState.AddMember(SAMPLER_MAX_LOD, sampler.maxLOD, allocator);
+		sampleState.AddMember(SAMPLER_MIN_LOD, sampler.minLOD, allocator);
+		sampleState.AddMember(SAMPLER_MIP_LOD_BIAS, sampler.mipLODBias, allocator);
+
+		SaveFloats(sampleState, SAMPLER_BORDER_COLOR, sampler.borderColor, 4, sceneDoc);
+
+		texSampleStateBlock.PushBack(sampleState, allocator);
+	}
+
+	sceneDoc.AddMember(TEXTURE_SAMPLE_STATES, texSampleStateBlock, allocator);
+
+	auto writeShaders = [&](const char* category, const std::vector<SceneFileShader>& shaders) {
+		rapidjson::Value shaderBlock(rapidjson::kArrayType);
+		for (const SceneFileShader& shader : shaders) {
+			rapidjson::Value shaderObject(rapidjson::kObjectType);
+
+			SaveStringIndex(shaderObject, NAME, shader.name, contents, sceneDoc);
+			SaveStringIndex(shaderObject, SHADER_FILE_PATH, shader.filePath, contents, sceneDoc);
+
+			shaderBlock.PushBack(shaderObject, allocator);
+		}
+
+		sceneDoc.AddMember(rapidjson::StringRef(category), shaderBlock, allocator);
+	};
+
+	writeShaders(VERTEX_SHADERS, contents.vertexShaders);
+	writeShaders(PIXEL_SHADERS, contents.pixelShaders);
+	writeShaders(COMPUTE_SHADERS, contents.computeShaders);
+
+	rapidjson::Value skyBlock(rapidjson::kArrayType);
+	for (const SceneFileSky& sky : contents.skies) {
+		rapidjson::Value skyObject(rapidjson::kObjectType);
+
+		SaveStringIndex(skyObject, NAME, sky.name, contents, sceneDoc);
+		SaveFlag(skyObject, SKY_FILENAME_KEY_TYPE, sky.flags, SCENE_FLAG_SEPARATE_SKY_FACES, sceneDoc);
+		SaveStringIndex(skyObject, FILENAME_KEY, sky.fileNameKey, contents, sceneDoc);
+		SaveStringIndex(skyObject, SKY_FILENAME_EXTENSION, sky.fileExtension, contents, sceneDoc);
+
+		skyBlock.PushBack(skyObject, allocator);
+	}
+
+	sceneDoc.AddMember(SKIES, skyBlock, allocator);
+
+	rapidjson::Value soundBlock(rapidjson::kArrayType);
+	for (const SceneFileSound& sound : contents.sounds) {
+		rapidjson::Value soundObject(rapidjson::kObjectType);
+
+		SaveStringIndex(soundObject, FILENAME_KEY, sound.fileNameKey, contents, sceneDoc);
+		SaveStringIndex(soundObject, NAME, sound.name, contents, sceneDoc);
+		soundObject.AddMember(SOUND_FMOD_MODE, sound.mode, allocator);
+
+		soundBlock.PushBack(soundObject, allocator);
+	}
+
+	sceneDoc.AddMember(SOUNDS, soundBlock, allocator);
+
+	rapidjson::Value terrainMatBlock(rapidjson::kArrayType);
+	for (const SceneFileTerrainMaterial& terrainMaterial : contents.terrainMaterials) {
+		rapidjson::Value terrainMatObj(rapidjson::kObjectType);
+
+		SaveFlag(terrainMatObj, TERRAIN_MATERIAL_BLEND_MAP_ENABLED, terrainMaterial.flags, SCENE_FLAG_BLEND_MAP, sceneDoc);
+		SaveStringIndex(terrainMatObj, NAME, terrainMaterial.name, contents, sceneDoc);
+		SaveStringIndex(terrainMatObj, TERRAIN_MATERIAL_BLEND_MAP_PATH, terrainMaterial.blendMapPath, contents, sceneDoc);
+
+		rapidjson::Value terrainInternalMats(rapidjson::kArrayType);
+		for (uint32_t i = 0; i < terrainMaterial.materialCount; i++) {
+			terrainInternalMats.PushBack(contents.indices[terrainMaterial.firstMaterial + i], allocator);
+		}
+		terrainMatObj.AddMember(TERRAIN_MATERIAL_MATERIAL_ARRAY, terrainInternalMats, allocator);
+
+		terrainMatBlock.PushBack(terrainMatObj, allocator);
+	}
+
+	sceneDoc.AddMember(TERRAIN_MATERIALS, terrainMatBlock, allocator);
 }
 
 /// <summary>
-/// Deserializes a file name in a JSON block
+/// Writes a scene's entities as JSON
 /// </summary>
-/// <param name="jsonBlock">JSON block data is in</param>
-/// <param name="memberName">Key of the value to deserialize</param>
-/// <returns>The deserialized file name</returns>
-std::string SceneManager::LoadDeserializedFileName(const rapidjson::Value& jsonBlock, const char* memberName)
+/// <param name="contents">Scene to write</param>
+/// <param name="sceneDoc">JSON document to write them into</param>
+void SceneManager::WriteJsonEntities(const SceneFileContents& contents, rapidjson::Document& sceneDoc)
 {
-	return assetManager.DeSerializeFileName(jsonBlock.FindMember(memberName)->value.GetString());
+	rapidjson::MemoryPoolAllocator<>& allocator = sceneDoc.GetAllocator();
+
+	rapidjson::Value gameEntityBlock(rapidjson::kArrayType);
+	for (const SceneFileEntity& entity : contents.entities) {
+		rapidjson::Value geValue(rapidjson::kObjectType);
+
+		SaveStringIndex(geValue, NAME, entity.name, contents, sceneDoc);
+		SaveFlag(geValue, ENABLED, entity.flags, SCENE_FLAG_ENABLED, sceneDoc);
+
+		rapidjson::Value geComponents(rapidjson::kArrayType);
+		for (uint32_t c = entity.firstComponent; c < entity.firstComponent + entity.componentCount; c++) {
+			const SceneFileComponent& component = contents.components[c];
+			rapidjson::Value coValue(rapidjson::kObjectType);
+
+			switch (component.schema) {
+			case SCENE_SCHEMA_LIGHT: {
+				const SceneFileLight& light = contents.lights[component.index];
+				SaveFlag(coValue, ENABLED, light.flags, SCENE_FLAG_ENABLED, sceneDoc);
+				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::LIGHT, allocator);
+
+				coValue.AddMember(LIGHT_TYPE, light.type, allocator);
+				coValue.AddMember(LIGHT_INTENSITY, light.intensity, allocator);
+				coValue.AddMember(LIGHT_RANGE, light.range, allocator);
+				SaveFlag(coValue, LIGHT_CASTS_SHADOWS, light.flags, SCENE_FLAG_CASTS_SHADOWS, sceneDoc);
+
+				SaveFloats(coValue, LIGHT_COLOR, light.color, 3, sceneDoc);
+				break;
+			}
+			case SCENE_SCHEMA_COLLIDER: {
+				const SceneFileCollider& collider = contents.colliders[component.index];
+				SaveFlag(coValue, ENABLED, collider.flags, SCENE_FLAG_ENABLED, sceneDoc);
+				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::COLLIDER, allocator);
+
+				SaveFlag(coValue, COLLIDER_TYPE, collider.flags, SCENE_FLAG_TRIGGER, sceneDoc);
+				SaveFlag(coValue, COLLIDER_IS_VISIBLE, collider.flags, SCENE_FLAG_VISIBLE, sceneDoc);
+
+				SaveFloats(coValue, COLLIDER_POSITION_OFFSET, collider.positionOffset, 3, sceneDoc);
+				SaveFloats(coValue, COLLIDER_ROTATION_OFFSET, collider.rotationOffset, 3, sceneDoc);
+				SaveFloats(coValue, COLLIDER_SCALE_OFFSET, collider.scale, 3, sceneDoc);
+				break;
+			}
+			case SCENE_SCHEMA_TERRAIN: {
+				const SceneFileTerrain& terrain = contents.terrains[component.index];
+				SaveFlag(coValue, ENABLED, terrain.flags, SCENE_FLAG_ENABLED, sceneDoc);
+				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::TERRAIN, allocator);
+
+				SaveStringIndex(coValue, FILENAME_KEY, terrain.fileNameKey, contents, sceneDoc);
+				SaveIndex(coValue, TERRAIN_INDEX_OF_TERRAIN_MATERIAL, terrain.terrainMaterial, sceneDoc);
+				break;
+			}
+			case SCENE_SCHEMA_PARTICLE_SYSTEM: {
+				const SceneFileParticleSystem& ps = contents.particleSystems[component.index];
+				SaveFlag(coValue, ENABLED, ps.flags, SCENE_FLAG_ENABLED, sceneDoc);
+				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::PARTICLE_SYSTEM, allocator);
+
+				coValue.AddMember(PARTICLE_SYSTEM_MAX_PARTICLES, ps.maxParticles, allocator);
+				SaveFlag(coValue, PARTICLE_SYSTEM_IS_MULTI_PARTICLE, ps.flags, SCENE_FLAG_MULTI_PARTICLE, sceneDoc);
+				SaveFlag(coValue, PARTICLE_SYSTEM_ADDITIVE_BLEND, ps.flags, SCENE_FLAG_ADDITIVE_BLEND, sceneDoc);
+				coValue.AddMember(PARTICLE_SYSTEM_SCALE, ps.scale, allocator);
+				coValue.AddMember(PARTICLE_SYSTEM_SPEED, ps.speed, allocator);
+				coValue.AddMember(PARTICLE_SYSTEM_PARTICLES_PER_SECOND, ps.particlesPerSecond, allocator);
+				coValue.AddMember(PARTICLE_SYSTEM_PARTICLE_LIFETIME, ps.particleLifetime, allocator);
+
+				SaveFloats(coValue, PARTICLE_SYSTEM_DESTINATION, ps.destination, 3, sceneDoc);
+				SaveFloats(coValue, PARTICLE_SYSTEM_COLOR_TINT, ps.colorTint, 4, sceneDoc);
+
+				SaveStringIndex(coValue, FILENAME_KEY, ps.fileNameKey, contents, sceneDoc);
+				break;
+			}
+			case SCENE_SCHEMA_MESH_RENDERER: {
+				const SceneFileMeshRenderer& meshRenderer = contents.meshRenderers[component.index];
+				SaveFlag(coValue, ENABLED, meshRenderer.flags, SCENE_FLAG_ENABLED, sceneDoc);
+				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::MESH_RENDERER, allocator);
+
+				SaveIndex(coValue, MESH_COMPONENT_INDEX, meshRenderer.mesh, sceneDoc);
+				SaveIndex(coValue, MATERIAL_COMPONENT_INDEX, meshRenderer.material, sceneDoc);
+				break;
+			}
+			case SCENE_SCHEMA_CAMERA: {
+				const SceneFileCamera& camera = contents.cameras[component.index];
+				SaveFlag(coValue, ENABLED, camera.flags, SCENE_FLAG_ENABLED, sceneDoc);
+				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::CAMERA, allocator);
+
+				coValue.AddMember(CAMERA_ASPECT_RATIO, camera.aspectRatio, allocator);
+				SaveFlag(coValue, CAMERA_PROJECTION_MATRIX_TYPE, camera.flags, SCENE_FLAG_PERSPECTIVE, sceneDoc);
+				coValue.AddMember(CAMERA_NEAR_DISTANCE, camera.nearDistance, allocator);
+				coValue.AddMember(CAMERA_FAR_DISTANCE, camera.farDistance, allocator);
+				coValue.AddMember(CAMERA_FIELD_OF_VIEW, camera.fieldOfView, allocator);
+				SaveFlag(coValue, CAMERA_IS_MAIN, camera.flags, SCENE_FLAG_MAIN_CAMERA, sceneDoc);
+				break;
+			}
+			case SCENE_SCHEMA_NOCLIP_MOVEMENT: {
+				const SceneFileNoclipMovement& noclip = contents.noclipMovements[component.index];
+				SaveFlag(coValue, ENABLED, noclip.flags, SCENE_FLAG_ENABLED, sceneDoc);
+				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::NOCLIP_CHAR_CONTROLLER, allocator);
+
+				coValue.AddMember(NOCLIP_MOVE_SPEED, noclip.moveSpeed, allocator);
+				coValue.AddMember(NOCLIP_LOOK_SPEED, noclip.lookSpeed, allocator);
+				break;
+			}
+			case SCENE_SCHEMA_FLASHLIGHT_CONTROLLER: {
+				const SceneFileFlashlightController& flashlight = contents.flashlightControllers[component.index];
+				SaveFlag(coValue, ENABLED, flashlight.flags, SCENE_FLAG_ENABLED, sceneDoc);
+				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::FLASHLIGHT_CONTROLLER, allocator);
+				break;
+			}
+			default:
+				continue;
+			}
+
+			geComponents.PushBack(coValue, allocator);
+		}
+
+		SaveFloats(geValue, TRANSFORM_LOCAL_POSITION, entity.position, 3, sceneDoc);
+		SaveFloats(geValue, TRANSFORM_LOCAL_ROTATION, entity.rotation, 3, sceneDoc);
+		SaveFloats(geValue, TRANSFORM_LOCAL_SCALE, entity.scale, 3, sceneDoc);
+
+		geValue.AddMember(COMPONENTS, geComponents, allocator);
+
+		gameEntityBlock.PushBack(geValue, allocator);
+	}
+
+	sceneDoc.AddMember(ENTITIES, gameEntityBlock, allocator);
 }
 
 /// <summary>
 /// Loads the scene assets
 /// </summary>
-/// <param name="sceneDoc">JSON block to load from</param>
+/// <param name="contents">Scene to load from</param>
 /// <param name="progressListener">Function to call when progressing to each new object load</param>
-void SceneManager::LoadAssets(const rapidjson::Value& sceneDoc, std::function<void()> progressListener)
+void SceneManager::LoadAssets(const SceneFileContents& contents, std::function<void()> progressListener)
 {
 	// Load order:
 	// Fonts
@@ -158,37 +516,32 @@ void SceneManager::LoadAssets(const rapidjson::Value& sceneDoc, std::function<vo
 
 	// Fonts
 	currentLoadCategory = "Fonts";
-	const rapidjson::Value& fontBlock = sceneDoc[FONTS];
-	assert(fontBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < fontBlock.Size(); i++) {
-		currentLoadName = fontBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileFont& font : contents.fonts) {
+		currentLoadName = contents.GetString(font.name);
 		//if(progressListener) progressListener(); NEEDS PRE-LOADED FONTS
-		assetManager.CreateSHOEFont(currentLoadName, LoadDeserializedFileName(fontBlock[i], FILENAME_KEY));
+		assetManager.CreateSHOEFont(currentLoadName, LoadDeserializedFileName(contents, font.fileNameKey));
 	}
 
 	// Texture Sampler States
 	currentLoadCategory = "Texture Sampler States";
 	currentLoadName = "";
 	if(progressListener) progressListener();
-	const rapidjson::Value& sampleStateBlock = sceneDoc[TEXTURE_SAMPLE_STATES];
-	assert(sampleStateBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < sampleStateBlock.Size(); i++) {
+	for (const SceneFileSampler& sampler : contents.samplers) {
 		Microsoft::WRL::ComPtr<ID3D11SamplerState> loadedSampler;
 
 		D3D11_SAMPLER_DESC loadDesc;
-		loadDesc.AddressU = (D3D11_TEXTURE_ADDRESS_MODE)(sampleStateBlock[i].FindMember(SAMPLER_ADDRESS_U)->value.GetInt());
-		loadDesc.AddressV = (D3D11_TEXTURE_ADDRESS_MODE)(sampleStateBlock[i].FindMember(SAMPLER_ADDRESS_V)->value.GetInt());
-		loadDesc.AddressW = (D3D11_TEXTURE_ADDRESS_MODE)(sampleStateBlock[i].FindMember(SAMPLER_ADDRESS_W)->value.GetInt());
-		loadDesc.Filter = (D3D11_FILTER)(sampleStateBlock[i].FindMember(SAMPLER_FILTER)->value.GetInt());
-		loadDesc.MaxAnisotropy = sampleStateBlock[i].FindMember(SAMPLER_MAX_ANISOTROPY)->value.GetInt();
-		loadDesc.MinLOD = sampleStateBlock[i].FindMember(SAMPLER_MIN_LOD)->value.GetDouble();
-		loadDesc.MaxLOD = sampleStateBlock[i].FindMember(SAMPLER_MAX_LOD)->value.GetDouble();
-		loadDesc.MipLODBias = sampleStateBlock[i].FindMember(SAMPLER_MIP_LOD_BIAS)->value.GetDouble();
-		loadDesc.ComparisonFunc = (D3D11_COMPARISON_FUNC)(sampleStateBlock[i].FindMember(SAMPLER_COMPARISON_FUNCTION)->value.GetInt());
-
-		const rapidjson::Value& borderColorBlock = sampleStateBlock[i].FindMember(SAMPLER_BORDER_COLOR)->value;
+		loadDesc.AddressU = (D3D11_TEXTURE_ADDRESS_MODE)sampler.addressU;
+		loadDesc.AddressV = (D3D11_TEXTURE_ADDRESS_MODE)sampler.addressV;
+		loadDesc.AddressW = (D3D11_TEXTURE_ADDRESS_MODE)sampler.addressW;
+		loadDesc.Filter = (D3D11_FILTER)sampler.filter;
+		loadDesc.MaxAnisotropy = sampler.maxAnisotropy;
+		loadDesc.MinLOD = sampler.minLOD;
+		loadDesc.MaxLOD = sampler.maxLOD;
+		loadDesc.MipLODBias = sampler.mipLODBias;
+		loadDesc.ComparisonFunc = (D3D11_COMPARISON_FUNC)sampler.comparisonFunction;
+
 		for (int j = 0; j < 4; j++) {
-			loadDesc.BorderColor[j] = borderColorBlock[j].GetDouble();
+			loadDesc.BorderColor[j] = sampler.borderColor[j];
 		}
 
 		assetManager.device->CreateSamplerState(&loadDesc, &loadedSampler);
@@ -201,119 +554,103 @@ void SceneManager::LoadAssets(const rapidjson::Value& sceneDoc, std::function<vo
 
 	// Pixel Shaders
 	currentLoadCategory = "Pixel Shaders";
-	const rapidjson::Value& pixelShaderBlock = sceneDoc[PIXEL_SHADERS];
-	assert(pixelShaderBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < pixelShaderBlock.Size(); i++) {
-		currentLoadName = pixelShaderBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileShader& shader : contents.pixelShaders) {
+		currentLoadName = contents.GetString(shader.name);
 		if(progressListener) progressListener();
-		assetManager.CreatePixelShader(currentLoadName, LoadDeserializedFileName(pixelShaderBlock[i], SHADER_FILE_PATH));
+		assetManager.CreatePixelShader(currentLoadName, LoadDeserializedFileName(contents, shader.filePath));
 	}
 
 	// Vertex Shaders
 	currentLoadCategory = "Vertex Shaders";
-	const rapidjson::Value& vertexShaderBlock = sceneDoc[VERTEX_SHADERS];
-	assert(vertexShaderBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < vertexShaderBlock.Size(); i++) {
-		currentLoadName = vertexShaderBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileShader& shader : contents.vertexShaders) {
+		currentLoadName = contents.GetString(shader.name);
 		if(progressListener) progressListener();
-		assetManager.CreateVertexShader(currentLoadName, LoadDeserializedFileName(vertexShaderBlock[i], SHADER_FILE_PATH));
+		assetManager.CreateVertexShader(currentLoadName, LoadDeserializedFileName(contents, shader.filePath));
 	}
 
 	// Compute Shaders
 	currentLoadCategory = "Compute Shaders";
-	const rapidjson::Value& computeShaderBlock = sceneDoc[COMPUTE_SHADERS];
-	assert(computeShaderBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < computeShaderBlock.Size(); i++) {
-		currentLoadName = computeShaderBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileShader& shader : contents.computeShaders) {
+		currentLoadName = contents.GetString(shader.name);
 		if(progressListener) progressListener();
-		assetManager.CreateComputeShader(currentLoadName, LoadDeserializedFileName(computeShaderBlock[i], SHADER_FILE_PATH));
+		assetManager.CreateComputeShader(currentLoadName, LoadDeserializedFileName(contents, shader.filePath));
 	}
 
 	currentLoadCategory = "Textures";
-	const rapidjson::Value& textureBlock = sceneDoc[TEXTURES];
-	assert(textureBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < textureBlock.Size(); i++) {
-		currentLoadName = textureBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileTexture& texture : contents.textures) {
+		currentLoadName = contents.GetString(texture.name);
 		if (progressListener) progressListener();
 
 		// Textures require a check to determine which valid texture folder
 		// they're in.
-		AssetPathIndex assetPath;
-		assetPath = (AssetPathIndex)(textureBlock[i].FindMember(TEXTURE_ASSET_PATH_INDEX)->value.GetInt());
-		assetManager.CreateTexture(LoadDeserializedFileName(textureBlock[i], FILENAME_KEY), currentLoadName, assetPath);
+		AssetPathIndex assetPath = (AssetPathIndex)texture.assetPathIndex;
+		assetManager.CreateTexture(LoadDeserializedFileName(contents, texture.fileNameKey), currentLoadName, assetPath);
 	}
 
 	currentLoadCategory = "Materials";
-	const rapidjson::Value& materialBlock = sceneDoc[MATERIALS];
-	assert(materialBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < materialBlock.Size(); i++) {
-		currentLoadName = LoadDeserializedFileName(materialBlock[i], NAME);
+	for (const SceneFileMaterial& material : contents.materials) {
+		currentLoadName = LoadDeserializedFileName(contents, material.name);
 		if(progressListener) progressListener();
 
 		std::shared_ptr<Material> newMaterial = assetManager.CreatePBRMaterial(
 			currentLoadName,
-			assetManager.globalTextures[materialBlock[i].FindMember(MAT_TEXTURE_OR_ALBEDO_MAP)->value.GetInt()],
-			assetManager.globalTextures[materialBlock[i].FindMember(MAT_NORMAL_MAP)->value.GetInt()], 
-			assetManager.globalTextures[materialBlock[i].FindMember(MAT_METAL_MAP)->value.GetInt()],
-			assetManager.globalTextures[materialBlock[i].FindMember(MAT_ROUGHNESS_MAP)->value.GetInt()]);
+			GetAtIndex(assetManager.globalTextures, material.albedoMap),
+			GetAtIndex(assetManager.globalTextures, material.normalMap),
+			GetAtIndex(assetManager.globalTextures, material.metalMap),
+			GetAtIndex(assetManager.globalTextures, material.roughnessMap));
 
-		newMaterial->SetTransparent(materialBlock[i].FindMember(MAT_IS_TRANSPARENT)->value.GetBool());
+		newMaterial->SetTransparent((material.flags & SCENE_FLAG_TRANSPARENT) != 0);
 
-		newMaterial->SetRefractive(materialBlock[i].FindMember(MAT_IS_REFRACTIVE)->value.GetBool());
+		newMaterial->SetRefractive((material.flags & SCENE_FLAG_REFRACTIVE) != 0);
 
-		newMaterial->SetTiling(materialBlock[i].FindMember(MAT_UV_TILING)->value.GetDouble());
+		newMaterial->SetTiling(material.uvTiling);
 
-		newMaterial->SetIndexOfRefraction(materialBlock[i].FindMember(MAT_INDEX_OF_REFRACTION)->value.GetDouble());
+		newMaterial->SetIndexOfRefraction(material.indexOfRefraction);
 
-		newMaterial->SetRefractionScale(materialBlock[i].FindMember(MAT_REFRACTION_SCALE)->value.GetDouble());
+		newMaterial->SetRefractionScale(material.refractionScale);
 
-		newMaterial->SetSamplerState(assetManager.textureSampleStates[materialBlock[i].FindMember(MAT_TEXTURE_SAMPLER_STATE)->value.GetInt()]);
+		newMaterial->SetSamplerState(GetAtIndex(assetManager.textureSampleStates, material.samplerState));
 
-		newMaterial->SetClampSamplerState(assetManager.textureSampleStates[materialBlock[i].FindMember(MAT_CLAMP_SAMPLER_STATE)->value.GetInt()]);
+		newMaterial->SetClampSamplerState(GetAtIndex(assetManager.textureSampleStates, material.clampSamplerState));
 
-		newMaterial->SetVertexShader(assetManager.GetVertexShaderAtID(materialBlock[i].FindMember(MAT_VERTEX_SHADER)->value.GetInt()));
+		newMaterial->SetVertexShader(GetAtIndex(assetManager.vertexShaders, material.vertexShader));
 
-		newMaterial->SetPixelShader(assetManager.GetPixelShaderAtID(materialBlock[i].FindMember(MAT_PIXEL_SHADER)->value.GetInt()));
+		newMaterial->SetPixelShader(GetAtIndex(assetManager.pixelShaders, material.pixelShader));
 
 		if (newMaterial->GetRefractive() || newMaterial->GetTransparent()) {
-			int index = materialBlock[i].FindMember(MAT_REFRACTION_PIXEL_SHADER)->value.GetInt();
-			newMaterial->SetRefractivePixelShader(assetManager.GetPixelShaderAtID(index));
+			newMaterial->SetRefractivePixelShader(GetAtIndex(assetManager.pixelShaders, material.refractionPixelShader));
 		}
 
-		newMaterial->SetTint(LoadFloat4(materialBlock[i], MAT_COLOR_TINT));
+		newMaterial->SetTint(DirectX::XMFLOAT4(material.colorTint));
 	}
 
 	currentLoadCategory = "Meshes";
-	const rapidjson::Value& meshBlock = sceneDoc[MESHES];
-	for (rapidjson::SizeType i = 0; i < meshBlock.Size(); i++) {
-		currentLoadName = meshBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileMesh& mesh : contents.meshes) {
+		currentLoadName = contents.GetString(mesh.name);
 		if(progressListener) progressListener();
 
-		std::shared_ptr<Mesh> newMesh = assetManager.CreateMesh(currentLoadName, LoadDeserializedFileName(meshBlock[i], FILENAME_KEY));
-		newMesh->SetDepthPrePass(meshBlock[i].FindMember(MESH_NEEDS_DEPTH_PREPASS)->value.GetBool());
-		newMesh->SetMaterialIndex(meshBlock[i].FindMember(MESH_MATERIAL_INDEX)->value.GetInt());
+		std::shared_ptr<Mesh> newMesh = assetManager.CreateMesh(currentLoadName, LoadDeserializedFileName(contents, mesh.fileNameKey));
+		newMesh->SetDepthPrePass((mesh.flags & SCENE_FLAG_DEPTH_PREPASS) != 0);
+		newMesh->SetMaterialIndex(mesh.materialIndex);
 
 		// This is currently generated automatically. Would need to change
 		// if storing meshes built through code arrays becomes supported.
-		// newMesh->SetIndexCount(meshBlock[i].FindMember(MESH_INDEX_COUNT)->value.GetInt());
+		// newMesh->SetIndexCount(mesh.indexCount);
 	}
 
 	currentLoadCategory = "Terrain Materials";
-	const rapidjson::Value& terrainMaterialBlock = sceneDoc[TERRAIN_MATERIALS];
-	assert(terrainMaterialBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < terrainMaterialBlock.Size(); i++) {
-		const rapidjson::Value& tMatInternalBlock = terrainMaterialBlock[i].FindMember(TERRAIN_MATERIAL_MATERIAL_ARRAY)->value;
-		currentLoadName = terrainMaterialBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileTerrainMaterial& terrainMaterial : contents.terrainMaterials) {
+		currentLoadName = contents.GetString(terrainMaterial.name);
 		if(progressListener) progressListener();
 
 		std::vector<std::shared_ptr<Material>> internalMaterials;
-		for (rapidjson::SizeType j = 0; j < tMatInternalBlock.Size(); j++) {
+		for (uint32_t j = 0; j < terrainMaterial.materialCount; j++) {
 			// Material texture strings are being incorrectly serialized/loaded
-			internalMaterials.push_back(assetManager.GetMaterialAtID(tMatInternalBlock[j].GetInt()));
+			internalMaterials.push_back(assetManager.GetMaterialAtID(contents.indices[terrainMaterial.firstMaterial + j]));
 		}
 
-		if (terrainMaterialBlock[i].FindMember(TERRAIN_MATERIAL_BLEND_MAP_ENABLED)->value.GetBool()) {
-			std::shared_ptr<TerrainMaterial> newTMat = assetManager.CreateTerrainMaterial(currentLoadName, internalMaterials, LoadDeserializedFileName(terrainMaterialBlock[i], TERRAIN_MATERIAL_BLEND_MAP_PATH));
+		if (terrainMaterial.flags & SCENE_FLAG_BLEND_MAP) {
+			std::shared_ptr<TerrainMaterial> newTMat = assetManager.CreateTerrainMaterial(currentLoadName, internalMaterials, LoadDeserializedFileName(contents, terrainMaterial.blendMapPath));
 		}
 		else {
 			std::shared_ptr<TerrainMaterial> newTMat = assetManager.CreateTerrainMaterial(currentLoadName, internalMaterials);
@@ -321,152 +658,167 @@ void SceneManager::LoadAssets(const rapidjson::Value& sceneDoc, std::function<vo
 	}
 
 	currentLoadCategory = "Skies";
-	const rapidjson::Value& skyBlock = sceneDoc[SKIES];
-	assert(skyBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < skyBlock.Size(); i++) {
-		currentLoadName = skyBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileSky& sky : contents.skies) {
+		currentLoadName = contents.GetString(sky.name);
 		if(progressListener) progressListener();
-		bool keyType = skyBlock[i].FindMember(SKY_FILENAME_KEY_TYPE)->value.GetBool();
-		std::string fileExt = keyType ? skyBlock[i].FindMember(SKY_FILENAME_EXTENSION)->value.GetString() : ".png";
-		assetManager.CreateSky(LoadDeserializedFileName(skyBlock[i], FILENAME_KEY), keyType, currentLoadName, fileExt);
+		bool keyType = (sky.flags & SCENE_FLAG_SEPARATE_SKY_FACES) != 0;
+		std::string fileExt = keyType ? contents.GetString(sky.fileExtension) : ".png";
+		assetManager.CreateSky(LoadDeserializedFileName(contents, sky.fileNameKey), keyType, currentLoadName, fileExt);
 	}
 
 	currentLoadCategory = "Sounds";
-	const rapidjson::Value& soundBlock = sceneDoc[SOUNDS];
-	assert(soundBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < soundBlock.Size(); i++) {
-		currentLoadName = soundBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileSound& sound : contents.sounds) {
+		currentLoadName = contents.GetString(sound.name);
 		if(progressListener) progressListener();
-		int mode = soundBlock[i].FindMember(SOUND_FMOD_MODE)->value.GetInt();
-		FMOD::Sound* newSound = assetManager.CreateSound(LoadDeserializedFileName(soundBlock[i], FILENAME_KEY), mode, currentLoadName);
+		FMOD::Sound* newSound = assetManager.CreateSound(LoadDeserializedFileName(contents, sound.fileNameKey), sound.mode, currentLoadName);
 	}
 }
 
 /// <summary>
 /// Loads the scene entities
 /// </summary>
-/// <param name="sceneDoc">JSON block to load from</param>
+/// <param name="contents">Scene to load from</param>
 /// <param name="progressListener">Function to call when progressing to each new entity load</param>
-void SceneManager::LoadEntities(const rapidjson::Value& sceneDoc, std::function<void()> progressListener)
+void SceneManager::LoadEntities(const SceneFileContents& contents, std::function<void()> progressListener)
 {
 	currentLoadCategory = "Entities";
-	const rapidjson::Value& entityBlock = sceneDoc[ENTITIES];
-	assert(entityBlock.IsArray());
-	for (rapidjson::SizeType i = 0; i < entityBlock.Size(); i++) {
-		currentLoadName = entityBlock[i].FindMember(NAME)->value.GetString();
+	for (const SceneFileEntity& entity : contents.entities) {
+		currentLoadName = contents.GetString(entity.name);
 		if(progressListener) progressListener();
 
-		std::shared_ptr<GameEntity> newEnt = assetManager.CreateGameEntity(currentLoadName);
-		newEnt->SetEnabled(entityBlock[i].FindMember(ENABLED)->value.GetBool());
+		LoadEntity(contents, entity);
+	}
+}
+
+/// <summary>
+/// Loads one scene entity and its components. Every asset it
+/// references must already be loaded.
+/// </summary>
+/// <param name="contents">Scene to load from</param>
+/// <param name="entity">The entity to load</param>
+/// <returns>The new entity</returns>
+std::shared_ptr<GameEntity> SceneManager::LoadEntity(const SceneFileContents& contents, const SceneFileEntity& entity)
+{
+	std::shared_ptr<GameEntity> newEnt = assetManager.CreateGameEntity(contents.GetString(entity.name));
+	newEnt->SetEnabled((entity.flags & SCENE_FLAG_ENABLED) != 0);
+
+	newEnt->GetTransform()->SetPosition(DirectX::XMFLOAT3(entity.position));
+	newEnt->GetTransform()->SetRotation(DirectX::XMFLOAT3(entity.rotation));
+	newEnt->GetTransform()->SetScale(DirectX::XMFLOAT3(entity.scale));
 
-		newEnt->GetTransform()->SetPosition(LoadFloat3(entityBlock[i], TRANSFORM_LOCAL_POSITION));
-		newEnt->GetTransform()->SetRotation(LoadFloat3(entityBlock[i], TRANSFORM_LOCAL_ROTATION));
-		newEnt->GetTransform()->SetScale(LoadFloat3(entityBlock[i], TRANSFORM_LOCAL_SCALE));
+	for (uint32_t c = entity.firstComponent; c < entity.firstComponent + entity.componentCount; c++) {
+		LoadComponent(contents, newEnt, contents.components[c]);
+	}
 
-		const rapidjson::Value& componentBlock = entityBlock[i].FindMember(COMPONENTS)->value;
-		assert(componentBlock.IsArray());
-		for (rapidjson::SizeType i = 0; i < componentBlock.Size(); i++) {
-			int componentType = componentBlock[i].FindMember(COMPONENT_TYPE)->value.GetInt();
-			if (componentType == ComponentTypes::COLLIDER) {
-				std::shared_ptr<Collider> collider = newEnt->AddComponent<Collider>();
+	return newEnt;
+}
 
-				collider->SetEnabled(componentBlock[i].FindMember(ENABLED)->value.GetBool());
-				collider->SetVisible(componentBlock[i].FindMember(COLLIDER_IS_VISIBLE)->value.GetBool());
-				collider->SetIsTrigger(componentBlock[i].FindMember(COLLIDER_TYPE)->value.GetBool());
+/// <summary>
+/// Adds one scene component to an entity
+/// </summary>
+/// <param name="contents">Scene to load from</param>
+/// <param name="entity">The entity to add it to</param>
+/// <param name="component">The component to load</param>
+void SceneManager::LoadComponent(const SceneFileContents& contents, std::shared_ptr<GameEntity> entity, const SceneFileComponent& component)
+{
+	if (component.schema == SCENE_SCHEMA_COLLIDER) {
+		const SceneFileCollider& record = contents.colliders[component.index];
+		std::shared_ptr<Collider> collider = entity->AddComponent<Collider>();
 
-				collider->SetPositionOffset(LoadFloat3(componentBlock[i], COLLIDER_POSITION_OFFSET));
-				collider->SetRotationOffset(LoadFloat3(componentBlock[i], COLLIDER_ROTATION_OFFSET));
-				collider->SetScale(LoadFloat3(componentBlock[i], COLLIDER_SCALE_OFFSET));
-			}
-			else if (componentType == ComponentTypes::TERRAIN) {
-				std::shared_ptr<TerrainMaterial> tMat = assetManager.GetTerrainMaterialAtID(componentBlock[i].FindMember(TERRAIN_INDEX_OF_TERRAIN_MATERIAL)->value.GetInt());
+		collider->SetEnabled((record.flags & SCENE_FLAG_ENABLED) != 0);
+		collider->SetVisible((record.flags & SCENE_FLAG_VISIBLE) != 0);
+		collider->SetIsTrigger((record.flags & SCENE_FLAG_TRIGGER) != 0);
 
-				assetManager.CreateTerrainOnEntity(newEnt, LoadDeserializedFileName(componentBlock[i], FILENAME_KEY).c_str(), tMat)->SetEnabled(componentBlock[i].FindMember(ENABLED)->value.GetBool());
-			}
-			else if (componentType == ComponentTypes::PARTICLE_SYSTEM) {
-				std::string filename = LoadDeserializedFileName(componentBlock[i], FILENAME_KEY);
-				int maxParticles = componentBlock[i].FindMember(PARTICLE_SYSTEM_MAX_PARTICLES)->value.GetInt();
-				bool blendState = componentBlock[i].FindMember(PARTICLE_SYSTEM_ADDITIVE_BLEND)->value.GetBool();
-				bool isMultiParticle = componentBlock[i].FindMember(PARTICLE_SYSTEM_IS_MULTI_PARTICLE)->value.GetBool();
-				float particlesPerSecond = componentBlock[i].FindMember(PARTICLE_SYSTEM_PARTICLES_PER_SECOND)->value.GetDouble();
-				float particleLifetime = componentBlock[i].FindMember(PARTICLE_SYSTEM_PARTICLE_LIFETIME)->value.GetDouble();
+		collider->SetPositionOffset(DirectX::XMFLOAT3(record.positionOffset));
+		collider->SetRotationOffset(DirectX::XMFLOAT3(record.rotationOffset));
+		collider->SetScale(DirectX::XMFLOAT3(record.scale));
+	}
+	else if (component.schema == SCENE_SCHEMA_TERRAIN) {
+		const SceneFileTerrain& record = contents.terrains[component.index];
+		std::shared_ptr<TerrainMaterial> tMat = GetAtIndex(assetManager.globalTerrainMaterials, record.terrainMaterial);
 
-				std::shared_ptr<ParticleSystem> newParticles = assetManager.CreateParticleEmitterOnEntity(newEnt, filename, maxParticles, particleLifetime, particlesPerSecond, isMultiParticle, blendState);
+		assetManager.CreateTerrainOnEntity(entity, LoadDeserializedFileName(contents, record.fileNameKey).c_str(), tMat)->SetEnabled((record.flags & SCENE_FLAG_ENABLED) != 0);
+	}
+	else if (component.schema == SCENE_SCHEMA_PARTICLE_SYSTEM) {
+		const SceneFileParticleSystem& record = contents.particleSystems[component.index];
+		std::string filename = LoadDeserializedFileName(contents, record.fileNameKey);
+		bool blendState = (record.flags & SCENE_FLAG_ADDITIVE_BLEND) != 0;
+		bool isMultiParticle = (record.flags & SCENE_FLAG_MULTI_PARTICLE) != 0;
 
-				newParticles->SetScale(componentBlock[i].FindMember(PARTICLE_SYSTEM_SCALE)->value.GetDouble());
-				newParticles->SetSpeed(componentBlock[i].FindMember(PARTICLE_SYSTEM_SPEED)->value.GetDouble());
-				newParticles->SetDestination(LoadFloat3(componentBlock[i], PARTICLE_SYSTEM_DESTINATION));
-				bool enabled = componentBlock[i].FindMember(ENABLED)->value.GetBool();
+		std::shared_ptr<ParticleSystem> newParticles = assetManager.CreateParticleEmitterOnEntity(entity, filename, record.maxParticles, record.particleLifetime, record.particlesPerSecond, isMultiParticle, blendState);
 
-				newParticles->SetColorTint(LoadFloat4(componentBlock[i], PARTICLE_SYSTEM_COLOR_TINT));
+		newParticles->SetScale(record.scale);
+		newParticles->SetSpeed(record.speed);
+		newParticles->SetDestination(DirectX::XMFLOAT3(record.destination));
 
-				// Particles are a bit of a mess, and need to be initially disabled for at least the first frame.
-				newParticles->SetEnabled(false);
-			}
-			else if (componentType == ComponentTypes::LIGHT) {
-				std::shared_ptr<Light> light;
+		newParticles->SetColorTint(DirectX::XMFLOAT4(record.colorTint));
 
-				float type = componentBlock[i].FindMember(LIGHT_TYPE)->value.GetDouble();
-				float intensity = componentBlock[i].FindMember(LIGHT_INTENSITY)->value.GetDouble();
-				float range = componentBlock[i].FindMember(LIGHT_RANGE)->value.GetDouble();
-				DirectX::XMFLOAT3 color = LoadFloat3(componentBlock[i], LIGHT_COLOR);
+		// Particles are a bit of a mess, and need to be initially disabled for at least the first frame.
+		newParticles->SetEnabled(false);
+	}
+	else if (component.schema == SCENE_SCHEMA_LIGHT) {
+		const SceneFileLight& record = contents.lights[component.index];
+		std::shared_ptr<Light> light;
+		DirectX::XMFLOAT3 color(record.color);
 
-				if (type == 0.0f) {
-					light = assetManager.CreateDirectionalLightOnEntity(newEnt, color, intensity);
-				}
-				else if (type == 1.0f) {
-					light = assetManager.CreatePointLightOnEntity(newEnt, range, color, intensity);
-				}
-				else if (type == 2.0f) {
-					light = assetManager.CreateSpotLightOnEntity(newEnt, range, color, intensity);
-				}
-				else {
-					// Unrecognized light type, do nothing
-				}
-				light->SetEnabled(componentBlock[i].FindMember(ENABLED)->value.GetBool());
-				light->SetCastsShadows(componentBlock[i].FindMember(LIGHT_CASTS_SHADOWS)->value.GetBool());
-			}
-			else if (componentType == ComponentTypes::MESH_RENDERER) {
-				std::shared_ptr<MeshRenderer> mRenderer = newEnt->AddComponent<MeshRenderer>();
-				mRenderer->SetMaterial(assetManager.GetMaterialAtID(componentBlock[i].FindMember(MATERIAL_COMPONENT_INDEX)->value.GetInt()));
-				mRenderer->SetMesh(assetManager.GetMeshAtID(componentBlock[i].FindMember(MESH_COMPONENT_INDEX)->value.GetInt()));
-				mRenderer->SetEnabled(componentBlock[i].FindMember(ENABLED)->value.GetBool());
-			}
-			else if (componentType == ComponentTypes::CAMERA) {
-				std::shared_ptr<Camera> loadedCam = assetManager.CreateCameraOnEntity(newEnt, componentBlock[i].FindMember(CAMERA_ASPECT_RATIO)->value.GetDouble());
-				loadedCam->SetIsPerspective(componentBlock[i].FindMember(CAMERA_PROJECTION_MATRIX_TYPE)->value.GetBool());
-				loadedCam->SetNearDist(componentBlock[i].FindMember(CAMERA_NEAR_DISTANCE)->value.GetDouble());
-				loadedCam->SetFarDist(componentBlock[i].FindMember(CAMERA_FAR_DISTANCE)->value.GetDouble());
-				loadedCam->SetFOV(componentBlock[i].FindMember(CAMERA_FIELD_OF_VIEW)->value.GetDouble());
-				if (componentBlock[i].FindMember(CAMERA_IS_MAIN)->value.GetBool())
-					assetManager.SetMainCamera(loadedCam);
-				loadedCam->SetEnabled(componentBlock[i].FindMember(ENABLED)->value.GetBool());
-			}
-			else if (componentType == ComponentTypes::NOCLIP_CHAR_CONTROLLER) {
-				std::shared_ptr<NoclipMovement> ncMovement = newEnt->AddComponent<NoclipMovement>();
-				ncMovement->moveSpeed = componentBlock[i].FindMember(NOCLIP_MOVE_SPEED)->value.GetDouble();
-				ncMovement->lookSpeed = componentBlock[i].FindMember(NOCLIP_LOOK_SPEED)->value.GetDouble();
-				ncMovement->SetEnabled(componentBlock[i].FindMember(ENABLED)->value.GetBool());
-			}
-			else if (componentType == ComponentTypes::FLASHLIGHT_CONTROLLER) {
-				newEnt->AddComponent<FlashlightController>()->SetEnabled(componentBlock[i].FindMember(ENABLED)->value.GetBool());
-			}
-			else {
-				// Unkown Component Type, do nothing
-			}
+		if (record.type == 0.0f) {
+			light = assetManager.CreateDirectionalLightOnEntity(entity, color, record.intensity);
 		}
+		else if (record.type == 1.0f) {
+			light = assetManager.CreatePointLightOnEntity(entity, record.range, color, record.intensity);
+		}
+		else if (record.type == 2.0f) {
+			light = assetManager.CreateSpotLightOnEntity(entity, record.range, color, record.intensity);
+		}
+		else {
+			// Unrecognized light type, do nothing
+			return;
+		}
+		light->SetEnabled((record.flags & SCENE_FLAG_ENABLED) != 0);
+		light->SetCastsShadows((record.flags & SCENE_FLAG_CASTS_SHADOWS) != 0);
+	}
+	else if (component.schema == SCENE_SCHEMA_MESH_RENDERER) {
+		const SceneFileMeshRenderer& record = contents.meshRenderers[component.index];
+		std::shared_ptr<MeshRenderer> mRenderer = entity->AddComponent<MeshRenderer>();
+		mRenderer->SetMaterial(GetAtIndex(assetManager.globalMaterials, record.material));
+		mRenderer->SetMesh(GetAtIndex(assetManager.globalMeshes, record.mesh));
+		mRenderer->SetEnabled((record.flags & SCENE_FLAG_ENABLED) != 0);
+	}
+	else if (component.schema == SCENE_SCHEMA_CAMERA) {
+		const SceneFileCamera& record = contents.cameras[component.index];
+		std::shared_ptr<Camera> loadedCam = assetManager.CreateCameraOnEntity(entity, record.aspectRatio);
+		loadedCam->SetIsPerspective((record.flags & SCENE_FLAG_PERSPECTIVE) != 0);
+		loadedCam->SetNearDist(record.nearDistance);
+		loadedCam->SetFarDist(record.farDistance);
+		loadedCam->SetFOV(record.fieldOfView);
+		if (record.flags & SCENE_FLAG_MAIN_CAMERA)
+			assetManager.SetMainCamera(loadedCam);
+		loadedCam->SetEnabled((record.flags & SCENE_FLAG_ENABLED) != 0);
+	}
+	else if (component.schema == SCENE_SCHEMA_NOCLIP_MOVEMENT) {
+		const SceneFileNoclipMovement& record = contents.noclipMovements[component.index];
+		std::shared_ptr<NoclipMovement> ncMovement = entity->AddComponent<NoclipMovement>();
+		ncMovement->moveSpeed = record.moveSpeed;
+		ncMovement->lookSpeed = record.lookSpeed;
+		ncMovement->SetEnabled((record.flags & SCENE_FLAG_ENABLED) != 0);
+	}
+	else if (component.schema == SCENE_SCHEMA_FLASHLIGHT_CONTROLLER) {
+		const SceneFileFlashlightController& record = contents.flashlightControllers[component.index];
+		entity->AddComponent<FlashlightController>()->SetEnabled((record.flags & SCENE_FLAG_ENABLED) != 0);
+	}
+	else {
+		// Unkown Component Type, do nothing
 	}
 }
 
 /// <summary>
-/// Saves the scene's assets
+/// Records the scene's assets
 /// </summary>
-/// <param name="sceneDocToSave">JSON document to save them into</param>
-void SceneManager::SaveAssets(rapidjson::Document& sceneDocToSave)
+/// <param name="contents">Scene to record them into</param>
+void SceneManager::CaptureAssets(SceneFileContents& contents)
 {
-	rapidjson::MemoryPoolAllocator<>& allocator = sceneDocToSave.GetAllocator();
+	contents.hasAssets = true;
 
-	rapidjson::Value meshBlock(rapidjson::kArrayType);
 	bool shouldBreak = false;
 	for (auto me : assetManager.globalMeshes) {
 		for (auto te : ComponentManager::GetAll<Terrain>()) {
@@ -474,211 +826,113 @@ void SceneManager::SaveAssets(rapidjson::Document& sceneDocToSave)
 		}
 		if (shouldBreak) break;
 
-		// Mesh
-		rapidjson::Value meshValue(rapidjson::kObjectType);
-
-		meshValue.AddMember(MESH_INDEX_COUNT, me->GetIndexCount(), allocator);
-		meshValue.AddMember(MESH_MATERIAL_INDEX, me->GetMaterialIndex(), allocator);
-		meshValue.AddMember(MESH_NEEDS_DEPTH_PREPASS, me->GetDepthPrePass(), allocator); 
-		
-		meshValue.AddMember(NAME, rapidjson::Value().SetString(me->GetName().c_str(), allocator), allocator);
-		meshValue.AddMember(FILENAME_KEY, rapidjson::Value().SetString(me->GetFileNameKey().c_str(), allocator), allocator);
-
-		meshBlock.PushBack(meshValue, allocator);
+		SceneFileMesh mesh;
+		mesh.name = contents.AddString(me->GetName());
+		mesh.fileNameKey = contents.AddString(me->GetFileNameKey());
+		mesh.flags = me->GetDepthPrePass() ? SCENE_FLAG_DEPTH_PREPASS : 0;
+		mesh.indexCount = me->GetIndexCount();
+		mesh.materialIndex = me->GetMaterialIndex();
+		contents.meshes.push_back(mesh);
 	}
 
-	sceneDocToSave.AddMember(MESHES, meshBlock, allocator);
-
-	rapidjson::Value textureBlock(rapidjson::kArrayType);
 	for (auto tex : assetManager.globalTextures) {
-		// Textures
-		rapidjson::Value textureValue(rapidjson::kObjectType);
-
-		textureValue.AddMember(NAME, rapidjson::Value().SetString(tex->GetName().c_str(), allocator), allocator);
-		textureValue.AddMember(FILENAME_KEY, rapidjson::Value().SetString(tex->GetTextureFilenameKey().c_str(), allocator), allocator);
-		textureValue.AddMember(TEXTURE_ASSET_PATH_INDEX, tex->GetAssetPathIndex(), allocator);
-
-		textureBlock.PushBack(textureValue, allocator);
+		SceneFileTexture texture;
+		texture.name = contents.AddString(tex->GetName());
+		texture.fileNameKey = contents.AddString(tex->GetTextureFilenameKey());
+		texture.assetPathIndex = tex->GetAssetPathIndex();
+		contents.textures.push_back(texture);
 	}
 
-	sceneDocToSave.AddMember(TEXTURES, textureBlock, allocator);
-
-	rapidjson::Value materialBlock(rapidjson::kArrayType);
+	size_t textureCount = assetManager.globalTextures.size();
+	size_t samplerCount = assetManager.textureSampleStates.size();
 	for (auto mat : assetManager.globalMaterials) {
-		// Material
-		rapidjson::Value matValue(rapidjson::kObjectType);
-
-		matValue.AddMember(MAT_UV_TILING, mat->GetTiling(), allocator);
-		matValue.AddMember(MAT_IS_TRANSPARENT, mat->GetTransparent(), allocator);
-		matValue.AddMember(MAT_IS_REFRACTIVE, mat->GetRefractive(), allocator);
-		matValue.AddMember(MAT_INDEX_OF_REFRACTION, mat->GetIndexOfRefraction(), allocator);
-		matValue.AddMember(MAT_REFRACTION_SCALE, mat->GetRefractionScale(), allocator);
-
-		matValue.AddMember(MAT_PIXEL_SHADER, assetManager.GetPixelShaderIDByPointer(mat->GetPixShader()), allocator);
-		matValue.AddMember(MAT_VERTEX_SHADER, assetManager.GetVertexShaderIDByPointer(mat->GetVertShader()), allocator);
-
-		matValue.AddMember(NAME, rapidjson::Value().SetString(mat->GetName().c_str(), allocator), allocator);
+		SceneFileMaterial material;
+		material.name = contents.AddString(mat->GetName());
+		material.flags = (mat->GetTransparent() ? SCENE_FLAG_TRANSPARENT : 0) |
+			(mat->GetRefractive() ? SCENE_FLAG_REFRACTIVE : 0);
+		material.uvTiling = mat->GetTiling();
+		material.indexOfRefraction = mat->GetIndexOfRefraction();
+		material.refractionScale = mat->GetRefractionScale();
+		CopyFloat4(material.colorTint, mat->GetTint());
+
+		material.pixelShader = assetManager.GetPixelShaderIDByPointer(mat->GetPixShader());
+		material.vertexShader = assetManager.GetVertexShaderIDByPointer(mat->GetVertShader());
 
 		// Currently, refractivePixShader also covers transparency
 		if (mat->GetRefractive() || mat->GetTransparent()) {
-			matValue.AddMember(MAT_REFRACTION_PIXEL_SHADER, assetManager.GetPixelShaderIDByPointer(mat->GetRefractivePixelShader()), allocator);
+			material.refractionPixelShader = assetManager.GetPixelShaderIDByPointer(mat->GetRefractivePixelShader());
 		}
 
-		SaveFloat4(matValue, MAT_COLOR_TINT, mat->GetTint(), sceneDocToSave);
+		// Sampler states and textures are stored in the scene file,
+		// so store the index of the ones being used
+		material.samplerState = FindIndex(assetManager.textureSampleStates, mat->GetSamplerState(), samplerCount);
+		material.clampSamplerState = FindIndex(assetManager.textureSampleStates, mat->GetClampSamplerState(), samplerCount);
+		material.albedoMap = FindIndex(assetManager.globalTextures, mat->GetTexture(), textureCount);
+		material.normalMap = FindIndex(assetManager.globalTextures, mat->GetNormalMap(), textureCount);
+		material.roughnessMap = FindIndex(assetManager.globalTextures, mat->GetRoughMap(), textureCount);
+		material.metalMap = FindIndex(assetManager.globalTextures, mat->GetMetalMap(), textureCount);
 
-		// Complex types - Sampler States
-		// Store the index of the state being used.
-		// States are stored in the scene file.
-		// Index is determined by a pointer-match search
-		for (int i = 0; i < assetManager.textureSampleStates.size(); i++) {
-			if (mat->GetSamplerState() == assetManager.textureSampleStates[i]) {
-				matValue.AddMember(MAT_TEXTURE_SAMPLER_STATE, i, allocator);
-				break;
-			}
-		}
+		contents.materials.push_back(material);
+	}
 
-		for (int i = 0; i < assetManager.textureSampleStates.size(); i++) {
-			if (mat->GetClampSamplerState() == assetManager.textureSampleStates[i]) {
-				matValue.AddMember(MAT_CLAMP_SAMPLER_STATE, i, allocator);
-				break;
-			}
-		}
+	for (auto font : assetManager.globalFonts) {
+		SceneFileFont fontRecord;
+		fontRecord.name = contents.AddString(font->name);
+		fontRecord.fileNameKey = contents.AddString(font->fileNameKey);
+		contents.fonts.push_back(fontRecord);
+	}
 
-		// Complex types - Textures
-		// Store the index of the Texture being used.
-		// Textures are stored in the scene file.
-		// Index is determined by a pointer-match search
+	for (auto tss : assetManager.textureSampleStates) {
+		D3D11_SAMPLER_DESC texSamplerDesc;
+		tss->GetDesc(&texSamplerDesc);
 
-		for (int i = 0; i < assetManager.globalTextures.size(); i++) {
-			if (mat->GetTexture() == assetManager.globalTextures[i]) {
-				matValue.AddMember(MAT_TEXTURE_OR_ALBEDO_MAP, i, allocator);
-				break;
-			}
-		}
-
-		for (int i = 0; i < assetManager.globalTextures.size(); i++) {
-			if (mat->GetNormalMap() == assetManager.globalTextures[i]) {
-				matValue.AddMember(MAT_NORMAL_MAP, i, allocator);
-				break;
-			}
-		}
-
-		for (int i = 0; i < assetManager.globalTextures.size(); i++) {
-			if (mat->GetRoughMap() == assetManager.globalTextures[i]) {
-				matValue.AddMember(MAT_ROUGHNESS_MAP, i, allocator);
-				break;
-			}
-		}
-
-		for (int i = 0; i < assetManager.globalTextures.size(); i++) {
-			if (mat->GetMetalMap() == assetManager.globalTextures[i]) {
-				matValue.AddMember(MAT_METAL_MAP, i, allocator);
-				break;
-			}
+		SceneFileSampler sampler;
+		sampler.addressU = texSamplerDesc.AddressU;
+		sampler.addressV = texSamplerDesc.AddressV;
+		sampler.addressW = texSamplerDesc.AddressW;
+		sampler.comparisonFunction = texSamplerDesc.ComparisonFunc;
+		sampler.filter = texSamplerDesc.Filter;
+		sampler.maxAnisotropy = texSamplerDesc.MaxAnisotropy;
+		sampler.maxLOD = texSamplerDesc.MaxLOD;
+		sampler.minLOD = texSamplerDesc.MinLOD;
+		sampler.mipLODBias = texSamplerDesc.MipLODBias;
+		for (int j = 0; j < 4; j++) {
+			sampler.borderColor[j] = texSamplerDesc.BorderColor[j];
 		}
-
-		// Add everything to the material
-		materialBlock.PushBack(matValue, allocator);
-	}
-
-	sceneDocToSave.AddMember(MATERIALS, materialBlock, allocator);
-
-	rapidjson::Value fontBlock(rapidjson::kArrayType);
-	for (auto font : assetManager.globalFonts) {
-		rapidjson::Value fontObject(rapidjson::kObjectType);
-
-		fontObject.AddMember(FILENAME_KEY, rapidjson::Value().SetString(font->fileNameKey.c_str(), allocator), allocator);
-		fontObject.AddMember(NAME, rapidjson::Value().SetString(font->name.c_str(), allocator), allocator);
-
-		fontBlock.PushBack(fontObject, allocator);
-	}
-
-	sceneDocToSave.AddMember(FONTS, fontBlock, allocator);
-
-	// Save all texture sample states
-	rapidjson::Value texSampleStateBlock(rapidjson::kArrayType);
-	for (auto tss : assetManager.textureSampleStates) {
-		// Future optimization - If these are 0, don't store,
-		// and in Load(), default all of these to 0 if not found
-		rapidjson::Value sampleState(rapidjson::kObjectType);
-
-		D3D11_SAMPLER_DESC texSamplerDesc;
-		tss->GetDesc(&texSamplerDesc);
-
-		// Read each value of the description and add it to the
-		// JSON object
-		sampleState.AddMember(SAMPLER_ADDRESS_U, texSamplerDesc.AddressU, allocator);
-		sampleState.AddMember(SAMPLER_ADDRESS_V, texSamplerDesc.AddressV, allocator);
-		sampleState.AddMember(SAMPLER_ADDRESS_W, texSamplerDesc.AddressW, allocator);
-		sampleState.AddMember(SAMPLER_COMPARISON_FUNCTION, texSamplerDesc.ComparisonFunc, allocator);
-		sampleState.AddMember(SAMPLER_FILTER, texSamplerDesc.Filter, allocator);
-		sampleState.AddMember(SAMPLER_MAX_ANISOTROPY, texSamplerDesc.MaxAnisotropy, allocator);
-		sampleState.AddMember(SAMPLER_MAX_LOD, texSamplerDesc.MaxLOD, allocator);
-		sampleState.AddMember(SAMPLER_MIN_LOD, texSamplerDesc.MinLOD, allocator);
-		sampleState.AddMember(SAMPLER_MIP_LOD_BIAS, texSamplerDesc.MipLODBias, allocator);
-
-		SaveFloat4(sampleState, SAMPLER_BORDER_COLOR, DirectX::XMFLOAT4(texSamplerDesc.BorderColor), sceneDocToSave);
-
-		// Add all that to array
-		texSampleStateBlock.PushBack(sampleState, allocator);
+		contents.samplers.push_back(sampler);
 	}
 
-	sceneDocToSave.AddMember(TEXTURE_SAMPLE_STATES, texSampleStateBlock, allocator);
-
-	// Save all shaders
-	rapidjson::Value vertexShaderBlock(rapidjson::kArrayType);
 	for (auto vs : assetManager.vertexShaders) {
-		rapidjson::Value vsObject(rapidjson::kObjectType);
-
-		vsObject.AddMember(NAME, rapidjson::Value().SetString(vs->GetName().c_str(), allocator), allocator);
-		vsObject.AddMember(SHADER_FILE_PATH, rapidjson::Value().SetString(vs->GetFileNameKey().c_str(), allocator), allocator);
-
-		vertexShaderBlock.PushBack(vsObject, allocator);
+		SceneFileShader shader;
+		shader.name = contents.AddString(vs->GetName());
+		shader.filePath = contents.AddString(vs->GetFileNameKey());
+		contents.vertexShaders.push_back(shader);
 	}
 
-	sceneDocToSave.AddMember(VERTEX_SHADERS, vertexShaderBlock, allocator);
-
-	rapidjson::Value pixelShaderBlock(rapidjson::kArrayType);
 	for (auto ps : assetManager.pixelShaders) {
-		rapidjson::Value psObject(rapidjson::kObjectType);
-
-		psObject.AddMember(NAME, rapidjson::Value().SetString(ps->GetName().c_str(), allocator), allocator);
-		psObject.AddMember(SHADER_FILE_PATH, rapidjson::Value().SetString(ps->GetFileNameKey().c_str(), allocator), allocator);
-
-		pixelShaderBlock.PushBack(psObject, allocator);
+		SceneFileShader shader;
+		shader.name = contents.AddString(ps->GetName());
+		shader.filePath = contents.AddString(ps->GetFileNameKey());
+		contents.pixelShaders.push_back(shader);
 	}
 
-	sceneDocToSave.AddMember(PIXEL_SHADERS, pixelShaderBlock, allocator);
-
-	rapidjson::Value computeShaderBlock(rapidjson::kArrayType);
 	for (auto cs : assetManager.computeShaders) {
-		rapidjson::Value csObject(rapidjson::kObjectType);
-
-		csObject.AddMember(NAME, rapidjson::Value().SetString(cs->GetName().c_str(), allocator), allocator);
-		csObject.AddMember(SHADER_FILE_PATH, rapidjson::Value().SetString(cs->GetFileNameKey().c_str(), allocator), allocator);
-
-		computeShaderBlock.PushBack(csObject, allocator);
+		SceneFileShader shader;
+		shader.name = contents.AddString(cs->GetName());
+		shader.filePath = contents.AddString(cs->GetFileNameKey());
+		contents.computeShaders.push_back(shader);
 	}
 
-	sceneDocToSave.AddMember(COMPUTE_SHADERS, computeShaderBlock, allocator);
-
-	rapidjson::Value skyBlock(rapidjson::kArrayType);
 	for (auto sy : assetManager.skies) {
-		rapidjson::Value skyObject(rapidjson::kObjectType);
-
-		skyObject.AddMember(NAME, rapidjson::Value().SetString(sy->GetName().c_str(), allocator), allocator);
-		skyObject.AddMember(SKY_FILENAME_KEY_TYPE, sy->GetFilenameKeyType(), allocator);
-		skyObject.AddMember(FILENAME_KEY, rapidjson::Value().SetString(sy->GetFilenameKey().c_str(), allocator), allocator);
-		skyObject.AddMember(SKY_FILENAME_EXTENSION, rapidjson::Value().SetString(sy->GetFileExtension().c_str(), allocator), allocator);
-
-		skyBlock.PushBack(skyObject, allocator);
+		SceneFileSky sky;
+		sky.name = contents.AddString(sy->GetName());
+		sky.fileNameKey = contents.AddString(sy->GetFilenameKey());
+		sky.fileExtension = contents.AddString(sy->GetFileExtension());
+		sky.flags = sy->GetFilenameKeyType() ? SCENE_FLAG_SEPARATE_SKY_FACES : 0;
+		contents.skies.push_back(sky);
 	}
 
-	sceneDocToSave.AddMember(SKIES, skyBlock, allocator);
-
-	rapidjson::Value soundBlock(rapidjson::kArrayType);
 	for (int i = 0; i < assetManager.globalSounds.size(); i++) {
-		rapidjson::Value soundObject(rapidjson::kObjectType);
 		FMODUserData* uData;
 		FMOD_MODE sMode;
 
@@ -698,194 +952,314 @@ void SceneManager::SaveAssets(rapidjson::Document& sceneDocToSave)
 		}
 #endif
 
-		soundObject.AddMember(FILENAME_KEY, rapidjson::Value().SetString(uData->filenameKey->c_str(), allocator), allocator);
-		soundObject.AddMember(NAME, rapidjson::Value().SetString(uData->name->c_str(), allocator), allocator);
-		soundObject.AddMember(SOUND_FMOD_MODE, sMode, allocator);
-
-		soundBlock.PushBack(soundObject, allocator);
+		SceneFileSound sound;
+		sound.name = contents.AddString(*uData->name);
+		sound.fileNameKey = contents.AddString(*uData->filenameKey);
+		sound.mode = sMode;
+		contents.sounds.push_back(sound);
 	}
 
-	sceneDocToSave.AddMember(SOUNDS, soundBlock, allocator);
-
-	rapidjson::Value terrainMatBlock(rapidjson::kArrayType);
+	size_t materialCount = assetManager.globalMaterials.size();
 	for (auto tm : assetManager.globalTerrainMaterials) {
-		rapidjson::Value terrainMatObj(rapidjson::kObjectType);
-
-		terrainMatObj.AddMember(TERRAIN_MATERIAL_BLEND_MAP_ENABLED, tm->GetUsingBlendMap(), allocator);
-		terrainMatObj.AddMember(NAME, rapidjson::Value().SetString(tm->GetName().c_str(), allocator), allocator);
-		terrainMatObj.AddMember(TERRAIN_MATERIAL_BLEND_MAP_PATH, rapidjson::Value().SetString(tm->GetBlendMapFilenameKey().c_str(), allocator), allocator);
+		SceneFileTerrainMaterial terrainMaterial;
+		terrainMaterial.name = contents.AddString(tm->GetName());
+		terrainMaterial.blendMapPath = contents.AddString(tm->GetBlendMapFilenameKey());
+		terrainMaterial.flags = tm->GetUsingBlendMap() ? SCENE_FLAG_BLEND_MAP : 0;
 
 		// The internal materials are already tracked as regular materials,
-		// So we just need an array of pointers to them
-		rapidjson::Value terrainInternalMats(rapidjson::kArrayType);
+		// so we just need their indices. GUIDs aren't implemented yet.
+		terrainMaterial.firstMaterial = (uint32_t)contents.indices.size();
 		for (int i = 0; i < tm->GetMaterialCount(); i++) {
-			// GUIDs aren't implemented yet, so store array indices for now
-			int index;
-			for (index = 0; index < assetManager.globalMaterials.size(); index++) {
-				if (assetManager.globalMaterials[index] == tm->GetMaterialAtID(i)) break;
-			}
-
-			terrainInternalMats.PushBack(index, allocator);
+			int32_t index = FindIndex(assetManager.globalMaterials, tm->GetMaterialAtID(i), materialCount);
+			if (index != SCENE_FILE_NO_INDEX) contents.indices.push_back(index);
 		}
-		terrainMatObj.AddMember(TERRAIN_MATERIAL_MATERIAL_ARRAY, terrainInternalMats, allocator);
+		terrainMaterial.materialCount = (uint32_t)contents.indices.size() - terrainMaterial.firstMaterial;
 
-		terrainMatBlock.PushBack(terrainMatObj, allocator);
+		contents.terrainMaterials.push_back(terrainMaterial);
 	}
-
-	sceneDocToSave.AddMember(TERRAIN_MATERIALS, terrainMatBlock, allocator);
 }
 
 /// <summary>
-/// Saves the scene's entities
+/// Records the scene's entities
 /// </summary>
-/// <param name="sceneDocToSave">JSON document to save them into</param>
-void SceneManager::SaveEntities(rapidjson::Document& sceneDocToSave)
+/// <param name="contents">Scene to record them into. Asset indices are
+/// limited to the assets already recorded, if there are any.</param>
+/// <param name="capturedEntities">If given, gets each recorded entity,
+/// in the same order as the entity records</param>
+void SceneManager::CaptureEntities(SceneFileContents& contents, std::vector<std::shared_ptr<GameEntity>>* capturedEntities)
 {
-	rapidjson::MemoryPoolAllocator<>& allocator = sceneDocToSave.GetAllocator();
+	// Streamed entities are already saved in their cells' files
+	std::unordered_set<GameEntity*> streamedEntities = GetStreamedEntities();
 
-	rapidjson::Value gameEntityBlock(rapidjson::kArrayType);
+	SceneAssetIndices assetIndices = MapAssetIndices(contents);
+
+	contents.entities.reserve(assetManager.globalEntities.size());
 	for (auto ge : assetManager.globalEntities) {
-		rapidjson::Value geValue(rapidjson::kObjectType);
+		if (streamedEntities.count(ge.get())) continue;
 
-		// First add entity-level types
-		rapidjson::Value eName;
-		eName.SetString(ge->GetName().c_str(), allocator);
-		geValue.AddMember(NAME, eName, allocator);
-		geValue.AddMember(ENABLED, ge->GetEnabled(), allocator);
+		CaptureEntity(contents, ge, assetIndices);
+		if (capturedEntities) capturedEntities->push_back(ge);
+	}
 
-		rapidjson::Value geComponents(rapidjson::kArrayType);
-		rapidjson::Value coValue(rapidjson::kObjectType);
-		for (auto co : ge->GetAllComponents()) {
-			coValue.AddMember(ENABLED, co->IsLocallyEnabled(), allocator);
+	for (const StreamedCell& cell : streamedCells) {
+		SceneFileCell record = cell.bounds;
+		record.path = contents.AddString(cell.path);
+		contents.cells.push_back(record);
+	}
+}
 
-			// Is it a Light?
-			if (std::shared_ptr<Light> light = std::dynamic_pointer_cast<Light>(co)) {
-				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::LIGHT, allocator);
+/// <summary>
+/// Maps the assets entity records can refer to onto their indices, once
+/// for however many entities are recorded after
+/// </summary>
+/// <param name="contents">Scene the entities will be recorded into. Only
+/// assets already recorded in it are mapped, if there are any.</param>
+SceneManager::SceneAssetIndices SceneManager::MapAssetIndices(const SceneFileContents& contents)
+{
+	size_t meshCount = contents.hasAssets ? contents.meshes.size() : assetManager.globalMeshes.size();
+	size_t materialCount = contents.hasAssets ? contents.materials.size() : assetManager.globalMaterials.size();
+	size_t terrainMaterialCount = contents.hasAssets ? contents.terrainMaterials.size() : assetManager.globalTerrainMaterials.size();
+
+	SceneAssetIndices assetIndices;
+	MapIndices(assetManager.globalMeshes, meshCount, &assetIndices.meshes);
+	MapIndices(assetManager.globalMaterials, materialCount, &assetIndices.materials);
+	MapIndices(assetManager.globalTerrainMaterials, terrainMaterialCount, &assetIndices.terrainMaterials);
+	return assetIndices;
+}
 
-				coValue.AddMember(LIGHT_TYPE, light->GetType(), allocator);
-				coValue.AddMember(LIGHT_INTENSITY, light->GetIntensity(), allocator);
-				coValue.AddMember(LIGHT_RANGE, light->GetRange(), allocator);
-				coValue.AddMember(LIGHT_CASTS_SHADOWS, light->CastsShadows(), allocator);
+/// <summary>
+/// Records one entity and its components
+/// </summary>
+/// <param name="contents">Scene to record it into</param>
+/// <param name="ge">The entity to record</param>
+/// <param name="assetIndices">From MapAssetIndices for the same contents</param>
+/// <param name="capturedComponents">If given, gets each recorded component,
+/// in the same order as the component records</param>
+void SceneManager::CaptureEntity(SceneFileContents& contents, std::shared_ptr<GameEntity> ge, const SceneAssetIndices& assetIndices, std::vector<std::shared_ptr<IComponent>>* capturedComponents)
+{
+	SceneFileEntity entity;
+	entity.name = contents.AddString(ge->GetName());
+	entity.flags = ge->GetEnabled() ? SCENE_FLAG_ENABLED : 0;
+
+	// Transforms are treated and stored differently
+	CopyFloat3(entity.position, ge->GetTransform()->GetLocalPosition());
+	CopyFloat3(entity.rotation, ge->GetTransform()->GetLocalPitchYawRoll());
+	CopyFloat3(entity.scale, ge->GetTransform()->GetLocalScale());
+
+	// Parents and children aren't stored yet. They'd need
+	// a unique id system - GUIDs?
+	entity.firstComponent = (uint32_t)contents.components.size();
+	contents.entities.push_back(entity);
+
+	for (auto co : ge->GetAllComponents()) {
+		uint32_t enabled = co->IsLocallyEnabled() ? SCENE_FLAG_ENABLED : 0;
+
+		// Is it a Light?
+		if (std::shared_ptr<Light> light = std::dynamic_pointer_cast<Light>(co)) {
+			SceneFileLight& record = contents.AddComponent(SCENE_SCHEMA_LIGHT, contents.lights);
+			record.flags = enabled | (light->CastsShadows() ? SCENE_FLAG_CASTS_SHADOWS : 0);
+			record.type = light->GetType();
+			record.intensity = light->GetIntensity();
+			record.range = light->GetRange();
+			CopyFloat3(record.color, light->GetColor());
+		}
 
-				SaveFloat3(coValue, LIGHT_COLOR, light->GetColor(), sceneDocToSave);
-			}
+		// Is it a Collider?
+		else if (std::shared_ptr<Collider> collider = std::dynamic_pointer_cast<Collider>(co)) {
+			SceneFileCollider& record = contents.AddComponent(SCENE_SCHEMA_COLLIDER, contents.colliders);
+			record.flags = enabled |
+				(collider->IsTrigger() ? SCENE_FLAG_TRIGGER : 0) |
+				(collider->IsVisible() ? SCENE_FLAG_VISIBLE : 0);
+			CopyFloat3(record.positionOffset, collider->GetPositionOffset());
+			CopyFloat3(record.rotationOffset, collider->GetRotationOffset());
+			CopyFloat3(record.scale, collider->GetScale());
+		}
 
-			// Is it a Collider?
-			else if (std::shared_ptr<Collider> collider = std::dynamic_pointer_cast<Collider>(co)) {
-				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::COLLIDER, allocator);
+		// Is it Terrain?
+		else if (std::shared_ptr<Terrain> terrain = std::dynamic_pointer_cast<Terrain>(co)) {
+			SceneFileTerrain& record = contents.AddComponent(SCENE_SCHEMA_TERRAIN, contents.terrains);
+			record.flags = enabled;
+			record.fileNameKey = contents.AddString(terrain->GetMesh()->GetFileNameKey());
+			record.terrainMaterial = LookUpIndex(assetIndices.terrainMaterials, terrain->GetMaterial().get());
+		}
 
-				coValue.AddMember(COLLIDER_TYPE, collider->IsTrigger(), allocator);
-				coValue.AddMember(COLLIDER_IS_VISIBLE, collider->IsVisible(), allocator);
+		// Is it a Particle System?
+		else if (std::shared_ptr<ParticleSystem> ps = std::dynamic_pointer_cast<ParticleSystem>(co)) {
+			SceneFileParticleSystem& record = contents.AddComponent(SCENE_SCHEMA_PARTICLE_SYSTEM, contents.particleSystems);
+			record.flags = enabled |
+				(ps->IsMultiParticle() ? SCENE_FLAG_MULTI_PARTICLE : 0) |
+				(ps->GetBlendState() ? SCENE_FLAG_ADDITIVE_BLEND : 0);
+			record.fileNameKey = contents.AddString(ps->GetFilenameKey());
+			record.maxParticles = ps->GetMaxParticles();
+			record.scale = ps->GetScale();
+			record.speed = ps->GetSpeed();
+			record.particlesPerSecond = ps->GetParticlesPerSecond();
+			record.particleLifetime = ps->GetParticleLifetime();
+			CopyFloat3(record.destination, ps->GetDestination());
+			CopyFloat4(record.colorTint, ps->GetColorTint());
+		}
 
-				SaveFloat3(coValue, COLLIDER_POSITION_OFFSET, collider->GetPositionOffset(), sceneDocToSave);
-				SaveFloat3(coValue, COLLIDER_ROTATION_OFFSET, collider->GetRotationOffset(), sceneDocToSave);
-				SaveFloat3(coValue, COLLIDER_SCALE_OFFSET, collider->GetScale(), sceneDocToSave);
-			}
+		// Is it a MeshRenderer?
+		else if (std::shared_ptr<MeshRenderer> meshRenderer = std::dynamic_pointer_cast<MeshRenderer>(co)) {
+			// Mesh Renderers are really just storage for a Mesh
+			// and a Material, so get the indices for those in the
+			// stored list
+			SceneFileMeshRenderer& record = contents.AddComponent(SCENE_SCHEMA_MESH_RENDERER, contents.meshRenderers);
+			record.flags = enabled;
+			record.mesh = LookUpIndex(assetIndices.meshes, meshRenderer->GetMesh().get());
+			record.material = LookUpIndex(assetIndices.materials, meshRenderer->GetMaterial().get());
+		}
 
-			// Is it Terrain?
-			else if (std::shared_ptr<Terrain> terrain = std::dynamic_pointer_cast<Terrain>(co)) {
-				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::TERRAIN, allocator);
+		// Is it a Camera?
+		else if (std::shared_ptr<Camera> camera = std::dynamic_pointer_cast<Camera>(co)) {
+			SceneFileCamera& record = contents.AddComponent(SCENE_SCHEMA_CAMERA, contents.cameras);
+			record.flags = enabled |
+				(camera->IsPerspective() ? SCENE_FLAG_PERSPECTIVE : 0) |
+				(camera == assetManager.mainCamera ? SCENE_FLAG_MAIN_CAMERA : 0);
+			record.aspectRatio = camera->GetAspectRatio();
+			record.nearDistance = camera->GetNearDist();
+			record.farDistance = camera->GetFarDist();
+			record.fieldOfView = camera->GetFOV();
+		}
 
-				coValue.AddMember(FILENAME_KEY, rapidjson::Value().SetString(terrain->GetMesh()->GetFileNameKey().c_str(), allocator), allocator);
+		// Is it a Noclip Movement Controller?
+		else if (std::shared_ptr<NoclipMovement> noclip = std::dynamic_pointer_cast<NoclipMovement>(co)) {
+			SceneFileNoclipMovement& record = contents.AddComponent(SCENE_SCHEMA_NOCLIP_MOVEMENT, contents.noclipMovements);
+			record.flags = enabled;
+			record.moveSpeed = noclip->moveSpeed;
+			record.lookSpeed = noclip->lookSpeed;
+		}
 
-				int index;
-				for (index = 0; index < assetManager.globalTerrainMaterials.size(); index++) {
-					if (assetManager.globalTerrainMaterials[index] == terrain->GetMaterial()) break;
-				}
-				coValue.AddMember(TERRAIN_INDEX_OF_TERRAIN_MATERIAL, index, allocator);
-			}
+		// Is it a Flashlight Controller?
+		else if (std::shared_ptr<FlashlightController> flashlight = std::dynamic_pointer_cast<FlashlightController>(co)) {
+			contents.AddComponent(SCENE_SCHEMA_FLASHLIGHT_CONTROLLER, contents.flashlightControllers).flags = enabled;
+		}
+		else {
+			// Not a component scenes store
+			continue;
+		}
 
-			// Is it a Particle System?
-			else if (std::shared_ptr<ParticleSystem> ps = std::dynamic_pointer_cast<ParticleSystem>(co)) {
-				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::PARTICLE_SYSTEM, allocator);
+		if (capturedComponents) capturedComponents->push_back(co);
+	}
+}
 
-				coValue.AddMember(PARTICLE_SYSTEM_MAX_PARTICLES, ps->GetMaxParticles(), allocator);
-				coValue.AddMember(PARTICLE_SYSTEM_IS_MULTI_PARTICLE, ps->IsMultiParticle(), allocator);
-				coValue.AddMember(PARTICLE_SYSTEM_ADDITIVE_BLEND, ps->GetBlendState(), allocator);
-				coValue.AddMember(PARTICLE_SYSTEM_SCALE, ps->GetScale(), allocator);
-				coValue.AddMember(PARTICLE_SYSTEM_SPEED, ps->GetSpeed(), allocator);
-				coValue.AddMember(PARTICLE_SYSTEM_PARTICLES_PER_SECOND, ps->GetParticlesPerSecond(), allocator);
-				coValue.AddMember(PARTICLE_SYSTEM_PARTICLE_LIFETIME, ps->GetParticleLifetime(), allocator);
+/// <summary>
+/// Checks whether a scene file is in the binary format rather than JSON
+/// </summary>
+/// <param name="filepath">Path to the file</param>
+bool SceneManager::IsBinaryScene(const std::string& filepath)
+{
+	size_t extensionLength = strlen(SCENE_FILE_EXTENSION);
+	return filepath.size() >= extensionLength &&
+		filepath.compare(filepath.size() - extensionLength, extensionLength, SCENE_FILE_EXTENSION) == 0;
+}
 
-				SaveFloat3(coValue, PARTICLE_SYSTEM_DESTINATION, ps->GetDestination(), sceneDocToSave);
-				SaveFloat4(coValue, PARTICLE_SYSTEM_COLOR_TINT, ps->GetColorTint(), sceneDocToSave);
+/// <summary>
+/// Reads a scene file in either format
+/// </summary>
+/// <param name="namePath">Full path to the file</param>
+/// <param name="contents">Filled with the scene, with any journaled edits replayed on top</param>
+/// <param name="journalState">If given, gets where the scene stands relative to its journal</param>
+/// <returns>False if the file couldn't be read or isn't a valid SHOE scene</returns>
+bool SceneManager::ReadSceneFile(std::string namePath, SceneFileContents& contents, SceneJournalState* journalState)
+{
+	// Read ahead of any streaming reads still queued, since nothing else can happen until it's here
+	AsyncReadResult sceneData = AsyncFileReader::GetInstance().Read(namePath, ASYNC_READ_PRIORITY_HIGH).get();
+	if (!sceneData.succeeded) {
+		return false;
+	}
 
-				coValue.AddMember(FILENAME_KEY, rapidjson::Value().SetString(ps->GetFilenameKey().c_str(), allocator), allocator);
-			}
+	if (IsBinaryScene(namePath)) {
+		if (!SceneFile::Read(sceneData.data.data(), sceneData.data.size(), &contents)) return false;
+	}
+	else {
+		SceneJsonReader reader(&contents);
+		if (!reader.Read(sceneData.data.data(), sceneData.data.size())) return false;
+	}
 
-			// Is it a MeshRenderer?
-			else if (std::shared_ptr<MeshRenderer> meshRenderer = std::dynamic_pointer_cast<MeshRenderer>(co)) {
-				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::MESH_RENDERER, allocator);
+	SceneJournalState journal;
+	journal.baseHash = SceneJournal::Hash(sceneData.data.data(), sceneData.data.size());
+	journal.baseSize = sceneData.data.size();
 
-				// Mesh Renderers are really just storage for a Mesh
-				// and a Material, so get the indices for those in the 
-				// stored list
+	// Edits journaled since the file was written go on top of it
+	std::string journalPath = namePath + SCENE_JOURNAL_EXTENSION;
+	std::error_code fileError;
+	AsyncReadResult journalData;
+	if (std::experimental::filesystem::exists(journalPath, fileError)) {
+		journalData = AsyncFileReader::GetInstance().Read(journalPath, ASYNC_READ_PRIORITY_HIGH).get();
+	}
 
-				rapidjson::Value meshIndex;
-				for (int i = 0; i < assetManager.globalMeshes.size(); i++) {
-					if (assetManager.globalMeshes[i] == meshRenderer->GetMesh()) {
-						meshIndex.SetInt(i);
-						break;
-					}
-				}
-				coValue.AddMember(MESH_COMPONENT_INDEX, meshIndex, allocator);
-
-				rapidjson::Value materialIndex;
-				for (int i = 0; i < assetManager.globalMaterials.size(); i++) {
-					if (assetManager.globalMaterials[i] == meshRenderer->GetMaterial()) {
-						materialIndex.SetInt(i);
-						break;
-					}
-				}
-				coValue.AddMember(MATERIAL_COMPONENT_INDEX, materialIndex, allocator);
-			}
+	if (!journalData.succeeded || !SceneJournal::Apply(journalData.data.data(), journalData.data.size(), &contents, &journal)) {
+		SceneJournal::Reset(contents, journal.baseHash, journal.baseSize, &journal);
+	}
+	else if (journal.journalSize < journalData.data.size()) {
+		// Cut off by a crash. The partial record is dropped, or nothing journaled after it could be replayed.
+		MappedFile::WriteWholeFile(journalPath, journalData.data.data(), (size_t)journal.journalSize);
+	}
 
-			// Is it a Camera?
-			else if (std::shared_ptr<Camera> camera = std::dynamic_pointer_cast<Camera>(co)) {
-				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::CAMERA, allocator);
-				coValue.AddMember(CAMERA_ASPECT_RATIO, camera->GetAspectRatio(), allocator);
-				coValue.AddMember(CAMERA_PROJECTION_MATRIX_TYPE, camera->IsPerspective(), allocator);
-				coValue.AddMember(CAMERA_NEAR_DISTANCE, camera->GetNearDist(), allocator);
-				coValue.AddMember(CAMERA_FAR_DISTANCE, camera->GetFarDist(), allocator);
-				coValue.AddMember(CAMERA_FIELD_OF_VIEW, camera->GetFOV(), allocator);
-				coValue.AddMember(CAMERA_IS_MAIN, camera == assetManager.mainCamera, allocator);
-			}
+	if (journalState) *journalState = journal;
+	return true;
+}
 
-			// Is it a Noclip Movement Controller?
-			else if (std::shared_ptr<NoclipMovement> noclip = std::dynamic_pointer_cast<NoclipMovement>(co)) {
-				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::NOCLIP_CHAR_CONTROLLER, allocator);
-				coValue.AddMember(NOCLIP_MOVE_SPEED, noclip->moveSpeed, allocator);
-				coValue.AddMember(NOCLIP_LOOK_SPEED, noclip->lookSpeed, allocator);
-			}
+/// <summary>
+/// Writes a scene file, in the format its extension names. Only touches
+/// the contents it's given, so it's safe to call from any thread.
+/// </summary>
+/// <param name="namePath">Full path to the file</param>
+/// <param name="contents">Scene to write</param>
+/// <param name="fileHash">If given, gets the hash of what was written, which its journal is tied to</param>
+/// <param name="fileSize">If given, gets the size of what was written</param>
+/// <returns>False if the file couldn't be written</returns>
+bool SceneManager::WriteSceneFile(std::string namePath, const SceneFileContents& contents, uint64_t* fileHash, uint64_t* fileSize)
+{
+	if (IsBinaryScene(namePath)) {
+		std::vector<unsigned char> output;
+		SceneFile::Encode(contents, &output);
 
-			// Is it a Flashlight Controller?
-			else if (std::shared_ptr<FlashlightController> flashlight = std::dynamic_pointer_cast<FlashlightController>(co)) {
-				coValue.AddMember(COMPONENT_TYPE, ComponentTypes::FLASHLIGHT_CONTROLLER, allocator);
-			}
+		if (fileHash) *fileHash = SceneJournal::Hash(output.data(), output.size());
+		if (fileSize) *fileSize = output.size();
+		return MappedFile::WriteWholeFile(namePath, output.data(), output.size());
+	}
 
-			geComponents.PushBack(coValue, allocator);
-			coValue.SetObject();
-		}
+	char cbuf[4096];
+	rapidjson::MemoryPoolAllocator<> allocator(cbuf, sizeof(cbuf));
 
-		// Transforms are treated and stored differently
-		SaveFloat3(geValue, TRANSFORM_LOCAL_POSITION, ge->GetTransform()->GetLocalPosition(), sceneDocToSave);
-		SaveFloat3(geValue, TRANSFORM_LOCAL_ROTATION, ge->GetTransform()->GetLocalPitchYawRoll(), sceneDocToSave);
-		SaveFloat3(geValue, TRANSFORM_LOCAL_SCALE, ge->GetTransform()->GetLocalScale(), sceneDocToSave);
+	rapidjson::Document sceneDocToSave(&allocator, 256);
 
-		// I have no idea how to serialize this
-		// I'd need to essentially create a unique id system - GUIDs?
-		rapidjson::Value parent;
-		rapidjson::Value children;
+	sceneDocToSave.SetObject();
 
-		// Push all the components to the game entity
-		geValue.AddMember(COMPONENTS, geComponents, allocator);
+	// RapidJSON doesn't know about our file types directly, so they
+	// have to be reconstructed and stored as individual values.
+	sceneDocToSave.AddMember(VALID_SHOE_SCENE, true, allocator);
+	sceneDocToSave.AddMember(NAME, rapidjson::Value().SetString(contents.name.c_str(), allocator), allocator);
 
-		// Push everything to the game entity array
-		gameEntityBlock.PushBack(geValue, allocator);
+	//
+	// In all rapidjson saving and loading instances, defines are used to
+	// create shorthand strings to optimize memory while keeping the code readable.
+	//
+	if (contents.hasAssets) {
+		WriteJsonAssets(contents, sceneDocToSave);
 	}
+	WriteJsonEntities(contents, sceneDocToSave);
+
+	rapidjson::StringBuffer sceneBuffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(sceneBuffer);
+	sceneDocToSave.Accept(writer);
+
+	if (fileHash) *fileHash = SceneJournal::Hash(sceneBuffer.GetString(), sceneBuffer.GetSize());
+	if (fileSize) *fileSize = sceneBuffer.GetSize();
 
-	// Add the game entity array to the doc
-	sceneDocToSave.AddMember(ENTITIES, gameEntityBlock, allocator);
+	// Renamed over the old file once it's all written, so a failed save leaves the last one intact
+	return MappedFile::WriteWholeFile(namePath, sceneBuffer.GetString(), sceneBuffer.GetSize());
+}
+
+/// <summary>
+/// Finishes writing any saves still waiting, so none are lost on exit
+/// </summary>
+SceneManager::~SceneManager()
+{
+	WaitForSaves();
+	assetManager.SetIndexedAssetCounter({});
 }
 
 /// <summary>
@@ -895,6 +1269,36 @@ void SceneManager::SaveEntities(rapidjson::Document& sceneDocToSave)
 void SceneManager::Initialize(EngineState* engineState)
 {
 	this->engineState = engineState;
+
+	assetManager.SetIndexedAssetCounter([this]() { return CountIndexedAssets(); });
+}
+
+/// <summary>
+/// Counts the assets the play snapshot and the scene's cells refer to by index,
+/// so unloading doesn't shift them
+/// </summary>
+IndexedAssetCounts SceneManager::CountIndexedAssets()
+{
+	IndexedAssetCounts counts;
+
+	// Cells that aren't loaded can refer to any of the scene's assets
+	if (!streamedCells.empty()) {
+		counts.meshCount = assetManager.GetMeshArraySize();
+		counts.materialCount = assetManager.GetMaterialArraySize();
+		counts.terrainMaterialCount = assetManager.GetTerrainMaterialArraySize();
+		return counts;
+	}
+
+	for (const SceneFileMeshRenderer& meshRenderer : playSnapshot.meshRenderers) {
+		if (meshRenderer.mesh >= 0) counts.meshCount = (std::max)(counts.meshCount, (size_t)meshRenderer.mesh + 1);
+		if (meshRenderer.material >= 0) counts.materialCount = (std::max)(counts.materialCount, (size_t)meshRenderer.material + 1);
+	}
+
+	for (const SceneFileTerrain& terrain : playSnapshot.terrains) {
+		if (terrain.terrainMaterial >= 0) counts.terrainMaterialCount = (std::max)(counts.terrainMaterialCount, (size_t)terrain.terrainMaterial + 1);
+	}
+
+	return counts;
 }
 
 /// <summary>
@@ -912,50 +1316,112 @@ std::string SceneManager::GetCurrentSceneName() {
 }
 
 /// <summary>
-/// Loads a scene from a JSON file
+/// Loads a scene from a JSON or binary scene file
 /// </summary>
 /// <param name="filepath">Path to the file</param>
 /// <param name="progressListener">Function to call when progressing to each new object load</param>
 void SceneManager::LoadScene(std::string filepath, std::function<void()> progressListener) {
 	HRESULT hr = CoInitialize(NULL);
 
+	// Loading outright overrides a switch that hasn't been swapped in yet
+	CancelSceneSwitch();
+
 	*engineState = EngineState::LOAD_SCENE;
 
 	try {
-		rapidjson::Document sceneDoc;
-
 		std::string namePath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, filepath);
 
-		FILE* file;
-		fopen_s(&file, namePath.c_str(), "rb");
+		// Everything but reading the file itself happens in here, once every asset is known
+		bool assetsLoaded = false;
+		auto loadAssets = [&](const SceneFileContents& contents) {
+			if (!contents.hasAssets) {
+				return false;
+			}
 
-		if (file == NULL) {
-			return;
+			// Get the scene name for loading purposes
+			loadingSceneName = contents.name;
+
+			// Remove the current scene from memory
+			assetManager.CleanAllVectors();
+			ResetStreaming(false);
+			StopJournal();
+			sceneGeneration++;
+
+			LoadAssets(contents, progressListener);
+			assetsLoaded = true;
+
+			currentLoadCategory = "Entities";
+			return true;
+		};
+
+		SceneFileContents contents;
+		SceneJournalState journalState;
+		bool readAll = true;
+
+		// Journaled edits have to be replayed before anything's made, so a JSON scene with a journal is read whole
+		std::error_code fileError;
+		if (IsBinaryScene(namePath) || std::experimental::filesystem::exists(namePath + SCENE_JOURNAL_EXTENSION, fileError)) {
+			if (!ReadSceneFile(namePath, contents, &journalState) || !loadAssets(contents)) {
+				return;
+			}
+
+			LoadEntities(contents, progressListener);
+			StartStreaming(contents);
 		}
+		else {
+			AsyncReadResult sceneData = AsyncFileReader::GetInstance().Read(namePath, ASYNC_READ_PRIORITY_HIGH).get();
+			if (!sceneData.succeeded) {
+				return;
+			}
 
-		char readBuffer[FILE_BUFFER_SIZE];
-		rapidjson::FileReadStream sceneFileStream(file, readBuffer, sizeof(readBuffer));
+			// JSON scenes are parsed on a worker, which hands each entity over as
+			// soon as it's been read, so entities are made here while the rest of
+			// the file is still being parsed
+			std::shared_ptr<JsonSceneRead> read = StartJsonRead(std::move(sceneData.data));
 
-		sceneDoc.ParseStream(sceneFileStream);
+			bool finished = false;
+			while (!finished) {
+				std::shared_ptr<SceneFileContents> assets;
+				std::deque<std::shared_ptr<SceneFileContents>> entities;
+				finished = TakeJsonRecords(*read, &assets, &entities);
 
-		// Check if this is a valid SHOE scene
-		assert(sceneDoc[VALID_SHOE_SCENE].GetBool());
+				if (assets != nullptr && !loadAssets(*assets)) {
+					read->cancelled = true;
+					break;
+				}
+
+				for (const std::shared_ptr<SceneFileContents>& entity : entities) {
+					currentLoadName = entity->GetString(entity->entities[0].name);
+					if(progressListener) progressListener();
+
+					LoadEntity(*entity, entity->entities[0]);
+				}
 
-		// Get the scene name for loading purposes
-		loadingSceneName = sceneDoc[NAME].GetString();
+				// Keeps the loading screen drawing while the worker catches up
+				if (entities.empty() && progressListener) progressListener();
+			}
+			read->result.wait();
+
+			// Past loading assets the old scene is already gone, so whatever
+			// was read before an error is kept rather than left half loaded
+			readAll = read->succeeded && !read->cancelled;
+			if (!readAll && !assetsLoaded) {
+				return;
+			}
 
-		// Remove the current scene from memory
-		assetManager.CleanAllVectors();
+			SceneJournal::Reset(read->contents, SceneJournal::Hash(read->data.data(), read->data.size()), read->data.size(), &journalState);
+		}
 
-		LoadAssets(sceneDoc, progressListener);
-		LoadEntities(sceneDoc, progressListener);
+		// A scene that failed part way isn't what its file holds, so it's
+		// never journaled on top of the file or compacted over it
+		if (readAll) {
+			StartJournal(filepath, journalState);
+		}
 
 		currentLoadCategory = "Post-Initialization";
 		currentLoadName = "Renderer and Final Setup";
 		if(progressListener) progressListener();
 
-		fclose(file);
-
 		currentSceneName = loadingSceneName;
 		loadingSceneName = "";
 		*engineState = EngineState::EDITING;
@@ -966,142 +1432,1284 @@ void SceneManager::LoadScene(std::string filepath, std::function<void()> progres
 }
 
 /// <summary>
-/// Saves a scene to a JSON file
+/// Starts reading a JSON scene on a JobSystem worker. Its records are handed
+/// over through TakeJsonRecords as they're read.
 /// </summary>
-/// <param name="filepath">Path to the file</param>
-/// <param name="sceneName">Name to store the scene under</param>
-void SceneManager::SaveScene(std::string filepath, std::string sceneName) {
-	//Cannot save scene during play
-	if (*engineState == EngineState::PLAY)
-		return;
+/// <param name="data">The whole file</param>
+std::shared_ptr<SceneManager::JsonSceneRead> SceneManager::StartJsonRead(std::vector<char> data)
+{
+	std::shared_ptr<JsonSceneRead> read = std::make_shared<JsonSceneRead>();
+	read->data = std::move(data);
+
+	read->result = JobSystem::GetInstance().Schedule([read]() {
+		SceneJsonReader reader(&read->contents, [read](const SceneFileContents& contents) {
+			// Copied, since reading goes on adding to the contents while the main thread loads these
+			std::shared_ptr<SceneFileContents> assets = std::make_shared<SceneFileContents>(contents);
+			{
+				std::lock_guard<std::mutex> lock(read->recordMutex);
+				read->assets = assets;
+			}
+			read->recordsReady.notify_one();
+			return !read->cancelled;
+		}, [read](const SceneFileContents& contents, uint32_t entityIndex) {
+			std::shared_ptr<SceneFileContents> entity = std::make_shared<SceneFileContents>();
+			entity->hasAssets = false;
+			entity->CopyEntity(contents, entityIndex);
+			{
+				std::lock_guard<std::mutex> lock(read->recordMutex);
+				read->entities.push_back(entity);
+			}
+			read->recordsReady.notify_one();
+			return !read->cancelled;
+		});
 
-	try {
-		char cbuf[4096];
-		rapidjson::MemoryPoolAllocator<> allocator(cbuf, sizeof(cbuf));
+		bool succeeded = false;
+		try {
+			succeeded = reader.Read(read->data.data(), read->data.size());
+		}
+		catch (...) {}
 
-		rapidjson::Document sceneDocToSave(&allocator, 256);
+		{
+			std::lock_guard<std::mutex> lock(read->recordMutex);
+			read->succeeded = succeeded;
+			read->finished = true;
+		}
+		read->recordsReady.notify_one();
+	});
+
+	return read;
+}
 
-		sceneDocToSave.SetObject();
+/// <summary>
+/// Takes every record a JSON read has handed over so far, waiting up to a
+/// frame for one if there aren't any yet
+/// </summary>
+/// <param name="assets">Gets the scene's assets, if they were handed over since the last call</param>
+/// <param name="entities">Gets the entities handed over since the last call, in order</param>
+/// <returns>True once the read has finished, so nothing else will be handed over</returns>
+bool SceneManager::TakeJsonRecords(JsonSceneRead& read, std::shared_ptr<SceneFileContents>* assets, std::deque<std::shared_ptr<SceneFileContents>>* entities)
+{
+	std::unique_lock<std::mutex> lock(read.recordMutex);
+	if (read.assets == nullptr && read.entities.empty() && !read.finished) {
+		read.recordsReady.wait_for(lock, std::chrono::milliseconds(16));
+	}
 
-		// RapidJSON doesn't know about our file types directly, so they
-		// have to be reconstructed and stored as individual values.
-		sceneDocToSave.AddMember(VALID_SHOE_SCENE, true, allocator);
-		sceneDocToSave.AddMember(NAME, rapidjson::Value().SetString(sceneName.c_str(), allocator), allocator);
+	*assets = read.assets;
+	read.assets = nullptr;
+	entities->swap(read.entities);
+	return read.finished;
+}
 
-		//
-		// In all rapidjson saving and loading instances, defines are used to 
-		// create shorthand strings to optimize memory while keeping the code readable.
-		//
-		SaveAssets(sceneDocToSave);
-		SaveEntities(sceneDocToSave);
+/// <summary>
+/// Switches to another scene without stopping the current one. The scene is
+/// read and its asset files decoded on JobSystem workers while the current
+/// scene keeps running, then UpdateSceneSwitch swaps it in within one frame.
+/// Asset files the two scenes have in common are handed over through the
+/// asset cache instead of being read again. Starting another switch, or
+/// loading a scene outright, cancels one that hasn't been swapped in yet.
+/// </summary>
+/// <param name="filepath">Path to the file</param>
+/// <param name="completionListener">Called on the main thread once the scene
+/// is swapped in, or the switch failed or was cancelled</param>
+/// <returns>False if the engine isn't in a state to switch scenes</returns>
+bool SceneManager::SwitchScene(std::string filepath, SceneSwitchCallback completionListener)
+{
+	if (*engineState != EngineState::EDITING && *engineState != EngineState::PLAY)
+		return false;
+
+	CancelSceneSwitch();
+
+	std::shared_ptr<SceneSwitch> sceneSwitch = std::make_shared<SceneSwitch>();
+	sceneSwitch->filepath = filepath;
+	sceneSwitch->namePath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, filepath);
+	sceneSwitch->callback = completionListener;
+	sceneSwitch->startTime = GetSeconds();
+	activeSwitch = sceneSwitch;
+
+	// Hashing every file up front lets the main thread tell which ones the cache already holds
+	JobSystem::GetInstance().Schedule([this, sceneSwitch]() {
+		bool succeeded = false;
+		try {
+			succeeded = ReadSceneFile(sceneSwitch->namePath, sceneSwitch->contents, &sceneSwitch->journal) &&
+				sceneSwitch->contents.hasAssets;
+
+			if (succeeded) {
+				BuildScenePreload(sceneSwitch->contents, sceneSwitch->preload.get());
+				assetManager.HashScenePreload(sceneSwitch->preload.get());
+			}
+		}
+		catch (...) {
+			succeeded = false;
+		}
 
-		// At the end of gathering data, write it all
-		// to the appropriate file
-		std::string namePath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, filepath);
+		JobSystem::GetInstance().QueueMainThreadJob([this, sceneSwitch, succeeded]() { DecodeSceneSwitch(sceneSwitch, succeeded); });
+	});
 
-		FILE* file;
-		fopen_s(&file, namePath.c_str(), "w");
+	return true;
+}
 
-		char writeBuffer[FILE_BUFFER_SIZE];
-		rapidjson::FileWriteStream sceneFileStream(file, writeBuffer, sizeof(writeBuffer));
+/// <summary>
+/// Lists the asset files a scene loads, for reading ahead of a switch.
+/// Only works out paths, so it's safe to call from any thread.
+/// </summary>
+/// <param name="contents">Scene to list the files of</param>
+/// <param name="preload">Filled with a request per file</param>
+void SceneManager::BuildScenePreload(const SceneFileContents& contents, ScenePreload* preload)
+{
+	for (const SceneFileTexture& texture : contents.textures) {
+		TextureLoadRequest request;
+		request.nameToLoad = LoadDeserializedFileName(contents, texture.fileNameKey);
+		request.textureName = contents.GetString(texture.name);
+		request.assetPath = (AssetPathIndex)texture.assetPathIndex;
+		request.fullPath = assetManager.GetFullPathToAssetFile(request.assetPath, request.nameToLoad);
+		request.deferLoad = false;
+		request.result = E_PENDING;
+		preload->textures.push_back(request);
+	}
 
-		rapidjson::Writer<rapidjson::FileWriteStream> writer(sceneFileStream);
-		sceneDocToSave.Accept(writer);
+	for (const SceneFileMesh& mesh : contents.meshes) {
+		MeshLoadRequest request;
+		request.id = contents.GetString(mesh.name);
+		request.nameToLoad = LoadDeserializedFileName(contents, mesh.fileNameKey);
+		request.fullPath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_MODEL_PATH, request.nameToLoad);
+		request.deferLoad = false;
+		request.loaded = false;
+		preload->meshes.push_back(request);
+	}
 
-		fclose(file);
+	for (const SceneFileSky& sky : contents.skies) {
+		SkyLoadRequest request;
+		request.filepath = LoadDeserializedFileName(contents, sky.fileNameKey);
+		request.fullPath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_TEXTURE_PATH_SKIES, request.filepath);
+		request.fileType = (sky.flags & SCENE_FLAG_SEPARATE_SKY_FACES) != 0;
+		request.name = contents.GetString(sky.name);
+		request.fileExtension = request.fileType ? contents.GetString(sky.fileExtension) : ".png";
+		request.result = E_PENDING;
+		preload->skies.push_back(request);
 	}
-	catch (...) {
-#if defined(DEBUG) || defined(_DEBUG)
-		printf("Failed to save scene with error:\n %s \n", std::current_exception());
-#endif
+
+	for (const SceneFileSound& sound : contents.sounds) {
+		SoundLoadRequest request;
+		request.fullPath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SOUND_PATH, LoadDeserializedFileName(contents, sound.fileNameKey));
+		request.mode = sound.mode;
+		request.name = contents.GetString(sound.name);
+		request.sound = nullptr;
+		preload->sounds.push_back(request);
 	}
 }
 
 /// <summary>
-/// Saves the state of the entities in the scene before moving to play state
+/// Drops the files of a switch's scene that the cache already holds, then
+/// decodes the rest in the background
 /// </summary>
-void SceneManager::PrePlaySave()
+/// <param name="sceneSwitch">The switch whose scene was just read</param>
+/// <param name="succeeded">Whether the scene could be read</param>
+void SceneManager::DecodeSceneSwitch(std::shared_ptr<SceneSwitch> sceneSwitch, bool succeeded)
 {
-	if (*engineState != EngineState::EDITING)
-		return;
-
-	try {
-		char cbuf[4096];
-		rapidjson::MemoryPoolAllocator<> allocator(cbuf, sizeof(cbuf));
-
-		rapidjson::Document sceneDocToSave(&allocator, 256);
+	// Cancelled while it was reading
+	if (sceneSwitch != activeSwitch) return;
 
-		sceneDocToSave.SetObject();
-
-		// RapidJSON doesn't know about our file types directly, so they
-		// have to be reconstructed and stored as individual values.
-		sceneDocToSave.AddMember(VALID_SHOE_SCENE, true, allocator);
+	if (!succeeded) {
+		FinishSceneSwitch(false);
+		return;
+	}
 
-		SaveEntities(sceneDocToSave);
+	sceneSwitch->sharedAssetCount = assetManager.FilterScenePreload(sceneSwitch->preload.get());
 
-		// At the end of gathering data, write it all
-		// to the appropriate file
-		std::string namePath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, ".temp_play_save.json");
+	JobSystem::GetInstance().Schedule([this, sceneSwitch]() {
+		bool decoded = true;
+		try {
+			assetManager.DecodeScenePreload(sceneSwitch->preload.get());
+		}
+		catch (...) {
+			decoded = false;
+		}
 
-		FILE* file;
-		fopen_s(&file, namePath.c_str(), "w");
+		JobSystem::GetInstance().QueueMainThreadJob([this, sceneSwitch, decoded]() {
+			// Only the one waiting to swap in holds on to what was decoded
+			if (sceneSwitch != activeSwitch) {
+				assetManager.ReleaseScenePreload(sceneSwitch->preload);
+				return;
+			}
 
-		char writeBuffer[FILE_BUFFER_SIZE];
-		rapidjson::FileWriteStream sceneFileStream(file, writeBuffer, sizeof(writeBuffer));
+			// Whatever's missing is loaded during the swap instead, the slow way
+			if (!decoded) {
+				assetManager.ReleaseScenePreload(sceneSwitch->preload);
+			}
 
-		rapidjson::Writer<rapidjson::FileWriteStream> writer(sceneFileStream);
-		sceneDocToSave.Accept(writer);
+			sceneSwitch->ready = true;
+		});
+	});
+}
 
-		fclose(file);
+/// <summary>
+/// Swaps in a scene that's finished preparing in the background. The old
+/// scene's entities are removed and the new one's made in the same frame, so
+/// nothing is drawn in between. Meant to be called once per frame, before
+/// anything updates or draws the scene.
+/// </summary>
+void SceneManager::UpdateSceneSwitch()
+{
+	if (activeSwitch == nullptr || !activeSwitch->ready) return;
+	if (*engineState != EngineState::EDITING && *engineState != EngineState::PLAY) return;
 
-		*engineState = EngineState::PLAY;
-	}
-	catch (...) {
-#if defined(DEBUG) || defined(_DEBUG)
-		printf("Failed to save pre-play scene with error:\n %s \n", std::current_exception());
-#endif
-	}
+	FinishSceneSwitch(true);
 }
 
 /// <summary>
-/// Loads the state of the scene how it was just before moving to play state
+/// Swaps in the active switch's scene, or reports that it failed
 /// </summary>
-void SceneManager::PostPlayLoad()
+/// <param name="succeeded">Whether the scene was read and is ready to swap in</param>
+void SceneManager::FinishSceneSwitch(bool succeeded)
 {
-	if (*engineState != EngineState::PLAY)
-		return;
+	std::shared_ptr<SceneSwitch> sceneSwitch = activeSwitch;
+	activeSwitch = nullptr;
 
-//	try {
-		*engineState = EngineState::UNLOAD_PLAY;
+	SceneSwitchResult result;
+	result.path = sceneSwitch->namePath;
+	result.sharedAssetCount = sceneSwitch->sharedAssetCount;
 
-		rapidjson::Document sceneDoc;
+	double swapStartTime = GetSeconds();
+	result.preparationTime = swapStartTime - sceneSwitch->startTime;
 
-		std::string namePath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, ".temp_play_save.json");
+	if (succeeded) {
+		RetiredSceneAssets retired;
 
-		FILE* file;
-		fopen_s(&file, namePath.c_str(), "rb");
+		try {
+			const SceneFileContents& contents = sceneSwitch->contents;
+			loadingSceneName = contents.name;
 
-		if (file == NULL) {
-			return;
-		}
+			// The old scene's assets keep their place in the cache until the new
+			// scene's are made, so the ones the two share are taken over as they are
+			assetManager.RetireSceneAssets(&retired);
+			ResetStreaming(false);
+			StopJournal();
+			sceneGeneration++;
 
-		char readBuffer[FILE_BUFFER_SIZE];
-		rapidjson::FileReadStream sceneFileStream(file, readBuffer, sizeof(readBuffer));
+			assetManager.SetScenePreload(sceneSwitch->preload);
+			LoadAssets(contents);
+			LoadEntities(contents);
+			assetManager.ReleaseScenePreload(sceneSwitch->preload);
 
-		sceneDoc.ParseStream(sceneFileStream);
+			result.releasedAssetCount = assetManager.ReleaseRetiredAssets(&retired);
 
-		// Check if this is a valid SHOE scene
-		assert(sceneDoc[VALID_SHOE_SCENE].GetBool());
+			StartStreaming(contents);
+			StartJournal(sceneSwitch->filepath, sceneSwitch->journal);
 
-		assetManager.CleanAllEntities();
+			// Stopping play goes back to the scene that was switched to, as it loaded
+			if (*engineState == EngineState::PLAY) {
+				CapturePlaySnapshot();
+			}
 
-		LoadEntities(sceneDoc);
+			currentSceneName = loadingSceneName;
+			loadingSceneName = "";
+			result.succeeded = true;
+		}
+		catch (...) {
+			assetManager.ReleaseScenePreload(sceneSwitch->preload);
+			assetManager.ReleaseRetiredAssets(&retired);
+			loadingSceneName = "";
+		}
+	}
+	else {
+		assetManager.ReleaseScenePreload(sceneSwitch->preload);
+	}
 
-		fclose(file);
+	result.swapTime = GetSeconds() - swapStartTime;
+	lastSwitchResult = result;
 
-		*engineState = EngineState::EDITING;
-//	}
+#if defined(DEBUG) || defined(_DEBUG)
+	if (!result.succeeded) {
+		printf("Failed to switch to scene %s\n", result.path.c_str());
+	}
+#endif
+
+	if (sceneSwitch->callback) sceneSwitch->callback(result);
+}
+
+/// <summary>
+/// Drops the active switch, if there is one and it hasn't been swapped in
+/// </summary>
+void SceneManager::CancelSceneSwitch()
+{
+	if (activeSwitch == nullptr) return;
+
+	std::shared_ptr<SceneSwitch> sceneSwitch = activeSwitch;
+	activeSwitch = nullptr;
+
+	// One still reading or decoding frees its preload once that's done
+	if (sceneSwitch->ready) {
+		assetManager.ReleaseScenePreload(sceneSwitch->preload);
+	}
+
+	SceneSwitchResult result;
+	result.path = sceneSwitch->namePath;
+	result.cancelled = true;
+	result.preparationTime = GetSeconds() - sceneSwitch->startTime;
+	lastSwitchResult = result;
+
+	if (sceneSwitch->callback) sceneSwitch->callback(result);
+}
+
+/// <summary>
+/// Checks whether a scene is being prepared to switch to
+/// </summary>
+bool SceneManager::IsSwitchingScene()
+{
+	return activeSwitch != nullptr;
+}
+
+/// <summary>
+/// Gets how the last scene switch went
+/// </summary>
+SceneSwitchResult SceneManager::GetLastSwitchResult()
+{
+	return lastSwitchResult;
+}
+
+/// <summary>
+/// Saves a scene to a file. Ending the path in SCENE_FILE_EXTENSION
+/// saves it in the binary format, anything else saves JSON. The scene is
+/// recorded right away, then written in the background, so later changes
+/// don't end up in the file.
+/// </summary>
+/// <param name="filepath">Path to the file</param>
+/// <param name="sceneName">Name to store the scene under</param>
+/// <param name="completionListener">Called on the main thread once the file
+/// is written, or the save failed or was superseded</param>
+void SceneManager::SaveScene(std::string filepath, std::string sceneName, SceneSaveCallback completionListener) {
+	//Cannot save scene during play
+	if (*engineState == EngineState::PLAY)
+		return;
+
+	try {
+		double startTime = GetSeconds();
+
+		std::shared_ptr<SceneFileContents> contents = std::make_shared<SceneFileContents>();
+		contents->name = sceneName;
+
+		SceneSave save;
+		CaptureAssets(*contents);
+		CaptureEntities(*contents, &save.entities);
+
+		save.id = nextSaveId++;
+		save.filepath = filepath;
+		save.namePath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, filepath);
+		save.contents = contents;
+		save.assets = CaptureJournalAssets();
+		save.callback = completionListener;
+		save.captureTime = GetSeconds() - startTime;
+		save.sceneGeneration = sceneGeneration;
+
+		// Only the newest recording of a file is worth writing
+		std::vector<SceneSave> superseded;
+		for (auto it = queuedSaves.begin(); it != queuedSaves.end();) {
+			if (it->namePath == save.namePath) {
+				superseded.push_back(*it);
+				it = queuedSaves.erase(it);
+			}
+			else {
+				it++;
+			}
+		}
+
+		queuedSaves.push_back(save);
+		StartNextSave();
+
+		for (const SceneSave& skipped : superseded) {
+			SceneSaveResult result;
+			result.path = skipped.namePath;
+			result.superseded = true;
+			result.captureTime = skipped.captureTime;
+			if (skipped.callback) skipped.callback(result);
+		}
+	}
+	catch (...) {
+#if defined(DEBUG) || defined(_DEBUG)
+		printf("Failed to save scene with error:\n %s \n", std::current_exception());
+#endif
+	}
+}
+
+/// <summary>
+/// Starts writing the oldest queued save, unless one is already being written
+/// </summary>
+void SceneManager::StartNextSave()
+{
+	if (activeSaveResult.valid() || queuedSaves.empty()) return;
+
+	activeSave = queuedSaves.front();
+	queuedSaves.pop_front();
+
+	SceneSave save = activeSave;
+	activeSaveResult = JobSystem::GetInstance().Schedule([this, save]() {
+		SceneSaveResult result;
+		result.path = save.namePath;
+		result.captureTime = save.captureTime;
+
+		double startTime = GetSeconds();
+		try {
+			result.succeeded = WriteSceneFile(save.namePath, *save.contents, &result.fileHash, &result.fileSize);
+		}
+		catch (...) {
+			result.succeeded = false;
+		}
+		result.writeTime = GetSeconds() - startTime;
+
+		uint64_t id = save.id;
+		JobSystem::GetInstance().QueueMainThreadJob([this, id]() { FinishSave(id); });
+
+		return result;
+	});
+}
+
+/// <summary>
+/// Reports a written save and starts the next one
+/// </summary>
+/// <param name="id">The save that was written</param>
+void SceneManager::FinishSave(uint64_t id)
+{
+	// Already finished by WaitForSaves
+	if (!activeSaveResult.valid() || activeSave.id != id) return;
+
+	SceneSaveResult result = activeSaveResult.get();
+	SceneSave save = activeSave;
+	activeSave = SceneSave();
+	lastSaveResult = result;
+
+	if (result.succeeded) {
+		// Edits are journaled on top of the file that was just written from here on.
+		// The old journal was for the old file, which this one already includes.
+		std::remove((save.namePath + SCENE_JOURNAL_EXTENSION).c_str());
+
+		if (save.sceneGeneration == sceneGeneration) {
+			journalSceneFile = save.filepath;
+			SceneJournal::Reset(*save.contents, result.fileHash, result.fileSize, &journal);
+			SetJournaledEntities(save.contents, save.entities);
+			journaledAssets = save.assets;
+			journalNeedsCompaction = false;
+		}
+		else if (save.filepath == journalSceneFile) {
+			// The scene loaded since was read from the file this replaced, so its journal no longer fits
+			journalNeedsCompaction = true;
+		}
+	}
+#if defined(DEBUG) || defined(_DEBUG)
+	else {
+		printf("Failed to write scene %s\n", result.path.c_str());
+	}
+#endif
+
+	StartNextSave();
+
+	// Edits made while the file was being written
+	if (journalPending && !IsSaving()) {
+		journalPending = false;
+		JournalScene();
+	}
+
+	if (save.callback) save.callback(result);
+}
+
+/// <summary>
+/// Journals the entity edits made since the scene file was written or last
+/// journaled, so saving costs as much as what changed rather than the whole
+/// scene. Only entities marked as edited and ones that were added are
+/// recorded; the rest are only looked up, to find the ones that were removed.
+/// Once the journal outgrows the scene file, or an edit can't be journaled,
+/// the whole scene is saved instead, which starts a new journal.
+/// Streamed cell entities and assets aren't journaled.
+/// </summary>
+/// <returns>False if there's no scene file to journal on top of, or the journal couldn't be written</returns>
+bool SceneManager::JournalScene()
+{
+	if (*engineState != EngineState::EDITING || journalSceneFile.empty())
+		return false;
+
+	// Whatever the file being written misses is journaled once it's done
+	if (IsSaving()) {
+		journalPending = true;
+		return true;
+	}
+
+	uint64_t compactSize = (std::max)((uint64_t)SCENE_JOURNAL_COMPACT_SIZE, journal.baseSize);
+	if (journalNeedsCompaction || journal.journalSize > compactSize || !JournalAssetsMatch(journaledAssets)) {
+		SaveScene(journalSceneFile, currentSceneName);
+		return true;
+	}
+
+	try {
+		std::unordered_set<GameEntity*> streamedEntities = GetStreamedEntities();
+
+		std::vector<std::shared_ptr<GameEntity>> recordedEntities;
+		size_t keptCount = 0;
+		for (auto& ge : assetManager.globalEntities) {
+			if (streamedEntities.count(ge.get())) continue;
+
+			bool journaledBefore = journaledEntities.count(ge.get()) > 0;
+			if (journaledBefore) keptCount++;
+			if (!journaledBefore || editedEntities.count(ge.get())) {
+				recordedEntities.push_back(ge);
+			}
+		}
+
+		std::shared_ptr<SceneFileContents> current = std::make_shared<SceneFileContents>();
+		current->hasAssets = false;
+
+		std::vector<unsigned char> records;
+		std::vector<JournaledEntity> recorded;
+		uint32_t slotCount = journal.slotCount;
+
+		if (!recordedEntities.empty()) {
+			SceneAssetIndices assetIndices = MapAssetIndices(*current);
+
+			for (auto& ge : recordedEntities) {
+				JournaledEntity entry;
+				entry.entity = ge;
+				entry.contents = current;
+				entry.index = (uint32_t)current->entities.size();
+				CaptureEntity(*current, ge, assetIndices);
+
+				auto found = journaledEntities.find(ge.get());
+				if (found == journaledEntities.end()) {
+					entry.slot = slotCount++;
+					SceneJournal::AddEntity(*current, entry.index, entry.slot, &records);
+				}
+				else {
+					entry.slot = found->second.slot;
+					SceneJournal::AddEntityChanges(*found->second.contents, found->second.index, *current, entry.index, entry.slot, &records);
+				}
+				recorded.push_back(entry);
+			}
+		}
+
+		// Every journaled entity that's still here was counted, so fewer means some were removed
+		std::vector<GameEntity*> removed;
+		if (keptCount < journaledEntities.size()) {
+			std::unordered_set<GameEntity*> present;
+			for (auto& ge : assetManager.globalEntities) {
+				present.insert(ge.get());
+			}
+
+			for (auto& journaledEntity : journaledEntities) {
+				if (present.count(journaledEntity.first) && !streamedEntities.count(journaledEntity.first)) continue;
+
+				SceneJournal::AddRemoval(journaledEntity.second.slot, &records);
+				removed.push_back(journaledEntity.first);
+			}
+		}
+
+		if (!records.empty()) {
+			std::string journalPath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, journalSceneFile) + SCENE_JOURNAL_EXTENSION;
+			if (journal.journalSize == 0) {
+				if (!SceneJournal::Create(journalPath, journal.baseHash, journal.baseSize)) return false;
+				journal.journalSize = sizeof(SceneJournalHeader);
+			}
+
+			if (!SceneJournal::Append(journalPath, records)) {
+				// It may have been left with part of a record, so it can't be added to
+				journalNeedsCompaction = true;
+				return false;
+			}
+			journal.journalSize += records.size();
+		}
+
+		for (const JournaledEntity& entry : recorded) {
+			journaledEntities[entry.entity.get()] = entry;
+		}
+		for (GameEntity* ge : removed) {
+			journaledEntities.erase(ge);
+		}
+		journal.slotCount = slotCount;
+		editedEntities.clear();
+		return true;
+	}
+	catch (...) {
+#if defined(DEBUG) || defined(_DEBUG)
+		printf("Failed to journal scene %s\n", journalSceneFile.c_str());
+#endif
+		return false;
+	}
+}
+
+/// <summary>
+/// Marks an entity the editor changed, so the next journal records it
+/// </summary>
+void SceneManager::MarkEntityEdited(std::shared_ptr<GameEntity> entity)
+{
+	if (entity != nullptr) editedEntities.insert(entity.get());
+}
+
+/// <summary>
+/// Journals on top of a scene file that was just loaded
+/// </summary>
+/// <param name="filepath">Path to the scene file</param>
+/// <param name="state">Where the loaded scene stands relative to its journal</param>
+void SceneManager::StartJournal(std::string filepath, const SceneJournalState& state)
+{
+	std::shared_ptr<SceneFileContents> contents = std::make_shared<SceneFileContents>();
+	contents->hasAssets = false;
+
+	// Recorded from the entities rather than taken from the file, so anything
+	// loading changes, like particles starting disabled, isn't journaled as an edit
+	std::vector<std::shared_ptr<GameEntity>> entities;
+	CaptureEntities(*contents, &entities);
+
+	journalSceneFile = filepath;
+	journal = state;
+	journalNeedsCompaction = journal.slots.size() != entities.size();
+	SetJournaledEntities(contents, entities);
+	journaledAssets = CaptureJournalAssets();
+	journalPending = false;
+}
+
+/// <summary>
+/// Stops journaling, for when the entities no longer come from the journaled file
+/// </summary>
+void SceneManager::StopJournal()
+{
+	journalSceneFile = "";
+	journal = SceneJournalState();
+	journaledEntities.clear();
+	editedEntities.clear();
+	journaledAssets = JournalAssets();
+	journalNeedsCompaction = false;
+	journalPending = false;
+}
+
+/// <summary>
+/// Sets the entities as they're recorded in the scene file journaled on top of
+/// </summary>
+/// <param name="contents">The entities' records, in the same order as the journal's slots</param>
+/// <param name="entities">The entity each record was made from</param>
+void SceneManager::SetJournaledEntities(std::shared_ptr<const SceneFileContents> contents, const std::vector<std::shared_ptr<GameEntity>>& entities)
+{
+	journaledEntities.clear();
+	journaledEntities.reserve(entities.size());
+
+	for (uint32_t i = 0; i < entities.size(); i++) {
+		JournaledEntity entry;
+		entry.entity = entities[i];
+		entry.contents = contents;
+		entry.index = i;
+		// A mismatch already has the journal compacted, so any unused slot will do
+		entry.slot = i < journal.slots.size() ? journal.slots[i] : journal.slotCount++;
+		journaledEntities[entry.entity.get()] = entry;
+	}
+}
+
+/// <summary>
+/// Records the assets entities can reference, which a journal can't hold
+/// </summary>
+SceneManager::JournalAssets SceneManager::CaptureJournalAssets()
+{
+	JournalAssets assets;
+	CaptureWeak(assetManager.globalMeshes, &assets.meshes);
+	CaptureWeak(assetManager.globalMaterials, &assets.materials);
+	CaptureWeak(assetManager.globalTerrainMaterials, &assets.terrainMaterials);
+	return assets;
+}
+
+/// <summary>
+/// Checks that every asset entities can reference is still the one
+/// at the same index, so journaled indices still point at it
+/// </summary>
+bool SceneManager::JournalAssetsMatch(const JournalAssets& assets)
+{
+	return WeakMatch(assets.meshes, assetManager.globalMeshes) &&
+		WeakMatch(assets.materials, assetManager.globalMaterials) &&
+		WeakMatch(assets.terrainMaterials, assetManager.globalTerrainMaterials);
+}
+
+/// <summary>
+/// Checks whether any save is still being written or waiting to be
+/// </summary>
+bool SceneManager::IsSaving()
+{
+	return activeSaveResult.valid() || !queuedSaves.empty();
+}
+
+/// <summary>
+/// Blocks until every save has been written, reporting each as it finishes
+/// </summary>
+void SceneManager::WaitForSaves()
+{
+	while (activeSaveResult.valid()) {
+		activeSaveResult.wait();
+		FinishSave(activeSave.id);
+	}
+}
+
+/// <summary>
+/// Gets how the last save that was written went
+/// </summary>
+SceneSaveResult SceneManager::GetLastSaveResult()
+{
+	return lastSaveResult;
+}
+
+/// <summary>
+/// Saves the state of the entities in the scene before moving to play state
+/// </summary>
+void SceneManager::PrePlaySave()
+{
+	if (*engineState != EngineState::EDITING)
+		return;
+
+	try {
+		CapturePlaySnapshot();
+
+		*engineState = EngineState::PLAY;
+	}
+	catch (...) {
+#if defined(DEBUG) || defined(_DEBUG)
+		printf("Failed to save pre-play scene with error:\n %s \n", std::current_exception());
+#endif
+	}
+}
+
+/// <summary>
+/// Records the scene's entities as they are now, for PostPlayLoad to put back
+/// </summary>
+void SceneManager::CapturePlaySnapshot()
+{
+	// Kept in memory, since nobody reads it but PostPlayLoad
+	playSnapshot.Clear();
+	playSnapshot.hasAssets = false;
+	playSnapshotComponents.clear();
+
+	// Streamed entities are left out, so they're removed after play and stream back in from their cells' files
+	std::unordered_set<GameEntity*> streamedEntities = GetStreamedEntities();
+
+	playSnapshotEntities.clear();
+	for (auto ge : assetManager.globalEntities) {
+		if (!streamedEntities.count(ge.get())) {
+			playSnapshotEntities.push_back(ge);
+		}
+	}
+
+	SceneAssetIndices assetIndices = MapAssetIndices(playSnapshot);
+
+	playSnapshot.entities.reserve(playSnapshotEntities.size());
+	for (auto ge : playSnapshotEntities) {
+		CaptureEntity(playSnapshot, ge, assetIndices, &playSnapshotComponents);
+	}
+}
+
+/// <summary>
+/// Loads the state of the scene how it was just before moving to play state.
+/// Only entities and components play created, destroyed or changed are touched.
+/// </summary>
+void SceneManager::PostPlayLoad()
+{
+	if (*engineState != EngineState::PLAY)
+		return;
+
+//	try {
+		*engineState = EngineState::UNLOAD_PLAY;
+
+		std::unordered_set<GameEntity*> snapshotEntities;
+		for (auto& ge : playSnapshotEntities) {
+			snapshotEntities.insert(ge.get());
+		}
+
+		// Entities created during play are removed outright
+		std::unordered_set<GameEntity*> survivingEntities;
+		for (int i = (int)assetManager.globalEntities.size() - 1; i >= 0; i--) {
+			GameEntity* ge = assetManager.globalEntities[i].get();
+			if (snapshotEntities.count(ge)) {
+				survivingEntities.insert(ge);
+			}
+			else {
+				assetManager.RemoveGameEntity(i);
+			}
+		}
+
+		// That included every streamed entity, so the cells start over unloaded
+		ResetStreaming(true);
+
+		SceneFileContents current;
+		current.hasAssets = false;
+		SceneAssetIndices assetIndices = MapAssetIndices(current);
+
+		std::vector<std::shared_ptr<GameEntity>> restoredEntities;
+		restoredEntities.reserve(playSnapshotEntities.size());
+		for (uint32_t i = 0; i < playSnapshot.entities.size(); i++) {
+			if (survivingEntities.count(playSnapshotEntities[i].get())) {
+				RestoreEntity(i, current, assetIndices);
+				restoredEntities.push_back(playSnapshotEntities[i]);
+			}
+			else {
+				// Destroyed during play, so it has to be made again
+				restoredEntities.push_back(LoadEntity(playSnapshot, playSnapshot.entities[i]));
+			}
+		}
+
+		// Recreated entities were added to the end, so put everything back in its pre-play order
+		assetManager.globalEntities = restoredEntities;
+
+		playSnapshot.Clear();
+		playSnapshotEntities.clear();
+		playSnapshotComponents.clear();
+
+		*engineState = EngineState::EDITING;
+//	}
 //	catch (...) {
 
 //	}
 }
+
+/// <summary>
+/// Puts an entity that lasted through play back how it was before play
+/// </summary>
+/// <param name="snapshotIndex">The entity's index in the play snapshot</param>
+/// <param name="current">Scratch contents to record the entity's current state in</param>
+/// <param name="assetIndices">From MapAssetIndices for current</param>
+void SceneManager::RestoreEntity(uint32_t snapshotIndex, SceneFileContents& current, const SceneAssetIndices& assetIndices)
+{
+	std::shared_ptr<GameEntity> ge = playSnapshotEntities[snapshotIndex];
+	const SceneFileEntity& snapshotEntity = playSnapshot.entities[snapshotIndex];
+
+	std::vector<std::shared_ptr<IComponent>> currentComponents;
+	CaptureEntity(current, ge, assetIndices, &currentComponents);
+	const SceneFileEntity& currentEntity = current.entities.back();
+
+	const std::string& name = playSnapshot.GetString(snapshotEntity.name);
+	if (ge->GetName() != name) {
+		ge->SetName(name);
+	}
+
+	if (currentEntity.flags != snapshotEntity.flags) {
+		ge->SetEnabled((snapshotEntity.flags & SCENE_FLAG_ENABLED) != 0);
+	}
+
+	std::shared_ptr<Transform> transform = ge->GetTransform();
+	if (memcmp(currentEntity.position, snapshotEntity.position, sizeof(snapshotEntity.position)) != 0) {
+		transform->SetPosition(DirectX::XMFLOAT3(snapshotEntity.position));
+	}
+	if (memcmp(currentEntity.rotation, snapshotEntity.rotation, sizeof(snapshotEntity.rotation)) != 0) {
+		transform->SetRotation(DirectX::XMFLOAT3(snapshotEntity.rotation));
+	}
+	if (memcmp(currentEntity.scale, snapshotEntity.scale, sizeof(snapshotEntity.scale)) != 0) {
+		transform->SetScale(DirectX::XMFLOAT3(snapshotEntity.scale));
+	}
+
+	// Components still on the entity, in the state they were recorded in, are left alone
+	std::vector<std::shared_ptr<IComponent>> keptComponents;
+	std::vector<uint32_t> changedComponents;
+	for (uint32_t c = snapshotEntity.firstComponent; c < snapshotEntity.firstComponent + snapshotEntity.componentCount; c++) {
+		bool unchanged = false;
+		for (uint32_t k = 0; k < currentComponents.size(); k++) {
+			if (currentComponents[k] == playSnapshotComponents[c] &&
+				SceneFile::ComponentsEqual(playSnapshot, playSnapshot.components[c], current, current.components[currentEntity.firstComponent + k])) {
+				keptComponents.push_back(currentComponents[k]);
+				unchanged = true;
+				break;
+			}
+		}
+
+		if (!unchanged) {
+			changedComponents.push_back(c);
+		}
+	}
+
+	// Everything else was added or changed during play. Changed
+	// components are made again from how they were recorded.
+	for (auto co : ge->GetAllComponents()) {
+		if (std::find(keptComponents.begin(), keptComponents.end(), co) == keptComponents.end()) {
+			ge->RemoveComponent(co);
+		}
+	}
+
+	for (uint32_t c : changedComponents) {
+		LoadComponent(playSnapshot, ge, playSnapshot.components[c]);
+	}
+}
+
+/// <summary>
+/// Sets up streaming for a newly loaded scene's cells. Nothing is read
+/// until UpdateSceneStreaming finds the camera near a cell.
+/// </summary>
+/// <param name="contents">The loaded scene</param>
+void SceneManager::StartStreaming(const SceneFileContents& contents)
+{
+	ResetStreaming(false);
+
+	for (const SceneFileCell& record : contents.cells) {
+		StreamedCell cell;
+		cell.bounds = record;
+		cell.path = contents.GetString(record.path);
+		streamedCells.push_back(cell);
+
+		cellStreamer.AddCell(record.minX, record.minZ, record.maxX, record.maxZ);
+	}
+}
+
+/// <summary>
+/// Forgets every cell's entities and drops any reads still going.
+/// The entities themselves have to have been removed already.
+/// </summary>
+/// <param name="keepCells">Whether to keep the cells to stream in again, rather than stop streaming</param>
+void SceneManager::ResetStreaming(bool keepCells)
+{
+	streamingGeneration++;
+
+	if (!keepCells) {
+		streamedCells.clear();
+		cellStreamer.Clear();
+		return;
+	}
+
+	for (StreamedCell& cell : streamedCells) {
+		cell.contents = nullptr;
+		cell.entities.clear();
+	}
+	cellStreamer.UnloadAll();
+}
+
+/// <summary>
+/// Reads and parses a cell's file in the background. Its entities are
+/// made on the main thread afterwards, by UpdateSceneStreaming.
+/// </summary>
+/// <param name="id">The cell to read</param>
+void SceneManager::ReadStreamedCell(uint32_t id)
+{
+	uint32_t generation = streamingGeneration;
+	std::string namePath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, streamedCells[id].path);
+
+	AsyncFileReader::GetInstance().Read(namePath, ASYNC_READ_PRIORITY_NORMAL, [this, id, generation](AsyncReadResult& result) {
+		std::shared_ptr<AsyncReadResult> data = std::make_shared<AsyncReadResult>(std::move(result));
+
+		// Parsed on a worker, so the I/O thread can get on with the next read
+		JobSystem::GetInstance().Schedule([this, id, generation, data]() {
+			std::shared_ptr<SceneFileContents> contents = std::make_shared<SceneFileContents>();
+			bool succeeded = data->succeeded && SceneFile::Read(data->data.data(), data->data.size(), contents.get());
+
+			JobSystem::GetInstance().QueueMainThreadJob([this, id, generation, contents, succeeded]() {
+				// The scene changed, or play ended, while it was reading
+				if (generation != streamingGeneration) return;
+
+				if (!succeeded) {
+#if defined(DEBUG) || defined(_DEBUG)
+					printf("Failed to stream scene cell %s\n", streamedCells[id].path.c_str());
+#endif
+					cellStreamer.CompleteChange(id, true);
+					return;
+				}
+
+				streamedCells[id].contents = contents;
+			});
+		});
+	});
+}
+
+/// <summary>
+/// Removes a streamed entity from the scene, unless something else already has
+/// </summary>
+void SceneManager::RemoveStreamedEntity(std::shared_ptr<GameEntity> entity)
+{
+	for (int i = (int)assetManager.globalEntities.size() - 1; i >= 0; i--) {
+		if (assetManager.globalEntities[i] == entity) {
+			assetManager.RemoveGameEntity(i);
+			return;
+		}
+	}
+}
+
+/// <summary>
+/// Gets every entity that belongs to a streamed cell rather than the persistent layer
+/// </summary>
+std::unordered_set<GameEntity*> SceneManager::GetStreamedEntities()
+{
+	std::unordered_set<GameEntity*> entities;
+	for (const StreamedCell& cell : streamedCells) {
+		for (const std::shared_ptr<GameEntity>& entity : cell.entities) {
+			entities.insert(entity.get());
+		}
+	}
+
+	return entities;
+}
+
+/// <summary>
+/// Loads and unloads the scene's cells around a camera. Cells are read and
+/// parsed in the background, and their entities are made and removed a few
+/// per frame, so streaming never waits on a file or hitches on a big cell.
+/// </summary>
+/// <param name="camera">The camera to stream around</param>
+void SceneManager::UpdateSceneStreaming(std::shared_ptr<Camera> camera)
+{
+	if (streamedCells.empty() || camera == nullptr) return;
+	if (*engineState != EngineState::EDITING && *engineState != EngineState::PLAY) return;
+
+	DirectX::XMFLOAT3 cameraPosition = camera->GetTransform()->GetGlobalPosition();
+
+	std::vector<SceneCellChange> changes;
+	cellStreamer.Update(cameraPosition.x, cameraPosition.z, &changes);
+
+	// Unloads are picked up below, since the cell is already marked as unloading
+	for (const SceneCellChange& change : changes) {
+		if (!change.unload) {
+			ReadStreamedCell(change.id);
+		}
+	}
+
+	size_t budget = SCENE_STREAMING_ENTITY_LIMIT;
+	for (uint32_t id = 0; id < streamedCells.size() && budget > 0; id++) {
+		StreamedCell& cell = streamedCells[id];
+
+		SceneCellStatus status;
+		cellStreamer.GetStatus(id, &status);
+
+		if (status.state == SCENE_CELL_UNLOADING) {
+			for (; budget > 0 && !cell.entities.empty(); budget--) {
+				RemoveStreamedEntity(cell.entities.back());
+				cell.entities.pop_back();
+			}
+
+			if (cell.entities.empty()) {
+				cellStreamer.CompleteChange(id);
+			}
+		}
+		else if (status.state == SCENE_CELL_LOADING && cell.contents != nullptr) {
+			const std::vector<SceneFileEntity>& entities = cell.contents->entities;
+			for (; budget > 0 && cell.entities.size() < entities.size(); budget--) {
+				cell.entities.push_back(LoadEntity(*cell.contents, entities[cell.entities.size()]));
+			}
+
+			if (cell.entities.size() == entities.size()) {
+				cell.contents = nullptr;
+				cellStreamer.CompleteChange(id);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Checks whether an entity was made from one of the scene's cells. Those
+/// aren't saved or journaled, since they're only ever read from the cell files.
+/// </summary>
+bool SceneManager::IsStreamedEntity(std::shared_ptr<GameEntity> entity)
+{
+	for (const StreamedCell& cell : streamedCells) {
+		for (const std::shared_ptr<GameEntity>& cellEntity : cell.entities) {
+			if (cellEntity == entity) return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Finds a streamed entity by handle
+/// </summary>
+/// <returns>The entity, or null if its cell isn't loaded</returns>
+std::shared_ptr<GameEntity> SceneManager::FindStreamedEntity(SceneEntityHandle handle)
+{
+	if (handle.cell >= streamedCells.size()) return nullptr;
+
+	const StreamedCell& cell = streamedCells[handle.cell];
+	if (handle.entity >= cell.entities.size()) return nullptr;
+
+	return cell.entities[handle.entity];
+}
+
+SceneCellStreamingStats SceneManager::GetSceneStreamingStats()
+{
+	return cellStreamer.GetStats();
+}
+
+/// <summary>
+/// Converts a scene between JSON and the binary format, in either direction,
+/// without loading it. Formats are picked by extension.
+/// </summary>
+/// <param name="sourcePath">Path to the scene to convert</param>
+/// <param name="destinationPath">Path to write the converted scene to</param>
+/// <returns>False if the source couldn't be read or the destination couldn't be written</returns>
+bool SceneManager::ConvertScene(std::string sourcePath, std::string destinationPath)
+{
+	try {
+		SceneFileContents contents;
+		if (!ReadSceneFile(assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, sourcePath), contents)) {
+			return false;
+		}
+
+		return WriteSceneFile(assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, destinationPath), contents);
+	}
+	catch (...) {
+#if defined(DEBUG) || defined(_DEBUG)
+		printf("Failed to convert scene %s\n", sourcePath.c_str());
+#endif
+		return false;
+	}
+}
+
+/// <summary>
+/// Splits a scene into a grid of streamed cells, without loading it. Cameras,
+/// player controllers, terrain and directional lights stay in the persistent
+/// layer, and every other entity goes in the cell its position falls in. Each
+/// cell is written next to the destination as its own entity-only file.
+/// </summary>
+/// <param name="sourcePath">Path to the scene to split</param>
+/// <param name="destinationPath">Path to write the persistent layer to. Has
+/// to be a binary scene, since JSON scenes can't hold cells.</param>
+/// <param name="cellSize">Width of each cell along X and Z</param>
+/// <returns>False if the source couldn't be read or anything couldn't be written</returns>
+bool SceneManager::PartitionScene(std::string sourcePath, std::string destinationPath, float cellSize)
+{
+	if (!IsBinaryScene(destinationPath) || cellSize <= 0.0f) {
+		return false;
+	}
+
+	try {
+		SceneFileContents source;
+		if (!ReadSceneFile(assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, sourcePath), source)) {
+			return false;
+		}
+
+		auto isPersistent = [&](const SceneFileEntity& entity) {
+			for (uint32_t c = entity.firstComponent; c < entity.firstComponent + entity.componentCount; c++) {
+				const SceneFileComponent& component = source.components[c];
+				if (component.schema == SCENE_SCHEMA_CAMERA ||
+					component.schema == SCENE_SCHEMA_NOCLIP_MOVEMENT ||
+					component.schema == SCENE_SCHEMA_FLASHLIGHT_CONTROLLER ||
+					component.schema == SCENE_SCHEMA_TERRAIN) {
+					return true;
+				}
+
+				// Directional lights light everything, wherever they are
+				if (component.schema == SCENE_SCHEMA_LIGHT && source.lights[component.index].type == 0.0f) {
+					return true;
+				}
+			}
+			return false;
+		};
+
+		// The persistent layer keeps all the assets, and only its own entities
+		SceneFileContents persistent = source;
+		persistent.ClearEntities();
+		persistent.cells.clear();
+
+		// Ordered by coordinate, so the same scene always splits into the same cell ids
+		std::map<std::pair<int32_t, int32_t>, SceneFileContents> cells;
+		for (uint32_t i = 0; i < source.entities.size(); i++) {
+			const SceneFileEntity& entity = source.entities[i];
+			if (isPersistent(entity)) {
+				persistent.CopyEntity(source, i);
+				continue;
+			}
+
+			std::pair<int32_t, int32_t> coordinate((int32_t)floorf(entity.position[0] / cellSize), (int32_t)floorf(entity.position[2] / cellSize));
+			SceneFileContents& cell = cells[coordinate];
+			cell.hasAssets = false;
+			cell.name = source.name;
+			cell.CopyEntity(source, i);
+		}
+
+		std::string basePath = destinationPath.substr(0, destinationPath.size() - strlen(SCENE_FILE_EXTENSION));
+		for (const auto& cell : cells) {
+			std::string cellPath = basePath + "." + std::to_string(cell.first.first) + "_" + std::to_string(cell.first.second) + SCENE_FILE_EXTENSION;
+			if (!WriteSceneFile(assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, cellPath), cell.second)) {
+				return false;
+			}
+
+			SceneFileCell record;
+			record.minX = cell.first.first * cellSize;
+			record.minZ = cell.first.second * cellSize;
+			record.maxX = record.minX + cellSize;
+			record.maxZ = record.minZ + cellSize;
+			record.path = persistent.AddString(cellPath);
+			persistent.cells.push_back(record);
+		}
+
+		return WriteSceneFile(assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, destinationPath), persistent);
+	}
+	catch (...) {
+#if defined(DEBUG) || defined(_DEBUG)
+		printf("Failed to partition scene %s\n", sourcePath.c_str());
+#endif
+		return false;
+	}
+}
+
+/// <summary>
+/// Reads a JSON scene both into a document, the way scenes used to be
+/// read, and by streaming it, without loading either. Document memory is
+/// only the document itself, which used to be held on top of the scene
+/// contents streaming ends up with.
+/// </summary>
+/// <param name="filepath">Path to the JSON scene</param>
+/// <returns>Times and memory for both ways of reading</returns>
+SceneLoadBenchmark SceneManager::BenchmarkJsonLoad(std::string filepath)
+{
+	SceneLoadBenchmark benchmark;
+
+	std::string namePath = assetManager.GetFullPathToAssetFile(AssetPathIndex::ASSET_SCENE_PATH, filepath);
+	AsyncReadResult sceneData = AsyncFileReader::GetInstance().Read(namePath, ASYNC_READ_PRIORITY_HIGH).get();
+	if (!sceneData.succeeded) {
+		return benchmark;
+	}
+
+	{
+		double startTime = GetSeconds();
+
+		rapidjson::Document sceneDoc;
+		rapidjson::MemoryStream sceneFileStream(sceneData.data.data(), sceneData.data.size());
+		sceneDoc.ParseStream(sceneFileStream);
+
+		// No entity could be made until the whole document was parsed
+		benchmark.documentTime = GetSeconds() - startTime;
+		benchmark.documentFirstEntityTime = benchmark.documentTime;
+		benchmark.documentMemory = sceneDoc.GetAllocator().Size();
+
+		if (sceneDoc.HasParseError()) {
+			return benchmark;
+		}
+	}
+
+	{
+		double startTime = GetSeconds();
+
+		SceneFileContents contents;
+		SceneJsonReader reader(&contents, {}, [](const SceneFileContents& readContents, uint32_t entityIndex) {
+			return true;
+		});
+		benchmark.succeeded = reader.Read(sceneData.data.data(), sceneData.data.size());
+
+		benchmark.streamTime = GetSeconds() - startTime;
+		benchmark.streamFirstEntityTime = reader.GetFirstEntityTime();
+		benchmark.streamMemory = contents.GetMemoryUsage();
+	}
+
+	{
+		double startTime = GetSeconds();
+
+		std::shared_ptr<JsonSceneRead> read = StartJsonRead(std::move(sceneData.data));
+		benchmark.workerFirstEntityTime = -1.0;
+
+		bool finished = false;
+		while (!finished) {
+			std::shared_ptr<SceneFileContents> assets;
+			std::deque<std::shared_ptr<SceneFileContents>> entities;
+			finished = TakeJsonRecords(*read, &assets, &entities);
+
+			if (!entities.empty() && benchmark.workerFirstEntityTime < 0.0) {
+				benchmark.workerFirstEntityTime = GetSeconds() - startTime;
+			}
+		}
+		read->result.wait();
+
+		benchmark.workerTime = GetSeconds() - startTime;
+	}
+
+#if defined(DEBUG) || defined(_DEBUG)
+	printf("Scene %s as a document: %.2fms, first entity at %.2fms, %zu bytes\n", filepath.c_str(),
+		benchmark.documentTime * 1000.0, benchmark.documentFirstEntityTime * 1000.0, benchmark.documentMemory);
+	printf("Scene %s streamed: %.2fms, first entity at %.2fms, %zu bytes\n", filepath.c_str(),
+		benchmark.streamTime * 1000.0, benchmark.streamFirstEntityTime * 1000.0, benchmark.streamMemory);
+	printf("Scene %s streamed on a worker: %.2fms, first entity at %.2fms\n", filepath.c_str(),
+		benchmark.workerTime * 1000.0, benchmark.workerFirstEntityTime * 1000.0);
+#endif
+
+	return benchmark;
+}
@@ -0,0 +1,321 @@
+#include "../Headers/ShaderReflectionFile.h"
+#include <experimental/filesystem>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+// 64 bit FNV-1a, same as AssetCache. The offset is Checksum's default seed.
+static const uint64_t fnvPrime = 1099511628211ull;
+
+// D3D_CBUFFER_TYPE and D3D_REGISTER_COMPONENT_TYPE end here, anything past them is damage
+static const uint32_t maxBufferType = 3;
+static const uint32_t maxComponentType = 3;
+
+std::atomic<uint64_t> ShaderReflectionFile::hitCount(0);
+std::atomic<uint64_t> ShaderReflectionFile::missCount(0);
+std::atomic<uint64_t> ShaderReflectionFile::corruptCount(0);
+std::atomic<uint64_t> ShaderReflectionFile::writeCount(0);
+std::atomic<uint64_t> ShaderReflectionFile::failedWriteCount(0);
+
+#pragma region naming
+uint64_t ShaderReflectionFile::HashBytecode(const void* bytecode, size_t size) {
+	return Checksum((const unsigned char*)bytecode, size);
+}
+
+std::string ShaderReflectionFile::GetCachePath(const std::string& cacheFolder, uint64_t bytecodeHash) {
+	char name[20];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)bytecodeHash);
+
+	return cacheFolder + name + SHADER_REFLECTION_FILE_EXTENSION;
+}
+
+bool ShaderReflectionFile::ParseCachePath(const std::string& path, uint64_t* bytecodeHash) {
+	std::string fileName = path.substr(path.find_last_of("\\/") + 1);
+	std::string extension = SHADER_REFLECTION_FILE_EXTENSION;
+
+	if (fileName.size() != 16 + extension.size() || fileName.compare(16, extension.size(), extension) != 0) return false;
+
+	char* end = nullptr;
+	std::string hex = fileName.substr(0, 16);
+	unsigned long long hash = strtoull(hex.c_str(), &end, 16);
+	if (end != hex.c_str() + hex.size()) return false;
+
+	*bytecodeHash = hash;
+	return true;
+}
+#pragma endregion
+
+#pragma region reading
+bool ShaderReflectionFile::Read(const std::string& path, uint64_t bytecodeHash, uint64_t bytecodeSize, ShaderReflection* reflection) {
+	MappedFile file;
+	if (path.empty() || !file.Open(path)) {
+		missCount++;
+		return false;
+	}
+
+	if (!Decode(file.GetData(), file.GetSize(), bytecodeHash, bytecodeSize, reflection)) {
+		// A truncated or damaged file would fail every launch, so it's removed for the rewrite
+		file.Close();
+		std::remove(path.c_str());
+
+		corruptCount++;
+		missCount++;
+		return false;
+	}
+
+	hitCount++;
+	return true;
+}
+
+bool ShaderReflectionFile::Decode(const unsigned char* data, size_t size, uint64_t bytecodeHash, uint64_t bytecodeSize, ShaderReflection* reflection) {
+	if (size < sizeof(ShaderReflectionFileHeader)) return false;
+
+	const ShaderReflectionFileHeader* header = (const ShaderReflectionFileHeader*)data;
+	if (header->magic != SHADER_REFLECTION_FILE_MAGIC ||
+		header->version != SHADER_REFLECTION_FILE_VERSION ||
+		header->headerSize != sizeof(ShaderReflectionFileHeader) ||
+		header->bytecodeHash != bytecodeHash ||
+		header->bytecodeSize != bytecodeSize) {
+		return false;
+	}
+
+	// Sizes are added up as 64 bit, so counts from a damaged header can't wrap around
+	uint64_t recordsSize =
+		(uint64_t)header->bufferCount * sizeof(ShaderReflectionFileBuffer) +
+		(uint64_t)header->variableCount * sizeof(ShaderReflectionFileVariable) +
+		((uint64_t)header->textureCount + header->samplerCount + header->uavCount) * sizeof(ShaderReflectionFileResource) +
+		(uint64_t)header->inputCount * sizeof(ShaderReflectionFileInput);
+
+	const unsigned char* payload = data + sizeof(ShaderReflectionFileHeader);
+	if (header->payloadSize != size - sizeof(ShaderReflectionFileHeader) ||
+		header->payloadSize != recordsSize + header->stringsSize ||
+		header->payloadChecksum != GetPayloadChecksum(*header, payload)) {
+		return false;
+	}
+
+	const ShaderReflectionFileBuffer* buffers = (const ShaderReflectionFileBuffer*)payload;
+	const ShaderReflectionFileVariable* variables = (const ShaderReflectionFileVariable*)(buffers + header->bufferCount);
+	const ShaderReflectionFileResource* textures = (const ShaderReflectionFileResource*)(variables + header->variableCount);
+	const ShaderReflectionFileResource* samplers = textures + header->textureCount;
+	const ShaderReflectionFileResource* uavs = samplers + header->samplerCount;
+	const ShaderReflectionFileInput* inputs = (const ShaderReflectionFileInput*)(uavs + header->uavCount);
+	const char* strings = (const char*)(inputs + header->inputCount);
+
+	// The checksum matched, so anything out of range is from a writer that disagrees about the layout
+	auto nameInRange = [&](uint32_t offset, uint32_t length) {
+		return (uint64_t)offset + length <= header->stringsSize;
+	};
+
+	uint64_t nextVariable = 0;
+	for (uint32_t b = 0; b < header->bufferCount; b++) {
+		const ShaderReflectionFileBuffer& buffer = buffers[b];
+		if (!nameInRange(buffer.nameOffset, buffer.nameLength) || buffer.type > maxBufferType) return false;
+
+		// Every variable belongs to exactly one buffer, in order
+		if (buffer.firstVariable != nextVariable) return false;
+		nextVariable += buffer.variableCount;
+		if (nextVariable > header->variableCount) return false;
+
+		for (uint32_t v = buffer.firstVariable; v < buffer.firstVariable + buffer.variableCount; v++) {
+			if (!nameInRange(variables[v].nameOffset, variables[v].nameLength) ||
+				(uint64_t)variables[v].byteOffset + variables[v].size > buffer.size) {
+				return false;
+			}
+		}
+	}
+
+	if (nextVariable != header->variableCount) return false;
+
+	for (uint64_t r = 0; r < (uint64_t)header->textureCount + header->samplerCount + header->uavCount; r++) {
+		if (!nameInRange(textures[r].nameOffset, textures[r].nameLength)) return false;
+	}
+
+	for (uint32_t i = 0; i < header->inputCount; i++) {
+		if (!nameInRange(inputs[i].nameOffset, inputs[i].nameLength) ||
+			inputs[i].mask > 15 || inputs[i].componentType > maxComponentType) {
+			return false;
+		}
+	}
+
+	if (reflection == nullptr) return true;
+
+	reflection->constantBuffers.resize(header->bufferCount);
+	for (uint32_t b = 0; b < header->bufferCount; b++) {
+		ShaderReflectionBuffer& buffer = reflection->constantBuffers[b];
+		buffer.name.assign(strings + buffers[b].nameOffset, buffers[b].nameLength);
+		buffer.type = buffers[b].type;
+		buffer.bindIndex = buffers[b].bindIndex;
+		buffer.size = buffers[b].size;
+
+		buffer.variables.resize(buffers[b].variableCount);
+		for (uint32_t v = 0; v < buffers[b].variableCount; v++) {
+			const ShaderReflectionFileVariable& variable = variables[buffers[b].firstVariable + v];
+			buffer.variables[v].name.assign(strings + variable.nameOffset, variable.nameLength);
+			buffer.variables[v].byteOffset = variable.byteOffset;
+			buffer.variables[v].size = variable.size;
+		}
+	}
+
+	auto readResources = [&](const ShaderReflectionFileResource* resources, uint32_t count, std::vector<ShaderReflectionResource>* output) {
+		output->resize(count);
+		for (uint32_t r = 0; r < count; r++) {
+			(*output)[r].name.assign(strings + resources[r].nameOffset, resources[r].nameLength);
+			(*output)[r].bindIndex = resources[r].bindIndex;
+		}
+	};
+
+	readResources(textures, header->textureCount, &reflection->textures);
+	readResources(samplers, header->samplerCount, &reflection->samplers);
+	readResources(uavs, header->uavCount, &reflection->unorderedAccessViews);
+	memcpy(reflection->threadGroupSize, header->threadGroupSize, sizeof(reflection->threadGroupSize));
+
+	reflection->inputs.resize(header->inputCount);
+	for (uint32_t i = 0; i < header->inputCount; i++) {
+		ShaderReflectionInput& input = reflection->inputs[i];
+		input.semanticName.assign(strings + inputs[i].nameOffset, inputs[i].nameLength);
+		input.semanticIndex = inputs[i].semanticIndex;
+		input.mask = inputs[i].mask;
+		input.componentType = inputs[i].componentType;
+	}
+
+	return true;
+}
+#pragma endregion
+
+#pragma region writing
+bool ShaderReflectionFile::Write(const std::string& path, uint64_t bytecodeHash, uint64_t bytecodeSize, const ShaderReflection& reflection) {
+	std::vector<unsigned char> output;
+	if (path.empty() || !Encode(bytecodeHash, bytecodeSize, reflection, &output)) {
+		failedWriteCount++;
+		return false;
+	}
+
+	std::error_code error;
+	std::experimental::filesystem::create_directories(std::experimental::filesystem::path(path).parent_path(), error);
+
+	// Written to a temporary file and renamed, so a crash mid-write can't leave a partial cache file
+	bool written = MappedFile::WriteWholeFile(path, output.data(), output.size());
+	if (written) writeCount++;
+	else failedWriteCount++;
+
+	return written;
+}
+
+bool ShaderReflectionFile::Encode(uint64_t bytecodeHash, uint64_t bytecodeSize, const ShaderReflection& reflection, std::vector<unsigned char>* output) {
+	std::vector<ShaderReflectionFileBuffer> buffers;
+	std::vector<ShaderReflectionFileVariable> variables;
+	std::vector<ShaderReflectionFileResource> resources;
+	std::vector<ShaderReflectionFileInput> inputs;
+	std::string strings;
+
+	bool fits = true;
+	auto addName = [&](const std::string& name, uint32_t* offset, uint32_t* length) {
+		if ((uint64_t)strings.size() + name.size() > UINT32_MAX) fits = false;
+
+		*offset = (uint32_t)strings.size();
+		*length = (uint32_t)name.size();
+		strings += name;
+	};
+
+	for (const ShaderReflectionBuffer& buffer : reflection.constantBuffers) {
+		ShaderReflectionFileBuffer fileBuffer = {};
+		addName(buffer.name, &fileBuffer.nameOffset, &fileBuffer.nameLength);
+		fileBuffer.type = buffer.type;
+		fileBuffer.bindIndex = buffer.bindIndex;
+		fileBuffer.size = buffer.size;
+		fileBuffer.firstVariable = (uint32_t)variables.size();
+		fileBuffer.variableCount = (uint32_t)buffer.variables.size();
+		buffers.push_back(fileBuffer);
+
+		for (const ShaderReflectionVariable& variable : buffer.variables) {
+			ShaderReflectionFileVariable fileVariable = {};
+			addName(variable.name, &fileVariable.nameOffset, &fileVariable.nameLength);
+			fileVariable.byteOffset = variable.byteOffset;
+			fileVariable.size = variable.size;
+			variables.push_back(fileVariable);
+		}
+	}
+
+	// Textures, samplers then UAVs, which the header tells apart by count
+	for (const std::vector<ShaderReflectionResource>* list : { &reflection.textures, &reflection.samplers, &reflection.unorderedAccessViews }) {
+		for (const ShaderReflectionResource& resource : *list) {
+			ShaderReflectionFileResource fileResource = {};
+			addName(resource.name, &fileResource.nameOffset, &fileResource.nameLength);
+			fileResource.bindIndex = resource.bindIndex;
+			resources.push_back(fileResource);
+		}
+	}
+
+	for (const ShaderReflectionInput& input : reflection.inputs) {
+		ShaderReflectionFileInput fileInput = {};
+		addName(input.semanticName, &fileInput.nameOffset, &fileInput.nameLength);
+		fileInput.semanticIndex = input.semanticIndex;
+		fileInput.mask = input.mask;
+		fileInput.componentType = input.componentType;
+		inputs.push_back(fileInput);
+	}
+
+	if (!fits) return false;
+
+	ShaderReflectionFileHeader header = {};
+	header.magic = SHADER_REFLECTION_FILE_MAGIC;
+	header.version = SHADER_REFLECTION_FILE_VERSION;
+	header.headerSize = sizeof(ShaderReflectionFileHeader);
+	header.bufferCount = (uint32_t)buffers.size();
+	header.variableCount = (uint32_t)variables.size();
+	header.textureCount = (uint32_t)reflection.textures.size();
+	header.samplerCount = (uint32_t)reflection.samplers.size();
+	header.uavCount = (uint32_t)reflection.unorderedAccessViews.size();
+	header.inputCount = (uint32_t)inputs.size();
+	header.stringsSize = (uint32_t)strings.size();
+	memcpy(header.threadGroupSize, reflection.threadGroupSize, sizeof(header.threadGroupSize));
+	header.bytecodeSize = bytecodeSize;
+	header.bytecodeHash = bytecodeHash;
+
+	output->clear();
+	output->resize(sizeof(ShaderReflectionFileHeader));
+
+	auto append = [&](const void* data, size_t size) {
+		if (size == 0) return;
+		output->insert(output->end(), (const unsigned char*)data, (const unsigned char*)data + size);
+	};
+
+	append(buffers.data(), buffers.size() * sizeof(ShaderReflectionFileBuffer));
+	append(variables.data(), variables.size() * sizeof(ShaderReflectionFileVariable));
+	append(resources.data(), resources.size() * sizeof(ShaderReflectionFileResource));
+	append(inputs.data(), inputs.size() * sizeof(ShaderReflectionFileInput));
+	append(strings.data(), strings.size());
+
+	header.payloadSize = output->size() - sizeof(ShaderReflectionFileHeader);
+	header.payloadChecksum = GetPayloadChecksum(header, output->data() + sizeof(ShaderReflectionFileHeader));
+	memcpy(output->data(), &header, sizeof(ShaderReflectionFileHeader));
+
+	return true;
+}
+#pragma endregion
+
+ShaderReflectionCacheStats ShaderReflectionFile::GetStats() {
+	ShaderReflectionCacheStats stats;
+	stats.hitCount = hitCount;
+	stats.missCount = missCount;
+	stats.corruptCount = corruptCount;
+	stats.writeCount = writeCount;
+	stats.failedWriteCount = failedWriteCount;
+
+	return stats;
+}
+
+uint64_t ShaderReflectionFile::Checksum(const unsigned char* data, size_t size, uint64_t hash) {
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= fnvPrime;
+	}
+
+	return hash;
+}
+
+uint64_t ShaderReflectionFile::GetPayloadChecksum(const ShaderReflectionFileHeader& header, const unsigned char* payload) {
+	// The thread group size is the one thing in the header nothing else checks
+	uint64_t hash = Checksum((const unsigned char*)header.threadGroupSize, sizeof(header.threadGroupSize));
+	return Checksum(payload, (size_t)header.payloadSize, hash);
+}
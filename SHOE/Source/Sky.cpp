@@ -1,4 +1,10 @@
 #include "../Headers/Sky.h"
+#include "../Headers/JobSystem.h"
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Sky::sharedLookupTexture;
+std::vector<uint16_t> Sky::brdfLookupTexels;
+std::future<void> Sky::brdfLookupBake;
+std::string Sky::brdfLookupCacheFolder;
 
 Sky::Sky(Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerOptions, 
 		 Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skyTexture, 
@@ -6,7 +12,8 @@ Sky::Sky(Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerOptions,
 		 std::vector<std::shared_ptr<SimpleVertexShader>> vertShaders,
 		 Microsoft::WRL::ComPtr<ID3D11Device> device,
 		 Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
-		 std::string name) {
+		 std::string name,
+		 std::shared_ptr<IBLBakedSky> bakedIBL) {
 	this->samplerOptions = samplerOptions;
 	this->skyPixelShader = pixShaders[0];
 	this->skyVertexShader = vertShaders[0];
@@ -21,9 +28,21 @@ Sky::Sky(Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerOptions,
 	this->name = name;
 	this->enabled = true;
 
-	IBLCreateIrradianceMap();
-	IBLCreateConvolvedSpecularMap();
-	IBLCreateBRDFLookUpTexture();
+	this->bakedIBL = bakedIBL;
+	this->mipLevelCount = IBLBaker::GetSpecularMipLevels(IBL_CUBE_FACE_SIZE);
+
+	// Maps baked on the CPU only need uploading, otherwise the shaders render them
+	if (bakedIBL != nullptr && bakedIBL->specular.mipLevels == (uint32_t)mipLevelCount) {
+		IBLCreateBakedCubeMap(bakedIBL->irradiance, irradianceCM.GetAddressOf());
+		IBLCreateBakedCubeMap(bakedIBL->specular, convolvedSpecularCM.GetAddressOf());
+	}
+	else {
+		this->bakedIBL = nullptr;
+		IBLCreateIrradianceMap(irradianceCM.GetAddressOf());
+		IBLCreateConvolvedSpecularMap(convolvedSpecularCM.GetAddressOf());
+	}
+
+	IBLCreateSharedBRDFLookUpTexture();
 }
 
 Sky::~Sky() {
@@ -31,7 +50,7 @@ Sky::~Sky() {
 }
 
 Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Sky::GetBRDFLookupTexture() {
-	return this->lookupTexture;
+	return sharedLookupTexture;
 }
 
 Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Sky::GetConvolvedSpecularCubeMap() {
@@ -46,12 +65,37 @@ int Sky::GetIBLMipLevelCount() {
 	return this->mipLevelCount;
 }
 
-void Sky::IBLCreateIrradianceMap() {
+std::shared_ptr<IBLBakedSky> Sky::GetBakedIBL() {
+	return this->bakedIBL;
+}
+
+bool Sky::IsIBLBakedOnCPU() {
+	return this->bakedIBL != nullptr && !this->bakedIBL->fromShaders;
+}
+
+void Sky::StartBRDFLookupBake(std::string cacheFolder) {
+	if (!cacheFolder.empty()) brdfLookupCacheFolder = cacheFolder;
+	if (sharedLookupTexture != nullptr || brdfLookupBake.valid()) return;
+
+	std::string cachePath = brdfLookupCacheFolder.empty() ? "" : IBLCacheFile::GetCachePath(brdfLookupCacheFolder, IBL_CACHE_BRDF_LOOKUP, 0, false);
+	brdfLookupBake = JobSystem::GetInstance().Schedule([cachePath]() {
+		if (IBLCacheFile::ReadBRDFLookup(cachePath, &brdfLookupTexels)) return;
+
+		IBLBaker::BakeBRDFLookup(&brdfLookupTexels);
+		IBLCacheFile::WriteBRDFLookup(cachePath, brdfLookupTexels);
+	});
+}
+
+void Sky::ReleaseSharedResources() {
+	sharedLookupTexture.Reset();
+}
+
+void Sky::IBLCreateIrradianceMap(ID3D11ShaderResourceView** irradianceMap) {
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> finalIrrMapTexture;
 
 	D3D11_TEXTURE2D_DESC texDesc = {};
-	texDesc.Width = CMFaceSize;
-	texDesc.Height = CMFaceSize;
+	texDesc.Width = IBL_CUBE_FACE_SIZE;
+	texDesc.Height = IBL_CUBE_FACE_SIZE;
 	texDesc.ArraySize = 6;
 	texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
 	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -65,7 +109,7 @@ void Sky::IBLCreateIrradianceMap() {
 	srvDesc.TextureCube.MipLevels = 1;
 	srvDesc.TextureCube.MostDetailedMip = 0;
 	srvDesc.Format = texDesc.Format;
-	device->CreateShaderResourceView(finalIrrMapTexture.Get(), &srvDesc, irradianceCM.GetAddressOf());
+	device->CreateShaderResourceView(finalIrrMapTexture.Get(), &srvDesc, irradianceMap);
 
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> prevRTV;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> prevDSV;
@@ -76,8 +120,8 @@ void Sky::IBLCreateIrradianceMap() {
 	context->RSGetViewports(&vpCount, &prevVP);
 
 	D3D11_VIEWPORT vp = {};
-	vp.Width = (float)CMFaceSize;
-	vp.Height = (float)CMFaceSize;
+	vp.Width = (float)IBL_CUBE_FACE_SIZE;
+	vp.Height = (float)IBL_CUBE_FACE_SIZE;
 	vp.MinDepth = 0.0f;
 	vp.MaxDepth = 1.0f;
 	context->RSSetViewports(1, &vp);
@@ -120,13 +164,12 @@ void Sky::IBLCreateIrradianceMap() {
 	context->RSSetViewports(1, &prevVP);
 }
 
-void Sky::IBLCreateConvolvedSpecularMap() {
+void Sky::IBLCreateConvolvedSpecularMap(ID3D11ShaderResourceView** specularMap) {
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> finalSpecMapTexture;
-	mipLevelCount = max((int)(log2(CMFaceSize)) + 1 - mipLevelSkip, 1);
 
 	D3D11_TEXTURE2D_DESC texDesc = {};
-	texDesc.Width = CMFaceSize;
-	texDesc.Height = CMFaceSize;
+	texDesc.Width = IBL_CUBE_FACE_SIZE;
+	texDesc.Height = IBL_CUBE_FACE_SIZE;
 	texDesc.ArraySize = 6;
 	texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
 	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -140,7 +183,7 @@ void Sky::IBLCreateConvolvedSpecularMap() {
 	srvDesc.TextureCube.MipLevels = mipLevelCount;
 	srvDesc.TextureCube.MostDetailedMip = 0;
 	srvDesc.Format = texDesc.Format;
-	device->CreateShaderResourceView(finalSpecMapTexture.Get(), &srvDesc, convolvedSpecularCM.GetAddressOf());
+	device->CreateShaderResourceView(finalSpecMapTexture.Get(), &srvDesc, specularMap);
 
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> prevRTV;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> prevDSV;
@@ -174,7 +217,7 @@ void Sky::IBLCreateConvolvedSpecularMap() {
 			context->OMSetRenderTargets(1, rtv.GetAddressOf(), 0);
 
 			D3D11_VIEWPORT vp = {};
-			vp.Width = (float)pow(2, mipLevelCount + mipLevelSkip - 1 - mipLevel);
+			vp.Width = (float)(IBL_CUBE_FACE_SIZE >> mipLevel);
 			vp.Height = vp.Width;
 			vp.MinDepth = 0.0f;
 			vp.MaxDepth = 1.0f;
@@ -195,12 +238,12 @@ void Sky::IBLCreateConvolvedSpecularMap() {
 	context->RSSetViewports(1, &prevVP);
 }
 
-void Sky::IBLCreateBRDFLookUpTexture() {
+void Sky::IBLCreateBRDFLookUpTexture(ID3D11ShaderResourceView** lookupMap) {
 	Microsoft::WRL::ComPtr<ID3D11Texture2D> finalBRDFMapTexture;
 
 	D3D11_TEXTURE2D_DESC texDesc = {};
-	texDesc.Width = lookupTextureSize;
-	texDesc.Height = lookupTextureSize;
+	texDesc.Width = IBL_BRDF_LOOKUP_SIZE;
+	texDesc.Height = IBL_BRDF_LOOKUP_SIZE;
 	texDesc.ArraySize = 1;
 	texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
 	texDesc.Format = DXGI_FORMAT_R16G16_UNORM;
@@ -214,7 +257,7 @@ void Sky::IBLCreateBRDFLookUpTexture() {
 	srvDesc.Texture2D.MipLevels = 1;
 	srvDesc.Texture2D.MostDetailedMip = 0;
 	srvDesc.Format = texDesc.Format;
-	device->CreateShaderResourceView(finalBRDFMapTexture.Get(), &srvDesc, lookupTexture.GetAddressOf());
+	device->CreateShaderResourceView(finalBRDFMapTexture.Get(), &srvDesc, lookupMap);
 
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> prevRTV;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> prevDSV;
@@ -225,8 +268,8 @@ void Sky::IBLCreateBRDFLookUpTexture() {
 	context->RSGetViewports(&vpCount, &prevVP);
 
 	D3D11_VIEWPORT vp = {};
-	vp.Width = (float)lookupTextureSize;
-	vp.Height = (float)lookupTextureSize;
+	vp.Width = (float)IBL_BRDF_LOOKUP_SIZE;
+	vp.Height = (float)IBL_BRDF_LOOKUP_SIZE;
 	vp.MinDepth = 0.0f;
 	vp.MaxDepth = 1.0f;
 	context->RSSetViewports(1, &vp);
@@ -256,6 +299,196 @@ void Sky::IBLCreateBRDFLookUpTexture() {
 	context->RSSetViewports(1, &prevVP);
 }
 
+void Sky::IBLCreateBakedCubeMap(const IBLCubeFaces& faces, ID3D11ShaderResourceView** cubeMap) {
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> bakedTexture;
+
+	D3D11_TEXTURE2D_DESC texDesc = {};
+	texDesc.Width = faces.faceSize;
+	texDesc.Height = faces.faceSize;
+	texDesc.ArraySize = 6;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	texDesc.MipLevels = faces.mipLevels;
+	texDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Usage = D3D11_USAGE_IMMUTABLE;
+
+	// Subresources go face by face, each with its whole mip chain
+	std::vector<D3D11_SUBRESOURCE_DATA> initialData(6 * faces.mipLevels);
+	for (int face = 0; face < 6; face++) {
+		size_t offset = 0;
+		for (uint32_t mipLevel = 0; mipLevel < faces.mipLevels; mipLevel++) {
+			uint32_t mipSize = faces.faceSize >> mipLevel;
+			if (mipSize == 0) mipSize = 1;
+
+			D3D11_SUBRESOURCE_DATA& data = initialData[face * faces.mipLevels + mipLevel];
+			data.pSysMem = faces.faces[face].data() + offset;
+			data.SysMemPitch = mipSize * 4;
+			data.SysMemSlicePitch = 0;
+
+			offset += (size_t)mipSize * mipSize * 4;
+		}
+	}
+
+	device->CreateTexture2D(&texDesc, initialData.data(), bakedTexture.GetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+	srvDesc.TextureCube.MipLevels = faces.mipLevels;
+	srvDesc.TextureCube.MostDetailedMip = 0;
+	srvDesc.Format = texDesc.Format;
+	device->CreateShaderResourceView(bakedTexture.Get(), &srvDesc, cubeMap);
+}
+
+/// <summary>
+/// Uploads the BRDF lookup once, for every sky to use. Waits on the
+/// bake if it's still running, helping with other jobs meanwhile.
+/// </summary>
+void Sky::IBLCreateSharedBRDFLookUpTexture() {
+	if (sharedLookupTexture != nullptr) return;
+
+	StartBRDFLookupBake();
+	while (brdfLookupBake.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		if (!JobSystem::GetInstance().TryRunPendingJob()) std::this_thread::yield();
+	}
+	brdfLookupBake.get();
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> lookupTexture;
+
+	D3D11_TEXTURE2D_DESC texDesc = {};
+	texDesc.Width = IBL_BRDF_LOOKUP_SIZE;
+	texDesc.Height = IBL_BRDF_LOOKUP_SIZE;
+	texDesc.ArraySize = 1;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texDesc.Format = DXGI_FORMAT_R16G16_UNORM;
+	texDesc.MipLevels = 1;
+	texDesc.MiscFlags = 0;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Usage = D3D11_USAGE_IMMUTABLE;
+
+	D3D11_SUBRESOURCE_DATA initialData = {};
+	initialData.pSysMem = brdfLookupTexels.data();
+	initialData.SysMemPitch = IBL_BRDF_LOOKUP_SIZE * 2 * sizeof(uint16_t);
+	device->CreateTexture2D(&texDesc, &initialData, lookupTexture.GetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Format = texDesc.Format;
+	device->CreateShaderResourceView(lookupTexture.Get(), &srvDesc, sharedLookupTexture.GetAddressOf());
+
+	// The texture has its own copy now
+	brdfLookupTexels.clear();
+	brdfLookupTexels.shrink_to_fit();
+}
+
+/// <summary>
+/// Copies one subresource of a texture back to the CPU, tightly packed
+/// </summary>
+bool Sky::ReadBackTexture(ID3D11ShaderResourceView* texture, unsigned int arraySlice, unsigned int mipLevel, unsigned int texelSize, std::vector<unsigned char>* texels) {
+	if (texture == nullptr) return false;
+
+	Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> sourceTexture;
+	texture->GetResource(resource.GetAddressOf());
+	if (FAILED(resource.As(&sourceTexture))) return false;
+
+	D3D11_TEXTURE2D_DESC sourceDesc;
+	sourceTexture->GetDesc(&sourceDesc);
+
+	D3D11_TEXTURE2D_DESC stagingDesc = {};
+	stagingDesc.Width = max(sourceDesc.Width >> mipLevel, 1u);
+	stagingDesc.Height = max(sourceDesc.Height >> mipLevel, 1u);
+	stagingDesc.ArraySize = 1;
+	stagingDesc.MipLevels = 1;
+	stagingDesc.Format = sourceDesc.Format;
+	stagingDesc.SampleDesc.Count = 1;
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> stagingTexture;
+	if (FAILED(device->CreateTexture2D(&stagingDesc, 0, stagingTexture.GetAddressOf()))) return false;
+
+	context->CopySubresourceRegion(stagingTexture.Get(), 0, 0, 0, 0, sourceTexture.Get(),
+		D3D11CalcSubresource(mipLevel, arraySlice, sourceDesc.MipLevels), nullptr);
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (FAILED(context->Map(stagingTexture.Get(), 0, D3D11_MAP_READ, 0, &mapped))) return false;
+
+	size_t rowSize = (size_t)stagingDesc.Width * texelSize;
+	size_t start = texels->size();
+	texels->resize(start + rowSize * stagingDesc.Height);
+	for (unsigned int row = 0; row < stagingDesc.Height; row++) {
+		memcpy(texels->data() + start + row * rowSize, (unsigned char*)mapped.pData + row * mapped.RowPitch, rowSize);
+	}
+
+	context->Unmap(stagingTexture.Get(), 0);
+
+	return true;
+}
+
+bool Sky::ReadBackIBL(IBLBakedSky* bakedSky) {
+	if (bakedIBL != nullptr) return false;
+
+	bakedSky->fromShaders = true;
+	bakedSky->irradiance.faceSize = IBL_CUBE_FACE_SIZE;
+	bakedSky->irradiance.mipLevels = 1;
+	bakedSky->specular.faceSize = IBL_CUBE_FACE_SIZE;
+	bakedSky->specular.mipLevels = mipLevelCount;
+
+	for (int face = 0; face < 6; face++) {
+		if (!ReadBackTexture(irradianceCM.Get(), face, 0, 4, &bakedSky->irradiance.faces[face])) return false;
+
+		for (int mipLevel = 0; mipLevel < mipLevelCount; mipLevel++) {
+			if (!ReadBackTexture(convolvedSpecularCM.Get(), face, mipLevel, 4, &bakedSky->specular.faces[face])) return false;
+		}
+	}
+
+	return true;
+}
+
+bool Sky::CompareIBLWithShaders(SkyIBLComparison* comparison) {
+	if (!IsIBLBakedOnCPU()) return false;
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shaderIrradiance;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shaderSpecular;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shaderLookup;
+	IBLCreateIrradianceMap(shaderIrradiance.GetAddressOf());
+	IBLCreateConvolvedSpecularMap(shaderSpecular.GetAddressOf());
+	IBLCreateBRDFLookUpTexture(shaderLookup.GetAddressOf());
+
+	// Read back in the same order the bake packs its faces: face by face, mips largest first
+	std::vector<unsigned char> shaderTexels;
+	std::vector<unsigned char> bakedTexels;
+	for (int face = 0; face < 6; face++) {
+		ReadBackTexture(shaderIrradiance.Get(), face, 0, 4, &shaderTexels);
+		bakedTexels.insert(bakedTexels.end(), bakedIBL->irradiance.faces[face].begin(), bakedIBL->irradiance.faces[face].end());
+	}
+	if (shaderTexels.size() != bakedTexels.size()) return false;
+	comparison->irradiance = IBLBaker::CompareTexels(shaderTexels.data(), bakedTexels.data(), shaderTexels.size() / 4);
+
+	shaderTexels.clear();
+	bakedTexels.clear();
+	for (int face = 0; face < 6; face++) {
+		for (int mipLevel = 0; mipLevel < mipLevelCount; mipLevel++) {
+			ReadBackTexture(shaderSpecular.Get(), face, mipLevel, 4, &shaderTexels);
+		}
+		bakedTexels.insert(bakedTexels.end(), bakedIBL->specular.faces[face].begin(), bakedIBL->specular.faces[face].end());
+	}
+	if (shaderTexels.size() != bakedTexels.size()) return false;
+	comparison->specular = IBLBaker::CompareTexels(shaderTexels.data(), bakedTexels.data(), shaderTexels.size() / 4);
+
+	shaderTexels.clear();
+	bakedTexels.clear();
+	ReadBackTexture(shaderLookup.Get(), 0, 0, 4, &shaderTexels);
+	ReadBackTexture(sharedLookupTexture.Get(), 0, 0, 4, &bakedTexels);
+	if (shaderTexels.empty() || shaderTexels.size() != bakedTexels.size()) return false;
+	comparison->brdfLookup = IBLBaker::CompareTexels((const uint16_t*)shaderTexels.data(), (const uint16_t*)bakedTexels.data(), shaderTexels.size() / 4);
+
+	return true;
+}
+
 Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Sky::GetSkyTexture() {
 	return this->textureSRV;
 }
@@ -15,6 +15,22 @@ void Terrain::SetDefaults(std::shared_ptr<Mesh> mesh, std::shared_ptr<TerrainMat
 	defaultTerrainMat = mat;
 }
 
+/// <summary>
+/// Get the mesh a newly allocated Terrain starts with
+/// </summary>
+std::shared_ptr<Mesh> Terrain::GetDefaultMesh()
+{
+	return defaultMesh;
+}
+
+/// <summary>
+/// Get the material a newly allocated Terrain starts with
+/// </summary>
+std::shared_ptr<TerrainMaterial> Terrain::GetDefaultMaterial()
+{
+	return defaultTerrainMat;
+}
+
 /// <summary>
 /// Sets the members to the defaults for a newly allocated Terrain
 /// </summary>
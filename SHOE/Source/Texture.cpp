@@ -1,7 +1,7 @@
 #include "../Headers/Texture.h"
 
 Texture::Texture() {
-
+	this->streamingID = 0;
 }
 
 Texture::Texture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> texture,
@@ -13,6 +13,7 @@ Texture::Texture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> texture,
 	this->fileKey = fileKey;
 	this->name = name;
 	this->assetPathIndex = assetPathIndex;
+	this->streamingID = 0;
 }
 
 Texture::~Texture() {
@@ -24,9 +25,32 @@ void Texture::SetTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textur
 }
 
 Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Texture::GetTexture() {
+	if (materializer) {
+		// Cleared first, so a load that finishes inside the call can't start another
+		std::function<void()> materialize = std::move(materializer);
+		materializer = nullptr;
+		materialize();
+	}
+
 	return this->coreTexture;
 }
 
+void Texture::SetMaterializer(std::function<void()> materializer) {
+	this->materializer = materializer;
+}
+
+bool Texture::IsLoadDeferred() {
+	return (bool)this->materializer;
+}
+
+unsigned int Texture::GetStreamingID() {
+	return this->streamingID;
+}
+
+void Texture::SetStreamingID(unsigned int streamingID) {
+	this->streamingID = streamingID;
+}
+
 std::string Texture::GetName() {
 	return this->name;
 }
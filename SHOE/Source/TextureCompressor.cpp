@@ -0,0 +1,873 @@
+#include "../Headers/TextureCompressor.h"
+#include "../Headers/JobSystem.h"
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <cctype>
+#include <xmmintrin.h>
+
+// Texel rows per job while filtering mips
+static const size_t mipRowGrainSize = 16;
+
+// BC7's 4 bit index interpolation weights, out of 64
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static const char* presetNames[TEXTURE_PRESET_COUNT] = { "uncompressed", "fast", "balanced", "quality" };
+
+static inline float Clamp(float value, float low, float high) {
+	return (std::max)(low, (std::min)(high, value));
+}
+
+static inline int ClampInt(int value, int low, int high) {
+	return (std::max)(low, (std::min)(high, value));
+}
+
+#pragma region paths
+TextureUsage TextureCompressor::GetUsageForPath(const std::string& path) {
+	std::string folder = path;
+	std::replace(folder.begin(), folder.end(), '\\', '/');
+	std::transform(folder.begin(), folder.end(), folder.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+	if (folder.find("pbr/normals/") != std::string::npos) return TEXTURE_USAGE_NORMAL;
+	if (folder.find("pbr/metalness/") != std::string::npos || folder.find("pbr/roughness/") != std::string::npos) return TEXTURE_USAGE_MASK;
+
+	return TEXTURE_USAGE_COLOR;
+}
+
+const char* TextureCompressor::GetPresetName(TexturePreset preset) {
+	return preset >= 0 && preset < TEXTURE_PRESET_COUNT ? presetNames[preset] : "";
+}
+
+bool TextureCompressor::ParsePreset(const std::string& name, TexturePreset* preset) {
+	for (int i = 0; i < TEXTURE_PRESET_COUNT; i++) {
+		if (name == presetNames[i]) {
+			*preset = (TexturePreset)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+TextureFileFormat TextureCompressor::ChooseFormat(const TextureFileImage& image, TextureUsage usage, TexturePreset preset) {
+	// The top mip of a block compressed texture has to be whole blocks
+	if (preset == TEXTURE_PRESET_UNCOMPRESSED || image.width % 4 != 0 || image.height % 4 != 0) return TEXTURE_FORMAT_RGBA8;
+
+	if (usage == TEXTURE_USAGE_NORMAL) return TEXTURE_FORMAT_BC5;
+	if (usage == TEXTURE_USAGE_MASK) return TEXTURE_FORMAT_BC4;
+
+	if (preset == TEXTURE_PRESET_QUALITY) return TEXTURE_FORMAT_BC7;
+
+	bool hasAlpha = false;
+	for (size_t i = 3; i < image.pixels.size() && !hasAlpha; i += 4) {
+		hasAlpha = image.pixels[i] != 255;
+	}
+
+	return hasAlpha ? TEXTURE_FORMAT_BC3 : TEXTURE_FORMAT_BC1;
+}
+#pragma endregion
+
+#pragma region mips
+void TextureCompressor::GenerateMips(const TextureFileImage& image, TextureUsage usage, bool sRGB, std::vector<TextureFileImage>* mips) {
+	mips->clear();
+	mips->push_back(image);
+
+	// sRGB color is averaged as light, so it's taken out of its gamma first
+	float toLinear[256];
+	for (int i = 0; i < 256; i++) {
+		float value = i / 255.0f;
+		if (!sRGB) toLinear[i] = value;
+		else toLinear[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	auto toByte = [sRGB](float value) {
+		if (sRGB) value = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+		return (uint8_t)Clamp(value * 255.0f + 0.5f, 0.0f, 255.0f);
+	};
+
+	while (mips->back().width > 1 || mips->back().height > 1) {
+		const TextureFileImage& source = mips->back();
+
+		TextureFileImage mip;
+		mip.width = (std::max)(1u, source.width / 2);
+		mip.height = (std::max)(1u, source.height / 2);
+		mip.pixels.resize((size_t)mip.width * mip.height * 4);
+
+		JobSystem::GetInstance().ParallelFor(mip.height, mipRowGrainSize, [&](size_t start, size_t end) {
+			for (uint32_t y = (uint32_t)start; y < end; y++) {
+				for (uint32_t x = 0; x < mip.width; x++) {
+					// Clamped so 1 pixel wide sources reuse their only row or column
+					uint32_t x0 = (std::min)(x * 2, source.width - 1);
+					uint32_t x1 = (std::min)(x * 2 + 1, source.width - 1);
+					uint32_t y0 = (std::min)(y * 2, source.height - 1);
+					uint32_t y1 = (std::min)(y * 2 + 1, source.height - 1);
+
+					const uint8_t* taps[4] = {
+						&source.pixels[((size_t)y0 * source.width + x0) * 4],
+						&source.pixels[((size_t)y0 * source.width + x1) * 4],
+						&source.pixels[((size_t)y1 * source.width + x0) * 4],
+						&source.pixels[((size_t)y1 * source.width + x1) * 4]
+					};
+
+					uint8_t* output = &mip.pixels[((size_t)y * mip.width + x) * 4];
+
+					if (usage == TEXTURE_USAGE_COLOR) {
+						for (int channel = 0; channel < 3; channel++) {
+							float sum = 0.0f;
+							for (const uint8_t* tap : taps) sum += toLinear[tap[channel]];
+							output[channel] = toByte(sum * 0.25f);
+						}
+					}
+					else if (usage == TEXTURE_USAGE_NORMAL) {
+						// Averaged normals are shorter than 1, which would darken lighting, so they're renormalized
+						float normal[3] = {};
+						for (const uint8_t* tap : taps) {
+							for (int channel = 0; channel < 3; channel++) {
+								normal[channel] += tap[channel] / 255.0f * 2.0f - 1.0f;
+							}
+						}
+
+						float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+						if (length < 1e-6f) {
+							normal[0] = 0;
+							normal[1] = 0;
+							normal[2] = 1;
+							length = 1;
+						}
+
+						for (int channel = 0; channel < 3; channel++) {
+							output[channel] = (uint8_t)Clamp((normal[channel] / length * 0.5f + 0.5f) * 255.0f + 0.5f, 0.0f, 255.0f);
+						}
+					}
+					else {
+						for (int channel = 0; channel < 3; channel++) {
+							int sum = taps[0][channel] + taps[1][channel] + taps[2][channel] + taps[3][channel];
+							output[channel] = (uint8_t)((sum + 2) / 4);
+						}
+					}
+
+					// Alpha is always linear
+					int alpha = taps[0][3] + taps[1][3] + taps[2][3] + taps[3][3];
+					output[3] = (uint8_t)((alpha + 2) / 4);
+				}
+			}
+		});
+
+		mips->push_back(std::move(mip));
+	}
+}
+#pragma endregion
+
+#pragma region bc1
+static inline uint16_t To565(const float color[3]) {
+	int r = ClampInt((int)(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+	int g = ClampInt((int)(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+	int b = ClampInt((int)(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static inline void From565(uint16_t color, int rgb[3]) {
+	int r = (color >> 11) & 31;
+	int g = (color >> 5) & 63;
+	int b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// BC1's four color palette, in index order
+static void GetBC1Palette(uint16_t color0, uint16_t color1, int palette[4][3]) {
+	From565(color0, palette[0]);
+	From565(color1, palette[1]);
+	for (int channel = 0; channel < 3; channel++) {
+		palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+		palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+	}
+}
+
+// Picks the nearest palette entry for every texel, comparing against all four at once
+static float FitBC1Indices(const float texels[16][3], const int palette[4][3], int indices[16]) {
+	__m128 paletteR = _mm_setr_ps((float)palette[0][0], (float)palette[1][0], (float)palette[2][0], (float)palette[3][0]);
+	__m128 paletteG = _mm_setr_ps((float)palette[0][1], (float)palette[1][1], (float)palette[2][1], (float)palette[3][1]);
+	__m128 paletteB = _mm_setr_ps((float)palette[0][2], (float)palette[1][2], (float)palette[2][2], (float)palette[3][2]);
+
+	float error = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		__m128 r = _mm_sub_ps(paletteR, _mm_set1_ps(texels[i][0]));
+		__m128 g = _mm_sub_ps(paletteG, _mm_set1_ps(texels[i][1]));
+		__m128 b = _mm_sub_ps(paletteB, _mm_set1_ps(texels[i][2]));
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(g, g)), _mm_mul_ps(b, b));
+
+		float distances[4];
+		_mm_storeu_ps(distances, distance);
+
+		int best = 0;
+		for (int j = 1; j < 4; j++) {
+			if (distances[j] < distances[best]) best = j;
+		}
+
+		indices[i] = best;
+		error += distances[best];
+	}
+
+	return error;
+}
+
+// Principal axis of a block's colors, by power iteration on their covariance
+template <int Channels>
+static void GetPrincipalAxis(const float texels[16][Channels], int iterations, float mean[Channels], float axis[Channels]) {
+	for (int channel = 0; channel < Channels; channel++) {
+		mean[channel] = 0;
+		for (int i = 0; i < 16; i++) mean[channel] += texels[i][channel];
+		mean[channel] /= 16.0f;
+	}
+
+	float covariance[Channels][Channels] = {};
+	for (int i = 0; i < 16; i++) {
+		for (int a = 0; a < Channels; a++) {
+			for (int b = 0; b < Channels; b++) {
+				covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+			}
+		}
+	}
+
+	for (int channel = 0; channel < Channels; channel++) axis[channel] = 1.0f;
+	for (int iteration = 0; iteration < iterations; iteration++) {
+		float next[Channels] = {};
+		for (int a = 0; a < Channels; a++) {
+			for (int b = 0; b < Channels; b++) next[a] += covariance[a][b] * axis[b];
+		}
+
+		float length = 0.0f;
+		for (int channel = 0; channel < Channels; channel++) length = (std::max)(length, fabsf(next[channel]));
+		if (length < 1e-6f) break;
+
+		for (int channel = 0; channel < Channels; channel++) axis[channel] = next[channel] / length;
+	}
+}
+
+// Endpoints at the ends of the colors' spread along an axis
+template <int Channels>
+static void GetAxisEndpoints(const float texels[16][Channels], const float mean[Channels], const float axis[Channels], float endpoint0[Channels], float endpoint1[Channels]) {
+	float axisLength = 0.0f;
+	for (int channel = 0; channel < Channels; channel++) axisLength += axis[channel] * axis[channel];
+
+	float minProjection = FLT_MAX;
+	float maxProjection = -FLT_MAX;
+	for (int i = 0; i < 16; i++) {
+		float projection = 0.0f;
+		for (int channel = 0; channel < Channels; channel++) projection += (texels[i][channel] - mean[channel]) * axis[channel];
+		minProjection = (std::min)(minProjection, projection);
+		maxProjection = (std::max)(maxProjection, projection);
+	}
+
+	if (axisLength < 1e-12f) axisLength = 1.0f;
+	for (int channel = 0; channel < Channels; channel++) {
+		endpoint0[channel] = Clamp(mean[channel] + axis[channel] * maxProjection / axisLength, 0.0f, 255.0f);
+		endpoint1[channel] = Clamp(mean[channel] + axis[channel] * minProjection / axisLength, 0.0f, 255.0f);
+	}
+}
+
+// Least squares endpoints for fixed indices, where each index puts a texel weight of its way from endpoint 0 to 1
+template <int Channels>
+static bool SolveEndpoints(const float texels[16][Channels], const int indices[16], const float* weights, float endpoint0[Channels], float endpoint1[Channels]) {
+	float aa = 0, ab = 0, bb = 0;
+	float ax[Channels] = {};
+	float bx[Channels] = {};
+	for (int i = 0; i < 16; i++) {
+		float b = weights[indices[i]];
+		float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int channel = 0; channel < Channels; channel++) {
+			ax[channel] += a * texels[i][channel];
+			bx[channel] += b * texels[i][channel];
+		}
+	}
+
+	float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f) return false;
+
+	for (int channel = 0; channel < Channels; channel++) {
+		endpoint0[channel] = Clamp((ax[channel] * bb - bx[channel] * ab) / determinant, 0.0f, 255.0f);
+		endpoint1[channel] = Clamp((bx[channel] * aa - ax[channel] * ab) / determinant, 0.0f, 255.0f);
+	}
+
+	return true;
+}
+
+void TextureCompressor::EncodeBC1Block(const uint8_t texels[64], TexturePreset preset, uint8_t block[8]) {
+	float colors[16][3];
+	for (int i = 0; i < 16; i++) {
+		for (int channel = 0; channel < 3; channel++) colors[i][channel] = texels[i * 4 + channel];
+	}
+
+	// Bounding box, flipped to the diagonal the colors lean along and inset a little
+	float low[3] = { 255, 255, 255 };
+	float high[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		for (int channel = 0; channel < 3; channel++) {
+			low[channel] = (std::min)(low[channel], colors[i][channel]);
+			high[channel] = (std::max)(high[channel], colors[i][channel]);
+		}
+	}
+
+	float centerR = (low[0] + high[0]) * 0.5f;
+	float covariance[3] = {};
+	for (int i = 0; i < 16; i++) {
+		for (int channel = 1; channel < 3; channel++) {
+			covariance[channel] += (colors[i][0] - centerR) * (colors[i][channel] - (low[channel] + high[channel]) * 0.5f);
+		}
+	}
+
+	float endpoint0[3];
+	float endpoint1[3];
+	for (int channel = 0; channel < 3; channel++) {
+		float inset = (high[channel] - low[channel]) / 16.0f;
+		bool flipped = channel > 0 && covariance[channel] < 0;
+		endpoint0[channel] = flipped ? low[channel] + inset : high[channel] - inset;
+		endpoint1[channel] = flipped ? high[channel] - inset : low[channel] + inset;
+	}
+
+	uint16_t color0 = To565(endpoint0);
+	uint16_t color1 = To565(endpoint1);
+	int palette[4][3];
+	int indices[16];
+	GetBC1Palette(color0, color1, palette);
+	float error = FitBC1Indices(colors, palette, indices);
+
+	// The principal axis fits most blocks better, but not all, so the box stays as a candidate
+	if (preset != TEXTURE_PRESET_FAST && error > 0.0f) {
+		float mean[3];
+		float axis[3];
+		GetPrincipalAxis<3>(colors, preset == TEXTURE_PRESET_QUALITY ? 8 : 4, mean, axis);
+		GetAxisEndpoints<3>(colors, mean, axis, endpoint0, endpoint1);
+
+		uint16_t axis0 = To565(endpoint0);
+		uint16_t axis1 = To565(endpoint1);
+		int axisPalette[4][3];
+		int axisIndices[16];
+		GetBC1Palette(axis0, axis1, axisPalette);
+		float axisError = FitBC1Indices(colors, axisPalette, axisIndices);
+		if (axisError < error) {
+			color0 = axis0;
+			color1 = axis1;
+			error = axisError;
+			memcpy(indices, axisIndices, sizeof(indices));
+		}
+	}
+
+	int refinements = preset == TEXTURE_PRESET_QUALITY ? 2 : (preset == TEXTURE_PRESET_BALANCED ? 1 : 0);
+	static const float bc1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	for (int refinement = 0; refinement < refinements; refinement++) {
+		if (!SolveEndpoints<3>(colors, indices, bc1Weights, endpoint0, endpoint1)) break;
+
+		uint16_t refined0 = To565(endpoint0);
+		uint16_t refined1 = To565(endpoint1);
+		int refinedPalette[4][3];
+		int refinedIndices[16];
+		GetBC1Palette(refined0, refined1, refinedPalette);
+		float refinedError = FitBC1Indices(colors, refinedPalette, refinedIndices);
+		if (refinedError >= error) break;
+
+		color0 = refined0;
+		color1 = refined1;
+		error = refinedError;
+		memcpy(indices, refinedIndices, sizeof(indices));
+	}
+
+	// Four color mode needs color 0 above color 1. Equal colors only ever use index 0.
+	if (color0 < color1) {
+		std::swap(color0, color1);
+		static const int swapped[4] = { 1, 0, 3, 2 };
+		for (int i = 0; i < 16; i++) indices[i] = swapped[indices[i]];
+	}
+	else if (color0 == color1) {
+		for (int i = 0; i < 16; i++) indices[i] = 0;
+	}
+
+	uint32_t indexBits = 0;
+	for (int i = 0; i < 16; i++) indexBits |= (uint32_t)indices[i] << (i * 2);
+
+	block[0] = (uint8_t)(color0 & 0xFF);
+	block[1] = (uint8_t)(color0 >> 8);
+	block[2] = (uint8_t)(color1 & 0xFF);
+	block[3] = (uint8_t)(color1 >> 8);
+	for (int i = 0; i < 4; i++) block[4 + i] = (uint8_t)(indexBits >> (i * 8));
+}
+#pragma endregion
+
+#pragma region bc4
+// BC4's eight values, in index order. Endpoint 0 above endpoint 1 interpolates
+// six values between them, otherwise four and adds 0 and 255.
+static void GetBC4Palette(int value0, int value1, int palette[8]) {
+	palette[0] = value0;
+	palette[1] = value1;
+	if (value0 > value1) {
+		for (int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+	}
+	else {
+		for (int i = 1; i < 5; i++) palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static int FitBC4Indices(const int values[16], const int palette[8], int indices[16]) {
+	int error = 0;
+	for (int i = 0; i < 16; i++) {
+		int best = 0;
+		int bestDistance = INT32_MAX;
+		for (int j = 0; j < 8; j++) {
+			int distance = (values[i] - palette[j]) * (values[i] - palette[j]);
+			if (distance < bestDistance) {
+				bestDistance = distance;
+				best = j;
+			}
+		}
+
+		indices[i] = best;
+		error += bestDistance;
+	}
+
+	return error;
+}
+
+void TextureCompressor::EncodeBC4Block(const uint8_t texels[64], int channel, TexturePreset preset, uint8_t block[8]) {
+	int values[16];
+	float floatValues[16][1];
+	int low = 255;
+	int high = 0;
+	for (int i = 0; i < 16; i++) {
+		values[i] = texels[i * 4 + channel];
+		floatValues[i][0] = (float)values[i];
+		low = (std::min)(low, values[i]);
+		high = (std::max)(high, values[i]);
+	}
+
+	int value0 = high;
+	int value1 = low;
+	int indices[16] = {};
+	int error = 0;
+
+	if (high != low) {
+		int palette[8];
+		GetBC4Palette(value0, value1, palette);
+		error = FitBC4Indices(values, palette, indices);
+
+		// Index order from endpoint 0 to 1 is 0, 2, 3, 4, 5, 6, 7, 1
+		static const float bc4Weights[8] = { 0.0f, 1.0f, 1 / 7.0f, 2 / 7.0f, 3 / 7.0f, 4 / 7.0f, 5 / 7.0f, 6 / 7.0f };
+		int refinements = preset == TEXTURE_PRESET_QUALITY ? 2 : (preset == TEXTURE_PRESET_BALANCED ? 1 : 0);
+		for (int refinement = 0; refinement < refinements && error > 0; refinement++) {
+			float endpoint0[1];
+			float endpoint1[1];
+			if (!SolveEndpoints<1>(floatValues, indices, bc4Weights, endpoint0, endpoint1)) break;
+
+			int refined0 = (int)(endpoint0[0] + 0.5f);
+			int refined1 = (int)(endpoint1[0] + 0.5f);
+			if (refined0 < refined1) std::swap(refined0, refined1);
+			if (refined0 == refined1) break;
+
+			int refinedPalette[8];
+			int refinedIndices[16];
+			GetBC4Palette(refined0, refined1, refinedPalette);
+			int refinedError = FitBC4Indices(values, refinedPalette, refinedIndices);
+			if (refinedError >= error) break;
+
+			value0 = refined0;
+			value1 = refined1;
+			error = refinedError;
+			memcpy(indices, refinedIndices, sizeof(indices));
+		}
+
+		// Blocks touching black or white can do better with those two exact and six values between the rest
+		if (preset == TEXTURE_PRESET_QUALITY && error > 0) {
+			int innerLow = 255;
+			int innerHigh = 0;
+			for (int i = 0; i < 16; i++) {
+				if (values[i] == 0 || values[i] == 255) continue;
+				innerLow = (std::min)(innerLow, values[i]);
+				innerHigh = (std::max)(innerHigh, values[i]);
+			}
+
+			if (innerLow <= innerHigh) {
+				int palette6[8];
+				int indices6[16];
+				GetBC4Palette(innerLow, innerHigh, palette6);
+				int error6 = FitBC4Indices(values, palette6, indices6);
+				if (error6 < error) {
+					value0 = innerLow;
+					value1 = innerHigh;
+					error = error6;
+					memcpy(indices, indices6, sizeof(indices));
+				}
+			}
+		}
+	}
+
+	uint64_t indexBits = 0;
+	for (int i = 0; i < 16; i++) indexBits |= (uint64_t)indices[i] << (i * 3);
+
+	block[0] = (uint8_t)value0;
+	block[1] = (uint8_t)value1;
+	for (int i = 0; i < 6; i++) block[2 + i] = (uint8_t)(indexBits >> (i * 8));
+}
+#pragma endregion
+
+#pragma region bc7
+// Writes and reads little endian bit fields across a 16 byte block
+struct BC7Bits {
+	uint8_t* bytes;
+	int position;
+
+	void Write(uint32_t value, int count) {
+		for (int i = 0; i < count; i++, position++) {
+			if (value & (1u << i)) bytes[position >> 3] |= (uint8_t)(1u << (position & 7));
+		}
+	}
+
+	uint32_t Read(int count) {
+		uint32_t value = 0;
+		for (int i = 0; i < count; i++, position++) {
+			value |= (uint32_t)((bytes[position >> 3] >> (position & 7)) & 1) << i;
+		}
+		return value;
+	}
+};
+
+static inline void GetBC7Palette(const int endpoint0[4], const int endpoint1[4], int palette[16][4]) {
+	for (int i = 0; i < 16; i++) {
+		for (int channel = 0; channel < 4; channel++) {
+			palette[i][channel] = ((64 - bc7Weights[i]) * endpoint0[channel] + bc7Weights[i] * endpoint1[channel] + 32) >> 6;
+		}
+	}
+}
+
+// Nearest of the sixteen palette entries for every texel, four entries at a time
+static float FitBC7Indices(const float texels[16][4], const int palette[16][4], int indices[16]) {
+	__m128 paletteChannels[4][4];
+	for (int group = 0; group < 4; group++) {
+		for (int channel = 0; channel < 4; channel++) {
+			paletteChannels[group][channel] = _mm_setr_ps(
+				(float)palette[group * 4 + 0][channel], (float)palette[group * 4 + 1][channel],
+				(float)palette[group * 4 + 2][channel], (float)palette[group * 4 + 3][channel]);
+		}
+	}
+
+	float error = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		__m128 texel[4];
+		for (int channel = 0; channel < 4; channel++) texel[channel] = _mm_set1_ps(texels[i][channel]);
+
+		float distances[16];
+		for (int group = 0; group < 4; group++) {
+			__m128 distance = _mm_setzero_ps();
+			for (int channel = 0; channel < 4; channel++) {
+				__m128 difference = _mm_sub_ps(paletteChannels[group][channel], texel[channel]);
+				distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+			}
+			_mm_storeu_ps(distances + group * 4, distance);
+		}
+
+		int best = 0;
+		for (int j = 1; j < 16; j++) {
+			if (distances[j] < distances[best]) best = j;
+		}
+
+		indices[i] = best;
+		error += distances[best];
+	}
+
+	return error;
+}
+
+// Quantizes endpoints to mode 6's 7 bits plus a shared p-bit each, then fits indices
+static float FitBC7Endpoints(const float texels[16][4], const float endpoint0[4], const float endpoint1[4], int pBit0, int pBit1,
+	int quantized0[4], int quantized1[4], int indices[16]) {
+	int expanded0[4];
+	int expanded1[4];
+	for (int channel = 0; channel < 4; channel++) {
+		quantized0[channel] = ClampInt((int)((endpoint0[channel] - pBit0) * 0.5f + 0.5f), 0, 127);
+		quantized1[channel] = ClampInt((int)((endpoint1[channel] - pBit1) * 0.5f + 0.5f), 0, 127);
+		expanded0[channel] = (quantized0[channel] << 1) | pBit0;
+		expanded1[channel] = (quantized1[channel] << 1) | pBit1;
+	}
+
+	int palette[16][4];
+	GetBC7Palette(expanded0, expanded1, palette);
+	return FitBC7Indices(texels, palette, indices);
+}
+
+void TextureCompressor::EncodeBC7Block(const uint8_t texels[64], TexturePreset preset, uint8_t block[16]) {
+	float colors[16][4];
+	for (int i = 0; i < 16; i++) {
+		for (int channel = 0; channel < 4; channel++) colors[i][channel] = texels[i * 4 + channel];
+	}
+
+	float mean[4];
+	float axis[4];
+	float endpoint0[4];
+	float endpoint1[4];
+	GetPrincipalAxis<4>(colors, preset == TEXTURE_PRESET_QUALITY ? 8 : 4, mean, axis);
+	GetAxisEndpoints<4>(colors, mean, axis, endpoint0, endpoint1);
+
+	float weights[16];
+	for (int i = 0; i < 16; i++) weights[i] = bc7Weights[i] / 64.0f;
+
+	int bestQuantized0[4];
+	int bestQuantized1[4];
+	int bestIndices[16];
+	int bestPBits[2] = { 0, 0 };
+	float bestError = FLT_MAX;
+
+	// Faster presets keep the p-bits that round the endpoints' averages best, quality tries all four
+	int refinements = preset == TEXTURE_PRESET_QUALITY ? 2 : (preset == TEXTURE_PRESET_BALANCED ? 1 : 0);
+	for (int refinement = 0; refinement <= refinements; refinement++) {
+		for (int pBits = 0; pBits < 4; pBits++) {
+			int pBit0 = pBits & 1;
+			int pBit1 = pBits >> 1;
+			if (preset != TEXTURE_PRESET_QUALITY) {
+				float average0 = (endpoint0[0] + endpoint0[1] + endpoint0[2] + endpoint0[3]) * 0.25f;
+				float average1 = (endpoint1[0] + endpoint1[1] + endpoint1[2] + endpoint1[3]) * 0.25f;
+				if (pBit0 != ((int)(average0 + 0.5f) & 1) || pBit1 != ((int)(average1 + 0.5f) & 1)) continue;
+			}
+
+			int quantized0[4];
+			int quantized1[4];
+			int indices[16];
+			float error = FitBC7Endpoints(colors, endpoint0, endpoint1, pBit0, pBit1, quantized0, quantized1, indices);
+			if (error < bestError) {
+				bestError = error;
+				bestPBits[0] = pBit0;
+				bestPBits[1] = pBit1;
+				memcpy(bestQuantized0, quantized0, sizeof(quantized0));
+				memcpy(bestQuantized1, quantized1, sizeof(quantized1));
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+		}
+
+		if (refinement == refinements || bestError == 0.0f) break;
+		if (!SolveEndpoints<4>(colors, bestIndices, weights, endpoint0, endpoint1)) break;
+	}
+
+	// The first texel's index has its top bit left out, so it has to be in the lower half
+	if (bestIndices[0] >= 8) {
+		std::swap(bestPBits[0], bestPBits[1]);
+		for (int channel = 0; channel < 4; channel++) std::swap(bestQuantized0[channel], bestQuantized1[channel]);
+		for (int i = 0; i < 16; i++) bestIndices[i] = 15 - bestIndices[i];
+	}
+
+	memset(block, 0, 16);
+	BC7Bits bits = { block, 0 };
+	bits.Write(1 << 6, 7);
+	for (int channel = 0; channel < 4; channel++) {
+		bits.Write(bestQuantized0[channel], 7);
+		bits.Write(bestQuantized1[channel], 7);
+	}
+	bits.Write(bestPBits[0], 1);
+	bits.Write(bestPBits[1], 1);
+	for (int i = 0; i < 16; i++) {
+		bits.Write(bestIndices[i], i == 0 ? 3 : 4);
+	}
+}
+#pragma endregion
+
+#pragma region images
+// Copies a 4x4 block out of an image, repeating the edge texels past its right and bottom sides
+static void GetBlockTexels(const TextureFileImage& image, uint32_t blockX, uint32_t blockY, uint8_t texels[64]) {
+	for (uint32_t y = 0; y < 4; y++) {
+		uint32_t sourceY = (std::min)(blockY * 4 + y, image.height - 1);
+		for (uint32_t x = 0; x < 4; x++) {
+			uint32_t sourceX = (std::min)(blockX * 4 + x, image.width - 1);
+			memcpy(texels + (y * 4 + x) * 4, &image.pixels[((size_t)sourceY * image.width + sourceX) * 4], 4);
+		}
+	}
+}
+
+bool TextureCompressor::Compress(const TextureFileImage& image, TextureFileFormat format, TexturePreset preset, TextureFileImage* compressed) {
+	uint32_t blockSize = TextureFile::GetBlockSize(format);
+	if (blockSize == 0 || image.pixels.size() != (size_t)image.width * image.height * 4) return false;
+
+	uint32_t blocksWide = TextureFile::GetRowPitch(format, image.width) / blockSize;
+	uint32_t blocksHigh = TextureFile::GetRowCount(format, image.height);
+
+	compressed->width = image.width;
+	compressed->height = image.height;
+	compressed->pixels.resize((size_t)blocksWide * blocksHigh * blockSize);
+
+	JobSystem::GetInstance().ParallelFor(blocksHigh, TEXTURE_COMPRESSION_GRAIN_SIZE, [&](size_t start, size_t end) {
+		uint8_t texels[64];
+		for (uint32_t blockY = (uint32_t)start; blockY < end; blockY++) {
+			for (uint32_t blockX = 0; blockX < blocksWide; blockX++) {
+				GetBlockTexels(image, blockX, blockY, texels);
+				uint8_t* block = &compressed->pixels[((size_t)blockY * blocksWide + blockX) * blockSize];
+
+				switch (format) {
+				case TEXTURE_FORMAT_BC1:
+					EncodeBC1Block(texels, preset, block);
+					break;
+				case TEXTURE_FORMAT_BC3:
+					EncodeBC4Block(texels, 3, preset, block);
+					EncodeBC1Block(texels, preset, block + 8);
+					break;
+				case TEXTURE_FORMAT_BC4:
+					EncodeBC4Block(texels, 0, preset, block);
+					break;
+				case TEXTURE_FORMAT_BC5:
+					EncodeBC4Block(texels, 0, preset, block);
+					EncodeBC4Block(texels, 1, preset, block + 8);
+					break;
+				case TEXTURE_FORMAT_BC7:
+					EncodeBC7Block(texels, preset, block);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	});
+
+	return true;
+}
+
+TextureFileFormat TextureCompressor::Process(const TextureFileImage& image, TextureUsage usage, bool sRGB, TexturePreset preset, std::vector<TextureFileImage>* mips) {
+	GenerateMips(image, usage, sRGB, mips);
+
+	TextureFileFormat format = ChooseFormat(image, usage, preset);
+	if (format == TEXTURE_FORMAT_RGBA8) return format;
+
+	for (TextureFileImage& mip : *mips) {
+		TextureFileImage compressed;
+		Compress(mip, format, preset, &compressed);
+		mip = std::move(compressed);
+	}
+
+	return format;
+}
+#pragma endregion
+
+#pragma region decoding
+static void DecodeBC1Colors(const uint8_t* block, bool allowTransparent, uint8_t texels[64]) {
+	uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+	uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+
+	int palette[4][3];
+	GetBC1Palette(color0, color1, palette);
+
+	// Three colors and transparent black, only possible in plain BC1
+	bool threeColor = allowTransparent && color0 <= color1;
+	if (threeColor) {
+		for (int channel = 0; channel < 3; channel++) {
+			palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+			palette[3][channel] = 0;
+		}
+	}
+
+	uint32_t indexBits = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+	for (int i = 0; i < 16; i++) {
+		int index = (indexBits >> (i * 2)) & 3;
+		for (int channel = 0; channel < 3; channel++) texels[i * 4 + channel] = (uint8_t)palette[index][channel];
+		texels[i * 4 + 3] = threeColor && index == 3 ? 0 : 255;
+	}
+}
+
+static void DecodeBC4Channel(const uint8_t* block, int channel, uint8_t texels[64]) {
+	int palette[8];
+	GetBC4Palette(block[0], block[1], palette);
+
+	uint64_t indexBits = 0;
+	for (int i = 0; i < 6; i++) indexBits |= (uint64_t)block[2 + i] << (i * 8);
+
+	for (int i = 0; i < 16; i++) {
+		texels[i * 4 + channel] = (uint8_t)palette[(indexBits >> (i * 3)) & 7];
+	}
+}
+
+void TextureCompressor::DecodeBlock(TextureFileFormat format, const uint8_t* block, uint8_t texels[64]) {
+	switch (format) {
+	case TEXTURE_FORMAT_BC1:
+		DecodeBC1Colors(block, true, texels);
+		break;
+	case TEXTURE_FORMAT_BC3:
+		DecodeBC1Colors(block + 8, false, texels);
+		DecodeBC4Channel(block, 3, texels);
+		break;
+	case TEXTURE_FORMAT_BC4:
+	case TEXTURE_FORMAT_BC5:
+		for (int i = 0; i < 16; i++) {
+			texels[i * 4 + 1] = 0;
+			texels[i * 4 + 2] = 0;
+			texels[i * 4 + 3] = 255;
+		}
+		DecodeBC4Channel(block, 0, texels);
+		if (format == TEXTURE_FORMAT_BC5) DecodeBC4Channel(block + 8, 1, texels);
+		break;
+	case TEXTURE_FORMAT_BC7: {
+		memset(texels, 0, 64);
+		if ((block[0] & 0x7F) != (1 << 6)) break;
+
+		BC7Bits bits = { (uint8_t*)block, 7 };
+		int endpoint0[4];
+		int endpoint1[4];
+		for (int channel = 0; channel < 4; channel++) {
+			endpoint0[channel] = bits.Read(7) << 1;
+			endpoint1[channel] = bits.Read(7) << 1;
+		}
+
+		int pBit0 = bits.Read(1);
+		int pBit1 = bits.Read(1);
+		for (int channel = 0; channel < 4; channel++) {
+			endpoint0[channel] |= pBit0;
+			endpoint1[channel] |= pBit1;
+		}
+
+		int palette[16][4];
+		GetBC7Palette(endpoint0, endpoint1, palette);
+		for (int i = 0; i < 16; i++) {
+			int index = bits.Read(i == 0 ? 3 : 4);
+			for (int channel = 0; channel < 4; channel++) texels[i * 4 + channel] = (uint8_t)palette[index][channel];
+		}
+		break;
+	}
+	default:
+		memset(texels, 0, 64);
+		break;
+	}
+}
+
+float TextureCompressor::GetCompressionError(const TextureFileImage& image, const TextureFileImage& compressed, TextureFileFormat format) {
+	uint32_t blockSize = TextureFile::GetBlockSize(format);
+	if (blockSize == 0 || image.width == 0 || image.height == 0) return 0.0f;
+
+	int channelCount = 4;
+	if (format == TEXTURE_FORMAT_BC1) channelCount = 3;
+	else if (format == TEXTURE_FORMAT_BC4) channelCount = 1;
+	else if (format == TEXTURE_FORMAT_BC5) channelCount = 2;
+
+	uint32_t blocksWide = TextureFile::GetRowPitch(format, image.width) / blockSize;
+	uint32_t blocksHigh = TextureFile::GetRowCount(format, image.height);
+	if (compressed.pixels.size() < (size_t)blocksWide * blocksHigh * blockSize) return FLT_MAX;
+
+	double total = 0.0;
+	uint8_t texels[64];
+	for (uint32_t blockY = 0; blockY < blocksHigh; blockY++) {
+		for (uint32_t blockX = 0; blockX < blocksWide; blockX++) {
+			DecodeBlock(format, &compressed.pixels[((size_t)blockY * blocksWide + blockX) * blockSize], texels);
+
+			for (uint32_t y = 0; y < 4 && blockY * 4 + y < image.height; y++) {
+				for (uint32_t x = 0; x < 4 && blockX * 4 + x < image.width; x++) {
+					const uint8_t* source = &image.pixels[((size_t)(blockY * 4 + y) * image.width + blockX * 4 + x) * 4];
+					for (int channel = 0; channel < channelCount; channel++) {
+						double difference = (double)source[channel] - texels[(y * 4 + x) * 4 + channel];
+						total += difference * difference;
+					}
+				}
+			}
+		}
+	}
+
+	return (float)sqrt(total / ((double)image.width * image.height * channelCount));
+}
+#pragma endregion
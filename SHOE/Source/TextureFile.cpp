@@ -0,0 +1,196 @@
+#include "../Headers/TextureFile.h"
+#include <cstring>
+#include <algorithm>
+
+#pragma region view
+
+bool TextureFileView::Open(const std::string& path) {
+	Close();
+
+	if (!file.Open(path)) return false;
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+
+	if (size < sizeof(TextureFileHeader)) {
+		Close();
+		return false;
+	}
+
+	const TextureFileHeader* fileHeader = (const TextureFileHeader*)data;
+	if (fileHeader->magic != TEXTURE_FILE_MAGIC ||
+		fileHeader->version != TEXTURE_FILE_VERSION ||
+		fileHeader->headerSize != sizeof(TextureFileHeader) ||
+		fileHeader->format < TEXTURE_FORMAT_RGBA8 ||
+		fileHeader->format > TEXTURE_FORMAT_BC7 ||
+		fileHeader->width == 0 || fileHeader->width > TEXTURE_FILE_MAX_DIMENSION ||
+		fileHeader->height == 0 || fileHeader->height > TEXTURE_FILE_MAX_DIMENSION ||
+		fileHeader->mipCount == 0 ||
+		fileHeader->mipCount > TextureFile::GetFullMipCount(fileHeader->width, fileHeader->height) ||
+		fileHeader->arraySize == 0 || fileHeader->arraySize > TEXTURE_FILE_MAX_ARRAY_SIZE ||
+		((fileHeader->flags & TEXTURE_FLAG_CUBEMAP) && fileHeader->arraySize % 6 != 0)) {
+		Close();
+		return false;
+	}
+
+	// The top mip of a block compressed texture has to be whole blocks
+	if (TextureFile::GetBlockSize(fileHeader->format) != 0 && (fileHeader->width % 4 != 0 || fileHeader->height % 4 != 0)) {
+		Close();
+		return false;
+	}
+
+	uint64_t subresourceCount = (uint64_t)fileHeader->mipCount * fileHeader->arraySize;
+	uint64_t tableEnd = sizeof(TextureFileHeader) + subresourceCount * sizeof(TextureFileSubresource);
+	if (tableEnd > size) {
+		Close();
+		return false;
+	}
+
+	// Every subresource has to be the size its mip level implies, with packed rows,
+	// and lie inside the file. Textures are created straight from these, so anything
+	// else would have the driver reading past the data.
+	const TextureFileSubresource* subresources = (const TextureFileSubresource*)(data + sizeof(TextureFileHeader));
+	for (uint64_t i = 0; i < subresourceCount; i++) {
+		const TextureFileSubresource& subresource = subresources[i];
+		uint32_t mip = (uint32_t)(i % fileHeader->mipCount);
+		uint32_t width = (std::max)(1u, fileHeader->width >> mip);
+		uint32_t height = (std::max)(1u, fileHeader->height >> mip);
+
+		if (subresource.width != width ||
+			subresource.height != height ||
+			subresource.rowPitch != TextureFile::GetRowPitch(fileHeader->format, width) ||
+			subresource.size != (uint64_t)subresource.rowPitch * TextureFile::GetRowCount(fileHeader->format, height) ||
+			subresource.offset < tableEnd ||
+			subresource.offset > size ||
+			subresource.size > size - subresource.offset) {
+			Close();
+			return false;
+		}
+	}
+
+	header = fileHeader;
+	return true;
+}
+
+void TextureFileView::Close() {
+	file.Close();
+	header = nullptr;
+}
+
+const TextureFileHeader* TextureFileView::GetHeader() {
+	return header;
+}
+
+const TextureFileSubresource* TextureFileView::GetSubresource(uint32_t mip, uint32_t slice) {
+	if (header == nullptr || mip >= header->mipCount || slice >= header->arraySize) return nullptr;
+
+	const TextureFileSubresource* subresources = (const TextureFileSubresource*)(file.GetData() + sizeof(TextureFileHeader));
+	return &subresources[mip + slice * header->mipCount];
+}
+
+const uint8_t* TextureFileView::GetSubresourceData(uint32_t mip, uint32_t slice) {
+	const TextureFileSubresource* subresource = GetSubresource(mip, slice);
+	if (subresource == nullptr) return nullptr;
+
+	return file.GetData() + subresource->offset;
+}
+
+#pragma endregion
+
+#pragma region writing
+
+bool TextureFile::Write(const std::string& path, uint32_t flags, const std::vector<std::vector<TextureFileImage>>& slices, TextureFileFormat format) {
+	if (slices.empty() || slices[0].empty()) return false;
+
+	uint32_t mipCount = (uint32_t)slices[0].size();
+	for (const std::vector<TextureFileImage>& slice : slices) {
+		if (slice.size() != mipCount) return false;
+
+		for (uint32_t mip = 0; mip < mipCount; mip++) {
+			const TextureFileImage& image = slice[mip];
+			if (image.width != (std::max)(1u, slices[0][0].width >> mip) ||
+				image.height != (std::max)(1u, slices[0][0].height >> mip) ||
+				image.pixels.size() != (size_t)GetRowPitch(format, image.width) * GetRowCount(format, image.height)) return false;
+		}
+	}
+
+	TextureFileHeader header = {};
+	header.magic = TEXTURE_FILE_MAGIC;
+	header.version = TEXTURE_FILE_VERSION;
+	header.headerSize = sizeof(TextureFileHeader);
+	header.format = format;
+	header.flags = flags;
+	header.width = slices[0][0].width;
+	header.height = slices[0][0].height;
+	header.mipCount = mipCount;
+	header.arraySize = (uint32_t)slices.size();
+
+	std::vector<TextureFileSubresource> subresources;
+	uint64_t offset = sizeof(TextureFileHeader) + (uint64_t)mipCount * slices.size() * sizeof(TextureFileSubresource);
+	for (const std::vector<TextureFileImage>& slice : slices) {
+		for (const TextureFileImage& image : slice) {
+			offset = (offset + TEXTURE_FILE_SECTION_ALIGNMENT - 1) & ~(uint64_t)(TEXTURE_FILE_SECTION_ALIGNMENT - 1);
+
+			TextureFileSubresource subresource = {};
+			subresource.offset = offset;
+			subresource.size = image.pixels.size();
+			subresource.width = image.width;
+			subresource.height = image.height;
+			subresource.rowPitch = GetRowPitch(format, image.width);
+			subresources.push_back(subresource);
+
+			offset += subresource.size;
+		}
+	}
+
+	std::vector<unsigned char> output((size_t)offset, 0);
+	memcpy(output.data(), &header, sizeof(TextureFileHeader));
+	memcpy(output.data() + sizeof(TextureFileHeader), subresources.data(), subresources.size() * sizeof(TextureFileSubresource));
+
+	size_t index = 0;
+	for (const std::vector<TextureFileImage>& slice : slices) {
+		for (const TextureFileImage& image : slice) {
+			memcpy(output.data() + subresources[index].offset, image.pixels.data(), image.pixels.size());
+			index++;
+		}
+	}
+
+	return MappedFile::WriteWholeFile(path, output.data(), output.size());
+}
+
+uint32_t TextureFile::GetBlockSize(uint32_t format) {
+	switch (format) {
+	case TEXTURE_FORMAT_BC1:
+	case TEXTURE_FORMAT_BC4:
+		return 8;
+	case TEXTURE_FORMAT_BC3:
+	case TEXTURE_FORMAT_BC5:
+	case TEXTURE_FORMAT_BC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+uint32_t TextureFile::GetRowPitch(uint32_t format, uint32_t width) {
+	uint32_t blockSize = GetBlockSize(format);
+	if (blockSize == 0) return width * 4;
+
+	return (std::max)(1u, (width + 3) / 4) * blockSize;
+}
+
+uint32_t TextureFile::GetRowCount(uint32_t format, uint32_t height) {
+	if (GetBlockSize(format) == 0) return height;
+
+	return (std::max)(1u, (height + 3) / 4);
+}
+
+uint32_t TextureFile::GetFullMipCount(uint32_t width, uint32_t height) {
+	uint32_t largest = (std::max)(width, height);
+	uint32_t mipCount = 1;
+	while (largest >> mipCount) mipCount++;
+
+	return mipCount;
+}
+
+#pragma endregion
@@ -0,0 +1,259 @@
+#include "../Headers/TextureStreamer.h"
+#include <algorithm>
+#include <cmath>
+
+TextureStreamer::TextureStreamer() {
+	nextID = 1;
+	budget = TEXTURE_STREAMING_DEFAULT_BUDGET;
+
+	streamedInBytes = 0;
+	evictedBytes = 0;
+	failedCount = 0;
+}
+
+#pragma region tracking
+uint32_t TextureStreamer::Register(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t format, uint32_t residentMip) {
+	uint32_t id = nextID++;
+
+	StreamedTexture& texture = textures[id];
+	texture.status.width = width;
+	texture.status.height = height;
+	texture.status.mipCount = (std::max)(1u, mipCount);
+	texture.status.format = format;
+	texture.status.tailMip = GetTailMip(width, height, mipCount, format);
+	texture.status.residentMip = (std::min)(residentMip, texture.status.tailMip);
+	texture.status.wantedMip = texture.status.tailMip;
+	texture.status.targetMip = texture.status.residentMip;
+	texture.status.residentBytes = GetSize(texture.status, texture.status.residentMip);
+	texture.bestMip = 0;
+
+	return id;
+}
+
+void TextureStreamer::Unregister(uint32_t id) {
+	textures.erase(id);
+}
+
+bool TextureStreamer::IsRegistered(uint32_t id) {
+	return textures.find(id) != textures.end();
+}
+
+void TextureStreamer::Clear() {
+	// nextID keeps counting, so a change finishing late can't land on a new texture
+	textures.clear();
+}
+
+void TextureStreamer::RequestScreenSize(uint32_t id, float screenSize, float time) {
+	auto found = textures.find(id);
+	if (found == textures.end()) return;
+
+	found->second.requestedSize = (std::max)(found->second.requestedSize, screenSize);
+	found->second.status.lastUsedTime = time;
+}
+#pragma endregion
+
+#pragma region updating
+void TextureStreamer::Update(float time, std::vector<TextureStreamingChange>* changes) {
+	changes->clear();
+
+	std::vector<std::pair<uint32_t, StreamedTexture*>> ordered;
+	ordered.reserve(textures.size());
+
+	for (auto& entry : textures) {
+		StreamedTexture& texture = entry.second;
+		StreamedTextureStatus& status = texture.status;
+
+		if (texture.requestedSize > 0) {
+			status.wantedMip = (std::max)(GetWantedMip(status.width, status.height, status.mipCount, texture.requestedSize), texture.bestMip);
+			status.wantedMip = (std::min)(status.wantedMip, status.tailMip);
+			status.screenSize = texture.requestedSize;
+			texture.requestedSize = 0;
+		}
+		else if (time - status.lastUsedTime > TEXTURE_STREAMING_IDLE_TIME) {
+			status.wantedMip = status.tailMip;
+			status.screenSize = 0;
+		}
+
+		ordered.push_back(std::make_pair(entry.first, &texture));
+	}
+
+	// Most recently used first, then biggest on screen. The id settles ties so updates are repeatable.
+	std::sort(ordered.begin(), ordered.end(), [](const std::pair<uint32_t, StreamedTexture*>& a, const std::pair<uint32_t, StreamedTexture*>& b) {
+		const StreamedTextureStatus& statusA = a.second->status;
+		const StreamedTextureStatus& statusB = b.second->status;
+		if (statusA.lastUsedTime != statusB.lastUsedTime) return statusA.lastUsedTime > statusB.lastUsedTime;
+		if (statusA.screenSize != statusB.screenSize) return statusA.screenSize > statusB.screenSize;
+		return a.first < b.first;
+	});
+
+	// Tails are always resident, so they're paid for up front
+	uint64_t committed = 0;
+	for (auto& entry : ordered) {
+		committed += GetSize(entry.second->status, entry.second->status.tailMip);
+	}
+
+	for (auto& entry : ordered) {
+		StreamedTextureStatus& status = entry.second->status;
+		uint64_t tailSize = GetSize(status, status.tailMip);
+
+		// Mips that are already resident stay until the budget needs them back or the texture goes idle
+		uint32_t desiredMip = status.wantedMip;
+		if (time - status.lastUsedTime <= TEXTURE_STREAMING_IDLE_TIME) {
+			desiredMip = (std::min)(desiredMip, status.residentMip);
+		}
+		// A change that's still running is counted as if it had finished
+		if (status.streaming) {
+			desiredMip = status.targetMip;
+		}
+
+		uint32_t targetMip = status.tailMip;
+		for (uint32_t mip = desiredMip; mip < status.tailMip; mip++) {
+			uint64_t extra = GetSize(status, mip) - tailSize;
+			if (budget == 0 || committed + extra <= budget) {
+				targetMip = mip;
+				committed += extra;
+				break;
+			}
+		}
+
+		if (!status.streaming) status.targetMip = targetMip;
+	}
+
+	// Evictions go first so their memory is free before anything new arrives
+	for (auto it = ordered.rbegin(); it != ordered.rend(); it++) {
+		StreamedTextureStatus& status = it->second->status;
+		if (status.streaming || status.targetMip <= status.residentMip) continue;
+
+		TextureStreamingChange change;
+		change.id = it->first;
+		change.residentMip = status.targetMip;
+		change.evict = true;
+		changes->push_back(change);
+
+		status.streaming = true;
+	}
+
+	uint64_t uploadBytes = 0;
+	for (auto& entry : ordered) {
+		StreamedTextureStatus& status = entry.second->status;
+		if (status.streaming || status.targetMip >= status.residentMip) continue;
+
+		// The first stream-in always goes out, even if it's bigger than the limit by itself
+		uint64_t bytes = GetSize(status, status.targetMip) - status.residentBytes;
+		if (uploadBytes > 0 && uploadBytes + bytes > TEXTURE_STREAMING_UPLOAD_LIMIT) continue;
+		uploadBytes += bytes;
+
+		TextureStreamingChange change;
+		change.id = entry.first;
+		change.residentMip = status.targetMip;
+		change.evict = false;
+		changes->push_back(change);
+
+		status.streaming = true;
+	}
+}
+
+void TextureStreamer::CompleteChange(uint32_t id, uint32_t residentMip, bool failed) {
+	auto found = textures.find(id);
+	if (found == textures.end()) return;
+
+	StreamedTexture& texture = found->second;
+	StreamedTextureStatus& status = texture.status;
+
+	if (failed && status.targetMip < status.residentMip) {
+		// Whatever was asked for is out of reach, so it stops being asked for
+		texture.bestMip = (std::max)(texture.bestMip, status.residentMip);
+	}
+	if (failed) failedCount++;
+
+	residentMip = (std::min)(residentMip, status.tailMip);
+	uint64_t residentBytes = GetSize(status, residentMip);
+	if (residentBytes > status.residentBytes) streamedInBytes += residentBytes - status.residentBytes;
+	else evictedBytes += status.residentBytes - residentBytes;
+
+	status.residentMip = residentMip;
+	status.residentBytes = residentBytes;
+	status.targetMip = residentMip;
+	status.streaming = false;
+}
+#pragma endregion
+
+#pragma region stats
+void TextureStreamer::SetBudget(uint64_t budgetBytes) {
+	budget = budgetBytes;
+}
+
+uint64_t TextureStreamer::GetBudget() {
+	return budget;
+}
+
+bool TextureStreamer::GetStatus(uint32_t id, StreamedTextureStatus* status) {
+	auto found = textures.find(id);
+	if (found == textures.end()) return false;
+
+	*status = found->second.status;
+	return true;
+}
+
+TextureStreamingStats TextureStreamer::GetStats() {
+	TextureStreamingStats stats;
+	stats.textureCount = textures.size();
+	stats.budget = budget;
+	stats.streamedInBytes = streamedInBytes;
+	stats.evictedBytes = evictedBytes;
+	stats.failedCount = failedCount;
+
+	for (auto& entry : textures) {
+		const StreamedTextureStatus& status = entry.second.status;
+		stats.residentBytes += status.residentBytes;
+		stats.wantedBytes += GetSize(status, status.wantedMip);
+		if (status.streaming) stats.streamingCount++;
+	}
+
+	return stats;
+}
+#pragma endregion
+
+#pragma region sizes
+uint32_t TextureStreamer::GetTailMip(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t format) {
+	uint32_t mip = 0;
+	while (mip + 1 < mipCount && ((std::max)(width, height) >> mip) > TEXTURE_STREAMING_TAIL_SIZE) {
+		mip++;
+	}
+
+	// A block compressed texture has to start on a size that's whole blocks
+	if (TextureFile::GetBlockSize(format) != 0) {
+		while (mip > 0 && (width % (4u << mip) != 0 || height % (4u << mip) != 0)) {
+			mip--;
+		}
+	}
+
+	return mip;
+}
+
+uint32_t TextureStreamer::GetWantedMip(uint32_t width, uint32_t height, uint32_t mipCount, float screenSize) {
+	if (mipCount <= 1) return 0;
+	if (screenSize <= 0) return mipCount - 1;
+
+	float ratio = (std::max)(width, height) / screenSize;
+	if (ratio <= 1.0f) return 0;
+
+	uint32_t mip = (uint32_t)std::floor(std::log2(ratio));
+	return (std::min)(mip, mipCount - 1);
+}
+
+uint64_t TextureStreamer::GetMipChainSize(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t format, uint32_t firstMip) {
+	uint64_t size = 0;
+	for (uint32_t mip = firstMip; mip < mipCount; mip++) {
+		uint32_t mipWidth = (std::max)(1u, width >> mip);
+		uint32_t mipHeight = (std::max)(1u, height >> mip);
+		size += (uint64_t)TextureFile::GetRowPitch(format, mipWidth) * TextureFile::GetRowCount(format, mipHeight);
+	}
+
+	return size;
+}
+
+uint64_t TextureStreamer::GetSize(const StreamedTextureStatus& status, uint32_t firstMip) {
+	return GetMipChainSize(status.width, status.height, status.mipCount, status.format, firstMip);
+}
+#pragma endregion
@@ -0,0 +1,312 @@
+#include "../Headers/VirtualFileSystem.h"
+#include <experimental/filesystem>
+#include <algorithm>
+#include <map>
+
+namespace fs = std::experimental::filesystem;
+
+VirtualFileSystem* VirtualFileSystem::instance;
+
+#pragma region files
+VirtualFile::VirtualFile() {
+	data = nullptr;
+	size = 0;
+}
+
+bool VirtualFile::Open(const std::string& path) {
+	return VirtualFileSystem::GetInstance().Open(path, this);
+}
+
+void VirtualFile::Close() {
+	looseFile.Close();
+	pack.reset();
+	std::vector<unsigned char>().swap(unpacked);
+
+	data = nullptr;
+	size = 0;
+}
+
+bool VirtualFile::IsOpen() {
+	return data != nullptr;
+}
+
+bool VirtualFile::IsPacked() {
+	return pack != nullptr;
+}
+
+const unsigned char* VirtualFile::GetData() {
+	return data;
+}
+
+size_t VirtualFile::GetSize() {
+	return size;
+}
+#pragma endregion
+
+VirtualFileSystem::VirtualFileSystem() {
+	mounts = std::make_shared<const std::vector<MountedPack>>();
+
+	packedReads = 0;
+	looseReads = 0;
+	decompressedBytes = 0;
+	failedReads = 0;
+}
+
+#pragma region mounting
+bool VirtualFileSystem::Mount(const std::string& archivePath, const std::string& mountPoint) {
+	std::shared_ptr<AssetPack> pack = std::make_shared<AssetPack>();
+	if (!pack->Open(archivePath)) return false;
+
+	MountedPack mount;
+	mount.root = NormalizePath(mountPoint);
+	if (mount.root.empty() || mount.root.back() != '/') mount.root += '/';
+	mount.pack = pack;
+
+	std::lock_guard<std::mutex> lock(mountMutex);
+	std::shared_ptr<std::vector<MountedPack>> newMounts = std::make_shared<std::vector<MountedPack>>(*mounts);
+	newMounts->push_back(mount);
+	mounts = newMounts;
+
+	return true;
+}
+
+size_t VirtualFileSystem::MountFolder(const std::string& folder) {
+	std::vector<std::string> archives;
+
+	std::error_code error;
+	for (fs::directory_iterator it(folder, error), end; !error && it != end; it.increment(error)) {
+		if (!fs::is_regular_file(it->path(), error)) continue;
+
+		std::string extension = it->path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+		if (extension == ASSET_PACK_EXTENSION) archives.push_back(it->path().string());
+	}
+
+	// Later names override earlier ones, so a patch only has to sort after what it patches
+	std::sort(archives.begin(), archives.end());
+
+	size_t mountedCount = 0;
+	for (const std::string& archive : archives) {
+		if (Mount(archive, folder)) mountedCount++;
+	}
+
+	return mountedCount;
+}
+
+void VirtualFileSystem::UnmountAll() {
+	std::lock_guard<std::mutex> lock(mountMutex);
+	mounts = std::make_shared<const std::vector<MountedPack>>();
+}
+
+std::shared_ptr<const std::vector<VirtualFileSystem::MountedPack>> VirtualFileSystem::GetMounts() {
+	std::lock_guard<std::mutex> lock(mountMutex);
+	return mounts;
+}
+#pragma endregion
+
+#pragma region reading
+bool VirtualFileSystem::FindPacked(const std::string& path, std::shared_ptr<AssetPack>* pack, const AssetPackEntry** entry) {
+	std::shared_ptr<const std::vector<MountedPack>> currentMounts = GetMounts();
+	if (currentMounts->empty()) return false;
+
+	std::string normalizedPath = NormalizePath(path);
+
+	for (auto mount = currentMounts->rbegin(); mount != currentMounts->rend(); mount++) {
+		if (normalizedPath.compare(0, mount->root.size(), mount->root) != 0) continue;
+
+		const AssetPackEntry* found = mount->pack->Find(normalizedPath.substr(mount->root.size()));
+		if (found != nullptr) {
+			*pack = mount->pack;
+			*entry = found;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool VirtualFileSystem::Open(const std::string& path, VirtualFile* file) {
+	file->Close();
+
+	std::shared_ptr<AssetPack> pack;
+	const AssetPackEntry* entry;
+	if (FindPacked(path, &pack, &entry)) {
+		// Matches MappedFile, which can't open empty files
+		if (entry->size == 0) return false;
+
+		const unsigned char* stored = pack->GetStoredData(*entry);
+		if (stored != nullptr) {
+			file->data = stored;
+		}
+		else if (pack->Read(*entry, &file->unpacked)) {
+			file->data = file->unpacked.data();
+			decompressedBytes += entry->size;
+		}
+		else {
+			failedReads++;
+			return false;
+		}
+
+		file->pack = pack;
+		file->size = (size_t)entry->size;
+		packedReads++;
+		return true;
+	}
+
+	if (!file->looseFile.Open(path)) return false;
+
+	file->data = file->looseFile.GetData();
+	file->size = file->looseFile.GetSize();
+	looseReads++;
+	return true;
+}
+
+bool VirtualFileSystem::Exists(const std::string& path) {
+	VirtualFileInfo info;
+	return GetFileInfo(path, &info);
+}
+
+bool VirtualFileSystem::GetFileInfo(const std::string& path, VirtualFileInfo* info) {
+	std::shared_ptr<AssetPack> pack;
+	const AssetPackEntry* entry;
+	if (FindPacked(path, &pack, &entry)) {
+		info->size = entry->size;
+		info->modifiedTime = entry->sourceModifiedTime;
+		info->packed = true;
+		info->contentHash = entry->contentHash;
+		return true;
+	}
+
+	if (!AssetPack::GetDiskStamp(path, &info->size, &info->modifiedTime)) return false;
+	info->packed = false;
+	info->contentHash = 0;
+	return true;
+}
+
+bool VirtualFileSystem::ReadWholeFile(const std::string& path, std::vector<char>* data) {
+	VirtualFile file;
+	if (!Open(path, &file)) {
+		// Empty files are still files, they just can't be opened
+		data->clear();
+		return Exists(path);
+	}
+
+	data->assign((const char*)file.GetData(), (const char*)file.GetData() + file.GetSize());
+	return true;
+}
+
+void VirtualFileSystem::ListFiles(const std::string& folder, bool recursive, std::vector<std::string>* paths) {
+	paths->clear();
+
+	std::string root = NormalizePath(folder);
+	if (root.empty() || root.back() != '/') root += '/';
+
+	// Keyed by the normalized relative path, so a file in several places is listed once
+	std::map<std::string, std::string> found;
+
+	std::shared_ptr<const std::vector<MountedPack>> currentMounts = GetMounts();
+	for (const MountedPack& mount : *currentMounts) {
+		if (root.compare(0, mount.root.size(), mount.root) != 0) continue;
+
+		std::string packedFolder = root.substr(mount.root.size());
+		for (uint32_t i = 0; i < mount.pack->GetEntryCount(); i++) {
+			std::string packedPath = mount.pack->GetEntryPath(*mount.pack->GetEntry(i));
+			std::string normalizedPath = AssetPack::NormalizePath(packedPath);
+			if (normalizedPath.compare(0, packedFolder.size(), packedFolder) != 0) continue;
+
+			std::string relativePath = packedPath.substr(packedFolder.size());
+			if (!recursive && relativePath.find('/') != std::string::npos) continue;
+
+			found.emplace(normalizedPath.substr(packedFolder.size()), relativePath);
+		}
+	}
+
+	auto addLooseFile = [&](const fs::path& path) {
+		std::error_code fileError;
+		if (!fs::is_regular_file(path, fileError)) return;
+
+		std::string fullPath = path.string();
+		std::string normalizedPath = NormalizePath(fullPath);
+		if (normalizedPath.compare(0, root.size(), root) != 0) return;
+
+		// The part below the folder is the same length either way, only separators and case differ
+		std::string relativeKey = normalizedPath.substr(root.size());
+		std::string relativePath = fullPath.substr(fullPath.size() - relativeKey.size());
+		std::replace(relativePath.begin(), relativePath.end(), '\\', '/');
+
+		found.emplace(relativeKey, relativePath);
+	};
+
+	std::error_code error;
+	if (recursive) {
+		for (fs::recursive_directory_iterator it(folder, error), end; !error && it != end; it.increment(error)) {
+			addLooseFile(it->path());
+		}
+	}
+	else {
+		for (fs::directory_iterator it(folder, error), end; !error && it != end; it.increment(error)) {
+			addLooseFile(it->path());
+		}
+	}
+
+	// Listed in the folder's own form, with its separators
+	char separator = folder.find('\\') != std::string::npos ? '\\' : '/';
+	std::string prefix = folder;
+	if (!prefix.empty() && prefix.back() != '/' && prefix.back() != '\\') prefix += separator;
+
+	for (auto& file : found) {
+		std::string relativePath = file.second;
+		std::replace(relativePath.begin(), relativePath.end(), '/', separator);
+		paths->push_back(prefix + relativePath);
+	}
+}
+#pragma endregion
+
+VirtualFileSystemStats VirtualFileSystem::GetStats() {
+	VirtualFileSystemStats stats;
+
+	std::shared_ptr<const std::vector<MountedPack>> currentMounts = GetMounts();
+	stats.archiveCount = currentMounts->size();
+	for (const MountedPack& mount : *currentMounts) {
+		stats.packedFileCount += mount.pack->GetEntryCount();
+	}
+
+	stats.packedReads = packedReads;
+	stats.looseReads = looseReads;
+	stats.decompressedBytes = decompressedBytes;
+	stats.failedReads = failedReads;
+
+	return stats;
+}
+
+std::string VirtualFileSystem::NormalizePath(const std::string& path) {
+	std::string absolutePath = fs::absolute(fs::path(path)).string();
+	std::replace(absolutePath.begin(), absolutePath.end(), '\\', '/');
+	std::transform(absolutePath.begin(), absolutePath.end(), absolutePath.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+	// Resolved by hand, since packed files don't exist for the filesystem to resolve
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while (start <= absolutePath.size()) {
+		size_t end = absolutePath.find('/', start);
+		if (end == std::string::npos) end = absolutePath.size();
+
+		std::string part = absolutePath.substr(start, end - start);
+		if (part == "..") {
+			if (parts.size() > 1) parts.pop_back();
+		}
+		else if (part != "." && (!part.empty() || parts.empty())) {
+			parts.push_back(part);
+		}
+
+		start = end + 1;
+	}
+
+	std::string normalized;
+	for (size_t i = 0; i < parts.size(); i++) {
+		if (i > 0) normalized += '/';
+		normalized += parts[i];
+	}
+
+	return normalized;
+}